@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testsupport.h"
+
+#define MAX_PIECES 4
+
+void setUp(void) { VERIFY_HW_ENV; }
+
+void tearDown(void) {}
+
+typedef struct piece {
+  zdnn_tensor_desc pre_tfrmd_desc;
+  zdnn_tensor_desc tfrmd_desc;
+  zdnn_ztensor ztensor;
+} piece;
+
+/// Initialize an NHWC zTensor of the given dims, with garbage in its buffer
+static void init_piece(piece *p, const uint32_t *dims) {
+  zdnn_init_pre_transformed_desc(ZDNN_NHWC, FP32, &p->pre_tfrmd_desc, dims[0],
+                                 dims[1], dims[2], dims[3]);
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_generate_transformed_desc(&p->pre_tfrmd_desc,
+                                                            &p->tfrmd_desc));
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_init_ztensor_with_malloc(&p->pre_tfrmd_desc,
+                                                  &p->tfrmd_desc, &p->ztensor));
+  memset(p->ztensor.buffer, 0xff, p->ztensor.buffer_size);
+}
+
+/// Get the cell of a zTensor at the given coordinates
+static uint16_t cell_at(const piece *p, const uint32_t *x) {
+  return *(uint16_t *)((char *)p->ztensor.buffer +
+                       get_stick_offset(x[0], x[1], x[2], x[3],
+                                        &p->tfrmd_desc));
+}
+
+/*
+ * Transform random values into pieces, concat them into a whole zTensor and
+ * check every cell of the whole against the piece cell it comes from.  Then
+ * split the whole into new pieces and check them against the originals.
+ */
+void test_concat_split(uint8_t axis, uint32_t dim4, uint32_t dim3,
+                       uint32_t dim2, uint32_t dim1, uint32_t count,
+                       const uint32_t *sizes) {
+  piece pieces[MAX_PIECES], split_pieces[MAX_PIECES], whole;
+  const zdnn_ztensor *inputs[MAX_PIECES];
+  zdnn_ztensor *outputs[MAX_PIECES];
+  void *values[MAX_PIECES];
+  uint32_t whole_dims[] = {dim4, dim3, dim2, dim1};
+  uint32_t starts[MAX_PIECES];
+
+  whole_dims[axis] = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t dims[] = {dim4, dim3, dim2, dim1};
+    dims[axis] = sizes[i];
+    starts[i] = whole_dims[axis];
+    whole_dims[axis] += sizes[i];
+
+    init_piece(&pieces[i], dims);
+    values[i] = create_and_fill_random_fp_data(&pieces[i].ztensor);
+    TEST_ASSERT_EQUAL(ZDNN_OK,
+                      zdnn_transform_ztensor(&pieces[i].ztensor, values[i]));
+    inputs[i] = &pieces[i].ztensor;
+
+    init_piece(&split_pieces[i], dims);
+    outputs[i] = &split_pieces[i].ztensor;
+  }
+  init_piece(&whole, whole_dims);
+
+  zdnn_status status =
+      zdnn_concat_ztensors(inputs, count, axis, &whole.ztensor);
+  TEST_ASSERT_MESSAGE_FORMATTED(
+      status == ZDNN_OK, "zdnn_concat_ztensors() failed, status = %08x",
+      status);
+  TEST_ASSERT_TRUE(whole.ztensor.is_transformed);
+
+  status = zdnn_split_ztensor(&whole.ztensor, axis, outputs, count);
+  TEST_ASSERT_MESSAGE_FORMATTED(
+      status == ZDNN_OK, "zdnn_split_ztensor() failed, status = %08x", status);
+
+  for (uint32_t i = 0; i < count; i++) {
+    const zdnn_tensor_desc *desc = &pieces[i].tfrmd_desc;
+    uint32_t x[4], wx[4];
+    TEST_ASSERT_TRUE(split_pieces[i].ztensor.is_transformed);
+
+    for (x[0] = 0; x[0] < desc->dim4; x[0]++) {
+      for (x[1] = 0; x[1] < desc->dim3; x[1]++) {
+        for (x[2] = 0; x[2] < desc->dim2; x[2]++) {
+          for (x[3] = 0; x[3] < desc->dim1; x[3]++) {
+            memcpy(wx, x, sizeof(wx));
+            wx[axis] += starts[i];
+            uint16_t exp_val = cell_at(&pieces[i], x);
+            uint16_t whole_val = cell_at(&whole, wx);
+            uint16_t split_val = cell_at(&split_pieces[i], x);
+            TEST_ASSERT_MESSAGE_FORMATTED(
+                whole_val == exp_val && split_val == exp_val,
+                "axis %u piece %u (%u, %u, %u, %u): concat 0x%04x, split "
+                "0x%04x, expected 0x%04x",
+                axis, i, x[0], x[1], x[2], x[3], whole_val, split_val,
+                exp_val);
+          }
+        }
+      }
+    }
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    free(values[i]);
+    zdnn_free_ztensor_buffer(&pieces[i].ztensor);
+    zdnn_free_ztensor_buffer(&split_pieces[i].ztensor);
+  }
+  zdnn_free_ztensor_buffer(&whole.ztensor);
+}
+
+void test_dim4() {
+  uint32_t sizes[] = {1, 3, 2};
+  test_concat_split(0, 0, 3, 40, 70, 3, sizes);
+}
+
+void test_dim3() {
+  uint32_t sizes[] = {2, 1, 3};
+  test_concat_split(1, 2, 0, 40, 70, 3, sizes);
+}
+
+// pieces start in the middle of a page of sticks
+void test_dim2() {
+  uint32_t sizes[] = {5, 33, 7};
+  test_concat_split(2, 2, 3, 0, 70, 3, sizes);
+}
+
+// pieces start on stick boundaries, whole sticks are copied
+void test_dim1_aligned() {
+  uint32_t sizes[] = {64, 128, 10};
+  test_concat_split(3, 2, 3, 5, 0, 3, sizes);
+}
+
+// pieces start in the middle of sticks, cells are moved
+void test_dim1_unaligned() {
+  uint32_t sizes[] = {5, 70, 64, 3};
+  test_concat_split(3, 2, 3, 5, 0, 4, sizes);
+}
+
+void test_single() {
+  uint32_t sizes[] = {70};
+  test_concat_split(3, 2, 3, 5, 0, 1, sizes);
+}
+
+void test_wrong_sizes() {
+  uint32_t shape1[] = {1, 2, 3, 4}, shape2[] = {1, 2, 3, 5},
+           whole_shape[] = {1, 2, 3, 10};
+  zdnn_ztensor *in1 = alloc_ztensor_with_values(shape1, ZDNN_NHWC, FP32,
+                                                NO_CONCAT, true, ZERO_ARRAY);
+  zdnn_ztensor *in2 = alloc_ztensor_with_values(shape2, ZDNN_NHWC, FP32,
+                                                NO_CONCAT, true, ZERO_ARRAY);
+  zdnn_ztensor *whole =
+      alloc_output_ztensor(whole_shape, ZDNN_NHWC, FP32, NO_CONCAT);
+  const zdnn_ztensor *inputs[] = {in1, in2};
+
+  // 4 + 5 along dim1 isn't 10
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_SHAPE,
+                    zdnn_concat_ztensors(inputs, 2, 3, whole));
+  // dim1 differs when concatenating along dim2
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_SHAPE,
+                    zdnn_concat_ztensors(inputs, 2, 2, whole));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_SHAPE,
+                    zdnn_concat_ztensors(inputs, 2, 4, whole));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_SHAPE,
+                    zdnn_concat_ztensors(inputs, 0, 3, whole));
+
+  free_ztensor_buffers(3, in1, in2, whole);
+}
+
+void test_not_transformed() {
+  uint32_t shape[] = {1, 2, 3, 4}, whole_shape[] = {2, 2, 3, 4};
+  zdnn_ztensor *in1 = alloc_ztensor_with_values(shape, ZDNN_NHWC, FP32,
+                                                NO_CONCAT, true, ZERO_ARRAY);
+  zdnn_ztensor *in2 = alloc_output_ztensor(shape, ZDNN_NHWC, FP32, NO_CONCAT);
+  zdnn_ztensor *whole =
+      alloc_output_ztensor(whole_shape, ZDNN_NHWC, FP32, NO_CONCAT);
+  const zdnn_ztensor *inputs[] = {in1, in2};
+  zdnn_ztensor *outputs[] = {in1, in2};
+
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE,
+                    zdnn_concat_ztensors(inputs, 2, 0, whole));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE,
+                    zdnn_split_ztensor(whole, 0, outputs, 2));
+
+  free_ztensor_buffers(3, in1, in2, whole);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_dim4);
+  RUN_TEST(test_dim3);
+  RUN_TEST(test_dim2);
+  RUN_TEST(test_dim1_aligned);
+  RUN_TEST(test_dim1_unaligned);
+  RUN_TEST(test_single);
+  RUN_TEST(test_wrong_sizes);
+  RUN_TEST(test_not_transformed);
+
+  return UNITY_END();
+}
@@ -38,6 +38,11 @@
 #include "testsupport.h"
 
 #include <math.h>
+
+// off Z, `vector` is an ordinary identifier to code including the headers
+#if !defined(__s390x__) && !defined(__MVS__) && defined(vector)
+#error "vector must not be defined by the zDNN headers"
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -132,20 +137,19 @@ int convert_and_compare(zdnn_data_types in_type, int numvalues,
   // Build the "expected" areas that we will compare to conversion results
   for (int i = 0; i < numvalues; i = i + 1) {
 
+    // the converted DLFLOAT16 data is laid out as in a stick
+    uint16_t dlf16 = 0;
+
     if (in_type == FP32) {
 
-      expected_DLF_data.maps.shortfloat[i] =
-          cnvt_1_fp32_to_dlf16(fixedfloat[i]); /* Convert a value, store in
+      dlf16 = cnvt_1_fp32_to_dlf16(fixedfloat[i]); /* Convert a value, store in
                                                 expected dlfloat entry */
       LOG_DEBUG("++ c_1_fp32_to_dlf for expected DLF %d of %d", i, numvalues);
-      LOG_DEBUG("First : %x, Second: %x", fixedfloat[i],
-                expected_DLF_data.maps.shortfloat[i]);
+      LOG_DEBUG("First : %x, Second: %x", fixedfloat[i], dlf16);
 
       expected_orig_data.maps.expfloat[i] = cnvt_1_dlf16_to_fp32(
-          expected_DLF_data.maps.shortfloat[i]); /* Convert a value back to
-                                                    original format, store in
-                                                    expected original format
-                                                    entry */
+          dlf16); /* Convert a value back to original format, store in
+                     expected original format entry */
       LOG_DEBUG("++ c_1_dlf16_to_FP32 for expected Orig %d of %d", i,
                 numvalues);
       LOG_DEBUG("First : %x, Second: %x", fixedfloat[i],
@@ -153,27 +157,23 @@ int convert_and_compare(zdnn_data_types in_type, int numvalues,
     }
 
     if (in_type == FP16) {
-      expected_DLF_data.maps.shortfloat[i] =
-          cnvt_1_fp16_to_dlf16(fixed_float_bit16[i]); /* Convert a value, store
-                                                in expected dlfloat entry */
+      dlf16 = cnvt_1_fp16_to_dlf16(fixed_float_bit16[i]); /* Convert a value,
+                                          store in expected dlfloat entry */
 
       expected_orig_data.maps.shortfloat[i] = cnvt_1_dlf16_to_fp16(
-          expected_DLF_data.maps.shortfloat[i]); /* Convert a value back to
-                                                    original format, store in
-                                                    expected original format
-                                                    entry */
+          dlf16); /* Convert a value back to original format, store in
+                     expected original format entry */
     }
 
     if (in_type == BFLOAT) {
-      expected_DLF_data.maps.shortfloat[i] =
-          cnvt_1_bfloat_to_dlf16(fixed_float_bit16[i]); /* Convert a value,
+      dlf16 = cnvt_1_bfloat_to_dlf16(fixed_float_bit16[i]); /* Convert a value,
                                          store in expected dlfloat entry */
-      expected_orig_data.maps.shortfloat[i] =
-          cnvt_1_dlf16_to_bfloat(expected_DLF_data.maps.shortfloat[i]); /*
-                                         Convert a value back to original
-                                         format, store in expected
-                                         original format entry */
+      expected_orig_data.maps.shortfloat[i] = cnvt_1_dlf16_to_bfloat(
+          dlf16); /* Convert a value back to original format, store in
+                     expected original format entry */
     }
+
+    expected_DLF_data.maps.shortfloat[i] = STICK_CELL16(dlf16);
   }
 
   // call convert_data to convert/stickify the original data
@@ -273,7 +273,7 @@ int convert_and_compare(zdnn_data_types in_type, int numvalues,
         "convert_data (to orig, no stride) count did not match actual");
   }
   TEST_ASSERT_MESSAGE(
-      memcmp(converted_orig_data, zeroes, (numvalues * sizeof(short))) != 0,
+      memcmp(converted_orig_data, zeroes, (size_t)orig_data_size) != 0,
       "converted-to-original area left as zeros");
 
   int memcmp_rc2 =
@@ -865,16 +865,13 @@ void test_bidir_output_max_dim1() {
   test_main(&pre_tfrmd_desc, &tfrmd_desc, NO_CONCAT, expected_size, ZDNN_OK);
 }
 
-void test_bidir_output_fail_dim1_too_big() {
+void test_bidir_output_above_max_dim1() {
 
   zdnn_tensor_desc pre_tfrmd_desc, tfrmd_desc;
   uint64_t max_dim1 = max_concat_dim1(2);
   zdnn_init_pre_transformed_desc(ZDNN_4DS, test_datatype, &pre_tfrmd_desc, 1, 2,
                                  3, max_dim1 + 1);
 
-  // zdnn_generate_transformed_desc_concatenated() yields no error but
-  // zdnn_allochelper() yields ZDNN_DATA_ERROR during it's checks.
-
   zdnn_status status =
       zdnn_generate_transformed_desc(&pre_tfrmd_desc, &tfrmd_desc);
   TEST_ASSERT_MESSAGE_FORMATTED(
@@ -884,7 +881,10 @@ void test_bidir_output_fail_dim1_too_big() {
       status, zdnn_get_status_message(status), ZDNN_OK,
       zdnn_get_status_message(ZDNN_OK));
 
-  test_main(&pre_tfrmd_desc, &tfrmd_desc, NO_CONCAT, 9999, ZDNN_INVALID_SHAPE);
+  // dim1 of a feature tensor may go past the limit, operations given it
+  // return ZDNN_EXCEEDS_MDIS instead
+  test_main(&pre_tfrmd_desc, &tfrmd_desc, NO_CONCAT,
+            zdnn_getsize_ztensor(&tfrmd_desc), ZDNN_OK);
 }
 
 void test_zdnn_init_ztensor_function() {
@@ -921,6 +921,12 @@ void test_zdnn_init_ztensor_function() {
       memcmp(expected_reserved2, ztensor.reserved2,
              sizeof(expected_reserved2)) == 0,
       "Expected ztensor reserved2 area not initialized to zeroes.");
+
+  TEST_ASSERT_MESSAGE(!ztensor.is_per_channel &&
+                          ztensor.channel_scales == NULL &&
+                          ztensor.channel_offsets == NULL,
+                      "Expected ztensor channel scales and offsets to be "
+                      "initialized as unused and NULL.");
 }
 
 void test_zdnn_init_ztensor_via_malloc_function() {
@@ -962,9 +968,79 @@ void test_zdnn_init_ztensor_via_malloc_function() {
              sizeof(expected_reserved2)) == 0,
       "Expected ztensor reserved2 area not initialized to zeroes.");
 
+  TEST_ASSERT_MESSAGE(!ztensor.is_per_channel &&
+                          ztensor.channel_scales == NULL &&
+                          ztensor.channel_offsets == NULL,
+                      "Expected ztensor channel scales and offsets to be "
+                      "initialized as unused and NULL.");
+
   zdnn_free_ztensor_buffer(&ztensor);
 }
 
+void test_zdnn_init_quantized_ztensor_function() {
+  zdnn_tensor_desc pre_tfrmd_desc, tfrmd_desc;
+  zdnn_ztensor ztensor;
+
+  zdnn_init_pre_transformed_desc(ZDNN_2D, INT8, &pre_tfrmd_desc, 1, 8);
+  zdnn_generate_quantized_transformed_desc(
+      &pre_tfrmd_desc, QUANTIZED_WEIGHTS_INT8, &tfrmd_desc);
+
+  // Set ztensor to all 1s prior to function call.
+  memset(&ztensor, 1, sizeof(ztensor));
+
+  zdnn_init_quantized_ztensor(&pre_tfrmd_desc, &tfrmd_desc, 0.5f, 3.f,
+                              &ztensor);
+
+  TEST_ASSERT_EQUAL_FLOAT(2.f, ztensor.rec_scale);
+  TEST_ASSERT_EQUAL_FLOAT(3.f, ztensor.offset);
+
+  char expected_reserved2[sizeof(ztensor.reserved2)] = {0};
+
+  TEST_ASSERT_MESSAGE(
+      memcmp(expected_reserved2, ztensor.reserved2,
+             sizeof(expected_reserved2)) == 0,
+      "Expected ztensor reserved2 area not initialized to zeroes.");
+
+  TEST_ASSERT_MESSAGE(!ztensor.is_per_channel &&
+                          ztensor.channel_scales == NULL &&
+                          ztensor.channel_offsets == NULL,
+                      "Expected ztensor channel scales and offsets to be "
+                      "initialized as unused and NULL.");
+}
+
+void test_zdnn_init_per_channel_quantized_ztensor_function() {
+  zdnn_tensor_desc pre_tfrmd_desc, tfrmd_desc;
+  zdnn_ztensor ztensor;
+  float channel_scales[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+  zdnn_init_pre_transformed_desc(ZDNN_2D, INT8, &pre_tfrmd_desc, 1, 8);
+  zdnn_generate_quantized_transformed_desc(
+      &pre_tfrmd_desc, QUANTIZED_WEIGHTS_INT8, &tfrmd_desc);
+
+  memset(&ztensor, 1, sizeof(ztensor));
+
+  zdnn_init_per_channel_quantized_ztensor(&pre_tfrmd_desc, &tfrmd_desc, 0.5f,
+                                          3.f, channel_scales, NULL, &ztensor);
+
+  TEST_ASSERT_EQUAL_FLOAT(2.f, ztensor.rec_scale);
+  TEST_ASSERT_EQUAL_FLOAT(3.f, ztensor.offset);
+  TEST_ASSERT_TRUE(ztensor.is_per_channel);
+  TEST_ASSERT_TRUE(ztensor.channel_scales == channel_scales);
+  TEST_ASSERT_NULL(ztensor.channel_offsets);
+
+  char expected_reserved2[sizeof(ztensor.reserved2)] = {0};
+
+  TEST_ASSERT_MESSAGE(
+      memcmp(expected_reserved2, ztensor.reserved2,
+             sizeof(expected_reserved2)) == 0,
+      "Expected ztensor reserved2 area not initialized to zeroes.");
+
+  // without either vector the zTensor is quantized per tensor
+  zdnn_init_per_channel_quantized_ztensor(&pre_tfrmd_desc, &tfrmd_desc, 0.5f,
+                                          3.f, NULL, NULL, &ztensor);
+  TEST_ASSERT_FALSE(ztensor.is_per_channel);
+}
+
 void test_zdnn_is_quantized_ztensor_scale() {
   zdnn_tensor_desc pre_tfrmd_desc, tfrmd_desc;
   zdnn_ztensor ztensor;
@@ -1118,10 +1194,12 @@ int main(void) {
   RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_bidir_output_2x2x50x150);
 
   RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_bidir_output_max_dim1);
-  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_bidir_output_fail_dim1_too_big);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_bidir_output_above_max_dim1);
 
   RUN_TEST(test_zdnn_init_ztensor_function);
   RUN_TEST(test_zdnn_init_ztensor_via_malloc_function);
+  RUN_TEST(test_zdnn_init_quantized_ztensor_function);
+  RUN_TEST(test_zdnn_init_per_channel_quantized_ztensor_function);
 
   RUN_TEST(test_zdnn_is_quantized_ztensor_scale);
   RUN_TEST(test_zdnn_is_quantized_ztensor_false);
@@ -84,10 +84,150 @@ void malloc4k_check_boundary() {
   TEST_PASS();
 }
 
+// a freed area is handed out again for a request of the same size class
+void malloc4k_reuse() {
+  if (!alloc_cache_bytes) {
+    TEST_IGNORE_MESSAGE("pooling disabled by " ENVVAR_ALLOC_CACHE_MB);
+  }
+
+  // 8k save area, kept in the thread cache
+  void *ptr = malloc_aligned_4k(ZDNN_8K_SAVEAREA_SIZE);
+  free_aligned_4k(ptr);
+  TEST_ASSERT_EQUAL_PTR(ptr, malloc_aligned_4k(ZDNN_8K_SAVEAREA_SIZE));
+  free_aligned_4k(ptr);
+
+  // 1M + 1 byte and 1M + 64K both round up to the 320 pages class, kept in
+  // the shared pool
+  ptr = malloc_aligned_4k(1024 * 1024 + 1);
+  memset(ptr, 0xAA, 1024 * 1024 + 1);
+  free_aligned_4k(ptr);
+  void *ptr2 = malloc_aligned_4k(1024 * 1024 + 64 * 1024);
+  TEST_ASSERT_EQUAL_PTR(ptr, ptr2);
+  memset(ptr2, 0x55, 1024 * 1024 + 64 * 1024);
+  free_aligned_4k(ptr2);
+}
+
+// areas too large to pool are still 4k-aligned and usable
+void malloc4k_unpooled() {
+  size_t size = 65 * 1024 * 1024;
+  void *ptr = malloc_aligned_4k(size);
+  TEST_ASSERT_NOT_NULL(ptr);
+  TEST_ASSERT_EQUAL(0, (uintptr_t)ptr % AIU_PAGESIZE_IN_BYTES);
+  memset(ptr, 0, size);
+  free_aligned_4k(ptr);
+}
+
+void malloc4k_hugepages() {
+  bool saved_hugepages = hugepages_enabled;
+  hugepages_enabled = true;
+
+  size_t size = 3 * 1024 * 1024 + 5;
+  void *ptr = malloc_aligned_4k(size);
+  TEST_ASSERT_NOT_NULL(ptr);
+  TEST_ASSERT_EQUAL(0, (uintptr_t)ptr % AIU_PAGESIZE_IN_BYTES);
+  memset(ptr, 0, size);
+  free_aligned_4k(ptr);
+
+  hugepages_enabled = saved_hugepages;
+}
+
+typedef struct host_arena {
+  uint32_t allocs;
+  uint32_t frees;
+  size_t outstanding;
+  bool misalign;
+} host_arena;
+
+static void *host_alloc(size_t size, void *user_data) {
+  host_arena *arena = (host_arena *)user_data;
+  void *ptr;
+  if (posix_memalign(&ptr, AIU_PAGESIZE_IN_BYTES, size + 64)) {
+    return NULL;
+  }
+  arena->allocs++;
+  arena->outstanding += size;
+  return arena->misalign ? (void *)((uintptr_t)ptr + 64) : ptr;
+}
+
+static void host_free(void *ptr, size_t size, void *user_data) {
+  host_arena *arena = (host_arena *)user_data;
+  arena->frees++;
+  arena->outstanding -= size;
+  free(arena->misalign ? (void *)((uintptr_t)ptr - 64) : ptr);
+}
+
+// zTensor buffers come from and go back to the host allocator
+void malloc4k_host_allocator() {
+  host_arena arena = {0};
+  zdnn_set_allocator(host_alloc, host_free, &arena);
+
+  zdnn_tensor_desc pre_tfrmd_desc, tfrmd_desc;
+  zdnn_ztensor ztensor;
+  zdnn_init_pre_transformed_desc(ZDNN_NHWC, FP32, &pre_tfrmd_desc, 1, 3, 5, 70);
+  zdnn_generate_transformed_desc(&pre_tfrmd_desc, &tfrmd_desc);
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_init_ztensor_with_malloc(
+                                 &pre_tfrmd_desc, &tfrmd_desc, &ztensor));
+  TEST_ASSERT_EQUAL_UINT32(1, arena.allocs);
+  TEST_ASSERT_EQUAL(0, (uintptr_t)ztensor.buffer % AIU_PAGESIZE_IN_BYTES);
+
+  // freed by the allocator it came from even after switching back
+  zdnn_set_allocator(NULL, NULL, NULL);
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_free_ztensor_buffer(&ztensor));
+  TEST_ASSERT_EQUAL_UINT32(1, arena.frees);
+  TEST_ASSERT_EQUAL_UINT64(0, arena.outstanding);
+}
+
+// areas pooled before a host allocator is installed are released, and so are
+// pooled areas freed while it is
+void malloc4k_host_allocator_drains_pool() {
+  if (!alloc_cache_bytes) {
+    TEST_IGNORE_MESSAGE("pooling disabled by " ENVVAR_ALLOC_CACHE_MB);
+  }
+
+  void *cached = malloc_aligned_4k(ZDNN_8K_SAVEAREA_SIZE);
+  void *in_use = malloc_aligned_4k(ZDNN_8K_SAVEAREA_SIZE);
+  free_aligned_4k(cached);
+  TEST_ASSERT_TRUE(get_alloc_cached_bytes() > 0);
+
+  host_arena arena = {0};
+  zdnn_set_allocator(host_alloc, host_free, &arena);
+  TEST_ASSERT_EQUAL_UINT64(0, get_alloc_cached_bytes());
+
+  free_aligned_4k(in_use);
+  TEST_ASSERT_EQUAL_UINT64(0, get_alloc_cached_bytes());
+
+  void *ptr = malloc_aligned_4k(ZDNN_8K_SAVEAREA_SIZE);
+  TEST_ASSERT_EQUAL_UINT32(1, arena.allocs);
+  free_aligned_4k(ptr);
+  TEST_ASSERT_EQUAL_UINT32(1, arena.frees);
+  TEST_ASSERT_EQUAL_UINT64(0, get_alloc_cached_bytes());
+
+  zdnn_set_allocator(NULL, NULL, NULL);
+}
+
+// memory not on a 4k boundary is given back and the allocation fails
+void malloc4k_host_allocator_misaligned() {
+  host_arena arena = {0};
+  arena.misalign = true;
+  zdnn_set_allocator(host_alloc, host_free, &arena);
+
+  TEST_ASSERT_NULL(malloc_aligned_4k(AIU_PAGESIZE_IN_BYTES));
+  TEST_ASSERT_EQUAL_UINT32(1, arena.allocs);
+  TEST_ASSERT_EQUAL_UINT32(1, arena.frees);
+
+  zdnn_set_allocator(NULL, NULL, NULL);
+}
+
 int main(void) {
   UNITY_BEGIN();
   RUN_TEST(malloc4k_zero);
   RUN_TEST(malloc4k_size_max_plus_one);
   RUN_TEST(malloc4k_check_boundary);
+  RUN_TEST(malloc4k_reuse);
+  RUN_TEST(malloc4k_unpooled);
+  RUN_TEST(malloc4k_hugepages);
+  RUN_TEST(malloc4k_host_allocator);
+  RUN_TEST(malloc4k_host_allocator_drains_pool);
+  RUN_TEST(malloc4k_host_allocator_misaligned);
   return UNITY_END();
 }
@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "common_elwise.h"
+#include "testsupport.h"
+#include "version.h"
+
+#include <string.h>
+
+static nnpa_backends saved_backend;
+
+void setUp(void) {
+#if !defined(ZDNN_VEC_GENERIC)
+  // on IBM Z stickification relies on the NNPA-assist conversion instructions
+  VERIFY_HW_ENV;
+#endif
+  saved_backend = nnpa_backend;
+  nnpa_backend = NNPA_BACKEND_SOFT;
+}
+
+void tearDown(void) { nnpa_backend = saved_backend; }
+
+// QAF should report the newest known zAIU
+void soft_qaf() {
+  nnpa_qaf_parameter_block qpb;
+  memset(&qpb, 0xFF, sizeof(qpb));
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, invoke_nnpa_query(&qpb));
+  TEST_ASSERT_EQUAL_MEMORY(aiu_hwinfo_list[0]->blk1,
+                           &qpb.installed_functions_vector, HWINFO_BLK1_LEN);
+  TEST_ASSERT_EQUAL(aiu_hwinfo_list[0]->val1,
+                    qpb.maximum_dimension_index_size);
+  TEST_ASSERT_EQUAL_UINT64(aiu_hwinfo_list[0]->val2, qpb.maximum_tensor_size);
+}
+
+void soft_unsupported_parmblock() {
+  nnpa_parameter_block parm_block;
+  memset(&parm_block, 0, sizeof(parm_block));
+  parm_block.parm_block_version_number = NNPA_PARMBLKFORMAT_1 + 1;
+
+  uint8_t ef;
+  TEST_ASSERT_EQUAL(ZDNN_UNSUPPORTED_PARMBLOCK,
+                    invoke_nnpa(NNPA_ADD, (char *)&parm_block, &ef));
+}
+
+void soft_unavailable_function() {
+  nnpa_parameter_block parm_block;
+  memset(&parm_block, 0, sizeof(parm_block));
+  parm_block.parm_block_version_number = NNPA_PARMBLKFORMAT_1;
+
+  uint8_t ef;
+  TEST_ASSERT_EQUAL(ZDNN_UNAVAILABLE_FUNCTION,
+                    invoke_nnpa(1, (char *)&parm_block, &ef));
+}
+
+// run full APIs through the software backend, results are checked against
+// the same expected values as with the hardware
+void soft_add() {
+  uint32_t shape[] = {2, 3, 40, 70};
+  int num_values = shape[0] * shape[1] * shape[2] * shape[3];
+
+  float input1_values[num_values];
+  gen_random_float_array(num_values, input1_values);
+  float input2_values[num_values];
+  gen_random_float_array(num_values, input2_values);
+
+  test_elwise_api_2_inputs(shape, ZDNN_NHWC, input1_values, input2_values,
+                           NNPA_ADD, ZDNN_OK);
+}
+
+void soft_exp() {
+  uint32_t shape[] = {1, 4, 33, 130};
+  int num_values = shape[0] * shape[1] * shape[2] * shape[3];
+
+  float input_values[num_values];
+  gen_random_float_array(num_values, input_values);
+
+  test_elwise_api_1_input(shape, ZDNN_NHWC, input_values, NNPA_EXP, ZDNN_OK);
+}
+
+void soft_max() {
+  uint32_t shape[] = {3, 1, 65, 3};
+  int num_values = shape[0] * shape[1] * shape[2] * shape[3];
+
+  float input1_values[num_values];
+  gen_random_float_array(num_values, input1_values);
+  float input2_values[num_values];
+  gen_random_float_array(num_values, input2_values);
+
+  test_elwise_api_2_inputs(shape, ZDNN_NHWC, input1_values, input2_values,
+                           NNPA_MAX, ZDNN_OK);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(soft_qaf);
+  RUN_TEST(soft_unsupported_parmblock);
+  RUN_TEST(soft_unavailable_function);
+
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(soft_add);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(soft_exp);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(soft_max);
+
+  return UNITY_END();
+}
@@ -0,0 +1,263 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "testsupport.h"
+
+#define NUM_EXECUTIONS 3
+
+static bool saved_precheck;
+
+void setUp(void) {
+  VERIFY_HW_ENV;
+  saved_precheck = precheck_enabled;
+}
+
+void tearDown(void) { precheck_enabled = saved_precheck; }
+
+static zdnn_ztensor *alloc_random_nhwc(uint32_t *shape) {
+  return alloc_ztensor_with_random_values(shape, ZDNN_NHWC, -2, 2);
+}
+
+/// Allocate an output zTensor with its padding zeroed, so stick areas can be
+/// compared as a whole
+static zdnn_ztensor *alloc_zeroed_output(uint32_t *shape,
+                                         zdnn_data_layouts layout) {
+  zdnn_ztensor *ztensor = alloc_output_ztensor(shape, layout, FP32, NO_CONCAT);
+  memset(ztensor->buffer, 0, ztensor->buffer_size);
+  return ztensor;
+}
+
+/// Compare the stick areas of two output zTensors of the same shape
+static void assert_same_output(zdnn_ztensor *a, zdnn_ztensor *b) {
+  TEST_ASSERT_EQUAL_UINT64(a->buffer_size, b->buffer_size);
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(a->buffer, b->buffer, a->buffer_size,
+                                   "plan output differs from direct call");
+}
+
+// record zdnn_add(), execute it several times and again after swapping the
+// buffer of an input
+void test_add() {
+  uint32_t shape[] = {2, 3, 17, 70};
+
+  zdnn_ztensor *a = alloc_random_nhwc(shape);
+  zdnn_ztensor *b = alloc_random_nhwc(shape);
+  zdnn_ztensor *b2 = alloc_random_nhwc(shape);
+  zdnn_ztensor *exp_out = alloc_zeroed_output(shape, ZDNN_NHWC);
+  zdnn_ztensor *out = alloc_zeroed_output(shape, ZDNN_NHWC);
+
+  zdnn_op_plan *plan;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_begin_op_plan(&plan));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_add(a, b, out));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_end_op_plan(plan));
+
+  // recording doesn't run the operation
+  TEST_ASSERT_FALSE(out->is_transformed);
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_add(a, b, exp_out));
+  for (int i = 0; i < NUM_EXECUTIONS; i++) {
+    memset(out->buffer, 0, out->buffer_size);
+    TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_execute_op_plan(plan));
+    TEST_ASSERT_TRUE(out->is_transformed);
+    assert_same_output(exp_out, out);
+  }
+
+  // same descriptors, different data
+  void *saved_buffer = b->buffer;
+  b->buffer = b2->buffer;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_add(a, b2, exp_out));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_execute_op_plan(plan));
+  assert_same_output(exp_out, out);
+  b->buffer = saved_buffer;
+
+  zdnn_free_op_plan(plan);
+  free_ztensor_buffers(5, a, b, b2, exp_out, out);
+}
+
+void test_matmul() {
+  uint32_t a_shape[] = {2, 30, 70};
+  uint32_t b_shape[] = {2, 70, 45};
+  uint32_t c_shape[] = {2, 45};
+  uint32_t out_shape[] = {2, 30, 45};
+
+  zdnn_ztensor *a = alloc_ztensor_with_random_values(a_shape, ZDNN_3DS, -2, 2);
+  zdnn_ztensor *b = alloc_ztensor_with_random_values(b_shape, ZDNN_3DS, -2, 2);
+  zdnn_ztensor *c = alloc_ztensor_with_random_values(c_shape, ZDNN_2DS, -2, 2);
+  zdnn_ztensor *exp_out = alloc_zeroed_output(out_shape, ZDNN_3DS);
+  zdnn_ztensor *out = alloc_zeroed_output(out_shape, ZDNN_3DS);
+
+  zdnn_op_plan *plan;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_begin_op_plan(&plan));
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_matmul_op(a, b, c, MATMUL_OP_ADDITION, out));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_end_op_plan(plan));
+
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_matmul_op(a, b, c, MATMUL_OP_ADDITION, exp_out));
+  for (int i = 0; i < NUM_EXECUTIONS; i++) {
+    memset(out->buffer, 0, out->buffer_size);
+    TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_execute_op_plan(plan));
+    assert_same_output(exp_out, out);
+  }
+
+  zdnn_free_op_plan(plan);
+  free_ztensor_buffers(5, a, b, c, exp_out, out);
+}
+
+// softmax without a caller save area, the plan owns the one it allocated
+void test_softmax_no_savearea() {
+  uint32_t shape[] = {2, 5, 90};
+
+  zdnn_ztensor *in = alloc_ztensor_with_random_values(shape, ZDNN_3DS, -2, 2);
+  zdnn_ztensor *exp_out = alloc_zeroed_output(shape, ZDNN_3DS);
+  zdnn_ztensor *out = alloc_zeroed_output(shape, ZDNN_3DS);
+
+  zdnn_op_plan *plan;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_begin_op_plan(&plan));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_softmax(in, NULL, SOFTMAX_ACT_NONE, out));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_end_op_plan(plan));
+
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_softmax(in, NULL, SOFTMAX_ACT_NONE, exp_out));
+  for (int i = 0; i < NUM_EXECUTIONS; i++) {
+    TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_execute_op_plan(plan));
+    assert_same_output(exp_out, out);
+  }
+
+  zdnn_free_op_plan(plan);
+  free_ztensor_buffers(3, in, exp_out, out);
+}
+
+// tensors are validated while recording even when precheck is off
+void test_record_invalid_shape() {
+  uint32_t shape[] = {2, 3, 17, 70};
+  uint32_t bad_shape[] = {2, 3, 17, 71};
+
+  precheck_enabled = false;
+
+  zdnn_ztensor *a = alloc_random_nhwc(shape);
+  zdnn_ztensor *b = alloc_random_nhwc(bad_shape);
+  zdnn_ztensor *out = alloc_zeroed_output(shape, ZDNN_NHWC);
+
+  zdnn_op_plan *plan;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_begin_op_plan(&plan));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_SHAPE, zdnn_add(a, b, out));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE, zdnn_end_op_plan(plan));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE, zdnn_execute_op_plan(plan));
+
+  zdnn_free_op_plan(plan);
+  free_ztensor_buffers(3, a, b, out);
+}
+
+// operations that make more than one zAIU call can't be recorded
+void test_record_multi_call_op() {
+  // fails before any of the tensors are looked at
+  precheck_enabled = false;
+
+  zdnn_op_plan *plan;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_begin_op_plan(&plan));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE,
+                    zdnn_lstm(NULL, NULL, NULL, NULL, NULL, NULL, NULL, FWD,
+                              NULL, NULL, NULL));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE, zdnn_end_op_plan(plan));
+  zdnn_free_op_plan(plan);
+}
+
+void test_record_two_ops() {
+  uint32_t shape[] = {1, 1, 4, 8};
+
+  zdnn_ztensor *a = alloc_random_nhwc(shape);
+  zdnn_ztensor *out = alloc_zeroed_output(shape, ZDNN_NHWC);
+
+  zdnn_op_plan *plan;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_begin_op_plan(&plan));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_exp(a, out));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE, zdnn_exp(a, out));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE, zdnn_end_op_plan(plan));
+
+  zdnn_free_op_plan(plan);
+  free_ztensor_buffers(2, a, out);
+}
+
+// transformations are done on the host, so they can't be recorded either
+void test_record_transform() {
+  uint32_t shape[] = {1, 1, 4, 8};
+  float values[4 * 8], back[4 * 8];
+  gen_random_float_array(4 * 8, values);
+
+  zdnn_ztensor *a = alloc_random_nhwc(shape);
+  zdnn_ztensor *out = alloc_zeroed_output(shape, ZDNN_NHWC);
+
+  zdnn_op_plan *plan;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_begin_op_plan(&plan));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE, zdnn_transform_ztensor(out, values));
+  TEST_ASSERT_FALSE(out->is_transformed);
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE, zdnn_end_op_plan(plan));
+  zdnn_free_op_plan(plan);
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_begin_op_plan(&plan));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE, zdnn_transform_origtensor(a, back));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE, zdnn_end_op_plan(plan));
+  zdnn_free_op_plan(plan);
+
+  // and work again once the recording is over
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_ztensor(out, values));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_origtensor(a, back));
+
+  free_ztensor_buffers(2, a, out);
+}
+
+void test_plan_state_errors() {
+  zdnn_op_plan *plan, *nested;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_begin_op_plan(&plan));
+
+  // only one plan per thread at a time, and not runnable while recording
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE, zdnn_begin_op_plan(&nested));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE, zdnn_execute_op_plan(plan));
+
+  // nothing recorded
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE, zdnn_end_op_plan(plan));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE, zdnn_execute_op_plan(plan));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE, zdnn_end_op_plan(plan));
+  zdnn_free_op_plan(plan);
+
+  // freeing a plan still recording stops the recording
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_begin_op_plan(&plan));
+  zdnn_free_op_plan(plan);
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_begin_op_plan(&plan));
+  zdnn_free_op_plan(plan);
+
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE, zdnn_execute_op_plan(NULL));
+  zdnn_free_op_plan(NULL);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_add);
+  RUN_TEST(test_matmul);
+  RUN_TEST(test_softmax_no_savearea);
+  RUN_TEST(test_record_invalid_shape);
+  RUN_TEST(test_record_multi_call_op);
+  RUN_TEST(test_record_two_ops);
+  RUN_TEST(test_record_transform);
+  RUN_TEST(test_plan_state_errors);
+
+  return UNITY_END();
+}
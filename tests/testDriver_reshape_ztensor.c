@@ -112,7 +112,8 @@ void test(zdnn_data_layouts src_layout, uint32_t src_dim4, uint32_t src_dim3,
 
             uint16_t raw_dlf16_val = 0; // this is the "expected" value
             uint16_t dest_dlf16_val =
-                *(uint16_t *)((uintptr_t)dest_ztensor.buffer + dest_offset);
+                STICK_CELL16(*(uint16_t *)((uintptr_t)dest_ztensor.buffer +
+                                           dest_offset));
 
             // these 2 are for printf-ing only
             float raw_float_val = 0;
@@ -184,6 +185,36 @@ void test_4x4x4x4_1x1x16x16() {
   test(ZDNN_NHWC, 4, 4, 4, 4, ZDNN_NHWC, 1, 1, 16, 16, ZDNN_OK);
 }
 
+// different C, src sticks straddling dest sticks (cells moved between sticks)
+void test_2x3x40x100_1x10x16x150() {
+  test(ZDNN_NHWC, 2, 3, 40, 100, ZDNN_NHWC, 1, 10, 16, 150, ZDNN_OK);
+}
+
+// C spanning several sticks to C within one stick
+void test_1x1x3x200_1x2x5x60() {
+  test(ZDNN_NHWC, 1, 1, 3, 200, ZDNN_NHWC, 1, 2, 5, 60, ZDNN_OK);
+}
+
+// different C, whole sticks line up
+void test_3x1x70x64_1x1x35x384() {
+  test(ZDNN_NHWC, 3, 1, 70, 64, ZDNN_NHWC, 1, 1, 35, 384, ZDNN_OK);
+}
+
+// 3DS to NHWC, different C
+void test_3ds_4x10x30_1x6x5x40() {
+  test(ZDNN_3DS, 4, 10, 30, 0, ZDNN_NHWC, 1, 6, 5, 40, ZDNN_OK);
+}
+
+// different C, enough rows to be split across threads
+void test_2x16x64x130_4x8x65x128() {
+  test(ZDNN_NHWC, 2, 16, 64, 130, ZDNN_NHWC, 4, 8, 65, 128, ZDNN_OK);
+}
+
+// NCHW to NHWC, elements taken in NCHW order (elements moved one at a time)
+void test_nchw_2x70x5x9_1x10x7x90() {
+  test(ZDNN_NCHW, 2, 70, 5, 9, ZDNN_NHWC, 1, 10, 7, 90, ZDNN_OK);
+}
+
 void test_fail_total_elements_mismatch() {
   test(ZDNN_NHWC, 4, 4, 4, 4, ZDNN_NHWC, 1, 1, 16, 15, ZDNN_INVALID_SHAPE);
 }
@@ -223,6 +254,11 @@ void test_fail_not_same_layout() {
   test(ZDNN_NHWC, 4, 5, 6, 7, ZDNN_HWCK, 4, 5, 6, 7, ZDNN_INVALID_LAYOUT);
 }
 
+// kernel tensors can only be reshaped when K stays the same
+void test_fail_hwck_different_k() {
+  test(ZDNN_HWCK, 3, 3, 40, 70, ZDNN_HWCK, 3, 3, 70, 40, ZDNN_INVALID_FORMAT);
+}
+
 void test_fail_src_not_transformed() {
   zdnn_status status, exp_status = ZDNN_INVALID_STATE;
   test_datatype = FP16;
@@ -289,10 +325,17 @@ int main(void) {
   RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_2x3x4x68_4x1x6x68);
   RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_4x3x40x70_8x20x3x70);
   RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_4x4x4x4_1x1x16x16);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_2x3x40x100_1x10x16x150);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_1x1x3x200_1x2x5x60);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_3x1x70x64_1x1x35x384);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_3ds_4x10x30_1x6x5x40);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_2x16x64x130_4x8x65x128);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_nchw_2x70x5x9_1x10x7x90);
 
   RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_fail_total_elements_mismatch);
   RUN_TEST(test_fail_not_nhwc_nor_hwck);
   RUN_TEST(test_fail_not_same_layout);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_fail_hwck_different_k);
   RUN_TEST(test_fail_src_not_transformed);
   RUN_TEST(test_fail_dest_already_transformed);
 
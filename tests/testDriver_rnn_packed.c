@@ -0,0 +1,266 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common_rnn.h"
+
+#define NUM_TS 5
+#define NUM_BATCHES 4
+#define NUM_FEATURES 5
+#define HIDDEN_SIZE 3
+#define MAX_DIRS 2
+
+// unsorted, with a repeated length and a row shorter than all others
+static uint32_t seq_lens[NUM_BATCHES] = {3, 5, 1, 3};
+
+void setUp(void) { VERIFY_HW_ENV; }
+
+void tearDown(void) {}
+
+typedef struct rnn_tensors {
+  uint32_t num_dirs;
+  float input_values[NUM_TS][NUM_BATCHES][NUM_FEATURES];
+  float h0_values[MAX_DIRS][NUM_BATCHES][HIDDEN_SIZE];
+  float c0_values[MAX_DIRS][NUM_BATCHES][HIDDEN_SIZE];
+  // h0 and c0 are cut per row from the values above instead
+  rnn_layer_ztensors layer;
+} rnn_tensors;
+
+static void alloc_rnn_tensors(uint8_t function_code, uint32_t num_dirs,
+                              rnn_tensors *t) {
+  t->num_dirs = num_dirs;
+  gen_random_float_array_pos_neg(NUM_TS * NUM_BATCHES * NUM_FEATURES,
+                                 &t->input_values[0][0][0]);
+  gen_random_float_array_pos_neg(MAX_DIRS * NUM_BATCHES * HIDDEN_SIZE,
+                                 &t->h0_values[0][0][0]);
+  gen_random_float_array_pos_neg(MAX_DIRS * NUM_BATCHES * HIDDEN_SIZE,
+                                 &t->c0_values[0][0][0]);
+
+  alloc_rnn_layer_ztensors(function_code, PREV_LAYER_UNI, num_dirs, 0,
+                           NUM_FEATURES, HIDDEN_SIZE, &t->layer);
+}
+
+/// Allocate the input, h0 and c0 ztensors of either the whole batch (row < 0)
+/// or of a single row cut down to its own length
+static void alloc_batch_ztensors(rnn_tensors *t, int row, zdnn_ztensor **input,
+                                 zdnn_ztensor **h0, zdnn_ztensor **c0) {
+  uint32_t num_rows = (row < 0) ? NUM_BATCHES : 1;
+  uint32_t num_ts = (row < 0) ? NUM_TS : seq_lens[row];
+  uint32_t first_row = (row < 0) ? 0 : row;
+
+  float input_values[NUM_TS * NUM_BATCHES * NUM_FEATURES];
+  float h0_values[MAX_DIRS * NUM_BATCHES * HIDDEN_SIZE];
+  float c0_values[MAX_DIRS * NUM_BATCHES * HIDDEN_SIZE];
+  uint32_t idx = 0;
+  for (uint32_t ts = 0; ts < num_ts; ts++) {
+    for (uint32_t b = first_row; b < first_row + num_rows; b++) {
+      memcpy(&input_values[idx++ * NUM_FEATURES], t->input_values[ts][b],
+             NUM_FEATURES * sizeof(float));
+    }
+  }
+  idx = 0;
+  for (uint32_t d = 0; d < t->num_dirs; d++) {
+    for (uint32_t b = first_row; b < first_row + num_rows; b++) {
+      memcpy(&h0_values[idx * HIDDEN_SIZE], t->h0_values[d][b],
+             HIDDEN_SIZE * sizeof(float));
+      memcpy(&c0_values[idx++ * HIDDEN_SIZE], t->c0_values[d][b],
+             HIDDEN_SIZE * sizeof(float));
+    }
+  }
+
+  uint32_t input_shape[] = {num_ts, num_rows, NUM_FEATURES};
+  uint32_t state_shape[] = {t->num_dirs, num_rows, HIDDEN_SIZE};
+  *input = alloc_ztensor_with_values(input_shape, ZDNN_3DS, FP32, NO_CONCAT,
+                                     false, input_values);
+  *h0 = alloc_ztensor_with_values(state_shape, ZDNN_3DS, FP32, NO_CONCAT,
+                                  false, h0_values);
+  *c0 = alloc_ztensor_with_values(state_shape, ZDNN_3DS, FP32, NO_CONCAT,
+                                  false, c0_values);
+}
+
+static zdnn_status run_rnn(uint8_t function_code, rnn_tensors *t,
+                           const uint32_t *lens, zdnn_ztensor *input,
+                           zdnn_ztensor *h0, zdnn_ztensor *c0,
+                           lstm_gru_direction direction, zdnn_ztensor *hn,
+                           zdnn_ztensor *cf) {
+  rnn_layer_ztensors *l = &t->layer;
+
+  if (function_code == NNPA_LSTMACT) {
+    return lens ? zdnn_lstm_packed(input, lens, h0, c0, l->weights, l->biases,
+                                   l->hidden_weights, l->hidden_biases,
+                                   direction, NULL, hn, cf)
+                : zdnn_lstm(input, h0, c0, l->weights, l->biases,
+                            l->hidden_weights, l->hidden_biases, direction,
+                            NULL, hn, cf);
+  }
+  return lens ? zdnn_gru_packed(input, lens, h0, l->weights, l->biases,
+                                l->hidden_weights, l->hidden_biases,
+                                direction, NULL, hn)
+              : zdnn_gru(input, h0, l->weights, l->biases, l->hidden_weights,
+                         l->hidden_biases, direction, NULL, hn);
+}
+
+/// Run the padded batch with zdnn_lstm_packed()/zdnn_gru_packed(), then every
+/// row on its own, unpadded, with zdnn_lstm()/zdnn_gru().  Each row of the
+/// packed outputs must match its own run and hn_output must be zero past the
+/// row's length.
+///
+/// \param[in] function_code NNPA_LSTMACT or NNPA_GRUACT
+/// \param[in] direction FWD, BWD or BIDIR
+/// \param[in] all_timesteps hn_output of all timesteps or only the final one
+///
+void test_packed(uint8_t function_code, lstm_gru_direction direction,
+                 bool all_timesteps) {
+  bool is_lstm = (function_code == NNPA_LSTMACT);
+  uint32_t num_dirs = (direction == BIDIR) ? 2 : 1;
+  rnn_tensors t;
+  alloc_rnn_tensors(function_code, num_dirs, &t);
+
+  zdnn_ztensor *input, *h0, *c0;
+  alloc_batch_ztensors(&t, -1, &input, &h0, &c0);
+
+  uint32_t hn_ts = all_timesteps ? NUM_TS : 1;
+  uint32_t hn_shape[] = {hn_ts, num_dirs, NUM_BATCHES, HIDDEN_SIZE};
+  uint32_t cf_shape[] = {1, num_dirs, NUM_BATCHES, HIDDEN_SIZE};
+  zdnn_ztensor *hn =
+      alloc_output_ztensor(hn_shape, ZDNN_4DS, FP32, NO_CONCAT);
+  zdnn_ztensor *cf =
+      alloc_output_ztensor(cf_shape, ZDNN_4DS, FP32, NO_CONCAT);
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, run_rnn(function_code, &t, seq_lens, input, h0,
+                                     c0, direction, hn, cf));
+
+  float hn_values[NUM_TS][MAX_DIRS][NUM_BATCHES][HIDDEN_SIZE];
+  float cf_values[MAX_DIRS][NUM_BATCHES][HIDDEN_SIZE];
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_origtensor(hn, hn_values));
+  if (is_lstm) {
+    TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_origtensor(cf, cf_values));
+  }
+
+  // zdnn_transform_origtensor() packs the values by the actual dims
+  float(*hn_rows)[num_dirs][NUM_BATCHES][HIDDEN_SIZE] = (void *)hn_values;
+  float(*cf_rows)[NUM_BATCHES][HIDDEN_SIZE] = (void *)cf_values;
+  float zeros[HIDDEN_SIZE] = {0};
+
+  for (uint32_t b = 0; b < NUM_BATCHES; b++) {
+    zdnn_ztensor *row_input, *row_h0, *row_c0;
+    alloc_batch_ztensors(&t, b, &row_input, &row_h0, &row_c0);
+
+    uint32_t row_hn_ts = all_timesteps ? seq_lens[b] : 1;
+    uint32_t row_hn_shape[] = {row_hn_ts, num_dirs, 1, HIDDEN_SIZE};
+    uint32_t row_cf_shape[] = {1, num_dirs, 1, HIDDEN_SIZE};
+    zdnn_ztensor *row_hn =
+        alloc_output_ztensor(row_hn_shape, ZDNN_4DS, FP32, NO_CONCAT);
+    zdnn_ztensor *row_cf =
+        alloc_output_ztensor(row_cf_shape, ZDNN_4DS, FP32, NO_CONCAT);
+
+    TEST_ASSERT_EQUAL(ZDNN_OK,
+                      run_rnn(function_code, &t, NULL, row_input, row_h0,
+                              row_c0, direction, row_hn, row_cf));
+
+    float row_hn_values[NUM_TS][num_dirs][HIDDEN_SIZE];
+    float row_cf_values[num_dirs][HIDDEN_SIZE];
+    TEST_ASSERT_EQUAL(ZDNN_OK,
+                      zdnn_transform_origtensor(row_hn, row_hn_values));
+    if (is_lstm) {
+      TEST_ASSERT_EQUAL(ZDNN_OK,
+                        zdnn_transform_origtensor(row_cf, row_cf_values));
+    }
+
+    for (uint32_t d = 0; d < num_dirs; d++) {
+      for (uint32_t ts = 0; ts < hn_ts; ts++) {
+        TEST_ASSERT_EQUAL_MEMORY_MESSAGE(
+            (ts < row_hn_ts) ? row_hn_values[ts][d] : zeros,
+            hn_rows[ts][d][b], sizeof(zeros),
+            "packed hn differs from the row's own run");
+      }
+      if (is_lstm) {
+        TEST_ASSERT_EQUAL_MEMORY_MESSAGE(
+            row_cf_values[d], cf_rows[d][b], sizeof(zeros),
+            "packed cf differs from the row's own run");
+      }
+    }
+
+    free_ztensor_buffers(5, row_input, row_h0, row_c0, row_hn, row_cf);
+  }
+
+  free_ztensor_buffers(5, input, h0, c0, hn, cf);
+  free_rnn_layer_ztensors(&t.layer);
+}
+
+void test_lstm_packed_fwd_hn_all() { test_packed(NNPA_LSTMACT, FWD, true); }
+void test_lstm_packed_fwd_hn_final() { test_packed(NNPA_LSTMACT, FWD, false); }
+void test_lstm_packed_bwd_hn_all() { test_packed(NNPA_LSTMACT, BWD, true); }
+void test_lstm_packed_bwd_hn_final() { test_packed(NNPA_LSTMACT, BWD, false); }
+void test_lstm_packed_bidir_hn_all() {
+  test_packed(NNPA_LSTMACT, BIDIR, true);
+}
+void test_lstm_packed_bidir_hn_final() {
+  test_packed(NNPA_LSTMACT, BIDIR, false);
+}
+void test_gru_packed_fwd_hn_all() { test_packed(NNPA_GRUACT, FWD, true); }
+void test_gru_packed_fwd_hn_final() { test_packed(NNPA_GRUACT, FWD, false); }
+void test_gru_packed_bwd_hn_all() { test_packed(NNPA_GRUACT, BWD, true); }
+void test_gru_packed_bwd_hn_final() { test_packed(NNPA_GRUACT, BWD, false); }
+void test_gru_packed_bidir_hn_all() { test_packed(NNPA_GRUACT, BIDIR, true); }
+void test_gru_packed_bidir_hn_final() {
+  test_packed(NNPA_GRUACT, BIDIR, false);
+}
+
+// every length must be within [1, ts]
+void test_packed_invalid_seq_lens() {
+  rnn_tensors t;
+  alloc_rnn_tensors(NNPA_GRUACT, 1, &t);
+
+  zdnn_ztensor *input, *h0, *c0;
+  alloc_batch_ztensors(&t, -1, &input, &h0, &c0);
+  uint32_t hn_shape[] = {1, 1, NUM_BATCHES, HIDDEN_SIZE};
+  zdnn_ztensor *hn =
+      alloc_output_ztensor(hn_shape, ZDNN_4DS, FP32, NO_CONCAT);
+
+  uint32_t zero_len[NUM_BATCHES] = {3, 0, 1, 3};
+  uint32_t too_long[NUM_BATCHES] = {3, NUM_TS + 1, 1, 3};
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_SHAPE,
+                    run_rnn(NNPA_GRUACT, &t, zero_len, input, h0, NULL, FWD,
+                            hn, NULL));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_SHAPE,
+                    run_rnn(NNPA_GRUACT, &t, too_long, input, h0, NULL, FWD,
+                            hn, NULL));
+
+  free_ztensor_buffers(4, input, h0, c0, hn);
+  free_rnn_layer_ztensors(&t.layer);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_lstm_packed_fwd_hn_all);
+  RUN_TEST(test_lstm_packed_fwd_hn_final);
+  RUN_TEST(test_lstm_packed_bwd_hn_all);
+  RUN_TEST(test_lstm_packed_bwd_hn_final);
+  RUN_TEST(test_lstm_packed_bidir_hn_all);
+  RUN_TEST(test_lstm_packed_bidir_hn_final);
+  RUN_TEST(test_gru_packed_fwd_hn_all);
+  RUN_TEST(test_gru_packed_fwd_hn_final);
+  RUN_TEST(test_gru_packed_bwd_hn_all);
+  RUN_TEST(test_gru_packed_bwd_hn_final);
+  RUN_TEST(test_gru_packed_bidir_hn_all);
+  RUN_TEST(test_gru_packed_bidir_hn_final);
+  RUN_TEST(test_packed_invalid_seq_lens);
+  return UNITY_END();
+}
@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common_rnn.h"
+
+#define NUM_TS 6
+#define NUM_BATCHES 2
+#define NUM_FEATURES 5
+#define HIDDEN_SIZE 3
+
+void setUp(void) { VERIFY_HW_ENV; }
+
+void tearDown(void) {}
+
+static float input_values[NUM_TS * NUM_BATCHES * NUM_FEATURES];
+
+static void alloc_rnn_tensors(uint8_t function_code, rnn_layer_ztensors *t) {
+  gen_random_float_array_pos_neg(NUM_TS * NUM_BATCHES * NUM_FEATURES,
+                                 input_values);
+  alloc_rnn_layer_ztensors(function_code, PREV_LAYER_UNI, 1, NUM_BATCHES,
+                           NUM_FEATURES, HIDDEN_SIZE, t);
+}
+
+/// Allocate the input ztensor of timesteps [first_ts, first_ts + num_ts)
+static zdnn_ztensor *alloc_input_chunk(uint32_t first_ts, uint32_t num_ts) {
+  uint32_t shape[] = {num_ts, NUM_BATCHES, NUM_FEATURES};
+  return alloc_ztensor_with_values(
+      shape, ZDNN_3DS, FP32, NO_CONCAT, false,
+      &input_values[first_ts * NUM_BATCHES * NUM_FEATURES]);
+}
+
+/// Unstickify an output ztensor into FP32 values, padding excluded
+static void get_output_values(zdnn_ztensor *ztensor, float *values) {
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_origtensor(ztensor, values));
+}
+
+/// Run the whole sequence with zdnn_lstm()/zdnn_gru(), then the same sequence
+/// through a session in chunks of chunk_ts timesteps.  The hidden states of
+/// every timestep and the final cell state must be identical.
+///
+/// \param[in] function_code NNPA_LSTMACT or NNPA_GRUACT
+/// \param[in] chunk_ts timesteps per step, NUM_TS must be a multiple of it
+///
+void test_session(uint8_t function_code, uint32_t chunk_ts) {
+  bool is_lstm = (function_code == NNPA_LSTMACT);
+  rnn_layer_ztensors t;
+  alloc_rnn_tensors(function_code, &t);
+
+  uint32_t hn_shape[] = {NUM_TS, 1, NUM_BATCHES, HIDDEN_SIZE};
+  uint32_t cf_shape[] = {1, 1, NUM_BATCHES, HIDDEN_SIZE};
+  zdnn_ztensor *input = alloc_input_chunk(0, NUM_TS);
+  zdnn_ztensor *exp_hn = alloc_output_ztensor(hn_shape, ZDNN_4DS, FP32,
+                                              NO_CONCAT);
+  zdnn_ztensor *exp_cf = alloc_output_ztensor(cf_shape, ZDNN_4DS, FP32,
+                                              NO_CONCAT);
+
+  zdnn_status status =
+      is_lstm ? zdnn_lstm(input, t.h0, t.c0, t.weights, t.biases,
+                          t.hidden_weights, t.hidden_biases, FWD, NULL, exp_hn,
+                          exp_cf)
+              : zdnn_gru(input, t.h0, t.weights, t.biases, t.hidden_weights,
+                         t.hidden_biases, FWD, NULL, exp_hn);
+  TEST_ASSERT_EQUAL(ZDNN_OK, status);
+
+  zdnn_rnn_session *session;
+  status = is_lstm ? zdnn_create_lstm_session(t.h0, t.c0, t.weights, t.biases,
+                                              t.hidden_weights,
+                                              t.hidden_biases, chunk_ts,
+                                              &session)
+                   : zdnn_create_gru_session(t.h0, t.weights, t.biases,
+                                             t.hidden_weights, t.hidden_biases,
+                                             chunk_ts, &session);
+  TEST_ASSERT_EQUAL(ZDNN_OK, status);
+
+  float exp_hn_values[NUM_TS * NUM_BATCHES * HIDDEN_SIZE];
+  float exp_cf_values[NUM_BATCHES * HIDDEN_SIZE];
+  float hn_values[NUM_TS * NUM_BATCHES * HIDDEN_SIZE];
+  float cf_values[NUM_BATCHES * HIDDEN_SIZE];
+  size_t ts_values = NUM_BATCHES * HIDDEN_SIZE;
+
+  get_output_values(exp_hn, exp_hn_values);
+  if (is_lstm) {
+    get_output_values(exp_cf, exp_cf_values);
+  }
+
+  uint32_t chunk_hn_shape[] = {chunk_ts, 1, NUM_BATCHES, HIDDEN_SIZE};
+  zdnn_ztensor *cf = alloc_output_ztensor(cf_shape, ZDNN_4DS, FP32, NO_CONCAT);
+
+  // twice, resetting the state in between
+  for (int pass = 0; pass < 2; pass++) {
+    for (uint32_t ts = 0; ts < NUM_TS; ts += chunk_ts) {
+      zdnn_ztensor *chunk = alloc_input_chunk(ts, chunk_ts);
+      zdnn_ztensor *hn =
+          alloc_output_ztensor(chunk_hn_shape, ZDNN_4DS, FP32, NO_CONCAT);
+
+      TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_rnn_session_step(session, chunk, hn,
+                                                       is_lstm ? cf : NULL));
+      get_output_values(hn, hn_values);
+      TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&exp_hn_values[ts * ts_values],
+                                       hn_values,
+                                       chunk_ts * ts_values * sizeof(float),
+                                       "session hn differs from full sequence");
+      free_ztensor_buffers(2, chunk, hn);
+    }
+    if (is_lstm) {
+      get_output_values(cf, cf_values);
+      TEST_ASSERT_EQUAL_MEMORY_MESSAGE(exp_cf_values, cf_values,
+                                       sizeof(cf_values),
+                                       "session cf differs from full sequence");
+    }
+    TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_reset_rnn_session(session, t.h0,
+                                                      is_lstm ? t.c0 : NULL));
+  }
+
+  zdnn_free_rnn_session(session);
+  free_ztensor_buffers(4, input, exp_hn, exp_cf, cf);
+  free_rnn_layer_ztensors(&t);
+}
+
+void test_lstm_session_1ts() { test_session(NNPA_LSTMACT, 1); }
+void test_lstm_session_3ts() { test_session(NNPA_LSTMACT, 3); }
+void test_gru_session_1ts() { test_session(NNPA_GRUACT, 1); }
+void test_gru_session_2ts() { test_session(NNPA_GRUACT, 2); }
+
+// a step longer than max_timesteps doesn't fit the work area
+void test_session_too_many_ts() {
+  rnn_layer_ztensors t;
+  alloc_rnn_tensors(NNPA_GRUACT, &t);
+
+  zdnn_rnn_session *session;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_create_gru_session(
+                                 t.h0, t.weights, t.biases, t.hidden_weights,
+                                 t.hidden_biases, 2, &session));
+
+  uint32_t hn_shape[] = {1, 1, NUM_BATCHES, HIDDEN_SIZE};
+  zdnn_ztensor *chunk = alloc_input_chunk(0, 3);
+  zdnn_ztensor *hn = alloc_output_ztensor(hn_shape, ZDNN_4DS, FP32, NO_CONCAT);
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_SHAPE,
+                    zdnn_rnn_session_step(session, chunk, hn, NULL));
+
+  zdnn_free_rnn_session(session);
+  free_ztensor_buffers(2, chunk, hn);
+  free_rnn_layer_ztensors(&t);
+}
+
+// sessions are forward only, h0 can't have 2 directions
+void test_session_bidir_h0() {
+  rnn_layer_ztensors t;
+  alloc_rnn_tensors(NNPA_LSTMACT, &t);
+
+  uint32_t bidir_shape[] = {2, NUM_BATCHES, HIDDEN_SIZE};
+  zdnn_ztensor *h0 =
+      alloc_ztensor_with_values(bidir_shape, ZDNN_3DS, FP32, NO_CONCAT, true,
+                                ZERO_ARRAY);
+
+  zdnn_rnn_session *session;
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_SHAPE,
+                    zdnn_create_lstm_session(h0, t.c0, t.weights, t.biases,
+                                             t.hidden_weights, t.hidden_biases,
+                                             1, &session));
+
+  free_ztensor_buffers(1, h0);
+  free_rnn_layer_ztensors(&t);
+}
+
+// tensors are checked before the session looks at their shapes
+void test_session_missing_tensor() {
+  rnn_layer_ztensors t;
+  alloc_rnn_tensors(NNPA_LSTMACT, &t);
+
+  zdnn_rnn_session *session;
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE,
+                    zdnn_create_lstm_session(t.h0, t.c0, NULL, t.biases,
+                                             t.hidden_weights, t.hidden_biases,
+                                             1, &session));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE,
+                    zdnn_create_lstm_session(t.h0, NULL, t.weights, t.biases,
+                                             t.hidden_weights, t.hidden_biases,
+                                             1, &session));
+
+  t.hidden_biases->is_transformed = false;
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE,
+                    zdnn_create_lstm_session(t.h0, t.c0, t.weights, t.biases,
+                                             t.hidden_weights, t.hidden_biases,
+                                             1, &session));
+  t.hidden_biases->is_transformed = true;
+
+  free_rnn_layer_ztensors(&t);
+}
+
+// hidden_weights of another hidden size don't fit h0
+void test_session_bad_hidden_weights() {
+  rnn_layer_ztensors t;
+  alloc_rnn_tensors(NNPA_GRUACT, &t);
+
+  uint32_t hidden_weights_shape[] = {1, HIDDEN_SIZE + 1, HIDDEN_SIZE};
+  zdnn_ztensor *hidden_weights = alloc_gates_ztensor(
+      hidden_weights_shape, ZDNN_3DS, RNN_TYPE_GRU | USAGE_HIDDEN_WEIGHTS,
+      get_func_code_num_gates(NNPA_GRUACT), (HIDDEN_SIZE + 1) * HIDDEN_SIZE);
+
+  zdnn_rnn_session *session;
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_SHAPE,
+                    zdnn_create_gru_session(t.h0, t.weights, t.biases,
+                                            hidden_weights, t.hidden_biases, 1,
+                                            &session));
+
+  free_ztensor_buffers(1, hidden_weights);
+  free_rnn_layer_ztensors(&t);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_lstm_session_1ts);
+  RUN_TEST(test_lstm_session_3ts);
+  RUN_TEST(test_gru_session_1ts);
+  RUN_TEST(test_gru_session_2ts);
+  RUN_TEST(test_session_too_many_ts);
+  RUN_TEST(test_session_bidir_h0);
+  RUN_TEST(test_session_missing_tensor);
+  RUN_TEST(test_session_bad_hidden_weights);
+  return UNITY_END();
+}
@@ -0,0 +1,216 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common_rnn.h"
+
+#define NUM_TS 4
+#define NUM_BATCHES 3
+#define NUM_FEATURES 5
+#define NUM_LAYERS 3
+
+// a layer wider than a stick in the middle, so the intermediate outputs differ
+// in size
+static uint32_t hidden_sizes[NUM_LAYERS] = {3, 70, 5};
+
+static bool saved_precheck;
+
+void setUp(void) {
+  VERIFY_HW_ENV;
+  saved_precheck = precheck_enabled;
+}
+
+void tearDown(void) { precheck_enabled = saved_precheck; }
+
+static void alloc_rnn_layer(uint8_t function_code, uint32_t num_dirs,
+                            uint32_t layer, rnn_layer_ztensors *l) {
+  zdnn_concat_info prev_layer =
+      (layer > 0 && num_dirs == 2) ? PREV_LAYER_BIDIR : PREV_LAYER_UNI;
+
+  // a BIDIR layer's input is both directions of the previous one
+  uint32_t num_features = (layer == 0)
+                              ? NUM_FEATURES
+                              : hidden_sizes[layer - 1] * num_dirs;
+
+  alloc_rnn_layer_ztensors(function_code, prev_layer, num_dirs, NUM_BATCHES,
+                           num_features, hidden_sizes[layer], l);
+}
+
+/// Run NUM_LAYERS layers one zdnn_lstm()/zdnn_gru() call at a time, then the
+/// same layers with zdnn_lstm_stack()/zdnn_gru_stack().  The last layer's
+/// outputs must be identical.
+///
+/// \param[in] function_code NNPA_LSTMACT or NNPA_GRUACT
+/// \param[in] direction FWD, BWD or BIDIR
+/// \param[in] all_timesteps last hn_output of all timesteps or the final one
+///
+void test_stack(uint8_t function_code, lstm_gru_direction direction,
+                bool all_timesteps) {
+  bool is_lstm = (function_code == NNPA_LSTMACT);
+  uint32_t num_dirs = (direction == BIDIR) ? 2 : 1;
+
+  rnn_layer_ztensors layers[NUM_LAYERS];
+  const zdnn_ztensor *h0[NUM_LAYERS], *c0[NUM_LAYERS], *weights[NUM_LAYERS],
+      *biases[NUM_LAYERS], *hidden_weights[NUM_LAYERS],
+      *hidden_biases[NUM_LAYERS];
+  for (uint32_t i = 0; i < NUM_LAYERS; i++) {
+    alloc_rnn_layer(function_code, num_dirs, i, &layers[i]);
+    h0[i] = layers[i].h0;
+    c0[i] = layers[i].c0;
+    weights[i] = layers[i].weights;
+    biases[i] = layers[i].biases;
+    hidden_weights[i] = layers[i].hidden_weights;
+    hidden_biases[i] = layers[i].hidden_biases;
+  }
+
+  uint32_t input_shape[] = {NUM_TS, NUM_BATCHES, NUM_FEATURES};
+  zdnn_ztensor *input =
+      alloc_ztensor_with_random_values(input_shape, ZDNN_3DS, -2, 2);
+
+  // layer by layer, all timesteps but for the last layer
+  zdnn_ztensor *exp_hn[NUM_LAYERS], *exp_cf[NUM_LAYERS];
+  for (uint32_t i = 0; i < NUM_LAYERS; i++) {
+    bool is_last = (i == NUM_LAYERS - 1);
+    uint32_t hn_shape[] = {(is_last && !all_timesteps) ? 1 : NUM_TS,
+                           num_dirs, NUM_BATCHES, hidden_sizes[i]};
+    uint32_t cf_shape[] = {1, num_dirs, NUM_BATCHES, hidden_sizes[i]};
+    exp_hn[i] = alloc_output_ztensor(hn_shape, ZDNN_4DS, FP32, NO_CONCAT);
+    exp_cf[i] = alloc_output_ztensor(cf_shape, ZDNN_4DS, FP32, NO_CONCAT);
+
+    const zdnn_ztensor *layer_input = (i == 0) ? input : exp_hn[i - 1];
+    zdnn_status status =
+        is_lstm ? zdnn_lstm(layer_input, h0[i], c0[i], weights[i], biases[i],
+                            hidden_weights[i], hidden_biases[i], direction,
+                            NULL, exp_hn[i], exp_cf[i])
+                : zdnn_gru(layer_input, h0[i], weights[i], biases[i],
+                           hidden_weights[i], hidden_biases[i], direction,
+                           NULL, exp_hn[i]);
+    TEST_ASSERT_EQUAL(ZDNN_OK, status);
+  }
+
+  uint32_t last_hidden = hidden_sizes[NUM_LAYERS - 1];
+  uint32_t hn_shape[] = {all_timesteps ? NUM_TS : 1, num_dirs, NUM_BATCHES,
+                         last_hidden};
+  uint32_t cf_shape[] = {1, num_dirs, NUM_BATCHES, last_hidden};
+  zdnn_ztensor *hn = alloc_output_ztensor(hn_shape, ZDNN_4DS, FP32, NO_CONCAT);
+  zdnn_ztensor *cf = alloc_output_ztensor(cf_shape, ZDNN_4DS, FP32, NO_CONCAT);
+
+  zdnn_status status =
+      is_lstm ? zdnn_lstm_stack(input, NUM_LAYERS, h0, c0, weights, biases,
+                                hidden_weights, hidden_biases, direction, NULL,
+                                hn, cf)
+              : zdnn_gru_stack(input, NUM_LAYERS, h0, weights, biases,
+                               hidden_weights, hidden_biases, direction, NULL,
+                               hn);
+  TEST_ASSERT_EQUAL(ZDNN_OK, status);
+
+  uint64_t num_values = get_num_elements(hn, ELEMENTS_PRE);
+  float *exp_values = malloc(num_values * sizeof(float));
+  float *values = malloc(num_values * sizeof(float));
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_origtensor(exp_hn[NUM_LAYERS - 1],
+                                                       exp_values));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_origtensor(hn, values));
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(exp_values, values,
+                                   num_values * sizeof(float),
+                                   "stack hn differs from layer by layer");
+  if (is_lstm) {
+    num_values = get_num_elements(cf, ELEMENTS_PRE);
+    TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_origtensor(
+                                   exp_cf[NUM_LAYERS - 1], exp_values));
+    TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_origtensor(cf, values));
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(exp_values, values,
+                                     num_values * sizeof(float),
+                                     "stack cf differs from layer by layer");
+  }
+
+  free(exp_values);
+  free(values);
+  for (uint32_t i = 0; i < NUM_LAYERS; i++) {
+    free_ztensor_buffers(2, exp_hn[i], exp_cf[i]);
+    free_rnn_layer_ztensors(&layers[i]);
+  }
+  free_ztensor_buffers(3, input, hn, cf);
+}
+
+void test_lstm_stack_fwd_hn_all() { test_stack(NNPA_LSTMACT, FWD, true); }
+void test_lstm_stack_bwd_hn_final() { test_stack(NNPA_LSTMACT, BWD, false); }
+void test_lstm_stack_bidir_hn_all() { test_stack(NNPA_LSTMACT, BIDIR, true); }
+void test_lstm_stack_bidir_hn_final() {
+  test_stack(NNPA_LSTMACT, BIDIR, false);
+}
+void test_gru_stack_fwd_hn_final() { test_stack(NNPA_GRUACT, FWD, false); }
+void test_gru_stack_bwd_hn_all() { test_stack(NNPA_GRUACT, BWD, true); }
+void test_gru_stack_bidir_hn_all() { test_stack(NNPA_GRUACT, BIDIR, true); }
+void test_gru_stack_bidir_hn_final() {
+  test_stack(NNPA_GRUACT, BIDIR, false);
+}
+
+// a layer whose weights don't take the previous layer's output is caught by
+// precheck before any layer runs
+void test_stack_mismatched_layers() {
+  precheck_enabled = true;
+
+  rnn_layer_ztensors layers[2];
+  alloc_rnn_layer(NNPA_GRUACT, 1, 0, &layers[0]);
+  // layer 0's weights again, sized for the stack's input rather than layer 0's
+  // output
+  alloc_rnn_layer(NNPA_GRUACT, 1, 0, &layers[1]);
+
+  const zdnn_ztensor *h0[] = {layers[0].h0, layers[0].h0};
+  const zdnn_ztensor *weights[] = {layers[0].weights, layers[1].weights};
+  const zdnn_ztensor *biases[] = {layers[0].biases, layers[1].biases};
+  const zdnn_ztensor *hidden_weights[] = {layers[0].hidden_weights,
+                                          layers[1].hidden_weights};
+  const zdnn_ztensor *hidden_biases[] = {layers[0].hidden_biases,
+                                         layers[1].hidden_biases};
+
+  uint32_t input_shape[] = {NUM_TS, NUM_BATCHES, NUM_FEATURES};
+  uint32_t hn_shape[] = {1, 1, NUM_BATCHES, hidden_sizes[0]};
+  zdnn_ztensor *input =
+      alloc_ztensor_with_random_values(input_shape, ZDNN_3DS, -2, 2);
+  zdnn_ztensor *hn = alloc_output_ztensor(hn_shape, ZDNN_4DS, FP32, NO_CONCAT);
+
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_SHAPE,
+                    zdnn_gru_stack(input, 2, h0, weights, biases,
+                                   hidden_weights, hidden_biases, FWD, NULL,
+                                   hn));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_SHAPE,
+                    zdnn_gru_stack(input, 0, h0, weights, biases,
+                                   hidden_weights, hidden_biases, FWD, NULL,
+                                   hn));
+
+  free_ztensor_buffers(2, input, hn);
+  free_rnn_layer_ztensors(&layers[0]);
+  free_rnn_layer_ztensors(&layers[1]);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_lstm_stack_fwd_hn_all);
+  RUN_TEST(test_lstm_stack_bwd_hn_final);
+  RUN_TEST(test_lstm_stack_bidir_hn_all);
+  RUN_TEST(test_lstm_stack_bidir_hn_final);
+  RUN_TEST(test_gru_stack_fwd_hn_final);
+  RUN_TEST(test_gru_stack_bwd_hn_all);
+  RUN_TEST(test_gru_stack_bidir_hn_all);
+  RUN_TEST(test_gru_stack_bidir_hn_final);
+  RUN_TEST(test_stack_mismatched_layers);
+  return UNITY_END();
+}
@@ -0,0 +1,363 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "testsupport.h"
+
+#define DIM3 2
+#define DIM2 5
+#define DIM1 70
+#define NUM_VALUES (DIM3 * DIM2 * DIM1)
+
+static char name[64];
+
+static zdnn_tensor_desc pre_tfrmd_desc, tfrmd_desc;
+static float values[NUM_VALUES];
+
+void setUp(void) {
+  VERIFY_HW_ENV;
+  snprintf(name, sizeof(name), "/zdnn_shm_ztensor_%d", (int)getpid());
+
+  zdnn_init_pre_transformed_desc(ZDNN_3DS, FP32, &pre_tfrmd_desc, DIM3, DIM2,
+                                 DIM1);
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_generate_transformed_desc(&pre_tfrmd_desc,
+                                                            &tfrmd_desc));
+  gen_random_float_array(NUM_VALUES, values);
+}
+
+void tearDown(void) { shm_unlink(name); }
+
+/// Create the shared memory ztensor, transform values into it and publish it
+static void create_published(zdnn_ztensor *ztensor) {
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_init_ztensor_with_shm(
+                                 &pre_tfrmd_desc, &tfrmd_desc, name, ztensor));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_ztensor(ztensor, values));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_publish_shm_ztensor(ztensor));
+}
+
+void test_create() {
+  zdnn_ztensor ztensor;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_init_ztensor_with_shm(
+                                 &pre_tfrmd_desc, &tfrmd_desc, name, &ztensor));
+
+  TEST_ASSERT_FALSE(ztensor.is_transformed);
+  TEST_ASSERT_EQUAL_UINT64(zdnn_getsize_ztensor(&tfrmd_desc),
+                           ztensor.buffer_size);
+  TEST_ASSERT_MESSAGE_FORMATTED(
+      ((uintptr_t)ztensor.buffer & (AIU_PAGESIZE_IN_BYTES - 1)) == 0,
+      "buffer %p isn't 4k aligned", ztensor.buffer);
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_detach_shm_ztensor(&ztensor));
+  TEST_ASSERT_NULL(ztensor.buffer);
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_BUFFER, zdnn_detach_shm_ztensor(&ztensor));
+}
+
+// the attached buffer holds what was transformed, and is used as an operation
+// input as is
+void test_attach() {
+  zdnn_ztensor created, attached;
+  create_published(&created);
+
+  zdnn_tensor_desc pre2, tfrmd2;
+  zdnn_init_pre_transformed_desc(ZDNN_3DS, FP32, &pre2, DIM3, DIM2, DIM1);
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_generate_transformed_desc(&pre2, &tfrmd2));
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_attach_shm_ztensor(&pre2, &tfrmd2, name, &attached));
+  TEST_ASSERT_TRUE(attached.is_transformed);
+  TEST_ASSERT_EQUAL_UINT64(created.buffer_size, attached.buffer_size);
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(created.buffer, attached.buffer,
+                                   attached.buffer_size, "stick area differs");
+
+  uint32_t shape[] = {DIM3, DIM2, DIM1};
+  zdnn_ztensor *input = alloc_ztensor_with_values(shape, ZDNN_3DS, FP32,
+                                                  NO_CONCAT, false, values);
+  zdnn_ztensor *exp_out =
+      alloc_output_ztensor(shape, ZDNN_3DS, FP32, NO_CONCAT);
+  zdnn_ztensor *out = alloc_output_ztensor(shape, ZDNN_3DS, FP32, NO_CONCAT);
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_add(input, input, exp_out));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_add(&attached, &attached, out));
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(exp_out->buffer, out->buffer,
+                                   out->buffer_size,
+                                   "output from attached input differs");
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_detach_shm_ztensor(&attached));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_detach_shm_ztensor(&created));
+  free_ztensor_buffers(3, input, exp_out, out);
+}
+
+// another process sees the same pages
+void test_attach_other_process() {
+  zdnn_ztensor created;
+  create_published(&created);
+
+  pid_t pid = fork();
+  TEST_ASSERT_MESSAGE(pid >= 0, "fork failed");
+  if (pid == 0) {
+    zdnn_ztensor attached;
+    int rc = 1;
+    if (zdnn_attach_shm_ztensor(&pre_tfrmd_desc, &tfrmd_desc, name,
+                                &attached) == ZDNN_OK) {
+      rc = memcmp(created.buffer, attached.buffer, attached.buffer_size) ? 2
+                                                                         : 0;
+      zdnn_detach_shm_ztensor(&attached);
+    }
+    _exit(rc);
+  }
+
+  int wstatus;
+  TEST_ASSERT_EQUAL(pid, waitpid(pid, &wstatus, 0));
+  TEST_ASSERT_TRUE(WIFEXITED(wstatus));
+  TEST_ASSERT_EQUAL_MESSAGE(0, WEXITSTATUS(wstatus),
+                            "other process failed to attach (1) or saw "
+                            "different data (2)");
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_detach_shm_ztensor(&created));
+}
+
+void test_attach_unpublished() {
+  zdnn_ztensor created, attached;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_init_ztensor_with_shm(
+                                 &pre_tfrmd_desc, &tfrmd_desc, name, &created));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_ztensor(&created, values));
+
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE,
+                    zdnn_attach_shm_ztensor(&pre_tfrmd_desc, &tfrmd_desc, name,
+                                            &attached));
+  TEST_ASSERT_NULL(attached.buffer);
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_detach_shm_ztensor(&created));
+}
+
+void test_attach_other_shape() {
+  zdnn_ztensor created, attached;
+  create_published(&created);
+
+  zdnn_tensor_desc pre2, tfrmd2;
+  zdnn_init_pre_transformed_desc(ZDNN_3DS, FP32, &pre2, DIM2, DIM3, DIM1);
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_generate_transformed_desc(&pre2, &tfrmd2));
+  TEST_ASSERT_EQUAL(ZDNN_FILE_ERROR,
+                    zdnn_attach_shm_ztensor(&pre2, &tfrmd2, name, &attached));
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_detach_shm_ztensor(&created));
+}
+
+void test_attach_missing() {
+  zdnn_ztensor attached;
+  TEST_ASSERT_EQUAL(ZDNN_FILE_ERROR,
+                    zdnn_attach_shm_ztensor(&pre_tfrmd_desc, &tfrmd_desc, name,
+                                            &attached));
+}
+
+void test_create_existing() {
+  zdnn_ztensor created, created2;
+  create_published(&created);
+
+  TEST_ASSERT_EQUAL(ZDNN_FILE_ERROR,
+                    zdnn_init_ztensor_with_shm(&pre_tfrmd_desc, &tfrmd_desc,
+                                               name, &created2));
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_detach_shm_ztensor(&created));
+}
+
+void test_publish_not_transformed() {
+  zdnn_ztensor created;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_init_ztensor_with_shm(
+                                 &pre_tfrmd_desc, &tfrmd_desc, name, &created));
+
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE, zdnn_publish_shm_ztensor(&created));
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_detach_shm_ztensor(&created));
+}
+
+// a published or attached zTensor can't be published again
+void test_publish_twice() {
+  zdnn_ztensor created, attached;
+  create_published(&created);
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_attach_shm_ztensor(&pre_tfrmd_desc, &tfrmd_desc, name,
+                                            &attached));
+
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE, zdnn_publish_shm_ztensor(&created));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE, zdnn_publish_shm_ztensor(&attached));
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_detach_shm_ztensor(&attached));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_detach_shm_ztensor(&created));
+}
+
+// a buffer that isn't a shared memory object's stick area is refused, whether
+// or not it is page aligned
+void test_not_shm_buffer() {
+  zdnn_ztensor ztensor;
+  zdnn_init_ztensor(&pre_tfrmd_desc, &tfrmd_desc, &ztensor);
+  ztensor.buffer_size = zdnn_getsize_ztensor(&tfrmd_desc);
+
+  // a zeroed page in front of the buffer, where the header would be
+  const size_t size = AIU_PAGESIZE_IN_BYTES + ztensor.buffer_size;
+  char *pages = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  TEST_ASSERT_TRUE(pages != MAP_FAILED);
+
+  ztensor.buffer = pages + AIU_PAGESIZE_IN_BYTES;
+  ztensor.is_transformed = true;
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_BUFFER, zdnn_publish_shm_ztensor(&ztensor));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_BUFFER, zdnn_detach_shm_ztensor(&ztensor));
+
+  ztensor.buffer = pages + AIU_PAGESIZE_IN_BYTES + AIU_BYTES_PER_STICK;
+  ztensor.buffer_size -= AIU_BYTES_PER_STICK;
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_BUFFER, zdnn_publish_shm_ztensor(&ztensor));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_BUFFER, zdnn_detach_shm_ztensor(&ztensor));
+
+  munmap(pages, size);
+}
+
+// the memory in front of a buffer that isn't a shared memory zTensor's is
+// never read, here a page that can't be
+void test_not_shm_buffer_guarded() {
+  zdnn_ztensor ztensor;
+  zdnn_init_ztensor(&pre_tfrmd_desc, &tfrmd_desc, &ztensor);
+  ztensor.buffer_size = zdnn_getsize_ztensor(&tfrmd_desc);
+
+  const size_t size = AIU_PAGESIZE_IN_BYTES + ztensor.buffer_size;
+  char *pages = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  TEST_ASSERT_TRUE(pages != MAP_FAILED);
+  TEST_ASSERT_EQUAL(0, mprotect(pages, AIU_PAGESIZE_IN_BYTES, PROT_NONE));
+
+  ztensor.buffer = pages + AIU_PAGESIZE_IN_BYTES;
+  ztensor.is_transformed = true;
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_BUFFER, zdnn_publish_shm_ztensor(&ztensor));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_BUFFER, zdnn_detach_shm_ztensor(&ztensor));
+
+  munmap(pages, size);
+}
+
+// per-channel scales and offsets are published with the stick area
+void test_attach_channel_vectors() {
+  float channel_scales[DIM1], channel_offsets[DIM1];
+  for (uint32_t i = 0; i < DIM1; i++) {
+    channel_scales[i] = 0.5f + i;
+    channel_offsets[i] = -(float)i;
+  }
+
+  zdnn_ztensor created, attached;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_init_ztensor_with_shm(
+                                 &pre_tfrmd_desc, &tfrmd_desc, name, &created));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_ztensor(&created, values));
+  created.is_per_channel = true;
+  created.channel_scales = channel_scales;
+  created.channel_offsets = channel_offsets;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_publish_shm_ztensor(&created));
+
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_attach_shm_ztensor(&pre_tfrmd_desc, &tfrmd_desc, name,
+                                            &attached));
+  TEST_ASSERT_TRUE(attached.is_per_channel);
+  TEST_ASSERT_NOT_NULL(attached.channel_scales);
+  TEST_ASSERT_NOT_NULL(attached.channel_offsets);
+  TEST_ASSERT_TRUE(attached.channel_scales != channel_scales);
+  TEST_ASSERT_EQUAL_MEMORY(channel_scales, attached.channel_scales,
+                           sizeof(channel_scales));
+  TEST_ASSERT_EQUAL_MEMORY(channel_offsets, attached.channel_offsets,
+                           sizeof(channel_offsets));
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_detach_shm_ztensor(&attached));
+  TEST_ASSERT_FALSE(attached.is_per_channel);
+  TEST_ASSERT_NULL(attached.channel_scales);
+  TEST_ASSERT_NULL(attached.channel_offsets);
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_detach_shm_ztensor(&created));
+  // the creator's own vectors are left alone
+  TEST_ASSERT_TRUE(created.channel_scales == channel_scales);
+}
+
+// a zTensor published without channel vectors is attached without them
+void test_attach_no_channel_vectors() {
+  zdnn_ztensor created, attached;
+  create_published(&created);
+
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_attach_shm_ztensor(&pre_tfrmd_desc, &tfrmd_desc, name,
+                                            &attached));
+  TEST_ASSERT_FALSE(attached.is_per_channel);
+  TEST_ASSERT_NULL(attached.channel_scales);
+  TEST_ASSERT_NULL(attached.channel_offsets);
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_detach_shm_ztensor(&attached));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_detach_shm_ztensor(&created));
+}
+
+// a shared memory zTensor whose buffer_size was changed is refused
+void test_detach_other_size() {
+  zdnn_ztensor created;
+  create_published(&created);
+
+  created.buffer_size += AIU_PAGESIZE_IN_BYTES;
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_BUFFER, zdnn_detach_shm_ztensor(&created));
+
+  created.buffer_size -= AIU_PAGESIZE_IN_BYTES;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_detach_shm_ztensor(&created));
+}
+
+// unlinking the name leaves existing mappings alone
+void test_unlink() {
+  zdnn_ztensor created, attached;
+  create_published(&created);
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_attach_shm_ztensor(&pre_tfrmd_desc, &tfrmd_desc, name,
+                                            &attached));
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_unlink_shm_ztensor(name));
+  TEST_ASSERT_EQUAL(ZDNN_FILE_ERROR, zdnn_unlink_shm_ztensor(name));
+
+  zdnn_ztensor attached2;
+  TEST_ASSERT_EQUAL(ZDNN_FILE_ERROR,
+                    zdnn_attach_shm_ztensor(&pre_tfrmd_desc, &tfrmd_desc, name,
+                                            &attached2));
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(created.buffer, attached.buffer,
+                                   attached.buffer_size, "stick area differs");
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_detach_shm_ztensor(&attached));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_detach_shm_ztensor(&created));
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_create);
+  RUN_TEST(test_attach);
+  RUN_TEST(test_attach_other_process);
+  RUN_TEST(test_attach_unpublished);
+  RUN_TEST(test_attach_other_shape);
+  RUN_TEST(test_attach_missing);
+  RUN_TEST(test_create_existing);
+  RUN_TEST(test_publish_not_transformed);
+  RUN_TEST(test_publish_twice);
+  RUN_TEST(test_not_shm_buffer);
+  RUN_TEST(test_not_shm_buffer_guarded);
+  RUN_TEST(test_attach_channel_vectors);
+  RUN_TEST(test_attach_no_channel_vectors);
+  RUN_TEST(test_detach_other_size);
+  RUN_TEST(test_unlink);
+
+  return UNITY_END();
+}
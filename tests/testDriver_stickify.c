@@ -110,7 +110,7 @@ void test_stickify(uint32_t dim4, uint32_t dim3, uint32_t dim2, uint32_t dim1,
 
     // value in stick area, stickified
     uint16_t output_stickified_value =
-        *(uint16_t *)((uintptr_t)ztensor.buffer + offsets[i]);
+        STICK_CELL16(*(uint16_t *)((uintptr_t)ztensor.buffer + offsets[i]));
 
     // input value converted to DLFLOAT16, this is the "expected" value
     uint16_t stickified_input_value = 0;
@@ -435,8 +435,8 @@ void test_concat_stickify(zdnn_concat_info info, uint32_t dim3, uint32_t dim2,
       void *concat_slice_data =
           (void *)((uintptr_t)data[concat] + slice_offset);
       for (uint32_t elm_i = 0; elm_i < elements_per_concat_slice; elm_i++) {
-        output_stickified_value =
-            *(uint16_t *)((uintptr_t)ztensor.buffer + offsets[offset_index]);
+        output_stickified_value = STICK_CELL16(
+            *(uint16_t *)((uintptr_t)ztensor.buffer + offsets[offset_index]));
         switch (test_datatype) {
         // Convert input to stickified values for comparison to output.
         case BFLOAT:
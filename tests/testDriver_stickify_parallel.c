@@ -0,0 +1,291 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "testsupport.h"
+
+// enough threads to split every tensor below into several chunks
+#define TEST_THREADS 4
+
+static uint32_t saved_max_threads;
+static bool saved_streaming_stores;
+
+void setUp(void) {
+  VERIFY_HW_ENV;
+  saved_max_threads = zdnn_get_max_threads();
+  saved_streaming_stores = streaming_stores_enabled;
+}
+
+void tearDown(void) {
+  zdnn_set_max_threads(saved_max_threads);
+  streaming_stores_enabled = saved_streaming_stores;
+}
+
+/// Stickify the same data single-threaded and with TEST_THREADS threads, the
+/// resulting status and stick areas must be identical.
+///
+/// \param[in] shape pre-transformed shape, 4 dimensions
+/// \param[in] layout pre-transformed layout
+/// \param[in] type pre-transformed data type
+/// \param[in] saturation use zdnn_transform_ztensor_with_saturation()
+/// \param[in] bad_value_idx index of an element set to infinity, or -1
+/// \param[in] exp_status expected status of both transforms
+///
+void test_parallel_stickify(uint32_t *shape, zdnn_data_layouts layout,
+                            zdnn_data_types type, bool saturation,
+                            int64_t bad_value_idx, zdnn_status exp_status) {
+  uint64_t num_elements = (uint64_t)shape[0] * shape[1] * shape[2] * shape[3];
+
+  float *values = malloc(num_elements * sizeof(float));
+  gen_random_float_array(num_elements, values);
+  if (bad_value_idx >= 0) {
+    values[bad_value_idx] = INFINITY;
+  }
+  void *data =
+      alloc_and_convert_float_values(type, num_elements, false, values);
+
+  zdnn_tensor_desc pre_tfrmd_desc, tfrmd_desc;
+  zdnn_ztensor ztensor[2];
+
+  zdnn_init_pre_transformed_desc(layout, type, &pre_tfrmd_desc, shape[0],
+                                 shape[1], shape[2], shape[3]);
+  TEST_ASSERT_EQUAL(
+      ZDNN_OK, zdnn_generate_transformed_desc(&pre_tfrmd_desc, &tfrmd_desc));
+
+  for (int i = 0; i < 2; i++) {
+    TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_init_ztensor_with_malloc(
+                                   &pre_tfrmd_desc, &tfrmd_desc, &ztensor[i]));
+    // so padding compares equal no matter what malloc handed out
+    memset(ztensor[i].buffer, 0, ztensor[i].buffer_size);
+
+    zdnn_set_max_threads(i ? TEST_THREADS : 1);
+    zdnn_status status =
+        saturation ? zdnn_transform_ztensor_with_saturation(&ztensor[i], data)
+                   : zdnn_transform_ztensor(&ztensor[i], data);
+    TEST_ASSERT_MESSAGE_FORMATTED(
+        status == exp_status,
+        "transform with %u thread(s) returned %08x (%s), expected %08x (%s)",
+        zdnn_get_max_threads(), status, zdnn_get_status_message(status),
+        exp_status, zdnn_get_status_message(exp_status));
+  }
+
+  if (exp_status == ZDNN_OK || exp_status == ZDNN_ELEMENT_RANGE_VIOLATION) {
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(
+        ztensor[0].buffer, ztensor[1].buffer, ztensor[0].buffer_size,
+        "multi-threaded stickify differs from single-threaded");
+  }
+
+  zdnn_free_ztensor_buffer(&ztensor[0]);
+  zdnn_free_ztensor_buffer(&ztensor[1]);
+  free(data);
+  free(values);
+}
+
+// dim2 isn't a multiple of AIU_STICKS_PER_PAGE and dim1 spans 2 sticks, so
+// every row has stick padding and a partial stick
+void test_nhwc() {
+  uint32_t shape[] = {3, 41, 37, 70};
+  test_parallel_stickify(shape, ZDNN_NHWC, test_datatype, false, -1, ZDNN_OK);
+}
+
+void test_nchw() {
+  uint32_t shape[] = {3, 70, 41, 37};
+  test_parallel_stickify(shape, ZDNN_NCHW, test_datatype, false, -1, ZDNN_OK);
+}
+
+// W is converted a stick's worth at a time, so take it past two of them with
+// a partial last one
+void test_nchw_wide() {
+  uint32_t shape[] = {2, 70, 5, 150};
+  test_parallel_stickify(shape, ZDNN_NCHW, test_datatype, false, -1, ZDNN_OK);
+}
+
+void test_hwck() {
+  uint32_t shape[] = {5, 7, 67, 130};
+  test_parallel_stickify(shape, ZDNN_HWCK, test_datatype, false, -1, ZDNN_OK);
+}
+
+// an infinity near the end is raised by a worker thread, it must still fail
+// the whole transform
+void test_nchw_inf() {
+  uint32_t shape[] = {3, 70, 41, 37};
+  test_parallel_stickify(shape, ZDNN_NCHW, FP32, false,
+                         (int64_t)shape[0] * shape[1] * shape[2] * shape[3] -
+                             5,
+                         ZDNN_CONVERT_FAILURE);
+}
+
+void test_nchw_inf_saturation() {
+  uint32_t shape[] = {3, 70, 41, 37};
+  test_parallel_stickify(shape, ZDNN_NCHW, FP32, true,
+                         (int64_t)shape[0] * shape[1] * shape[2] * shape[3] -
+                             5,
+                         ZDNN_ELEMENT_RANGE_VIOLATION);
+}
+
+/// Unstickify the same ztensor single-threaded, with TEST_THREADS threads and
+/// with TEST_THREADS threads using streaming stores, all the results must be
+/// identical.
+///
+/// \param[in] shape pre-transformed shape, 4 dimensions
+/// \param[in] layout pre-transformed layout
+/// \param[in] type pre-transformed data type
+///
+void test_parallel_unstickify(uint32_t *shape, zdnn_data_layouts layout,
+                              zdnn_data_types type) {
+  uint64_t num_elements = (uint64_t)shape[0] * shape[1] * shape[2] * shape[3];
+
+  float *values = malloc(num_elements * sizeof(float));
+  gen_random_float_array(num_elements, values);
+
+  zdnn_set_max_threads(1);
+  zdnn_ztensor *ztensor = alloc_ztensor_with_values(
+      shape, layout, type, NO_CONCAT, false, values);
+
+  uint64_t out_size = num_elements * get_data_type_size(type);
+  void *out[3];
+
+  for (int i = 0; i < 3; i++) {
+    // odd offset so streaming stores start and end misaligned
+    out[i] = malloc(out_size + 1);
+    memset(out[i], 0, out_size + 1);
+
+    zdnn_set_max_threads(i ? TEST_THREADS : 1);
+    streaming_stores_enabled = (i == 2);
+    zdnn_status status =
+        zdnn_transform_origtensor(ztensor, (void *)((uintptr_t)out[i] + 1));
+    TEST_ASSERT_MESSAGE_FORMATTED(
+        status == ZDNN_OK, "unstickify %d returned %08x (%s)", i, status,
+        zdnn_get_status_message(status));
+  }
+
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(
+      out[0], out[1], out_size + 1,
+      "multi-threaded unstickify differs from single-threaded");
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(
+      out[0], out[2], out_size + 1,
+      "streaming unstickify differs from single-threaded");
+
+  for (int i = 0; i < 3; i++) {
+    free(out[i]);
+  }
+  free_ztensor_buffers(1, ztensor);
+  free(values);
+}
+
+void test_unstickify_nhwc() {
+  uint32_t shape[] = {3, 41, 37, 70};
+  test_parallel_unstickify(shape, ZDNN_NHWC, test_datatype);
+}
+
+void test_unstickify_nchw() {
+  uint32_t shape[] = {3, 70, 41, 37};
+  test_parallel_unstickify(shape, ZDNN_NCHW, test_datatype);
+}
+
+void test_unstickify_nhwc_dim1_1() {
+  uint32_t shape[] = {3, 97, 1021, 1};
+  test_parallel_unstickify(shape, ZDNN_NHWC, test_datatype);
+}
+
+void test_unstickify_nhwc_dim1_2() {
+  uint32_t shape[] = {3, 97, 1021, 2};
+  test_parallel_unstickify(shape, ZDNN_NHWC, test_datatype);
+}
+
+// a child of fork() inherits none of the pool's workers, its transforms must
+// still run rather than wait for them
+void test_fork() {
+  uint32_t shape[] = {3, 41, 37, 70};
+  uint64_t num_elements = (uint64_t)shape[0] * shape[1] * shape[2] * shape[3];
+
+  float *values = malloc(num_elements * sizeof(float));
+  gen_random_float_array(num_elements, values);
+
+  zdnn_set_max_threads(TEST_THREADS);
+  zdnn_ztensor *ztensor = alloc_ztensor_with_values(
+      shape, ZDNN_NHWC, FP32, NO_CONCAT, false, values);
+
+  uint64_t out_size = num_elements * sizeof(float);
+  float *exp_out = malloc(out_size);
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_origtensor(ztensor, exp_out));
+
+  pid_t pid = fork();
+  TEST_ASSERT_MESSAGE(pid >= 0, "fork() failed");
+  if (!pid) {
+    // a hang kills the child instead of the test
+    alarm(60);
+    float *out = malloc(out_size);
+    zdnn_status status = zdnn_transform_origtensor(ztensor, out);
+    _exit(status == ZDNN_OK && !memcmp(out, exp_out, out_size) ? 0 : 1);
+  }
+
+  int wstatus;
+  TEST_ASSERT_EQUAL(pid, waitpid(pid, &wstatus, 0));
+  TEST_ASSERT_MESSAGE(WIFEXITED(wstatus) && !WEXITSTATUS(wstatus),
+                      "unstickify in the child of fork() failed");
+
+  // the parent's pool still works
+  float *out = malloc(out_size);
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_origtensor(ztensor, out));
+  TEST_ASSERT_EQUAL_MEMORY(exp_out, out, out_size);
+
+  free(exp_out);
+  free(out);
+  free_ztensor_buffers(1, ztensor);
+  free(values);
+}
+
+void test_max_threads() {
+  zdnn_set_max_threads(3);
+  TEST_ASSERT_EQUAL_UINT32(3, zdnn_get_max_threads());
+
+  zdnn_set_max_threads(1);
+  TEST_ASSERT_EQUAL_UINT32(1, zdnn_get_max_threads());
+
+  // default is the number of online processors
+  zdnn_set_max_threads(0);
+  TEST_ASSERT_TRUE(zdnn_get_max_threads() >= 1);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_max_threads);
+
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_nhwc);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_nchw);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_nchw_wide);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_hwck);
+
+  RUN_TEST(test_nchw_inf);
+  RUN_TEST(test_nchw_inf_saturation);
+
+  RUN_TEST(test_fork);
+
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_unstickify_nhwc);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_unstickify_nchw);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_unstickify_nhwc_dim1_1);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_unstickify_nhwc_dim1_2);
+
+  return UNITY_END();
+}
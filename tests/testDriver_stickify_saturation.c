@@ -71,21 +71,11 @@ float fp32_saturation_value(float value) {
 
 uint16_t bfloat_saturation_value(uint16_t value) {
 
-  typedef struct float_as_uint16s {
-    uint16_t left;
-    uint16_t right;
-  } float_as_uint16s;
-
-  union {
-    float f;
-    float_as_uint16s fau;
-  } tmp;
-
-  tmp.fau.left = value;
-  tmp.fau.right = 0;
-  if (tmp.f > DLF16_MAX_AS_FP32) {
+  float tmp = cnvt_1_bfloat_to_fp32(value);
+
+  if (tmp > DLF16_MAX_AS_FP32) {
     return DLF16_MAX_AS_BFLOAT;
-  } else if (tmp.f < DLF16_MIN_AS_FP32) {
+  } else if (tmp < DLF16_MIN_AS_FP32) {
     return DLF16_MIN_AS_BFLOAT;
   } else {
     return value;
@@ -57,21 +57,53 @@ void verify_dims() {
   set_and_verify_transformed_descriptor(
       at_limit, ZDNN_NHWC, test_datatype, ZDNN_FORMAT_4DFEATURE, ZDNN_OK,
       "Not returning ZDNN_OK for at dims limit tensor");
+  // only DLFLOAT16 feature tensors may go past the limits, see
+  // verify_dims_past_limit()
   set_and_verify_transformed_descriptor(
-      limit_plus1, ZDNN_NHWC, test_datatype, ZDNN_FORMAT_4DFEATURE,
+      limit_plus1, ZDNN_NHWC, ZDNN_BINARY_INT32, ZDNN_FORMAT_4DFEATURE,
       ZDNN_INVALID_SHAPE,
       "Not returning ZDNN_INVALID_SHAPE for above dims limit tensor");
 }
 
+// operations given DLFLOAT16 feature tensors past the limits split them into
+// tiles or chunks, or return ZDNN_EXCEEDS_MDIS.  So do convolutions given a
+// kernel with more output channels (dim1) than the limit.
+void verify_dims_past_limit() {
+
+  uint32_t dim3_limit_plus1[ZDNN_MAX_DIMS] = {1, zdnn_get_max_for_dim(3) + 1, 1,
+                                              1};
+  uint32_t dim2_limit_plus1[ZDNN_MAX_DIMS] = {1, 1, zdnn_get_max_for_dim(2) + 1,
+                                              1};
+  uint32_t dim1_limit_plus1[ZDNN_MAX_DIMS] = {1, 1, 1,
+                                              zdnn_get_max_for_dim(1) + 1};
+
+  set_and_verify_transformed_descriptor(
+      dim3_limit_plus1, ZDNN_NHWC, test_datatype, ZDNN_FORMAT_4DFEATURE,
+      ZDNN_OK, "Not returning ZDNN_OK for above dim3 limit feature tensor");
+  set_and_verify_transformed_descriptor(
+      dim2_limit_plus1, ZDNN_NHWC, test_datatype, ZDNN_FORMAT_4DFEATURE,
+      ZDNN_OK, "Not returning ZDNN_OK for above dim2 limit feature tensor");
+  set_and_verify_transformed_descriptor(
+      dim1_limit_plus1, ZDNN_HWCK, test_datatype, ZDNN_FORMAT_4DKERNEL,
+      ZDNN_OK, "Not returning ZDNN_OK for above dim1 limit kernel tensor");
+  set_and_verify_transformed_descriptor(
+      dim3_limit_plus1, ZDNN_HWCK, test_datatype, ZDNN_FORMAT_4DKERNEL,
+      ZDNN_INVALID_SHAPE,
+      "Not returning ZDNN_INVALID_SHAPE for above dim3 limit kernel tensor");
+}
+
+// (1, dim3, max_dim_size, max_dim_size) with dim3 chosen so the tensor sits
+// right at the MAX TENSOR SIZE limit
+static uint32_t get_max_tensor_size_dim3(uint32_t max_dim_size) {
+  return zdnn_get_nnpa_max_tensor_size() /
+         (max_dim_size / AIU_STICKS_PER_PAGE) /
+         (max_dim_size / AIU_2BYTE_CELLS_PER_STICK) / AIU_PAGESIZE_IN_BYTES;
+}
+
 void verify_max_tensor_size() {
 
   uint32_t max_dim_size = zdnn_get_nnpa_max_dim_idx_size();
-
-  // try to come up with dim3 so that (1, dim3, max_dim_size, max_dim_size)
-  // would sit right at the MAX TENSOR SIZE limit
-  uint32_t dim3 =
-      zdnn_get_nnpa_max_tensor_size() / (max_dim_size / AIU_STICKS_PER_PAGE) /
-      (max_dim_size / AIU_2BYTE_CELLS_PER_STICK) / AIU_PAGESIZE_IN_BYTES;
+  uint32_t dim3 = get_max_tensor_size_dim3(max_dim_size);
 
   unsigned int limit_minus1[ZDNN_MAX_DIMS] = {1, dim3, max_dim_size - 1,
                                               max_dim_size};
@@ -85,12 +117,33 @@ void verify_max_tensor_size() {
   set_and_verify_transformed_descriptor(
       at_limit, ZDNN_NHWC, test_datatype, ZDNN_FORMAT_4DFEATURE, ZDNN_OK,
       "Not returning ZDNN_OK for at tensor size limit tensor");
+  // only DLFLOAT16 feature and kernel tensors may go past the limit, see
+  // verify_max_tensor_size_past_limit()
   set_and_verify_transformed_descriptor(
-      limit_plus1, ZDNN_NHWC, test_datatype, ZDNN_FORMAT_4DFEATURE,
+      limit_plus1, ZDNN_NHWC, ZDNN_BINARY_INT32, ZDNN_FORMAT_4DFEATURE,
       ZDNN_INVALID_SHAPE,
       "Not returning ZDNN_INVALID_SHAPE for above tensor size limit tensor");
 }
 
+void verify_max_tensor_size_past_limit() {
+
+  uint32_t max_dim_size = zdnn_get_nnpa_max_dim_idx_size();
+  uint32_t dim3 = get_max_tensor_size_dim3(max_dim_size);
+
+  unsigned int limit_plus1[ZDNN_MAX_DIMS] = {1, dim3, max_dim_size + 1,
+                                             max_dim_size};
+  unsigned int kernel_limit_plus1[ZDNN_MAX_DIMS] = {
+      1, dim3, max_dim_size, max_dim_size + AIU_2BYTE_CELLS_PER_STICK};
+
+  set_and_verify_transformed_descriptor(
+      limit_plus1, ZDNN_NHWC, test_datatype, ZDNN_FORMAT_4DFEATURE, ZDNN_OK,
+      "Not returning ZDNN_OK for above tensor size limit feature tensor");
+  set_and_verify_transformed_descriptor(
+      kernel_limit_plus1, ZDNN_HWCK, test_datatype, ZDNN_FORMAT_4DKERNEL,
+      ZDNN_OK,
+      "Not returning ZDNN_OK for above tensor size limit kernel tensor");
+}
+
 void verify_datatype_tranformed() {
   uint32_t dims[ZDNN_MAX_DIMS] = {1, 1, 1, 1};
 
@@ -504,7 +557,9 @@ int main(void) {
   UNITY_BEGIN();
 
   RUN_TEST_ALL_DLFLOAT16_TFRMD_DATATYPES(verify_dims);
+  RUN_TEST_ALL_DLFLOAT16_TFRMD_DATATYPES(verify_dims_past_limit);
   RUN_TEST_ALL_DLFLOAT16_TFRMD_DATATYPES(verify_max_tensor_size);
+  RUN_TEST_ALL_DLFLOAT16_TFRMD_DATATYPES(verify_max_tensor_size_past_limit);
 
   // test all data-types possible
   RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(verify_datatype_tranformed);
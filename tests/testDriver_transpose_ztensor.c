@@ -0,0 +1,200 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testsupport.h"
+
+void setUp(void) { VERIFY_HW_ENV; }
+
+void tearDown(void) {}
+
+/*
+ * Transform random values into an NHWC input, transpose it into an NHWC
+ * output and compare every cell of the output with the input cell it comes
+ * from, which must be bit for bit the same.  Padding cells after the last C
+ * of every output stick must be zero.
+ */
+void test_perm(uint32_t dim4, uint32_t dim3, uint32_t dim2, uint32_t dim1,
+               uint8_t p0, uint8_t p1, uint8_t p2, uint8_t p3) {
+  uint8_t perm[] = {p0, p1, p2, p3};
+  uint32_t in_dims[] = {dim4, dim3, dim2, dim1};
+  uint32_t out_dims[] = {in_dims[p0], in_dims[p1], in_dims[p2], in_dims[p3]};
+
+  zdnn_tensor_desc in_pre, in_tfrmd, out_pre, out_tfrmd;
+  zdnn_ztensor input, output;
+
+  zdnn_init_pre_transformed_desc(ZDNN_NHWC, FP32, &in_pre, dim4, dim3, dim2,
+                                 dim1);
+  zdnn_init_pre_transformed_desc(ZDNN_NHWC, FP32, &out_pre, out_dims[0],
+                                 out_dims[1], out_dims[2], out_dims[3]);
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_generate_transformed_desc(&in_pre, &in_tfrmd));
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_generate_transformed_desc(&out_pre, &out_tfrmd));
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_init_ztensor_with_malloc(&in_pre, &in_tfrmd, &input));
+  TEST_ASSERT_EQUAL(
+      ZDNN_OK, zdnn_init_ztensor_with_malloc(&out_pre, &out_tfrmd, &output));
+
+  // fill the output with garbage so unwritten cells show up
+  memset(output.buffer, 0xff, output.buffer_size);
+
+  void *values = create_and_fill_random_fp_data(&input);
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_ztensor(&input, values));
+
+  zdnn_status status = zdnn_transpose_ztensor(&input, perm, &output);
+  TEST_ASSERT_MESSAGE_FORMATTED(
+      status == ZDNN_OK,
+      "zdnn_transpose_ztensor() (%u, %u, %u, %u) failed, status = %08x", p0,
+      p1, p2, p3, status);
+  TEST_ASSERT_TRUE(output.is_transformed);
+
+  uint32_t o[4], x[4];
+  uint32_t padded_dim1 = CEIL(out_dims[3], AIU_2BYTE_CELLS_PER_STICK) *
+                         AIU_2BYTE_CELLS_PER_STICK;
+  for (o[0] = 0; o[0] < out_dims[0]; o[0]++) {
+    for (o[1] = 0; o[1] < out_dims[1]; o[1]++) {
+      for (o[2] = 0; o[2] < out_dims[2]; o[2]++) {
+        for (o[3] = 0; o[3] < padded_dim1; o[3]++) {
+          uint16_t out_val = *(uint16_t *)((char *)output.buffer +
+                                           get_stick_offset(o[0], o[1], o[2],
+                                                            o[3], &out_tfrmd));
+          uint16_t exp_val = 0;
+          if (o[3] < out_dims[3]) {
+            for (int k = 0; k < 4; k++) {
+              x[perm[k]] = o[k];
+            }
+            exp_val = *(uint16_t *)((char *)input.buffer +
+                                    get_stick_offset(x[0], x[1], x[2], x[3],
+                                                     &in_tfrmd));
+          }
+          TEST_ASSERT_MESSAGE_FORMATTED(
+              out_val == exp_val,
+              "perm (%u, %u, %u, %u) output (%u, %u, %u, %u) is 0x%04x, "
+              "expected 0x%04x",
+              p0, p1, p2, p3, o[0], o[1], o[2], o[3], out_val, exp_val);
+        }
+      }
+    }
+  }
+
+  free(values);
+  zdnn_free_ztensor_buffer(&input);
+  zdnn_free_ztensor_buffer(&output);
+}
+
+void test_identity() { test_perm(2, 3, 5, 70, 0, 1, 2, 3); }
+
+// dim1 stays dim1, whole sticks are copied
+void test_swap_h_w() { test_perm(2, 3, 40, 70, 0, 2, 1, 3); }
+void test_swap_n_h() { test_perm(3, 2, 5, 130, 1, 0, 2, 3); }
+
+// NHWC to NCHW order and back
+void test_nhwc_to_nchw() { test_perm(2, 3, 5, 70, 0, 3, 1, 2); }
+void test_nchw_to_nhwc() { test_perm(2, 70, 3, 5, 0, 2, 3, 1); }
+
+// matrix transpose of every (n, h), over many tiles both ways
+void test_swap_w_c() { test_perm(1, 2, 150, 130, 0, 1, 3, 2); }
+void test_swap_w_c_small() { test_perm(2, 1, 3, 5, 0, 1, 3, 2); }
+
+void test_swap_n_c() { test_perm(70, 2, 3, 4, 3, 1, 2, 0); }
+void test_reverse() { test_perm(3, 4, 65, 66, 3, 2, 1, 0); }
+
+void test_not_permutation() {
+  uint32_t shape[] = {1, 2, 3, 4};
+  zdnn_ztensor *input = alloc_ztensor_with_values(shape, ZDNN_NHWC, FP32,
+                                                  NO_CONCAT, true, ZERO_ARRAY);
+  zdnn_ztensor *output =
+      alloc_output_ztensor(shape, ZDNN_NHWC, FP32, NO_CONCAT);
+
+  uint8_t dup[] = {0, 1, 1, 3};
+  uint8_t big[] = {0, 1, 2, 4};
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_SHAPE,
+                    zdnn_transpose_ztensor(input, dup, output));
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_SHAPE,
+                    zdnn_transpose_ztensor(input, big, output));
+
+  free_ztensor_buffers(2, input, output);
+}
+
+void test_wrong_output_shape() {
+  uint32_t in_shape[] = {1, 2, 3, 4};
+  uint32_t out_shape[] = {1, 4, 3, 2};
+  zdnn_ztensor *input = alloc_ztensor_with_values(in_shape, ZDNN_NHWC, FP32,
+                                                  NO_CONCAT, true, ZERO_ARRAY);
+  zdnn_ztensor *output =
+      alloc_output_ztensor(out_shape, ZDNN_NHWC, FP32, NO_CONCAT);
+
+  uint8_t perm[] = {0, 3, 1, 2};
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_SHAPE,
+                    zdnn_transpose_ztensor(input, perm, output));
+
+  free_ztensor_buffers(2, input, output);
+}
+
+void test_not_transformed() {
+  uint32_t shape[] = {1, 2, 3, 4};
+  zdnn_ztensor *input =
+      alloc_output_ztensor(shape, ZDNN_NHWC, FP32, NO_CONCAT);
+  zdnn_ztensor *output =
+      alloc_output_ztensor(shape, ZDNN_NHWC, FP32, NO_CONCAT);
+
+  uint8_t perm[] = {0, 1, 2, 3};
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE,
+                    zdnn_transpose_ztensor(input, perm, output));
+
+  free_ztensor_buffers(2, input, output);
+}
+
+void test_wrong_type() {
+  uint32_t shape[] = {1, 2, 3, 4};
+  zdnn_ztensor *input = alloc_ztensor_with_values(shape, ZDNN_NHWC, FP32,
+                                                  NO_CONCAT, true, ZERO_ARRAY);
+  zdnn_ztensor *output =
+      alloc_output_ztensor(shape, ZDNN_NHWC, FP32, NO_CONCAT);
+  output->transformed_desc->type = ZDNN_BINARY_INT8;
+
+  uint8_t perm[] = {0, 1, 2, 3};
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_TYPE,
+                    zdnn_transpose_ztensor(input, perm, output));
+
+  output->transformed_desc->type = ZDNN_DLFLOAT16;
+  free_ztensor_buffers(2, input, output);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_identity);
+  RUN_TEST(test_swap_h_w);
+  RUN_TEST(test_swap_n_h);
+  RUN_TEST(test_nhwc_to_nchw);
+  RUN_TEST(test_nchw_to_nhwc);
+  RUN_TEST(test_swap_w_c);
+  RUN_TEST(test_swap_w_c_small);
+  RUN_TEST(test_swap_n_c);
+  RUN_TEST(test_reverse);
+  RUN_TEST(test_not_permutation);
+  RUN_TEST(test_wrong_output_shape);
+  RUN_TEST(test_not_transformed);
+  RUN_TEST(test_wrong_type);
+
+  return UNITY_END();
+}
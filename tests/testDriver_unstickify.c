@@ -135,7 +135,7 @@ void test_unstickify(uint32_t dim4, uint32_t dim3, uint32_t dim2, uint32_t dim1,
       // ztensor.buffer is void*
       // stickified_input_value is uint16_t
       *(uint16_t *)((uintptr_t)(ztensor.buffer) + offsets[i]) =
-          stickified_input_value;
+          STICK_CELL16(stickified_input_value);
     }
     free(offsets);
     // hack, since we never actually stickified anything
@@ -552,7 +552,7 @@ void test_ztensor_bad_value_FP16(uint16_t bad_value) {
   array = (uint16_t *)ztensor.buffer; /* use stickified_data as an array */
 
   for (int i = 0; i < STICK_ENTRIES_FP16; i++) {
-    array[stick_entries_to_try[i]] = bad_value;
+    array[stick_entries_to_try[i]] = STICK_CELL16(bad_value);
     status = zdnn_transform_origtensor(&ztensor, unstickified_data);
 
     TEST_ASSERT_MESSAGE_FORMATTED(
@@ -647,7 +647,7 @@ void test_ztensor_bad_value_FP32(uint16_t bad_value) {
   }
 
   for (int i = 0; i < STICK_ENTRIES_FP32; i++) {
-    array[stick_entries_to_try[i]] = bad_value;
+    array[stick_entries_to_try[i]] = STICK_CELL16(bad_value);
 
     status = zdnn_transform_origtensor(&ztensor, unstickified_data);
     TEST_ASSERT_MESSAGE_FORMATTED(
@@ -5828,8 +5828,9 @@ void test_f001_fail() {
                       "zdnn_conv2d(): status not ZDNN_FUNC_RC_F001");
 }
 
-// both strides = 0, kernel height > 448
-void test_f002_height_fail() {
+// both strides = 0, kernel height > 448, split into kernels the zAIU
+// convolves instead of failing with ZDNN_FUNC_RC_F002
+void test_f002_height_tiled() {
   input_set i = {1, 1, 1, 1, {512, 1}, 1};
   input_set *set = &i; // just so we can copy and paste code
 
@@ -5847,11 +5848,14 @@ void test_f002_height_fail() {
   uint32_t bias_dims[1] = {set->channel_out};
   uint32_t output_dims[4] = {set->n, 1, 1, set->channel_out};
 
+  // all ones, so every output is the number of elements in the kernel
+  float one[] = {1};
+
   zdnn_ztensor *input_ztensor = alloc_ztensor_with_values(
-      input_dims, ZDNN_NHWC, test_datatype, NO_CONCAT, true, ZERO_ARRAY);
+      input_dims, ZDNN_NHWC, test_datatype, NO_CONCAT, true, one);
 
   zdnn_ztensor *kernel_ztensor = alloc_ztensor_with_values(
-      kernel_dims, ZDNN_HWCK, test_datatype, NO_CONCAT, true, ZERO_ARRAY);
+      kernel_dims, ZDNN_HWCK, test_datatype, NO_CONCAT, true, one);
 
   zdnn_ztensor *bias_ztensor = alloc_ztensor_with_values(
       bias_dims, ZDNN_1D, test_datatype, NO_CONCAT, true, ZERO_ARRAY);
@@ -5863,12 +5867,19 @@ void test_f002_height_fail() {
                        strides->height, strides->width, CONV2D_ACT_NONE, NULL,
                        output_ztensor);
 
-  TEST_ASSERT_MESSAGE(status == ZDNN_FUNC_RC_F002,
-                      "zdnn_conv2d(): status not ZDNN_FUNC_RC_F002");
+  TEST_ASSERT_MESSAGE(status == ZDNN_OK, "zdnn_conv2d(): status not ZDNN_OK");
+  TEST_ASSERT_TRUE(output_ztensor->is_transformed);
+
+  float exp_value[] = {set->kernel_size[0] * set->kernel_size[1]};
+  assert_ztensor_values(output_ztensor, true, exp_value);
+
+  free_ztensor_buffers(4, input_ztensor, kernel_ztensor, bias_ztensor,
+                       output_ztensor);
 }
 
-// both strides = 0, kernel width > 448
-void test_f002_width_fail() {
+// both strides = 0, kernel width > 448, split into kernels the zAIU
+// convolves instead of failing with ZDNN_FUNC_RC_F002
+void test_f002_width_tiled() {
   input_set i = {1, 1, 1, 1, {1, 512}, 1};
   input_set *set = &i; // just so we can copy and paste code
 
@@ -5886,11 +5897,14 @@ void test_f002_width_fail() {
   uint32_t bias_dims[1] = {set->channel_out};
   uint32_t output_dims[4] = {set->n, 1, 1, set->channel_out};
 
+  // all ones, so every output is the number of elements in the kernel
+  float one[] = {1};
+
   zdnn_ztensor *input_ztensor = alloc_ztensor_with_values(
-      input_dims, ZDNN_NHWC, test_datatype, NO_CONCAT, true, ZERO_ARRAY);
+      input_dims, ZDNN_NHWC, test_datatype, NO_CONCAT, true, one);
 
   zdnn_ztensor *kernel_ztensor = alloc_ztensor_with_values(
-      kernel_dims, ZDNN_HWCK, test_datatype, NO_CONCAT, true, ZERO_ARRAY);
+      kernel_dims, ZDNN_HWCK, test_datatype, NO_CONCAT, true, one);
 
   zdnn_ztensor *bias_ztensor = alloc_ztensor_with_values(
       bias_dims, ZDNN_1D, test_datatype, NO_CONCAT, true, ZERO_ARRAY);
@@ -5902,12 +5916,19 @@ void test_f002_width_fail() {
                        strides->height, strides->width, CONV2D_ACT_NONE, NULL,
                        output_ztensor);
 
-  TEST_ASSERT_MESSAGE(status == ZDNN_FUNC_RC_F002,
-                      "zdnn_conv2d(): status not ZDNN_FUNC_RC_F002");
+  TEST_ASSERT_MESSAGE(status == ZDNN_OK, "zdnn_conv2d(): status not ZDNN_OK");
+  TEST_ASSERT_TRUE(output_ztensor->is_transformed);
+
+  float exp_value[] = {set->kernel_size[0] * set->kernel_size[1]};
+  assert_ztensor_values(output_ztensor, true, exp_value);
+
+  free_ztensor_buffers(4, input_ztensor, kernel_ztensor, bias_ztensor,
+                       output_ztensor);
 }
 
-// both strides > 0, kernel height > 64
-void test_f003_height_fail() {
+// both strides > 0, kernel height > 64, split into kernels the zAIU
+// convolves instead of failing with ZDNN_FUNC_RC_F003
+void test_f003_height_tiled() {
   uint32_t bad_height = 70; // output height becomes 11
 
   // height_in must > kernel_height
@@ -5928,11 +5949,14 @@ void test_f003_height_fail() {
   uint32_t bias_dims[1] = {set->channel_out};
   uint32_t output_dims[4] = {set->n, 11, 1, set->channel_out}; //
 
+  // all ones, so every output is the number of elements in the kernel
+  float one[] = {1};
+
   zdnn_ztensor *input_ztensor = alloc_ztensor_with_values(
-      input_dims, ZDNN_NHWC, test_datatype, NO_CONCAT, true, ZERO_ARRAY);
+      input_dims, ZDNN_NHWC, test_datatype, NO_CONCAT, true, one);
 
   zdnn_ztensor *kernel_ztensor = alloc_ztensor_with_values(
-      kernel_dims, ZDNN_HWCK, test_datatype, NO_CONCAT, true, ZERO_ARRAY);
+      kernel_dims, ZDNN_HWCK, test_datatype, NO_CONCAT, true, one);
 
   zdnn_ztensor *bias_ztensor = alloc_ztensor_with_values(
       bias_dims, ZDNN_1D, test_datatype, NO_CONCAT, true, ZERO_ARRAY);
@@ -5944,12 +5968,19 @@ void test_f003_height_fail() {
                        strides->height, strides->width, CONV2D_ACT_NONE, NULL,
                        output_ztensor);
 
-  TEST_ASSERT_MESSAGE(status == ZDNN_FUNC_RC_F003,
-                      "zdnn_conv2d(): status not ZDNN_FUNC_RC_F003");
+  TEST_ASSERT_MESSAGE(status == ZDNN_OK, "zdnn_conv2d(): status not ZDNN_OK");
+  TEST_ASSERT_TRUE(output_ztensor->is_transformed);
+
+  float exp_value[] = {set->kernel_size[0] * set->kernel_size[1]};
+  assert_ztensor_values(output_ztensor, true, exp_value);
+
+  free_ztensor_buffers(4, input_ztensor, kernel_ztensor, bias_ztensor,
+                       output_ztensor);
 }
 
-// both strides > 0, kernel width > 64
-void test_f003_width_fail() {
+// both strides > 0, kernel width > 64, split into kernels the zAIU
+// convolves instead of failing with ZDNN_FUNC_RC_F003
+void test_f003_width_tiled() {
   uint32_t bad_width = 70; // output width becomes 11
 
   // width_in must > kernel_width
@@ -5970,11 +6001,14 @@ void test_f003_width_fail() {
   uint32_t bias_dims[1] = {set->channel_out};
   uint32_t output_dims[4] = {set->n, 1, 11, set->channel_out};
 
+  // all ones, so every output is the number of elements in the kernel
+  float one[] = {1};
+
   zdnn_ztensor *input_ztensor = alloc_ztensor_with_values(
-      input_dims, ZDNN_NHWC, test_datatype, NO_CONCAT, true, ZERO_ARRAY);
+      input_dims, ZDNN_NHWC, test_datatype, NO_CONCAT, true, one);
 
   zdnn_ztensor *kernel_ztensor = alloc_ztensor_with_values(
-      kernel_dims, ZDNN_HWCK, test_datatype, NO_CONCAT, true, ZERO_ARRAY);
+      kernel_dims, ZDNN_HWCK, test_datatype, NO_CONCAT, true, one);
 
   zdnn_ztensor *bias_ztensor = alloc_ztensor_with_values(
       bias_dims, ZDNN_1D, test_datatype, NO_CONCAT, true, ZERO_ARRAY);
@@ -5986,8 +6020,14 @@ void test_f003_width_fail() {
                        strides->height, strides->width, CONV2D_ACT_NONE, NULL,
                        output_ztensor);
 
-  TEST_ASSERT_MESSAGE(status == ZDNN_FUNC_RC_F003,
-                      "zdnn_conv2d(): status not ZDNN_FUNC_RC_F003");
+  TEST_ASSERT_MESSAGE(status == ZDNN_OK, "zdnn_conv2d(): status not ZDNN_OK");
+  TEST_ASSERT_TRUE(output_ztensor->is_transformed);
+
+  float exp_value[] = {set->kernel_size[0] * set->kernel_size[1]};
+  assert_ztensor_values(output_ztensor, true, exp_value);
+
+  free_ztensor_buffers(4, input_ztensor, kernel_ztensor, bias_ztensor,
+                       output_ztensor);
 }
 
 // stride height > 13
@@ -6098,10 +6138,10 @@ int main() {
 
   RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_f000_fail);
   RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_f001_fail);
-  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_f002_height_fail);
-  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_f002_width_fail);
-  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_f003_height_fail);
-  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_f003_width_fail);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_f002_height_tiled);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_f002_width_tiled);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_f003_height_tiled);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_f003_width_tiled);
   RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_f004_stride_height_fail);
   RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(test_f004_stride_width_fail);
   return UNITY_END();
@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testsupport.h"
+
+void setUp(void) {
+  VERIFY_HW_ENV;
+
+  save_nnpa_limits();
+}
+
+void tearDown(void) { restore_nnpa_limits(); }
+
+/*
+ * Run a convolution of (n, h, w, c) by (kh, kw, c, k) with the kernel dilated
+ * by (dh, dw), and check it against a dilated convolution computed here.
+ */
+static void test_dilated(uint32_t n, uint32_t h, uint32_t w, uint32_t c,
+                         uint32_t kh, uint32_t kw, uint32_t k,
+                         zdnn_pool_padding padding, uint32_t sh, uint32_t sw,
+                         uint32_t dh, uint32_t dw, zdnn_conv2d_act act,
+                         float clip, uint32_t max_dim_idx_size) {
+  conv2d_ref ref = {
+      .n = n,
+      .h = h,
+      .w = w,
+      .c = c,
+      .kh = kh,
+      .kw = kw,
+      .k = k,
+      .groups = 1,
+      .padding = padding,
+      .stride_h = sh,
+      .stride_w = sw,
+      .dilation_h = dh,
+      .dilation_w = dw,
+      .act = act,
+      .clip = clip,
+  };
+  conv2d_ref_dims(&ref);
+  uint32_t oh = ref.oh, ow = ref.ow;
+
+  uint32_t input_shape[] = {n, h, w, c};
+  uint32_t kernel_shape[] = {kh, kw, c, k};
+  uint32_t bias_shape[] = {k};
+  uint32_t output_shape[] = {n, oh, ow, k};
+
+  float *input_values = alloc_random_dlf16_values((uint64_t)n * h * w * c);
+  float *kernel_values = alloc_random_dlf16_values((uint64_t)kh * kw * c * k);
+  float *bias_values = alloc_random_dlf16_values(k);
+  float *expected = malloc((uint64_t)n * oh * ow * k * sizeof(float));
+
+  zdnn_ztensor *input = alloc_ztensor_with_values(
+      input_shape, ZDNN_NHWC, FP32, NO_CONCAT, false, input_values);
+  zdnn_ztensor *kernel = alloc_ztensor_with_values(
+      kernel_shape, ZDNN_HWCK, FP32, NO_CONCAT, false, kernel_values);
+  zdnn_ztensor *bias = alloc_ztensor_with_values(bias_shape, ZDNN_1D, FP32,
+                                                 NO_CONCAT, false, bias_values);
+  zdnn_ztensor *output =
+      alloc_output_ztensor(output_shape, ZDNN_NHWC, FP32, NO_CONCAT);
+
+  lower_nnpa_limits(0, max_dim_idx_size, 0);
+  zdnn_status status = zdnn_conv2d_dilated(input, kernel, bias, padding, sh,
+                                           sw, dh, dw, act, &clip, output);
+  restore_nnpa_limits();
+
+  TEST_ASSERT_MESSAGE_FORMATTED(
+      status == ZDNN_OK,
+      "conv2d (%u, %u, %u, %u) by (%u, %u, %u, %u) dilated by (%u, %u) "
+      "returned %08x",
+      n, h, w, c, kh, kw, c, k, dh, dw, status);
+  TEST_ASSERT_TRUE(output->is_transformed);
+
+  compute_conv2d_ref(&ref, input_values, kernel_values, bias_values, expected);
+  assert_conv2d_output(output, expected);
+
+  free(input_values);
+  free(kernel_values);
+  free(bias_values);
+  free(expected);
+  free_ztensor_buffers(4, input, kernel, bias, output);
+}
+
+/// Check that a dilated convolution of (1, 8, 8, 4) by (3, 3, 4, 4) into an
+/// output of (1, oh, ow, 4) is rejected
+static void test_dilated_invalid(uint32_t oh, uint32_t ow, uint32_t sh,
+                                 uint32_t sw, uint32_t dh, uint32_t dw,
+                                 zdnn_status exp_status) {
+  uint32_t input_shape[] = {1, 8, 8, 4};
+  uint32_t kernel_shape[] = {3, 3, 4, 4};
+  uint32_t bias_shape[] = {4};
+  uint32_t output_shape[] = {1, oh, ow, 4};
+
+  zdnn_ztensor *input = alloc_ztensor_with_values(
+      input_shape, ZDNN_NHWC, FP32, NO_CONCAT, true, ZERO_ARRAY);
+  zdnn_ztensor *kernel = alloc_ztensor_with_values(
+      kernel_shape, ZDNN_HWCK, FP32, NO_CONCAT, true, ZERO_ARRAY);
+  zdnn_ztensor *bias = alloc_ztensor_with_values(
+      bias_shape, ZDNN_1D, FP32, NO_CONCAT, true, ZERO_ARRAY);
+  zdnn_ztensor *output =
+      alloc_output_ztensor(output_shape, ZDNN_NHWC, FP32, NO_CONCAT);
+
+  zdnn_status status =
+      zdnn_conv2d_dilated(input, kernel, bias, VALID_PADDING, sh, sw, dh, dw,
+                          CONV2D_ACT_NONE, NULL, output);
+  TEST_ASSERT_MESSAGE_FORMATTED(status == exp_status,
+                                "dilated conv2d returned %08x, expected %08x",
+                                status, exp_status);
+
+  free_ztensor_buffers(4, input, kernel, bias, output);
+}
+
+// dilations of 1 are a dense convolution
+void test_dilation_1() {
+  test_dilated(1, 7, 6, 3, 3, 3, 4, SAME_PADDING, 1, 1, 1, 1,
+               CONV2D_ACT_NONE, 0, 0);
+}
+
+// every output row and column class reads its own input sub-lattice
+void test_dilation_2_same() {
+  test_dilated(2, 9, 10, 5, 3, 3, 6, SAME_PADDING, 1, 1, 2, 2,
+               CONV2D_ACT_NONE, 0, 0);
+}
+
+void test_dilation_2_valid() {
+  test_dilated(1, 11, 12, 4, 3, 3, 5, VALID_PADDING, 1, 1, 2, 2,
+               CONV2D_ACT_RELU, 0, 0);
+}
+
+// the classes of a stride coprime to the dilation are strided convolutions
+void test_dilation_3_stride_2() {
+  test_dilated(1, 17, 16, 3, 3, 3, 4, SAME_PADDING, 2, 2, 3, 3,
+               CONV2D_ACT_NONE, 0, 0);
+}
+
+// a stride that's a multiple of the dilation has a single class
+void test_dilation_2_stride_2() {
+  test_dilated(1, 14, 13, 3, 3, 3, 4, VALID_PADDING, 2, 2, 2, 2,
+               CONV2D_ACT_NONE, 0, 0);
+}
+
+void test_dilation_height_only() {
+  test_dilated(1, 12, 7, 6, 3, 2, 3, SAME_PADDING, 1, 2, 4, 1,
+               CONV2D_ACT_RELU, 0.5, 0);
+}
+
+// channels are copied a run of cells of a stick at a time
+void test_dilation_wide_channels() {
+  test_dilated(1, 8, 8, 70, 3, 3, 70, SAME_PADDING, 1, 1, 2, 2,
+               CONV2D_ACT_NONE, 0, 0);
+}
+
+// the stacked classes are tiled beyond the NNPA limits
+void test_dilation_tiled() {
+  test_dilated(1, 260, 8, 3, 3, 3, 4, SAME_PADDING, 1, 1, 2, 2,
+               CONV2D_ACT_NONE, 0, 64);
+}
+
+void test_dilation_0() {
+  test_dilated_invalid(6, 6, 1, 1, 0, 1, ZDNN_INVALID_STRIDES);
+}
+
+void test_dilation_zero_strides() {
+  test_dilated_invalid(1, 1, 0, 0, 2, 2, ZDNN_INVALID_STRIDES);
+}
+
+// a dilation of 2 spans 5 input rows and columns, so VALID outputs are 4 by 4
+void test_dilation_invalid_output() {
+  test_dilated_invalid(6, 6, 1, 1, 2, 2, ZDNN_INVALID_SHAPE);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_dilation_1);
+  RUN_TEST(test_dilation_2_same);
+  RUN_TEST(test_dilation_2_valid);
+  RUN_TEST(test_dilation_3_stride_2);
+  RUN_TEST(test_dilation_2_stride_2);
+  RUN_TEST(test_dilation_height_only);
+  RUN_TEST(test_dilation_wide_channels);
+  RUN_TEST(test_dilation_tiled);
+  RUN_TEST(test_dilation_0);
+  RUN_TEST(test_dilation_zero_strides);
+  RUN_TEST(test_dilation_invalid_output);
+
+  return UNITY_END();
+}
@@ -0,0 +1,268 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testsupport.h"
+
+void setUp(void) {
+  VERIFY_HW_ENV;
+
+  save_nnpa_limits();
+}
+
+void tearDown(void) { restore_nnpa_limits(); }
+
+/*
+ * Run a convolution of (n, h, w, c) by (kh, kw, c / groups, k) in groups,
+ * with the NNPA maximum dimension index sizes lowered to max_dim_idx_size
+ * unless it's 0, and check it against a grouped convolution computed here
+ * within the rounding of the DLFLOAT16 results.
+ */
+static void test_grouped(uint32_t n, uint32_t h, uint32_t w, uint32_t c,
+                         uint32_t kh, uint32_t kw, uint32_t k,
+                         uint32_t groups, zdnn_pool_padding padding,
+                         uint32_t stride_h, uint32_t stride_w,
+                         zdnn_conv2d_act act, float clip,
+                         uint32_t max_dim_idx_size) {
+  uint32_t cg = c / groups;
+  conv2d_ref ref = {
+      .n = n,
+      .h = h,
+      .w = w,
+      .c = c,
+      .kh = kh,
+      .kw = kw,
+      .k = k,
+      .groups = groups,
+      .padding = padding,
+      .stride_h = stride_h,
+      .stride_w = stride_w,
+      .dilation_h = 1,
+      .dilation_w = 1,
+      .act = act,
+      .clip = clip,
+  };
+  conv2d_ref_dims(&ref);
+  uint32_t oh = ref.oh, ow = ref.ow;
+
+  uint32_t input_shape[] = {n, h, w, c};
+  uint32_t kernel_shape[] = {kh, kw, cg, k};
+  uint32_t bias_shape[] = {k};
+  uint32_t output_shape[] = {n, oh, ow, k};
+
+  float *input_values = alloc_random_dlf16_values((uint64_t)n * h * w * c);
+  float *kernel_values = alloc_random_dlf16_values((uint64_t)kh * kw * cg * k);
+  float *bias_values = alloc_random_dlf16_values(k);
+  float *expected = malloc((uint64_t)n * oh * ow * k * sizeof(float));
+
+  zdnn_ztensor *input = alloc_ztensor_with_values(
+      input_shape, ZDNN_NHWC, FP32, NO_CONCAT, false, input_values);
+  zdnn_ztensor *kernel = alloc_ztensor_with_values(
+      kernel_shape, ZDNN_HWCK, FP32, NO_CONCAT, false, kernel_values);
+  zdnn_ztensor *bias = alloc_ztensor_with_values(bias_shape, ZDNN_1D, FP32,
+                                                 NO_CONCAT, false, bias_values);
+  zdnn_ztensor *output =
+      alloc_output_ztensor(output_shape, ZDNN_NHWC, FP32, NO_CONCAT);
+
+  lower_nnpa_limits(0, max_dim_idx_size, 0);
+  zdnn_status status =
+      zdnn_conv2d_grouped(input, kernel, bias, groups, padding, stride_h,
+                          stride_w, act, &clip, output);
+  restore_nnpa_limits();
+
+  TEST_ASSERT_MESSAGE_FORMATTED(
+      status == ZDNN_OK,
+      "conv2d (%u, %u, %u, %u) by (%u, %u, %u, %u) in %u groups returned "
+      "%08x",
+      n, h, w, c, kh, kw, cg, k, groups, status);
+  TEST_ASSERT_TRUE(output->is_transformed);
+
+  compute_conv2d_ref(&ref, input_values, kernel_values, bias_values, expected);
+  assert_conv2d_output(output, expected);
+
+  free(input_values);
+  free(kernel_values);
+  free(bias_values);
+  free(expected);
+  free_ztensor_buffers(4, input, kernel, bias, output);
+}
+
+/// Check that a grouped convolution of the given shapes is rejected
+static void test_invalid_groups(uint32_t c, uint32_t kernel_c, uint32_t k,
+                                uint32_t groups) {
+  uint32_t input_shape[] = {1, 4, 4, c};
+  uint32_t kernel_shape[] = {3, 3, kernel_c, k};
+  uint32_t bias_shape[] = {k};
+  uint32_t output_shape[] = {1, 2, 2, k};
+
+  zdnn_ztensor *input = alloc_ztensor_with_values(
+      input_shape, ZDNN_NHWC, FP32, NO_CONCAT, true, ZERO_ARRAY);
+  zdnn_ztensor *kernel = alloc_ztensor_with_values(
+      kernel_shape, ZDNN_HWCK, FP32, NO_CONCAT, true, ZERO_ARRAY);
+  zdnn_ztensor *bias = alloc_ztensor_with_values(
+      bias_shape, ZDNN_1D, FP32, NO_CONCAT, true, ZERO_ARRAY);
+  zdnn_ztensor *output =
+      alloc_output_ztensor(output_shape, ZDNN_NHWC, FP32, NO_CONCAT);
+
+  zdnn_status status =
+      zdnn_conv2d_grouped(input, kernel, bias, groups, VALID_PADDING, 1, 1,
+                          CONV2D_ACT_NONE, NULL, output);
+  TEST_ASSERT_MESSAGE_FORMATTED(
+      status == ZDNN_INVALID_SHAPE,
+      "conv2d of %u channels by %u channels in %u groups returned %08x", c,
+      kernel_c, groups, status);
+
+  free_ztensor_buffers(4, input, kernel, bias, output);
+}
+
+// groups of 1 is a dense convolution
+void test_groups_1() {
+  test_grouped(1, 6, 6, 5, 3, 3, 4, 1, SAME_PADDING, 1, 1, CONV2D_ACT_NONE, 0,
+               0);
+}
+
+// both groups fit in a stick, so they're one convolution
+void test_groups_2() {
+  test_grouped(2, 7, 6, 8, 3, 3, 6, 2, VALID_PADDING, 1, 1, CONV2D_ACT_NONE,
+               0, 0);
+}
+
+// 5 groups of 32 input channels are packed 2 by 2, the last one on its own
+void test_groups_packed() {
+  test_grouped(1, 8, 8, 160, 3, 3, 10, 5, SAME_PADDING, 2, 2,
+               CONV2D_ACT_RELU, 0, 0);
+}
+
+// groups wider than a stick are convolved one at a time
+void test_groups_wide() {
+  test_grouped(1, 5, 5, 200, 3, 3, 20, 2, SAME_PADDING, 1, 1,
+               CONV2D_ACT_NONE, 0, 0);
+}
+
+// every group has one input channel and 2 output channels
+void test_depth_multiplier() {
+  test_grouped(1, 9, 9, 16, 3, 3, 32, 16, SAME_PADDING, 1, 1,
+               CONV2D_ACT_RELU, 0.5, 0);
+}
+
+// the packs are tiled beyond the NNPA limits
+void test_groups_tiled() {
+  test_grouped(1, 150, 10, 24, 3, 3, 12, 3, SAME_PADDING, 1, 1,
+               CONV2D_ACT_NONE, 0, 128);
+}
+
+// one input and one output channel per group of a small convolution is
+// computed from the sticks
+void test_depthwise_same() {
+  test_grouped(2, 10, 9, 70, 3, 3, 70, 70, SAME_PADDING, 1, 1,
+               CONV2D_ACT_RELU, 0.5, 0);
+}
+
+void test_depthwise_valid_strided() {
+  test_grouped(1, 11, 12, 8, 3, 5, 8, 8, VALID_PADDING, 2, 3,
+               CONV2D_ACT_NONE, 0, 0);
+}
+
+void test_depthwise_zero_strides() {
+  test_grouped(3, 4, 5, 130, 4, 5, 130, 130, VALID_PADDING, 0, 0,
+               CONV2D_ACT_RELU, 0, 0);
+}
+
+// larger depthwise convolutions are packed like other groups, and tiled
+// beyond the NNPA limits
+void test_depthwise_packed() {
+  test_grouped(1, 40, 40, 70, 3, 3, 70, 70, SAME_PADDING, 1, 1,
+               CONV2D_ACT_RELU, 0, 0);
+}
+
+void test_depthwise_large() {
+  test_grouped(1, 300, 4, 3, 3, 3, 3, 3, SAME_PADDING, 1, 1,
+               CONV2D_ACT_NONE, 0, 128);
+}
+
+// a depthwise output beyond the DLFLOAT16 range is a range violation, with
+// the rest of the output computed
+void test_depthwise_range_violation() {
+  uint32_t input_shape[] = {1, 2, 2, 2};
+  uint32_t kernel_shape[] = {1, 1, 1, 2};
+  uint32_t bias_shape[] = {2};
+  uint32_t output_shape[] = {1, 2, 2, 2};
+  float input_values[] = {1e5, 1, 1, 1, 1, 1, 1, 1};
+  float kernel_values[] = {1e5, 1};
+
+  zdnn_ztensor *input = alloc_ztensor_with_values(
+      input_shape, ZDNN_NHWC, FP32, NO_CONCAT, false, input_values);
+  zdnn_ztensor *kernel = alloc_ztensor_with_values(
+      kernel_shape, ZDNN_HWCK, FP32, NO_CONCAT, false, kernel_values);
+  zdnn_ztensor *bias = alloc_ztensor_with_values(
+      bias_shape, ZDNN_1D, FP32, NO_CONCAT, true, ZERO_ARRAY);
+  zdnn_ztensor *output =
+      alloc_output_ztensor(output_shape, ZDNN_NHWC, FP32, NO_CONCAT);
+
+  TEST_ASSERT_EQUAL(ZDNN_ELEMENT_RANGE_VIOLATION,
+                    zdnn_conv2d_grouped(input, kernel, bias, 2, VALID_PADDING,
+                                        1, 1, CONV2D_ACT_NONE, NULL, output));
+  TEST_ASSERT_TRUE(output->is_transformed);
+
+  size_t offset = get_stick_offset(0, 1, 1, 1, output->transformed_desc);
+  TEST_ASSERT_EQUAL_FLOAT(1, cnvt_1_dlf16_to_fp32(STICK_CELL16(
+                                 *(uint16_t *)((char *)output->buffer +
+                                               offset))));
+
+  free_ztensor_buffers(4, input, kernel, bias, output);
+}
+
+// groups must divide the input and output channels, and the kernel must have
+// the input channels of one group
+void test_invalid_groups_0() { test_invalid_groups(6, 6, 4, 0); }
+
+void test_invalid_groups_input_channels() { test_invalid_groups(6, 1, 8, 4); }
+
+void test_invalid_groups_output_channels() {
+  test_invalid_groups(6, 3, 5, 2);
+}
+
+void test_invalid_groups_kernel_channels() {
+  test_invalid_groups(6, 6, 4, 2);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_groups_1);
+  RUN_TEST(test_groups_2);
+  RUN_TEST(test_groups_packed);
+  RUN_TEST(test_groups_wide);
+  RUN_TEST(test_depth_multiplier);
+  RUN_TEST(test_groups_tiled);
+  RUN_TEST(test_depthwise_same);
+  RUN_TEST(test_depthwise_valid_strided);
+  RUN_TEST(test_depthwise_zero_strides);
+  RUN_TEST(test_depthwise_packed);
+  RUN_TEST(test_depthwise_large);
+  RUN_TEST(test_depthwise_range_violation);
+  RUN_TEST(test_invalid_groups_0);
+  RUN_TEST(test_invalid_groups_input_channels);
+  RUN_TEST(test_invalid_groups_output_channels);
+  RUN_TEST(test_invalid_groups_kernel_channels);
+
+  return UNITY_END();
+}
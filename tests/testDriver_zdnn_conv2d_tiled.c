@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testsupport.h"
+
+void setUp(void) {
+  VERIFY_HW_ENV;
+
+  save_nnpa_limits();
+}
+
+void tearDown(void) { restore_nnpa_limits(); }
+
+/*
+ * Run a convolution of (n, h, w, c) by (kh, kw, c, k) with the NNPA limits
+ * lowered as given, and check it against a convolution computed here within
+ * the rounding of the DLFLOAT16 partial sums.
+ */
+static void test_tiled(uint32_t n, uint32_t h, uint32_t w, uint32_t c,
+                       uint32_t kh, uint32_t kw, uint32_t k,
+                       zdnn_pool_padding padding, uint32_t stride_h,
+                       uint32_t stride_w, zdnn_conv2d_act act, float clip,
+                       uint32_t max_dim4, uint32_t max_dim_idx_size,
+                       uint64_t max_tensor_size) {
+  conv2d_ref ref = {
+      .n = n,
+      .h = h,
+      .w = w,
+      .c = c,
+      .kh = kh,
+      .kw = kw,
+      .k = k,
+      .groups = 1,
+      .padding = padding,
+      .stride_h = stride_h,
+      .stride_w = stride_w,
+      .dilation_h = 1,
+      .dilation_w = 1,
+      .act = act,
+      .clip = clip,
+  };
+  conv2d_ref_dims(&ref);
+  uint32_t oh = ref.oh, ow = ref.ow;
+
+  uint32_t input_shape[] = {n, h, w, c};
+  uint32_t kernel_shape[] = {kh, kw, c, k};
+  uint32_t bias_shape[] = {k};
+  uint32_t output_shape[] = {n, oh, ow, k};
+
+  float *input_values = alloc_random_dlf16_values((uint64_t)n * h * w * c);
+  float *kernel_values = alloc_random_dlf16_values((uint64_t)kh * kw * c * k);
+  float *bias_values = alloc_random_dlf16_values(k);
+  float *expected = malloc((uint64_t)n * oh * ow * k * sizeof(float));
+
+  zdnn_ztensor *input = alloc_ztensor_with_values(
+      input_shape, ZDNN_NHWC, FP32, NO_CONCAT, false, input_values);
+  zdnn_ztensor *kernel = alloc_ztensor_with_values(
+      kernel_shape, ZDNN_HWCK, FP32, NO_CONCAT, false, kernel_values);
+  zdnn_ztensor *bias = alloc_ztensor_with_values(bias_shape, ZDNN_1D, FP32,
+                                                 NO_CONCAT, false, bias_values);
+  zdnn_ztensor *output =
+      alloc_output_ztensor(output_shape, ZDNN_NHWC, FP32, NO_CONCAT);
+
+  lower_nnpa_limits(max_dim4, max_dim_idx_size, max_tensor_size);
+  zdnn_status status = zdnn_conv2d(input, kernel, bias, padding, stride_h,
+                                   stride_w, act, &clip, output);
+  restore_nnpa_limits();
+
+  TEST_ASSERT_MESSAGE_FORMATTED(
+      status == ZDNN_OK,
+      "tiled conv2d (%u, %u, %u, %u) by (%u, %u, %u, %u) returned %08x", n, h,
+      w, c, kh, kw, c, k, status);
+  TEST_ASSERT_TRUE(output->is_transformed);
+
+  compute_conv2d_ref(&ref, input_values, kernel_values, bias_values, expected);
+  assert_conv2d_output(output, expected);
+
+  free(input_values);
+  free(kernel_values);
+  free(bias_values);
+  free(expected);
+  free_ztensor_buffers(4, input, kernel, bias, output);
+}
+
+// output rows are tiled, the halo rows at the top and bottom edges are padding
+void test_tile_height_same_padding() {
+  test_tiled(1, 300, 20, 3, 3, 3, 8, SAME_PADDING, 1, 1, CONV2D_ACT_NONE, 0,
+             0, 128, 0);
+}
+
+// output columns are tiled, halo columns overlap between tiles
+void test_tile_width_strided() {
+  test_tiled(1, 10, 301, 4, 5, 3, 8, VALID_PADDING, 1, 2, CONV2D_ACT_NONE, 0,
+             0, 128, 0);
+}
+
+void test_tile_batch() {
+  test_tiled(3, 6, 7, 5, 3, 3, 4, SAME_PADDING, 2, 2, CONV2D_ACT_RELU, 0, 1,
+             0, 0);
+}
+
+// output channel tiles take views of the kernel and the bias
+void test_tile_output_channels() {
+  test_tiled(1, 8, 8, 16, 3, 3, 300, SAME_PADDING, 1, 1, CONV2D_ACT_RELU, 0,
+             0, 128, 0);
+}
+
+// input channel tiles are added up, then the activation is applied
+void test_tile_input_channels() {
+  test_tiled(1, 6, 6, 200, 3, 3, 10, VALID_PADDING, 1, 1, CONV2D_ACT_RELU,
+             0.5, 0, 128, 0);
+}
+
+void test_tile_all() {
+  test_tiled(2, 150, 140, 130, 3, 3, 130, SAME_PADDING, 2, 2,
+             CONV2D_ACT_RELU, 0, 0, 128, 0);
+}
+
+// tiles shrink until they are within the maximum tensor size
+void test_tile_max_tensor_size() {
+  test_tiled(2, 40, 40, 70, 3, 3, 70, SAME_PADDING, 1, 1, CONV2D_ACT_NONE, 0,
+             0, 0, 64 * 1024);
+}
+
+// kernels taller or wider than the zAIU convolves are split up
+void test_tile_kernel_height() {
+  test_tiled(1, 80, 3, 2, 70, 1, 3, VALID_PADDING, 1, 1, CONV2D_ACT_NONE, 0,
+             0, 0, 0);
+}
+
+void test_tile_kernel_width() {
+  test_tiled(1, 5, 90, 2, 3, 70, 3, SAME_PADDING, 1, 2, CONV2D_ACT_RELU, 0, 0,
+             0, 0);
+}
+
+// with zero strides the kernel covers the whole input
+void test_tile_zero_strides() {
+  test_tiled(1, 2, 500, 3, 2, 500, 4, VALID_PADDING, 0, 0, CONV2D_ACT_NONE, 0,
+             0, 0, 0);
+}
+
+// zero strides kernels beyond the 448 the zAIU convolves are split up too
+void test_tile_zero_strides_kernel_height() {
+  test_tiled(1, 512, 1, 1, 512, 1, 1, VALID_PADDING, 0, 0, CONV2D_ACT_NONE, 0,
+             0, 0, 0);
+}
+
+void test_tile_zero_strides_kernel_width() {
+  test_tiled(1, 1, 512, 1, 1, 512, 1, VALID_PADDING, 0, 0, CONV2D_ACT_RELU, 0,
+             0, 0, 0);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_tile_height_same_padding);
+  RUN_TEST(test_tile_width_strided);
+  RUN_TEST(test_tile_batch);
+  RUN_TEST(test_tile_output_channels);
+  RUN_TEST(test_tile_input_channels);
+  RUN_TEST(test_tile_all);
+  RUN_TEST(test_tile_max_tensor_size);
+  RUN_TEST(test_tile_kernel_height);
+  RUN_TEST(test_tile_kernel_width);
+  RUN_TEST(test_tile_zero_strides);
+  RUN_TEST(test_tile_zero_strides_kernel_height);
+  RUN_TEST(test_tile_zero_strides_kernel_width);
+
+  return UNITY_END();
+}
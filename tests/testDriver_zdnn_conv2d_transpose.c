@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testsupport.h"
+
+void setUp(void) {
+  VERIFY_HW_ENV;
+
+  save_nnpa_limits();
+}
+
+void tearDown(void) { restore_nnpa_limits(); }
+
+/*
+ * Run a transposed convolution of (n, h, w, c) by (kh, kw, c, k) with strides
+ * (sh, sw), and check it against one computed here by adding every input
+ * value times the kernel into the output.
+ */
+static void test_transpose(uint32_t n, uint32_t h, uint32_t w, uint32_t c,
+                           uint32_t kh, uint32_t kw, uint32_t k,
+                           zdnn_pool_padding padding, uint32_t sh,
+                           uint32_t sw, zdnn_conv2d_act act, float clip,
+                           uint32_t max_dim_idx_size) {
+  uint32_t oh = h * sh, ow = w * sw;
+  int64_t pad_h = 0, pad_w = 0;
+
+  if (padding == SAME_PADDING) {
+    pad_h = MAX((int64_t)kh - sh, 0) / 2;
+    pad_w = MAX((int64_t)kw - sw, 0) / 2;
+  } else {
+    oh += MAX((int64_t)kh - sh, 0);
+    ow += MAX((int64_t)kw - sw, 0);
+  }
+
+  uint32_t input_shape[] = {n, h, w, c};
+  uint32_t kernel_shape[] = {kh, kw, c, k};
+  uint32_t bias_shape[] = {k};
+  uint32_t output_shape[] = {n, oh, ow, k};
+  uint64_t num_out = (uint64_t)n * oh * ow * k;
+
+  float *input_values = alloc_random_dlf16_values((uint64_t)n * h * w * c);
+  float *kernel_values = alloc_random_dlf16_values((uint64_t)kh * kw * c * k);
+  float *bias_values = alloc_random_dlf16_values(k);
+  float *expected = malloc(num_out * sizeof(float));
+
+  zdnn_ztensor *input = alloc_ztensor_with_values(
+      input_shape, ZDNN_NHWC, FP32, NO_CONCAT, false, input_values);
+  zdnn_ztensor *kernel = alloc_ztensor_with_values(
+      kernel_shape, ZDNN_HWCK, FP32, NO_CONCAT, false, kernel_values);
+  zdnn_ztensor *bias = alloc_ztensor_with_values(bias_shape, ZDNN_1D, FP32,
+                                                 NO_CONCAT, false, bias_values);
+  zdnn_ztensor *output =
+      alloc_output_ztensor(output_shape, ZDNN_NHWC, FP32, NO_CONCAT);
+
+  lower_nnpa_limits(0, max_dim_idx_size, 0);
+  zdnn_status status = zdnn_conv2d_transpose(input, kernel, bias, padding, sh,
+                                             sw, act, &clip, output);
+  restore_nnpa_limits();
+
+  TEST_ASSERT_MESSAGE_FORMATTED(
+      status == ZDNN_OK,
+      "transposed conv2d (%u, %u, %u, %u) by (%u, %u, %u, %u) with strides "
+      "(%u, %u) returned %08x",
+      n, h, w, c, kh, kw, c, k, sh, sw, status);
+  TEST_ASSERT_TRUE(output->is_transformed);
+
+  for (uint64_t i = 0; i < num_out; i++) {
+    expected[i] = bias_values[i % k];
+  }
+  for (uint32_t e4x = 0; e4x < n; e4x++) {
+    for (uint32_t ih = 0; ih < h; ih++) {
+      for (uint32_t iw = 0; iw < w; iw++) {
+        for (uint32_t y = 0; y < kh; y++) {
+          int64_t e3x = (int64_t)ih * sh + y - pad_h;
+          for (uint32_t x = 0; x < kw; x++) {
+            int64_t e2x = (int64_t)iw * sw + x - pad_w;
+            if (e3x < 0 || e3x >= oh || e2x < 0 || e2x >= ow) {
+              continue;
+            }
+            float *out = expected + ((e4x * oh + e3x) * ow + e2x) * k;
+            for (uint32_t ch = 0; ch < c; ch++) {
+              float in = input_values[((e4x * h + ih) * w + iw) * c + ch];
+              const float *wk =
+                  kernel_values + (((uint64_t)y * kw + x) * c + ch) * k;
+              for (uint32_t e1x = 0; e1x < k; e1x++) {
+                out[e1x] += in * wk[e1x];
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+  for (uint64_t i = 0; i < num_out; i++) {
+    expected[i] = apply_conv2d_act(expected[i], act, clip);
+  }
+  assert_conv2d_output(output, expected);
+
+  free(input_values);
+  free(kernel_values);
+  free(bias_values);
+  free(expected);
+  free_ztensor_buffers(4, input, kernel, bias, output);
+}
+
+/// Check that a transposed convolution of (1, 4, 4, 3) by (3, 3, 3, 2) into
+/// an output of (1, oh, ow, 2) is rejected
+static void test_transpose_invalid(uint32_t oh, uint32_t ow, uint32_t sh,
+                                   uint32_t sw, zdnn_status exp_status) {
+  uint32_t input_shape[] = {1, 4, 4, 3};
+  uint32_t kernel_shape[] = {3, 3, 3, 2};
+  uint32_t bias_shape[] = {2};
+  uint32_t output_shape[] = {1, oh, ow, 2};
+
+  zdnn_ztensor *input = alloc_ztensor_with_values(
+      input_shape, ZDNN_NHWC, FP32, NO_CONCAT, true, ZERO_ARRAY);
+  zdnn_ztensor *kernel = alloc_ztensor_with_values(
+      kernel_shape, ZDNN_HWCK, FP32, NO_CONCAT, true, ZERO_ARRAY);
+  zdnn_ztensor *bias = alloc_ztensor_with_values(
+      bias_shape, ZDNN_1D, FP32, NO_CONCAT, true, ZERO_ARRAY);
+  zdnn_ztensor *output =
+      alloc_output_ztensor(output_shape, ZDNN_NHWC, FP32, NO_CONCAT);
+
+  zdnn_status status = zdnn_conv2d_transpose(
+      input, kernel, bias, SAME_PADDING, sh, sw, CONV2D_ACT_NONE, NULL, output);
+  TEST_ASSERT_MESSAGE_FORMATTED(
+      status == exp_status, "transposed conv2d returned %08x, expected %08x",
+      status, exp_status);
+
+  free_ztensor_buffers(4, input, kernel, bias, output);
+}
+
+// the 4 phases of the output each read a 2 by 2 corner of the kernel
+void test_stride_2_same() {
+  test_transpose(2, 5, 6, 3, 3, 3, 4, SAME_PADDING, 2, 2, CONV2D_ACT_NONE, 0,
+                 0);
+}
+
+void test_stride_2_valid() {
+  test_transpose(1, 5, 4, 4, 3, 3, 3, VALID_PADDING, 2, 2, CONV2D_ACT_NONE, 0,
+                 0);
+}
+
+// kernels of the stride size don't overlap
+void test_stride_2_kernel_2() {
+  test_transpose(1, 6, 5, 3, 2, 2, 5, VALID_PADDING, 2, 2, CONV2D_ACT_RELU, 0,
+                 0);
+}
+
+// with stride 1 the kernel is only flipped
+void test_stride_1() {
+  test_transpose(1, 6, 7, 3, 3, 3, 4, SAME_PADDING, 1, 1, CONV2D_ACT_NONE, 0,
+                 0);
+}
+
+// kernels smaller than the stride leave gaps of only the bias
+void test_stride_3_kernel_2() {
+  test_transpose(1, 4, 4, 2, 2, 2, 3, VALID_PADDING, 3, 3, CONV2D_ACT_NONE, 0,
+                 0);
+}
+
+void test_strides_differ() {
+  test_transpose(1, 5, 4, 3, 4, 5, 4, SAME_PADDING, 2, 3, CONV2D_ACT_RELU,
+                 0.5, 0);
+}
+
+// the phases of 70 output channels don't start on a stick
+void test_wide_channels() {
+  test_transpose(1, 4, 4, 70, 3, 3, 70, SAME_PADDING, 2, 2, CONV2D_ACT_NONE, 0,
+                 0);
+}
+
+// the stacked phases are tiled beyond the NNPA limits
+void test_transpose_tiled() {
+  test_transpose(1, 100, 6, 3, 3, 3, 20, SAME_PADDING, 2, 2, CONV2D_ACT_NONE,
+                 0, 64);
+}
+
+void test_transpose_zero_strides() {
+  test_transpose_invalid(1, 1, 0, 0, ZDNN_INVALID_STRIDES);
+}
+
+// with SAME padding the output is the input times the strides
+void test_transpose_invalid_output() {
+  test_transpose_invalid(9, 8, 2, 2, ZDNN_INVALID_SHAPE);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_stride_2_same);
+  RUN_TEST(test_stride_2_valid);
+  RUN_TEST(test_stride_2_kernel_2);
+  RUN_TEST(test_stride_1);
+  RUN_TEST(test_stride_3_kernel_2);
+  RUN_TEST(test_strides_differ);
+  RUN_TEST(test_wide_channels);
+  RUN_TEST(test_transpose_tiled);
+  RUN_TEST(test_transpose_zero_strides);
+  RUN_TEST(test_transpose_invalid_output);
+
+  return UNITY_END();
+}
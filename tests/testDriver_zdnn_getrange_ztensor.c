@@ -16,11 +16,12 @@
  */
 
 #include "testsupport.h"
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-typedef vector signed short vec_short;
+typedef VEC_UNALIGNED signed short vec_short;
 
 void setUp(void) {
   VERIFY_HW_ENV;
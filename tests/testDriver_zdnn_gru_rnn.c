@@ -477,9 +477,17 @@ float default_bidir_exp_hn_out_final_ts_values[] = {
 /******************************************************************************
                           Unity Methods
 ******************************************************************************/
-void setUp(void) { VERIFY_HW_ENV; }
+static uint32_t saved_max_threads;
 
-void tearDown(void) {}
+void setUp(void) {
+  VERIFY_HW_ENV;
+  saved_max_threads = zdnn_get_max_threads();
+}
+
+void tearDown(void) {
+  rnn_bidir_concurrent = false;
+  zdnn_set_max_threads(saved_max_threads);
+}
 
 /******************************************************************************
                               Tests
@@ -748,6 +756,20 @@ void gru_basic_bidir_hn_final() {
       BIDIR, ZDNN_OK);
 }
 
+// Same as above with the two directions running on two threads, results must
+// not change
+void gru_concurrent_bidir_hn_all() {
+  rnn_bidir_concurrent = true;
+  zdnn_set_max_threads(2);
+  gru_basic_bidir_hn_all();
+}
+
+void gru_concurrent_bidir_hn_final() {
+  rnn_bidir_concurrent = true;
+  zdnn_set_max_threads(2);
+  gru_basic_bidir_hn_final();
+}
+
 int main() {
   UNITY_BEGIN();
 
@@ -764,6 +786,8 @@ int main() {
   // BIDIR direction tests
   RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(gru_basic_bidir_hn_all);
   RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(gru_basic_bidir_hn_final);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(gru_concurrent_bidir_hn_all);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(gru_concurrent_bidir_hn_final);
 
   return UNITY_END();
 }
@@ -619,9 +619,17 @@ float default_bidir_exp_cf_out_values[] = {
 /******************************************************************************
                           Unity Methods
 ******************************************************************************/
-void setUp(void) { VERIFY_HW_ENV; }
+static uint32_t saved_max_threads;
 
-void tearDown(void) {}
+void setUp(void) {
+  VERIFY_HW_ENV;
+  saved_max_threads = zdnn_get_max_threads();
+}
+
+void tearDown(void) {
+  rnn_bidir_concurrent = false;
+  zdnn_set_max_threads(saved_max_threads);
+}
 
 /******************************************************************************
                               Tests
@@ -854,6 +862,20 @@ void lstm_basic_bidir_hn_final() {
       BIDIR, ZDNN_OK);
 }
 
+// Same as above with the two directions running on two threads, results must
+// not change
+void lstm_concurrent_bidir_hn_all() {
+  rnn_bidir_concurrent = true;
+  zdnn_set_max_threads(2);
+  lstm_basic_bidir_hn_all();
+}
+
+void lstm_concurrent_bidir_hn_final() {
+  rnn_bidir_concurrent = true;
+  zdnn_set_max_threads(2);
+  lstm_basic_bidir_hn_final();
+}
+
 int main() {
   UNITY_BEGIN();
   // FWD direction tests
@@ -867,5 +889,7 @@ int main() {
   // BIDIR direction tests
   RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(lstm_basic_bidir_hn_all);
   RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(lstm_basic_bidir_hn_final);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(lstm_concurrent_bidir_hn_all);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(lstm_concurrent_bidir_hn_final);
   return UNITY_END();
 }
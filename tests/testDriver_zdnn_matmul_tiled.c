@@ -0,0 +1,251 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testsupport.h"
+
+// limit the tests lower the NNPA maximum dimension index sizes to, so small
+// matmuls are tiled
+#define TEST_MAX_DIM_IDX_SIZE 128
+
+void setUp(void) {
+  VERIFY_HW_ENV;
+  VERIFY_PARMBLKFORMAT_1;
+
+  save_nnpa_limits();
+}
+
+void tearDown(void) { restore_nnpa_limits(); }
+
+/*
+ * Run a matmul with the NNPA limits, then again with them lowered to
+ * max_dim4, max_dim_idx_size and max_tensor_size (0 keeps a limit), and check
+ * that the tiled output is the untiled one within the rounding of the
+ * DLFLOAT16 partial sums.  An A or B stack of 1 is broadcast.
+ */
+void test_tiled_limits(uint32_t s_a, uint32_t s_b, uint32_t m, uint32_t n,
+                       uint32_t p, bool transpose_a, bool transpose_b,
+                       zdnn_matmul_ops op_type, uint32_t max_dim4,
+                       uint32_t max_dim_idx_size, uint64_t max_tensor_size,
+                       zdnn_status exp_status) {
+  uint32_t s = MAX(s_a, s_b);
+  uint32_t a_shape[] = {s_a, transpose_a ? n : m, transpose_a ? m : n};
+  uint32_t b_shape[] = {s_b, transpose_b ? p : n, transpose_b ? n : p};
+  uint32_t c_shape[] = {s_b, p};
+  uint32_t out_shape[] = {s, m, p};
+
+  zdnn_ztensor *input_a =
+      alloc_ztensor_with_random_values(a_shape, ZDNN_3DS, -1, 1);
+  zdnn_ztensor *input_b =
+      alloc_ztensor_with_random_values(b_shape, ZDNN_3DS, -1, 1);
+  zdnn_ztensor *input_c =
+      alloc_ztensor_with_random_values(c_shape, ZDNN_2DS, -1, 1);
+  zdnn_ztensor *untiled = alloc_output_ztensor(out_shape, ZDNN_3DS, FP32,
+                                               NO_CONCAT);
+  zdnn_ztensor *tiled = alloc_output_ztensor(out_shape, ZDNN_3DS, FP32,
+                                             NO_CONCAT);
+
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_matmul_transpose_op(input_a, input_b, input_c,
+                                             transpose_a, transpose_b, op_type,
+                                             untiled));
+
+  lower_nnpa_limits(max_dim4, max_dim_idx_size, max_tensor_size);
+  zdnn_status status =
+      zdnn_matmul_transpose_op(input_a, input_b, input_c, transpose_a,
+                               transpose_b, op_type, tiled);
+  restore_nnpa_limits();
+
+  TEST_ASSERT_MESSAGE_FORMATTED(
+      status == exp_status,
+      "tiled matmul (%u, %u, %u, %u) returned %08x, expected %08x", s, m, n, p,
+      status, exp_status);
+
+  if (exp_status == ZDNN_OK) {
+    TEST_ASSERT_TRUE(tiled->is_transformed);
+
+    for (uint32_t e4x = 0; e4x < s; e4x++) {
+      for (uint32_t e2x = 0; e2x < m; e2x++) {
+        for (uint32_t e1x = 0; e1x < p; e1x++) {
+          size_t offset =
+              get_stick_offset(e4x, 0, e2x, e1x, untiled->transformed_desc);
+          float exp_val = cnvt_1_dlf16_to_fp32(
+              STICK_CELL16(*(uint16_t *)((char *)untiled->buffer + offset)));
+          float val = cnvt_1_dlf16_to_fp32(
+              STICK_CELL16(*(uint16_t *)((char *)tiled->buffer + offset)));
+          TEST_ASSERT_MESSAGE_FORMATTED(
+              fabsf(val - exp_val) <= 0.02f * (fabsf(exp_val) + 1),
+              "output (%u, %u, %u) is %f, expected %f", e4x, e2x, e1x, val,
+              exp_val);
+        }
+      }
+    }
+  }
+
+  free_ztensor_buffers(5, input_a, input_b, input_c, untiled, tiled);
+}
+
+// tile with dim2 and dim1 limited to TEST_MAX_DIM_IDX_SIZE
+void test_tiled(uint32_t s, uint32_t m, uint32_t n, uint32_t p,
+                bool transpose_a, bool transpose_b, zdnn_matmul_ops op_type,
+                zdnn_status exp_status) {
+  test_tiled_limits(s, s, m, n, p, transpose_a, transpose_b, op_type, 0,
+                    TEST_MAX_DIM_IDX_SIZE, 0, exp_status);
+}
+
+// every tile of every tensor is a view
+void test_tile_m() {
+  test_tiled(1, 300, 60, 50, false, false, MATMUL_OP_ADDITION, ZDNN_OK);
+}
+
+void test_tile_p() {
+  test_tiled(1, 20, 50, 300, false, false, MATMUL_OP_ADDITION, ZDNN_OK);
+}
+
+// partial products are added up
+void test_tile_n() {
+  test_tiled(1, 20, 300, 30, false, false, MATMUL_OP_ADDITION, ZDNN_OK);
+}
+
+void test_tile_all() {
+  test_tiled(1, 200, 270, 150, false, false, MATMUL_OP_ADDITION, ZDNN_OK);
+}
+
+void test_tile_all_stacked() {
+  test_tiled(2, 150, 200, 170, false, false, MATMUL_OP_ADDITION, ZDNN_OK);
+}
+
+void test_tile_transpose_a() {
+  test_tiled(1, 150, 170, 140, true, false, MATMUL_OP_ADDITION, ZDNN_OK);
+}
+
+void test_tile_transpose_b() {
+  test_tiled(1, 150, 170, 140, false, true, MATMUL_OP_ADDITION, ZDNN_OK);
+}
+
+void test_tile_transpose_both() {
+  test_tiled(2, 150, 170, 140, true, true, MATMUL_OP_ADDITION, ZDNN_OK);
+}
+
+// a comparison of the whole dot product can be tiled along M and P only
+void test_tile_comparison() {
+  test_tiled(1, 200, 100, 150, false, false, MATMUL_OP_GREATER, ZDNN_OK);
+}
+
+void test_tile_comparison_n() {
+  test_tiled(1, 20, 300, 30, false, false, MATMUL_OP_GREATER,
+             ZDNN_EXCEEDS_MDIS);
+}
+
+// the stack is tiled in chunks of the maximum dim4 index size
+void test_tile_s() {
+  test_tiled_limits(5, 5, 20, 30, 40, false, false, MATMUL_OP_ADDITION, 2, 0,
+                    0, ZDNN_OK);
+}
+
+void test_tile_s_and_all() {
+  test_tiled_limits(3, 3, 150, 200, 170, false, true, MATMUL_OP_ADDITION, 2,
+                    TEST_MAX_DIM_IDX_SIZE, 0, ZDNN_OK);
+}
+
+// a single-stack B and C, or A, is broadcast to every stack tile
+void test_tile_s_bcast23() {
+  test_tiled_limits(5, 1, 20, 30, 40, false, false, MATMUL_OP_ADDITION, 2, 0,
+                    0, ZDNN_OK);
+}
+
+void test_tile_s_bcast1() {
+  test_tiled_limits(1, 5, 20, 30, 40, false, false, MATMUL_OP_ADDITION, 2, 0,
+                    0, ZDNN_OK);
+}
+
+// tiles are shrunk until every one is within the maximum tensor size: 64 KB
+// holds 8 pages of 32 sticks
+void test_tile_mts() {
+  test_tiled_limits(2, 2, 200, 300, 150, false, false, MATMUL_OP_ADDITION, 0,
+                    0, 64 * 1024, ZDNN_OK);
+}
+
+void test_tile_mts_transpose_a() {
+  test_tiled_limits(1, 1, 150, 170, 140, true, false, MATMUL_OP_ADDITION, 0, 0,
+                    32 * 1024, ZDNN_OK);
+}
+
+void test_tile_mts_comparison() {
+  test_tiled_limits(1, 1, 200, 60, 150, false, false, MATMUL_OP_GREATER, 0, 0,
+                    32 * 1024, ZDNN_OK);
+}
+
+// not even a single stick of every tile fits
+void test_tile_mts_too_small() {
+  test_tiled_limits(1, 1, 20, 30, 40, false, false, MATMUL_OP_ADDITION, 0, 0,
+                    1024, ZDNN_EXCEEDS_MTS);
+}
+
+// zdnn_matmul_op() is tiled the same way
+void test_matmul_op_tile_m() {
+  uint32_t a_shape[] = {1, 300, 60}, b_shape[] = {1, 60, 50},
+           c_shape[] = {1, 50}, out_shape[] = {1, 300, 50};
+  zdnn_ztensor *input_a =
+      alloc_ztensor_with_random_values(a_shape, ZDNN_3DS, -1, 1);
+  zdnn_ztensor *input_b =
+      alloc_ztensor_with_random_values(b_shape, ZDNN_3DS, -1, 1);
+  zdnn_ztensor *input_c =
+      alloc_ztensor_with_random_values(c_shape, ZDNN_2DS, -1, 1);
+  zdnn_ztensor *output =
+      alloc_output_ztensor(out_shape, ZDNN_3DS, FP32, NO_CONCAT);
+
+  lower_nnpa_limits(0, TEST_MAX_DIM_IDX_SIZE, 0);
+  zdnn_status status = zdnn_matmul_op(input_a, input_b, input_c,
+                                      MATMUL_OP_ADDITION, output);
+  restore_nnpa_limits();
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, status);
+  TEST_ASSERT_TRUE(output->is_transformed);
+
+  free_ztensor_buffers(4, input_a, input_b, input_c, output);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_tile_m);
+  RUN_TEST(test_tile_p);
+  RUN_TEST(test_tile_n);
+  RUN_TEST(test_tile_all);
+  RUN_TEST(test_tile_all_stacked);
+  RUN_TEST(test_tile_transpose_a);
+  RUN_TEST(test_tile_transpose_b);
+  RUN_TEST(test_tile_transpose_both);
+  RUN_TEST(test_tile_comparison);
+  RUN_TEST(test_tile_comparison_n);
+  RUN_TEST(test_tile_s);
+  RUN_TEST(test_tile_s_and_all);
+  RUN_TEST(test_tile_s_bcast23);
+  RUN_TEST(test_tile_s_bcast1);
+  RUN_TEST(test_tile_mts);
+  RUN_TEST(test_tile_mts_transpose_a);
+  RUN_TEST(test_tile_mts_comparison);
+  RUN_TEST(test_tile_mts_too_small);
+  RUN_TEST(test_matmul_op_tile_m);
+
+  return UNITY_END();
+}
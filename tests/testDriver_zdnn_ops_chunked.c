@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testsupport.h"
+
+void setUp(void) {
+  VERIFY_HW_ENV;
+
+  save_nnpa_limits();
+}
+
+void tearDown(void) { restore_nnpa_limits(); }
+
+/// Check that two zTensors of the same dims hold the same cells
+static void assert_same_cells(const zdnn_ztensor *chunked,
+                              const zdnn_ztensor *whole) {
+  const zdnn_tensor_desc *desc = whole->transformed_desc;
+
+  TEST_ASSERT_TRUE(chunked->is_transformed);
+  for (uint32_t e4x = 0; e4x < desc->dim4; e4x++) {
+    for (uint32_t e3x = 0; e3x < desc->dim3; e3x++) {
+      for (uint32_t e2x = 0; e2x < desc->dim2; e2x++) {
+        for (uint32_t e1x = 0; e1x < desc->dim1; e1x++) {
+          size_t offset = get_stick_offset(e4x, e3x, e2x, e1x, desc);
+          uint16_t val = *(uint16_t *)((char *)chunked->buffer + offset);
+          uint16_t exp_val = *(uint16_t *)((char *)whole->buffer + offset);
+          TEST_ASSERT_MESSAGE_FORMATTED(
+              val == exp_val, "(%u, %u, %u, %u) is 0x%04x, expected 0x%04x",
+              e4x, e3x, e2x, e1x, val, exp_val);
+        }
+      }
+    }
+  }
+}
+
+// chunks of whole dim4 entries are views
+void test_relu_dim4() {
+  uint32_t shape[] = {40, 2, 10, 20};
+  zdnn_ztensor *input =
+      alloc_ztensor_with_random_values(shape, ZDNN_NHWC, -2, 2);
+  zdnn_ztensor *whole = alloc_output_ztensor(shape, ZDNN_NHWC, FP32, NO_CONCAT);
+  zdnn_ztensor *chunked =
+      alloc_output_ztensor(shape, ZDNN_NHWC, FP32, NO_CONCAT);
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_relu(input, NULL, whole));
+  lower_nnpa_limits(8, 0, 0);
+  zdnn_status status = zdnn_relu(input, NULL, chunked);
+  restore_nnpa_limits();
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, status);
+  assert_same_cells(chunked, whole);
+  free_ztensor_buffers(3, input, whole, chunked);
+}
+
+// dim2 chunks of more than one dim1 stick are copied
+void test_add_dim2() {
+  uint32_t shape[] = {2, 3, 300, 100};
+  zdnn_ztensor *input_a =
+      alloc_ztensor_with_random_values(shape, ZDNN_NHWC, -2, 2);
+  zdnn_ztensor *input_b =
+      alloc_ztensor_with_random_values(shape, ZDNN_NHWC, -2, 2);
+  zdnn_ztensor *whole = alloc_output_ztensor(shape, ZDNN_NHWC, FP32, NO_CONCAT);
+  zdnn_ztensor *chunked =
+      alloc_output_ztensor(shape, ZDNN_NHWC, FP32, NO_CONCAT);
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_add(input_a, input_b, whole));
+  lower_nnpa_limits(0, 128, 0);
+  zdnn_status status = zdnn_add(input_a, input_b, chunked);
+  restore_nnpa_limits();
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, status);
+  assert_same_cells(chunked, whole);
+  free_ztensor_buffers(4, input_a, input_b, whole, chunked);
+}
+
+// the scale and bias are broadcast to every chunk
+void test_batchnorm_dim3() {
+  uint32_t shape[] = {2, 150, 9, 70};
+  uint32_t bc_shape[] = {70};
+  zdnn_ztensor *input_a =
+      alloc_ztensor_with_random_values(shape, ZDNN_NHWC, -2, 2);
+  zdnn_ztensor *input_b =
+      alloc_ztensor_with_random_values(bc_shape, ZDNN_1D, -2, 2);
+  zdnn_ztensor *input_c =
+      alloc_ztensor_with_random_values(bc_shape, ZDNN_1D, -2, 2);
+  zdnn_ztensor *whole = alloc_output_ztensor(shape, ZDNN_NHWC, FP32, NO_CONCAT);
+  zdnn_ztensor *chunked =
+      alloc_output_ztensor(shape, ZDNN_NHWC, FP32, NO_CONCAT);
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_batchnorm(input_a, input_b, input_c, whole));
+  lower_nnpa_limits(0, 80, 0);
+  zdnn_status status = zdnn_batchnorm(input_a, input_b, input_c, chunked);
+  restore_nnpa_limits();
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, status);
+  assert_same_cells(chunked, whole);
+  free_ztensor_buffers(5, input_a, input_b, input_c, whole, chunked);
+}
+
+// every row keeps all its cells
+void test_softmax_dim4() {
+  uint32_t shape[] = {100, 5, 70};
+  zdnn_ztensor *input =
+      alloc_ztensor_with_random_values(shape, ZDNN_3DS, -2, 2);
+  zdnn_ztensor *whole = alloc_output_ztensor(shape, ZDNN_3DS, FP32, NO_CONCAT);
+  zdnn_ztensor *chunked =
+      alloc_output_ztensor(shape, ZDNN_3DS, FP32, NO_CONCAT);
+
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_softmax(input, NULL, SOFTMAX_ACT_NONE, whole));
+  lower_nnpa_limits(16, 0, 0);
+  zdnn_status status = zdnn_softmax(input, NULL, SOFTMAX_ACT_NONE, chunked);
+  restore_nnpa_limits();
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, status);
+  assert_same_cells(chunked, whole);
+  free_ztensor_buffers(3, input, whole, chunked);
+}
+
+void test_layernorm_dim2() {
+  uint32_t shape[] = {1, 2, 200, 30};
+  uint32_t bc_shape[] = {1, 2, 200, 1};
+  zdnn_ztensor *input_a =
+      alloc_ztensor_with_random_values(shape, ZDNN_NHWC, -2, 2);
+  zdnn_ztensor *input_b =
+      alloc_ztensor_with_random_values(bc_shape, ZDNN_NHWC, -2, 2);
+  zdnn_ztensor *input_c =
+      alloc_ztensor_with_random_values(bc_shape, ZDNN_NHWC, -2, 2);
+  zdnn_ztensor *whole = alloc_output_ztensor(shape, ZDNN_NHWC, FP32, NO_CONCAT);
+  zdnn_ztensor *chunked =
+      alloc_output_ztensor(shape, ZDNN_NHWC, FP32, NO_CONCAT);
+
+  // variance can't be negative
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_mul(input_c, input_c, input_c));
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_layernorm(input_a, input_b, input_c, 0.5,
+                                            1.0, 0.01, whole));
+  lower_nnpa_limits(0, 64, 0);
+  zdnn_status status =
+      zdnn_layernorm(input_a, input_b, input_c, 0.5, 1.0, 0.01, chunked);
+  restore_nnpa_limits();
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, status);
+  assert_same_cells(chunked, whole);
+  free_ztensor_buffers(5, input_a, input_b, input_c, whole, chunked);
+}
+
+// chunks are cut down until they are within the maximum tensor size
+void test_reduce_mts() {
+  uint32_t in_shape[] = {4, 4, 40, 128};
+  uint32_t out_shape[] = {4, 4, 40, 1};
+  zdnn_ztensor *input =
+      alloc_ztensor_with_random_values(in_shape, ZDNN_NHWC, -2, 2);
+  zdnn_ztensor *whole =
+      alloc_output_ztensor(out_shape, ZDNN_NHWC, FP32, NO_CONCAT);
+  zdnn_ztensor *chunked =
+      alloc_output_ztensor(out_shape, ZDNN_NHWC, FP32, NO_CONCAT);
+
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_reduce(input, NULL, REDUCE_OP_MAXIMUM, whole));
+  lower_nnpa_limits(0, 0, 65536);
+  zdnn_status status = zdnn_reduce(input, NULL, REDUCE_OP_MAXIMUM, chunked);
+  restore_nnpa_limits();
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, status);
+  assert_same_cells(chunked, whole);
+  free_ztensor_buffers(3, input, whole, chunked);
+}
+
+// moments works across dim3 and dim2, so can't be chunked
+void test_moments_not_chunked() {
+  uint32_t shape[] = {2, 3, 300, 10};
+  uint32_t out_shape[] = {2, 1, 1, 1};
+  zdnn_ztensor *input =
+      alloc_ztensor_with_random_values(shape, ZDNN_NHWC, -2, 2);
+  zdnn_ztensor *output_a =
+      alloc_output_ztensor(out_shape, ZDNN_NHWC, FP32, NO_CONCAT);
+  zdnn_ztensor *output_b =
+      alloc_output_ztensor(out_shape, ZDNN_NHWC, FP32, NO_CONCAT);
+
+  lower_nnpa_limits(0, 64, 0);
+  zdnn_status status =
+      zdnn_moments(input, MOMENTS_BESSEL_POPULATION, output_a, output_b);
+  restore_nnpa_limits();
+
+  TEST_ASSERT_EQUAL(ZDNN_EXCEEDS_MDIS, status);
+  free_ztensor_buffers(3, input, output_a, output_b);
+}
+
+// rows are never split
+void test_add_dim1_not_chunked() {
+  uint32_t shape[] = {1, 1, 2, 300};
+  zdnn_ztensor *input_a =
+      alloc_ztensor_with_random_values(shape, ZDNN_NHWC, -2, 2);
+  zdnn_ztensor *input_b =
+      alloc_ztensor_with_random_values(shape, ZDNN_NHWC, -2, 2);
+  zdnn_ztensor *output =
+      alloc_output_ztensor(shape, ZDNN_NHWC, FP32, NO_CONCAT);
+
+  nnpa_query_result.max_dim1_index_size = 128;
+  zdnn_status status = zdnn_add(input_a, input_b, output);
+  restore_nnpa_limits();
+
+  TEST_ASSERT_EQUAL(ZDNN_EXCEEDS_MDIS, status);
+  free_ztensor_buffers(3, input_a, input_b, output);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_relu_dim4);
+  RUN_TEST(test_add_dim2);
+  RUN_TEST(test_batchnorm_dim3);
+  RUN_TEST(test_softmax_dim4);
+  RUN_TEST(test_layernorm_dim2);
+  RUN_TEST(test_reduce_mts);
+  RUN_TEST(test_moments_not_chunked);
+  RUN_TEST(test_add_dim1_not_chunked);
+
+  return UNITY_END();
+}
@@ -0,0 +1,263 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common_quantization.h"
+#include "testsupport.h"
+
+#define S 2
+#define M 5
+#define N 70
+#define P 40
+
+#define A_SCALE 0.70588235294f // (80.0 - -100.0) / 255.0
+#define A_OFFSET 14.f
+#define B_SCALE 0.15686274509f // (20.0 - -20.0) / 255.0, symmetric
+#define B_ASYM_OFFSET 12.f
+#define C_SCALE 0.4f
+#define C_OFFSET -3.f
+#define Y_SCALE 64.f
+#define Y_OFFSET 5.f
+
+static uint32_t input_shape[] = {S, M, N};
+static uint32_t weights_shape[] = {S, N, P};
+static uint32_t biases_shape[] = {S, P};
+static uint32_t out_shape[] = {S, M, P};
+
+static uint32_t saved_cache_entries;
+
+void setUp(void) {
+  VERIFY_HW_ENV;
+  VERIFY_PARMBLKFORMAT_1;
+  saved_cache_entries = qmatmul_bias_cache_entries;
+  zdnn_reset_quantized_bias_cache();
+}
+
+void tearDown(void) {
+  qmatmul_bias_cache_entries = saved_cache_entries;
+  zdnn_reset_quantized_bias_cache();
+}
+
+static zdnn_ztensor *alloc_input() {
+  float values[S * M * N];
+  gen_random_float_array_range(S * M * N, values, -100.f, 80.f);
+  return alloc_quantized_ztensor_with_values(input_shape, ZDNN_3DS, FP32,
+                                             QUANTIZED_INT8, values, A_SCALE,
+                                             A_OFFSET);
+}
+
+static zdnn_ztensor *alloc_weights(float offset) {
+  float values[S * N * P];
+  gen_random_float_array_range(S * N * P, values, -15.f, 15.f);
+  return alloc_quantized_ztensor_with_values(weights_shape, ZDNN_3DS, INT8,
+                                             QUANTIZED_WEIGHTS_INT8, values,
+                                             B_SCALE, offset);
+}
+
+static zdnn_ztensor *alloc_biases() {
+  float values[S * P];
+  gen_random_float_array_range(S * P, values, -40.f, 40.f);
+  return alloc_quantized_ztensor_with_values(biases_shape, ZDNN_2DS, FP32,
+                                             QUANTIZED_INT8, values, C_SCALE,
+                                             C_OFFSET);
+}
+
+static zdnn_ztensor *alloc_output() {
+  return alloc_quantized_ztensor_with_values(out_shape, ZDNN_3DS, FP32,
+                                             QUANTIZED_DLFLOAT16, NULL,
+                                             Y_SCALE, Y_OFFSET);
+}
+
+static void run_qmatmul(zdnn_ztensor *input, zdnn_ztensor *weights,
+                        zdnn_ztensor *biases, zdnn_matmul_ops op_type,
+                        zdnn_ztensor *out) {
+  memset(out->buffer, 0, out->buffer_size);
+  out->is_transformed = false;
+  zdnn_status status =
+      zdnn_quantized_matmul_op(input, weights, biases, op_type, INT8_MIN,
+                               INT8_MAX, false, false, false, NULL, out);
+  TEST_ASSERT_EQUAL_MESSAGE(ZDNN_OK, status,
+                            "zdnn_quantized_matmul_op() failed");
+}
+
+/// Run once without the cache to get the expected output, then with the cache
+/// enabled, twice so the second one reuses the cached bias
+static void assert_cached_same_as_uncached(zdnn_ztensor *input,
+                                           zdnn_ztensor *weights,
+                                           zdnn_ztensor *biases,
+                                           zdnn_matmul_ops op_type,
+                                           zdnn_ztensor *exp_out,
+                                           zdnn_ztensor *out) {
+  uint32_t entries = qmatmul_bias_cache_entries;
+
+  qmatmul_bias_cache_entries = 0;
+  run_qmatmul(input, weights, biases, op_type, exp_out);
+  qmatmul_bias_cache_entries = entries;
+
+  for (int i = 0; i < 2; i++) {
+    run_qmatmul(input, weights, biases, op_type, out);
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(exp_out->buffer, out->buffer,
+                                     out->buffer_size,
+                                     "output differs from uncached run");
+  }
+}
+
+// the bias is reused as long as the weights' buffer isn't transformed into,
+// even if its data changed behind the cache's back
+static void cache_hit(zdnn_matmul_ops op_type) {
+  qmatmul_bias_cache_entries = 4;
+
+  zdnn_ztensor *input = alloc_input();
+  zdnn_ztensor *weights = alloc_weights(0.f);
+  zdnn_ztensor *weights2 = alloc_weights(0.f);
+  zdnn_ztensor *biases = alloc_biases();
+  zdnn_ztensor *exp_out = alloc_output();
+  zdnn_ztensor *exp_out2 = alloc_output();
+  zdnn_ztensor *out = alloc_output();
+
+  assert_cached_same_as_uncached(input, weights, biases, op_type, exp_out,
+                                 out);
+
+  // expected output with the other weights, with the cache disabled
+  qmatmul_bias_cache_entries = 0;
+  run_qmatmul(input, weights2, biases, op_type, exp_out2);
+  qmatmul_bias_cache_entries = 4;
+
+  // overwrite the weights without telling anyone, the stale bias is used
+  memcpy(weights->buffer, weights2->buffer, weights->buffer_size);
+  run_qmatmul(input, weights, biases, op_type, out);
+  TEST_ASSERT_MESSAGE(
+      memcmp(exp_out2->buffer, out->buffer, out->buffer_size) != 0,
+      "cached bias wasn't used");
+
+  zdnn_reset_quantized_bias_cache();
+  run_qmatmul(input, weights, biases, op_type, out);
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(exp_out2->buffer, out->buffer,
+                                   out->buffer_size,
+                                   "output after reset differs");
+
+  free_ztensor_buffers(7, input, weights, weights2, biases, exp_out, exp_out2,
+                       out);
+}
+
+void test_cache_hit_folded() { cache_hit(MATMUL_OP_ADDITION); }
+
+void test_cache_hit_comparison() { cache_hit(MATMUL_OP_GREATER_EQUAL); }
+
+// transforming new data into the weights drops the cached bias
+void test_retransform_invalidates() {
+  qmatmul_bias_cache_entries = 4;
+
+  zdnn_ztensor *input = alloc_input();
+  zdnn_ztensor *weights = alloc_weights(0.f);
+  zdnn_ztensor *biases = alloc_biases();
+  zdnn_ztensor *exp_out = alloc_output();
+  zdnn_ztensor *out = alloc_output();
+
+  assert_cached_same_as_uncached(input, weights, biases, MATMUL_OP_ADDITION,
+                                 exp_out, out);
+
+  int8_t values[S * N * P];
+  for (int i = 0; i < S * N * P; i++) {
+    values[i] = (int8_t)(i % 61 - 30);
+  }
+  zdnn_reset_ztensor(weights);
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_quantized_ztensor(
+                                 weights, false, INT8_MIN, INT8_MAX, values));
+
+  assert_cached_same_as_uncached(input, weights, biases, MATMUL_OP_ADDITION,
+                                 exp_out, out);
+
+  free_ztensor_buffers(5, input, weights, biases, exp_out, out);
+}
+
+// a different quantization of the input or output needs another bias
+void test_scale_change_misses() {
+  qmatmul_bias_cache_entries = 4;
+
+  zdnn_ztensor *input = alloc_input();
+  zdnn_ztensor *weights = alloc_weights(0.f);
+  zdnn_ztensor *biases = alloc_biases();
+  zdnn_ztensor *exp_out = alloc_output();
+  zdnn_ztensor *out = alloc_output();
+
+  assert_cached_same_as_uncached(input, weights, biases, MATMUL_OP_ADDITION,
+                                 exp_out, out);
+
+  input->offset = A_OFFSET + 3.f;
+  assert_cached_same_as_uncached(input, weights, biases, MATMUL_OP_ADDITION,
+                                 exp_out, out);
+
+  exp_out->offset = Y_OFFSET - 2.f;
+  out->offset = Y_OFFSET - 2.f;
+  assert_cached_same_as_uncached(input, weights, biases, MATMUL_OP_ADDITION,
+                                 exp_out, out);
+
+  free_ztensor_buffers(5, input, weights, biases, exp_out, out);
+}
+
+// more layers than entries, the least recently used ones get recomputed
+void test_eviction() {
+  qmatmul_bias_cache_entries = 1;
+
+  zdnn_ztensor *input = alloc_input();
+  zdnn_ztensor *weights = alloc_weights(0.f);
+  zdnn_ztensor *weights2 = alloc_weights(0.f);
+  zdnn_ztensor *biases = alloc_biases();
+  zdnn_ztensor *exp_out = alloc_output();
+  zdnn_ztensor *out = alloc_output();
+
+  for (int i = 0; i < 3; i++) {
+    assert_cached_same_as_uncached(input, weights, biases, MATMUL_OP_ADDITION,
+                                   exp_out, out);
+    assert_cached_same_as_uncached(input, weights2, biases, MATMUL_OP_LESSER,
+                                   exp_out, out);
+  }
+
+  free_ztensor_buffers(6, input, weights, weights2, biases, exp_out, out);
+}
+
+// asymmetric weights need the correction term, the bias isn't folded or cached
+void test_asymmetric_weights() {
+  qmatmul_bias_cache_entries = 4;
+
+  zdnn_ztensor *input = alloc_input();
+  zdnn_ztensor *weights = alloc_weights(B_ASYM_OFFSET);
+  zdnn_ztensor *biases = alloc_biases();
+  zdnn_ztensor *exp_out = alloc_output();
+  zdnn_ztensor *out = alloc_output();
+
+  assert_cached_same_as_uncached(input, weights, biases, MATMUL_OP_ADDITION,
+                                 exp_out, out);
+
+  free_ztensor_buffers(5, input, weights, biases, exp_out, out);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_cache_hit_folded);
+  RUN_TEST(test_cache_hit_comparison);
+  RUN_TEST(test_retransform_invalidates);
+  RUN_TEST(test_scale_change_misses);
+  RUN_TEST(test_eviction);
+  RUN_TEST(test_asymmetric_weights);
+
+  return UNITY_END();
+}
@@ -1272,6 +1272,102 @@ void quantized_matmul_biasadd_on_the_fly_2x20x40_by_40x30() {
                              pre_compute);
 }
 
+/**
+ * - Quantized MatMul BiasAdd, one thread vs. several
+ *
+ * The correction term and the output are processed on the host in chunks spread
+ * across threads. Every element is computed in the same order either way, so
+ * the outputs must be identical. Shapes are large enough for several chunks.
+ */
+void quantized_matmul_threads_match(bool stacked_a, bool stacked_b,
+                                    bool on_the_fly, bool dequantize) {
+  const uint32_t s = 2, m = 200, n = 256, p = 200;
+
+  uint32_t input_a_shape[] = {s, m, n};
+  uint32_t input_b_shape[] = {s, n, p};
+  uint32_t input_c_shape[] = {s, p};
+  uint32_t output_shape[] = {s, m, p};
+
+  // unstacked tensors drop the s dimension
+  uint32_t *a_shape = stacked_a ? input_a_shape : input_a_shape + 1;
+  uint32_t *b_shape = stacked_b ? input_b_shape : input_b_shape + 1;
+  uint32_t *c_shape = stacked_b ? input_c_shape : input_c_shape + 1;
+
+  float *input_a_values = malloc(s * m * n * sizeof(float));
+  float *input_b_values = malloc(s * n * p * sizeof(float));
+  float *input_c_values = malloc(s * p * sizeof(float));
+  gen_random_float_array_range(s * m * n, input_a_values, -100.f, 80.f);
+  gen_random_float_array_range(s * n * p, input_b_values, -20.f, 10.f);
+  gen_random_float_array_range(s * p, input_c_values, -500.f, 500.f);
+
+  float a_scale, a_offset, b_scale, b_offset, c_scale, c_offset, y_scale,
+      y_offset;
+  gen_scale_and_offset(-100.f, 80.f, &a_scale, &a_offset);
+  gen_scale_and_offset(-20.f, 10.f, &b_scale, &b_offset);
+  gen_scale_and_offset(-500.f, 500.f, &c_scale, &c_offset);
+  gen_scale_and_offset(-20000.f, 20000.f, &y_scale, &y_offset);
+
+  zdnn_ztensor *input_a;
+  if (on_the_fly) {
+    input_a = alloc_ztensor_with_values(a_shape, stacked_a ? ZDNN_3DS : ZDNN_2D,
+                                        FP32, NO_CONCAT, false, input_a_values);
+    input_a->rec_scale = 1.f / a_scale;
+    input_a->offset = a_offset;
+  } else {
+    input_a = alloc_quantized_ztensor_with_values(
+        a_shape, stacked_a ? ZDNN_3DS : ZDNN_2D, FP32, QUANTIZED_INT8,
+        input_a_values, a_scale, a_offset);
+  }
+  zdnn_ztensor *input_b = alloc_quantized_ztensor_with_values(
+      b_shape, stacked_b ? ZDNN_3DS : ZDNN_2D, INT8, QUANTIZED_WEIGHTS_INT8,
+      input_b_values, b_scale, b_offset);
+  zdnn_ztensor *input_c = alloc_quantized_ztensor_with_values(
+      c_shape, stacked_b ? ZDNN_2DS : ZDNN_1D, FP32, QUANTIZED_INT8,
+      input_c_values, c_scale, c_offset);
+
+  zdnn_ztensor *outputs[2];
+  uint32_t saved_max_threads = zdnn_get_max_threads();
+
+  for (int i = 0; i < 2; i++) {
+    outputs[i] = alloc_quantized_ztensor_with_values(
+        output_shape, ZDNN_3DS, FP32, QUANTIZED_DLFLOAT16, NULL, y_scale,
+        y_offset);
+    memset(outputs[i]->buffer, 0, outputs[i]->buffer_size);
+
+    zdnn_set_max_threads(i ? 4 : 1);
+    zdnn_status status = zdnn_quantized_matmul_op(
+        input_a, input_b, input_c, MATMUL_OP_ADDITION, INT8_MIN, INT8_MAX,
+        false, dequantize, false, NULL, outputs[i]);
+    TEST_ASSERT_MESSAGE_FORMATTED(
+        status == ZDNN_OK,
+        "call to zdnn_quantized_matmul_op() with %u threads returned status "
+        "%08x \"%s\"",
+        zdnn_get_max_threads(), status, zdnn_get_status_message(status));
+  }
+  zdnn_set_max_threads(saved_max_threads);
+
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(outputs[0]->buffer, outputs[1]->buffer,
+                                   outputs[0]->buffer_size,
+                                   "multi-threaded output differs");
+
+  free(input_a_values);
+  free(input_b_values);
+  free(input_c_values);
+  free_ztensor_buffers(5, input_a, input_b, input_c, outputs[0], outputs[1]);
+}
+
+void quantized_matmul_biasadd_threads_match() {
+  quantized_matmul_threads_match(true, true, false, false);
+}
+
+void quantized_matmul_biasadd_bcast1_threads_match() {
+  quantized_matmul_threads_match(false, true, false, true);
+}
+
+void quantized_matmul_biasadd_on_the_fly_bcast23_threads_match() {
+  quantized_matmul_threads_match(true, false, true, false);
+}
+
 /******************************************************************************
                               Compare Tests
 ******************************************************************************/
@@ -3839,6 +3935,10 @@ int main() {
   RUN_TEST(quantized_matmul_biasadd_on_the_fly_20x40_by_2x40x30);
   RUN_TEST(quantized_matmul_biasadd_on_the_fly_2x20x40_by_40x30);
 
+  RUN_TEST(quantized_matmul_biasadd_threads_match);
+  RUN_TEST(quantized_matmul_biasadd_bcast1_threads_match);
+  RUN_TEST(quantized_matmul_biasadd_on_the_fly_bcast23_threads_match);
+
   // Compare tests (always symmetric weights)
   RUN_TEST(quantized_matmul_greater_basic);
   RUN_TEST(quantized_matmul_greater_bcast1_basic);
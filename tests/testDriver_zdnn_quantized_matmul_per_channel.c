@@ -0,0 +1,329 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common_quantization.h"
+#include "testsupport.h"
+
+#define S 2
+#define M 5
+#define N 70
+#define P 90 // more than one dlfloat16 stick
+
+#define A_MIN -100.f
+#define A_MAX 80.f
+#define C_MIN -50.f
+#define C_MAX 50.f
+
+void setUp(void) {
+  VERIFY_HW_ENV;
+  VERIFY_PARMBLKFORMAT_1;
+}
+
+void tearDown(void) {}
+
+static void gen_scale_and_offset(float min, float max, float *scale,
+                                 float *offset) {
+  *scale = (max - min) / 255.f;
+  *offset = roundf(-128.f - min / *scale);
+}
+
+/// Weights whose output channels span very different ranges, quantized per
+/// channel.  Symmetric channels get a 0 offset.
+typedef struct channel_weights {
+  float values[S * N * P]; // dequantized back from int8
+  int8_t quantized[S * N * P];
+  float scales[P];
+  float offsets[P];
+} channel_weights;
+
+// the widest channel is j = 25, the last one is close to it unless
+// narrow_last gives it the narrowest range of all
+static void gen_channel_weights(bool asymmetric, bool narrow_last,
+                                channel_weights *w) {
+  for (uint32_t j = 0; j < P; j++) {
+    float max = (narrow_last && j == P - 1)
+                    ? 0.01f
+                    : 0.05f * (float)(1 + j % 13) * (j % 2 ? 20.f : 1.f);
+    float min = asymmetric ? -max / 2.f : -max;
+    if (asymmetric) {
+      gen_scale_and_offset(min, max, &w->scales[j], &w->offsets[j]);
+    } else {
+      w->scales[j] = max / 127.f;
+      w->offsets[j] = 0.f;
+    }
+
+    for (uint32_t i = 0; i < S * N; i++) {
+      float r;
+      gen_random_float_array_range(1, &r, min, max);
+      uint64_t idx = (uint64_t)i * P + j;
+      w->quantized[idx] = (int8_t)QUANTIZE(r, w->scales[j], w->offsets[j]);
+      w->values[idx] =
+          DEQUANTIZE((float)w->quantized[idx], w->scales[j], w->offsets[j]);
+    }
+  }
+}
+
+/// Allocates a transformed weights ztensor for w, with the per-channel scales
+/// and offsets attached
+static zdnn_ztensor *alloc_channel_weights(channel_weights *w, bool stacked,
+                                           bool with_offsets) {
+  uint32_t shape[] = {S, N, P};
+
+  zdnn_tensor_desc *pre_tfrmd_desc = malloc(sizeof(zdnn_tensor_desc));
+  zdnn_tensor_desc *tfrmd_desc = malloc(sizeof(zdnn_tensor_desc));
+  if (stacked) {
+    zdnn_init_pre_transformed_desc(ZDNN_3DS, INT8, pre_tfrmd_desc, shape[0],
+                                   shape[1], shape[2]);
+  } else {
+    zdnn_init_pre_transformed_desc(ZDNN_2D, INT8, pre_tfrmd_desc, shape[1],
+                                   shape[2]);
+  }
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_generate_quantized_transformed_desc(
+                                 pre_tfrmd_desc, QUANTIZED_WEIGHTS_INT8,
+                                 tfrmd_desc));
+
+  zdnn_ztensor *ztensor = malloc(sizeof(zdnn_ztensor));
+  zdnn_init_per_channel_quantized_ztensor(pre_tfrmd_desc, tfrmd_desc, 1.f, 0.f,
+                                          w->scales,
+                                          with_offsets ? w->offsets : NULL,
+                                          ztensor);
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_allochelper_ztensor(ztensor));
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_transform_quantized_ztensor(
+                        ztensor, false, INT8_MIN, INT8_MAX, w->quantized));
+  return ztensor;
+}
+
+/// Computes the expected quantized output from the dequantized inputs, along
+/// with an output scale and offset that cover its range
+static void gen_expected(const float *a, const channel_weights *w,
+                         bool stacked_b, const float *c, float Sa, float Za,
+                         float Sc, float Zc, float *result, float *Sy,
+                         float *Zy) {
+  float min_result = FLT_MAX;
+  float max_result = -FLT_MAX;
+
+  for (uint32_t i = 0; i < S; i++) {
+    uint32_t b_i = stacked_b ? i : 0;
+    for (uint32_t j = 0; j < M; j++) {
+      for (uint32_t k = 0; k < P; k++) {
+        uint64_t result_idx = GET_FLAT_IDX(i, j, k, M, P);
+
+        result[result_idx] =
+            CLEANSE_QUANTIZED(c[GET_FLAT_IDX(b_i, 0, k, 1, P)], Sc, Zc);
+
+        for (uint32_t l = 0; l < N; l++) {
+          result[result_idx] +=
+              CLEANSE_QUANTIZED(a[GET_FLAT_IDX(i, j, l, M, N)], Sa, Za) *
+              w->values[GET_FLAT_IDX(b_i, l, k, N, P)];
+        }
+
+        min_result = MIN(min_result, result[result_idx]);
+        max_result = MAX(max_result, result[result_idx]);
+      }
+    }
+  }
+
+  gen_scale_and_offset(min_result, max_result, Sy, Zy);
+
+  for (uint64_t i = 0; i < S * M * P; i++) {
+    result[i] = QUANTIZE(result[i], *Sy, *Zy);
+  }
+}
+
+/// Runs quantized matmul with per-channel weights and checks every quantized
+/// output value is within 1 of the expected one
+static void per_channel_test(bool asymmetric, bool narrow_last,
+                             bool with_offsets, bool on_the_fly,
+                             bool stacked_b) {
+  uint32_t a_shape[] = {S, M, N};
+  uint32_t c_shape[] = {S, P};
+  uint32_t y_shape[] = {S, M, P};
+
+  float *a_values = malloc(S * M * N * sizeof(float));
+  float c_values[S * P];
+  gen_random_float_array_range(S * M * N, a_values, A_MIN, A_MAX);
+  gen_random_float_array_range(S * P, c_values, C_MIN, C_MAX);
+
+  float a_scale, a_offset, c_scale, c_offset, y_scale, y_offset;
+  gen_scale_and_offset(A_MIN, A_MAX, &a_scale, &a_offset);
+  gen_scale_and_offset(C_MIN, C_MAX, &c_scale, &c_offset);
+
+  channel_weights *w = malloc(sizeof(channel_weights));
+  gen_channel_weights(asymmetric, narrow_last, w);
+
+  float *expected = malloc(S * M * P * sizeof(float));
+  gen_expected(a_values, w, stacked_b, c_values, a_scale, a_offset, c_scale,
+               c_offset, expected, &y_scale, &y_offset);
+
+  zdnn_ztensor *input_a;
+  if (on_the_fly) {
+    input_a = alloc_ztensor_with_values(a_shape, ZDNN_3DS, FP32, NO_CONCAT,
+                                        false, a_values);
+    input_a->rec_scale = 1.f / a_scale;
+    input_a->offset = a_offset;
+  } else {
+    input_a = alloc_quantized_ztensor_with_values(a_shape, ZDNN_3DS, FP32,
+                                                  QUANTIZED_INT8, a_values,
+                                                  a_scale, a_offset);
+  }
+  zdnn_ztensor *input_b = alloc_channel_weights(w, stacked_b, with_offsets);
+  zdnn_ztensor *input_c = alloc_quantized_ztensor_with_values(
+      stacked_b ? c_shape : c_shape + 1, stacked_b ? ZDNN_2DS : ZDNN_1D, FP32,
+      QUANTIZED_INT8, c_values, c_scale, c_offset);
+  zdnn_ztensor *output = alloc_quantized_ztensor_with_values(
+      y_shape, ZDNN_3DS, FP32, QUANTIZED_DLFLOAT16, NULL, y_scale, y_offset);
+
+  zdnn_status status = zdnn_quantized_matmul_op(
+      input_a, input_b, input_c, MATMUL_OP_ADDITION, INT8_MIN, INT8_MAX, false,
+      false, false, NULL, output);
+  TEST_ASSERT_MESSAGE_FORMATTED(
+      status == ZDNN_OK,
+      "call to zdnn_quantized_matmul_op() returned status %08x \"%s\"", status,
+      zdnn_get_status_message(status));
+
+  float *actual = malloc(S * M * P * sizeof(float));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_origtensor(output, actual));
+  for (uint64_t i = 0; i < S * M * P; i++) {
+    TEST_ASSERT_MESSAGE_FORMATTED(fabsf(actual[i] - expected[i]) <= 1.f,
+                                  "element %" PRIu64 " is %f, expected %f", i,
+                                  actual[i], expected[i]);
+  }
+
+  free(a_values);
+  free(w);
+  free(expected);
+  free(actual);
+  free_ztensor_buffers(4, input_a, input_b, input_c, output);
+}
+
+void test_symmetric() { per_channel_test(false, false, true, false, true); }
+
+// NULL channel_offsets uses the per-tensor offset, 0 here
+void test_symmetric_scales_only() {
+  per_channel_test(false, false, false, false, true);
+}
+
+void test_asymmetric() { per_channel_test(true, false, true, false, true); }
+
+void test_asymmetric_bcast23() {
+  per_channel_test(true, false, true, false, false);
+}
+
+void test_symmetric_on_the_fly() {
+  per_channel_test(false, false, true, true, true);
+}
+
+void test_asymmetric_on_the_fly() {
+  per_channel_test(true, false, true, true, true);
+}
+
+// the widest channel, which the others are scaled against, isn't the last one
+void test_symmetric_narrow_last() {
+  per_channel_test(false, true, true, false, true);
+}
+
+void test_asymmetric_narrow_last() {
+  per_channel_test(true, true, true, false, true);
+}
+
+/// Calls quantized matmul with per-channel weights and expects exp_status.
+/// The weights' vectors are left in place but ignored when !is_per_channel.
+static void per_channel_status_test(zdnn_matmul_ops op_type,
+                                    bool pre_computed, float channel_scale,
+                                    bool is_per_channel,
+                                    zdnn_status exp_status) {
+  uint32_t a_shape[] = {S, M, N};
+  uint32_t c_shape[] = {S, P};
+  uint32_t y_shape[] = {S, M, P};
+
+  float a_values[S * M * N] = {0};
+  float c_values[S * P] = {0};
+
+  channel_weights *w = malloc(sizeof(channel_weights));
+  gen_channel_weights(false, false, w);
+  w->scales[P / 2] = channel_scale;
+
+  zdnn_ztensor *input_a = alloc_quantized_ztensor_with_values(
+      a_shape, ZDNN_3DS, FP32, QUANTIZED_INT8, a_values, 1.f, 0.f);
+  zdnn_ztensor *input_b = alloc_channel_weights(w, true, true);
+  input_b->is_per_channel = is_per_channel;
+  zdnn_ztensor *input_c = alloc_quantized_ztensor_with_values(
+      c_shape, ZDNN_2DS, FP32,
+      pre_computed ? QUANTIZED_DLFLOAT16 : QUANTIZED_INT8, c_values, 1.f, 0.f);
+  zdnn_ztensor *output = alloc_quantized_ztensor_with_values(
+      y_shape, ZDNN_3DS, FP32, QUANTIZED_DLFLOAT16, NULL, 1.f, 0.f);
+
+  zdnn_status status =
+      zdnn_quantized_matmul_op(input_a, input_b, input_c, op_type, INT8_MIN,
+                               INT8_MAX, false, false, pre_computed, NULL,
+                               output);
+  TEST_ASSERT_MESSAGE_FORMATTED(
+      status == exp_status,
+      "call to zdnn_quantized_matmul_op() returned status %08x \"%s\" but "
+      "expected %08x \"%s\"",
+      status, zdnn_get_status_message(status), exp_status,
+      zdnn_get_status_message(exp_status));
+
+  free(w);
+  free_ztensor_buffers(4, input_a, input_b, input_c, output);
+}
+
+void test_zero_channel_scale() {
+  per_channel_status_test(MATMUL_OP_ADDITION, false, 0.f, true,
+                          ZDNN_INVALID_SCALE);
+}
+
+// channel vectors are only read from weights marked as quantized per channel
+void test_not_per_channel() {
+  per_channel_status_test(MATMUL_OP_ADDITION, false, 0.f, false, ZDNN_OK);
+  per_channel_status_test(MATMUL_OP_GREATER, false, 0.1f, false, ZDNN_OK);
+}
+
+void test_comparison_op() {
+  per_channel_status_test(MATMUL_OP_GREATER, false, 0.1f, true,
+                          ZDNN_INVALID_SCALE);
+}
+
+void test_pre_computed() {
+  per_channel_status_test(MATMUL_OP_ADDITION, true, 0.1f, true,
+                          ZDNN_INVALID_SCALE);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_symmetric);
+  RUN_TEST(test_symmetric_scales_only);
+  RUN_TEST(test_asymmetric);
+  RUN_TEST(test_asymmetric_bcast23);
+  RUN_TEST(test_symmetric_on_the_fly);
+  RUN_TEST(test_asymmetric_on_the_fly);
+  RUN_TEST(test_symmetric_narrow_last);
+  RUN_TEST(test_asymmetric_narrow_last);
+  RUN_TEST(test_zero_channel_scale);
+  RUN_TEST(test_comparison_op);
+  RUN_TEST(test_pre_computed);
+  RUN_TEST(test_not_per_channel);
+
+  return UNITY_END();
+}
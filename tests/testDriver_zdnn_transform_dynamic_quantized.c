@@ -0,0 +1,224 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "testsupport.h"
+
+#define TEST_THREADS 4
+
+static uint32_t saved_max_threads;
+
+void setUp(void) {
+  VERIFY_HW_ENV;
+  VERIFY_PARMBLKFORMAT_1;
+  saved_max_threads = zdnn_get_max_threads();
+}
+
+void tearDown(void) { zdnn_set_max_threads(saved_max_threads); }
+
+/// Initialize a 3DS quantized zTensor of test_datatype with a zeroed buffer
+static void init_quantized_ztensor(uint32_t *shape,
+                                   zdnn_quantized_transform_types type,
+                                   float scale, float offset,
+                                   zdnn_tensor_desc *pre_tfrmd_desc,
+                                   zdnn_tensor_desc *tfrmd_desc,
+                                   zdnn_ztensor *ztensor) {
+  zdnn_init_pre_transformed_desc(ZDNN_3DS, test_datatype, pre_tfrmd_desc,
+                                 shape[0], shape[1], shape[2]);
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_generate_quantized_transformed_desc(
+                                 pre_tfrmd_desc, type, tfrmd_desc));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_init_quantized_ztensor_with_malloc(
+                                 pre_tfrmd_desc, tfrmd_desc, scale, offset,
+                                 ztensor));
+  memset(ztensor->buffer, 0, ztensor->buffer_size);
+}
+
+/// Quantize values dynamically, check the scale and offset against the range
+/// of the values and the stick area against a static transform that uses the
+/// scale and offset found
+static void dynamic_quantized_test(uint32_t *shape,
+                                   zdnn_quantized_transform_types type,
+                                   const float *values) {
+  uint64_t num_elements = (uint64_t)shape[0] * shape[1] * shape[2];
+  void *data = alloc_and_convert_float_values(test_datatype, num_elements,
+                                              false, values);
+
+  zdnn_tensor_desc pre_tfrmd_desc, tfrmd_desc;
+  zdnn_ztensor ztensor;
+  init_quantized_ztensor(shape, type, 1.f, 0.f, &pre_tfrmd_desc, &tfrmd_desc,
+                         &ztensor);
+
+  zdnn_status status = zdnn_transform_dynamic_quantized_ztensor(
+      &ztensor, false, INT8_MIN, INT8_MAX, data);
+  TEST_ASSERT_MESSAGE_FORMATTED(
+      status == ZDNN_OK,
+      "call to zdnn_transform_dynamic_quantized_ztensor() returned status "
+      "%08x \"%s\"",
+      status, zdnn_get_status_message(status));
+  TEST_ASSERT_TRUE(ztensor.is_transformed);
+
+  float min = 0.f, max = 0.f;
+  for (uint64_t i = 0; i < num_elements; i++) {
+    min = MIN(min, values[i]);
+    max = MAX(max, values[i]);
+  }
+
+  // FP16 and BFLOAT data, and DLFLOAT16 sticks, carry less precision than the
+  // FP32 values the expected range comes from
+  float tolerance = (test_datatype == FP32 && type == QUANTIZED_INT8) ? 1e-5f
+                                                                      : 1e-2f;
+  float exp_scale = 1.f, exp_offset = 0.f;
+  if (max - min != 0.f) {
+    exp_scale = (max - min) / 255.f;
+    exp_offset = roundf(-128.f - min / exp_scale);
+  }
+
+  float scale = 1.f / ztensor.rec_scale;
+  TEST_ASSERT_MESSAGE_FORMATTED(
+      fabsf(scale - exp_scale) <= exp_scale * tolerance,
+      "scale is %f, expected %f", scale, exp_scale);
+  TEST_ASSERT_MESSAGE_FORMATTED(fabsf(ztensor.offset - exp_offset) <= 1.f,
+                                "offset is %f, expected %f", ztensor.offset,
+                                exp_offset);
+
+  // same stick area as a static transform with the scale and offset found
+  zdnn_tensor_desc exp_pre_tfrmd_desc, exp_tfrmd_desc;
+  zdnn_ztensor exp_ztensor;
+  init_quantized_ztensor(shape, type, 1.f, ztensor.offset, &exp_pre_tfrmd_desc,
+                         &exp_tfrmd_desc, &exp_ztensor);
+  exp_ztensor.rec_scale = ztensor.rec_scale;
+
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_transform_quantized_ztensor(&exp_ztensor, false,
+                                                     INT8_MIN, INT8_MAX, data));
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(exp_ztensor.buffer, ztensor.buffer,
+                                   ztensor.buffer_size,
+                                   "stick area differs from static transform");
+
+  free(data);
+  zdnn_free_ztensor_buffer(&ztensor);
+  zdnn_free_ztensor_buffer(&exp_ztensor);
+}
+
+static void dynamic_quantized_random_test(uint32_t *shape,
+                                          zdnn_quantized_transform_types type,
+                                          float min, float max) {
+  uint64_t num_elements = (uint64_t)shape[0] * shape[1] * shape[2];
+  float *values = malloc(num_elements * sizeof(float));
+  gen_random_float_array_range(num_elements, values, min, max);
+  dynamic_quantized_test(shape, type, values);
+  free(values);
+}
+
+void int8_basic() {
+  uint32_t shape[] = {2, 5, 70};
+  dynamic_quantized_random_test(shape, QUANTIZED_INT8, -100.f, 80.f);
+}
+
+// several chunks reduced on several threads
+void int8_large() {
+  uint32_t shape[] = {2, 300, 250};
+  zdnn_set_max_threads(TEST_THREADS);
+  dynamic_quantized_random_test(shape, QUANTIZED_INT8, -3.f, 20.f);
+}
+
+// several chunks reduced inline on the calling thread, with positive values so
+// a chunk whose range was never found can't hide behind the overall range
+void int8_large_single_thread() {
+  uint32_t shape[] = {2, 300, 250};
+  zdnn_set_max_threads(1);
+  dynamic_quantized_random_test(shape, QUANTIZED_INT8, 1.f, 1.6f);
+}
+
+// the range always includes 0, so positive values start at INT8_MIN
+void int8_positive() {
+  uint32_t shape[] = {1, 7, 33};
+  dynamic_quantized_random_test(shape, QUANTIZED_INT8, 2.f, 9.f);
+}
+
+void int8_zeros() {
+  uint32_t shape[] = {1, 3, 40};
+  float values[1 * 3 * 40] = {0};
+  dynamic_quantized_test(shape, QUANTIZED_INT8, values);
+}
+
+void dlfloat16_basic() {
+  uint32_t shape[] = {2, 5, 70};
+  dynamic_quantized_random_test(shape, QUANTIZED_DLFLOAT16, -100.f, 80.f);
+}
+
+void dlfloat16_large() {
+  uint32_t shape[] = {2, 300, 250};
+  zdnn_set_max_threads(TEST_THREADS);
+  dynamic_quantized_random_test(shape, QUANTIZED_DLFLOAT16, -3.f, 20.f);
+}
+
+// INT8 data is already quantized
+void invalid_pre_tfrmd_type() {
+  uint32_t shape[] = {1, 3, 40};
+  zdnn_tensor_desc pre_tfrmd_desc, tfrmd_desc;
+  zdnn_ztensor ztensor;
+  int8_t data[1 * 3 * 40] = {0};
+
+  test_datatype = INT8;
+  init_quantized_ztensor(shape, QUANTIZED_INT8, 1.f, 0.f, &pre_tfrmd_desc,
+                         &tfrmd_desc, &ztensor);
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_TYPE,
+                    zdnn_transform_dynamic_quantized_ztensor(
+                        &ztensor, false, INT8_MIN, INT8_MAX, data));
+  TEST_ASSERT_EQUAL_FLOAT(1.f, ztensor.rec_scale);
+  TEST_ASSERT_EQUAL_FLOAT(0.f, ztensor.offset);
+  zdnn_free_ztensor_buffer(&ztensor);
+}
+
+void already_transformed() {
+  uint32_t shape[] = {1, 3, 40};
+  zdnn_tensor_desc pre_tfrmd_desc, tfrmd_desc;
+  zdnn_ztensor ztensor;
+  float data[1 * 3 * 40] = {0};
+
+  test_datatype = FP32;
+  init_quantized_ztensor(shape, QUANTIZED_INT8, 1.f, 0.f, &pre_tfrmd_desc,
+                         &tfrmd_desc, &ztensor);
+  ztensor.is_transformed = true;
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE,
+                    zdnn_transform_dynamic_quantized_ztensor(
+                        &ztensor, false, INT8_MIN, INT8_MAX, data));
+  // a failed transform keeps the scale and offset the ztensor had
+  TEST_ASSERT_EQUAL_FLOAT(1.f, ztensor.rec_scale);
+  TEST_ASSERT_EQUAL_FLOAT(0.f, ztensor.offset);
+  zdnn_free_ztensor_buffer(&ztensor);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(int8_basic);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(int8_large);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(int8_large_single_thread);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(int8_positive);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(int8_zeros);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(dlfloat16_basic);
+  RUN_TEST_ALL_DLFLOAT16_PRE_DATATYPES(dlfloat16_large);
+  RUN_TEST(invalid_pre_tfrmd_type);
+  RUN_TEST(already_transformed);
+
+  return UNITY_END();
+}
@@ -0,0 +1,286 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "testsupport.h"
+
+#define NUM_TENSORS 3
+#define CHANNELS 40
+
+static char path[64];
+
+static float channel_scales[CHANNELS];
+static float channel_offsets[CHANNELS];
+
+void setUp(void) {
+  VERIFY_HW_ENV;
+  snprintf(path, sizeof(path), "ztensor_file_%d.zt", (int)getpid());
+}
+
+void tearDown(void) { remove(path); }
+
+/// An FP32 3DS ztensor, LSTM weights concatenated per gate, and INT8 weights
+/// with per-channel scales and offsets, all transformed
+static void alloc_test_ztensors(zdnn_ztensor **ztensors) {
+  uint32_t shape_3ds[] = {2, 5, 70};
+  uint32_t num_3ds = 2 * 5 * 70;
+  float values_3ds[num_3ds];
+  gen_random_float_array(num_3ds, values_3ds);
+  ztensors[0] = alloc_ztensor_with_values(shape_3ds, ZDNN_3DS, FP32, NO_CONCAT,
+                                          false, values_3ds);
+
+  uint32_t shape_fico[] = {1, 9, 7};
+  uint32_t num_fico = 9 * 7;
+  float f[num_fico], i[num_fico], c[num_fico], o[num_fico];
+  gen_random_float_array(num_fico, f);
+  gen_random_float_array(num_fico, i);
+  gen_random_float_array(num_fico, c);
+  gen_random_float_array(num_fico, o);
+  ztensors[1] = alloc_ztensor_with_values(
+      shape_fico, ZDNN_3DS, FP32,
+      RNN_TYPE_LSTM | PREV_LAYER_UNI | USAGE_WEIGHTS, false, f, i, c, o);
+
+  zdnn_tensor_desc *pre_tfrmd_desc = malloc(sizeof(zdnn_tensor_desc));
+  zdnn_tensor_desc *tfrmd_desc = malloc(sizeof(zdnn_tensor_desc));
+  zdnn_init_pre_transformed_desc(ZDNN_2D, INT8, pre_tfrmd_desc, 30, CHANNELS);
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_generate_quantized_transformed_desc(
+                                 pre_tfrmd_desc, QUANTIZED_WEIGHTS_INT8,
+                                 tfrmd_desc));
+  ztensors[2] = malloc(sizeof(zdnn_ztensor));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_init_quantized_ztensor_with_malloc(
+                                 pre_tfrmd_desc, tfrmd_desc, 0.5f, 3.f,
+                                 ztensors[2]));
+  // transform loads the last group of entries as a full vector, so leave
+  // some slack past the end of the values
+  int8_t values_int8[30 * CHANNELS + 16];
+  for (int k = 0; k < 30 * CHANNELS; k++) {
+    values_int8[k] = (int8_t)(k % 251 - 125);
+  }
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_transform_quantized_ztensor(
+                        ztensors[2], false, INT8_MIN, INT8_MAX, values_int8));
+  for (int k = 0; k < CHANNELS; k++) {
+    channel_scales[k] = 0.01f * (float)(k + 1);
+    channel_offsets[k] = (float)(k % 5);
+  }
+  ztensors[2]->is_per_channel = true;
+  ztensors[2]->channel_scales = channel_scales;
+  ztensors[2]->channel_offsets = channel_offsets;
+}
+
+static void save_test_ztensors(zdnn_ztensor **ztensors) {
+  zdnn_status status = zdnn_save_ztensors(
+      path, (const zdnn_ztensor *const *)ztensors, NUM_TENSORS);
+  TEST_ASSERT_MESSAGE_FORMATTED(
+      status == ZDNN_OK, "zdnn_save_ztensors() returned status %08x \"%s\"",
+      status, zdnn_get_status_message(status));
+}
+
+static void assert_same_ztensor(const zdnn_ztensor *exp,
+                                const zdnn_ztensor *act, uint32_t index) {
+  TEST_ASSERT_NOT_NULL(act);
+  TEST_ASSERT_MESSAGE_FORMATTED(act->is_transformed,
+                                "ztensor %u isn't transformed", index);
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(exp->pre_transformed_desc,
+                                   act->pre_transformed_desc,
+                                   sizeof(zdnn_tensor_desc),
+                                   "pre-transformed descriptor differs");
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(exp->transformed_desc,
+                                   act->transformed_desc,
+                                   sizeof(zdnn_tensor_desc),
+                                   "transformed descriptor differs");
+  TEST_ASSERT_EQUAL_UINT64(zdnn_getsize_ztensor(exp->transformed_desc),
+                           act->buffer_size);
+  TEST_ASSERT_MESSAGE_FORMATTED(
+      ((uintptr_t)act->buffer & (AIU_PAGESIZE_IN_BYTES - 1)) == 0,
+      "ztensor %u buffer %p isn't 4k aligned", index, act->buffer);
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(exp->buffer, act->buffer, act->buffer_size,
+                                   "stick area differs");
+  TEST_ASSERT_EQUAL_FLOAT(exp->rec_scale, act->rec_scale);
+  TEST_ASSERT_EQUAL_FLOAT(exp->offset, act->offset);
+
+  uint32_t channels = exp->transformed_desc->dim1;
+  TEST_ASSERT_EQUAL(exp->is_per_channel, act->is_per_channel);
+  if (exp->channel_scales) {
+    TEST_ASSERT_NOT_NULL(act->channel_scales);
+    TEST_ASSERT_EQUAL_MEMORY(exp->channel_scales, act->channel_scales,
+                             channels * sizeof(float));
+  } else {
+    TEST_ASSERT_NULL(act->channel_scales);
+  }
+  if (exp->channel_offsets) {
+    TEST_ASSERT_NOT_NULL(act->channel_offsets);
+    TEST_ASSERT_EQUAL_MEMORY(exp->channel_offsets, act->channel_offsets,
+                             channels * sizeof(float));
+  } else {
+    TEST_ASSERT_NULL(act->channel_offsets);
+  }
+}
+
+void test_round_trip() {
+  zdnn_ztensor *ztensors[NUM_TENSORS];
+  alloc_test_ztensors(ztensors);
+  save_test_ztensors(ztensors);
+
+  zdnn_ztensor_file *file;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_map_ztensor_file(path, &file));
+  TEST_ASSERT_EQUAL_UINT32(NUM_TENSORS, zdnn_get_ztensor_file_count(file));
+
+  for (uint32_t i = 0; i < NUM_TENSORS; i++) {
+    assert_same_ztensor(ztensors[i], zdnn_get_ztensor_file_entry(file, i), i);
+  }
+  TEST_ASSERT_NULL(zdnn_get_ztensor_file_entry(file, NUM_TENSORS));
+
+  // two mappings of the same file are independent
+  zdnn_ztensor_file *file2;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_map_ztensor_file(path, &file2));
+  zdnn_unmap_ztensor_file(file);
+  assert_same_ztensor(ztensors[0], zdnn_get_ztensor_file_entry(file2, 0), 0);
+  zdnn_unmap_ztensor_file(file2);
+
+  free_ztensor_buffers(NUM_TENSORS, ztensors[0], ztensors[1], ztensors[2]);
+}
+
+// mapped ztensors are used as operation inputs as they are
+void test_mapped_inputs() {
+  zdnn_ztensor *ztensors[NUM_TENSORS];
+  alloc_test_ztensors(ztensors);
+  save_test_ztensors(ztensors);
+
+  zdnn_ztensor_file *file;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_map_ztensor_file(path, &file));
+  const zdnn_ztensor *mapped = zdnn_get_ztensor_file_entry(file, 0);
+
+  uint32_t shape[] = {2, 5, 70};
+  zdnn_ztensor *exp_out =
+      alloc_output_ztensor(shape, ZDNN_3DS, FP32, NO_CONCAT);
+  zdnn_ztensor *out = alloc_output_ztensor(shape, ZDNN_3DS, FP32, NO_CONCAT);
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_add(ztensors[0], ztensors[0], exp_out));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_add(mapped, mapped, out));
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(exp_out->buffer, out->buffer,
+                                   out->buffer_size,
+                                   "output from mapped inputs differs");
+
+  zdnn_unmap_ztensor_file(file);
+  free_ztensor_buffers(NUM_TENSORS + 2, ztensors[0], ztensors[1], ztensors[2],
+                       exp_out, out);
+}
+
+void test_empty() {
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_save_ztensors(path, NULL, 0));
+
+  zdnn_ztensor_file *file;
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_map_ztensor_file(path, &file));
+  TEST_ASSERT_EQUAL_UINT32(0, zdnn_get_ztensor_file_count(file));
+  TEST_ASSERT_NULL(zdnn_get_ztensor_file_entry(file, 0));
+  zdnn_unmap_ztensor_file(file);
+}
+
+void test_save_not_transformed() {
+  uint32_t shape[] = {1, 2, 3};
+  zdnn_ztensor *ztensor =
+      alloc_output_ztensor(shape, ZDNN_3DS, FP32, NO_CONCAT);
+  const zdnn_ztensor *ztensors[] = {ztensor};
+
+  TEST_ASSERT_EQUAL(ZDNN_INVALID_STATE, zdnn_save_ztensors(path, ztensors, 1));
+  TEST_ASSERT_MESSAGE(access(path, F_OK) != 0, "file was created");
+
+  free_ztensor_buffers(1, ztensor);
+}
+
+void test_map_missing_file() {
+  zdnn_ztensor_file *file;
+  TEST_ASSERT_EQUAL(ZDNN_FILE_ERROR, zdnn_map_ztensor_file(path, &file));
+}
+
+/// Save the test ztensors, then overwrite size bytes at offset with data, or
+/// truncate the file to offset when data is NULL, and expect mapping it to
+/// fail
+static void corrupt_file_test(long offset, const void *data, size_t size) {
+  zdnn_ztensor *ztensors[NUM_TENSORS];
+  alloc_test_ztensors(ztensors);
+  save_test_ztensors(ztensors);
+
+  if (data) {
+    FILE *fp = fopen(path, "r+b");
+    TEST_ASSERT_NOT_NULL(fp);
+    fseek(fp, offset, SEEK_SET);
+    TEST_ASSERT_EQUAL(size, fwrite(data, 1, size, fp));
+    fclose(fp);
+  } else {
+    TEST_ASSERT_EQUAL(0, truncate(path, offset));
+  }
+
+  zdnn_ztensor_file *file;
+  TEST_ASSERT_EQUAL(ZDNN_FILE_ERROR, zdnn_map_ztensor_file(path, &file));
+
+  free_ztensor_buffers(NUM_TENSORS, ztensors[0], ztensors[1], ztensors[2]);
+}
+
+void test_map_bad_magic() { corrupt_file_test(0, "notzdnn", 8); }
+
+void test_map_bad_version() {
+  uint32_t version = 99;
+  corrupt_file_test(8, &version, sizeof(version));
+}
+
+void test_map_truncated() {
+  corrupt_file_test(3 * AIU_PAGESIZE_IN_BYTES, NULL, 0);
+}
+
+void test_map_too_small() { corrupt_file_test(10, NULL, 0); }
+
+// the first entry follows the 32-byte file header
+#define ENTRY0_OFFSET 32
+#define ENTRY0_BUFFER_OFFSET (ENTRY0_OFFSET + 2 * sizeof(zdnn_tensor_desc) + 8)
+
+// a stick area can't overlap the header, entries or channel vectors
+void test_map_buffer_over_metadata() {
+  uint64_t buffer_offset = 0;
+  corrupt_file_test(ENTRY0_BUFFER_OFFSET, &buffer_offset,
+                    sizeof(buffer_offset));
+}
+
+// the stick area size matches, but the layout doesn't exist
+void test_map_bad_transformed_desc() {
+  uint32_t layout = 999;
+  corrupt_file_test(ENTRY0_OFFSET + sizeof(zdnn_tensor_desc), &layout,
+                    sizeof(layout));
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_mapped_inputs);
+  RUN_TEST(test_empty);
+  RUN_TEST(test_save_not_transformed);
+  RUN_TEST(test_map_missing_file);
+  RUN_TEST(test_map_bad_magic);
+  RUN_TEST(test_map_bad_version);
+  RUN_TEST(test_map_truncated);
+  RUN_TEST(test_map_too_small);
+  RUN_TEST(test_map_buffer_over_metadata);
+  RUN_TEST(test_map_bad_transformed_desc);
+
+  return UNITY_END();
+}
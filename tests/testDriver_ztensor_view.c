@@ -0,0 +1,288 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common_quantization.h"
+#include "testsupport.h"
+
+void setUp(void) { VERIFY_HW_ENV; }
+
+void tearDown(void) {}
+
+/// An NHWC FP32 ztensor of random values, transformed
+static zdnn_ztensor *alloc_nhwc(uint32_t n, uint32_t h, uint32_t w,
+                                uint32_t c) {
+  uint32_t shape[] = {n, h, w, c};
+  uint64_t num_values = (uint64_t)n * h * w * c;
+  float *values = malloc(num_values * sizeof(float));
+  gen_random_float_array(num_values, values);
+  zdnn_ztensor *ztensor =
+      alloc_ztensor_with_values(shape, ZDNN_NHWC, FP32, NO_CONCAT, false,
+                                values);
+  free(values);
+  return ztensor;
+}
+
+/// Create a view of an NHWC parent, and check that it holds the same values as
+/// the parent over its range
+static void check_view(zdnn_ztensor *parent, uint32_t n0, uint32_t nc,
+                       uint32_t h0, uint32_t hc, uint32_t w0, uint32_t wc) {
+  zdnn_tensor_desc pre_tfrmd_desc, tfrmd_desc;
+  zdnn_ztensor view;
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_init_ztensor_view(parent, n0, nc, h0, hc, w0, wc,
+                                           &pre_tfrmd_desc, &tfrmd_desc,
+                                           &view));
+
+  TEST_ASSERT_TRUE(view.is_transformed);
+  TEST_ASSERT_EQUAL_UINT32(nc, pre_tfrmd_desc.dim4);
+  TEST_ASSERT_EQUAL_UINT32(hc, pre_tfrmd_desc.dim3);
+  TEST_ASSERT_EQUAL_UINT32(wc, pre_tfrmd_desc.dim2);
+  TEST_ASSERT_EQUAL_UINT64(zdnn_getsize_ztensor(&tfrmd_desc),
+                           view.buffer_size);
+  TEST_ASSERT_MESSAGE(
+      (char *)view.buffer + view.buffer_size <=
+          (char *)parent->buffer + parent->buffer_size,
+      "view is past the end of the parent");
+
+  const zdnn_tensor_desc *desc = parent->pre_transformed_desc;
+  uint32_t h = desc->dim3, w = desc->dim2, c = desc->dim1;
+  float *all = malloc((uint64_t)desc->dim4 * h * w * c * sizeof(float));
+  float *part = malloc((uint64_t)nc * hc * wc * c * sizeof(float));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_origtensor(parent, all));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_origtensor(&view, part));
+
+  for (uint32_t n = 0; n < nc; n++) {
+    for (uint32_t y = 0; y < hc; y++) {
+      for (uint32_t x = 0; x < wc; x++) {
+        TEST_ASSERT_EQUAL_MEMORY_MESSAGE(
+            &all[(((uint64_t)(n0 + n) * h + h0 + y) * w + w0 + x) * c],
+            &part[(((uint64_t)n * hc + y) * wc + x) * c], c * sizeof(float),
+            "view differs from parent");
+      }
+    }
+  }
+
+  free(all);
+  free(part);
+}
+
+/// Expect a view of the parent to be rejected
+static void check_bad_view(zdnn_ztensor *parent, uint32_t n0, uint32_t nc,
+                           uint32_t h0, uint32_t hc, uint32_t w0, uint32_t wc,
+                           zdnn_status exp_status) {
+  zdnn_tensor_desc pre_tfrmd_desc, tfrmd_desc;
+  zdnn_ztensor view;
+  TEST_ASSERT_EQUAL(exp_status,
+                    zdnn_init_ztensor_view(parent, n0, nc, h0, hc, w0, wc,
+                                           &pre_tfrmd_desc, &tfrmd_desc,
+                                           &view));
+}
+
+// dim4 ranges are always contiguous, even with dim1 spanning several sticks
+void test_view_dim4() {
+  zdnn_ztensor *parent = alloc_nhwc(5, 3, 40, 100);
+  check_view(parent, 0, 1, 0, 3, 0, 40);
+  check_view(parent, 1, 3, 0, 3, 0, 40);
+  check_view(parent, 4, 1, 0, 3, 0, 40);
+  free_ztensor_buffers(1, parent);
+}
+
+void test_view_dim3() {
+  zdnn_ztensor *parent = alloc_nhwc(1, 8, 40, 50);
+  check_view(parent, 0, 1, 2, 3, 0, 40);
+  check_view(parent, 0, 1, 7, 1, 0, 40);
+  free_ztensor_buffers(1, parent);
+}
+
+void test_view_dim2() {
+  zdnn_ztensor *parent = alloc_nhwc(1, 1, 100, 20);
+  check_view(parent, 0, 1, 0, 1, 32, 32);
+  check_view(parent, 0, 1, 0, 1, 64, 36);
+  check_view(parent, 0, 1, 0, 1, 0, 64);
+  free_ztensor_buffers(1, parent);
+}
+
+// a single dim3 row of a dim4 entry, sliced along dim2
+void test_view_dim3_dim2() {
+  zdnn_ztensor *parent = alloc_nhwc(3, 4, 70, 64);
+  check_view(parent, 2, 1, 1, 1, 32, 38);
+  free_ztensor_buffers(1, parent);
+}
+
+// a window of timesteps of a 3DS ztensor
+void test_view_3ds_timesteps() {
+  uint32_t shape[] = {6, 3, 20};
+  float values[6 * 3 * 20];
+  gen_random_float_array(6 * 3 * 20, values);
+  zdnn_ztensor *parent =
+      alloc_ztensor_with_values(shape, ZDNN_3DS, FP32, NO_CONCAT, false,
+                                values);
+
+  zdnn_tensor_desc pre_tfrmd_desc, tfrmd_desc;
+  zdnn_ztensor view;
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_init_ztensor_view(parent, 2, 3, 0, 1, 0, 3,
+                                           &pre_tfrmd_desc, &tfrmd_desc,
+                                           &view));
+  TEST_ASSERT_EQUAL(ZDNN_3DS, pre_tfrmd_desc.layout);
+  TEST_ASSERT_EQUAL_UINT32(3, pre_tfrmd_desc.dim3);
+  TEST_ASSERT_EQUAL_UINT32(3, pre_tfrmd_desc.dim2);
+  TEST_ASSERT_EQUAL_UINT32(20, pre_tfrmd_desc.dim1);
+
+  float all[6 * 3 * 20], part[3 * 3 * 20];
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_origtensor(parent, all));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_origtensor(&view, part));
+  TEST_ASSERT_EQUAL_MEMORY(&all[2 * 3 * 20], part, sizeof(part));
+
+  free_ztensor_buffers(1, parent);
+}
+
+// views of an output are written by operations in place
+void test_view_output() {
+  zdnn_ztensor *a = alloc_nhwc(4, 2, 40, 100);
+  zdnn_ztensor *b = alloc_nhwc(4, 2, 40, 100);
+  uint32_t shape[] = {4, 2, 40, 100};
+  zdnn_ztensor *exp_out =
+      alloc_output_ztensor(shape, ZDNN_NHWC, FP32, NO_CONCAT);
+  zdnn_ztensor *out = alloc_output_ztensor(shape, ZDNN_NHWC, FP32, NO_CONCAT);
+
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_add(a, b, exp_out));
+
+  for (uint32_t n = 0; n < 4; n += 2) {
+    zdnn_tensor_desc descs[6];
+    zdnn_ztensor view_a, view_b, view_out;
+    TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_init_ztensor_view(a, n, 2, 0, 2, 0, 40,
+                                                      &descs[0], &descs[1],
+                                                      &view_a));
+    TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_init_ztensor_view(b, n, 2, 0, 2, 0, 40,
+                                                      &descs[2], &descs[3],
+                                                      &view_b));
+    TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_init_ztensor_view(out, n, 2, 0, 2, 0, 40,
+                                                      &descs[4], &descs[5],
+                                                      &view_out));
+    TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_add(&view_a, &view_b, &view_out));
+  }
+
+  // the parent itself was never an operation output
+  out->is_transformed = true;
+
+  uint64_t num_values = 4 * 2 * 40 * 100;
+  float *exp_values = malloc(num_values * sizeof(float));
+  float *values = malloc(num_values * sizeof(float));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_origtensor(exp_out, exp_values));
+  TEST_ASSERT_EQUAL(ZDNN_OK, zdnn_transform_origtensor(out, values));
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(exp_values, values,
+                                   num_values * sizeof(float),
+                                   "output written through views differs");
+
+  free(exp_values);
+  free(values);
+  free_ztensor_buffers(4, a, b, exp_out, out);
+}
+
+void test_view_out_of_range() {
+  zdnn_ztensor *parent = alloc_nhwc(2, 3, 40, 20);
+  check_bad_view(parent, 1, 2, 0, 3, 0, 40, ZDNN_INVALID_SHAPE);
+  check_bad_view(parent, 0, 1, 3, 1, 0, 40, ZDNN_INVALID_SHAPE);
+  check_bad_view(parent, 0, 1, 0, 1, 32, 9, ZDNN_INVALID_SHAPE);
+  check_bad_view(parent, 0, 0, 0, 3, 0, 40, ZDNN_INVALID_SHAPE);
+  free_ztensor_buffers(1, parent);
+}
+
+void test_view_not_contiguous() {
+  zdnn_ztensor *parent = alloc_nhwc(2, 3, 70, 100);
+  // dim2 not starting on a page
+  check_bad_view(parent, 0, 1, 0, 1, 16, 16, ZDNN_INVALID_SHAPE);
+  // dim2 ending within a page of the parent's sticks
+  check_bad_view(parent, 0, 1, 0, 1, 0, 20, ZDNN_INVALID_SHAPE);
+  // dim3 range with dim1 spanning two sticks
+  check_bad_view(parent, 0, 1, 1, 2, 0, 70, ZDNN_INVALID_SHAPE);
+
+  zdnn_ztensor *parent2 = alloc_nhwc(2, 3, 70, 20);
+  // several dim4 with part of dim3
+  check_bad_view(parent2, 0, 2, 0, 2, 0, 70, ZDNN_INVALID_SHAPE);
+  // several dim3 with fewer dim2 pages
+  check_bad_view(parent2, 0, 1, 0, 3, 0, 64, ZDNN_INVALID_SHAPE);
+  // the same within a single stick of dim1 are fine
+  check_view(parent2, 1, 1, 1, 2, 0, 70);
+  check_view(parent2, 1, 1, 2, 1, 0, 64);
+
+  free_ztensor_buffers(2, parent, parent2);
+}
+
+void test_view_kernel() {
+  uint32_t shape[] = {3, 3, 8, 16};
+  uint32_t num_values = 3 * 3 * 8 * 16;
+  float values[num_values];
+  gen_random_float_array(num_values, values);
+  zdnn_ztensor *parent = alloc_ztensor_with_values(
+      shape, ZDNN_HWCK, FP32, NO_CONCAT, false, values);
+  check_bad_view(parent, 0, 1, 0, 3, 0, 8, ZDNN_INVALID_FORMAT);
+  free_ztensor_buffers(1, parent);
+}
+
+// 128 INT8 cells per stick, so dim1 of 200 takes two sticks rather than four
+void test_view_quantized_int8() {
+  uint32_t shape[] = {4, 1, 200};
+  uint32_t slice_shape[] = {1, 1, 200};
+  float values[4 * 200];
+  gen_random_float_array_range(4 * 200, values, -10.f, 10.f);
+  zdnn_ztensor *parent = alloc_quantized_ztensor_with_values(
+      shape, ZDNN_3DS, FP32, QUANTIZED_INT8, values, 0.1f, 0.f);
+  zdnn_ztensor *exp_view = alloc_quantized_ztensor_with_values(
+      slice_shape, ZDNN_3DS, FP32, QUANTIZED_INT8, &values[3 * 200], 0.1f,
+      0.f);
+
+  zdnn_tensor_desc pre_tfrmd_desc, tfrmd_desc;
+  zdnn_ztensor view;
+  TEST_ASSERT_EQUAL(ZDNN_OK,
+                    zdnn_init_ztensor_view(parent, 3, 1, 0, 1, 0, 1,
+                                           &pre_tfrmd_desc, &tfrmd_desc,
+                                           &view));
+  TEST_ASSERT_EQUAL_UINT64(exp_view->buffer_size, view.buffer_size);
+  TEST_ASSERT_EQUAL_PTR((char *)parent->buffer + parent->buffer_size -
+                            view.buffer_size,
+                        view.buffer);
+  // cells 0-127 in the first stick, 128-199 in the page after it
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(exp_view->buffer, view.buffer, 128,
+                                   "view differs from parent");
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE((char *)exp_view->buffer + 4096,
+                                   (char *)view.buffer + 4096, 72,
+                                   "view differs from parent");
+
+  free_ztensor_buffers(2, parent, exp_view);
+}
+
+int main() {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_view_dim4);
+  RUN_TEST(test_view_dim3);
+  RUN_TEST(test_view_dim2);
+  RUN_TEST(test_view_dim3_dim2);
+  RUN_TEST(test_view_3ds_timesteps);
+  RUN_TEST(test_view_output);
+  RUN_TEST(test_view_out_of_range);
+  RUN_TEST(test_view_not_contiguous);
+  RUN_TEST(test_view_kernel);
+  RUN_TEST(test_view_quantized_int8);
+
+  return UNITY_END();
+}
@@ -26,6 +26,7 @@
 #include "zdnn_private.h"
 #include <assert.h>
 #include <float.h>
+#include <math.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -648,6 +649,302 @@ zdnn_ztensor *alloc_output_ztensor(uint32_t *shape,
   return ztensor;
 }
 
+/// Creates an FP32 ztensor of random values in [min, max], one per element of
+/// its shape
+///
+/// \param[in] shape array of dimensions
+/// \param[in] pre_tfrmd_layout pre-transformed data layout
+/// \param[in] min smallest value
+/// \param[in] max largest value
+///
+/// \return zdnn_ztensor* Pointer to a malloc'd ztensor with transformed data
+///
+zdnn_ztensor *alloc_ztensor_with_random_values(
+    uint32_t *shape, zdnn_data_layouts pre_tfrmd_layout, float min,
+    float max) {
+  uint64_t num_values = 1;
+  for (short i = 0; i < get_data_layout_dims(pre_tfrmd_layout); i++) {
+    num_values *= shape[i];
+  }
+
+  float *values = malloc(num_values * sizeof(float));
+  gen_random_float_array_range(num_values, values, min, max);
+  zdnn_ztensor *ztensor = alloc_ztensor_with_values(
+      shape, pre_tfrmd_layout, FP32, NO_CONCAT, false, values);
+  free(values);
+  return ztensor;
+}
+
+/// Creates a ztensor of random values, concatenated per RNN gate, for the
+/// weights and biases of LSTM/GRU tests
+///
+/// \param[in] shape array of dimensions
+/// \param[in] pre_tfrmd_layout pre-transformed data layout
+/// \param[in] info RNN_TYPE_*, USAGE_* and PREV_LAYER_* of the concatenation
+/// \param[in] num_gates 4 for LSTM, 3 for GRU
+/// \param[in] num_values number of values of each gate
+///
+/// \return zdnn_ztensor* Pointer to a malloc'd ztensor with transformed data
+///
+zdnn_ztensor *alloc_gates_ztensor(uint32_t *shape,
+                                  zdnn_data_layouts pre_tfrmd_layout,
+                                  zdnn_concat_info info, uint32_t num_gates,
+                                  uint32_t num_values) {
+  float *values[4];
+  for (uint32_t i = 0; i < 4; i++) {
+    values[i] = malloc(num_values * sizeof(float));
+    gen_random_float_array_pos_neg(num_values, values[i]);
+  }
+  zdnn_ztensor *ztensor =
+      (num_gates == 4)
+          ? alloc_ztensor_with_values(shape, pre_tfrmd_layout, FP32, info,
+                                      false, values[0], values[1], values[2],
+                                      values[3])
+          : alloc_ztensor_with_values(shape, pre_tfrmd_layout, FP32, info,
+                                      false, values[0], values[1], values[2]);
+  for (uint32_t i = 0; i < 4; i++) {
+    free(values[i]);
+  }
+  return ztensor;
+}
+
+/// Creates the initial states, weights and biases of an LSTM/GRU layer, all
+/// random values
+///
+/// \param[in] function_code NNPA_LSTMACT or NNPA_GRUACT
+/// \param[in] prev_layer PREV_LAYER_UNI, or PREV_LAYER_BIDIR for a layer
+///                       taking both directions of a BIDIR layer
+/// \param[in] num_dirs 1, or 2 for BIDIR
+/// \param[in] num_batches batches of h0 and c0, 0 for neither of them
+/// \param[in] num_features input features
+/// \param[in] num_hidden hidden state size
+/// \param[out] t the ztensors, free with free_rnn_layer_ztensors()
+///
+/// \return None
+///
+void alloc_rnn_layer_ztensors(uint8_t function_code,
+                              zdnn_concat_info prev_layer, uint32_t num_dirs,
+                              uint32_t num_batches, uint32_t num_features,
+                              uint32_t num_hidden, rnn_layer_ztensors *t) {
+  zdnn_concat_info rnn_type =
+      (function_code == NNPA_LSTMACT) ? RNN_TYPE_LSTM : RNN_TYPE_GRU;
+  uint32_t num_gates = get_func_code_num_gates(function_code);
+
+  uint32_t state_shape[] = {num_dirs, num_batches, num_hidden};
+  uint32_t weights_shape[] = {num_dirs, num_features, num_hidden};
+  uint32_t biases_shape[] = {num_dirs, num_hidden};
+  uint32_t hidden_weights_shape[] = {num_dirs, num_hidden, num_hidden};
+
+  t->h0 = NULL;
+  t->c0 = NULL;
+  if (num_batches) {
+    uint32_t num_values = num_dirs * num_batches * num_hidden;
+    float *values = malloc(num_values * sizeof(float));
+    gen_random_float_array_pos_neg(num_values, values);
+    t->h0 = alloc_ztensor_with_values(state_shape, ZDNN_3DS, FP32, NO_CONCAT,
+                                      false, values);
+    gen_random_float_array_pos_neg(num_values, values);
+    t->c0 = alloc_ztensor_with_values(state_shape, ZDNN_3DS, FP32, NO_CONCAT,
+                                      false, values);
+    free(values);
+  }
+
+  t->weights = alloc_gates_ztensor(weights_shape, ZDNN_3DS,
+                                   rnn_type | prev_layer | USAGE_WEIGHTS,
+                                   num_gates,
+                                   num_dirs * num_features * num_hidden);
+  t->biases = alloc_gates_ztensor(biases_shape, ZDNN_2DS,
+                                  rnn_type | prev_layer | USAGE_BIASES,
+                                  num_gates, num_dirs * num_hidden);
+  t->hidden_weights = alloc_gates_ztensor(
+      hidden_weights_shape, ZDNN_3DS,
+      rnn_type | prev_layer | USAGE_HIDDEN_WEIGHTS, num_gates,
+      num_dirs * num_hidden * num_hidden);
+  t->hidden_biases = alloc_gates_ztensor(
+      biases_shape, ZDNN_2DS, rnn_type | prev_layer | USAGE_HIDDEN_BIASES,
+      num_gates, num_dirs * num_hidden);
+}
+
+/// Frees the ztensors of alloc_rnn_layer_ztensors()
+///
+/// \param[in] t the ztensors
+///
+/// \return None
+///
+void free_rnn_layer_ztensors(rnn_layer_ztensors *t) {
+  if (t->h0) {
+    free_ztensor_buffers(2, t->h0, t->c0);
+  }
+  free_ztensor_buffers(4, t->weights, t->biases, t->hidden_weights,
+                       t->hidden_biases);
+}
+
+// -----------------------------------------------------------------------------
+// NNPA Limits
+//
+// Tests of operations tiled beyond the NNPA limits lower the limits in
+// nnpa_query_result so small tensors are beyond them.  setUp() saves the
+// limits and tearDown() restores them, also when a test fails.
+// -----------------------------------------------------------------------------
+
+static nnpa_qaf_parameter_block saved_query_result;
+
+void save_nnpa_limits() { saved_query_result = nnpa_query_result; }
+
+void restore_nnpa_limits() { nnpa_query_result = saved_query_result; }
+
+/// Lower the NNPA limits.  0 keeps a limit.
+///
+/// \param[in] max_dim4 maximum dimension-4 index size
+/// \param[in] max_dim_idx_size maximum dimension-3, -2 and -1 index size
+/// \param[in] max_tensor_size maximum tensor size
+///
+/// \return None
+///
+void lower_nnpa_limits(uint32_t max_dim4, uint32_t max_dim_idx_size,
+                       uint64_t max_tensor_size) {
+  if (max_dim4) {
+    nnpa_query_result.max_dim4_index_size = max_dim4;
+  }
+  if (max_dim_idx_size) {
+    nnpa_query_result.max_dim3_index_size = max_dim_idx_size;
+    nnpa_query_result.max_dim2_index_size = max_dim_idx_size;
+    nnpa_query_result.max_dim1_index_size = max_dim_idx_size;
+  }
+  if (max_tensor_size) {
+    nnpa_query_result.maximum_tensor_size = max_tensor_size;
+  }
+}
+
+// -----------------------------------------------------------------------------
+// Reference Convolutions
+// -----------------------------------------------------------------------------
+
+/// Set the output shape of a reference convolution, and the padding in front
+/// of its input, from its input, kernel, padding, strides and dilations
+///
+/// \param[in,out] ref the reference convolution
+///
+/// \return None
+///
+void conv2d_ref_dims(conv2d_ref *ref) {
+  uint32_t span_h = (ref->kh - 1) * ref->dilation_h + 1;
+  uint32_t span_w = (ref->kw - 1) * ref->dilation_w + 1;
+
+  ref->pad_h = 0;
+  ref->pad_w = 0;
+  if (!ref->stride_h) {
+    ref->oh = ref->ow = 1;
+  } else if (ref->padding == SAME_PADDING) {
+    ref->oh = CEIL(ref->h, ref->stride_h);
+    ref->ow = CEIL(ref->w, ref->stride_w);
+    ref->pad_h =
+        MAX((int64_t)(ref->oh - 1) * ref->stride_h + span_h - ref->h, 0) / 2;
+    ref->pad_w =
+        MAX((int64_t)(ref->ow - 1) * ref->stride_w + span_w - ref->w, 0) / 2;
+  } else {
+    ref->oh = CEIL(ref->h - span_h + 1, ref->stride_h);
+    ref->ow = CEIL(ref->w - span_w + 1, ref->stride_w);
+  }
+}
+
+/// Compute a reference convolution in FP32, including its bias and activation
+///
+/// \param[in] ref the reference convolution, with conv2d_ref_dims() applied
+/// \param[in] input NHWC input values
+/// \param[in] kernel HWCK kernel values
+/// \param[in] bias k bias values
+/// \param[out] output n * oh * ow * k NHWC output values
+///
+/// \return None
+///
+void compute_conv2d_ref(const conv2d_ref *ref, const float *input,
+                        const float *kernel, const float *bias, float *output) {
+  uint32_t sh = ref->stride_h ? ref->stride_h : 1;
+  uint32_t sw = ref->stride_w ? ref->stride_w : 1;
+  uint32_t cg = ref->c / ref->groups, kg = ref->k / ref->groups;
+  uint64_t i = 0;
+
+  for (uint32_t e4x = 0; e4x < ref->n; e4x++) {
+    for (uint32_t e3x = 0; e3x < ref->oh; e3x++) {
+      for (uint32_t e2x = 0; e2x < ref->ow; e2x++) {
+        for (uint32_t e1x = 0; e1x < ref->k; e1x++, i++) {
+          uint32_t first_ch = e1x / kg * cg;
+          float val = bias[e1x];
+
+          for (uint32_t y = 0; y < ref->kh; y++) {
+            int64_t ih = (int64_t)e3x * sh + y * ref->dilation_h - ref->pad_h;
+            for (uint32_t x = 0; x < ref->kw; x++) {
+              int64_t iw =
+                  (int64_t)e2x * sw + x * ref->dilation_w - ref->pad_w;
+              if (ih < 0 || ih >= ref->h || iw < 0 || iw >= ref->w) {
+                continue;
+              }
+              const float *in =
+                  input + ((e4x * ref->h + ih) * ref->w + iw) * ref->c +
+                  first_ch;
+              const float *wk =
+                  kernel + ((uint64_t)y * ref->kw + x) * cg * ref->k + e1x;
+              for (uint32_t ch = 0; ch < cg; ch++) {
+                val += in[ch] * wk[(uint64_t)ch * ref->k];
+              }
+            }
+          }
+          output[i] = apply_conv2d_act(val, ref->act, ref->clip);
+        }
+      }
+    }
+  }
+}
+
+/// Apply the activation of a convolution to a reference value
+///
+/// \param[in] val the value
+/// \param[in] act the activation
+/// \param[in] clip the clipping value of CONV2D_ACT_RELU, 0 for none
+///
+/// \return the activated value
+///
+float apply_conv2d_act(float val, zdnn_conv2d_act act, float clip) {
+  if (act == CONV2D_ACT_RELU) {
+    val = MAX(val, 0);
+    if (clip > 0) {
+      val = MIN(val, clip);
+    }
+  }
+  return val;
+}
+
+/// Assert that the output of a convolution matches reference values within
+/// the rounding of the DLFLOAT16 results
+///
+/// \param[in] output the output ztensor
+/// \param[in] expected the reference values, in pre-transformed order
+///
+/// \return None
+///
+void assert_conv2d_output(const zdnn_ztensor *output, const float *expected) {
+  const zdnn_tensor_desc *desc = output->pre_transformed_desc;
+  uint64_t i = 0;
+
+  for (uint32_t e4x = 0; e4x < desc->dim4; e4x++) {
+    for (uint32_t e3x = 0; e3x < desc->dim3; e3x++) {
+      for (uint32_t e2x = 0; e2x < desc->dim2; e2x++) {
+        for (uint32_t e1x = 0; e1x < desc->dim1; e1x++, i++) {
+          size_t offset = get_stick_offset(e4x, e3x, e2x, e1x,
+                                           output->transformed_desc);
+          float val = cnvt_1_dlf16_to_fp32(
+              STICK_CELL16(*(uint16_t *)((char *)output->buffer + offset)));
+          TEST_ASSERT_MESSAGE_FORMATTED(
+              fabsf(val - expected[i]) <= 0.02f * (fabsf(expected[i]) + 1),
+              "output (%u, %u, %u, %u) is %f, expected %f", e4x, e3x, e2x,
+              e1x, val, expected[i]);
+        }
+      }
+    }
+  }
+}
+
 // -----------------------------------------------------------------------------
 // ULP-based Floating Point Comparsino Functions
 // -----------------------------------------------------------------------------
@@ -1311,6 +1608,20 @@ void gen_random_float_array_range(int size, float arr[], float min, float max) {
   }
 }
 
+/**
+ * Helper that allocates an array of random floats in [-1, 1], rounded to
+ * DLFLOAT16 so a reference result computed from them sees what the zAIU sees.
+ * The caller frees the array.
+ */
+float *alloc_random_dlf16_values(uint64_t num_values) {
+  float *values = malloc(num_values * sizeof(float));
+  gen_random_float_array_range(num_values, values, -1, 1);
+  for (uint64_t i = 0; i < num_values; i++) {
+    values[i] = cnvt_1_dlf16_to_fp32(cnvt_1_fp32_to_dlf16(values[i]));
+  }
+  return values;
+}
+
 /**
  * Helper that generates 0 values for a given size
  * and for a given array, meant for populating tensor buffers
@@ -57,8 +57,57 @@ zdnn_ztensor *alloc_ztensor_with_values(uint32_t *shape,
 zdnn_ztensor *alloc_output_ztensor(uint32_t *shape,
                                    zdnn_data_layouts pre_tfrmd_layout,
                                    zdnn_data_types type, zdnn_concat_info info);
+zdnn_ztensor *alloc_ztensor_with_random_values(
+    uint32_t *shape, zdnn_data_layouts pre_tfrmd_layout, float min, float max);
+zdnn_ztensor *alloc_gates_ztensor(uint32_t *shape,
+                                  zdnn_data_layouts pre_tfrmd_layout,
+                                  zdnn_concat_info info, uint32_t num_gates,
+                                  uint32_t num_values);
 void free_ztensor_buffers(uint32_t num_ztensors, ...);
 
+// The initial states, weights and biases of an LSTM/GRU layer, see
+// alloc_rnn_layer_ztensors()
+typedef struct rnn_layer_ztensors {
+  zdnn_ztensor *h0;
+  zdnn_ztensor *c0;
+  zdnn_ztensor *weights;
+  zdnn_ztensor *biases;
+  zdnn_ztensor *hidden_weights;
+  zdnn_ztensor *hidden_biases;
+} rnn_layer_ztensors;
+
+void alloc_rnn_layer_ztensors(uint8_t function_code,
+                              zdnn_concat_info prev_layer, uint32_t num_dirs,
+                              uint32_t num_batches, uint32_t num_features,
+                              uint32_t num_hidden, rnn_layer_ztensors *t);
+void free_rnn_layer_ztensors(rnn_layer_ztensors *t);
+
+void save_nnpa_limits();
+void restore_nnpa_limits();
+void lower_nnpa_limits(uint32_t max_dim4, uint32_t max_dim_idx_size,
+                       uint64_t max_tensor_size);
+
+// A 2D convolution computed on the host, to check the zDNN convolutions
+// against.  conv2d_ref_dims() fills in the output shape and padding.
+typedef struct conv2d_ref {
+  uint32_t n, h, w, c; // input (n, h, w, c)
+  uint32_t kh, kw, k;  // kernel (kh, kw, c / groups, k)
+  uint32_t groups;
+  zdnn_pool_padding padding;
+  uint32_t stride_h, stride_w;     // both 0: the kernel spans the input
+  uint32_t dilation_h, dilation_w; // 1 for a dense kernel
+  zdnn_conv2d_act act;
+  float clip;
+  uint32_t oh, ow;      // output (n, oh, ow, k)
+  int64_t pad_h, pad_w; // padding before the first input row and column
+} conv2d_ref;
+
+void conv2d_ref_dims(conv2d_ref *ref);
+void compute_conv2d_ref(const conv2d_ref *ref, const float *input,
+                        const float *kernel, const float *bias, float *output);
+float apply_conv2d_act(float val, zdnn_conv2d_act act, float clip);
+void assert_conv2d_output(const zdnn_ztensor *output, const float *expected);
+
 // Struct for floating point value tolerance information.
 typedef struct fp_tolerance {
   uint32_t ulps;         // unit in the last place
@@ -81,6 +130,7 @@ void gen_random_float_array(int size, float arr[]);
 void gen_random_float_array_neg(int size, float arr[]);
 void gen_random_float_array_pos_neg(int size, float arr[]);
 void gen_random_float_array_range(int size, float arr[], float min, float max);
+float *alloc_random_dlf16_values(uint64_t num_values);
 void gen_float_array_zeros(int size, float arr[]);
 void copy_to_array(int size, const float input[], float output[]);
 
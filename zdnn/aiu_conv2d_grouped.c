@@ -0,0 +1,502 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "convert.h"
+#include "zdnn.h"
+#include "zdnn_private.h"
+
+/*
+  A grouped convolution splits the C input channels and K output channels
+  into groups of Cg = C / groups and Kg = K / groups, and convolves every
+  group of input channels with its own (KH, KW, Cg, Kg) slice of the kernel:
+
+    output[n, oh, ow, g * Kg + k] = sum over (ky, kx, c) of
+                                      input[n, ih, iw, g * Cg + c] *
+                                      kernel[ky, kx, c, g * Kg + k]
+
+  The zAIU reads whole sticks of 64 channels, so a convolution of a few
+  channels costs about as much as one of a stick of them.  Consecutive groups
+  are therefore packed into one convolution of up to a stick of input
+  channels, with a block-diagonal kernel that has every group's slice on the
+  diagonal and zeros elsewhere.  Every pack is one zdnn_conv2d() of its
+  channel ranges of the input, bias and output, tiled the same way when it is
+  beyond the NNPA limits.
+
+  Depthwise convolutions with one input and one output channel per group
+  pack 64 channels into a kernel that is almost all zeros.  When a channel
+  only takes a few multiply-adds, because the output or the kernel is tiny,
+  they are computed here instead, straight from the input sticks into the
+  output sticks: every output cell only reads the KH * KW input cells of its
+  own channel.  Bigger ones still go through the zAIU, which does the wasted
+  multiply-adds faster than the CPU does the useful ones.
+*/
+
+// output cells times kernel cells computed by one chunk of depthwise rows
+#define DEPTHWISE_MACS_PER_CHUNK (64 * 1024)
+
+// output cells times kernel cells of one channel of one image up to which a
+// depthwise convolution is computed on the CPU
+#define DEPTHWISE_CPU_MAX_MACS 1024
+
+// how a depthwise convolution on the CPU is laid out
+typedef struct depthwise_job {
+  const char *in_buf;
+  char *out_buf;
+  stick_geometry in;
+  stick_geometry out;
+  uint32_t kernel_h;
+  uint32_t kernel_w;
+  uint32_t stride_h;
+  uint32_t stride_w;
+  int64_t pad_h; // leading SAME padding rows
+  int64_t pad_w; // leading SAME padding columns
+  const float *weights; // (KH, KW, K)
+  const float *bias;    // (K)
+  uint32_t act;
+  float clip;
+  bool range_violation; // an output cell became NINF
+} depthwise_job;
+
+/// Verify the tensors of a grouped convolution as the convolution of one
+/// group, which is what the zAIU checks
+///
+/// \param[in] input the input tensor, (N, H, W, C)
+/// \param[in] kernel the kernel tensor, (KH, KW, C / groups, K)
+/// \param[in] bias the bias tensor, (K)
+/// \param[in] groups number of groups
+/// \param[in] output the output tensor, (N, OH, OW, K)
+/// \param[in] fsp function specific parameters of the convolution
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_SHAPE
+///         a failure of verify_conv2d_tensors()
+///
+static zdnn_status
+verify_conv2d_grouped_tensors(const zdnn_ztensor *input,
+                              const zdnn_ztensor *kernel,
+                              const zdnn_ztensor *bias, uint32_t groups,
+                              const zdnn_ztensor *output,
+                              function_specific_parameters *fsp) {
+  const uint32_t in_channels = input->transformed_desc->dim1;
+  const uint32_t out_channels = output->transformed_desc->dim1;
+
+  if (!groups || in_channels % groups || out_channels % groups) {
+    return ZDNN_STATUS(ZDNN_INVALID_SHAPE,
+                       "groups (%u) must divide the input channels (%u) and "
+                       "the output channels (%u)",
+                       groups, in_channels, out_channels);
+  }
+
+  // every tensor is checked with the channels of one group in dim1
+  const zdnn_ztensor *tensors[] = {input, kernel, bias, output};
+  zdnn_tensor_desc group_descs[4];
+  zdnn_ztensor group_tensors[4];
+
+  for (int i = 0; i < 4; i++) {
+    uint32_t channels = i == 0 ? in_channels : out_channels;
+
+    group_descs[i] = *tensors[i]->transformed_desc;
+    if (group_descs[i].dim1 == channels) {
+      group_descs[i].dim1 = channels / groups;
+    }
+    group_tensors[i] = *tensors[i];
+    group_tensors[i].transformed_desc = &group_descs[i];
+  }
+
+  return verify_conv2d_tensors(
+      &group_tensors[0], &group_tensors[1], &group_tensors[2],
+      &fsp->function_specific_parm1, &fsp->function_specific_parm2,
+      &fsp->function_specific_parm3, &fsp->function_specific_parm4,
+      &group_tensors[3]);
+}
+
+/// Set up the block-diagonal kernel of a pack of consecutive groups
+///
+/// \param[in] kernel the kernel tensor
+/// \param[in] first_group first group of the pack
+/// \param[in] num_groups number of groups in the pack
+/// \param[in] group_out output channels per group
+/// \param[out] tile the pack's kernel
+///
+/// \return ZDNN_OK
+///         ZDNN_ALLOCATION_FAILURE
+///
+static zdnn_status init_pack_kernel(const zdnn_ztensor *kernel,
+                                    uint32_t first_group, uint32_t num_groups,
+                                    uint32_t group_out, ztensor_tile *tile) {
+  const zdnn_tensor_desc *kernel_desc = kernel->transformed_desc;
+  const uint32_t group_in = kernel_desc->dim2;
+  zdnn_status status;
+
+  tile->tfrmd_desc = *kernel_desc;
+  tile->tfrmd_desc.dim2 = num_groups * group_in;
+  tile->tfrmd_desc.dim1 = num_groups * group_out;
+  zdnn_init_pre_transformed_desc(ZDNN_HWCK, kernel->pre_transformed_desc->type,
+                                 &tile->pre_tfrmd_desc, kernel_desc->dim4,
+                                 kernel_desc->dim3, tile->tfrmd_desc.dim2,
+                                 tile->tfrmd_desc.dim1);
+  tile->is_view = false;
+  if ((status = zdnn_init_ztensor_with_malloc(
+           &tile->pre_tfrmd_desc, &tile->tfrmd_desc, &tile->ztensor)) !=
+      ZDNN_OK) {
+    return status;
+  }
+  memset(tile->ztensor.buffer, 0, tile->ztensor.buffer_size);
+
+  const uint32_t count[] = {kernel_desc->dim4, kernel_desc->dim3, group_in,
+                            group_out};
+  for (uint32_t g = 0; g < num_groups; g++) {
+    const uint32_t from_start[] = {0, 0, 0, (first_group + g) * group_out};
+    const uint32_t to_start[] = {0, 0, g * group_in, g * group_out};
+    copy_kernel_range(kernel, from_start, &tile->ztensor, to_start, count);
+  }
+  tile->ztensor.is_transformed = true;
+  return ZDNN_STATUS_OK;
+}
+
+/// Run the convolution of a pack of consecutive groups
+///
+/// \param[in] op_parm_block_version Parmblock version
+/// \param[in] input the input tensor
+/// \param[in] kernel the kernel tensor
+/// \param[in] bias the bias tensor
+/// \param[out] output the output tensor
+/// \param[in] fsp function specific parameters of the convolution
+/// \param[in] first_group first group of the pack
+/// \param[in] num_groups number of groups in the pack
+/// \param[in] group_out output channels per group
+///
+/// \return ZDNN_OK
+///         ZDNN_ALLOCATION_FAILURE
+///         a status of the pack's convolution
+///
+static zdnn_status conv2d_group_pack(uint16_t op_parm_block_version,
+                                     const zdnn_ztensor *input,
+                                     const zdnn_ztensor *kernel,
+                                     const zdnn_ztensor *bias,
+                                     zdnn_ztensor *output,
+                                     function_specific_parameters *fsp,
+                                     uint32_t first_group, uint32_t num_groups,
+                                     uint32_t group_out) {
+  const zdnn_tensor_desc *in_desc = input->transformed_desc;
+  const zdnn_tensor_desc *out_desc = output->transformed_desc;
+  const uint32_t group_in = kernel->transformed_desc->dim2;
+
+  const uint32_t in_start[] = {0, 0, 0, first_group * group_in};
+  const uint32_t in_count[] = {in_desc->dim4, in_desc->dim3, in_desc->dim2,
+                               num_groups * group_in};
+  const uint32_t out_start[] = {0, 0, 0, first_group * group_out};
+  const uint32_t out_count[] = {out_desc->dim4, out_desc->dim3, out_desc->dim2,
+                                num_groups * group_out};
+  const uint32_t bias_count[] = {1, 1, 1, num_groups * group_out};
+
+  ztensor_tile tiles[4];
+  int num_tiles = 0;
+  zdnn_status status;
+
+  status = init_ztensor_tile(input, in_start, in_count, true, &tiles[0]);
+  if (status == ZDNN_OK) {
+    num_tiles++;
+    status = init_pack_kernel(kernel, first_group, num_groups, group_out,
+                              &tiles[1]);
+  }
+  if (status == ZDNN_OK) {
+    num_tiles++;
+    status = init_ztensor_tile(bias, out_start, bias_count, true, &tiles[2]);
+  }
+  if (status == ZDNN_OK) {
+    num_tiles++;
+    status = init_ztensor_tile(output, out_start, out_count, false, &tiles[3]);
+  }
+  if (status == ZDNN_OK) {
+    num_tiles++;
+    status = aiu_conv2d_op(op_parm_block_version, &tiles[0].ztensor,
+                           &tiles[1].ztensor, &tiles[2].ztensor,
+                           &tiles[3].ztensor, fsp);
+    if (status == ZDNN_OK ||
+        (status & WARNING_STATUS_BITMASK) == ZDNN_WARNING) {
+      store_ztensor_tile(output, out_start, &tiles[3]);
+    }
+  }
+
+  while (num_tiles--) {
+    free_ztensor_tile(&tiles[num_tiles]);
+  }
+  return status;
+}
+
+/// Compute depthwise output rows [begin, end)
+///
+/// \param[in] ctx Pointer to the depthwise_job
+/// \param[in] begin first output (e4x, e3x) row
+/// \param[in] end one past the last output row
+///
+/// \return None
+///
+static void depthwise_rows_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  depthwise_job *job = ctx;
+  bool range_violation = false;
+  const uint32_t channels = job->out.dim1;
+  uint16_t in_cells[AIU_2BYTE_CELLS_PER_STICK];
+  float in_values[AIU_2BYTE_CELLS_PER_STICK];
+  float acc[AIU_2BYTE_CELLS_PER_STICK];
+
+  for (uint64_t row = begin; row < end; row++) {
+    uint32_t n = row / job->out.dim3;
+    uint32_t oh = row % job->out.dim3;
+
+    for (uint32_t c0 = 0; c0 < channels; c0 += AIU_2BYTE_CELLS_PER_STICK) {
+      const uint32_t cells = MIN(AIU_2BYTE_CELLS_PER_STICK, channels - c0);
+      const uint64_t stick1 = c0 / AIU_2BYTE_CELLS_PER_STICK;
+      const char *in_sticks = job->in_buf + n * job->in.bytes_per_e4x +
+                              stick1 * job->in.bytes_per_stick1;
+      uint16_t *out_stick =
+          (uint16_t *)(job->out_buf + n * job->out.bytes_per_e4x +
+                       stick1 * job->out.bytes_per_stick1 +
+                       oh * job->out.bytes_per_row);
+
+      for (uint32_t ow = 0; ow < job->out.dim2;
+           ow++, out_stick += AIU_2BYTE_CELLS_PER_STICK) {
+        memcpy(acc, job->bias + c0, cells * sizeof(float));
+
+        for (uint32_t ky = 0; ky < job->kernel_h; ky++) {
+          int64_t ih = (int64_t)oh * job->stride_h + ky - job->pad_h;
+          if (ih < 0 || ih >= job->in.dim3) {
+            continue;
+          }
+          for (uint32_t kx = 0; kx < job->kernel_w; kx++) {
+            int64_t iw = (int64_t)ow * job->stride_w + kx - job->pad_w;
+            if (iw < 0 || iw >= job->in.dim2) {
+              continue;
+            }
+            memcpy(in_cells,
+                   in_sticks + ih * job->in.bytes_per_row +
+                       iw * AIU_BYTES_PER_STICK,
+                   cells * AIU_2BYTE_CELL_SIZE);
+            dlf16_to_fp32(in_cells, in_values, cells);
+
+            const float *w =
+                job->weights +
+                ((uint64_t)ky * job->kernel_w + kx) * channels + c0;
+            for (uint32_t i = 0; i < cells; i++) {
+              acc[i] += in_values[i] * w[i];
+            }
+          }
+        }
+
+        for (uint32_t i = 0; i < cells; i++) {
+          float val = acc[i];
+          if (job->act == CONV2D_ACT_RELU) {
+            val = MAX(val, 0);
+            if (job->clip > 0) {
+              val = MIN(val, job->clip);
+            }
+          }
+          uint16_t cell = cnvt_1_fp32_to_dlf16(val);
+          range_violation |= (cell & DLF16_NINF) == DLF16_NINF;
+          out_stick[i] = STICK_CELL16(cell);
+        }
+        // the cells after the last channel of the stick are padding
+        memset(out_stick + cells, 0,
+               (AIU_2BYTE_CELLS_PER_STICK - cells) * AIU_2BYTE_CELL_SIZE);
+      }
+    }
+  }
+
+  if (range_violation) {
+    __atomic_store_n(&job->range_violation, true, __ATOMIC_RELAXED);
+  }
+}
+
+/// Compute a depthwise convolution, one input and one output channel per
+/// group, on the stick areas of its tensors
+///
+/// \param[in] input the input tensor
+/// \param[in] kernel the kernel tensor
+/// \param[in] bias the bias tensor
+/// \param[out] output the output tensor
+/// \param[in] fsp function specific parameters of the convolution
+///
+/// \return ZDNN_OK
+///         ZDNN_ELEMENT_RANGE_VIOLATION
+///         ZDNN_ALLOCATION_FAILURE
+///
+static zdnn_status conv2d_depthwise(const zdnn_ztensor *input,
+                                    const zdnn_ztensor *kernel,
+                                    const zdnn_ztensor *bias,
+                                    zdnn_ztensor *output,
+                                    function_specific_parameters *fsp) {
+  const func_sp_parms_conv2d *fsp_conv2d = (func_sp_parms_conv2d *)fsp;
+  const zdnn_tensor_desc *in_desc = input->transformed_desc;
+  const zdnn_tensor_desc *kernel_desc = kernel->transformed_desc;
+  const zdnn_tensor_desc *out_desc = output->transformed_desc;
+  const uint32_t channels = out_desc->dim1;
+  const uint64_t kernel_cells = (uint64_t)kernel_desc->dim4 * kernel_desc->dim3;
+  depthwise_job job;
+
+  float *weights = malloc((kernel_cells + 1) * channels * sizeof(float));
+  if (!weights) {
+    return ZDNN_STATUS(ZDNN_ALLOCATION_FAILURE,
+                       "Unable to allocate %" PRIu64 " bytes.",
+                       (kernel_cells + 1) * channels * sizeof(float));
+  }
+  float *bias_values = weights + kernel_cells * channels;
+
+  for (uint32_t k = 0; k < channels; k++) {
+    for (uint32_t ky = 0; ky < kernel_desc->dim4; ky++) {
+      for (uint32_t kx = 0; kx < kernel_desc->dim3; kx++) {
+        weights[((uint64_t)ky * kernel_desc->dim3 + kx) * channels + k] =
+            cnvt_1_dlf16_to_fp32(STICK_CELL16(
+                *(uint16_t *)((char *)kernel->buffer +
+                              get_stick_offset(ky, kx, 0, k, kernel_desc))));
+      }
+    }
+    bias_values[k] = cnvt_1_dlf16_to_fp32(STICK_CELL16(
+        *(uint16_t *)((char *)bias->buffer +
+                      get_stick_offset(0, 0, 0, k, bias->transformed_desc))));
+  }
+
+  job.in_buf = input->buffer;
+  job.out_buf = output->buffer;
+  init_stick_geometry(in_desc, &job.in);
+  init_stick_geometry(out_desc, &job.out);
+  job.kernel_h = kernel_desc->dim4;
+  job.kernel_w = kernel_desc->dim3;
+  job.weights = weights;
+  job.bias = bias_values;
+  job.act = fsp_conv2d->parm1.act;
+  job.clip = fsp_conv2d->parm4.clipping_value
+                 ? cnvt_1_dlf16_to_fp32(fsp_conv2d->parm4.clipping_value)
+                 : 0;
+  job.range_violation = false;
+
+  // with zero strides the kernel covers the whole input, which is a VALID
+  // convolution with strides of 1
+  job.stride_h = fsp_conv2d->parm3.stride_height
+                     ? fsp_conv2d->parm3.stride_height
+                     : 1;
+  job.stride_w =
+      fsp_conv2d->parm2.stride_width ? fsp_conv2d->parm2.stride_width : 1;
+  job.pad_h = 0;
+  job.pad_w = 0;
+  if (fsp_conv2d->parm1.pad == SAME_PADDING) {
+    // the padding is split evenly, with the odd row or column at the end
+    job.pad_h = MAX((int64_t)(out_desc->dim3 - 1) * job.stride_h +
+                        kernel_desc->dim4 - in_desc->dim3,
+                    0) /
+                2;
+    job.pad_w = MAX((int64_t)(out_desc->dim2 - 1) * job.stride_w +
+                        kernel_desc->dim3 - in_desc->dim2,
+                    0) /
+                2;
+  }
+
+  uint64_t row_macs = (uint64_t)out_desc->dim2 * channels * kernel_cells;
+  run_parallel((uint64_t)out_desc->dim4 * out_desc->dim3,
+               MAX(DEPTHWISE_MACS_PER_CHUNK / row_macs, 1),
+               depthwise_rows_chunk, &job);
+
+  free(weights);
+  output->is_transformed = true;
+  // like the zAIU, a range violation is a warning and the output is complete
+  if (job.range_violation) {
+    return ZDNN_STATUS(ZDNN_ELEMENT_RANGE_VIOLATION,
+                       "Range violation on tensor data", NO_ARG);
+  }
+  return ZDNN_STATUS_OK;
+}
+
+/// Run a grouped convolution.  groups of 1 is a zdnn_conv2d().
+///
+/// \param[in] op_parm_block_version Parmblock version
+/// \param[in] input the input tensor, (N, H, W, C)
+/// \param[in] kernel the kernel tensor, (KH, KW, C / groups, K)
+/// \param[in] bias the bias tensor, (K)
+/// \param[in] groups number of groups the channels are split into
+/// \param[out] output the output tensor, (N, OH, OW, K)
+/// \param[in] fsp function specific parameters of the convolution
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_SHAPE
+///         ZDNN_EXCEEDS_MTS
+///         ZDNN_ALLOCATION_FAILURE
+///         a failure of the verification or of one of the NNPA operations
+///
+zdnn_status aiu_conv2d_grouped_op(uint16_t op_parm_block_version,
+                                  const zdnn_ztensor *input,
+                                  const zdnn_ztensor *kernel,
+                                  const zdnn_ztensor *bias, uint32_t groups,
+                                  zdnn_ztensor *output,
+                                  function_specific_parameters *fsp) {
+  func_sp_parms_conv2d *fsp_conv2d = (func_sp_parms_conv2d *)fsp;
+  zdnn_status status;
+
+  if (groups == 1) {
+    return aiu_conv2d_op(op_parm_block_version, input, kernel, bias, output,
+                         fsp);
+  }
+
+  if (!is_query_parmblock_installed(op_parm_block_version)) {
+    return ZDNN_UNAVAILABLE_FUNCTION;
+  }
+  if ((status = check_op_plan_recordable("grouped conv2d")) != ZDNN_OK) {
+    return status;
+  }
+  if ((status = verify_conv2d_grouped_tensors(input, kernel, bias, groups,
+                                              output, fsp)) != ZDNN_OK) {
+    return status;
+  }
+
+  // padding and activations the zAIU doesn't know are left for it to reject
+  bool is_known_conv2d = (fsp_conv2d->parm1.pad == VALID_PADDING ||
+                          fsp_conv2d->parm1.pad == SAME_PADDING) &&
+                         (fsp_conv2d->parm1.act == CONV2D_ACT_NONE ||
+                          fsp_conv2d->parm1.act == CONV2D_ACT_RELU);
+  const zdnn_tensor_desc *kernel_desc = kernel->transformed_desc;
+  const zdnn_tensor_desc *out_desc = output->transformed_desc;
+  const uint32_t group_in = kernel_desc->dim2;
+  const uint32_t group_out = out_desc->dim1 / groups;
+  const uint64_t channel_macs = (uint64_t)out_desc->dim3 * out_desc->dim2 *
+                                kernel_desc->dim4 * kernel_desc->dim3;
+
+  if (is_known_conv2d && group_in == 1 && group_out == 1 &&
+      channel_macs <= DEPTHWISE_CPU_MAX_MACS) {
+    return conv2d_depthwise(input, kernel, bias, output, fsp);
+  }
+
+  // as many groups as fit in a stick of input channels are packed together
+  uint32_t pack = MAX(1, MIN(groups, AIU_2BYTE_CELLS_PER_STICK / group_in));
+  zdnn_status warning = ZDNN_OK;
+
+  for (uint32_t g = 0; g < groups; g += pack) {
+    status = conv2d_group_pack(op_parm_block_version, input, kernel, bias,
+                               output, fsp, g, MIN(pack, groups - g),
+                               group_out);
+    if ((status & WARNING_STATUS_BITMASK) == ZDNN_WARNING) {
+      // keep going, the convolution is reported as done with the warning
+      warning = status;
+    } else if (status != ZDNN_OK) {
+      return status;
+    }
+  }
+
+  output->is_transformed = true;
+  return warning;
+}
@@ -0,0 +1,650 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "zdnn.h"
+#include "zdnn_private.h"
+
+/*
+  Dilated and transposed convolutions are lowered onto one NNPA convolution
+  each, with the data moved between the tensors and temporaries a stick (or a
+  run of cells of a stick) at a time.
+
+  A dilated convolution with dilation d and stride s reads input rows
+
+    oh * s - pad + ky * d
+
+  With g = gcd(s, d) and L = d / g, the output rows oh = q * L + j of one
+  residue class j read input rows (j * s - pad) + d * i, so every class is a
+  dense convolution with stride s / g over a sub-lattice of the input rows
+  with step d.  The sub-lattices of all (row, column) classes are stacked
+  along dim4 (space to batch), convolved in one operation, and the output of
+  every class is scattered back to its rows and columns (batch to space).
+
+  A transposed convolution with stride s adds input[ih] * kernel[ky] into
+  output[ih * s + ky - pad].  That's a convolution over the input with s - 1
+  zeros inserted between rows, and for output rows oh with
+  (oh + pad) % s == r only the kernel rows ky = r + m * s meet an input row.
+  So every phase r of the output is a dense convolution with stride 1 of the
+  input by the kernel rows of the phase, flipped.  The kernels of all
+  (row, column) phases are stacked along dim1 (K), so one convolution
+  computes every phase, and every phase's channels are scattered to its
+  output rows and columns (depth to space).
+*/
+
+// cells copied by one chunk of lattice rows
+#define LATTICE_CELLS_PER_CHUNK (256 * 1024)
+
+// A lattice of (dim3, dim2) positions of a 4DFEATURE zTensor and a range of
+// the dim1 cells at each of them
+typedef struct stick_lattice {
+  const zdnn_ztensor *ztensor;
+  uint32_t n;      // first dim4 index
+  int64_t h;       // first dim3 index, may be outside of the tensor
+  int64_t w;       // first dim2 index, may be outside of the tensor
+  uint32_t step_h; // dim3 indices between lattice rows
+  uint32_t step_w; // dim2 indices between lattice columns
+  uint32_t c;      // first dim1 index
+} stick_lattice;
+
+typedef struct lattice_copy_job {
+  const stick_lattice *from;
+  const stick_lattice *to;
+  stick_geometry from_geom;
+  stick_geometry to_geom;
+  uint32_t count_h;
+  uint32_t count_w;
+  uint32_t count_c;
+} lattice_copy_job;
+
+/// Copy lattice rows [begin, end), skipping positions outside of either
+/// tensor
+///
+/// \param[in] ctx Pointer to the lattice_copy_job
+/// \param[in] begin first lattice (dim4, row)
+/// \param[in] end one past the last lattice row
+///
+/// \return None
+///
+static void copy_lattice_rows_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  const lattice_copy_job *job = ctx;
+  const stick_lattice *from = job->from, *to = job->to;
+  const stick_geometry *fg = &job->from_geom, *tg = &job->to_geom;
+  const uint32_t tail =
+      to->c + job->count_c == tg->dim1 ? tg->dim1 % AIU_2BYTE_CELLS_PER_STICK
+                                       : 0;
+
+  for (uint64_t row = begin; row < end; row++) {
+    uint32_t n = row / job->count_h;
+    uint32_t i = row % job->count_h;
+    int64_t fh = from->h + (int64_t)i * from->step_h;
+    int64_t th = to->h + (int64_t)i * to->step_h;
+
+    if (fh < 0 || fh >= fg->dim3 || th < 0 || th >= tg->dim3) {
+      continue;
+    }
+    const char *from_row = (char *)from->ztensor->buffer +
+                           (from->n + n) * fg->bytes_per_e4x +
+                           fh * fg->bytes_per_row;
+    char *to_row = (char *)to->ztensor->buffer +
+                   (to->n + n) * tg->bytes_per_e4x + th * tg->bytes_per_row;
+
+    for (uint32_t j = 0; j < job->count_w; j++) {
+      int64_t fw = from->w + (int64_t)j * from->step_w;
+      int64_t tw = to->w + (int64_t)j * to->step_w;
+
+      if (fw < 0 || fw >= fg->dim2 || tw < 0 || tw >= tg->dim2) {
+        continue;
+      }
+
+      uint32_t c = 0;
+      while (c < job->count_c) {
+        uint32_t fc = from->c + c, tc = to->c + c;
+        uint32_t run = MIN(AIU_2BYTE_CELLS_PER_STICK -
+                               fc % AIU_2BYTE_CELLS_PER_STICK,
+                           AIU_2BYTE_CELLS_PER_STICK -
+                               tc % AIU_2BYTE_CELLS_PER_STICK);
+        run = MIN(run, job->count_c - c);
+        memcpy(to_row + tc / AIU_2BYTE_CELLS_PER_STICK * tg->bytes_per_stick1 +
+                   tw * AIU_BYTES_PER_STICK +
+                   tc % AIU_2BYTE_CELLS_PER_STICK * AIU_2BYTE_CELL_SIZE,
+               from_row +
+                   fc / AIU_2BYTE_CELLS_PER_STICK * fg->bytes_per_stick1 +
+                   fw * AIU_BYTES_PER_STICK +
+                   fc % AIU_2BYTE_CELLS_PER_STICK * AIU_2BYTE_CELL_SIZE,
+               run * AIU_2BYTE_CELL_SIZE);
+        c += run;
+      }
+
+      // zero the padding cells after dim1 in the last stick written
+      if (tail) {
+        memset(to_row +
+                   (tg->dim1 - 1) / AIU_2BYTE_CELLS_PER_STICK *
+                       tg->bytes_per_stick1 +
+                   tw * AIU_BYTES_PER_STICK + tail * AIU_2BYTE_CELL_SIZE,
+               0, (AIU_2BYTE_CELLS_PER_STICK - tail) * AIU_2BYTE_CELL_SIZE);
+      }
+    }
+  }
+}
+
+/// Copy the cells of a lattice of one 4DFEATURE zTensor to a lattice of
+/// another.  Positions outside of either tensor are skipped.
+///
+/// \param[in] from the lattice copied from
+/// \param[in] to the lattice copied into
+/// \param[in] count_n number of dim4 indices
+/// \param[in] count_h number of lattice rows
+/// \param[in] count_w number of lattice columns
+/// \param[in] count_c number of dim1 cells at every position
+///
+/// \return None
+///
+static void copy_lattice(const stick_lattice *from, const stick_lattice *to,
+                         uint32_t count_n, uint32_t count_h, uint32_t count_w,
+                         uint32_t count_c) {
+  lattice_copy_job job;
+
+  job.from = from;
+  job.to = to;
+  init_stick_geometry(from->ztensor->transformed_desc, &job.from_geom);
+  init_stick_geometry(to->ztensor->transformed_desc, &job.to_geom);
+  job.count_h = count_h;
+  job.count_w = count_w;
+  job.count_c = count_c;
+
+  run_parallel((uint64_t)count_n * count_h,
+               MAX(LATTICE_CELLS_PER_CHUNK / ((uint64_t)count_w * count_c), 1),
+               copy_lattice_rows_chunk, &job);
+}
+
+/// Set up a zeroed temporary zTensor like another one, with other dims
+///
+/// \param[in] like the zTensor whose layout and types are used
+/// \param[in] layout pre-transformed layout of the temporary
+/// \param[in] dims dims of the temporary, dim4 first
+/// \param[out] tile the temporary
+///
+/// \return ZDNN_OK
+///         ZDNN_ALLOCATION_FAILURE
+///
+static zdnn_status init_zeroed_tile(const zdnn_ztensor *like,
+                                    zdnn_data_layouts layout,
+                                    const uint32_t *dims, ztensor_tile *tile) {
+  zdnn_status status;
+
+  tile->tfrmd_desc = *like->transformed_desc;
+  tile->tfrmd_desc.dim4 = dims[0];
+  tile->tfrmd_desc.dim3 = dims[1];
+  tile->tfrmd_desc.dim2 = dims[2];
+  tile->tfrmd_desc.dim1 = dims[3];
+  if (layout == ZDNN_1D) {
+    zdnn_init_pre_transformed_desc(layout, like->pre_transformed_desc->type,
+                                   &tile->pre_tfrmd_desc, dims[3]);
+  } else {
+    zdnn_init_pre_transformed_desc(layout, like->pre_transformed_desc->type,
+                                   &tile->pre_tfrmd_desc, dims[0], dims[1],
+                                   dims[2], dims[3]);
+  }
+  tile->is_view = false;
+  if ((status = zdnn_init_ztensor_with_malloc(
+           &tile->pre_tfrmd_desc, &tile->tfrmd_desc, &tile->ztensor)) !=
+      ZDNN_OK) {
+    return status;
+  }
+  memset(tile->ztensor.buffer, 0, tile->ztensor.buffer_size);
+  tile->ztensor.is_transformed = true;
+  return ZDNN_STATUS_OK;
+}
+
+/// Verify the tensors of a lowered convolution, with the descriptors of the
+/// NNPA convolution it's lowered to
+///
+/// \param[in] input the input tensor
+/// \param[in] kernel the kernel tensor
+/// \param[in] bias the bias tensor
+/// \param[in] output the output tensor
+/// \param[in] descs transformed descriptors of the lowered input, kernel, bias
+///                  and output
+/// \param[in] fsp function specific parameters of the lowered convolution
+///
+/// \return ZDNN_OK or a failure of verify_conv2d_tensors()
+///
+static zdnn_status verify_lowered_tensors(const zdnn_ztensor *input,
+                                          const zdnn_ztensor *kernel,
+                                          const zdnn_ztensor *bias,
+                                          const zdnn_ztensor *output,
+                                          zdnn_tensor_desc *descs,
+                                          function_specific_parameters *fsp) {
+  const zdnn_ztensor *tensors[] = {input, kernel, bias, output};
+  zdnn_ztensor lowered[4];
+
+  for (int i = 0; i < 4; i++) {
+    lowered[i] = *tensors[i];
+    lowered[i].transformed_desc = &descs[i];
+  }
+
+  return verify_conv2d_tensors(&lowered[0], &lowered[1], &lowered[2],
+                               &fsp->function_specific_parm1,
+                               &fsp->function_specific_parm2,
+                               &fsp->function_specific_parm3,
+                               &fsp->function_specific_parm4, &lowered[3]);
+}
+
+/// Check the strides and padding of a lowered convolution
+///
+/// \param[in] fsp_conv2d function specific parameters of the convolution
+/// \param[in] op_name name of the operation, for the error message
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_STRIDES
+///         ZDNN_INVALID_STRIDE_PADDING
+///
+static zdnn_status check_lowered_strides(const func_sp_parms_conv2d *fsp_conv2d,
+                                         const char *op_name) {
+  if (!fsp_conv2d->parm3.stride_height || !fsp_conv2d->parm2.stride_width) {
+    return ZDNN_STATUS(ZDNN_INVALID_STRIDES,
+                       "%s needs stride_height (%u) and stride_width (%u) "
+                       "greater than 0",
+                       op_name, fsp_conv2d->parm3.stride_height,
+                       fsp_conv2d->parm2.stride_width);
+  }
+  if (fsp_conv2d->parm1.pad != VALID_PADDING &&
+      fsp_conv2d->parm1.pad != SAME_PADDING) {
+    return ZDNN_STATUS(ZDNN_INVALID_STRIDE_PADDING,
+                       "padding must be VALID_PADDING or SAME_PADDING "
+                       "(found %u)",
+                       fsp_conv2d->parm1.pad);
+  }
+  return ZDNN_STATUS_OK;
+}
+
+static uint32_t gcd(uint32_t a, uint32_t b) {
+  while (b) {
+    uint32_t r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+/// Run a dilated convolution as one convolution of the stacked input
+/// sub-lattices of its output classes.  Dilations of 1 are a zdnn_conv2d().
+///
+/// \param[in] op_parm_block_version Parmblock version
+/// \param[in] input the input tensor, (N, H, W, C)
+/// \param[in] kernel the kernel tensor, (KH, KW, C, K)
+/// \param[in] bias the bias tensor, (K)
+/// \param[in] dilation_h distance between the input rows of kernel rows
+/// \param[in] dilation_w distance between the input columns of kernel columns
+/// \param[out] output the output tensor, (N, OH, OW, K)
+/// \param[in] fsp function specific parameters of the convolution
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_SHAPE
+///         ZDNN_INVALID_STRIDES
+///         ZDNN_INVALID_STRIDE_PADDING
+///         ZDNN_ALLOCATION_FAILURE
+///         a failure of the verification or of the NNPA convolution
+///
+zdnn_status aiu_conv2d_dilated_op(uint16_t op_parm_block_version,
+                                  const zdnn_ztensor *input,
+                                  const zdnn_ztensor *kernel,
+                                  const zdnn_ztensor *bias, uint32_t dilation_h,
+                                  uint32_t dilation_w, zdnn_ztensor *output,
+                                  function_specific_parameters *fsp) {
+  func_sp_parms_conv2d *fsp_conv2d = (func_sp_parms_conv2d *)fsp;
+  zdnn_status status;
+
+  if (!dilation_h || !dilation_w) {
+    return ZDNN_STATUS(ZDNN_INVALID_STRIDES,
+                       "dilation_height (%u) and dilation_width (%u) must be "
+                       "greater than 0",
+                       dilation_h, dilation_w);
+  }
+  if (dilation_h == 1 && dilation_w == 1) {
+    return aiu_conv2d_op(op_parm_block_version, input, kernel, bias, output,
+                         fsp);
+  }
+
+  if (!is_query_parmblock_installed(op_parm_block_version)) {
+    return ZDNN_UNAVAILABLE_FUNCTION;
+  }
+  if ((status = check_op_plan_recordable("dilated conv2d")) != ZDNN_OK) {
+    return status;
+  }
+  if ((status = check_lowered_strides(fsp_conv2d, "dilated conv2d")) !=
+      ZDNN_OK) {
+    return status;
+  }
+
+  const zdnn_tensor_desc *in_desc = input->transformed_desc;
+  const zdnn_tensor_desc *kernel_desc = kernel->transformed_desc;
+  const zdnn_tensor_desc *out_desc = output->transformed_desc;
+  // (height, width) of everything below
+  const uint32_t in_size[] = {in_desc->dim3, in_desc->dim2};
+  const uint32_t out_size[] = {out_desc->dim3, out_desc->dim2};
+  const uint32_t kernel_size[] = {kernel_desc->dim4, kernel_desc->dim3};
+  const uint32_t stride[] = {fsp_conv2d->parm3.stride_height,
+                             fsp_conv2d->parm2.stride_width};
+  const uint32_t dilation[] = {dilation_h, dilation_w};
+  uint32_t num_classes[2], sub_stride[2], sub_out[2], sub_in[2];
+  int64_t pad[2];
+
+  for (int i = 0; i < 2; i++) {
+    uint64_t span = (uint64_t)(kernel_size[i] - 1) * dilation[i] + 1;
+    uint64_t exp_out;
+
+    if (fsp_conv2d->parm1.pad == SAME_PADDING) {
+      exp_out = CEIL(in_size[i], stride[i]);
+      // the padding is split evenly, with the odd row or column at the end
+      pad[i] = MAX((int64_t)(exp_out - 1) * stride[i] + (int64_t)span -
+                       in_size[i],
+                   0) /
+               2;
+    } else {
+      exp_out = in_size[i] >= span ? CEIL(in_size[i] - span + 1, stride[i]) : 0;
+      pad[i] = 0;
+    }
+    if (!exp_out || out_size[i] != exp_out) {
+      return ZDNN_STATUS(ZDNN_INVALID_SHAPE,
+                         "output %s (%u) must be %" PRIu64
+                         " for an input %s of %u and a kernel spanning %" PRIu64,
+                         i ? "width" : "height", out_size[i], exp_out,
+                         i ? "width" : "height", in_size[i], span);
+    }
+
+    uint32_t g = gcd(stride[i], dilation[i]);
+    num_classes[i] = dilation[i] / g;
+    sub_stride[i] = stride[i] / g;
+    sub_out[i] = CEIL(out_size[i], num_classes[i]);
+    sub_in[i] = (sub_out[i] - 1) * sub_stride[i] + kernel_size[i];
+  }
+
+  const uint32_t batch = in_desc->dim4;
+  const uint32_t classes = num_classes[0] * num_classes[1];
+  function_specific_parameters sub_fsp = *fsp;
+  func_sp_parms_conv2d *sub_conv2d = (func_sp_parms_conv2d *)&sub_fsp;
+  sub_conv2d->parm1.pad = VALID_PADDING;
+  sub_conv2d->parm3.stride_height = sub_stride[0];
+  sub_conv2d->parm2.stride_width = sub_stride[1];
+
+  // the stacked classes are checked as the convolution the zAIU is given
+  zdnn_tensor_desc descs[] = {*in_desc, *kernel_desc, *bias->transformed_desc,
+                              *out_desc};
+  descs[0].dim4 *= classes;
+  descs[0].dim3 = sub_in[0];
+  descs[0].dim2 = sub_in[1];
+  descs[3].dim4 *= classes;
+  descs[3].dim3 = sub_out[0];
+  descs[3].dim2 = sub_out[1];
+  if ((status = verify_lowered_tensors(input, kernel, bias, output, descs,
+                                       &sub_fsp)) != ZDNN_OK) {
+    return status;
+  }
+
+  const uint32_t sub_in_dims[] = {classes * batch, sub_in[0], sub_in[1],
+                                  in_desc->dim1};
+  const uint32_t sub_out_dims[] = {classes * batch, sub_out[0], sub_out[1],
+                                   out_desc->dim1};
+  ztensor_tile sub_in_tile, sub_out_tile;
+
+  if ((status = init_zeroed_tile(input, ZDNN_NHWC, sub_in_dims,
+                                 &sub_in_tile)) != ZDNN_OK) {
+    return status;
+  }
+  if ((status = init_zeroed_tile(output, ZDNN_NHWC, sub_out_dims,
+                                 &sub_out_tile)) != ZDNN_OK) {
+    free_ztensor_tile(&sub_in_tile);
+    return status;
+  }
+
+  // space to batch: class (jh, jw) reads the input rows (jh * sh - pad_h) +
+  // i * dh and columns (jw * sw - pad_w) + i * dw
+  for (uint32_t jh = 0; jh < num_classes[0]; jh++) {
+    for (uint32_t jw = 0; jw < num_classes[1]; jw++) {
+      stick_lattice from = {input, 0, (int64_t)jh * stride[0] - pad[0],
+                            (int64_t)jw * stride[1] - pad[1], dilation[0],
+                            dilation[1], 0};
+      stick_lattice to = {&sub_in_tile.ztensor,
+                          (jh * num_classes[1] + jw) * batch, 0, 0, 1, 1, 0};
+      copy_lattice(&from, &to, batch, sub_in[0], sub_in[1], in_desc->dim1);
+    }
+  }
+
+  status = aiu_conv2d_op(op_parm_block_version, &sub_in_tile.ztensor, kernel,
+                         bias, &sub_out_tile.ztensor, &sub_fsp);
+
+  if (status == ZDNN_OK || (status & WARNING_STATUS_BITMASK) == ZDNN_WARNING) {
+    // batch to space: the output of class (jh, jw) goes to rows jh + q * Lh
+    // and columns jw + q * Lw
+    for (uint32_t jh = 0; jh < num_classes[0]; jh++) {
+      for (uint32_t jw = 0; jw < num_classes[1]; jw++) {
+        stick_lattice from = {&sub_out_tile.ztensor,
+                              (jh * num_classes[1] + jw) * batch, 0, 0, 1, 1,
+                              0};
+        stick_lattice to = {output, 0, jh, jw, num_classes[0], num_classes[1],
+                            0};
+        copy_lattice(&from, &to, batch, sub_out[0], sub_out[1],
+                     out_desc->dim1);
+      }
+    }
+    output->is_transformed = true;
+  }
+
+  free_ztensor_tile(&sub_out_tile);
+  free_ztensor_tile(&sub_in_tile);
+  return status;
+}
+
+/// Run a transposed convolution as one convolution of the input by the
+/// kernels of its output phases stacked along dim1
+///
+/// \param[in] op_parm_block_version Parmblock version
+/// \param[in] input the input tensor, (N, H, W, C)
+/// \param[in] kernel the kernel tensor, (KH, KW, C, K)
+/// \param[in] bias the bias tensor, (K)
+/// \param[out] output the output tensor, (N, OH, OW, K)
+/// \param[in] fsp function specific parameters of the convolution
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_SHAPE
+///         ZDNN_INVALID_STRIDES
+///         ZDNN_INVALID_STRIDE_PADDING
+///         ZDNN_ALLOCATION_FAILURE
+///         a failure of the verification or of the NNPA convolution
+///
+zdnn_status aiu_conv2d_transpose_op(uint16_t op_parm_block_version,
+                                    const zdnn_ztensor *input,
+                                    const zdnn_ztensor *kernel,
+                                    const zdnn_ztensor *bias,
+                                    zdnn_ztensor *output,
+                                    function_specific_parameters *fsp) {
+  func_sp_parms_conv2d *fsp_conv2d = (func_sp_parms_conv2d *)fsp;
+  zdnn_status status;
+
+  if (!is_query_parmblock_installed(op_parm_block_version)) {
+    return ZDNN_UNAVAILABLE_FUNCTION;
+  }
+  if ((status = check_op_plan_recordable("transposed conv2d")) != ZDNN_OK) {
+    return status;
+  }
+  if ((status = check_lowered_strides(fsp_conv2d, "transposed conv2d")) !=
+      ZDNN_OK) {
+    return status;
+  }
+
+  const zdnn_tensor_desc *in_desc = input->transformed_desc;
+  const zdnn_tensor_desc *kernel_desc = kernel->transformed_desc;
+  const zdnn_tensor_desc *out_desc = output->transformed_desc;
+  // (height, width) of everything below
+  const uint32_t in_size[] = {in_desc->dim3, in_desc->dim2};
+  const uint32_t out_size[] = {out_desc->dim3, out_desc->dim2};
+  const uint32_t kernel_size[] = {kernel_desc->dim4, kernel_desc->dim3};
+  const uint32_t stride[] = {fsp_conv2d->parm3.stride_height,
+                             fsp_conv2d->parm2.stride_width};
+  uint32_t taps[2], first_q[2], sub_out[2];
+  int64_t pad[2];
+
+  for (int i = 0; i < 2; i++) {
+    uint64_t exp_out = (uint64_t)in_size[i] * stride[i];
+
+    // the output a convolution with these strides and padding would take the
+    // input from, with the odd padding row or column at the end
+    if (fsp_conv2d->parm1.pad == SAME_PADDING) {
+      pad[i] = MAX((int64_t)kernel_size[i] - stride[i], 0) / 2;
+    } else {
+      exp_out += MAX((int64_t)kernel_size[i] - stride[i], 0);
+      pad[i] = 0;
+    }
+    if (out_size[i] != exp_out) {
+      return ZDNN_STATUS(ZDNN_INVALID_SHAPE,
+                         "output %s (%u) must be %" PRIu64
+                         " for an input %s of %u",
+                         i ? "width" : "height", out_size[i], exp_out,
+                         i ? "width" : "height", in_size[i]);
+    }
+
+    // output row oh is in phase (oh + pad) % s at (oh + pad) / s, which reads
+    // taps input rows up to it
+    taps[i] = CEIL(kernel_size[i], stride[i]);
+    first_q[i] = pad[i] / stride[i];
+    sub_out[i] = (out_size[i] - 1 + pad[i]) / stride[i] - first_q[i] + 1;
+  }
+
+  const uint32_t phases = stride[0] * stride[1];
+  const uint32_t channels_in = in_desc->dim1, channels_out = out_desc->dim1;
+  function_specific_parameters sub_fsp = *fsp;
+  func_sp_parms_conv2d *sub_conv2d = (func_sp_parms_conv2d *)&sub_fsp;
+  sub_conv2d->parm1.pad = VALID_PADDING;
+  sub_conv2d->parm3.stride_height = 1;
+  sub_conv2d->parm2.stride_width = 1;
+
+  const uint32_t sub_in[] = {sub_out[0] + taps[0] - 1,
+                             sub_out[1] + taps[1] - 1};
+  // the stacked phases are checked as the convolution the zAIU is given
+  zdnn_tensor_desc descs[] = {*in_desc, *kernel_desc, *bias->transformed_desc,
+                              *out_desc};
+  descs[0].dim3 = sub_in[0];
+  descs[0].dim2 = sub_in[1];
+  descs[1].dim4 = taps[0];
+  descs[1].dim3 = taps[1];
+  descs[1].dim1 *= phases;
+  descs[2].dim1 *= phases;
+  descs[3].dim3 = sub_out[0];
+  descs[3].dim2 = sub_out[1];
+  descs[3].dim1 *= phases;
+  if ((status = verify_lowered_tensors(input, kernel, bias, output, descs,
+                                       &sub_fsp)) != ZDNN_OK) {
+    return status;
+  }
+
+  const uint32_t sub_in_dims[] = {in_desc->dim4, sub_in[0], sub_in[1],
+                                  channels_in};
+  const uint32_t sub_kernel_dims[] = {taps[0], taps[1], channels_in,
+                                      phases * channels_out};
+  const uint32_t sub_bias_dims[] = {1, 1, 1, phases * channels_out};
+  const uint32_t sub_out_dims[] = {out_desc->dim4, sub_out[0], sub_out[1],
+                                   phases * channels_out};
+  ztensor_tile tiles[4];
+  int num_tiles = 0;
+
+  status = init_zeroed_tile(input, ZDNN_NHWC, sub_in_dims, &tiles[0]);
+  if (status == ZDNN_OK) {
+    num_tiles++;
+    status = init_zeroed_tile(kernel, ZDNN_HWCK, sub_kernel_dims, &tiles[1]);
+  }
+  if (status == ZDNN_OK) {
+    num_tiles++;
+    status = init_zeroed_tile(bias, ZDNN_1D, sub_bias_dims, &tiles[2]);
+  }
+  if (status == ZDNN_OK) {
+    num_tiles++;
+    status = init_zeroed_tile(output, ZDNN_NHWC, sub_out_dims, &tiles[3]);
+  }
+
+  if (status == ZDNN_OK) {
+    num_tiles++;
+
+    // sub-output row t (q = first_q + t) reads input rows q - taps + 1 on
+    stick_lattice from = {input, 0, (int64_t)first_q[0] - taps[0] + 1,
+                          (int64_t)first_q[1] - taps[1] + 1, 1, 1, 0};
+    stick_lattice to = {&tiles[0].ztensor, 0, 0, 0, 1, 1, 0};
+    copy_lattice(&from, &to, in_desc->dim4, sub_in[0], sub_in[1],
+                 channels_in);
+
+    // phase (rh, rw) has kernel rows rh + m * sh, flipped so that the last
+    // input row read goes with m = 0
+    for (uint32_t rh = 0; rh < stride[0]; rh++) {
+      for (uint32_t rw = 0; rw < stride[1]; rw++) {
+        const uint32_t phase = rh * stride[1] + rw;
+        const uint32_t bias_start[] = {0, 0, 0, phase * channels_out};
+        const uint32_t tap_count[] = {1, 1, channels_in, channels_out};
+
+        // taps past the kernel's edge stay zero
+        for (uint32_t mh = 0; mh < taps[0]; mh++) {
+          uint32_t ky = rh + (taps[0] - 1 - mh) * stride[0];
+          if (ky >= kernel_size[0]) {
+            continue;
+          }
+          for (uint32_t mw = 0; mw < taps[1]; mw++) {
+            uint32_t kx = rw + (taps[1] - 1 - mw) * stride[1];
+            if (kx >= kernel_size[1]) {
+              continue;
+            }
+            const uint32_t from_start[] = {ky, kx, 0, 0};
+            const uint32_t to_start[] = {mh, mw, 0, phase * channels_out};
+            copy_kernel_range(kernel, from_start, &tiles[1].ztensor,
+                              to_start, tap_count);
+          }
+        }
+        copy_ztensor_range(&tiles[2].ztensor, bias, bias_start, true);
+      }
+    }
+
+    status = aiu_conv2d_op(op_parm_block_version, &tiles[0].ztensor,
+                           &tiles[1].ztensor, &tiles[2].ztensor,
+                           &tiles[3].ztensor, &sub_fsp);
+  }
+
+  if (status == ZDNN_OK || (status & WARNING_STATUS_BITMASK) == ZDNN_WARNING) {
+    // depth to space: the channels of phase (rh, rw) at sub-output row t go
+    // to output row (first_q + t) * sh + rh - pad_h
+    for (uint32_t rh = 0; rh < stride[0]; rh++) {
+      for (uint32_t rw = 0; rw < stride[1]; rw++) {
+        stick_lattice from = {&tiles[3].ztensor, 0, 0, 0, 1, 1,
+                              (rh * stride[1] + rw) * channels_out};
+        stick_lattice to = {output,
+                            0,
+                            (int64_t)first_q[0] * stride[0] + rh - pad[0],
+                            (int64_t)first_q[1] * stride[1] + rw - pad[1],
+                            stride[0],
+                            stride[1],
+                            0};
+        copy_lattice(&from, &to, out_desc->dim4, sub_out[0], sub_out[1],
+                     channels_out);
+      }
+    }
+    output->is_transformed = true;
+  }
+
+  while (num_tiles--) {
+    free_ztensor_tile(&tiles[num_tiles]);
+  }
+  return status;
+}
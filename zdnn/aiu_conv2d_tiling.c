@@ -0,0 +1,615 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "zdnn.h"
+#include "zdnn_private.h"
+
+/*
+  A convolution beyond the NNPA maximum dimension index sizes, the maximum
+  tensor size or the largest kernel the zAIU convolves is run as a grid of
+  VALID-padded convolutions on tiles that are within them:
+
+    output[n, oh, ow, k] = sum over (ky, kx, c) of
+                             input[n, oh * sh + ky - pad_h,
+                                      ow * sw + kx - pad_w, c] *
+                             kernel[ky, kx, c, k]  (+ bias[k] once)
+
+  The output is split into tiles of (N, OH, OW, K).  Every output tile reads
+  the input rows and columns its kernel window covers, the halo, which for an
+  output tile of ohc rows starting at oh0 are the (ohc - 1) * sh + kh rows
+  starting at oh0 * sh - pad_h.  Halo rows and columns outside of the input
+  are the SAME padding, so input tiles that reach past an edge are copied into
+  a zeroed temporary tile.
+
+  When the kernel height, width or input channels (C) need splitting as well,
+  every (KH, KW, C) tile of the kernel adds its partial convolution, computed
+  with a zero bias and no activation, to the output tile with an NNPA add, and
+  the activation is applied to the sum.  Partial sums are DLFLOAT16, so
+  results can differ from an untiled convolution by the rounding of each add.
+
+  Tiles are set up by init_ztensor_tile() where they can be, as views of their
+  tensor where the stick layout allows and as temporary copies otherwise.
+*/
+
+// largest kernel height and width the zAIU convolves with nonzero strides,
+// and with zero strides (where the kernel covers the whole input)
+#define CONV2D_MAX_KERNEL 64
+#define CONV2D_ZERO_STRIDES_MAX_KERNEL 448
+
+// how a tiled convolution is laid out
+typedef struct conv2d_tiling {
+  uint16_t op_parm_block_version;
+  const zdnn_ztensor *input;
+  const zdnn_ztensor *kernel;
+  const zdnn_ztensor *bias;
+  zdnn_ztensor *output;
+  uint32_t stride_h;
+  uint32_t stride_w;
+  int64_t pad_h; // leading SAME padding rows
+  int64_t pad_w; // leading SAME padding columns
+  uint32_t act;
+  uint16_t clipping_value;
+  // tile sizes along the output's (N, OH, OW, K) and the kernel's (KH, KW, C)
+  uint32_t out_tile[ZDNN_MAX_DIMS];
+  uint32_t kernel_tile[3];
+} conv2d_tiling;
+
+/// Number of input rows (or columns) that a tile of output rows and kernel
+/// rows covers
+static uint32_t get_halo_size(uint32_t out_count, uint32_t stride,
+                              uint32_t kernel_count) {
+  return (out_count - 1) * stride + kernel_count;
+}
+
+/// Check whether a convolution can be given to the zAIU as it is
+///
+/// \param[in] input the input tensor
+/// \param[in] kernel the kernel tensor
+/// \param[in] bias the bias tensor
+/// \param[in] output the output tensor
+/// \param[in] fsp function specific parameters of the convolution
+///
+/// \return true if the convolution doesn't need tiling
+///
+static bool is_conv2d_within_nnpa_limits(const zdnn_ztensor *input,
+                                         const zdnn_ztensor *kernel,
+                                         const zdnn_ztensor *bias,
+                                         const zdnn_ztensor *output,
+                                         const func_sp_parms_conv2d *fsp) {
+  const zdnn_tensor_desc *kernel_desc = kernel->transformed_desc;
+  const uint32_t max_kernel =
+      (fsp->parm2.stride_width || fsp->parm3.stride_height)
+          ? CONV2D_MAX_KERNEL
+          : CONV2D_ZERO_STRIDES_MAX_KERNEL;
+
+  return is_within_nnpa_limits(input->transformed_desc) &&
+         is_within_nnpa_limits(kernel_desc) &&
+         is_within_nnpa_limits(bias->transformed_desc) &&
+         is_within_nnpa_limits(output->transformed_desc) &&
+         kernel_desc->dim4 <= max_kernel && kernel_desc->dim3 <= max_kernel;
+}
+
+/// Set up a range of the input for a tile convolution, zero-filling the rows
+/// and columns of the range that are outside of the input
+///
+/// \param[in] input the input tensor
+/// \param[in] start first index of the range, dim4 first, dim3 and dim2 may
+///                  be negative
+/// \param[in] count number of indices of the range, dim4 first
+/// \param[out] tile the tile
+///
+/// \return ZDNN_OK
+///         ZDNN_ALLOCATION_FAILURE
+///
+static zdnn_status init_input_tile(const zdnn_ztensor *input,
+                                   const int64_t *start, const uint32_t *count,
+                                   ztensor_tile *tile) {
+  const zdnn_tensor_desc *in_desc = input->transformed_desc;
+  const int64_t dims[] = {in_desc->dim3, in_desc->dim2};
+  uint32_t inner_start[ZDNN_MAX_DIMS] = {(uint32_t)start[0], 0, 0,
+                                         (uint32_t)start[3]};
+  uint32_t inner_count[ZDNN_MAX_DIMS] = {count[0], 0, 0, count[3]};
+  uint32_t pad_start[ZDNN_MAX_DIMS] = {0, 0, 0, 0};
+  bool is_inside = true;
+  zdnn_status status;
+
+  for (int i = 0; i < 2; i++) {
+    int64_t lo = MAX(start[i + 1], 0);
+    int64_t hi = MIN(start[i + 1] + count[i + 1], dims[i]);
+
+    inner_start[i + 1] = (uint32_t)lo;
+    inner_count[i + 1] = hi > lo ? (uint32_t)(hi - lo) : 0;
+    pad_start[i + 1] = (uint32_t)(lo - start[i + 1]);
+    is_inside &= inner_count[i + 1] == count[i + 1];
+  }
+
+  if (is_inside) {
+    return init_ztensor_tile(input, inner_start, count, true, tile);
+  }
+
+  tile->tfrmd_desc = *in_desc;
+  tile->tfrmd_desc.dim4 = count[0];
+  tile->tfrmd_desc.dim3 = count[1];
+  tile->tfrmd_desc.dim2 = count[2];
+  tile->tfrmd_desc.dim1 = count[3];
+  zdnn_init_pre_transformed_desc(ZDNN_NHWC, input->pre_transformed_desc->type,
+                                 &tile->pre_tfrmd_desc, count[0], count[1],
+                                 count[2], count[3]);
+  tile->is_view = false;
+  if ((status = zdnn_init_ztensor_with_malloc(
+           &tile->pre_tfrmd_desc, &tile->tfrmd_desc, &tile->ztensor)) !=
+      ZDNN_OK) {
+    return status;
+  }
+  memset(tile->ztensor.buffer, 0, tile->ztensor.buffer_size);
+  tile->ztensor.is_transformed = true;
+
+  if (inner_count[1] && inner_count[2]) {
+    ztensor_tile inner;
+
+    if ((status = init_ztensor_tile(input, inner_start, inner_count, true,
+                                    &inner)) != ZDNN_OK) {
+      free_ztensor_tile(tile);
+      return status;
+    }
+    copy_ztensor_range(&tile->ztensor, &inner.ztensor, pad_start, true);
+    free_ztensor_tile(&inner);
+  }
+  return ZDNN_STATUS_OK;
+}
+
+/// Copy a range of a 4DKERNEL tensor into a range of another, cell by cell
+/// in runs that don't cross a stick of either tensor
+///
+/// \param[in] from the kernel tensor copied from
+/// \param[in] from_start first index of the range in from, dim4 first
+/// \param[in] to the kernel tensor copied into
+/// \param[in] to_start first index of the range in to, dim4 first
+/// \param[in] count number of indices of the range in each dim, dim4 first
+///
+/// \return None
+///
+void copy_kernel_range(const zdnn_ztensor *from, const uint32_t *from_start,
+                       const zdnn_ztensor *to, const uint32_t *to_start,
+                       const uint32_t *count) {
+  for (uint32_t kh = 0; kh < count[0]; kh++) {
+    for (uint32_t kw = 0; kw < count[1]; kw++) {
+      for (uint32_t c = 0; c < count[2]; c++) {
+        uint32_t k = 0;
+        while (k < count[3]) {
+          uint32_t run =
+              MIN(MIN(AIU_2BYTE_CELLS_PER_STICK -
+                          (from_start[3] + k) % AIU_2BYTE_CELLS_PER_STICK,
+                      AIU_2BYTE_CELLS_PER_STICK -
+                          (to_start[3] + k) % AIU_2BYTE_CELLS_PER_STICK),
+                  count[3] - k);
+          memcpy((char *)to->buffer +
+                     get_stick_offset(to_start[0] + kh, to_start[1] + kw,
+                                      to_start[2] + c, to_start[3] + k,
+                                      to->transformed_desc),
+                 (char *)from->buffer +
+                     get_stick_offset(from_start[0] + kh, from_start[1] + kw,
+                                      from_start[2] + c, from_start[3] + k,
+                                      from->transformed_desc),
+                 run * AIU_2BYTE_CELL_SIZE);
+          k += run;
+        }
+      }
+    }
+  }
+}
+
+/// Set up a range of a 4DKERNEL tensor for a tile convolution, as a view of
+/// the kernel when only whole dim1 sticks of it are taken and as a temporary
+/// copy otherwise
+///
+/// \param[in] kernel the kernel tensor
+/// \param[in] start first index of the range in each dim, dim4 first
+/// \param[in] count number of indices of the range in each dim, dim4 first
+/// \param[out] tile the tile
+///
+/// \return ZDNN_OK
+///         ZDNN_ALLOCATION_FAILURE
+///
+static zdnn_status init_kernel_tile(const zdnn_ztensor *kernel,
+                                    const uint32_t *start,
+                                    const uint32_t *count,
+                                    ztensor_tile *tile) {
+  const zdnn_tensor_desc *kernel_desc = kernel->transformed_desc;
+  zdnn_status status;
+
+  tile->tfrmd_desc = *kernel_desc;
+  tile->tfrmd_desc.dim4 = count[0];
+  tile->tfrmd_desc.dim3 = count[1];
+  tile->tfrmd_desc.dim2 = count[2];
+  tile->tfrmd_desc.dim1 = count[3];
+  zdnn_init_pre_transformed_desc(ZDNN_HWCK, kernel->pre_transformed_desc->type,
+                                 &tile->pre_tfrmd_desc, count[0], count[1],
+                                 count[2], count[3]);
+
+  // dim1 stick groups are outermost in a 4DKERNEL stick area, each laid out
+  // as a kernel of 64 dim1 cells
+  tile->is_view = count[0] == kernel_desc->dim4 &&
+                  count[1] == kernel_desc->dim3 &&
+                  count[2] == kernel_desc->dim2 &&
+                  start[3] % AIU_2BYTE_CELLS_PER_STICK == 0;
+  if (tile->is_view) {
+    tile->ztensor = *kernel;
+    tile->ztensor.pre_transformed_desc = &tile->pre_tfrmd_desc;
+    tile->ztensor.transformed_desc = &tile->tfrmd_desc;
+    tile->ztensor.buffer_size = zdnn_getsize_ztensor(&tile->tfrmd_desc);
+    tile->ztensor.buffer =
+        (char *)kernel->buffer +
+        get_stick_offset(0, 0, 0, start[3], kernel_desc);
+    return ZDNN_STATUS_OK;
+  }
+
+  if ((status = zdnn_init_ztensor_with_malloc(
+           &tile->pre_tfrmd_desc, &tile->tfrmd_desc, &tile->ztensor)) !=
+      ZDNN_OK) {
+    return status;
+  }
+  memset(tile->ztensor.buffer, 0, tile->ztensor.buffer_size);
+
+  const uint32_t zeros[] = {0, 0, 0, 0};
+  copy_kernel_range(kernel, start, &tile->ztensor, zeros, count);
+  tile->ztensor.is_transformed = true;
+  return ZDNN_STATUS_OK;
+}
+
+/// Run the convolution of one kernel tile for one output tile
+///
+/// \param[in] t the tiling
+/// \param[in] out_start first index of the output tile, dim4 first
+/// \param[in] out_count number of indices of the output tile, dim4 first
+/// \param[in] kernel_start first (KH, KW, C) index of the kernel tile
+/// \param[in] kernel_count number of (KH, KW, C) indices of the kernel tile
+/// \param[in] bias bias tile
+/// \param[in] act activation of the tile convolution
+/// \param[out] output output of the tile convolution
+///
+/// \return ZDNN_OK
+///         ZDNN_ALLOCATION_FAILURE
+///         a failure of the NNPA convolution
+///
+static zdnn_status conv2d_tile(const conv2d_tiling *t,
+                               const uint32_t *out_start,
+                               const uint32_t *out_count,
+                               const uint32_t *kernel_start,
+                               const uint32_t *kernel_count,
+                               const zdnn_ztensor *bias, uint32_t act,
+                               zdnn_ztensor *output) {
+  const int64_t in_start[] = {
+      out_start[0],
+      (int64_t)out_start[1] * t->stride_h + kernel_start[0] - t->pad_h,
+      (int64_t)out_start[2] * t->stride_w + kernel_start[1] - t->pad_w,
+      kernel_start[2]};
+  const uint32_t in_count[] = {
+      out_count[0], get_halo_size(out_count[1], t->stride_h, kernel_count[0]),
+      get_halo_size(out_count[2], t->stride_w, kernel_count[1]),
+      kernel_count[2]};
+  const uint32_t k_start[] = {kernel_start[0], kernel_start[1],
+                              kernel_start[2], out_start[3]};
+  const uint32_t k_count[] = {kernel_count[0], kernel_count[1],
+                              kernel_count[2], out_count[3]};
+  ztensor_tile in_tile, kernel_tile;
+  zdnn_status status;
+
+  if ((status = init_input_tile(t->input, in_start, in_count, &in_tile)) !=
+      ZDNN_OK) {
+    return status;
+  }
+  if ((status = init_kernel_tile(t->kernel, k_start, k_count,
+                                 &kernel_tile)) != ZDNN_OK) {
+    free_ztensor_tile(&in_tile);
+    return status;
+  }
+
+  // the halo makes every tile a VALID convolution of its input tile
+  function_specific_parameters fsp;
+  memset(&fsp, 0, sizeof(function_specific_parameters));
+  func_sp_parms_conv2d *fsp_conv2d = (func_sp_parms_conv2d *)&fsp;
+  fsp_conv2d->parm1.act = act;
+  fsp_conv2d->parm1.pad = VALID_PADDING;
+  fsp_conv2d->parm2.stride_width = t->stride_w;
+  fsp_conv2d->parm3.stride_height = t->stride_h;
+  fsp_conv2d->parm4.clipping_value = t->clipping_value;
+
+  status = aiu_ops_func_specific(t->op_parm_block_version, NNPA_CONVOLUTION,
+                                 &in_tile.ztensor, &kernel_tile.ztensor, bias,
+                                 output, NULL, 0, &fsp);
+
+  free_ztensor_tile(&kernel_tile);
+  free_ztensor_tile(&in_tile);
+  return status;
+}
+
+/// Compute one output tile of a tiled convolution
+///
+/// \param[in] t the tiling
+/// \param[in] out_start first index of the output tile, dim4 first
+/// \param[in] out_count number of indices of the output tile, dim4 first
+///
+/// \return ZDNN_OK
+///         ZDNN_ALLOCATION_FAILURE
+///         a failure of one of the NNPA operations
+///
+static zdnn_status conv2d_output_tile(const conv2d_tiling *t,
+                                      const uint32_t *out_start,
+                                      const uint32_t *out_count) {
+  const zdnn_tensor_desc *kernel_desc = t->kernel->transformed_desc;
+  const uint32_t kernel_dims[] = {kernel_desc->dim4, kernel_desc->dim3,
+                                  kernel_desc->dim2};
+  const bool is_split = kernel_dims[0] > t->kernel_tile[0] ||
+                        kernel_dims[1] > t->kernel_tile[1] ||
+                        kernel_dims[2] > t->kernel_tile[2];
+
+  ztensor_tile out_tile, bias_tile;
+  tile_sum sum;
+  zdnn_status status;
+
+  uint32_t bias_start[] = {0, 0, 0, out_start[3]};
+  uint32_t bias_count[] = {1, 1, 1, out_count[3]};
+
+  if ((status = init_ztensor_tile(t->output, out_start, out_count, false,
+                                  &out_tile)) != ZDNN_OK) {
+    return status;
+  }
+  if ((status = init_ztensor_tile(t->bias, bias_start, bias_count, true,
+                                  &bias_tile)) != ZDNN_OK) {
+    free_ztensor_tile(&out_tile);
+    return status;
+  }
+  init_tile_sum(&out_tile, &bias_tile, &sum);
+
+  uint32_t start[3], count[3];
+  bool first = true;
+
+  for (start[0] = 0; status == ZDNN_OK && start[0] < kernel_dims[0];
+       start[0] += t->kernel_tile[0]) {
+    count[0] = MIN(t->kernel_tile[0], kernel_dims[0] - start[0]);
+    for (start[1] = 0; status == ZDNN_OK && start[1] < kernel_dims[1];
+         start[1] += t->kernel_tile[1]) {
+      count[1] = MIN(t->kernel_tile[1], kernel_dims[1] - start[1]);
+      for (start[2] = 0; status == ZDNN_OK && start[2] < kernel_dims[2];
+           start[2] += t->kernel_tile[2]) {
+        count[2] = MIN(t->kernel_tile[2], kernel_dims[2] - start[2]);
+
+        if (first) {
+          // the activation can only be applied to the whole sum
+          status = conv2d_tile(t, out_start, out_count, start, count,
+                               &bias_tile.ztensor,
+                               is_split ? CONV2D_ACT_NONE : t->act, sum.acc);
+          first = false;
+        } else if ((status = next_tile_sum_part(&sum)) == ZDNN_OK &&
+                   (status = conv2d_tile(t, out_start, out_count, start,
+                                         count, &sum.zero_bias.ztensor,
+                                         CONV2D_ACT_NONE,
+                                         &sum.part.ztensor)) == ZDNN_OK) {
+          status = add_tile_sum_part(&sum);
+        }
+      }
+    }
+  }
+
+  if (status == ZDNN_OK && is_split && t->act == CONV2D_ACT_RELU) {
+    function_specific_parameters fsp;
+    memset(&fsp, 0, sizeof(function_specific_parameters));
+    func_sp_parms_relu *fsp_relu = (func_sp_parms_relu *)&fsp;
+    fsp_relu->parm1.clipping_value = t->clipping_value;
+
+    // other is the output tile when acc isn't, and a temporary otherwise
+    if ((status = aiu_ops_func_specific(t->op_parm_block_version, NNPA_RELU,
+                                        sum.acc, NULL, NULL, sum.other, NULL,
+                                        0, &fsp)) == ZDNN_OK) {
+      sum.acc = sum.other;
+    }
+  }
+
+  if (status == ZDNN_OK) {
+    store_tile_sum(t->output, out_start, &sum);
+  }
+
+  free_tile_sum(&sum);
+  free_ztensor_tile(&bias_tile);
+  free_ztensor_tile(&out_tile);
+  return status;
+}
+
+/// Work out the tile sizes of a tiled convolution, the largest ones within
+/// the NNPA maximum dimension index sizes and maximum tensor size
+///
+/// \param[in,out] t the tiling, with the tensors and strides set
+///
+/// \return ZDNN_OK
+///         ZDNN_EXCEEDS_MTS
+///
+static zdnn_status init_tile_sizes(conv2d_tiling *t) {
+  const zdnn_tensor_desc *in_desc = t->input->transformed_desc;
+  const zdnn_tensor_desc *kernel_desc = t->kernel->transformed_desc;
+  const zdnn_tensor_desc *out_desc = t->output->transformed_desc;
+  const uint32_t max_dim4 = zdnn_get_max_for_dim(4);
+  const uint32_t max_dim3 = zdnn_get_max_for_dim(3);
+  const uint32_t max_dim2 = zdnn_get_max_for_dim(2);
+  const uint32_t max_dim1 = zdnn_get_max_for_dim(1);
+  const uint64_t max_size = zdnn_get_nnpa_max_tensor_size();
+  uint32_t *kt = t->kernel_tile, *ot = t->out_tile;
+
+  // the kernel's KH, KW and C are dim4, dim3 and dim2 of the kernel and dim3,
+  // dim2 and dim1 of the input tile
+  kt[0] = MIN(kernel_desc->dim4,
+              MIN(CONV2D_MAX_KERNEL, MIN(max_dim4, max_dim3)));
+  kt[1] = MIN(kernel_desc->dim3,
+              MIN(CONV2D_MAX_KERNEL, MIN(max_dim3, max_dim2)));
+  kt[2] = MIN(kernel_desc->dim2,
+              get_tile_size(MIN(max_dim2, max_dim1),
+                            AIU_2BYTE_CELLS_PER_STICK));
+
+  // output tiles along OW start on a page of sticks and along K on a stick,
+  // so whole-row output tiles are views of the output and K tiles of the
+  // kernel are views of the kernel
+  ot[0] = MIN(out_desc->dim4, max_dim4);
+  ot[1] = MIN(out_desc->dim3, (max_dim3 - kt[0]) / t->stride_h + 1);
+  ot[2] = MIN(out_desc->dim2,
+              get_tile_size((max_dim2 - kt[1]) / t->stride_w + 1,
+                            AIU_STICKS_PER_PAGE));
+  ot[3] = MIN(out_desc->dim1,
+              get_tile_size(max_dim1, AIU_2BYTE_CELLS_PER_STICK));
+
+  while (get_tile_bytes(kernel_desc, kt[0], kt[1], kt[2], ot[3]) > max_size) {
+    if (!shrink_tile_size(&ot[3], AIU_2BYTE_CELLS_PER_STICK) &&
+        !shrink_tile_size(&kt[2], AIU_STICKS_PER_PAGE) &&
+        !shrink_tile_size(&kt[0], 1) && !shrink_tile_size(&kt[1], 1)) {
+      return ZDNN_STATUS(ZDNN_EXCEEDS_MTS,
+                         "A single kernel stick is larger than %" PRIu64
+                         " bytes",
+                         max_size);
+    }
+  }
+
+  while (get_tile_bytes(in_desc, ot[0],
+                        get_halo_size(ot[1], t->stride_h, kt[0]),
+                        get_halo_size(ot[2], t->stride_w, kt[1]),
+                        kt[2]) > max_size ||
+         get_tile_bytes(out_desc, ot[0], ot[1], ot[2], ot[3]) > max_size) {
+    if (!shrink_tile_size(&ot[0], 1) && !shrink_tile_size(&ot[1], 1) &&
+        !shrink_tile_size(&ot[2], AIU_STICKS_PER_PAGE) &&
+        !shrink_tile_size(&ot[3], AIU_2BYTE_CELLS_PER_STICK) &&
+        !shrink_tile_size(&kt[2], AIU_2BYTE_CELLS_PER_STICK)) {
+      return ZDNN_STATUS(ZDNN_EXCEEDS_MTS,
+                         "A single kernel window is larger than %" PRIu64
+                         " bytes",
+                         max_size);
+    }
+  }
+  return ZDNN_STATUS_OK;
+}
+
+/// Run a 2D convolution, tiling it into convolutions within the NNPA maximum
+/// dimension index sizes, maximum tensor size and kernel size when its tensors
+/// are beyond them
+///
+/// \param[in] op_parm_block_version Parmblock version
+/// \param[in] input the input tensor
+/// \param[in] kernel the kernel tensor
+/// \param[in] bias the bias tensor
+/// \param[out] output the output tensor
+/// \param[in] fsp function specific parameters of the convolution
+///
+/// \return ZDNN_OK
+///         ZDNN_EXCEEDS_MTS
+///         ZDNN_ALLOCATION_FAILURE
+///         a failure of the verification or of one of the NNPA operations
+///
+zdnn_status aiu_conv2d_op(uint16_t op_parm_block_version,
+                          const zdnn_ztensor *input,
+                          const zdnn_ztensor *kernel, const zdnn_ztensor *bias,
+                          zdnn_ztensor *output,
+                          function_specific_parameters *fsp) {
+  func_sp_parms_conv2d *fsp_conv2d = (func_sp_parms_conv2d *)fsp;
+  zdnn_status status;
+
+  // padding and activations the zAIU doesn't know are left for it to reject
+  if (is_conv2d_within_nnpa_limits(input, kernel, bias, output, fsp_conv2d) ||
+      (fsp_conv2d->parm1.pad != VALID_PADDING &&
+       fsp_conv2d->parm1.pad != SAME_PADDING) ||
+      (fsp_conv2d->parm1.act != CONV2D_ACT_NONE &&
+       fsp_conv2d->parm1.act != CONV2D_ACT_RELU)) {
+    return aiu_ops_func_specific(op_parm_block_version, NNPA_CONVOLUTION,
+                                 input, kernel, bias, output, NULL, 0, fsp);
+  }
+
+  if (!is_query_parmblock_installed(op_parm_block_version)) {
+    return ZDNN_UNAVAILABLE_FUNCTION;
+  }
+  if ((status = check_op_plan_recordable("tiled conv2d")) != ZDNN_OK) {
+    return status;
+  }
+
+  // the tile operations only verify their tiles, so verify the whole
+  // convolution up front
+  if ((status = verify_conv2d_tensors(
+           input, kernel, bias, &fsp->function_specific_parm1,
+           &fsp->function_specific_parm2, &fsp->function_specific_parm3,
+           &fsp->function_specific_parm4, output)) != ZDNN_OK) {
+    return status;
+  }
+
+  const zdnn_tensor_desc *in_desc = input->transformed_desc;
+  const zdnn_tensor_desc *kernel_desc = kernel->transformed_desc;
+  const zdnn_tensor_desc *out_desc = output->transformed_desc;
+  conv2d_tiling t;
+
+  t.op_parm_block_version = op_parm_block_version;
+  t.input = input;
+  t.kernel = kernel;
+  t.bias = bias;
+  t.output = output;
+  t.act = fsp_conv2d->parm1.act;
+  t.clipping_value = fsp_conv2d->parm4.clipping_value;
+
+  // with zero strides the kernel covers the whole input, which is a VALID
+  // convolution with strides of 1
+  t.stride_h = fsp_conv2d->parm3.stride_height ? fsp_conv2d->parm3.stride_height
+                                                : 1;
+  t.stride_w = fsp_conv2d->parm2.stride_width ? fsp_conv2d->parm2.stride_width
+                                               : 1;
+  t.pad_h = 0;
+  t.pad_w = 0;
+  if (fsp_conv2d->parm1.pad == SAME_PADDING) {
+    // the padding is split evenly, with the odd row or column at the end
+    t.pad_h = MAX((int64_t)(out_desc->dim3 - 1) * t.stride_h +
+                      kernel_desc->dim4 - in_desc->dim3,
+                  0) /
+              2;
+    t.pad_w = MAX((int64_t)(out_desc->dim2 - 1) * t.stride_w +
+                      kernel_desc->dim3 - in_desc->dim2,
+                  0) /
+              2;
+  }
+
+  if ((status = init_tile_sizes(&t)) != ZDNN_OK) {
+    return status;
+  }
+
+  const uint32_t out_dims[] = {out_desc->dim4, out_desc->dim3, out_desc->dim2,
+                               out_desc->dim1};
+  uint32_t start[ZDNN_MAX_DIMS], count[ZDNN_MAX_DIMS];
+
+  for (start[0] = 0; start[0] < out_dims[0]; start[0] += t.out_tile[0]) {
+    count[0] = MIN(t.out_tile[0], out_dims[0] - start[0]);
+    for (start[3] = 0; start[3] < out_dims[3]; start[3] += t.out_tile[3]) {
+      count[3] = MIN(t.out_tile[3], out_dims[3] - start[3]);
+      for (start[1] = 0; start[1] < out_dims[1]; start[1] += t.out_tile[1]) {
+        count[1] = MIN(t.out_tile[1], out_dims[1] - start[1]);
+        for (start[2] = 0; start[2] < out_dims[2];
+             start[2] += t.out_tile[2]) {
+          count[2] = MIN(t.out_tile[2], out_dims[2] - start[2]);
+
+          if ((status = conv2d_output_tile(&t, start, count)) != ZDNN_OK) {
+            return status;
+          }
+        }
+      }
+    }
+  }
+
+  output->is_transformed = true;
+  return ZDNN_STATUS_OK;
+}
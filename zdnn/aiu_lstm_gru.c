@@ -17,9 +17,18 @@
 
 #include "zdnn.h"
 #include "zdnn_private.h"
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __MVS__
+#pragma export(zdnn_create_lstm_session)
+#pragma export(zdnn_create_gru_session)
+#pragma export(zdnn_reset_rnn_session)
+#pragma export(zdnn_rnn_session_step)
+#pragma export(zdnn_free_rnn_session)
+#endif
+
 // External users only need to specify between FWD, BWD, and BIDIR. However our
 // directional_rnn() needs more detail. FWD vs BWD controls the order the
 // timestep input is processed along with UNI vs BIDIR which affects how we move
@@ -652,10 +661,53 @@ directional_rnn(const uint16_t op_parm_block_version, uint8_t function_code,
   return ZDNN_STATUS_OK;
 }
 
+// Both directions of a BIDIR call, direction 0 being FWD and 1 BWD
+typedef struct bidir_rnn_job {
+  uint16_t op_parm_block_version;
+  uint8_t function_code;
+  const uint32_t *nums;
+  const zdnn_ztensor *input;
+  const zdnn_ztensor **sliced_inputs[2];
+  zdnn_ztensor *hn_output;
+  zdnn_ztensor *cf_output;
+  void *work_area;
+  size_t dir_work_area_size;
+  work_area_descriptor *wa_descs;
+  zdnn_status status[2];
+} bidir_rnn_job;
+
+// Run directions [begin, end) of a BIDIR call.  The directions write disjoint
+// halves of hn_output/cf_output and use their own part of the work area, so
+// they can run concurrently.
+static void bidir_rnn_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  bidir_rnn_job *job = (bidir_rnn_job *)ctx;
+
+  for (uint64_t dir_idx = begin; dir_idx < end; dir_idx++) {
+    // First direction slices are for FWD, the second are BWD.
+    rnn_internal_direction rnn_direction =
+        (dir_idx == 0) ? BIDIR_FWD : BIDIR_BWD;
+    void *dir_work_area =
+        (char *)job->work_area + (dir_idx * job->dir_work_area_size);
+
+    job->status[dir_idx] = directional_rnn(
+        job->op_parm_block_version, job->function_code, job->nums, job->input,
+        job->sliced_inputs[dir_idx], job->hn_output, job->cf_output,
+        rnn_direction, dir_work_area, job->wa_descs);
+  }
+}
+
+// Run the BWD direction of a BIDIR call on a thread of its own
+static void *bidir_rnn_bwd_thread(void *arg) {
+  bidir_rnn_chunk(arg, 1, 2);
+  return NULL;
+}
+
 /// Calls the NNPA operations that makeup LSTM. This method preforms "pre and
 /// post" work. For "pre" it allocates the work_area (if necessary) it then
 /// calls directional_rnn() to perform the RNN op (slicing the input and calling
-/// directional_rnn() twice for BIDIR case). After all directions are processed
+/// directional_rnn() twice for BIDIR case, one after the other, or on two
+/// threads when rnn_bidir_concurrent is set and more than one thread is
+/// allowed). After all directions are processed
 /// it cleans up the work area and returns the final status. Method stops and
 /// returns on the first error encountered or ZDNN_OK.
 ///
@@ -736,6 +788,13 @@ zdnn_status aiu_lstm_gru(uint16_t op_parm_block_version, uint8_t function_code,
     return ZDNN_UNAVAILABLE_FUNCTION;
   }
 
+  // issues an NNPA_MATMUL_OP and NNPA_LSTMACT/NNPA_GRUACT per timestep
+  if ((status = check_op_plan_recordable(
+           function_code == NNPA_LSTMACT ? "zdnn_lstm" : "zdnn_gru")) !=
+      ZDNN_OK) {
+    return status;
+  }
+
   // Store special dimensions/values to pass to various internal methods.
   uint32_t nums[NUM_INTEGER_INDICES];
   nums[TS] = input->transformed_desc->dim4;
@@ -807,10 +866,6 @@ zdnn_status aiu_lstm_gru(uint16_t op_parm_block_version, uint8_t function_code,
 
     // Slice the user's original ztensors based on direction dimension.
     for (uint32_t dir_idx = 0; dir_idx < num_dirs; dir_idx++) {
-      // First direction slices are for FWD, the second are BWD.
-      rnn_internal_direction rnn_direction =
-          (dir_idx == 0) ? BIDIR_FWD : BIDIR_BWD;
-
       // Slice the inputs over the direction dimension (dim4)
       for (uint32_t input_idx = 0; input_idx < nums[SLICEABLE_INPUTS];
            input_idx++) {
@@ -836,15 +891,38 @@ zdnn_status aiu_lstm_gru(uint16_t op_parm_block_version, uint8_t function_code,
       if (status != ZDNN_OK) {
         break;
       }
+    }
+    if (status != ZDNN_OK) {
+      break;
+    }
 
-      void *dir_work_area =
-          (char *)internal_work_area + (dir_idx * dir_work_area_size);
-      status =
-          directional_rnn(op_parm_block_version, function_code, nums, input,
-                          sliced_inputs_ptrs[dir_idx], hn_output, cf_output,
-                          rnn_direction, dir_work_area, wa_descs);
-      if (status != ZDNN_OK) {
-        break;
+    bidir_rnn_job job = {.op_parm_block_version = op_parm_block_version,
+                         .function_code = function_code,
+                         .nums = nums,
+                         .input = input,
+                         .sliced_inputs = {sliced_inputs_ptrs[0],
+                                           sliced_inputs_ptrs[1]},
+                         .hn_output = hn_output,
+                         .cf_output = cf_output,
+                         .work_area = internal_work_area,
+                         .dir_work_area_size = dir_work_area_size,
+                         .wa_descs = wa_descs,
+                         .status = {ZDNN_OK, ZDNN_OK}};
+
+    pthread_t bwd_thread;
+    if (rnn_bidir_concurrent && zdnn_get_max_threads() > 1 &&
+        pthread_create(&bwd_thread, NULL, bidir_rnn_bwd_thread, &job) == 0) {
+      // FWD on the calling thread while BWD runs on its own thread, not a
+      // pool worker that may be busy, each submitting its own timesteps
+      bidir_rnn_chunk(&job, 0, 1);
+      pthread_join(bwd_thread, NULL);
+      status = (job.status[0] != ZDNN_OK) ? job.status[0] : job.status[1];
+    } else {
+      for (uint32_t dir_idx = 0; dir_idx < num_dirs; dir_idx++) {
+        bidir_rnn_chunk(&job, dir_idx, dir_idx + 1);
+        if ((status = job.status[dir_idx]) != ZDNN_OK) {
+          break;
+        }
       }
     }
   } break;
@@ -880,3 +958,932 @@ zdnn_status aiu_lstm_gru(uint16_t op_parm_block_version, uint8_t function_code,
   // first failure or OK if everything works.
   return status;
 }
+
+// Intermediate output ztensors and input of one layer of a stack
+typedef struct stack_layer {
+  zdnn_tensor_desc hn_desc; // (ts, 1, b, s) or (ts, 1, b, out_pad)
+  zdnn_tensor_desc cf_desc; // (1, 1, b, s) or (1, 1, b, out_pad)
+  zdnn_ztensor hn;
+  zdnn_ztensor cf;
+  const zdnn_ztensor *input;
+} stack_layer;
+
+/// Runs a stack of LSTM/GRU layers, each layer's hn_output of all timesteps
+/// being the next layer's input. The layers share a single work area sized for
+/// the largest of them, and the intermediate outputs alternate between two
+/// buffers, so only the last layer's outputs are the caller's.
+///
+/// \param[in] op_parm_block_version Parmblock Version
+/// \param[in] function_code NNPA_LSTMACT or NNPA_GRUACT
+/// \param[in] input The first layer's input ztensor
+/// \param[in] num_layers Number of layers
+/// \param[in] h0 Per-layer hidden state ztensors
+/// \param[in] c0 Per-layer cell state ztensors (ignored when mode is GRU)
+/// \param[in] weights Per-layer input weights ztensors
+/// \param[in] biases Per-layer input biases ztensors
+/// \param[in] hidden_weights Per-layer hidden weights ztensors
+/// \param[in] hidden_biases Per-layer hidden biases ztensors
+/// \param[in] direction LSTM/GRU direction of every layer (FWD, BWD, BIDIR)
+/// \param[in] work_area Pointer to pre-allocated work area, large enough for
+///                      any of the layers, or NULL.
+/// \param[out] hn_output The last layer's hidden_state ztensor
+/// \param[out] cf_output The last layer's cell_state ztensor
+///
+/// \return ZDNN_OK if all checks pass or a failure based on why it failed.
+///
+zdnn_status aiu_lstm_gru_stack(
+    uint16_t op_parm_block_version, uint8_t function_code,
+    const zdnn_ztensor *input, uint32_t num_layers, const zdnn_ztensor **h0,
+    const zdnn_ztensor **c0, const zdnn_ztensor **weights,
+    const zdnn_ztensor **biases, const zdnn_ztensor **hidden_weights,
+    const zdnn_ztensor **hidden_biases, lstm_gru_direction direction,
+    void *work_area, zdnn_ztensor *hn_output, zdnn_ztensor *cf_output) {
+  zdnn_status status = ZDNN_OK;
+  bool is_lstm = (function_code == NNPA_LSTMACT);
+
+  if (!is_query_parmblock_installed(op_parm_block_version)) {
+    return ZDNN_UNAVAILABLE_FUNCTION;
+  }
+
+  if ((status = check_op_plan_recordable(is_lstm ? "zdnn_lstm_stack"
+                                                 : "zdnn_gru_stack")) !=
+      ZDNN_OK) {
+    return status;
+  }
+
+  if (!num_layers) {
+    return ZDNN_STATUS(ZDNN_INVALID_SHAPE, "num_layers is invalid (found %d)",
+                       num_layers);
+  }
+
+  if (direction != FWD && direction != BWD && direction != BIDIR) {
+    return ZDNN_STATUS(ZDNN_INVALID_DIRECTION, "%d is not a valid direction",
+                       direction);
+  }
+
+  uint32_t num_dirs = (direction == BIDIR) ? 2 : 1;
+  uint32_t num_ts = input->transformed_desc->dim4;
+  uint32_t num_batches = input->transformed_desc->dim2;
+
+  // num_layers comes from the caller, so the per-layer state is on the heap
+  stack_layer *layers = malloc((size_t)num_layers * sizeof(stack_layer));
+  if (!layers) {
+    return ZDNN_STATUS(ZDNN_ALLOCATION_FAILURE,
+                       "Unable to allocate %" PRIu64 " bytes for %u layers.",
+                       (uint64_t)num_layers * sizeof(stack_layer), num_layers);
+  }
+
+  // Describe every intermediate output and find the largest work area and
+  // intermediate buffers among the layers
+  size_t hn_size = 0, cf_size = 0, work_area_size = 0;
+
+  for (uint32_t layer = 0; layer < num_layers; layer++) {
+    uint32_t nums[NUM_INTEGER_INDICES];
+    nums[TS] = num_ts;
+    nums[BATCH] = num_batches;
+    nums[HID_SIZE] = h0[layer]->transformed_desc->dim1;
+    nums[IN_PAD] = weights[layer]->transformed_desc->dim1;
+    nums[GATES] = get_func_code_num_gates(function_code);
+
+    work_area_descriptor wa_descs[NUM_WA_DESCS];
+    work_area_size =
+        MAX(work_area_size,
+            setup_work_area_descs(function_code, nums, wa_descs) * num_dirs);
+
+    if (layer == num_layers - 1) {
+      break;
+    }
+
+    uint32_t out_dim1 =
+        (num_dirs == 2) ? 2 * PADDED(nums[HID_SIZE]) : nums[HID_SIZE];
+    init_transformed_desc(ZDNN_NHWC, ZDNN_DLFLOAT16, ZDNN_FORMAT_4DFEATURE,
+                          &layers[layer].hn_desc, num_ts, 1, num_batches,
+                          out_dim1);
+    init_transformed_desc(ZDNN_NHWC, ZDNN_DLFLOAT16, ZDNN_FORMAT_4DFEATURE,
+                          &layers[layer].cf_desc, 1, 1, num_batches, out_dim1);
+    hn_size = MAX(hn_size, zdnn_getsize_ztensor(&layers[layer].hn_desc));
+    cf_size = MAX(cf_size, zdnn_getsize_ztensor(&layers[layer].cf_desc));
+  }
+  if (!is_lstm) {
+    cf_size = 0;
+  }
+
+  // work_area (if not given) followed by the two hn buffers and the cf buffer
+  size_t alloc_work_area_size = work_area ? 0 : work_area_size;
+  size_t total_size = alloc_work_area_size + 2 * hn_size + cf_size;
+  char *alloced = NULL;
+  if (total_size && !(alloced = malloc_aligned_4k(total_size))) {
+    free(layers);
+    return ZDNN_STATUS(ZDNN_ALLOCATION_FAILURE,
+                       "Unable to allocate %" PRIu64
+                       " bytes for work_area and intermediate outputs.",
+                       total_size);
+  }
+  void *internal_work_area = work_area ? work_area : alloced;
+  void *hn_buffers[2] = {NULL, NULL};
+  void *cf_buffer = NULL;
+  if (alloced) {
+    hn_buffers[0] = alloced + alloc_work_area_size;
+    hn_buffers[1] = (char *)hn_buffers[0] + hn_size;
+    cf_buffer = (char *)hn_buffers[1] + hn_size;
+  }
+
+  for (uint32_t layer = 0; layer < num_layers; layer++) {
+    stack_layer *l = &layers[layer];
+    l->input = (layer == 0) ? input : &layers[layer - 1].hn;
+    if (layer == num_layers - 1) {
+      break;
+    }
+    // Layer n + 1 reads layer n's output while writing its own, so
+    // consecutive layers use different buffers. The intermediate cf is
+    // never read.
+    zdnn_init_ztensor(NULL, &l->hn_desc, &l->hn);
+    l->hn.buffer = hn_buffers[layer & 1];
+    l->hn.buffer_size = zdnn_getsize_ztensor(&l->hn_desc);
+    zdnn_init_ztensor(NULL, &l->cf_desc, &l->cf);
+    l->cf.buffer = cf_buffer;
+    l->cf.buffer_size = zdnn_getsize_ztensor(&l->cf_desc);
+  }
+
+  // Check every layer before running any of them
+  if (precheck_enabled) {
+    for (uint32_t layer = 0; layer < num_layers && status == ZDNN_OK;
+         layer++) {
+      bool is_last = (layer == num_layers - 1);
+      status = verify_zdnn_lstm_or_gru_tensors(
+          function_code, layers[layer].input, h0[layer],
+          is_lstm ? c0[layer] : NULL, weights[layer], biases[layer],
+          hidden_weights[layer], hidden_biases[layer], direction,
+          is_last ? hn_output : &layers[layer].hn,
+          !is_lstm ? NULL : (is_last ? cf_output : &layers[layer].cf));
+    }
+  }
+
+  for (uint32_t layer = 0; layer < num_layers && status == ZDNN_OK; layer++) {
+    bool is_last = (layer == num_layers - 1);
+    status = aiu_lstm_gru(
+        op_parm_block_version, function_code, layers[layer].input, h0[layer],
+        is_lstm ? c0[layer] : NULL, weights[layer], biases[layer],
+        hidden_weights[layer], hidden_biases[layer], direction,
+        internal_work_area, is_last ? hn_output : &layers[layer].hn,
+        !is_lstm ? NULL : (is_last ? cf_output : &layers[layer].cf));
+  }
+
+  free_aligned_4k(alloced);
+  free(layers);
+  return status;
+}
+
+// Byte offset of the stick_idx-th stick of row e2x at dim4 index e4x of a
+// (dim4, 1, dim2, dim1) stickified feature tensor
+static size_t rnn_row_stick_offset(const zdnn_tensor_desc *tfrmd_desc,
+                                   uint32_t e4x, uint32_t e2x,
+                                   uint32_t stick_idx) {
+  uint64_t sticks_per_row =
+      CEIL(tfrmd_desc->dim1, AIU_2BYTE_CELLS_PER_STICK);
+  uint64_t padded_rows =
+      CEIL(tfrmd_desc->dim2, AIU_STICKS_PER_PAGE) * AIU_STICKS_PER_PAGE;
+  return ((e4x * sticks_per_row + stick_idx) * padded_rows + e2x) *
+         AIU_BYTES_PER_STICK;
+}
+
+// Copy one batch row of a stickified feature tensor into a row of another,
+// stick by stick.  dst_stick_shift places the row in the FWD or BWD half of a
+// BIDIR output.
+static void copy_rnn_row(const zdnn_tensor_desc *src_desc, const void *src_buf,
+                         uint32_t src_e4x, uint32_t src_row,
+                         const zdnn_tensor_desc *dst_desc, void *dst_buf,
+                         uint32_t dst_e4x, uint32_t dst_row,
+                         uint32_t dst_stick_shift) {
+  uint32_t num_sticks = CEIL(src_desc->dim1, AIU_2BYTE_CELLS_PER_STICK);
+  for (uint32_t stick_idx = 0; stick_idx < num_sticks; stick_idx++) {
+    memcpy((char *)dst_buf + rnn_row_stick_offset(dst_desc, dst_e4x, dst_row,
+                                                  stick_idx + dst_stick_shift),
+           (const char *)src_buf +
+               rnn_row_stick_offset(src_desc, src_e4x, src_row, stick_idx),
+           AIU_BYTES_PER_STICK);
+  }
+}
+
+// Batch row and its sequence length, sorted longest first
+typedef struct packed_rnn_row {
+  uint32_t row;
+  uint32_t len;
+} packed_rnn_row;
+
+static int cmp_packed_rnn_rows(const void *a, const void *b) {
+  const packed_rnn_row *ra = (const packed_rnn_row *)a;
+  const packed_rnn_row *rb = (const packed_rnn_row *)b;
+  if (ra->len != rb->len) {
+    return (ra->len > rb->len) ? -1 : 1;
+  }
+  return (ra->row > rb->row) - (ra->row < rb->row);
+}
+
+// Scratch ztensors of a packed call, sized for the whole batch and all
+// timesteps.  Each segment re-describes them with its own timesteps and
+// active rows.
+typedef struct packed_rnn_scratch {
+  void *input;  // (seg ts, 1, active, f)
+  void *hn;     // (seg ts, 1, active, s)
+  void *h0;     // (1, 1, active, s)
+  void *c0;     // (1, 1, active, s), LSTM only
+  void *cf;     // (1, 1, active, s), LSTM only
+} packed_rnn_scratch;
+
+// Run one direction of a packed RNN call.  Rows are processed in length order
+// (sorted_rows) so that the rows still running at any timestep are a prefix of
+// the batch.  The timesteps are split into segments at each distinct length
+// and every segment is a single directional_rnn() call on only the active
+// rows: FWD drops the rows that have ended, BWD adds the rows whose last valid
+// timestep is reached, starting them from their own h0/c0.
+static zdnn_status packed_directional_rnn(
+    uint16_t op_parm_block_version, uint8_t function_code,
+    const uint32_t *nums, const zdnn_ztensor *input,
+    const packed_rnn_row *sorted_rows, const zdnn_ztensor **dir_inputs,
+    bool is_bwd, uint32_t out_stick_shift, zdnn_ztensor *hn_output,
+    zdnn_ztensor *cf_output, void *work_area, packed_rnn_scratch *scratch) {
+  zdnn_status status;
+  bool is_lstm = (function_code == NNPA_LSTMACT);
+  bool all_timesteps = (hn_output->transformed_desc->dim4 == nums[TS]);
+  uint32_t num_rows = nums[BATCH];
+  uint32_t num_features = input->transformed_desc->dim1;
+  uint32_t max_len = sorted_rows[0].len;
+
+  uint32_t seg_nums[NUM_INTEGER_INDICES];
+  memcpy(seg_nums, nums, sizeof(seg_nums));
+  work_area_descriptor wa_descs[NUM_WA_DESCS];
+
+  zdnn_tensor_desc in_desc, hn_desc, state_desc;
+  // descriptors of the previous segment, where carried states are read from
+  zdnn_tensor_desc prev_hn_desc = {0}, prev_state_desc = {0};
+  zdnn_ztensor seg_input, seg_hn, seg_h0, seg_c0, seg_cf;
+  uint32_t prev_ts = 0, prev_active = 0;
+
+  // Order must match rnn_user_zten_indices!
+  const zdnn_ztensor *seg_inputs[] = {&seg_h0,
+                                      dir_inputs[IN_WEIGHTS],
+                                      dir_inputs[IN_BIAS],
+                                      dir_inputs[HID_WEIGHTS],
+                                      dir_inputs[HID_BIAS],
+                                      &seg_c0};
+
+  // segment is timesteps [lo, hi)
+  uint32_t lo = 0, hi = max_len;
+
+  while (is_bwd ? (hi > 0) : (lo < max_len)) {
+    uint32_t active = 0;
+    if (is_bwd) {
+      // rows reaching at least timestep hi - 1, the next shorter length ends
+      // the segment
+      while (active < num_rows && sorted_rows[active].len >= hi) {
+        active++;
+      }
+      lo = (active < num_rows) ? sorted_rows[active].len : 0;
+    } else {
+      // rows going past timestep lo, the shortest of them ends the segment
+      while (active < num_rows && sorted_rows[active].len > lo) {
+        active++;
+      }
+      hi = sorted_rows[active - 1].len;
+    }
+    uint32_t seg_ts = hi - lo;
+
+    init_transformed_desc(ZDNN_NHWC, ZDNN_DLFLOAT16, ZDNN_FORMAT_4DFEATURE,
+                          &in_desc, seg_ts, 1, active, num_features);
+    init_transformed_desc(ZDNN_NHWC, ZDNN_DLFLOAT16, ZDNN_FORMAT_4DFEATURE,
+                          &hn_desc, seg_ts, 1, active, nums[HID_SIZE]);
+    init_transformed_desc(ZDNN_NHWC, ZDNN_DLFLOAT16, ZDNN_FORMAT_4DFEATURE,
+                          &state_desc, 1, 1, active, nums[HID_SIZE]);
+
+    zdnn_init_ztensor(NULL, &in_desc, &seg_input);
+    seg_input.buffer = scratch->input;
+    seg_input.buffer_size = zdnn_getsize_ztensor(&in_desc);
+    zdnn_init_ztensor(NULL, &hn_desc, &seg_hn);
+    seg_hn.buffer = scratch->hn;
+    seg_hn.buffer_size = zdnn_getsize_ztensor(&hn_desc);
+    zdnn_init_ztensor(NULL, &state_desc, &seg_h0);
+    seg_h0.buffer = scratch->h0;
+    seg_h0.buffer_size = zdnn_getsize_ztensor(&state_desc);
+    if (is_lstm) {
+      seg_c0 = seg_h0;
+      seg_c0.buffer = scratch->c0;
+      seg_cf = seg_h0;
+      seg_cf.buffer = scratch->cf;
+    }
+
+    // Gather the segment's input timesteps of the active rows
+    for (uint32_t t = 0; t < seg_ts; t++) {
+      for (uint32_t r = 0; r < active; r++) {
+        copy_rnn_row(input->transformed_desc, input->buffer, lo + t,
+                     sorted_rows[r].row, &in_desc, seg_input.buffer, t, r, 0);
+      }
+    }
+
+    // Rows running in the previous segment continue from the state it left
+    // (its last timestep for FWD, its first for BWD), the others start from
+    // h0/c0
+    for (uint32_t r = 0; r < active; r++) {
+      if (r < prev_active) {
+        copy_rnn_row(&prev_hn_desc, scratch->hn, is_bwd ? 0 : prev_ts - 1, r,
+                     &state_desc, scratch->h0, 0, r, 0);
+        if (is_lstm) {
+          copy_rnn_row(&prev_state_desc, scratch->cf, 0, r, &state_desc,
+                       scratch->c0, 0, r, 0);
+        }
+      } else {
+        copy_rnn_row(dir_inputs[H0]->transformed_desc, dir_inputs[H0]->buffer,
+                     0, sorted_rows[r].row, &state_desc, scratch->h0, 0, r, 0);
+        if (is_lstm) {
+          copy_rnn_row(dir_inputs[C0]->transformed_desc,
+                       dir_inputs[C0]->buffer, 0, sorted_rows[r].row,
+                       &state_desc, scratch->c0, 0, r, 0);
+        }
+      }
+    }
+
+    seg_nums[TS] = seg_ts;
+    seg_nums[BATCH] = active;
+    setup_work_area_descs(function_code, seg_nums, wa_descs);
+
+    if ((status = directional_rnn(op_parm_block_version, function_code,
+                                  seg_nums, &seg_input, seg_inputs, &seg_hn,
+                                  is_lstm ? &seg_cf : NULL,
+                                  is_bwd ? UNI_BWD : UNI_FWD, work_area,
+                                  wa_descs)) != ZDNN_OK) {
+      return status;
+    }
+
+    // Scatter the results back to the rows' places in the outputs.  Final
+    // states are taken from rows whose sequence ends here: FWD rows whose
+    // length is hi, and every row once BWD gets down to timestep 0.
+    for (uint32_t r = 0; r < active; r++) {
+      uint32_t row = sorted_rows[r].row;
+      if (all_timesteps) {
+        for (uint32_t t = 0; t < seg_ts; t++) {
+          copy_rnn_row(&hn_desc, seg_hn.buffer, t, r,
+                       hn_output->transformed_desc, hn_output->buffer, lo + t,
+                       row, out_stick_shift);
+        }
+      }
+      if (is_bwd ? (lo == 0) : (sorted_rows[r].len == hi)) {
+        if (!all_timesteps) {
+          copy_rnn_row(&hn_desc, seg_hn.buffer, is_bwd ? 0 : seg_ts - 1, r,
+                       hn_output->transformed_desc, hn_output->buffer, 0, row,
+                       out_stick_shift);
+        }
+        if (is_lstm) {
+          copy_rnn_row(&state_desc, seg_cf.buffer, 0, r,
+                       cf_output->transformed_desc, cf_output->buffer, 0, row,
+                       out_stick_shift);
+        }
+      }
+    }
+
+    prev_hn_desc = hn_desc;
+    prev_state_desc = state_desc;
+    prev_ts = seg_ts;
+    prev_active = active;
+
+    if (is_bwd) {
+      hi = lo;
+    } else {
+      lo = hi;
+    }
+  }
+
+  return ZDNN_STATUS_OK;
+}
+
+/// Packed-sequence variant of aiu_lstm_gru().  Row b of the batch only has
+/// seq_lens[b] valid timesteps; no NNPA work is spent on the timesteps past
+/// that.  For BWD the row starts at its own last valid timestep.  hn_output
+/// timesteps past a row's length are zeros, and the final hn_output/cf_output
+/// hold the state after each row's last valid (FWD) or first (BWD) timestep.
+///
+/// \param[in] op_parm_block_version Parmblock Version
+/// \param[in] function_code NNPA_LSTMACT or NNPA_GRUACT
+/// \param[in] input The input ztensor, (ts, 1, b, f)
+/// \param[in] seq_lens Number of valid timesteps of each batch row, each in
+///                     [1, ts]
+/// \param[in] h0 The hidden state ztensor fed into the zAIU.
+/// \param[in] c0 The cell state ztensor (ignored when mode is GRU)
+/// \param[in] weights The input weights ztensor.
+/// \param[in] biases The input biases ztensor.
+/// \param[in] hidden_weights The hidden weights ztensor.
+/// \param[in] hidden_biases The hidden biases ztensor.
+/// \param[in] direction LSTM/GRU direction (FWD, BWD, BIDIR)
+/// \param[in] work_area Pointer to pre-allocated work area (same size as for
+///                      aiu_lstm_gru()) or NULL.
+/// \param[out] hn_output The returned hidden_state ztensor.
+/// \param[out] cf_output The returned cell_state ztensor.
+///
+/// \return ZDNN_OK if all checks pass or a failure based on why it failed.
+///
+zdnn_status aiu_lstm_gru_packed(
+    uint16_t op_parm_block_version, uint8_t function_code,
+    const zdnn_ztensor *input, const uint32_t *seq_lens,
+    const zdnn_ztensor *h0, const zdnn_ztensor *c0,
+    const zdnn_ztensor *weights, const zdnn_ztensor *biases,
+    const zdnn_ztensor *hidden_weights, const zdnn_ztensor *hidden_biases,
+    lstm_gru_direction direction, void *work_area, zdnn_ztensor *hn_output,
+    zdnn_ztensor *cf_output) {
+  zdnn_status status = ZDNN_OK;
+  bool is_lstm = (function_code == NNPA_LSTMACT);
+
+  if (!is_query_parmblock_installed(op_parm_block_version)) {
+    return ZDNN_UNAVAILABLE_FUNCTION;
+  }
+
+  if ((status = check_op_plan_recordable(is_lstm ? "zdnn_lstm_packed"
+                                                 : "zdnn_gru_packed")) !=
+      ZDNN_OK) {
+    return status;
+  }
+
+  if (direction != FWD && direction != BWD && direction != BIDIR) {
+    return ZDNN_STATUS(ZDNN_INVALID_DIRECTION, "%d is not a valid direction",
+                       direction);
+  }
+
+  uint32_t nums[NUM_INTEGER_INDICES];
+  nums[TS] = input->transformed_desc->dim4;
+  nums[BATCH] = input->transformed_desc->dim2;
+  nums[HID_SIZE] = h0->transformed_desc->dim1;
+  nums[IN_PAD] = weights->transformed_desc->dim1;
+  nums[GATES] = get_func_code_num_gates(function_code);
+  nums[SLICEABLE_INPUTS] = is_lstm ? NUM_INPUTS_LSTM : NUM_INPUTS_GRU;
+
+  if (!seq_lens) {
+    return ZDNN_STATUS(ZDNN_INVALID_SHAPE, "seq_lens is NULL", NO_ARG);
+  }
+
+  packed_rnn_row *sorted_rows = malloc(nums[BATCH] * sizeof(packed_rnn_row));
+  if (!sorted_rows) {
+    return ZDNN_STATUS(ZDNN_ALLOCATION_FAILURE,
+                       "Unable to allocate %zu bytes for seq_lens.",
+                       nums[BATCH] * sizeof(packed_rnn_row));
+  }
+  for (uint32_t b = 0; b < nums[BATCH]; b++) {
+    if (seq_lens[b] == 0 || seq_lens[b] > nums[TS]) {
+      free(sorted_rows);
+      return ZDNN_STATUS(ZDNN_INVALID_SHAPE,
+                         "seq_lens[%u] is invalid (found %u, expects 1 to %u)",
+                         b, seq_lens[b], nums[TS]);
+    }
+    sorted_rows[b].row = b;
+    sorted_rows[b].len = seq_lens[b];
+  }
+  qsort(sorted_rows, nums[BATCH], sizeof(packed_rnn_row),
+        cmp_packed_rnn_rows);
+
+  // Same work_area layout as aiu_lstm_gru(), every segment fits in it
+  work_area_descriptor wa_descs[NUM_WA_DESCS];
+  size_t dir_work_area_size =
+      setup_work_area_descs(function_code, nums, wa_descs);
+  uint32_t num_dirs = (direction == BIDIR) ? 2 : 1;
+
+  zdnn_tensor_desc full_in_desc, full_hn_desc, full_state_desc;
+  init_transformed_desc(ZDNN_NHWC, ZDNN_DLFLOAT16, ZDNN_FORMAT_4DFEATURE,
+                        &full_in_desc, nums[TS], 1, nums[BATCH],
+                        input->transformed_desc->dim1);
+  init_transformed_desc(ZDNN_NHWC, ZDNN_DLFLOAT16, ZDNN_FORMAT_4DFEATURE,
+                        &full_hn_desc, nums[TS], 1, nums[BATCH],
+                        nums[HID_SIZE]);
+  init_transformed_desc(ZDNN_NHWC, ZDNN_DLFLOAT16, ZDNN_FORMAT_4DFEATURE,
+                        &full_state_desc, 1, 1, nums[BATCH], nums[HID_SIZE]);
+  size_t in_size = zdnn_getsize_ztensor(&full_in_desc);
+  size_t hn_size = zdnn_getsize_ztensor(&full_hn_desc);
+  size_t state_size = zdnn_getsize_ztensor(&full_state_desc);
+
+  // work_area (if not given) followed by the scratch ztensors
+  size_t alloc_work_area_size = work_area ? 0 : dir_work_area_size * num_dirs;
+  size_t total_size = alloc_work_area_size + in_size + hn_size +
+                      state_size * (is_lstm ? 3 : 1);
+  char *alloced = malloc_aligned_4k(total_size);
+  if (!alloced) {
+    free(sorted_rows);
+    return ZDNN_STATUS(ZDNN_ALLOCATION_FAILURE,
+                       "Unable to allocate %" PRIu64
+                       " bytes for work_area and scratch ztensors.",
+                       total_size);
+  }
+  void *internal_work_area = work_area ? work_area : alloced;
+
+  packed_rnn_scratch scratch;
+  scratch.input = alloced + alloc_work_area_size;
+  scratch.hn = (char *)scratch.input + in_size;
+  scratch.h0 = (char *)scratch.hn + hn_size;
+  scratch.c0 = is_lstm ? (char *)scratch.h0 + state_size : NULL;
+  scratch.cf = is_lstm ? (char *)scratch.c0 + state_size : NULL;
+
+  // timesteps past a row's length are never written
+  if (hn_output->transformed_desc->dim4 == nums[TS]) {
+    memset(hn_output->buffer, 0,
+           zdnn_getsize_ztensor(hn_output->transformed_desc));
+  }
+
+  // Order must match rnn_user_zten_indices!
+  const zdnn_ztensor *sliceable_inputs[] = {
+      h0, weights, biases, hidden_weights, hidden_biases, c0};
+
+  for (uint32_t dir_idx = 0; dir_idx < num_dirs && status == ZDNN_OK;
+       dir_idx++) {
+    zdnn_ztensor sliced_inputs[NUM_INPUTS_LSTM];
+    zdnn_tensor_desc sliced_descs[NUM_INPUTS_LSTM];
+    const zdnn_ztensor *dir_inputs[NUM_INPUTS_LSTM] = {NULL};
+
+    for (uint32_t input_idx = 0; input_idx < nums[SLICEABLE_INPUTS];
+         input_idx++) {
+      const zdnn_ztensor *unsliced_input = sliceable_inputs[input_idx];
+      if (num_dirs == 1) {
+        dir_inputs[input_idx] = unsliced_input;
+        continue;
+      }
+      if ((status = ztensor_slice_dim4(
+               unsliced_input, dir_idx,
+               zdnn_getsize_ztensor(unsliced_input->transformed_desc) /
+                   unsliced_input->transformed_desc->dim4,
+               NULL, &sliced_descs[input_idx], &sliced_inputs[input_idx])) !=
+          ZDNN_OK) {
+        break;
+      }
+      dir_inputs[input_idx] = &sliced_inputs[input_idx];
+    }
+    if (status != ZDNN_OK) {
+      break;
+    }
+
+    bool is_bwd = (direction == BWD || dir_idx == 1);
+    uint32_t out_stick_shift =
+        dir_idx * CEIL(nums[HID_SIZE], AIU_2BYTE_CELLS_PER_STICK);
+
+    status = packed_directional_rnn(
+        op_parm_block_version, function_code, nums, input, sorted_rows,
+        dir_inputs, is_bwd, out_stick_shift, hn_output, cf_output,
+        (char *)internal_work_area + dir_idx * dir_work_area_size, &scratch);
+  }
+
+  free_aligned_4k(alloced);
+  free(sorted_rows);
+
+  if (status == ZDNN_OK) {
+    hn_output->is_transformed = true;
+    if (is_lstm) {
+      cf_output->is_transformed = true;
+    }
+  }
+
+  return status;
+}
+
+// Unidirectional LSTM/GRU whose hidden (and cell) state carries over from one
+// zdnn_rnn_session_step() to the next
+struct zdnn_rnn_session {
+  uint8_t function_code;
+  uint32_t max_timesteps;
+  const zdnn_ztensor *weights;
+  const zdnn_ztensor *biases;
+  const zdnn_ztensor *hidden_weights;
+  const zdnn_ztensor *hidden_biases;
+  zdnn_tensor_desc state_pre_tfrmd_desc;
+  zdnn_tensor_desc state_tfrmd_desc;
+  zdnn_ztensor h_state;
+  zdnn_ztensor c_state; // LSTM only
+  void *work_area;      // sized for max_timesteps
+};
+
+/// Copy a state ztensor's stickified data into a session state ztensor
+///
+/// \param[in] src h0 or c0 supplied by the caller
+/// \param[out] state session state ztensor
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_STATE
+///         ZDNN_INVALID_SHAPE
+///
+static zdnn_status load_rnn_state(const zdnn_ztensor *src,
+                                  zdnn_ztensor *state) {
+  if (!src || !src->is_transformed) {
+    return ZDNN_STATUS(ZDNN_INVALID_STATE, "RNN state is not transformed",
+                       NO_ARG);
+  }
+  if (zdnn_getsize_ztensor(src->transformed_desc) != state->buffer_size) {
+    return ZDNN_STATUS(ZDNN_INVALID_SHAPE,
+                       "RNN state shape does not match the session's",
+                       NO_ARG);
+  }
+  memcpy(state->buffer, src->buffer, state->buffer_size);
+  return ZDNN_STATUS_OK;
+}
+
+/// Free a session's buffers and the session itself
+///
+/// \param[in] session Session to free, or NULL
+///
+/// \return None
+///
+void zdnn_free_rnn_session(zdnn_rnn_session *session) {
+  if (!session) {
+    return;
+  }
+  free_aligned_4k(session->h_state.buffer);
+  free_aligned_4k(session->c_state.buffer);
+  free_aligned_4k(session->work_area);
+  free(session);
+}
+
+/// Create a streaming LSTM/GRU session
+///
+/// \param[in] function_code NNPA_LSTMACT or NNPA_GRUACT
+/// \param[in] h0 initial hidden state, (1, 1, b, s)
+/// \param[in] c0 initial cell state (LSTM only, otherwise NULL)
+/// \param[in] weights input weights, kept by reference
+/// \param[in] biases input biases, kept by reference
+/// \param[in] hidden_weights hidden weights, kept by reference
+/// \param[in] hidden_biases hidden biases, kept by reference
+/// \param[in] max_timesteps most timesteps passed to a single step
+/// \param[out] session the new session
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_BUFFER
+///         ZDNN_INVALID_STATE
+///         ZDNN_INVALID_SHAPE
+///         ZDNN_INVALID_TYPE
+///         ZDNN_INVALID_FORMAT
+///         ZDNN_ALLOCATION_FAILURE
+///
+static zdnn_status create_rnn_session(
+    uint8_t function_code, const zdnn_ztensor *h0, const zdnn_ztensor *c0,
+    const zdnn_ztensor *weights, const zdnn_ztensor *biases,
+    const zdnn_ztensor *hidden_weights, const zdnn_ztensor *hidden_biases,
+    uint32_t max_timesteps, zdnn_rnn_session **session) {
+  zdnn_status status;
+  bool is_lstm = (function_code == NNPA_LSTMACT);
+
+  if (!session) {
+    return ZDNN_STATUS(ZDNN_INVALID_BUFFER, "session is NULL", NO_ARG);
+  }
+
+  // nothing below may look at a shape before the tensor is known to have one
+  const zdnn_ztensor *tensors[] = {h0, weights, biases, hidden_weights,
+                                   hidden_biases, c0};
+  uint32_t num_tensors = is_lstm ? 6 : 5;
+  for (uint32_t i = 0; i < num_tensors; i++) {
+    if (!tensors[i] || !tensors[i]->is_transformed) {
+      return ZDNN_STATUS(ZDNN_INVALID_STATE,
+                         "RNN session tensor %d is not transformed", i);
+    }
+  }
+
+  // Check the tensors the same way zdnn_rnn_session_step() will, against a
+  // one-timestep input and final-only outputs.  A session only runs forward,
+  // so h0 must have exactly one direction.
+  zdnn_tensor_desc step_in_desc, step_out_desc;
+  init_transformed_desc(ZDNN_NHWC, ZDNN_DLFLOAT16, ZDNN_FORMAT_4DFEATURE,
+                        &step_in_desc, 1, 1, h0->transformed_desc->dim2,
+                        weights->transformed_desc->dim2);
+  init_transformed_desc(ZDNN_NHWC, ZDNN_DLFLOAT16, ZDNN_FORMAT_4DFEATURE,
+                        &step_out_desc, 1, 1, h0->transformed_desc->dim2,
+                        h0->transformed_desc->dim1);
+  zdnn_ztensor step_input = {.transformed_desc = &step_in_desc};
+  zdnn_ztensor step_output = {.transformed_desc = &step_out_desc};
+  if ((status = verify_zdnn_lstm_or_gru_tensors(
+           function_code, &step_input, h0, c0, weights, biases,
+           hidden_weights, hidden_biases, FWD, &step_output,
+           is_lstm ? &step_output : NULL)) != ZDNN_OK) {
+    return status;
+  }
+  if (!max_timesteps) {
+    return ZDNN_STATUS(ZDNN_INVALID_SHAPE,
+                       "max_timesteps is invalid (found %d)", max_timesteps);
+  }
+
+  zdnn_rnn_session *new_session = malloc(sizeof(zdnn_rnn_session));
+  if (!new_session) {
+    return ZDNN_STATUS(ZDNN_ALLOCATION_FAILURE,
+                       "Unable to allocate %zu bytes for RNN session.",
+                       sizeof(zdnn_rnn_session));
+  }
+  memset(new_session, 0, sizeof(zdnn_rnn_session));
+
+  new_session->function_code = function_code;
+  new_session->max_timesteps = max_timesteps;
+  new_session->weights = weights;
+  new_session->biases = biases;
+  new_session->hidden_weights = hidden_weights;
+  new_session->hidden_biases = hidden_biases;
+  new_session->state_pre_tfrmd_desc = *h0->pre_transformed_desc;
+  new_session->state_tfrmd_desc = *h0->transformed_desc;
+
+  zdnn_ztensor *states[] = {&new_session->h_state, &new_session->c_state};
+  const zdnn_ztensor *initial_states[] = {h0, c0};
+  uint32_t num_states = is_lstm ? 2 : 1;
+
+  for (uint32_t i = 0; i < num_states; i++) {
+    zdnn_init_ztensor(&new_session->state_pre_tfrmd_desc,
+                      &new_session->state_tfrmd_desc, states[i]);
+    states[i]->buffer_size =
+        zdnn_getsize_ztensor(&new_session->state_tfrmd_desc);
+    if (!(states[i]->buffer = malloc_aligned_4k(states[i]->buffer_size))) {
+      status = ZDNN_STATUS(ZDNN_ALLOCATION_FAILURE,
+                           "Unable to allocate %" PRIu64
+                           " bytes for RNN state.",
+                           states[i]->buffer_size);
+      zdnn_free_rnn_session(new_session);
+      return status;
+    }
+    if ((status = load_rnn_state(initial_states[i], states[i])) != ZDNN_OK) {
+      zdnn_free_rnn_session(new_session);
+      return status;
+    }
+    states[i]->is_transformed = true;
+  }
+
+  uint32_t nums[NUM_INTEGER_INDICES];
+  nums[TS] = max_timesteps;
+  nums[BATCH] = h0->transformed_desc->dim2;
+  nums[HID_SIZE] = h0->transformed_desc->dim1;
+  nums[IN_PAD] = weights->transformed_desc->dim1;
+  nums[GATES] = get_func_code_num_gates(function_code);
+
+  work_area_descriptor wa_descs[NUM_WA_DESCS];
+  size_t work_area_size = setup_work_area_descs(function_code, nums, wa_descs);
+  if (!(new_session->work_area = malloc_aligned_4k(work_area_size))) {
+    zdnn_free_rnn_session(new_session);
+    return ZDNN_STATUS(ZDNN_ALLOCATION_FAILURE,
+                       "Unable to allocate %zu bytes for work_area.",
+                       work_area_size);
+  }
+
+  *session = new_session;
+  return ZDNN_STATUS_OK;
+}
+
+/// Create a streaming LSTM session.  The session keeps the hidden and cell
+/// state between calls to zdnn_rnn_session_step(), which process the
+/// following timesteps of the sequence.
+///
+/// \param[in] h0 initial hidden state, (1, 1, b, s)
+/// \param[in] c0 initial cell state, (1, 1, b, s)
+/// \param[in] weights input weights, kept by reference
+/// \param[in] biases input biases, kept by reference
+/// \param[in] hidden_weights hidden weights, kept by reference
+/// \param[in] hidden_biases hidden biases, kept by reference
+/// \param[in] max_timesteps most timesteps passed to a single step
+/// \param[out] session the new session
+///
+/// \return ZDNN_OK or a failure based on why it failed
+///
+zdnn_status zdnn_create_lstm_session(const zdnn_ztensor *h0,
+                                     const zdnn_ztensor *c0,
+                                     const zdnn_ztensor *weights,
+                                     const zdnn_ztensor *biases,
+                                     const zdnn_ztensor *hidden_weights,
+                                     const zdnn_ztensor *hidden_biases,
+                                     uint32_t max_timesteps,
+                                     zdnn_rnn_session **session) {
+  return create_rnn_session(NNPA_LSTMACT, h0, c0, weights, biases,
+                            hidden_weights, hidden_biases, max_timesteps,
+                            session);
+}
+
+/// Create a streaming GRU session.  The session keeps the hidden state between
+/// calls to zdnn_rnn_session_step(), which process the following timesteps of
+/// the sequence.
+///
+/// \param[in] h0 initial hidden state, (1, 1, b, s)
+/// \param[in] weights input weights, kept by reference
+/// \param[in] biases input biases, kept by reference
+/// \param[in] hidden_weights hidden weights, kept by reference
+/// \param[in] hidden_biases hidden biases, kept by reference
+/// \param[in] max_timesteps most timesteps passed to a single step
+/// \param[out] session the new session
+///
+/// \return ZDNN_OK or a failure based on why it failed
+///
+zdnn_status zdnn_create_gru_session(const zdnn_ztensor *h0,
+                                    const zdnn_ztensor *weights,
+                                    const zdnn_ztensor *biases,
+                                    const zdnn_ztensor *hidden_weights,
+                                    const zdnn_ztensor *hidden_biases,
+                                    uint32_t max_timesteps,
+                                    zdnn_rnn_session **session) {
+  return create_rnn_session(NNPA_GRUACT, h0, NULL, weights, biases,
+                            hidden_weights, hidden_biases, max_timesteps,
+                            session);
+}
+
+/// Replace the hidden (and cell) state of a session, e.g. to start a new
+/// sequence
+///
+/// \param[in] session the session
+/// \param[in] h0 new hidden state, same shape as at creation
+/// \param[in] c0 new cell state (LSTM only, otherwise NULL)
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_STATE
+///         ZDNN_INVALID_SHAPE
+///
+zdnn_status zdnn_reset_rnn_session(zdnn_rnn_session *session,
+                                   const zdnn_ztensor *h0,
+                                   const zdnn_ztensor *c0) {
+  zdnn_status status;
+
+  if ((status = load_rnn_state(h0, &session->h_state)) != ZDNN_OK) {
+    return status;
+  }
+  if (session->function_code == NNPA_LSTMACT) {
+    return load_rnn_state(c0, &session->c_state);
+  }
+  return ZDNN_STATUS_OK;
+}
+
+/// Process the next timesteps of a session's sequence.  Only the input
+/// projection of these timesteps and their activations are computed, the
+/// state left by the previous step stands in for h0/c0.
+///
+/// \param[in] session the session
+/// \param[in] input input features, (ts, 1, b, f) with ts <= max_timesteps
+/// \param[out] hn_output hidden state of all the timesteps, (ts, 1, b, s), or
+///                       of the last one, (1, 1, b, s)
+/// \param[out] cf_output cell state after the last timestep, (1, 1, b, s)
+///                       (LSTM only, otherwise NULL)
+///
+/// \return ZDNN_OK or a failure based on why it failed
+///
+zdnn_status zdnn_rnn_session_step(zdnn_rnn_session *session,
+                                  const zdnn_ztensor *input,
+                                  zdnn_ztensor *hn_output,
+                                  zdnn_ztensor *cf_output) {
+  zdnn_status status;
+  uint8_t function_code = session->function_code;
+  bool is_lstm = (function_code == NNPA_LSTMACT);
+
+  if (!is_query_parmblock_installed(NNPA_PARMBLKFORMAT_0)) {
+    return ZDNN_UNAVAILABLE_FUNCTION;
+  }
+
+  if ((status = check_op_plan_recordable("zdnn_rnn_session_step")) !=
+      ZDNN_OK) {
+    return status;
+  }
+
+  // hn_output/cf_output are also where the next state is taken from, so they
+  // are always checked
+  if ((status = verify_zdnn_lstm_or_gru_tensors(
+           function_code, input, &session->h_state,
+           is_lstm ? &session->c_state : NULL, session->weights,
+           session->biases, session->hidden_weights, session->hidden_biases,
+           FWD, hn_output, is_lstm ? cf_output : NULL)) != ZDNN_OK) {
+    return status;
+  }
+  if (input->transformed_desc->dim4 > session->max_timesteps) {
+    return ZDNN_STATUS(ZDNN_INVALID_SHAPE,
+                       "input dim4 tensor shape is invalid (found %d, expects "
+                       "at most %d)",
+                       input->transformed_desc->dim4, session->max_timesteps);
+  }
+
+  uint32_t nums[NUM_INTEGER_INDICES];
+  nums[TS] = input->transformed_desc->dim4;
+  nums[BATCH] = input->transformed_desc->dim2;
+  nums[HID_SIZE] = session->h_state.transformed_desc->dim1;
+  nums[IN_PAD] = session->weights->transformed_desc->dim1;
+  nums[GATES] = get_func_code_num_gates(function_code);
+  nums[SLICEABLE_INPUTS] = is_lstm ? NUM_INPUTS_LSTM : NUM_INPUTS_GRU;
+
+  // same layout as the sequence-wide call, just fewer timesteps
+  work_area_descriptor wa_descs[NUM_WA_DESCS];
+  setup_work_area_descs(function_code, nums, wa_descs);
+
+  // Order must match rnn_user_zten_indices!
+  const zdnn_ztensor *inputs[] = {&session->h_state,
+                                  session->weights,
+                                  session->biases,
+                                  session->hidden_weights,
+                                  session->hidden_biases,
+                                  is_lstm ? &session->c_state : NULL};
+
+  if ((status = directional_rnn(NNPA_PARMBLKFORMAT_0, function_code, nums,
+                                input, inputs, hn_output, cf_output, UNI_FWD,
+                                session->work_area, wa_descs)) != ZDNN_OK) {
+    return status;
+  }
+
+  // carry the state after the last timestep over to the next step
+  size_t h_size = session->h_state.buffer_size;
+  memcpy(session->h_state.buffer,
+         (char *)hn_output->buffer +
+             (hn_output->transformed_desc->dim4 - 1) * h_size,
+         h_size);
+  hn_output->is_transformed = true;
+
+  if (is_lstm) {
+    memcpy(session->c_state.buffer, cf_output->buffer,
+           session->c_state.buffer_size);
+    cf_output->is_transformed = true;
+  }
+
+  return ZDNN_STATUS_OK;
+}
@@ -0,0 +1,360 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+
+#include "zdnn.h"
+#include "zdnn_private.h"
+
+/*
+  A matmul whose stack dimension S, M, N or P is beyond the NNPA maximum
+  dimension index size, or whose tensors are beyond the maximum tensor size,
+  is run as a grid of matmuls on tiles that are within them:
+
+    output[s, m, p] = sum over n of A[s, m, n] * B[s, n, p]  (+ C[s, p] once)
+
+  A and B (or C) with a single stack entry are broadcast, so their tiles
+  always take that entry.
+
+  Every output tile is computed from the first N tile of A and B with the real
+  bias, and every further N tile adds its partial product, computed with a
+  zero bias, to it with an NNPA add.  Partial sums are DLFLOAT16, so results
+  can differ from an untiled matmul by the rounding of each add.
+
+  Tiles are set up by init_ztensor_tile(), as views of their tensor where the
+  stick layout allows and as temporary copies otherwise.
+*/
+
+// how a matmul is split into tiles
+typedef struct matmul_tiling {
+  uint16_t op_parm_block_version;
+  uint8_t function_code;
+  const zdnn_ztensor *input_a;
+  const zdnn_ztensor *input_b;
+  const zdnn_ztensor *input_c;
+  zdnn_ztensor *output;
+  function_specific_parameters *fsp;
+  bool transpose_a;
+  bool transpose_b;
+  // tile sizes along S, M, N and P
+  uint32_t tile_s;
+  uint32_t tile_m;
+  uint32_t tile_n;
+  uint32_t tile_p;
+} matmul_tiling;
+
+/// Check whether every tensor of a matmul is within the NNPA maximum
+/// dimension index sizes and maximum tensor size
+///
+/// \param[in] input_a the A tensor
+/// \param[in] input_b the B tensor
+/// \param[in] input_c the C tensor
+/// \param[in] output the output tensor
+///
+/// \return true if the matmul can be run as it is
+///
+static bool is_matmul_within_nnpa_limits(const zdnn_ztensor *input_a,
+                                         const zdnn_ztensor *input_b,
+                                         const zdnn_ztensor *input_c,
+                                         const zdnn_ztensor *output) {
+  return is_within_nnpa_limits(input_a->transformed_desc) &&
+         is_within_nnpa_limits(input_b->transformed_desc) &&
+         is_within_nnpa_limits(input_c->transformed_desc) &&
+         is_within_nnpa_limits(output->transformed_desc);
+}
+
+/// Set the dim4 (S) range of a tensor's tile, a tensor with a single stack
+/// entry being broadcast to every stack index
+///
+/// \param[in] desc transformed descriptor of the tensor
+/// \param[in] s0 first S index of the tile
+/// \param[in] sc number of S indices of the tile
+/// \param[out] start start of the tile, dim4 first
+/// \param[out] count count of the tile, dim4 first
+///
+/// \return None
+///
+static void set_stack_range(const zdnn_tensor_desc *desc, uint32_t s0,
+                            uint32_t sc, uint32_t *start, uint32_t *count) {
+  start[0] = desc->dim4 == 1 ? 0 : s0;
+  count[0] = desc->dim4 == 1 ? 1 : sc;
+}
+
+/// Check whether tiles of the current tile sizes are within the NNPA maximum
+/// tensor size
+///
+/// \param[in] t the tiling
+/// \param[in] max_size the maximum tensor size
+///
+/// \return true if every tile is within it
+///
+static bool are_matmul_tiles_within_mts(const matmul_tiling *t,
+                                        uint64_t max_size) {
+  const zdnn_tensor_desc *a_desc = t->input_a->transformed_desc;
+  const zdnn_tensor_desc *b_desc = t->input_b->transformed_desc;
+  const zdnn_tensor_desc *c_desc = t->input_c->transformed_desc;
+  const zdnn_tensor_desc *out_desc = t->output->transformed_desc;
+
+  return get_tile_bytes(a_desc, MIN(a_desc->dim4, t->tile_s), 1,
+                        t->transpose_a ? t->tile_n : t->tile_m,
+                        t->transpose_a ? t->tile_m : t->tile_n) <= max_size &&
+         get_tile_bytes(b_desc, MIN(b_desc->dim4, t->tile_s), 1,
+                        t->transpose_b ? t->tile_p : t->tile_n,
+                        t->transpose_b ? t->tile_n : t->tile_p) <= max_size &&
+         get_tile_bytes(c_desc, MIN(c_desc->dim4, t->tile_s), 1, c_desc->dim2,
+                        t->tile_p) <= max_size &&
+         get_tile_bytes(out_desc, t->tile_s, 1, t->tile_m, t->tile_p) <=
+             max_size;
+}
+
+/// Work out the tile sizes of a tiled matmul, the largest ones within the
+/// NNPA maximum dimension index sizes and maximum tensor size
+///
+/// \param[in,out] t the tiling, with the tensors set
+///
+/// \return ZDNN_OK
+///         ZDNN_EXCEEDS_MTS
+///
+static zdnn_status init_matmul_tile_sizes(matmul_tiling *t) {
+  const zdnn_tensor_desc *a_desc = t->input_a->transformed_desc;
+  const zdnn_tensor_desc *out_desc = t->output->transformed_desc;
+  const uint32_t max_dim4 = zdnn_get_max_for_dim(4);
+  const uint32_t max_dim2 = zdnn_get_max_for_dim(2);
+  const uint32_t max_dim1 = zdnn_get_max_for_dim(1);
+  const uint64_t max_size = zdnn_get_nnpa_max_tensor_size();
+
+  // every one of M, N and P is dim2 of some tensors and dim1 of others
+  t->tile_s = MIN(out_desc->dim4, max_dim4);
+  t->tile_m = MIN(out_desc->dim2,
+                  get_tile_size(t->transpose_a ? MIN(max_dim2, max_dim1)
+                                               : max_dim2,
+                                AIU_2BYTE_CELLS_PER_STICK));
+  t->tile_n = MIN(t->transpose_a ? a_desc->dim2 : a_desc->dim1,
+                  get_tile_size(MIN(max_dim2, max_dim1),
+                                AIU_2BYTE_CELLS_PER_STICK));
+  t->tile_p = MIN(out_desc->dim1,
+                  get_tile_size(t->transpose_b ? MIN(max_dim2, max_dim1)
+                                               : max_dim1,
+                                AIU_2BYTE_CELLS_PER_STICK));
+
+  while (!are_matmul_tiles_within_mts(t, max_size)) {
+    if (!shrink_tile_size(&t->tile_s, 1) &&
+        !shrink_tile_size(&t->tile_n, AIU_2BYTE_CELLS_PER_STICK) &&
+        !shrink_tile_size(&t->tile_m, AIU_2BYTE_CELLS_PER_STICK) &&
+        !shrink_tile_size(&t->tile_p, AIU_2BYTE_CELLS_PER_STICK)) {
+      return ZDNN_STATUS(ZDNN_EXCEEDS_MTS,
+                         "A single stick of matmul tiles is larger than "
+                         "%" PRIu64 " bytes",
+                         max_size);
+    }
+  }
+  return ZDNN_STATUS_OK;
+}
+
+/// Compute one output tile of a tiled matmul
+///
+/// \param[in] t the tiling
+/// \param[in] out_start first (S, M, P) index of the output tile
+/// \param[in] out_count number of (S, M, P) indices of the output tile
+///
+/// \return ZDNN_OK or a failure of one of the NNPA operations
+///
+static zdnn_status matmul_output_tile(const matmul_tiling *t,
+                                      const uint32_t *out_start,
+                                      const uint32_t *out_count) {
+  const zdnn_tensor_desc *a_desc = t->input_a->transformed_desc;
+  const zdnn_tensor_desc *b_desc = t->input_b->transformed_desc;
+  const zdnn_tensor_desc *c_desc = t->input_c->transformed_desc;
+  const uint32_t dim_n = t->transpose_a ? a_desc->dim2 : a_desc->dim1;
+  const uint32_t s0 = out_start[0], sc = out_count[0];
+  const uint32_t m0 = out_start[1], mc = out_count[1];
+  const uint32_t p0 = out_start[2], pc = out_count[2];
+
+  ztensor_tile out_tile, c_tile;
+  tile_sum sum;
+  zdnn_status status;
+
+  uint32_t o_start[] = {s0, 0, m0, p0};
+  uint32_t o_count[] = {sc, 1, mc, pc};
+  uint32_t c_start[] = {0, 0, 0, p0};
+  uint32_t c_count[] = {0, 1, c_desc->dim2, pc};
+  set_stack_range(c_desc, s0, sc, c_start, c_count);
+
+  if ((status = init_ztensor_tile(t->output, o_start, o_count, false,
+                                  &out_tile)) != ZDNN_OK) {
+    return status;
+  }
+  if ((status = init_ztensor_tile(t->input_c, c_start, c_count, true,
+                                  &c_tile)) != ZDNN_OK) {
+    free_ztensor_tile(&out_tile);
+    return status;
+  }
+  init_tile_sum(&out_tile, &c_tile, &sum);
+
+  for (uint32_t n0 = 0; n0 < dim_n; n0 += t->tile_n) {
+    uint32_t nc = MIN(t->tile_n, dim_n - n0);
+    uint32_t a_start[] = {0, 0, t->transpose_a ? n0 : m0,
+                          t->transpose_a ? m0 : n0};
+    uint32_t a_count[] = {0, 1, t->transpose_a ? nc : mc,
+                          t->transpose_a ? mc : nc};
+    uint32_t b_start[] = {0, 0, t->transpose_b ? p0 : n0,
+                          t->transpose_b ? n0 : p0};
+    uint32_t b_count[] = {0, 1, t->transpose_b ? pc : nc,
+                          t->transpose_b ? nc : pc};
+    ztensor_tile a_tile, b_tile;
+
+    set_stack_range(a_desc, s0, sc, a_start, a_count);
+    set_stack_range(b_desc, s0, sc, b_start, b_count);
+    if ((status = init_ztensor_tile(t->input_a, a_start, a_count, true,
+                                    &a_tile)) != ZDNN_OK) {
+      break;
+    }
+    if ((status = init_ztensor_tile(t->input_b, b_start, b_count, true,
+                                    &b_tile)) != ZDNN_OK) {
+      free_ztensor_tile(&a_tile);
+      break;
+    }
+
+    if (n0 == 0) {
+      status = aiu_ops_func_specific(
+          t->op_parm_block_version, t->function_code, &a_tile.ztensor,
+          &b_tile.ztensor, &c_tile.ztensor, sum.acc, NULL, 0, t->fsp);
+    } else if ((status = next_tile_sum_part(&sum)) == ZDNN_OK &&
+               (status = aiu_ops_func_specific(
+                    t->op_parm_block_version, t->function_code,
+                    &a_tile.ztensor, &b_tile.ztensor, &sum.zero_bias.ztensor,
+                    &sum.part.ztensor, NULL, 0, t->fsp)) == ZDNN_OK) {
+      status = add_tile_sum_part(&sum);
+    }
+
+    free_ztensor_tile(&a_tile);
+    free_ztensor_tile(&b_tile);
+    if (status != ZDNN_OK) {
+      break;
+    }
+  }
+
+  if (status == ZDNN_OK) {
+    store_tile_sum(t->output, o_start, &sum);
+  }
+
+  free_tile_sum(&sum);
+  free_ztensor_tile(&c_tile);
+  free_ztensor_tile(&out_tile);
+  return status;
+}
+
+/// Run a matmul, tiling it into matmuls within the NNPA maximum dimension
+/// index sizes and maximum tensor size when its tensors are beyond them
+///
+/// \param[in] op_parm_block_version Parmblock version
+/// \param[in] function_code NNPA_MATMUL_OP, NNPA_MATMUL_OP_BCAST23 or
+///                          NNPA_MATMUL_OP_BCAST1
+/// \param[in] input_a the A tensor
+/// \param[in] input_b the B tensor
+/// \param[in] input_c the C tensor
+/// \param[out] output the output tensor
+/// \param[in] fsp function specific parameters of the matmul
+///
+/// \return ZDNN_OK
+///         ZDNN_EXCEEDS_MDIS
+///         ZDNN_EXCEEDS_MTS
+///         ZDNN_ALLOCATION_FAILURE
+///         a failure of the verification or of one of the NNPA operations
+///
+zdnn_status aiu_matmul_op(uint16_t op_parm_block_version,
+                          uint8_t function_code, const zdnn_ztensor *input_a,
+                          const zdnn_ztensor *input_b,
+                          const zdnn_ztensor *input_c, zdnn_ztensor *output,
+                          function_specific_parameters *fsp) {
+  zdnn_status status;
+
+  if (is_matmul_within_nnpa_limits(input_a, input_b, input_c, output)) {
+    return aiu_ops_func_specific(op_parm_block_version, function_code, input_a,
+                                 input_b, input_c, output, NULL, 0, fsp);
+  }
+
+  if (!is_query_parmblock_installed(op_parm_block_version)) {
+    return ZDNN_UNAVAILABLE_FUNCTION;
+  }
+  if ((status = check_op_plan_recordable("tiled matmul")) != ZDNN_OK) {
+    return status;
+  }
+
+  // the tile operations only verify their tiles, so verify the whole matmul
+  // up front
+  if ((status = verify_matmul_op_common(
+           function_code, input_a, input_b, input_c,
+           &fsp->function_specific_parm2, &fsp->function_specific_parm3,
+           &fsp->function_specific_parm4, &fsp->function_specific_parm9,
+           &fsp->function_specific_parm10, output)) != ZDNN_OK) {
+    return status;
+  }
+
+  if (input_b->transformed_desc->type != ZDNN_DLFLOAT16) {
+    return ZDNN_STATUS(ZDNN_EXCEEDS_MDIS,
+                       "Only DLFLOAT16 matmuls can be tiled, found %s",
+                       get_data_type_str(input_b->transformed_desc->type));
+  }
+
+  func_sp_parms_matmul *fsp_matmul = (func_sp_parms_matmul *)fsp;
+  matmul_tiling t;
+  t.op_parm_block_version = op_parm_block_version;
+  t.function_code = function_code;
+  t.input_a = input_a;
+  t.input_b = input_b;
+  t.input_c = input_c;
+  t.output = output;
+  t.fsp = fsp;
+  t.transpose_a = fsp_matmul->parm2.transpose_a;
+  t.transpose_b = fsp_matmul->parm2.transpose_b;
+
+  if ((status = init_matmul_tile_sizes(&t)) != ZDNN_OK) {
+    return status;
+  }
+
+  const zdnn_tensor_desc *out_desc = output->transformed_desc;
+  const uint32_t dim_n = t.transpose_a ? input_a->transformed_desc->dim2
+                                       : input_a->transformed_desc->dim1;
+  if (dim_n > t.tile_n && fsp_matmul->parm1.operation != MATMUL_OP_ADDITION) {
+    return ZDNN_STATUS(ZDNN_EXCEEDS_MDIS,
+                       "Comparison matmuls can't be tiled along N (%u)",
+                       dim_n);
+  }
+
+  const uint32_t out_dims[] = {out_desc->dim4, out_desc->dim2,
+                               out_desc->dim1};
+  const uint32_t tiles[] = {t.tile_s, t.tile_m, t.tile_p};
+  uint32_t start[3], count[3];
+
+  for (start[0] = 0; start[0] < out_dims[0]; start[0] += tiles[0]) {
+    count[0] = MIN(tiles[0], out_dims[0] - start[0]);
+    for (start[1] = 0; start[1] < out_dims[1]; start[1] += tiles[1]) {
+      count[1] = MIN(tiles[1], out_dims[1] - start[1]);
+      for (start[2] = 0; start[2] < out_dims[2]; start[2] += tiles[2]) {
+        count[2] = MIN(tiles[2], out_dims[2] - start[2]);
+
+        if ((status = matmul_output_tile(&t, start, count)) != ZDNN_OK) {
+          return status;
+        }
+      }
+    }
+  }
+
+  output->is_transformed = true;
+  return ZDNN_STATUS_OK;
+}
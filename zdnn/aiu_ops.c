@@ -19,6 +19,29 @@
 #include "zdnn_private.h"
 #include <string.h>
 
+#ifdef __MVS__
+#pragma export(zdnn_begin_op_plan)
+#pragma export(zdnn_end_op_plan)
+#pragma export(zdnn_execute_op_plan)
+#pragma export(zdnn_free_op_plan)
+#endif
+
+// A single zAIU operation, validated and with its parameter block built, that
+// can be executed any number of times.  parm_block comes first so that it's
+// on the 4k boundary malloc_aligned_4k() returns.
+struct zdnn_op_plan {
+  nnpa_parameter_block parm_block;
+  uint8_t function_code;
+  const zdnn_ztensor *inputs[3];
+  zdnn_ztensor *outputs[2];
+  void *own_savearea;     // save area allocated for the plan, or NULL
+  bool recorded;          // parm_block holds an operation
+  zdnn_status rec_status; // first failure while recording
+};
+
+// plan being recorded by the calling thread, see zdnn_begin_op_plan()
+static __thread zdnn_op_plan *recording_plan = NULL;
+
 /// Convenience wrapper for zAIU ops that don't need function specific
 /// parameters
 zdnn_status aiu_ops(uint16_t op_parm_block_version, uint8_t function_code,
@@ -30,6 +53,216 @@ zdnn_status aiu_ops(uint16_t op_parm_block_version, uint8_t function_code,
                                input2, input3, output1, output2, 0, &fsp);
 }
 
+/// Map the exception flags of a completed zAIU operation to a status and mark
+/// the outputs as stickified when the operation succeeded
+///
+/// \param[in] status status returned by invoke_nnpa()
+/// \param[in] ef exception flags returned by invoke_nnpa()
+/// \param[in] function_code NNPA function code
+/// \param[in] output1
+/// \param[in] output2
+///
+/// \return status of the operation
+///
+static zdnn_status finish_aiu_op(zdnn_status status, uint8_t ef,
+                                 uint8_t function_code, zdnn_ztensor *output1,
+                                 zdnn_ztensor *output2) {
+  // Indicate output tensor is stickified only if invoke_nnpa() was OK
+  if (status == ZDNN_OK) {
+    if (ef & EF_RANGE_VIOLATION_MASK) {
+      status =
+          ZDNN_STATUS(ZDNN_ELEMENT_RANGE_VIOLATION,
+                      "Range violation on tensor data", NO_ARG); /*
+                               zAIU operation returned a RANGE VIOLATION, set
+                               as a warning code and continue processing */
+    } else if (ef & ~EF_RANGE_VIOLATION_MASK) {
+      return status = ZDNN_STATUS(ZDNN_UNSUPPORTED_AIU_EXCEPTION,
+                                  "Unsupported exception on ZDNN operation",
+                                  NO_ARG); /* zAIU operation returned an
+                               unexpected exception, return as a failure */
+    }
+    output1->is_transformed = true;
+    if (function_code == NNPA_LSTMACT) {
+      output2->is_transformed = true;
+    }
+  }
+
+  return status;
+}
+
+/// Record a failure in the plan being recorded, only the first one is kept
+///
+/// \param[in] status failure status
+///
+/// \return status
+///
+static zdnn_status fail_op_plan_recording(zdnn_status status) {
+  if (recording_plan->rec_status == ZDNN_OK) {
+    recording_plan->rec_status = status;
+  }
+  return status;
+}
+
+/// Reject operations that can't be recorded in a zdnn_op_plan, i.e. ones that
+/// issue more than one zAIU operation or do work on the host CPU besides
+///
+/// \param[in] op_name name of the API being called
+///
+/// \return ZDNN_OK when no plan is being recorded by the calling thread,
+///         ZDNN_INVALID_STATE otherwise
+///
+zdnn_status check_op_plan_recordable(const char *op_name) {
+  if (!recording_plan) {
+    return ZDNN_STATUS_OK;
+  }
+  return fail_op_plan_recording(ZDNN_STATUS(
+      ZDNN_INVALID_STATE, "%s can't be recorded in an operation plan",
+      op_name));
+}
+
+/// Verify the tensors and function specific parameters of a zAIU operation
+///
+/// \param[in] function_code          NNPA function code
+/// \param[in] input1
+/// \param[in] input2
+/// \param[in] input3
+/// \param[in] output1
+/// \param[in] output2
+/// \param[in] fsp                    Functions specific parameters struct
+///
+/// \return ZDNN_OK if all checks pass. or a failure based on why it failed
+///
+static zdnn_status
+verify_aiu_op_tensors(uint8_t function_code, const zdnn_ztensor *input1,
+                      const zdnn_ztensor *input2, const zdnn_ztensor *input3,
+                      zdnn_ztensor *output1, zdnn_ztensor *output2,
+                      function_specific_parameters *fsp) {
+  zdnn_status status;
+
+  // some ops use their own verifier.  for everything else use the simple one.
+  switch (function_code) {
+  case NNPA_BATCHNORMALIZATION:
+    if ((status = verify_batchnorm_tensors(input1, input2, input3,
+                                           output1)) != ZDNN_OK) {
+      return status;
+    }
+    break;
+  case NNPA_NORM:
+    if ((status = verify_norm_tensors(input1, input2, output1)) != ZDNN_OK) {
+      return status;
+    }
+    break;
+  case NNPA_MOMENTS:
+    if ((status = verify_moments_tensors(input1, &fsp->function_specific_parm1,
+                                         output1, output2)) != ZDNN_OK) {
+      return status;
+    }
+    break;
+  case NNPA_LAYERNORM:
+    if ((status = verify_layernorm_tensors(
+             input1, input2, input3, &fsp->function_specific_parm1,
+             &fsp->function_specific_parm2, &fsp->function_specific_parm3,
+             output1)) != ZDNN_OK) {
+      return status;
+    }
+    break;
+  case NNPA_LSTMACT:
+  case NNPA_GRUACT:
+    if ((status = verify_lstm_or_gru_act_tensors(function_code, input1,
+                                                 input2, input3, output1,
+                                                 output2)) != ZDNN_OK) {
+      return status;
+    }
+    break;
+  case NNPA_MATMUL_OP:
+  case NNPA_MATMUL_OP_BCAST23:
+  case NNPA_MATMUL_OP_BCAST1:
+    if ((status = verify_matmul_op_common(
+             function_code, input1, input2, input3,
+             &fsp->function_specific_parm2, &fsp->function_specific_parm3,
+             &fsp->function_specific_parm4, &fsp->function_specific_parm9,
+             &fsp->function_specific_parm10, output1)) != ZDNN_OK) {
+      return status;
+    }
+    break;
+  case NNPA_AVGPOOL2D:
+  case NNPA_MAXPOOL2D:
+    if ((status = verify_pool_avg_max_tensors(
+             input1, &fsp->function_specific_parm1,
+             &fsp->function_specific_parm2, &fsp->function_specific_parm3,
+             &fsp->function_specific_parm4, &fsp->function_specific_parm5,
+             output1)) != ZDNN_OK) {
+      return status;
+    }
+    break;
+  case NNPA_CONVOLUTION:
+    if ((status = verify_conv2d_tensors(
+             input1, input2, input3, &fsp->function_specific_parm1,
+             &fsp->function_specific_parm2, &fsp->function_specific_parm3,
+             &fsp->function_specific_parm4, output1)) != ZDNN_OK) {
+      return status;
+    }
+    break;
+  case NNPA_RELU:
+    if ((status = verify_relu_tensors(input1, &fsp->function_specific_parm1,
+                                      &fsp->function_specific_parm2,
+                                      output1)) != ZDNN_OK) {
+      return status;
+    }
+    break;
+  case NNPA_TRANSFORM:
+    if ((status = verify_transform_tensors(
+             input1, output1, &fsp->function_specific_parm1,
+             &fsp->function_specific_parm4, &fsp->function_specific_parm5)) !=
+        ZDNN_OK) {
+      return status;
+    }
+    break;
+  case NNPA_INVSQRT:
+    if ((status = verify_invsqrt_tensors(
+             input1, &fsp->function_specific_parm1, output1)) != ZDNN_OK) {
+      return status;
+    }
+    break;
+  case NNPA_REDUCE:
+    if ((status = verify_reduce_tensors(input1, output1)) != ZDNN_OK) {
+      return status;
+    }
+    break;
+  default:
+    if ((status = verify_tensors(input1, input2, input3, output1)) != ZDNN_OK) {
+      return status;
+    }
+    break;
+  }
+
+  return ZDNN_STATUS_OK;
+}
+
+/// Check if all given tensors are within the maximum dimension index sizes
+/// and maximum tensor size of the zAIU
+///
+/// \param[in] input1
+/// \param[in] input2
+/// \param[in] input3
+/// \param[in] output1
+///
+/// \return true if none of the non-NULL tensors is beyond the limits
+///
+static bool are_tensors_within_nnpa_limits(const zdnn_ztensor *input1,
+                                           const zdnn_ztensor *input2,
+                                           const zdnn_ztensor *input3,
+                                           const zdnn_ztensor *output1) {
+  const zdnn_ztensor *tensors[] = {input1, input2, input3, output1};
+
+  for (int i = 0; i < 4; i++) {
+    if (tensors[i] && !is_within_nnpa_limits(tensors[i]->transformed_desc)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 /// Common routine for invoking zAIU operations with function specific
 /// parameters
 ///
@@ -56,110 +289,46 @@ aiu_ops_func_specific(uint16_t op_parm_block_version, uint8_t function_code,
                       function_specific_parameters *fsp) {
   zdnn_status status;
   uint8_t ef = 0;
-#define EF_RANGE_VIOLATION_MASK 0x80
 
   if (!is_query_parmblock_installed(op_parm_block_version)) {
     return ZDNN_UNAVAILABLE_FUNCTION;
   }
 
-  if (precheck_enabled) {
-    // some ops use their own verifier.  for everything else use the simple one.
-    switch (function_code) {
-    case NNPA_BATCHNORMALIZATION:
-      if ((status = verify_batchnorm_tensors(input1, input2, input3,
-                                             output1)) != ZDNN_OK) {
-        return status;
-      }
-      break;
-    case NNPA_NORM:
-      if ((status = verify_norm_tensors(input1, input2, output1)) != ZDNN_OK) {
-        return status;
-      }
-      break;
-    case NNPA_MOMENTS:
-      if ((status =
-               verify_moments_tensors(input1, &fsp->function_specific_parm1,
-                                      output1, output2)) != ZDNN_OK) {
-        return status;
-      }
-      break;
-    case NNPA_LAYERNORM:
-      if ((status = verify_layernorm_tensors(
-               input1, input2, input3, &fsp->function_specific_parm1,
-               &fsp->function_specific_parm2, &fsp->function_specific_parm3,
-               output1)) != ZDNN_OK) {
-        return status;
-      }
-      break;
-    case NNPA_LSTMACT:
-    case NNPA_GRUACT:
-      if ((status = verify_lstm_or_gru_act_tensors(function_code, input1,
-                                                   input2, input3, output1,
-                                                   output2)) != ZDNN_OK) {
-        return status;
-      }
-      break;
-    case NNPA_MATMUL_OP:
-    case NNPA_MATMUL_OP_BCAST23:
-    case NNPA_MATMUL_OP_BCAST1:
-      if ((status = verify_matmul_op_common(
-               function_code, input1, input2, input3,
-               &fsp->function_specific_parm2, &fsp->function_specific_parm3,
-               &fsp->function_specific_parm4, &fsp->function_specific_parm9,
-               &fsp->function_specific_parm10, output1)) != ZDNN_OK) {
-        return status;
-      }
-      break;
-    case NNPA_AVGPOOL2D:
-    case NNPA_MAXPOOL2D:
-      if ((status = verify_pool_avg_max_tensors(
-               input1, &fsp->function_specific_parm1,
-               &fsp->function_specific_parm2, &fsp->function_specific_parm3,
-               &fsp->function_specific_parm4, &fsp->function_specific_parm5,
-               output1)) != ZDNN_OK) {
-        return status;
-      }
-      break;
-    case NNPA_CONVOLUTION:
-      if ((status = verify_conv2d_tensors(
-               input1, input2, input3, &fsp->function_specific_parm1,
-               &fsp->function_specific_parm2, &fsp->function_specific_parm3,
-               &fsp->function_specific_parm4, output1)) != ZDNN_OK) {
-        return status;
-      }
-      break;
-    case NNPA_RELU:
-      if ((status = verify_relu_tensors(input1, &fsp->function_specific_parm1,
-                                        &fsp->function_specific_parm2,
-                                        output1)) != ZDNN_OK) {
-        return status;
-      }
-      break;
-    case NNPA_TRANSFORM:
-      if ((status = verify_transform_tensors(
-               input1, output1, &fsp->function_specific_parm1,
-               &fsp->function_specific_parm4, &fsp->function_specific_parm5)) !=
-          ZDNN_OK) {
-        return status;
-      }
-      break;
-    case NNPA_INVSQRT:
-      if ((status = verify_invsqrt_tensors(
-               input1, &fsp->function_specific_parm1, output1)) != ZDNN_OK) {
-        return status;
-      }
-      break;
-    case NNPA_REDUCE:
-      if ((status = verify_reduce_tensors(input1, output1)) != ZDNN_OK) {
-        return status;
-      }
-      break;
-    default:
-      if ((status = verify_tensors(input1, input2, input3, output1)) !=
-          ZDNN_OK) {
-        return status;
-      }
-      break;
+  // tensors beyond the zAIU limits are split into chunks within them, when
+  // the operation allows
+  if (is_chunkable_op(function_code) && !output2 &&
+      !are_tensors_within_nnpa_limits(input1, input2, input3, output1)) {
+    if ((status = check_op_plan_recordable(
+             get_function_code_str(function_code))) != ZDNN_OK) {
+      return status;
+    }
+    // the chunk operations only verify their chunks
+    if ((status = verify_aiu_op_tensors(function_code, input1, input2, input3,
+                                        output1, output2, fsp)) != ZDNN_OK) {
+      return status;
+    }
+    return aiu_ops_chunked(op_parm_block_version, function_code, input1,
+                           input2, input3, output1, func_sp_savearea_addr,
+                           fsp);
+  }
+
+  if (recording_plan) {
+    // stickification builds temporary ztensors, it can't be replayed
+    if (function_code == NNPA_TRANSFORM) {
+      return check_op_plan_recordable("NNPA_TRANSFORM");
+    }
+    if (recording_plan->recorded) {
+      return fail_op_plan_recording(
+          ZDNN_STATUS(ZDNN_INVALID_STATE,
+                      "Only one operation can be recorded in a plan", NO_ARG));
+    }
+  }
+
+  // a plan is validated once, so always do it then
+  if (precheck_enabled || recording_plan) {
+    if ((status = verify_aiu_op_tensors(function_code, input1, input2, input3,
+                                        output1, output2, fsp)) != ZDNN_OK) {
+      return status;
     }
   }
 
@@ -176,6 +345,24 @@ aiu_ops_func_specific(uint16_t op_parm_block_version, uint8_t function_code,
     }
   }
 
+  if (recording_plan) {
+    zdnn_op_plan *plan = recording_plan;
+
+    // the plan keeps our own savearea (if any) until it's freed
+    populate_nnpa_parm_block(&plan->parm_block, op_parm_block_version, input1,
+                             input2, input3, output1, output2, savearea_addr,
+                             fsp);
+    plan->function_code = function_code;
+    plan->inputs[0] = input1;
+    plan->inputs[1] = input2;
+    plan->inputs[2] = input3;
+    plan->outputs[0] = output1;
+    plan->outputs[1] = output2;
+    plan->own_savearea = func_sp_savearea_addr ? NULL : savearea_addr;
+    plan->recorded = true;
+    return ZDNN_STATUS_OK;
+  }
+
   nnpa_parameter_block parm_block;
 
   populate_nnpa_parm_block(&parm_block, op_parm_block_version, input1, input2,
@@ -187,25 +374,121 @@ aiu_ops_func_specific(uint16_t op_parm_block_version, uint8_t function_code,
     free_aligned_4k(savearea_addr);
   }
 
-  // Indicate output tensor is stickified only if invoke_nnpa() was OK
-  if (status == ZDNN_OK) {
-    if (ef & EF_RANGE_VIOLATION_MASK) {
-      status =
-          ZDNN_STATUS(ZDNN_ELEMENT_RANGE_VIOLATION,
-                      "Range violation on tensor data", NO_ARG); /*
-                               zAIU operation returned a RANGE VIOLATION, set
-                               as a warning code and continue processing */
-    } else if (ef & ~EF_RANGE_VIOLATION_MASK) {
-      return status = ZDNN_STATUS(ZDNN_UNSUPPORTED_AIU_EXCEPTION,
-                                  "Unsupported exception on ZDNN operation",
-                                  NO_ARG); /* zAIU operation returned an
-                               unexpected exception, return as a failure */
+  return finish_aiu_op(status, ef, function_code, output1, output2);
+}
+
+/// Start recording an operation plan on the calling thread.  The next zDNN
+/// operation called by this thread is validated and its NNPA parameter block
+/// built, but it isn't executed; the operation returns ZDNN_OK instead.  Call
+/// zdnn_end_op_plan() after it.
+///
+/// \param[out] plan Pointer to receive the new plan
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_STATE
+///         ZDNN_ALLOCATION_FAILURE
+///
+zdnn_status zdnn_begin_op_plan(zdnn_op_plan **plan) {
+  if (recording_plan) {
+    return ZDNN_STATUS(ZDNN_INVALID_STATE,
+                       "A plan is already being recorded by this thread",
+                       NO_ARG);
+  }
+
+  zdnn_op_plan *new_plan = malloc_aligned_4k(sizeof(zdnn_op_plan));
+  if (!new_plan) {
+    return ZDNN_STATUS(ZDNN_ALLOCATION_FAILURE,
+                       "Unable to allocate %zu bytes for operation plan.",
+                       sizeof(zdnn_op_plan));
+  }
+  memset(new_plan, 0, sizeof(zdnn_op_plan));
+
+  recording_plan = new_plan;
+  *plan = new_plan;
+  return ZDNN_STATUS_OK;
+}
+
+/// Stop recording an operation plan
+///
+/// \param[in] plan Pointer to the plan returned by zdnn_begin_op_plan()
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_STATE
+///
+zdnn_status zdnn_end_op_plan(zdnn_op_plan *plan) {
+  if (!plan || plan != recording_plan) {
+    return ZDNN_STATUS(ZDNN_INVALID_STATE,
+                       "Plan is not being recorded by this thread", NO_ARG);
+  }
+  recording_plan = NULL;
+
+  if (plan->rec_status != ZDNN_OK) {
+    return plan->rec_status;
+  }
+  if (!plan->recorded) {
+    return ZDNN_STATUS(ZDNN_INVALID_STATE, "No operation recorded in plan",
+                       NO_ARG);
+  }
+  return ZDNN_STATUS_OK;
+}
+
+/// Execute the operation recorded in a plan.  The tensor data addresses are
+/// refreshed from the buffer fields of the zTensors the operation was recorded
+/// with, nothing else is validated or rebuilt.
+///
+/// \param[in] plan Pointer to a plan recorded successfully
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_STATE
+///         ZDNN_ELEMENT_RANGE_VIOLATION
+///         ZDNN_UNSUPPORTED_AIU_EXCEPTION
+///         hardware statuses (see invoke_nnpa())
+///
+zdnn_status zdnn_execute_op_plan(zdnn_op_plan *plan) {
+  if (!plan || !plan->recorded || plan->rec_status != ZDNN_OK ||
+      plan == recording_plan) {
+    return ZDNN_STATUS(ZDNN_INVALID_STATE,
+                       "Plan has not been recorded successfully", NO_ARG);
+  }
+
+  nnpa_tensor_descriptor *inputs = &plan->parm_block.input_tensor1;
+  nnpa_tensor_descriptor *outputs = &plan->parm_block.output_tensor1;
+
+  for (int i = 0; i < 3; i++) {
+    if (plan->inputs[i]) {
+      inputs[i].tensor_data_addr = plan->inputs[i]->buffer;
     }
-    output1->is_transformed = true;
-    if (function_code == NNPA_LSTMACT) {
-      output2->is_transformed = true;
+  }
+  for (int i = 0; i < 2; i++) {
+    if (plan->outputs[i]) {
+      outputs[i].tensor_data_addr = plan->outputs[i]->buffer;
     }
   }
 
-  return status;
+  uint8_t ef = 0;
+  zdnn_status status =
+      invoke_nnpa(plan->function_code, (char *)&plan->parm_block, &ef);
+
+  return finish_aiu_op(status, ef, plan->function_code, plan->outputs[0],
+                       plan->outputs[1]);
+}
+
+/// Free an operation plan
+///
+/// \param[in] plan Pointer to the plan returned by zdnn_begin_op_plan(), or
+///                 NULL
+///
+/// \return None
+///
+void zdnn_free_op_plan(zdnn_op_plan *plan) {
+  if (!plan) {
+    return;
+  }
+  if (plan == recording_plan) {
+    recording_plan = NULL;
+  }
+  if (plan->own_savearea) {
+    free_aligned_4k(plan->own_savearea);
+  }
+  free_aligned_4k(plan);
 }
@@ -0,0 +1,301 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "zdnn.h"
+#include "zdnn_private.h"
+
+/*
+  An elementwise, activation or normalization operation given a tensor beyond
+  the NNPA maximum dimension index sizes or maximum tensor size is run on
+  chunks of the output's (dim4, dim3, dim2) rows that are within them.  Every
+  row keeps all its dim1 cells, so operations across a row (softmax,
+  layernorm, norm and reduce) see the same rows as they would unchunked.
+
+  Every other tensor is chunked along with the output in the dims it has the
+  output's size in, and is passed whole in the dims it has size 1 in (e.g.
+  the batchnorm scale and bias).  Chunks are set up by init_ztensor_tile(), so
+  whole-row chunks along dim4 are views and the rest are temporary copies.
+*/
+
+/// Check if an operation can be run on chunks of its output's rows
+///
+/// \param[in] function_code NNPA function code
+///
+/// \return true if the operation can be chunked
+///
+bool is_chunkable_op(uint8_t function_code) {
+  switch (function_code) {
+  case NNPA_ADD:
+  case NNPA_SUB:
+  case NNPA_MUL:
+  case NNPA_DIV:
+  case NNPA_MIN:
+  case NNPA_MAX:
+  case NNPA_LOG:
+  case NNPA_EXP:
+  case NNPA_SQRT:
+  case NNPA_INVSQRT:
+  case NNPA_RELU:
+  case NNPA_TANH:
+  case NNPA_SIGMOID:
+  case NNPA_SOFTMAX:
+  case NNPA_GELU:
+  case NNPA_BATCHNORMALIZATION:
+  case NNPA_LAYERNORM:
+  case NNPA_NORM:
+  case NNPA_REDUCE:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// Work out the range of a tensor that goes with a chunk of the output
+///
+/// \param[in] desc transformed descriptor of the tensor
+/// \param[in] out_start first output index of the chunk in dim4, dim3, dim2
+/// \param[in] out_count number of output indices of the chunk in dim4, dim3,
+///                      dim2
+/// \param[out] start first index of the tensor's range, dim4 first
+/// \param[out] count number of indices of the tensor's range, dim4 first
+///
+/// \return None
+///
+static void get_chunk_range(const zdnn_tensor_desc *desc,
+                            const uint32_t *out_start,
+                            const uint32_t *out_count, uint32_t *start,
+                            uint32_t *count) {
+  const uint32_t dims[] = {desc->dim4, desc->dim3, desc->dim2};
+
+  for (int i = 0; i < 3; i++) {
+    // a dim of size 1 is broadcast to every output index
+    bool whole = dims[i] == 1;
+    start[i] = whole ? 0 : out_start[i];
+    count[i] = whole ? 1 : out_count[i];
+  }
+  start[3] = 0;
+  count[3] = desc->dim1;
+}
+
+/// Stick area size of the largest tensor range that goes with a chunk of the
+/// given size at the start of the output
+///
+/// \param[in] tensors the operation's tensors
+/// \param[in] num_tensors number of tensors
+/// \param[in] chunk number of output indices of the chunk in dim4, dim3, dim2
+///
+/// \return size in bytes
+///
+static uint64_t get_max_chunk_size(const zdnn_ztensor *const *tensors,
+                                   int num_tensors, const uint32_t *chunk) {
+  const uint32_t zeros[] = {0, 0, 0};
+  uint64_t max_size = 0;
+
+  for (int i = 0; i < num_tensors; i++) {
+    zdnn_tensor_desc desc = *tensors[i]->transformed_desc;
+    uint32_t start[ZDNN_MAX_DIMS], count[ZDNN_MAX_DIMS];
+
+    get_chunk_range(&desc, zeros, chunk, start, count);
+    desc.dim4 = count[0];
+    desc.dim3 = count[1];
+    desc.dim2 = count[2];
+    max_size = MAX(max_size, zdnn_getsize_ztensor(&desc));
+  }
+  return max_size;
+}
+
+/// Run an operation on one chunk of its output's rows
+///
+/// \param[in] op_parm_block_version Parmblock version
+/// \param[in] function_code NNPA function code
+/// \param[in] tensors the operation's tensors, inputs first and output last
+/// \param[in] num_tensors number of tensors
+/// \param[in] func_sp_savearea_addr Function-specific-save-area-address
+/// \param[in] fsp Functions specific parameters struct
+/// \param[in] out_start first output index of the chunk in dim4, dim3, dim2
+/// \param[in] out_count number of output indices of the chunk in dim4, dim3,
+///                      dim2
+///
+/// \return status of the operation, or ZDNN_ALLOCATION_FAILURE
+///
+static zdnn_status run_op_chunk(uint16_t op_parm_block_version,
+                                uint8_t function_code,
+                                const zdnn_ztensor *const *tensors,
+                                int num_tensors, uint64_t func_sp_savearea_addr,
+                                function_specific_parameters *fsp,
+                                const uint32_t *out_start,
+                                const uint32_t *out_count) {
+  ztensor_tile tiles[4];
+  uint32_t starts[4][ZDNN_MAX_DIMS], counts[4][ZDNN_MAX_DIMS];
+  const zdnn_ztensor *inputs[3] = {NULL, NULL, NULL};
+  int num_tiles;
+  zdnn_status status = ZDNN_OK;
+
+  for (num_tiles = 0; num_tiles < num_tensors; num_tiles++) {
+    int i = num_tiles;
+    bool is_output = i == num_tensors - 1;
+
+    get_chunk_range(tensors[i]->transformed_desc, out_start, out_count,
+                    starts[i], counts[i]);
+    if ((status = init_ztensor_tile(tensors[i], starts[i], counts[i],
+                                    !is_output, &tiles[i])) != ZDNN_OK) {
+      break;
+    }
+    if (!is_output) {
+      inputs[i] = &tiles[i].ztensor;
+    }
+  }
+
+  if (status == ZDNN_OK) {
+    ztensor_tile *out_tile = &tiles[num_tensors - 1];
+
+    status = aiu_ops_func_specific(op_parm_block_version, function_code,
+                                   inputs[0], inputs[1], inputs[2],
+                                   &out_tile->ztensor, NULL,
+                                   func_sp_savearea_addr, fsp);
+    if (status == ZDNN_OK ||
+        (status & WARNING_STATUS_BITMASK) == ZDNN_WARNING) {
+      store_ztensor_tile(tensors[num_tensors - 1], starts[num_tensors - 1],
+                         out_tile);
+    }
+  }
+
+  while (num_tiles--) {
+    free_ztensor_tile(&tiles[num_tiles]);
+  }
+  return status;
+}
+
+/// Run an operation on tensors beyond the NNPA maximum dimension index sizes
+/// or maximum tensor size as operations on chunks of its output's rows.  The
+/// operation must be chunkable (see is_chunkable_op()) and its tensors
+/// verified.
+///
+/// \param[in] op_parm_block_version Parmblock version
+/// \param[in] function_code NNPA function code
+/// \param[in] input1
+/// \param[in] input2
+/// \param[in] input3
+/// \param[in] output1
+/// \param[in] func_sp_savearea_addr Function-specific-save-area-address
+/// \param[in] fsp Functions specific parameters struct
+///
+/// \return ZDNN_OK
+///         ZDNN_ELEMENT_RANGE_VIOLATION
+///         ZDNN_EXCEEDS_MDIS
+///         ZDNN_EXCEEDS_MTS
+///         ZDNN_ALLOCATION_FAILURE
+///         a failure of one of the chunk operations
+///
+zdnn_status aiu_ops_chunked(uint16_t op_parm_block_version,
+                            uint8_t function_code, const zdnn_ztensor *input1,
+                            const zdnn_ztensor *input2,
+                            const zdnn_ztensor *input3, zdnn_ztensor *output1,
+                            uint64_t func_sp_savearea_addr,
+                            function_specific_parameters *fsp) {
+  const zdnn_tensor_desc *out_desc = output1->transformed_desc;
+  const uint32_t out_dims[] = {out_desc->dim4, out_desc->dim3, out_desc->dim2};
+  const zdnn_ztensor *tensors[4];
+  int num_tensors = 0;
+
+  if (input1) {
+    tensors[num_tensors++] = input1;
+  }
+  if (input2) {
+    tensors[num_tensors++] = input2;
+  }
+  if (input3) {
+    tensors[num_tensors++] = input3;
+  }
+  tensors[num_tensors++] = output1;
+
+  for (int i = 0; i < num_tensors; i++) {
+    const zdnn_tensor_desc *desc = tensors[i]->transformed_desc;
+    const uint32_t dims[] = {desc->dim4, desc->dim3, desc->dim2};
+
+    if (desc->dim1 > zdnn_get_max_for_dim(1)) {
+      return ZDNN_STATUS(ZDNN_EXCEEDS_MDIS,
+                         "dim1 (%u) can't be split into chunks", desc->dim1);
+    }
+    for (int d = 0; d < 3; d++) {
+      if (dims[d] != out_dims[d] && dims[d] != 1) {
+        return ZDNN_STATUS(ZDNN_EXCEEDS_MDIS,
+                           "dim%d (%u) of an input doesn't follow the output "
+                           "(%u) so can't be split into chunks",
+                           ZDNN_MAX_DIMS - d, dims[d], out_dims[d]);
+      }
+    }
+  }
+
+  // chunks start on a page of sticks along dim2, and are cut down dim4 first,
+  // so chunks of whole dim4 entries are views of the tensors
+  uint32_t chunk[3];
+  uint32_t max_dim2 = zdnn_get_max_for_dim(2);
+  if (max_dim2 >= AIU_STICKS_PER_PAGE) {
+    max_dim2 = max_dim2 / AIU_STICKS_PER_PAGE * AIU_STICKS_PER_PAGE;
+  }
+  chunk[0] = MIN(out_dims[0], zdnn_get_max_for_dim(4));
+  chunk[1] = MIN(out_dims[1], zdnn_get_max_for_dim(3));
+  chunk[2] = MIN(out_dims[2], max_dim2);
+
+  while (get_max_chunk_size(tensors, num_tensors, chunk) >
+         zdnn_get_nnpa_max_tensor_size()) {
+    if (chunk[0] > 1) {
+      chunk[0] = CEIL(chunk[0], 2);
+    } else if (chunk[1] > 1) {
+      chunk[1] = CEIL(chunk[1], 2);
+    } else if (chunk[2] > AIU_STICKS_PER_PAGE) {
+      chunk[2] = CEIL(CEIL(chunk[2], 2), AIU_STICKS_PER_PAGE) *
+                 AIU_STICKS_PER_PAGE;
+    } else if (chunk[2] > 1) {
+      chunk[2] = CEIL(chunk[2], 2);
+    } else {
+      return ZDNN_STATUS(ZDNN_EXCEEDS_MTS,
+                         "A single row of dim1 cells is larger than %" PRIu64
+                         " bytes",
+                         zdnn_get_nnpa_max_tensor_size());
+    }
+  }
+
+  zdnn_status status, warning = ZDNN_OK;
+  uint32_t start[3], count[3];
+
+  for (start[0] = 0; start[0] < out_dims[0]; start[0] += chunk[0]) {
+    count[0] = MIN(chunk[0], out_dims[0] - start[0]);
+    for (start[1] = 0; start[1] < out_dims[1]; start[1] += chunk[1]) {
+      count[1] = MIN(chunk[1], out_dims[1] - start[1]);
+      for (start[2] = 0; start[2] < out_dims[2]; start[2] += chunk[2]) {
+        count[2] = MIN(chunk[2], out_dims[2] - start[2]);
+
+        status = run_op_chunk(op_parm_block_version, function_code, tensors,
+                              num_tensors, func_sp_savearea_addr, fsp, start,
+                              count);
+        if ((status & WARNING_STATUS_BITMASK) == ZDNN_WARNING) {
+          // keep going, the operation is reported as done with the warning
+          warning = status;
+        } else if (status != ZDNN_OK) {
+          return status;
+        }
+      }
+    }
+  }
+
+  output1->is_transformed = true;
+  return warning;
+}
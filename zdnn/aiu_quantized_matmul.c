@@ -15,6 +15,8 @@
  * limitations under the License.
  */
 
+#include <math.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -24,12 +26,13 @@
 
 #ifdef __MVS__
 #pragma export(zdnn_getrange_ztensor)
+#pragma export(zdnn_reset_quantized_bias_cache)
 #endif
 
-typedef vector float vec_fp32;
-typedef vector signed int vec_int;
-typedef vector signed short vec_short;
-typedef vector signed char vec_char;
+typedef VEC_UNALIGNED float vec_fp32;
+typedef VEC_UNALIGNED signed int vec_int;
+typedef VEC_UNALIGNED signed short vec_short;
+typedef VEC_UNALIGNED signed char vec_char;
 
 /// Calculates the min and max values and places them in the passed pointers
 ///
@@ -119,8 +122,8 @@ zdnn_status zdnn_getrange_ztensor(const zdnn_ztensor *ztensor, float *min,
 
       // W
       for (uint32_t e2x = 0; e2x < c_page_w_iterations; e2x++) {
-        min_vec = vec_max(min_vec, *min_input_vec++);
-        max_vec = vec_max(max_vec, *max_input_vec++);
+        min_vec = vec_max(min_vec, VEC_STICK_CELLS16(*min_input_vec++));
+        max_vec = vec_max(max_vec, VEC_STICK_CELLS16(*max_input_vec++));
       }
 
       min_input_vec += w_padding_vectors;
@@ -138,15 +141,18 @@ zdnn_status zdnn_getrange_ztensor(const zdnn_ztensor *ztensor, float *min,
 
           // Full Vectors
           for (uint32_t e1x = 0; e1x < v_mod_vector; e1x++) {
-            min_vec = vec_max(min_vec, *min_input_vec++);
-            max_vec = vec_max(max_vec, *max_input_vec++);
+            min_vec = vec_max(min_vec, VEC_STICK_CELLS16(*min_input_vec++));
+            max_vec = vec_max(max_vec, VEC_STICK_CELLS16(*max_input_vec++));
           }
 
           // Padded Vector
           if (v_mod) {
             for (uint32_t i = 0; i < v_mod; i++) {
-              min_val = MAX(min_val, (*min_input_vec)[i]);
-              max_val = MAX(max_val, (*max_input_vec)[i]);
+              const uint16_t min_cell = STICK_CELL16((*min_input_vec)[i]);
+              const int16_t max_cell =
+                  (int16_t)STICK_CELL16((*max_input_vec)[i]);
+              min_val = MAX(min_val, min_cell);
+              max_val = MAX(max_val, max_cell);
             }
 
             min_input_vec++;
@@ -185,9 +191,9 @@ zdnn_status zdnn_getrange_ztensor(const zdnn_ztensor *ztensor, float *min,
   float range[2];
   void *dlfloat_range = (void *)range;
 
-  // Store results in the range as DLFloat
-  ((uint16_t *)dlfloat_range)[0] = min_val;
-  ((int16_t *)dlfloat_range)[1] = max_val;
+  // Store results in the range as DLFloat, in stick byte order
+  ((uint16_t *)dlfloat_range)[0] = STICK_CELL16(min_val);
+  ((uint16_t *)dlfloat_range)[1] = STICK_CELL16(max_val);
 
   // Convert range from DLFloat to FP32 in-place
   uint32_t nbr_fields_converted = convert_data_format(
@@ -203,6 +209,88 @@ zdnn_status zdnn_getrange_ztensor(const zdnn_ztensor *ztensor, float *min,
   return ZDNN_STATUS_OK;
 }
 
+/*
+  Bias cache
+
+  The biases folded with the column sums of input_b (compute_folded_bias() and
+  compute_comparison_bias()) take a pass over all of the weights on the CPU,
+  yet for a given layer the weights, the biases and their quantization
+  parameters rarely change from one request to the next.  When
+  qmatmul_bias_cache_entries is not 0, the computed qc_tilde is kept in a
+  cache keyed on everything it's computed from, and later requests copy it into
+  their work area instead of computing it again.  The least recently used entry
+  is dropped when the cache is full.
+
+  The key holds the buffer addresses of input_b and input_c, not their data.
+  zdnn_transform_quantized_ztensor() and zdnn_free_ztensor_buffer() drop the
+  entries of the buffer they're given; an application changing a buffer any
+  other way calls zdnn_reset_quantized_bias_cache().
+*/
+
+typedef enum bias_kinds { BIAS_FOLDED, BIAS_COMPARISON } bias_kinds;
+
+typedef struct bias_cache_entry {
+  struct bias_cache_entry *next; // most recently used first
+  bias_kinds kind;
+  const void *input_b_buffer;
+  const void *input_c_buffer;
+  uint32_t input_b_dims[ZDNN_MAX_DIMS]; // transformed dims
+  uint32_t input_c_dims[ZDNN_MAX_DIMS];
+  float scale;
+  float offset;
+  float zero_point; // MZa for BIAS_FOLDED, Za for BIAS_COMPARISON
+  uint64_t buffer_size;
+  void *buffer; // copy of qc_tilde->buffer
+} bias_cache_entry;
+
+static pthread_mutex_t bias_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static bias_cache_entry *bias_cache = NULL;
+static uint32_t bias_cache_count = 0;
+
+/// Unlink and free a bias cache entry, bias_cache_lock must be held
+///
+/// \param[in] link The link pointing to the entry
+///
+static void remove_bias_cache_entry(bias_cache_entry **link) {
+  bias_cache_entry *entry = *link;
+  *link = entry->next;
+  free_aligned_4k(entry->buffer);
+  free(entry);
+  bias_cache_count--;
+}
+
+/// Drop the cached biases computed from a buffer, as input_b or input_c
+///
+/// \param[in] buffer The zTensor buffer about to be changed or freed
+///
+void invalidate_qmatmul_bias_cache(const void *buffer) {
+  pthread_mutex_lock(&bias_cache_lock);
+  bias_cache_entry **link = &bias_cache;
+  while (*link) {
+    if ((*link)->input_b_buffer == buffer ||
+        (*link)->input_c_buffer == buffer) {
+      remove_bias_cache_entry(link);
+    } else {
+      link = &(*link)->next;
+    }
+  }
+  pthread_mutex_unlock(&bias_cache_lock);
+}
+
+/// Drop all the biases zdnn_quantized_matmul_op() has cached. Needed after the
+/// application changes the data of a cached input_b or input_c without going
+/// through zdnn_transform_quantized_ztensor().
+///
+/// \return None
+///
+void zdnn_reset_quantized_bias_cache() {
+  pthread_mutex_lock(&bias_cache_lock);
+  while (bias_cache) {
+    remove_bias_cache_entry(&bias_cache);
+  }
+  pthread_mutex_unlock(&bias_cache_lock);
+}
+
 #ifndef ZDNN_CONFIG_NO_NNPA
 /// Computes the bias to be passed to quantized matmul call when operation is
 /// MATMUL_OP_ADDITION.
@@ -366,6 +454,51 @@ static void compute_bias(const zdnn_ztensor *input_c, const float scale,
   qc_tilde->is_transformed = true;
 }
 
+/// Computes the bias to be passed to quantized matmul call when operation is
+/// MATMUL_OP_ADDITION and input_b is quantized per output channel.  Same as
+/// compute_bias(), but with a scale and offset per input_c[j]:
+///   qc_tilde[j] = input_c[j] * scales[j] + offsets[j]
+///
+/// \param[in] input_c The biases ztensor, quantized.
+/// \param[in] scales Per-channel scales, input_c dim1 of them.
+/// \param[in] offsets Per-channel offsets, input_c dim1 of them.
+/// \param[out] qc_tilde The computed biases ztensor.
+///
+static void compute_channel_bias(const zdnn_ztensor *input_c,
+                                 const float *scales, const float *offsets,
+                                 zdnn_ztensor *qc_tilde) {
+  const zdnn_tensor_desc *c_desc = input_c->transformed_desc;
+
+  // dim3 and dim2 are 1, so every stick is on a page of its own
+  const uint64_t in_c_bytes_per_n =
+      CEIL(c_desc->dim1, AIU_1BYTE_CELLS_PER_STICK) * AIU_PAGESIZE_IN_BYTES;
+
+  const uint64_t out_bytes_per_n =
+      CEIL(c_desc->dim1, AIU_2BYTE_CELLS_PER_STICK) * AIU_PAGESIZE_IN_BYTES;
+
+  for (uint32_t e4x = 0; e4x < c_desc->dim4; e4x++) {
+    const uintptr_t in_c_n =
+        (uintptr_t)input_c->buffer + e4x * in_c_bytes_per_n;
+    const uintptr_t out_n = (uintptr_t)qc_tilde->buffer + e4x * out_bytes_per_n;
+
+    for (uint32_t e1x = 0; e1x < c_desc->dim1; e1x++) {
+      const uint64_t in_c_page = e1x / AIU_1BYTE_CELLS_PER_STICK;
+      const uint64_t out_page = e1x / AIU_2BYTE_CELLS_PER_STICK;
+
+      const int8_t *in_c =
+          (int8_t *)(in_c_n + in_c_page * AIU_PAGESIZE_IN_BYTES) +
+          e1x % AIU_1BYTE_CELLS_PER_STICK;
+      uint16_t *out = (uint16_t *)(out_n + out_page * AIU_PAGESIZE_IN_BYTES) +
+                      e1x % AIU_2BYTE_CELLS_PER_STICK;
+
+      *out = STICK_CELL16(
+          cnvt_1_fp32_to_dlf16((float)*in_c * scales[e1x] + offsets[e1x]));
+    }
+  }
+
+  qc_tilde->is_transformed = true;
+}
+
 /// Computes the folded bias to be passed to quantized matmul call when
 /// operation is MATMUL_OP_ADDITION. Zb should be equal to 0, meaning the
 /// correction term for input_a is also equal to 0. This allows the correction
@@ -1160,6 +1293,152 @@ static void compute_comparison_bias(const zdnn_ztensor *input_b,
   qc_tilde->is_transformed = true;
 }
 
+/// Fill in a bias cache key
+///
+/// \param[in] kind Which of the biases is computed
+/// \param[in] input_b The weights ztensor, quantized.
+/// \param[in] input_c The biases ztensor, quantized.
+/// \param[in] scale The scale the bias is computed with.
+/// \param[in] offset The offset the bias is computed with.
+/// \param[in] zero_point MZa or Za the bias is computed with.
+/// \param[out] key The key, with buffer left unset
+///
+static void init_bias_cache_key(bias_kinds kind, const zdnn_ztensor *input_b,
+                                const zdnn_ztensor *input_c, const float scale,
+                                const float offset, const float zero_point,
+                                bias_cache_entry *key) {
+  const zdnn_tensor_desc *b_desc = input_b->transformed_desc;
+  const zdnn_tensor_desc *c_desc = input_c->transformed_desc;
+
+  key->kind = kind;
+  key->input_b_buffer = input_b->buffer;
+  key->input_c_buffer = input_c->buffer;
+  key->input_b_dims[0] = b_desc->dim4;
+  key->input_b_dims[1] = b_desc->dim3;
+  key->input_b_dims[2] = b_desc->dim2;
+  key->input_b_dims[3] = b_desc->dim1;
+  key->input_c_dims[0] = c_desc->dim4;
+  key->input_c_dims[1] = c_desc->dim3;
+  key->input_c_dims[2] = c_desc->dim2;
+  key->input_c_dims[3] = c_desc->dim1;
+  key->scale = scale;
+  key->offset = offset;
+  key->zero_point = zero_point;
+}
+
+/// Whether a bias cache entry was computed from the same inputs as a key
+///
+/// \param[in] entry The cache entry
+/// \param[in] key The key
+///
+/// \return true if the entry's bias can be reused
+///
+static bool bias_cache_entry_matches(const bias_cache_entry *entry,
+                                     const bias_cache_entry *key) {
+  return entry->kind == key->kind &&
+         entry->input_b_buffer == key->input_b_buffer &&
+         entry->input_c_buffer == key->input_c_buffer &&
+         !memcmp(entry->input_b_dims, key->input_b_dims,
+                 sizeof(key->input_b_dims)) &&
+         !memcmp(entry->input_c_dims, key->input_c_dims,
+                 sizeof(key->input_c_dims)) &&
+         entry->scale == key->scale && entry->offset == key->offset &&
+         entry->zero_point == key->zero_point;
+}
+
+/// Computes the folded or comparison bias into qc_tilde, or copies it from the
+/// bias cache when it was computed from the same inputs before. Biases computed
+/// with the cache enabled are added to it.
+///
+/// \param[in] kind Which of the biases to compute
+/// \param[in] input_b The weights ztensor, quantized.
+/// \param[in] input_c The biases ztensor, quantized.
+/// \param[in] scale Passed on to compute_folded_bias() or
+///                  compute_comparison_bias().
+/// \param[in] offset Passed on to compute_folded_bias() or
+///                   compute_comparison_bias().
+/// \param[in] zero_point MZa for compute_folded_bias(), Za for
+///                       compute_comparison_bias().
+/// \param[out] qc_tilde The computed biases ztensor.
+///
+static void compute_cached_bias(bias_kinds kind, const zdnn_ztensor *input_b,
+                                const zdnn_ztensor *input_c, const float scale,
+                                const float offset, const float zero_point,
+                                zdnn_ztensor *qc_tilde) {
+  bias_cache_entry key;
+  uint32_t max_entries = qmatmul_bias_cache_entries;
+  bool use_cache = max_entries != 0;
+
+  if (use_cache) {
+    init_bias_cache_key(kind, input_b, input_c, scale, offset, zero_point,
+                        &key);
+
+    pthread_mutex_lock(&bias_cache_lock);
+    for (bias_cache_entry **link = &bias_cache; *link;
+         link = &(*link)->next) {
+      bias_cache_entry *entry = *link;
+      if (bias_cache_entry_matches(entry, &key)) {
+        memcpy(qc_tilde->buffer, entry->buffer, entry->buffer_size);
+        // move to the front
+        *link = entry->next;
+        entry->next = bias_cache;
+        bias_cache = entry;
+        pthread_mutex_unlock(&bias_cache_lock);
+
+        qc_tilde->is_transformed = true;
+        return;
+      }
+    }
+    pthread_mutex_unlock(&bias_cache_lock);
+  }
+
+  if (kind == BIAS_FOLDED) {
+    compute_folded_bias(input_b, input_c, scale, offset, zero_point, qc_tilde);
+  } else {
+    compute_comparison_bias(input_b, input_c, scale, offset, zero_point,
+                            qc_tilde);
+  }
+
+  if (!use_cache) {
+    return;
+  }
+
+  // not cached when there's no memory for it, the bias is computed either way
+  bias_cache_entry *entry = malloc(sizeof(bias_cache_entry));
+  if (!entry) {
+    return;
+  }
+  *entry = key;
+  entry->buffer_size = qc_tilde->buffer_size;
+  if (!(entry->buffer = malloc_aligned_4k(entry->buffer_size))) {
+    free(entry);
+    return;
+  }
+  memcpy(entry->buffer, qc_tilde->buffer, entry->buffer_size);
+
+  pthread_mutex_lock(&bias_cache_lock);
+  // another thread may have added the same bias meanwhile
+  for (bias_cache_entry **link = &bias_cache; *link;
+       link = &(*link)->next) {
+    if (bias_cache_entry_matches(*link, &key)) {
+      remove_bias_cache_entry(link);
+      break;
+    }
+  }
+  // make room by dropping the least recently used entry
+  while (bias_cache_count >= max_entries) {
+    bias_cache_entry **link = &bias_cache;
+    while ((*link)->next) {
+      link = &(*link)->next;
+    }
+    remove_bias_cache_entry(link);
+  }
+  entry->next = bias_cache;
+  bias_cache = entry;
+  bias_cache_count++;
+  pthread_mutex_unlock(&bias_cache_lock);
+}
+
 /// Performs the actual quantized matmul (HW) processing.
 ///
 /// \param[in] function_code The matmul operation to be run.
@@ -1188,7 +1467,9 @@ quantized_matmul(const uint8_t function_code, const zdnn_ztensor *input_a,
 
   vec_float32 sz_vec = (vec_float32)vec_load_len(sz, 11);
   vec_float32 zero_vec = (vec_float32){0, 0, 0, 0};
-  vec_int16 converted_sz = aiu_vec_round_from_fp32(sz_vec, zero_vec);
+  // parameter block fields take the DLFLOAT16 values in host byte order
+  vec_int16 converted_sz =
+      VEC_STICK_CELLS16(aiu_vec_round_from_fp32(sz_vec, zero_vec));
 
   function_specific_parameters fsp;
   memset(&fsp, 0, sizeof(function_specific_parameters));
@@ -1241,7 +1522,9 @@ static zdnn_status quantized_matmul_on_the_fly(
 
   vec_float32 sz_vec = (vec_float32)vec_load_len(sz, 15);
   vec_float32 zero_vec = (vec_float32){0, 0, 0, 0};
-  vec_int16 converted_sz = aiu_vec_round_from_fp32(sz_vec, zero_vec);
+  // parameter block fields take the DLFLOAT16 values in host byte order
+  vec_int16 converted_sz =
+      VEC_STICK_CELLS16(aiu_vec_round_from_fp32(sz_vec, zero_vec));
 
   function_specific_parameters fsp;
   memset(&fsp, 0, sizeof(function_specific_parameters));
@@ -1325,601 +1608,568 @@ static void clip_and_round_lo(vec_fp32 *vec_lo, vec_fp32 *vec_clip_min,
   *vec_lo = vec_min(vec_max(vec_round(*vec_lo), *vec_clip_min), *vec_clip_max);
 }
 
-/// Clips the output between clip_min and clip_max.
+// rows (or sticks) handled per parallel chunk of the host-side passes over
+// quantized matmul tensors are sized to cover about this many elements
+#define QMATMUL_ELEMENTS_PER_CHUNK 65536
+
+// State shared by the workers of the host-side post-processing of quantized
+// matmul.  The correction terms are computed first, into term_a and term_b,
+// then every output row is corrected, clipped, rounded and dequantized in a
+// single pass.  Each chunk writes to its own part of term_a, term_b or the
+// output's stick area.
+typedef struct qmatmul_post_job {
+  const zdnn_ztensor *input_a;
+  const zdnn_ztensor *input_b;
+  zdnn_ztensor *output;
+  float term_a_scale;     // M * Zb, times Sa when input_a is unquantized
+  float MZa;              // M * Za
+  float *term_a;          // per input_a (e4x, e2x), NULL when not correcting
+  float *term_b;          // per input_b (e4x, e1x), term_b_stride per e4x
+  uint64_t term_b_stride; // input_b dim1 rounded up to whole sticks
+  const float *channel_zb;    // per output e1x, term_a multiplier or NULL
+  const float *channel_ratio; // per output e1x, final multiplier or NULL
+  float clip_min;
+  float clip_max;
+  void (*clip_round_hi_func)(vec_fp32 *, vec_fp32 *, vec_fp32 *);
+  void (*clip_round_lo_func)(vec_fp32 *, vec_fp32 *, vec_fp32 *);
+  void (*deq_func)(vec_fp32 *, vec_fp32 *, vec_fp32, vec_fp32);
+} qmatmul_post_job;
+
+/// Number of rows (or sticks) for each parallel chunk
+///
+/// \param[in] row_elements Number of elements in a row
+///
+/// \return rows per chunk, at least 1
+///
+static inline uint64_t qmatmul_rows_per_chunk(uint64_t row_elements) {
+  return MAX(1, QMATMUL_ELEMENTS_PER_CHUNK / MAX(row_elements, 1));
+}
+
+/// Set up the clipping and dequantization part of a qmatmul_post_job, with no
+/// correction terms
 ///
 /// \param[in] clip_min The minimum quantized value for input_a or NULL.
 /// \param[in] clip_max The maximim quantized value for input_a or NULL.
-/// \param[out] output The returned ztensor from the zAIU.
-/// \param[out] dequantize Whether to dequantize returned ztensor.
-/// \param[out] disable_clipping Whether to disable clipping and rounding.
+/// \param[in] output The returned ztensor from the zAIU.
+/// \param[in] dequantize Whether to dequantize returned ztensor.
+/// \param[in] disable_clipping Whether to disable clipping and rounding.
+/// \param[out] job The job
 ///
-static void apply_clipping(const int8_t clip_min, const int8_t clip_max,
-                           zdnn_ztensor *output, const bool dequantize,
-                           const bool disable_clipping) {
+static void init_qmatmul_post_job(const int8_t clip_min, const int8_t clip_max,
+                                  zdnn_ztensor *output, const bool dequantize,
+                                  const bool disable_clipping,
+                                  qmatmul_post_job *job) {
+  memset(job, 0, sizeof(qmatmul_post_job));
+  job->output = output;
+  job->clip_min = (float)clip_min;
+  job->clip_max = (float)clip_max;
+  job->clip_round_hi_func =
+      disable_clipping ? &skip_clip_and_round : &clip_and_round_hi;
+  job->clip_round_lo_func =
+      disable_clipping ? &skip_clip_and_round : &clip_and_round_lo;
+  job->deq_func = dequantize ? &apply_dequantization : &skip_dequantization;
+}
 
-  // return immediately if dequantize=false or disable_clipping=true
-  // so we don't perform an unstickify and then immediately a stickify
-  // which is unneeded when dequantize=false and disable_clipping=true
-  if (!dequantize && disable_clipping) {
-    return;
+/// Subtracts the correction terms (if any) from 4 output elements, then scales
+/// them by their channels' ratio to the weights' reference scale (if any).
+///
+/// \param[in] job The job
+/// \param[in,out] vec The output elements
+/// \param[in] term_a_vec term_a of the output row, splatted
+/// \param[in] term_b term_b of the output's dim4 index or NULL
+/// \param[in] col Output dim1 index of the first element
+///
+static inline void correct_output_vec(const qmatmul_post_job *job,
+                                      vec_fp32 *vec, vec_fp32 term_a_vec,
+                                      const float *term_b, uint32_t col) {
+  if (term_b) {
+    if (job->channel_zb) {
+      term_a_vec *= *(vec_fp32 *)&job->channel_zb[col];
+    }
+    *vec -= (*(vec_fp32 *)&term_b[col] + term_a_vec);
+  }
+  if (job->channel_ratio) {
+    *vec *= *(vec_fp32 *)&job->channel_ratio[col];
   }
-  uint64_t out_offset = 0; // moving position as output is processed, in BYTES
+}
+
+/// Correct (if there are correction terms), clip and round, and dequantize
+/// output rows [begin, end).  Row r is (e4x, e2x) = (r / dim2, r % dim2).
+///
+/// \param[in] ctx Pointer to the qmatmul_post_job
+/// \param[in] begin first row
+/// \param[in] end one past the last row
+///
+/// \return None
+///
+static void finish_output_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  qmatmul_post_job *job = (qmatmul_post_job *)ctx;
+  const zdnn_tensor_desc *out_desc = job->output->transformed_desc;
 
   uint32_t fields_to_convert;    // number of fields to actually convert
   uint32_t nbr_fields_converted; // number of fields converted
 
   const uint64_t out_bytes_all_w =
-      CEIL(output->transformed_desc->dim2, AIU_STICKS_PER_PAGE) *
-      AIU_PAGESIZE_IN_BYTES;
+      CEIL(out_desc->dim2, AIU_STICKS_PER_PAGE) * AIU_PAGESIZE_IN_BYTES;
 
   const uint64_t out_bytes_per_n =
-      CEIL(output->transformed_desc->dim1, AIU_2BYTE_CELLS_PER_STICK) *
-      out_bytes_all_w;
-
-  vec_fp32 vec_clip_min = vec_splats((float)clip_min);
-  vec_fp32 vec_clip_max = vec_splats((float)clip_max);
-  vec_fp32 vec_scale = vec_splats((1.f / output->rec_scale));
-  vec_fp32 vec_offset = vec_splats(output->offset);
-
-  void (*clip_round_hi_func)(vec_fp32 *, vec_fp32 *, vec_fp32 *) =
-      disable_clipping ? &skip_clip_and_round : &clip_and_round_hi;
-  void (*clip_round_lo_func)(vec_fp32 *, vec_fp32 *, vec_fp32 *) =
-      disable_clipping ? &skip_clip_and_round : &clip_and_round_lo;
-  void (*deq_func)(vec_fp32 *, vec_fp32 *, vec_fp32, vec_fp32) =
-      dequantize ? &apply_dequantization : &skip_dequantization;
-
-  for (uint32_t e4x = 0; e4x < output->transformed_desc->dim4; e4x++) {
-
-    // Used for pushing out_offset from n to n+1 (i.e., + out_bytes_per_n)
-    const uint64_t out_offset_n = out_offset;
-
-    for (uint32_t e2x = 0; e2x < output->transformed_desc->dim2; e2x++) {
-
-      const uint64_t out_w_offset = out_offset;
-
-      for (uint32_t e1x = 0; e1x < output->transformed_desc->dim1;
-           e1x += AIU_2BYTE_CELLS_PER_STICK) {
-
-        vec_int16 *output_vec =
-            (vec_int16 *)((void *)((uintptr_t)output->buffer + out_offset));
+      CEIL(out_desc->dim1, AIU_2BYTE_CELLS_PER_STICK) * out_bytes_all_w;
+
+  vec_fp32 vec_clip_min = vec_splats(job->clip_min);
+  vec_fp32 vec_clip_max = vec_splats(job->clip_max);
+  vec_fp32 vec_scale = vec_splats((1.f / job->output->rec_scale));
+  vec_fp32 vec_offset = vec_splats(job->output->offset);
+
+  for (uint64_t r = begin; r < end; r++) {
+    const uint32_t e4x = (uint32_t)(r / out_desc->dim2);
+    const uint32_t e2x = (uint32_t)(r % out_desc->dim2);
+
+    uint64_t out_offset =
+        e4x * out_bytes_per_n + (uint64_t)e2x * AIU_BYTES_PER_STICK;
+
+    // output[e2x][e1x] -= term_a[e2x] + term_b[e1x], where term_a and term_b
+    // of broadcast inputs are only computed for the first dim4 index
+    vec_fp32 term_a_vec = vec_splats(0.f);
+    const float *term_b = NULL;
+    if (job->term_b) {
+      const zdnn_tensor_desc *a_desc = job->input_a->transformed_desc;
+      const zdnn_tensor_desc *b_desc = job->input_b->transformed_desc;
+      const uint32_t a_e4x = a_desc->dim4 == 1 ? 0 : e4x;
+      const uint32_t b_e4x = b_desc->dim4 == 1 ? 0 : e4x;
+
+      if (job->term_a) {
+        term_a_vec =
+            vec_splats(job->term_a[(uint64_t)a_e4x * a_desc->dim2 + e2x]);
+      }
+      term_b = job->term_b + b_e4x * job->term_b_stride;
+    }
 
-        fields_to_convert = MIN(output->transformed_desc->dim1 - e1x,
-                                AIU_2BYTE_CELLS_PER_STICK);
-        nbr_fields_converted = 0;
+    for (uint32_t e1x = 0; e1x < out_desc->dim1;
+         e1x += AIU_2BYTE_CELLS_PER_STICK) {
 
-        while (nbr_fields_converted < fields_to_convert) {
-          vec_fp32 temp_vec_hi, temp_vec_lo;
-          VEC_LENGTHEN_TO_FP32(*output_vec, temp_vec_hi, temp_vec_lo);
-          (*clip_round_hi_func)(&temp_vec_hi, &vec_clip_min, &vec_clip_max);
-          (*clip_round_lo_func)(&temp_vec_lo, &vec_clip_min, &vec_clip_max);
-          (*deq_func)(&temp_vec_hi, &temp_vec_lo, vec_scale, vec_offset);
+      vec_int16 *output_vec =
+          (vec_int16 *)((void *)((uintptr_t)job->output->buffer + out_offset));
 
-          *output_vec++ = VEC_ROUND_FROM_FP32(temp_vec_hi, temp_vec_lo);
-          nbr_fields_converted += 8;
-        }
+      fields_to_convert =
+          MIN(out_desc->dim1 - e1x, AIU_2BYTE_CELLS_PER_STICK);
+      nbr_fields_converted = 0;
 
-        out_offset += out_bytes_all_w;
+      while (nbr_fields_converted < fields_to_convert) {
+        const uint32_t col = e1x + nbr_fields_converted;
+        vec_fp32 temp_vec_hi, temp_vec_lo;
+        VEC_LENGTHEN_TO_FP32(*output_vec, temp_vec_hi, temp_vec_lo);
+        correct_output_vec(job, &temp_vec_hi, term_a_vec, term_b, col);
+        (*job->clip_round_hi_func)(&temp_vec_hi, &vec_clip_min, &vec_clip_max);
+        correct_output_vec(job, &temp_vec_lo, term_a_vec, term_b, col + 4);
+        (*job->clip_round_lo_func)(&temp_vec_lo, &vec_clip_min, &vec_clip_max);
+        (*job->deq_func)(&temp_vec_hi, &temp_vec_lo, vec_scale, vec_offset);
+        *output_vec++ = VEC_ROUND_FROM_FP32(temp_vec_hi, temp_vec_lo);
+        nbr_fields_converted += 8;
       }
 
-      out_offset = out_w_offset + AIU_BYTES_PER_STICK;
+      out_offset += out_bytes_all_w;
     }
-
-    // reset out_offset to the next n
-    out_offset = out_offset_n + out_bytes_per_n;
   }
 }
 
-/// Computes the appropriate correction term and adjusts the matmul output. Then
-/// clips the output between clip_min and clip_max.
+/// Clips the output between clip_min and clip_max.
 ///
-/// \param[in] input_a The input ztensor, quantized values.
-/// \param[in] input_b The weights ztensor, quantized values.
-/// \param[in] M The result of Sy / (Sa * Sb).
 /// \param[in] clip_min The minimum quantized value for input_a or NULL.
 /// \param[in] clip_max The maximim quantized value for input_a or NULL.
 /// \param[out] output The returned ztensor from the zAIU.
 /// \param[out] dequantize Whether to dequantize returned ztensor.
 /// \param[out] disable_clipping Whether to disable clipping and rounding.
 ///
-static void apply_correction_term(const zdnn_ztensor *input_a,
-                                  const zdnn_ztensor *input_b, const float M,
-                                  const int8_t clip_min, const int8_t clip_max,
-                                  zdnn_ztensor *output, const bool dequantize,
-                                  const bool disable_clipping) {
-  uint64_t in_a_offset = 0; // moving position as input_a is processed, in BYTES
-  uint64_t in_b_offset = 0; // moving position as input_b is processed, in BYTES
-  uint64_t out_offset = 0;  // moving position as output is processed, in BYTES
+static void apply_clipping(const int8_t clip_min, const int8_t clip_max,
+                           zdnn_ztensor *output, const bool dequantize,
+                           const bool disable_clipping) {
+
+  // return immediately if dequantize=false or disable_clipping=true
+  // so we don't perform an unstickify and then immediately a stickify
+  // which is unneeded when dequantize=false and disable_clipping=true
+  if (!dequantize && disable_clipping) {
+    return;
+  }
+
+  qmatmul_post_job job;
+  init_qmatmul_post_job(clip_min, clip_max, output, dequantize,
+                        disable_clipping, &job);
+
+  const zdnn_tensor_desc *out_desc = output->transformed_desc;
+  run_parallel((uint64_t)out_desc->dim4 * out_desc->dim2,
+               qmatmul_rows_per_chunk(out_desc->dim1), finish_output_chunk,
+               &job);
+}
+
+/// Computes term_a = M * Zb * sum(input_a[e2x][:]) for input_a rows
+/// [begin, end), input_a quantized.  Row r is (e4x, e2x) = (r / dim2,
+/// r % dim2).
+///
+/// \param[in] ctx Pointer to the qmatmul_post_job
+/// \param[in] begin first row
+/// \param[in] end one past the last row
+///
+/// \return None
+///
+static void term_a_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  qmatmul_post_job *job = (qmatmul_post_job *)ctx;
+  const zdnn_tensor_desc *a_desc = job->input_a->transformed_desc;
 
   uint32_t remaining_fields;     // number of fields remaining
   uint32_t fields_to_convert;    // number of fields to actually convert
   uint32_t nbr_fields_converted; // number of fields converted
 
-  // loop invariant values
   const uint64_t in_a_bytes_all_w =
-      CEIL(input_a->transformed_desc->dim2, AIU_STICKS_PER_PAGE) *
-      AIU_PAGESIZE_IN_BYTES;
+      CEIL(a_desc->dim2, AIU_STICKS_PER_PAGE) * AIU_PAGESIZE_IN_BYTES;
 
   const uint64_t in_a_bytes_per_n =
-      CEIL(input_a->transformed_desc->dim1, AIU_1BYTE_CELLS_PER_STICK) *
-      in_a_bytes_all_w;
+      CEIL(a_desc->dim1, AIU_1BYTE_CELLS_PER_STICK) * in_a_bytes_all_w;
 
-  const uint64_t in_b_bytes_all_w =
-      CEIL(input_b->transformed_desc->dim2, AIU_2BYTE_CELLS_PER_STICK) *
-      AIU_PAGESIZE_IN_BYTES;
+  for (uint64_t r = begin; r < end; r++) {
+    const uint32_t e4x = (uint32_t)(r / a_desc->dim2);
+    const uint32_t e2x = (uint32_t)(r % a_desc->dim2);
 
-  const uint64_t in_b_bytes_per_n =
-      CEIL(input_b->transformed_desc->dim1, AIU_2BYTE_CELLS_PER_STICK) *
-      in_b_bytes_all_w;
-
-  const uint64_t out_bytes_all_w =
-      CEIL(output->transformed_desc->dim2, AIU_STICKS_PER_PAGE) *
-      AIU_PAGESIZE_IN_BYTES;
-
-  const uint64_t out_bytes_per_n =
-      CEIL(output->transformed_desc->dim1, AIU_2BYTE_CELLS_PER_STICK) *
-      out_bytes_all_w;
-
-  const float MZb = M * input_b->offset;
-  vec_fp32 vec_MZa = vec_splats(M * input_a->offset);
-
-  float term_a[input_a->transformed_desc->dim2];
-  float term_b[input_b->transformed_desc->dim1 + 7];
-
-  vec_fp32 vec_clip_min = vec_splats((float)clip_min);
-  vec_fp32 vec_clip_max = vec_splats((float)clip_max);
-  vec_fp32 vec_scale = vec_splats((1.f / output->rec_scale));
-  vec_fp32 vec_offset = vec_splats(output->offset);
+    uint64_t in_a_offset =
+        e4x * in_a_bytes_per_n + (uint64_t)e2x * AIU_BYTES_PER_STICK;
 
-  void (*clip_round_hi_func)(vec_fp32 *, vec_fp32 *, vec_fp32 *) =
-      disable_clipping ? &skip_clip_and_round : &clip_and_round_hi;
-  void (*clip_round_lo_func)(vec_fp32 *, vec_fp32 *, vec_fp32 *) =
-      disable_clipping ? &skip_clip_and_round : &clip_and_round_lo;
-  void (*deq_func)(vec_fp32 *, vec_fp32 *, vec_fp32, vec_fp32) =
-      dequantize ? &apply_dequantization : &skip_dequantization;
-
-  // Output dim4, which is equal to MAX(input_a dim4, input_b dim4)
-  for (uint32_t e4x = 0; e4x < output->transformed_desc->dim4; e4x++) {
-
-    // Computation of term_a from input_a and MZb. Only compute on first dim4
-    // index if input_a needs to be broadcast
-    if (e4x < input_a->transformed_desc->dim4) {
-      // Used for pushing in_a_offset from n to n+1 (i.e., + in_c_bytes_per_n)
-      const uint64_t in_a_offset_n = in_a_offset;
-
-      for (uint32_t e2x = 0; e2x < input_a->transformed_desc->dim2; e2x++) {
-        const uint64_t in_a_w_offset = in_a_offset;
-
-        // Zero out summ_vec, which will hold the summation for C dim.
-        vec_int summ_vec = vec_splats(0);
-
-        for (uint32_t e1x = 0; e1x < input_a->transformed_desc->dim1;
-             e1x += AIU_1BYTE_CELLS_PER_STICK) {
-          vec_char *in_a_vec =
-              (vec_char *)((void *)((uintptr_t)input_a->buffer + in_a_offset));
-
-          remaining_fields = MIN(input_a->transformed_desc->dim1 - e1x,
-                                 AIU_1BYTE_CELLS_PER_STICK);
-          fields_to_convert = remaining_fields - (remaining_fields % 16);
-          nbr_fields_converted = 0;
-
-          while (nbr_fields_converted < fields_to_convert) {
-            // Load high end of in_b_vec (first 8 elements) into temp_int16
-            vec_short temp_int16 = vec_unpackh(*in_a_vec);
-            // Perform sum operation on every 4 int8 elements into summ_vec
-            summ_vec += (vec_int){
-                temp_int16[0] + temp_int16[1], temp_int16[2] + temp_int16[3],
-                temp_int16[4] + temp_int16[5], temp_int16[6] + temp_int16[7]};
-            temp_int16 = vec_unpackl(*in_a_vec);
-            // Perform sum operation on every 4 int8 elements into summ_vec
-            summ_vec += (vec_int){
-                temp_int16[0] + temp_int16[1], temp_int16[2] + temp_int16[3],
-                temp_int16[4] + temp_int16[5], temp_int16[6] + temp_int16[7]};
-            in_a_vec++;
-            nbr_fields_converted += 16;
-          }
+    // Zero out summ_vec, which will hold the summation for C dim.
+    vec_int summ_vec = vec_splats(0);
 
-          if (nbr_fields_converted < remaining_fields) {
-            // Load remaining fields into temp_vec
-            vec_char temp_vec =
-                vec_load_len((signed char *)in_a_vec,
-                             (remaining_fields - nbr_fields_converted) - 1);
-            // Load high end of in_b_vec (first 8 elements) into temp_int16
-            vec_short temp_int16 = vec_unpackh(temp_vec);
-            // Perform sum operation on every 4 int8 elements into summ_vec
-            summ_vec += (vec_int){
-                temp_int16[0] + temp_int16[1], temp_int16[2] + temp_int16[3],
-                temp_int16[4] + temp_int16[5], temp_int16[6] + temp_int16[7]};
-            temp_int16 = vec_unpackl(temp_vec);
-            // Perform sum operation on every 4 int8 elements into summ_vec
-            summ_vec += (vec_int){
-                temp_int16[0] + temp_int16[1], temp_int16[2] + temp_int16[3],
-                temp_int16[4] + temp_int16[5], temp_int16[6] + temp_int16[7]};
-          }
-
-          in_a_offset += in_a_bytes_all_w;
-        }
-
-        term_a[e2x] =
-            (float)(summ_vec[0] + summ_vec[1] + summ_vec[2] + summ_vec[3]) *
-            MZb;
-
-        in_a_offset = in_a_w_offset + AIU_BYTES_PER_STICK;
-      }
-
-      // reset in_a_offset to the next n
-      in_a_offset = in_a_offset_n + in_a_bytes_per_n;
-    }
-
-    // Computation of term_b from input_b and MZa. Only compute on first dim4
-    // index if input_b needs to be broadcast
-    if (e4x < input_b->transformed_desc->dim4) {
-      // Used for pushing in_b_offset from n to n+1 (i.e., + in_b_bytes_per_n)
-      const uint64_t in_b_offset_n = in_b_offset;
-
-      vec_fp32 *term_b_vec = (vec_fp32 *)term_b;
-
-      for (uint32_t e1x = 0; e1x < input_b->transformed_desc->dim1;
-           e1x += AIU_2BYTE_CELLS_PER_STICK) {
-        const uint64_t in_b_w_offset = in_b_offset;
-
-        fields_to_convert = MIN(input_b->transformed_desc->dim1 - e1x,
-                                AIU_2BYTE_CELLS_PER_STICK);
-        nbr_fields_converted = 0;
-
-        while (nbr_fields_converted < fields_to_convert) {
-          // Zero out summ_vec, which will hold the summation for W dim.
-          vec_int summ_vec_hi = vec_splats(0);
-          vec_int summ_vec_lo = vec_splats(0);
-
-          vec_char *in_b_vec =
-              (vec_char *)((void *)((uintptr_t)input_b->buffer + in_b_offset));
-
-          for (uint32_t e2x = 0; e2x < input_b->transformed_desc->dim2 / 2;
-               e2x++) {
-            // Load high end of in_b_vec (first 8 elements) into temp_int16
-            vec_short temp_int16 = vec_unpackh(*in_b_vec);
-            // Perform sum operation on every 2 int16 elements into summ_vec_hi
-            summ_vec_hi += (vec_int){
-                temp_int16[0] + temp_int16[1], temp_int16[2] + temp_int16[3],
-                temp_int16[4] + temp_int16[5], temp_int16[6] + temp_int16[7]};
-            // Load low end of in_b_vec (final 8 elements) into temp_int16
-            temp_int16 = vec_unpackl(*in_b_vec);
-            // Perform sum operation on every 2 int16 elements into summ_vec_lo
-            summ_vec_lo += (vec_int){
-                temp_int16[0] + temp_int16[1], temp_int16[2] + temp_int16[3],
-                temp_int16[4] + temp_int16[5], temp_int16[6] + temp_int16[7]};
-
-            in_b_vec += 8;
-          }
-
-          if (input_b->transformed_desc->dim2 % 2) {
-            // Load high end of in_b_vec (first 8 elements) into temp_int16
-            vec_short temp_int16 = vec_unpackh(*in_b_vec);
-            // Perform sum operation on every other int16 element into
-            // summ_vec_hi
-            summ_vec_hi += (vec_int){temp_int16[0], temp_int16[2],
-                                     temp_int16[4], temp_int16[6]};
-            // Load low end of in_b_vec (final 8 elements) into temp_int16
-            temp_int16 = vec_unpackl(*in_b_vec);
-            // Perform sum operation on every other int16 element into
-            // summ_vec_lo
-            summ_vec_lo += (vec_int){temp_int16[0], temp_int16[2],
-                                     temp_int16[4], temp_int16[6]};
-          }
-
-          *term_b_vec++ = vec_float(summ_vec_hi) * vec_MZa;
-          *term_b_vec++ = vec_float(summ_vec_lo) * vec_MZa;
-
-          in_b_offset += 16;
+    for (uint32_t e1x = 0; e1x < a_desc->dim1;
+         e1x += AIU_1BYTE_CELLS_PER_STICK) {
+      vec_char *in_a_vec = (vec_char *)((
+          void *)((uintptr_t)job->input_a->buffer + in_a_offset));
 
-          nbr_fields_converted += 8;
-        }
+      remaining_fields = MIN(a_desc->dim1 - e1x, AIU_1BYTE_CELLS_PER_STICK);
+      fields_to_convert = remaining_fields - (remaining_fields % 16);
+      nbr_fields_converted = 0;
 
-        in_b_offset = in_b_w_offset + in_b_bytes_all_w;
+      while (nbr_fields_converted < fields_to_convert) {
+        // Load high end of in_b_vec (first 8 elements) into temp_int16
+        vec_short temp_int16 = vec_unpackh(*in_a_vec);
+        // Perform sum operation on every 4 int8 elements into summ_vec
+        summ_vec += (vec_int){
+            temp_int16[0] + temp_int16[1], temp_int16[2] + temp_int16[3],
+            temp_int16[4] + temp_int16[5], temp_int16[6] + temp_int16[7]};
+        temp_int16 = vec_unpackl(*in_a_vec);
+        // Perform sum operation on every 4 int8 elements into summ_vec
+        summ_vec += (vec_int){
+            temp_int16[0] + temp_int16[1], temp_int16[2] + temp_int16[3],
+            temp_int16[4] + temp_int16[5], temp_int16[6] + temp_int16[7]};
+        in_a_vec++;
+        nbr_fields_converted += 16;
       }
 
-      // reset in_b_offset to the next n
-      in_b_offset = in_b_offset_n + in_b_bytes_per_n;
-    }
-
-    // Used for pushing out_offset from n to n+1 (i.e., + out_bytes_per_n)
-    const uint64_t out_offset_n = out_offset;
-
-    // Computation of output[e2x][e1x] = term_a[e2x] + term_b[e1x]
-    for (uint32_t e2x = 0; e2x < output->transformed_desc->dim2; e2x++) {
-      const uint64_t out_w_offset = out_offset;
-
-      vec_fp32 term_a_vec = vec_splats(term_a[e2x]);
-
-      vec_fp32 *term_b_vec = (vec_fp32 *)term_b;
-
-      for (uint32_t e1x = 0; e1x < output->transformed_desc->dim1;
-           e1x += AIU_2BYTE_CELLS_PER_STICK) {
-
-        vec_int16 *output_vec =
-            (vec_int16 *)((void *)((uintptr_t)output->buffer + out_offset));
-
-        fields_to_convert = MIN(output->transformed_desc->dim1 - e1x,
-                                AIU_2BYTE_CELLS_PER_STICK);
-        nbr_fields_converted = 0;
-
-        while (nbr_fields_converted < fields_to_convert) {
-          vec_fp32 temp_vec_hi, temp_vec_lo;
-          VEC_LENGTHEN_TO_FP32(*output_vec, temp_vec_hi, temp_vec_lo);
-          temp_vec_hi -= (*term_b_vec + term_a_vec);
-          (*clip_round_hi_func)(&temp_vec_hi, &vec_clip_min, &vec_clip_max);
-          term_b_vec++;
-          temp_vec_lo -= (*term_b_vec + term_a_vec);
-          (*clip_round_lo_func)(&temp_vec_lo, &vec_clip_min, &vec_clip_max);
-          term_b_vec++;
-          (*deq_func)(&temp_vec_hi, &temp_vec_lo, vec_scale, vec_offset);
-          *output_vec++ = VEC_ROUND_FROM_FP32(temp_vec_hi, temp_vec_lo);
-          nbr_fields_converted += 8;
-        }
-
-        out_offset += out_bytes_all_w;
+      if (nbr_fields_converted < remaining_fields) {
+        // Load remaining fields into temp_vec
+        vec_char temp_vec =
+            vec_load_len((signed char *)in_a_vec,
+                         (remaining_fields - nbr_fields_converted) - 1);
+        // Load high end of in_b_vec (first 8 elements) into temp_int16
+        vec_short temp_int16 = vec_unpackh(temp_vec);
+        // Perform sum operation on every 4 int8 elements into summ_vec
+        summ_vec += (vec_int){
+            temp_int16[0] + temp_int16[1], temp_int16[2] + temp_int16[3],
+            temp_int16[4] + temp_int16[5], temp_int16[6] + temp_int16[7]};
+        temp_int16 = vec_unpackl(temp_vec);
+        // Perform sum operation on every 4 int8 elements into summ_vec
+        summ_vec += (vec_int){
+            temp_int16[0] + temp_int16[1], temp_int16[2] + temp_int16[3],
+            temp_int16[4] + temp_int16[5], temp_int16[6] + temp_int16[7]};
       }
 
-      out_offset = out_w_offset + AIU_BYTES_PER_STICK;
+      in_a_offset += in_a_bytes_all_w;
     }
 
-    // reset out_offset to the next n
-    out_offset = out_offset_n + out_bytes_per_n;
+    job->term_a[r] =
+        (float)(summ_vec[0] + summ_vec[1] + summ_vec[2] + summ_vec[3]) *
+        job->term_a_scale;
   }
 }
 
-/// Computes the appropriate correction term and adjusts the matmul output. Then
-/// clips the output between clip_min and clip_max.
+/// Computes term_a = M * Zb * Sa * sum(input_a[e2x][:]) for input_a rows
+/// [begin, end), input_a unquantized.  Row r is (e4x, e2x) = (r / dim2,
+/// r % dim2).
 ///
-/// \param[in] input_a The input ztensor, unquantized values.
-/// \param[in] input_b The weights ztensor, quantized values.
-/// \param[in] M The result of Sy / (Sa * Sb).
-/// \param[in] clip_min The minimum quantized value for input_a or NULL.
-/// \param[in] clip_max The maximim quantized value for input_a or NULL.
-/// \param[out] output The returned ztensor from the zAIU.
-/// \param[out] dequantize Whether to dequantize returned ztensor.
-/// \param[out] disable_clipping Whether to disable clipping and rounding.
+/// \param[in] ctx Pointer to the qmatmul_post_job
+/// \param[in] begin first row
+/// \param[in] end one past the last row
 ///
-static void apply_correction_term_on_the_fly(
-    const zdnn_ztensor *input_a, const zdnn_ztensor *input_b, const float M,
-    const int8_t clip_min, const int8_t clip_max, zdnn_ztensor *output,
-    const bool dequantize, const bool disable_clipping) {
-  uint64_t in_a_offset = 0; // moving position as input_a is processed, in BYTES
-  uint64_t in_b_offset = 0; // moving position as input_b is processed, in BYTES
-  uint64_t out_offset = 0;  // moving position as output is processed, in BYTES
+/// \return None
+///
+static void term_a_on_the_fly_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  qmatmul_post_job *job = (qmatmul_post_job *)ctx;
+  const zdnn_tensor_desc *a_desc = job->input_a->transformed_desc;
 
   uint32_t remaining_fields;     // number of fields remaining
   uint32_t fields_to_convert;    // number of fields to actually convert
   uint32_t nbr_fields_converted; // number of fields converted
 
-  // loop invariant values
   const uint64_t in_a_bytes_all_w =
-      CEIL(input_a->transformed_desc->dim2, AIU_STICKS_PER_PAGE) *
-      AIU_PAGESIZE_IN_BYTES;
+      CEIL(a_desc->dim2, AIU_STICKS_PER_PAGE) * AIU_PAGESIZE_IN_BYTES;
 
   const uint64_t in_a_bytes_per_n =
-      CEIL(input_a->transformed_desc->dim1, AIU_2BYTE_CELLS_PER_STICK) *
-      in_a_bytes_all_w;
+      CEIL(a_desc->dim1, AIU_2BYTE_CELLS_PER_STICK) * in_a_bytes_all_w;
 
-  const uint64_t in_b_bytes_all_w =
-      CEIL(input_b->transformed_desc->dim2, AIU_2BYTE_CELLS_PER_STICK) *
-      AIU_PAGESIZE_IN_BYTES;
+  for (uint64_t r = begin; r < end; r++) {
+    const uint32_t e4x = (uint32_t)(r / a_desc->dim2);
+    const uint32_t e2x = (uint32_t)(r % a_desc->dim2);
 
-  const uint64_t in_b_bytes_per_n =
-      CEIL(input_b->transformed_desc->dim1, AIU_2BYTE_CELLS_PER_STICK) *
-      in_b_bytes_all_w;
-
-  const uint64_t out_bytes_all_w =
-      CEIL(output->transformed_desc->dim2, AIU_STICKS_PER_PAGE) *
-      AIU_PAGESIZE_IN_BYTES;
+    uint64_t in_a_offset =
+        e4x * in_a_bytes_per_n + (uint64_t)e2x * AIU_BYTES_PER_STICK;
 
-  const uint64_t out_bytes_per_n =
-      CEIL(output->transformed_desc->dim1, AIU_2BYTE_CELLS_PER_STICK) *
-      out_bytes_all_w;
-
-  const float scale = M * input_b->offset * input_a->rec_scale;
-
-  vec_fp32 vec_MZa = vec_splats(M * input_a->offset);
+    // Zero out temp_float, which will hold the summation for C dim.
+    vec_fp32 summ_vec_a_hi = vec_splats(0.f);
+    vec_fp32 summ_vec_a_lo = vec_splats(0.f);
 
-  float term_a[input_a->transformed_desc->dim2];
-  float term_b[input_b->transformed_desc->dim1 + 7];
+    for (uint32_t e1x = 0; e1x < a_desc->dim1;
+         e1x += AIU_2BYTE_CELLS_PER_STICK) {
 
-  vec_fp32 vec_clip_min = vec_splats((float)clip_min);
-  vec_fp32 vec_clip_max = vec_splats((float)clip_max);
-  vec_fp32 vec_scale = vec_splats((1.f / output->rec_scale));
-  vec_fp32 vec_offset = vec_splats(output->offset);
-
-  void (*clip_round_hi_func)(vec_fp32 *, vec_fp32 *, vec_fp32 *) =
-      disable_clipping ? &skip_clip_and_round : &clip_and_round_hi;
-  void (*clip_round_lo_func)(vec_fp32 *, vec_fp32 *, vec_fp32 *) =
-      disable_clipping ? &skip_clip_and_round : &clip_and_round_lo;
-  void (*deq_func)(vec_fp32 *, vec_fp32 *, vec_fp32, vec_fp32) =
-      dequantize ? &apply_dequantization : &skip_dequantization;
+      vec_int16 *in_a_vec = (vec_int16 *)((
+          void *)((uintptr_t)job->input_a->buffer + in_a_offset));
 
-  // Output dim4, which is equal to MAX(input_a dim4, input_b dim4)
-  for (uint32_t e4x = 0; e4x < output->transformed_desc->dim4; e4x++) {
+      remaining_fields = MIN(a_desc->dim1 - e1x, AIU_2BYTE_CELLS_PER_STICK);
+      fields_to_convert = remaining_fields - (remaining_fields % 8);
+      nbr_fields_converted = 0;
 
-    // Computation of term_a from input_a and MZb. Only compute on first dim4
-    // index if input_a needs to be broadcast
-    if (e4x < input_a->transformed_desc->dim4) {
-      // Used for pushing in_a_offset from n to n+1 (i.e., + in_c_bytes_per_n)
-      const uint64_t in_a_offset_n = in_a_offset;
+      while (nbr_fields_converted < fields_to_convert) {
+        vec_fp32 temp_float_hi, temp_float_lo;
+        VEC_LENGTHEN_TO_FP32(*in_a_vec, temp_float_hi, temp_float_lo);
 
-      for (uint32_t e2x = 0; e2x < input_a->transformed_desc->dim2; e2x++) {
-        const uint64_t in_a_w_offset = in_a_offset;
+        summ_vec_a_hi += temp_float_hi;
+        summ_vec_a_lo += temp_float_lo;
 
-        // Zero out temp_float, which will hold the summation for C dim.
-        vec_fp32 summ_vec_a_hi = vec_splats(0.f);
-        vec_fp32 summ_vec_a_lo = vec_splats(0.f);
+        in_a_vec++;
+        nbr_fields_converted += 8;
+      }
 
-        for (uint32_t e1x = 0; e1x < input_a->transformed_desc->dim1;
-             e1x += AIU_2BYTE_CELLS_PER_STICK) {
+      if (nbr_fields_converted < remaining_fields) {
 
-          vec_int16 *in_a_vec =
-              (vec_int16 *)((void *)((uintptr_t)input_a->buffer + in_a_offset));
+        // Load remaining fields_to_convert into temp_vec
+        vec_int16 temp_vec =
+            vec_load_len((uint16_t *)in_a_vec,
+                         (remaining_fields - nbr_fields_converted) * 2 - 1);
 
-          remaining_fields = MIN(input_a->transformed_desc->dim1 - e1x,
-                                 AIU_2BYTE_CELLS_PER_STICK);
-          fields_to_convert = remaining_fields - (remaining_fields % 8);
-          nbr_fields_converted = 0;
+        vec_fp32 temp_float_hi, temp_float_lo;
+        VEC_LENGTHEN_TO_FP32(temp_vec, temp_float_hi, temp_float_lo);
 
-          while (nbr_fields_converted < fields_to_convert) {
-            vec_fp32 temp_float_hi, temp_float_lo;
-            VEC_LENGTHEN_TO_FP32(*in_a_vec, temp_float_hi, temp_float_lo);
+        summ_vec_a_hi += temp_float_hi;
+        summ_vec_a_lo += temp_float_lo;
+      }
 
-            summ_vec_a_hi += temp_float_hi;
-            summ_vec_a_lo += temp_float_lo;
+      in_a_offset += in_a_bytes_all_w;
+    }
 
-            in_a_vec++;
-            nbr_fields_converted += 8;
-          }
+    summ_vec_a_hi += summ_vec_a_lo;
 
-          if (nbr_fields_converted < remaining_fields) {
+    job->term_a[r] = (summ_vec_a_hi[0] + summ_vec_a_hi[1] + summ_vec_a_hi[2] +
+                      summ_vec_a_hi[3]) *
+                     job->term_a_scale;
+  }
+}
 
-            // Load remaining fields_to_convert into temp_vec
-            vec_int16 temp_vec =
-                vec_load_len((uint16_t *)in_a_vec,
-                             (remaining_fields - nbr_fields_converted) * 2 - 1);
+/// Computes term_b = M * Za * sum(input_b[:][e1x]) for input_b sticks
+/// [begin, end).  Stick s is (e4x, e1x / AIU_2BYTE_CELLS_PER_STICK) =
+/// (s / sticks_per_n, s % sticks_per_n).
+///
+/// \param[in] ctx Pointer to the qmatmul_post_job
+/// \param[in] begin first stick
+/// \param[in] end one past the last stick
+///
+/// \return None
+///
+static void term_b_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  qmatmul_post_job *job = (qmatmul_post_job *)ctx;
+  const zdnn_tensor_desc *b_desc = job->input_b->transformed_desc;
 
-            vec_fp32 temp_float_hi, temp_float_lo;
-            VEC_LENGTHEN_TO_FP32(temp_vec, temp_float_hi, temp_float_lo);
+  uint32_t fields_to_convert;    // number of fields to actually convert
+  uint32_t nbr_fields_converted; // number of fields converted
 
-            summ_vec_a_hi += temp_float_hi;
-            summ_vec_a_lo += temp_float_lo;
-          }
+  const uint64_t sticks_per_n =
+      CEIL(b_desc->dim1, AIU_2BYTE_CELLS_PER_STICK);
 
-          in_a_offset += in_a_bytes_all_w;
-        }
+  const uint64_t in_b_bytes_all_w =
+      CEIL(b_desc->dim2, AIU_2BYTE_CELLS_PER_STICK) * AIU_PAGESIZE_IN_BYTES;
 
-        summ_vec_a_hi += summ_vec_a_lo;
+  const uint64_t in_b_bytes_per_n = sticks_per_n * in_b_bytes_all_w;
 
-        term_a[e2x] = (summ_vec_a_hi[0] + summ_vec_a_hi[1] + summ_vec_a_hi[2] +
-                       summ_vec_a_hi[3]) *
-                      scale;
+  vec_fp32 vec_MZa = vec_splats(job->MZa);
 
-        in_a_offset = in_a_w_offset + AIU_BYTES_PER_STICK;
-      }
+  for (uint64_t s = begin; s < end; s++) {
+    const uint64_t e4x = s / sticks_per_n;
+    const uint32_t e1x = (uint32_t)(s % sticks_per_n) *
+                         AIU_2BYTE_CELLS_PER_STICK;
 
-      // reset in_a_offset to the next n
-      in_a_offset = in_a_offset_n + in_a_bytes_per_n;
-    }
+    uint64_t in_b_offset =
+        e4x * in_b_bytes_per_n + (s % sticks_per_n) * in_b_bytes_all_w;
 
-    // Computation of term_b from input_b and MZa. Only compute on first dim4
-    // index if input_b needs to be broadcast
-    if (e4x < input_b->transformed_desc->dim4) {
-      // Used for pushing in_b_offset from n to n+1 (i.e., + in_b_bytes_per_n)
-      const uint64_t in_b_offset_n = in_b_offset;
-
-      vec_fp32 *term_b_vec = (vec_fp32 *)term_b;
-
-      for (uint32_t e1x = 0; e1x < input_b->transformed_desc->dim1;
-           e1x += AIU_2BYTE_CELLS_PER_STICK) {
-        const uint64_t in_b_w_offset = in_b_offset;
-
-        fields_to_convert = MIN(input_b->transformed_desc->dim1 - e1x,
-                                AIU_2BYTE_CELLS_PER_STICK);
-        nbr_fields_converted = 0;
-
-        while (nbr_fields_converted < fields_to_convert) {
-          // Zero out summ_vec, which will hold the summation for W dim.
-          vec_int summ_vec_hi = vec_splats(0);
-          vec_int summ_vec_lo = vec_splats(0);
-
-          vec_char *in_b_vec =
-              (vec_char *)((void *)((uintptr_t)input_b->buffer + in_b_offset));
-
-          for (uint32_t e2x = 0; e2x < input_b->transformed_desc->dim2 / 2;
-               e2x++) {
-            // Load high end of in_b_vec (first 8 elements) into temp_int16
-            vec_short temp_int16 = vec_unpackh(*in_b_vec);
-            // Perform sum operation on every 2 int16 elements into summ_vec_hi
-            summ_vec_hi += (vec_int){
-                temp_int16[0] + temp_int16[1], temp_int16[2] + temp_int16[3],
-                temp_int16[4] + temp_int16[5], temp_int16[6] + temp_int16[7]};
-            // Load low end of in_b_vec (final 8 elements) into temp_int16
-            temp_int16 = vec_unpackl(*in_b_vec);
-            // Perform sum operation on every 2 int16 elements into summ_vec_lo
-            summ_vec_lo += (vec_int){
-                temp_int16[0] + temp_int16[1], temp_int16[2] + temp_int16[3],
-                temp_int16[4] + temp_int16[5], temp_int16[6] + temp_int16[7]};
-
-            in_b_vec += 8;
-          }
+    vec_fp32 *term_b_vec =
+        (vec_fp32 *)(job->term_b + e4x * job->term_b_stride + e1x);
 
-          if (input_b->transformed_desc->dim2 % 2) {
-            // Load high end of in_b_vec (first 8 elements) into temp_int16
-            vec_short temp_int16 = vec_unpackh(*in_b_vec);
-            // Perform sum operation on every other int16 element into
-            // summ_vec_hi
-            summ_vec_hi += (vec_int){temp_int16[0], temp_int16[2],
-                                     temp_int16[4], temp_int16[6]};
-            // Load low end of in_b_vec (final 8 elements) into temp_int16
-            temp_int16 = vec_unpackl(*in_b_vec);
-            // Perform sum operation on every other int16 element into
-            // summ_vec_lo
-            summ_vec_lo += (vec_int){temp_int16[0], temp_int16[2],
-                                     temp_int16[4], temp_int16[6]};
-          }
+    fields_to_convert = MIN(b_desc->dim1 - e1x, AIU_2BYTE_CELLS_PER_STICK);
+    nbr_fields_converted = 0;
 
-          *term_b_vec++ = vec_float(summ_vec_hi) * vec_MZa;
-          *term_b_vec++ = vec_float(summ_vec_lo) * vec_MZa;
+    while (nbr_fields_converted < fields_to_convert) {
+      // Zero out summ_vec, which will hold the summation for W dim.
+      vec_int summ_vec_hi = vec_splats(0);
+      vec_int summ_vec_lo = vec_splats(0);
 
-          in_b_offset += 16;
+      vec_char *in_b_vec = (vec_char *)((
+          void *)((uintptr_t)job->input_b->buffer + in_b_offset));
 
-          nbr_fields_converted += 8;
-        }
+      for (uint32_t e2x = 0; e2x < b_desc->dim2 / 2; e2x++) {
+        // Load high end of in_b_vec (first 8 elements) into temp_int16
+        vec_short temp_int16 = vec_unpackh(*in_b_vec);
+        // Perform sum operation on every 2 int16 elements into summ_vec_hi
+        summ_vec_hi += (vec_int){
+            temp_int16[0] + temp_int16[1], temp_int16[2] + temp_int16[3],
+            temp_int16[4] + temp_int16[5], temp_int16[6] + temp_int16[7]};
+        // Load low end of in_b_vec (final 8 elements) into temp_int16
+        temp_int16 = vec_unpackl(*in_b_vec);
+        // Perform sum operation on every 2 int16 elements into summ_vec_lo
+        summ_vec_lo += (vec_int){
+            temp_int16[0] + temp_int16[1], temp_int16[2] + temp_int16[3],
+            temp_int16[4] + temp_int16[5], temp_int16[6] + temp_int16[7]};
 
-        in_b_offset = in_b_w_offset + in_b_bytes_all_w;
+        in_b_vec += 8;
       }
 
-      // reset in_b_offset to the next n
-      in_b_offset = in_b_offset_n + in_b_bytes_per_n;
-    }
-
-    // Used for pushing out_offset from n to n+1 (i.e., + out_bytes_per_n)
-    const uint64_t out_offset_n = out_offset;
-
-    // Compute output[e2x][e1x] = term_a[e2x] + term_b[e1x]
-    for (uint32_t e2x = 0; e2x < output->transformed_desc->dim2; e2x++) {
-      const uint64_t out_w_offset = out_offset;
-
-      vec_fp32 term_a_vec = vec_splats(term_a[e2x]);
-
-      vec_fp32 *term_b_vec = (vec_fp32 *)term_b;
+      if (b_desc->dim2 % 2) {
+        // Load high end of in_b_vec (first 8 elements) into temp_int16
+        vec_short temp_int16 = vec_unpackh(*in_b_vec);
+        // Perform sum operation on every other int16 element into
+        // summ_vec_hi
+        summ_vec_hi += (vec_int){temp_int16[0], temp_int16[2], temp_int16[4],
+                                 temp_int16[6]};
+        // Load low end of in_b_vec (final 8 elements) into temp_int16
+        temp_int16 = vec_unpackl(*in_b_vec);
+        // Perform sum operation on every other int16 element into
+        // summ_vec_lo
+        summ_vec_lo += (vec_int){temp_int16[0], temp_int16[2], temp_int16[4],
+                                 temp_int16[6]};
+      }
 
-      for (uint32_t e1x = 0; e1x < output->transformed_desc->dim1;
-           e1x += AIU_2BYTE_CELLS_PER_STICK) {
-        vec_int16 *output_vec =
-            (vec_int16 *)((void *)((uintptr_t)output->buffer + out_offset));
+      *term_b_vec++ = vec_float(summ_vec_hi) * vec_MZa;
+      *term_b_vec++ = vec_float(summ_vec_lo) * vec_MZa;
 
-        fields_to_convert = MIN(output->transformed_desc->dim1 - e1x,
-                                AIU_2BYTE_CELLS_PER_STICK);
-        nbr_fields_converted = 0;
+      in_b_offset += 16;
 
-        while (nbr_fields_converted < fields_to_convert) {
+      nbr_fields_converted += 8;
+    }
+  }
+}
 
-          vec_fp32 temp_vec_hi, temp_vec_lo;
-          VEC_LENGTHEN_TO_FP32(*output_vec, temp_vec_hi, temp_vec_lo);
-          temp_vec_hi -= (*term_b_vec + term_a_vec);
-          (*clip_round_hi_func)(&temp_vec_hi, &vec_clip_min, &vec_clip_max);
-          term_b_vec++;
-          temp_vec_lo -= (*term_b_vec + term_a_vec);
-          (*clip_round_lo_func)(&temp_vec_lo, &vec_clip_min, &vec_clip_max);
-          term_b_vec++;
-          (*deq_func)(&temp_vec_hi, &temp_vec_lo, vec_scale, vec_offset);
-          *output_vec++ = VEC_ROUND_FROM_FP32(temp_vec_hi, temp_vec_lo);
-          nbr_fields_converted += 8;
-        }
+/// Computes the correction terms of a qmatmul_post_job, then corrects, clips
+/// and dequantizes the output with them.  Each of the passes is spread across
+/// the thread pool.
+///
+/// \param[in] job The job, set up by init_qmatmul_post_job() and with input_a,
+///                input_b, term_a_scale and MZa filled in
+/// \param[in] term_a_func term_a_chunk() or term_a_on_the_fly_chunk(), or
+///                        NULL when term_a is 0
+///
+/// \return ZDNN_OK or ZDNN_ALLOCATION_FAILURE
+///
+static zdnn_status apply_correction(qmatmul_post_job *job,
+                                    parallel_func term_a_func) {
+  const zdnn_tensor_desc *a_desc = job->input_a->transformed_desc;
+  const zdnn_tensor_desc *b_desc = job->input_b->transformed_desc;
+  const zdnn_tensor_desc *out_desc = job->output->transformed_desc;
+
+  const uint64_t term_a_size =
+      term_a_func ? (uint64_t)a_desc->dim4 * a_desc->dim2 : 0;
+  const uint64_t b_sticks_per_n = CEIL(b_desc->dim1, AIU_2BYTE_CELLS_PER_STICK);
+
+  // term_b is written and read 8 elements at a time, a whole stick covers it
+  job->term_b_stride = b_sticks_per_n * AIU_2BYTE_CELLS_PER_STICK;
+
+  uint64_t terms_size =
+      (term_a_size + b_desc->dim4 * job->term_b_stride) * sizeof(float);
+  float *terms = malloc(terms_size);
+  if (!terms) {
+    return ZDNN_STATUS(ZDNN_ALLOCATION_FAILURE,
+                       "Unable to allocate %" PRIu64
+                       " bytes for correction terms.",
+                       terms_size);
+  }
+  job->term_a = term_a_func ? terms : NULL;
+  job->term_b = terms + term_a_size;
 
-        out_offset += out_bytes_all_w;
-      }
+  if (term_a_func) {
+    run_parallel(term_a_size, qmatmul_rows_per_chunk(a_desc->dim1),
+                 term_a_func, job);
+  }
+  run_parallel(b_desc->dim4 * b_sticks_per_n,
+               qmatmul_rows_per_chunk((uint64_t)b_desc->dim2 *
+                                      AIU_2BYTE_CELLS_PER_STICK),
+               term_b_chunk, job);
+  run_parallel((uint64_t)out_desc->dim4 * out_desc->dim2,
+               qmatmul_rows_per_chunk(out_desc->dim1), finish_output_chunk,
+               job);
+
+  free(terms);
+  return ZDNN_STATUS_OK;
+}
 
-      out_offset = out_w_offset + AIU_BYTES_PER_STICK;
-    }
+/// Computes the appropriate correction term and adjusts the matmul output. Then
+/// clips the output between clip_min and clip_max.
+///
+/// \param[in] input_a The input ztensor, quantized values.
+/// \param[in] input_b The weights ztensor, quantized values.
+/// \param[in] M The result of Sy / (Sa * Sb).
+/// \param[in] clip_min The minimum quantized value for input_a or NULL.
+/// \param[in] clip_max The maximim quantized value for input_a or NULL.
+/// \param[out] output The returned ztensor from the zAIU.
+/// \param[out] dequantize Whether to dequantize returned ztensor.
+/// \param[out] disable_clipping Whether to disable clipping and rounding.
+///
+/// \return ZDNN_OK or ZDNN_ALLOCATION_FAILURE
+///
+static zdnn_status apply_correction_term(const zdnn_ztensor *input_a,
+                                         const zdnn_ztensor *input_b,
+                                         const float M, const int8_t clip_min,
+                                         const int8_t clip_max,
+                                         zdnn_ztensor *output,
+                                         const bool dequantize,
+                                         const bool disable_clipping) {
+  qmatmul_post_job job;
+  init_qmatmul_post_job(clip_min, clip_max, output, dequantize,
+                        disable_clipping, &job);
+  job.input_a = input_a;
+  job.input_b = input_b;
+  job.term_a_scale = M * input_b->offset;
+  job.MZa = M * input_a->offset;
+
+  return apply_correction(&job, term_a_chunk);
+}
 
-    // reset out_offset to the next n
-    out_offset = out_offset_n + out_bytes_per_n;
-  }
+/// Computes the appropriate correction term and adjusts the matmul output. Then
+/// clips the output between clip_min and clip_max.
+///
+/// \param[in] input_a The input ztensor, unquantized values.
+/// \param[in] input_b The weights ztensor, quantized values.
+/// \param[in] M The result of Sy / (Sa * Sb).
+/// \param[in] clip_min The minimum quantized value for input_a or NULL.
+/// \param[in] clip_max The maximim quantized value for input_a or NULL.
+/// \param[out] output The returned ztensor from the zAIU.
+/// \param[out] dequantize Whether to dequantize returned ztensor.
+/// \param[out] disable_clipping Whether to disable clipping and rounding.
+///
+/// \return ZDNN_OK or ZDNN_ALLOCATION_FAILURE
+///
+static zdnn_status apply_correction_term_on_the_fly(
+    const zdnn_ztensor *input_a, const zdnn_ztensor *input_b, const float M,
+    const int8_t clip_min, const int8_t clip_max, zdnn_ztensor *output,
+    const bool dequantize, const bool disable_clipping) {
+  qmatmul_post_job job;
+  init_qmatmul_post_job(clip_min, clip_max, output, dequantize,
+                        disable_clipping, &job);
+  job.input_a = input_a;
+  job.input_b = input_b;
+  job.term_a_scale = M * input_b->offset * input_a->rec_scale;
+  job.MZa = M * input_a->offset;
+
+  return apply_correction(&job, term_a_on_the_fly_chunk);
 }
 
 /// Calls the NNPA operations that makeup quantized matmul. This method preforms
@@ -1972,7 +2222,8 @@ static zdnn_status aiu_quantized_matmul_internal(
       const float offset = Zy - scale * Zc;
       const float MZa = M * Za;
 
-      compute_folded_bias(input_b, input_c, scale, offset, MZa, qc_tilde);
+      compute_cached_bias(BIAS_FOLDED, input_b, input_c, scale, offset, MZa,
+                          qc_tilde);
 
       status = quantized_matmul(function_code, input_a, input_b, qc_tilde,
                                 op_type, output);
@@ -1992,8 +2243,8 @@ static zdnn_status aiu_quantized_matmul_internal(
 
       // Upon success, compute correction term and subtract it from output
       if (status == ZDNN_OK) {
-        apply_correction_term(input_a, input_b, M, clip_min, clip_max, output,
-                              dequantize, disable_clipping);
+        status = apply_correction_term(input_a, input_b, M, clip_min, clip_max,
+                                       output, dequantize, disable_clipping);
       }
     }
 
@@ -2003,7 +2254,8 @@ static zdnn_status aiu_quantized_matmul_internal(
   const float scale = (Sa * Sb) / Sc;
   const float offset = scale * Zc;
 
-  compute_comparison_bias(input_b, input_c, scale, offset, Za, qc_tilde);
+  compute_cached_bias(BIAS_COMPARISON, input_b, input_c, scale, offset, Za,
+                      qc_tilde);
 
   zdnn_matmul_ops modified_op = op_type;
 
@@ -2081,7 +2333,8 @@ static zdnn_status aiu_quantized_matmul_on_the_fly_internal(
     if (Zb == 0.f) {
       const float MZa = M * Za;
 
-      compute_folded_bias(input_b, input_c, scale, offset, MZa, qc_tilde);
+      compute_cached_bias(BIAS_FOLDED, input_b, input_c, scale, offset, MZa,
+                          qc_tilde);
 
       status =
           quantized_matmul_on_the_fly(function_code, input_a, input_b, qc_tilde,
@@ -2100,9 +2353,9 @@ static zdnn_status aiu_quantized_matmul_on_the_fly_internal(
 
       // Upon success, compute correction term and subtract it from output
       if (status == ZDNN_OK) {
-        apply_correction_term_on_the_fly(input_a, input_b, M, clip_min,
-                                         clip_max, output, dequantize,
-                                         disable_clipping);
+        status = apply_correction_term_on_the_fly(input_a, input_b, M,
+                                                  clip_min, clip_max, output,
+                                                  dequantize, disable_clipping);
       }
     }
 
@@ -2112,7 +2365,8 @@ static zdnn_status aiu_quantized_matmul_on_the_fly_internal(
   const float scale = (Sa * Sb) / Sc;
   const float offset = scale * Zc;
 
-  compute_comparison_bias(input_b, input_c, scale, offset, Za, qc_tilde);
+  compute_cached_bias(BIAS_COMPARISON, input_b, input_c, scale, offset, Za,
+                      qc_tilde);
 
   zdnn_matmul_ops modified_op = op_type;
 
@@ -2140,6 +2394,137 @@ static zdnn_status aiu_quantized_matmul_on_the_fly_internal(
                                      modified_op, clip_min, clip_max, output);
 }
 
+/// Calls the NNPA operations that makeup quantized matmul with
+/// MATMUL_OP_ADDITION when input_b is quantized per output channel, with
+/// input_a quantized or not.
+///
+/// The zAIU only takes a single scale for input_b, so it is handed the largest
+/// channel scale as a reference, Sb = 1 / max(|scale[j]|), and every channel's
+/// ratio to it, r[j] = scale[j] / max(|scale[j]|), is applied on the host:
+///   M = Sy / (Sa * Sb)
+///   qc_tilde[j] = input_c[j] * (Sy / Sc) / r[j] + (Zy - (Sy / Sc) * Zc) / r[j]
+///                 + M * N * Za * Zb[j]
+///   output[i][j] = r[j] * (matmul[i][j] - Zb[j] * term_a[i] - term_b[j])
+///
+/// where the M * N * Za * Zb[j] part is left out for unquantized input_a, the
+/// same as with a per-tensor Zb.  |r[j]| <= 1, so the precision lost to the
+/// dlfloat16 matmul output isn't magnified.  The bias isn't cached.
+///
+/// \param[in] function_code The matmul operation to be run.
+/// \param[in] input_a The input ztensor, quantized or unquantized values.
+/// \param[in] input_b The weights ztensor, quantized values.
+/// \param[in] input_c The biases ztensor, quantized values.
+/// \param[in] clip_min The minimum quantized value.
+/// \param[in] clip_max The maximim quantized value.
+/// \param[out] qc_tilde The computed biases ztensor.
+/// \param[out] output The returned ztensor from the zAIU.
+/// \param[out] dequantize Whether to dequantize returned ztensor.
+/// \param[out] disable_clipping Whether to disable clipping and rounding.
+///
+/// \return ZDNN_OK if all checks pass or a failure based on why it failed.
+///
+static zdnn_status aiu_quantized_matmul_per_channel_internal(
+    const uint8_t function_code, const zdnn_ztensor *input_a,
+    const zdnn_ztensor *input_b, const zdnn_ztensor *input_c,
+    const int8_t clip_min, const int8_t clip_max, zdnn_ztensor *qc_tilde,
+    zdnn_ztensor *output, const bool dequantize, const bool disable_clipping) {
+
+  const bool on_the_fly = input_a->transformed_desc->type != ZDNN_BINARY_INT8;
+  const uint32_t channels = input_b->transformed_desc->dim1;
+
+  float ref_scale = 0.f;
+  bool asymmetric = false;
+  for (uint32_t j = 0; j < channels; j++) {
+    const float scale_j = input_b->channel_scales
+                              ? input_b->channel_scales[j]
+                              : 1.f / input_b->rec_scale;
+    const float zb_j = input_b->channel_offsets ? input_b->channel_offsets[j]
+                                                : input_b->offset;
+    // also catches NaN
+    if (!(scale_j != 0.f)) {
+      return ZDNN_STATUS(ZDNN_INVALID_SCALE,
+                         "input_b scale of channel %u must be a numeric "
+                         "non-zero value (found %f)",
+                         j, scale_j);
+    }
+    const float abs_scale_j = fabsf(scale_j);
+    ref_scale = MAX(ref_scale, abs_scale_j);
+    asymmetric |= (zb_j != 0.f);
+  }
+
+  // ratio and Zb are read 4 at a time, up to the end of the last stick
+  const uint64_t stride =
+      CEIL(channels, AIU_2BYTE_CELLS_PER_STICK) * AIU_2BYTE_CELLS_PER_STICK;
+  float *ratio = calloc(4 * stride, sizeof(float));
+  if (!ratio) {
+    return ZDNN_STATUS(ZDNN_ALLOCATION_FAILURE,
+                       "Unable to allocate %" PRIu64
+                       " bytes for per-channel factors.",
+                       4 * stride * sizeof(float));
+  }
+  float *zb = ratio + stride;
+  float *bias_scale = zb + stride;
+  float *bias_offset = bias_scale + stride;
+
+  zdnn_ztensor ref_b = *input_b;
+  ref_b.rec_scale = 1.f / ref_scale;
+
+  const float Sa = input_a->rec_scale;
+  const float Za = input_a->offset;
+  const float Sc = input_c->rec_scale;
+  const float Zc = input_c->offset;
+  const float Sy = output->rec_scale;
+  const float Zy = output->offset;
+
+  const float M = Sy / (Sa * ref_b.rec_scale);
+  const float scale = Sy / Sc;
+  const float offset = Zy - scale * Zc;
+  const float MNZa =
+      on_the_fly ? 0.f : M * (float)(input_a->transformed_desc->dim1) * Za;
+
+  for (uint32_t j = 0; j < channels; j++) {
+    const float scale_j = input_b->channel_scales
+                              ? input_b->channel_scales[j]
+                              : 1.f / input_b->rec_scale;
+    ratio[j] = scale_j / ref_scale;
+    zb[j] = input_b->channel_offsets ? input_b->channel_offsets[j]
+                                     : input_b->offset;
+    bias_scale[j] = scale / ratio[j];
+    bias_offset[j] = offset / ratio[j] + MNZa * zb[j];
+  }
+
+  compute_channel_bias(input_c, bias_scale, bias_offset, qc_tilde);
+
+  zdnn_status status =
+      on_the_fly ? quantized_matmul_on_the_fly(function_code, input_a, &ref_b,
+                                               qc_tilde, MATMUL_OP_ADDITION,
+                                               clip_min, clip_max, output)
+                 : quantized_matmul(function_code, input_a, &ref_b, qc_tilde,
+                                    MATMUL_OP_ADDITION, output);
+
+  // Upon success, compute correction term, subtract it from output and scale
+  // each channel by its ratio
+  if (status == ZDNN_OK) {
+    qmatmul_post_job job;
+    init_qmatmul_post_job(clip_min, clip_max, output, dequantize,
+                          disable_clipping, &job);
+    job.input_a = input_a;
+    job.input_b = input_b;
+    job.term_a_scale = on_the_fly ? M * Sa : M;
+    job.MZa = M * Za;
+    job.channel_zb = asymmetric ? zb : NULL;
+    job.channel_ratio = ratio;
+
+    status = apply_correction(
+        &job, !asymmetric ? NULL
+                          : (on_the_fly ? term_a_on_the_fly_chunk
+                                        : term_a_chunk));
+  }
+
+  free(ratio);
+  return status;
+}
+
 /// Calls the NNPA operations that makeup quantized matmul. This method preforms
 /// "post" work. It first calls quantized_matmul() to perform the matmul op. For
 /// "post" it computes the appropriate correction term (if applicable) and
@@ -2274,10 +2659,11 @@ static zdnn_status aiu_quantized_matmul_pre_computed_on_the_fly_internal(
 
 /// Calls the NNPA operations that makeup quantized matmul. It first allocates
 /// the work_area (if necessary) and then calls either
-/// aiu_quantized_matmul_internal() or
-/// aiu_quantized_matmul_on_the_fly_internal(). After output is processed it
-/// cleans up the work area (if necessary) and returns the final status. Method
-/// stops and returns on the first error encountered or ZDNN_OK.
+/// aiu_quantized_matmul_internal(), aiu_quantized_matmul_on_the_fly_internal()
+/// or, for per-channel weights, aiu_quantized_matmul_per_channel_internal().
+/// After output is processed it cleans up the work area (if necessary) and
+/// returns the final status. Method stops and returns on the first error
+/// encountered or ZDNN_OK.
 ///
 /// \param[in] op_parm_block_version Parmblock Version.
 /// \param[in] function_code The matmul operation to be run.
@@ -2309,6 +2695,13 @@ aiu_quantized_matmul(uint16_t op_parm_block_version,
     return ZDNN_UNAVAILABLE_FUNCTION;
   }
 
+  // computes the bias on the host and may issue more than one operation
+  zdnn_status plan_status =
+      check_op_plan_recordable("zdnn_quantized_matmul_op");
+  if (plan_status != ZDNN_OK) {
+    return plan_status;
+  }
+
   // Setup qc_tilde ztensor using same layout, format, and dims as input_c but
   // dlfloat16 type. Using values from input_c transformed_desc means
   // validation of qc_tilde applies to input_c.
@@ -2357,7 +2750,11 @@ aiu_quantized_matmul(uint16_t op_parm_block_version,
   }
 
   zdnn_status status;
-  if (input_a->transformed_desc->type == ZDNN_BINARY_INT8) {
+  if (!pre_computed && input_b->is_per_channel) {
+    status = aiu_quantized_matmul_per_channel_internal(
+        function_code, input_a, input_b, input_c, clip_min, clip_max,
+        &qc_tilde, output, dequantize, disable_clipping);
+  } else if (input_a->transformed_desc->type == ZDNN_BINARY_INT8) {
     if (!pre_computed) {
       status = aiu_quantized_matmul_internal(
           function_code, input_a, input_b, input_c, op_type, clip_min, clip_max,
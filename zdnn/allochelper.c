@@ -78,6 +78,8 @@ zdnn_status zdnn_free_ztensor_buffer(const zdnn_ztensor *ztensor) {
   if (!ztensor->buffer) {
     return ZDNN_STATUS_NO_MSG(ZDNN_INVALID_BUFFER);
   }
+  // the address may come back for different data
+  invalidate_qmatmul_bias_cache(ztensor->buffer);
   free_aligned_4k(ztensor->buffer);
   return ZDNN_STATUS_OK;
 }
@@ -0,0 +1,387 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "zdnn.h"
+#include "zdnn_private.h"
+
+#ifdef __MVS__
+#pragma export(zdnn_concat_ztensors)
+#pragma export(zdnn_split_ztensor)
+#endif
+
+/*
+  Concat and split both copy every piece to or from its range of the whole
+  zTensor along one axis, numbered in transformed NHWC order as for
+  zdnn_transpose_ztensor(): 0 is dim4 and 3 is dim1.  Along every other axis
+  the piece and the whole have the same dims, so:
+
+  - along dim4, a piece is a contiguous run of pages of the whole
+  - along dim3 or dim2, and along dim1 when the piece starts on a stick and
+    ends on a stick or at the end of the whole, every W row of sticks of the
+    piece is a run of sticks of the whole
+  - otherwise cells are moved between sticks, a run within a stick at a time
+*/
+
+// piece (e4x, e3x) rows handled per parallel chunk are sized to cover about
+// this many cells
+#define CONCAT_CELLS_PER_CHUNK 65536
+
+// State shared by the workers copying one piece.  Every chunk covers its own
+// rows of the piece.
+typedef struct concat_job {
+  char *whole_buf;
+  char *piece_buf;
+  stick_geometry whole;
+  stick_geometry piece;
+  uint32_t piece_dim1;
+  uint32_t start[ZDNN_MAX_DIMS]; // piece's first coordinates in the whole
+  bool to_whole;                 // concat if true, split otherwise
+  bool by_sticks;                // whole W rows of sticks can be copied
+} concat_job;
+
+/// Copy bytes between a piece and the whole, in the job's direction
+///
+/// \param[in] job the concat_job
+/// \param[in] whole pointer into the whole's buffer
+/// \param[in] piece pointer into the piece's buffer
+/// \param[in] size number of bytes
+///
+/// \return None
+///
+static inline void copy_bytes(const concat_job *job, char *whole, char *piece,
+                              size_t size) {
+  if (job->to_whole) {
+    memcpy(whole, piece, size);
+  } else {
+    memcpy(piece, whole, size);
+  }
+}
+
+/// Copy piece rows [begin, end) to or from the whole
+///
+/// \param[in] ctx Pointer to the concat_job
+/// \param[in] begin first piece (e4x, e3x) row
+/// \param[in] end one past the last piece row
+///
+/// \return None
+///
+static void concat_rows_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  const concat_job *job = ctx;
+  const uint32_t whole_dim1 = job->whole.dim1;
+
+  for (uint64_t row = begin; row < end; row++) {
+    uint32_t n = row / job->piece.dim3;
+    uint32_t h = row % job->piece.dim3;
+    char *piece_row = job->piece_buf + n * job->piece.bytes_per_e4x +
+                      h * job->piece.bytes_per_row;
+    char *whole_row = job->whole_buf +
+                      (n + job->start[0]) * job->whole.bytes_per_e4x +
+                      (h + job->start[1]) * job->whole.bytes_per_row +
+                      job->start[2] * AIU_BYTES_PER_STICK;
+
+    if (job->by_sticks) {
+      uint32_t first_stick1 = job->start[3] / AIU_2BYTE_CELLS_PER_STICK;
+      for (uint32_t s = 0; s < CEIL(job->piece_dim1, AIU_2BYTE_CELLS_PER_STICK);
+           s++) {
+        copy_bytes(job,
+                   whole_row + (first_stick1 + s) * job->whole.bytes_per_stick1,
+                   piece_row + s * job->piece.bytes_per_stick1,
+                   job->piece.dim2 * AIU_BYTES_PER_STICK);
+      }
+      continue;
+    }
+
+    for (uint32_t w = 0; w < job->piece.dim2; w++) {
+      uint32_t c = 0;
+      while (c < job->piece_dim1) {
+        uint32_t wc = c + job->start[3];
+        uint32_t run = MIN(AIU_2BYTE_CELLS_PER_STICK -
+                               c % AIU_2BYTE_CELLS_PER_STICK,
+                           AIU_2BYTE_CELLS_PER_STICK -
+                               wc % AIU_2BYTE_CELLS_PER_STICK);
+        run = MIN(run, job->piece_dim1 - c);
+        copy_bytes(job,
+                   whole_row +
+                       wc / AIU_2BYTE_CELLS_PER_STICK *
+                           job->whole.bytes_per_stick1 +
+                       w * AIU_BYTES_PER_STICK +
+                       wc % AIU_2BYTE_CELLS_PER_STICK * sizeof(uint16_t),
+                   piece_row +
+                       c / AIU_2BYTE_CELLS_PER_STICK *
+                           job->piece.bytes_per_stick1 +
+                       w * AIU_BYTES_PER_STICK +
+                       c % AIU_2BYTE_CELLS_PER_STICK * sizeof(uint16_t),
+                   run * sizeof(uint16_t));
+        c += run;
+      }
+
+      // zero the padding cells after dim1 in the last stick written, so they
+      // don't hold cells of other pieces
+      uint32_t tail;
+      char *last_stick;
+      if (job->to_whole) {
+        tail = whole_dim1 % AIU_2BYTE_CELLS_PER_STICK;
+        last_stick = whole_row +
+                     (whole_dim1 - 1) / AIU_2BYTE_CELLS_PER_STICK *
+                         job->whole.bytes_per_stick1 +
+                     w * AIU_BYTES_PER_STICK;
+        if (job->start[3] + job->piece_dim1 != whole_dim1) {
+          tail = 0;
+        }
+      } else {
+        tail = job->piece_dim1 % AIU_2BYTE_CELLS_PER_STICK;
+        last_stick = piece_row +
+                     (job->piece_dim1 - 1) / AIU_2BYTE_CELLS_PER_STICK *
+                         job->piece.bytes_per_stick1 +
+                     w * AIU_BYTES_PER_STICK;
+      }
+      if (tail) {
+        memset(last_stick + tail * sizeof(uint16_t), 0,
+               (AIU_2BYTE_CELLS_PER_STICK - tail) * sizeof(uint16_t));
+      }
+    }
+  }
+}
+
+/// Copy a piece to or from its range of the whole.  The range has the piece's
+/// dims and starts at the given coordinates of the whole, which can be any
+/// block of it, not only a slice along one axis.
+///
+/// \param[in] whole the whole zTensor
+/// \param[in] piece the piece zTensor
+/// \param[in] start the piece's first coordinates in the whole, dim4 first
+/// \param[in] to_whole true to copy into the whole, false to copy out of it
+///
+/// \return None
+///
+void copy_ztensor_range(const zdnn_ztensor *whole, const zdnn_ztensor *piece,
+                        const uint32_t *start, bool to_whole) {
+  const zdnn_tensor_desc *piece_desc = piece->transformed_desc;
+  concat_job job;
+
+  job.whole_buf = whole->buffer;
+  job.piece_buf = piece->buffer;
+  init_stick_geometry(whole->transformed_desc, &job.whole);
+  init_stick_geometry(piece_desc, &job.piece);
+  job.piece_dim1 = piece_desc->dim1;
+  memcpy(job.start, start, sizeof(job.start));
+  job.to_whole = to_whole;
+
+  if (!start[1] && !start[2] && !start[3] &&
+      piece_desc->dim3 == job.whole.dim3 &&
+      piece_desc->dim2 == job.whole.dim2 &&
+      piece_desc->dim1 == job.whole.dim1) {
+    // every e4x of the piece is laid out as in the whole
+    copy_bytes(&job, job.whole_buf + start[0] * job.whole.bytes_per_e4x,
+               job.piece_buf, piece_desc->dim4 * job.piece.bytes_per_e4x);
+    return;
+  }
+
+  job.by_sticks =
+      start[3] % AIU_2BYTE_CELLS_PER_STICK == 0 &&
+      (piece_desc->dim1 % AIU_2BYTE_CELLS_PER_STICK == 0 ||
+       start[3] + piece_desc->dim1 == job.whole.dim1);
+
+  run_parallel((uint64_t)piece_desc->dim4 * piece_desc->dim3,
+               MAX(1, CONCAT_CELLS_PER_CHUNK /
+                          MAX((uint64_t)piece_desc->dim2 * piece_desc->dim1,
+                              1)),
+               concat_rows_chunk, &job);
+}
+
+/// Check the whole zTensor and pieces of a concat or split
+///
+/// \param[in] whole the whole zTensor
+/// \param[in] pieces the pieces
+/// \param[in] count number of pieces
+/// \param[in] axis the axis the pieces are laid along
+/// \param[in] to_whole true for a concat, false for a split
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_STATE
+///         ZDNN_INVALID_FORMAT
+///         ZDNN_INVALID_TYPE
+///         ZDNN_INVALID_SHAPE
+///         ZDNN_INVALID_BUFFER
+///
+static zdnn_status verify_concat_tensors(const zdnn_ztensor *whole,
+                                         const zdnn_ztensor *const *pieces,
+                                         uint32_t count, uint8_t axis,
+                                         bool to_whole) {
+  const zdnn_tensor_desc *whole_desc = whole->transformed_desc;
+  const uint32_t whole_dims[] = {whole_desc->dim4, whole_desc->dim3,
+                                 whole_desc->dim2, whole_desc->dim1};
+
+  if (!count || axis >= ZDNN_MAX_DIMS) {
+    return ZDNN_STATUS(ZDNN_INVALID_SHAPE,
+                       "Invalid number of pieces %u or axis %u", count, axis);
+  }
+  if (!to_whole && !whole->is_transformed) {
+    return ZDNN_STATUS(ZDNN_INVALID_STATE, "input tensor is not transformed.",
+                       NO_ARG);
+  }
+  if (whole_desc->format != ZDNN_FORMAT_4DFEATURE) {
+    return ZDNN_STATUS(ZDNN_INVALID_FORMAT, "Format must be %s, found %s",
+                       get_data_format_str(ZDNN_FORMAT_4DFEATURE),
+                       get_data_format_str(whole_desc->format));
+  }
+  if (whole_desc->type != ZDNN_DLFLOAT16) {
+    return ZDNN_STATUS(ZDNN_INVALID_TYPE, "Type must be %s, found %s",
+                       get_data_type_str(ZDNN_DLFLOAT16),
+                       get_data_type_str(whole_desc->type));
+  }
+  if (!whole->buffer || (to_whole && whole->buffer_size <
+                                         zdnn_getsize_ztensor(whole_desc))) {
+    return ZDNN_STATUS_NO_MSG(ZDNN_INVALID_BUFFER);
+  }
+
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    const zdnn_tensor_desc *desc = pieces[i]->transformed_desc;
+    const uint32_t dims[] = {desc->dim4, desc->dim3, desc->dim2, desc->dim1};
+
+    if (to_whole && !pieces[i]->is_transformed) {
+      return ZDNN_STATUS(ZDNN_INVALID_STATE,
+                         "input tensor %u is not transformed.", i);
+    }
+    if (desc->format != ZDNN_FORMAT_4DFEATURE) {
+      return ZDNN_STATUS(ZDNN_INVALID_FORMAT,
+                         "Format of tensor %u must be %s, found %s", i,
+                         get_data_format_str(ZDNN_FORMAT_4DFEATURE),
+                         get_data_format_str(desc->format));
+    }
+    if (desc->type != ZDNN_DLFLOAT16) {
+      return ZDNN_STATUS(ZDNN_INVALID_TYPE,
+                         "Type of tensor %u must be %s, found %s", i,
+                         get_data_type_str(ZDNN_DLFLOAT16),
+                         get_data_type_str(desc->type));
+    }
+    for (uint8_t k = 0; k < ZDNN_MAX_DIMS; k++) {
+      if (k != axis && dims[k] != whole_dims[k]) {
+        return ZDNN_STATUS(ZDNN_INVALID_SHAPE,
+                           "Tensor %u dims (%u, %u, %u, %u) differ from "
+                           "(%u, %u, %u, %u) outside of axis %u",
+                           i, dims[0], dims[1], dims[2], dims[3],
+                           whole_dims[0], whole_dims[1], whole_dims[2],
+                           whole_dims[3], axis);
+      }
+    }
+    if (!pieces[i]->buffer ||
+        (!to_whole &&
+         pieces[i]->buffer_size < zdnn_getsize_ztensor(desc))) {
+      return ZDNN_STATUS_NO_MSG(ZDNN_INVALID_BUFFER);
+    }
+    total += dims[axis];
+  }
+
+  if (total != whole_dims[axis]) {
+    return ZDNN_STATUS(ZDNN_INVALID_SHAPE,
+                       "Pieces add up to %" PRIu64 " along axis %u, "
+                       "expected %u",
+                       total, axis, whole_dims[axis]);
+  }
+  return ZDNN_STATUS_OK;
+}
+
+/// Get a transformed dim of a zTensor by axis
+///
+/// \param[in] ztensor the zTensor
+/// \param[in] axis 0 for dim4 through 3 for dim1
+///
+/// \return the dim
+///
+static uint32_t get_axis_dim(const zdnn_ztensor *ztensor, uint8_t axis) {
+  const zdnn_tensor_desc *desc = ztensor->transformed_desc;
+  const uint32_t dims[] = {desc->dim4, desc->dim3, desc->dim2, desc->dim1};
+  return dims[axis];
+}
+
+/// Concatenate transformed zTensors along one axis into another, copying
+/// between stick areas without untransforming them.  Axes are numbered in
+/// transformed NHWC order, 0 for dim4 through 3 for dim1.
+///
+/// \param[in] inputs transformed DLFLOAT16 feature zTensors
+/// \param[in] count number of inputs
+/// \param[in] axis the axis to concatenate along
+/// \param[out] output DLFLOAT16 feature zTensor, with the inputs' dims except
+///                    along axis, where it has their sum
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_STATE
+///         ZDNN_INVALID_FORMAT
+///         ZDNN_INVALID_TYPE
+///         ZDNN_INVALID_SHAPE
+///         ZDNN_INVALID_BUFFER
+///
+zdnn_status zdnn_concat_ztensors(const zdnn_ztensor *const *inputs,
+                                 uint32_t count, uint8_t axis,
+                                 zdnn_ztensor *output) {
+  zdnn_status status;
+
+  if ((status = verify_concat_tensors(output, inputs, count, axis, true)) !=
+      ZDNN_OK) {
+    return status;
+  }
+
+  uint32_t start[ZDNN_MAX_DIMS] = {0};
+  for (uint32_t i = 0; i < count; i++) {
+    copy_ztensor_range(output, inputs[i], start, true);
+    start[axis] += get_axis_dim(inputs[i], axis);
+  }
+
+  output->is_transformed = true;
+  return ZDNN_STATUS_OK;
+}
+
+/// Split a transformed zTensor along one axis into others, copying between
+/// stick areas without untransforming them.  Axes are numbered in transformed
+/// NHWC order, 0 for dim4 through 3 for dim1.
+///
+/// \param[in] input transformed DLFLOAT16 feature zTensor
+/// \param[in] axis the axis to split along
+/// \param[out] outputs DLFLOAT16 feature zTensors, with the input's dims
+///                     except along axis, where theirs add up to the input's
+/// \param[in] count number of outputs
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_STATE
+///         ZDNN_INVALID_FORMAT
+///         ZDNN_INVALID_TYPE
+///         ZDNN_INVALID_SHAPE
+///         ZDNN_INVALID_BUFFER
+///
+zdnn_status zdnn_split_ztensor(const zdnn_ztensor *input, uint8_t axis,
+                               zdnn_ztensor *const *outputs, uint32_t count) {
+  zdnn_status status;
+
+  if ((status = verify_concat_tensors(
+           input, (const zdnn_ztensor *const *)outputs, count, axis, false)) !=
+      ZDNN_OK) {
+    return status;
+  }
+
+  uint32_t start[ZDNN_MAX_DIMS] = {0};
+  for (uint32_t i = 0; i < count; i++) {
+    copy_ztensor_range(input, outputs[i], start, false);
+    start[axis] += get_axis_dim(outputs[i], axis);
+    outputs[i]->is_transformed = true;
+  }
+
+  return ZDNN_STATUS_OK;
+}
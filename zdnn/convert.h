@@ -21,6 +21,8 @@
 #include <inttypes.h>
 #include <stddef.h>
 
+#include "zdnn_vec.h"
+
 #define STICKCVT_MAX_ENTRIES_TO_CONVERT 8
 /* Number of entries to be converted at a time. Conversion to/from
    FP32 to DLFLOAT require 2 vector regs to contain the 8 values,
@@ -42,11 +44,16 @@ typedef union uint32_float_u {
   float f;
 } uint32_float_u;
 
+// DLFLOAT16 bit patterns
+#define DLF16_SIGN_MASK 0x8000
+#define DLF16_NINF 0x7FFF    // NINF (not-a-number or infinity), magnitude only
+#define DLF16_MAX_BITS 0x7FFE // largest finite magnitude
+#define DLF16_EXP_BIAS 31
+#define FP32_EXP_BIAS 127
+
 // -----------------------------------------------------------------------------
 // convert_hw.c wrapper Functions and types
 // -----------------------------------------------------------------------------
-typedef vector unsigned int vec_float32;
-
 void saturate_fp32_to_dlf16(const vec_float32 *, const vec_float32 *,
                             vec_float32 *, vec_float32 *);
 void skip_saturate_fp32_to_dlf16(const vec_float32 *, const vec_float32 *,
@@ -14,6 +14,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+#include <fenv.h>
 #include <math.h>
 #include <stdbool.h>
 #include <stddef.h>
@@ -33,18 +34,191 @@
  * "float"-types will immediately cast to one of the float_bitxx
  * types and use those from then on.
  */
-vec_char8 selection_vector = {0,  1,  4,  5,  8,  9,  12, 13,
-                              16, 17, 20, 21, 24, 25, 28, 29};
+vec_char8 selection_vector = VEC_SEL_HI_HALFWORDS;
 static vec_int16 zero_vector16 = {0, 0, 0, 0, 0, 0, 0, 0};
 // 4 vector of the MIN DFL16 value represented as FP32
-static const vector float dlflt_min_vec = {
+static const zdnn_vec_f32 dlflt_min_vec = {
     DLF16_MIN_AS_FP32, DLF16_MIN_AS_FP32, DLF16_MIN_AS_FP32, DLF16_MIN_AS_FP32};
 // 4 vector of the MAX DFL16 value represented as FP32
-static const vector float dlflt_max_vec = {
+static const zdnn_vec_f32 dlflt_max_vec = {
     DLF16_MAX_AS_FP32, DLF16_MAX_AS_FP32, DLF16_MAX_AS_FP32, DLF16_MAX_AS_FP32};
 
-static const vector float dlflt_inf_vec = {INFINITY, INFINITY, INFINITY,
+static const zdnn_vec_f32 dlflt_inf_vec = {INFINITY, INFINITY, INFINITY,
                                            INFINITY};
+
+#if defined(ZDNN_VEC_GENERIC)
+/***********************************************************************
+ * Software DLFLOAT16 conversions
+ *
+ * Used in place of the NNPA-assist conversion instructions when not
+ * running on IBM Z.  Results match the instructions bit for bit: FP32
+ * to DLFLOAT16 rounds to nearest with ties away from zero, values too
+ * small become zero and NaN or values too large become NINF.  The
+ * conditions the instructions report in the FPC are raised with
+ * feraiseexcept() so the callers' fetestexcept() checks work unchanged.
+ *
+ * All of them work on whole vectors, one element per word.  Their
+ * DLFLOAT16 side is in stick byte order, as with the instructions.
+ **********************************************************************/
+
+typedef zdnn_vec_s32 vec_mask32;
+
+#define FP16_EXP_BIAS 15
+
+// FP32 magnitude bits of the DLFLOAT16 with all-zero exponent and fraction
+#define FP32_BITS_DLF16_ZERO_EXP                                               \
+  ((uint32_t)(FP32_EXP_BIAS - DLF16_EXP_BIAS) << 23)
+// FP32 magnitudes at or above this become NINF once rounded
+#define FP32_BITS_DLF16_NINF                                                   \
+  (FP32_BITS_DLF16_ZERO_EXP + ((uint32_t)DLF16_NINF << 14))
+// FP32 magnitudes at or above this become FP16 infinity once rounded
+#define FP32_BITS_FP16_INF 0x477FF000 // 65520.0f
+// smallest normal FP16 magnitude as FP32 bits
+#define FP32_BITS_FP16_MIN_NORMAL 0x38800000 // 2^-14
+
+static inline void raise_fp_exceptions(vec_mask32 fe) {
+  int flags = fe[0] | fe[1] | fe[2] | fe[3];
+  if (flags) {
+    feraiseexcept(flags);
+  }
+}
+
+static inline void halfwords_to_words(vec_int16 a, vec_float32 *hi,
+                                      vec_float32 *lo) {
+  for (int i = 0; i < 4; i++) {
+    (*hi)[i] = a[i];
+    (*lo)[i] = a[i + 4];
+  }
+}
+
+static inline vec_int16 words_to_halfwords(vec_float32 hi, vec_float32 lo) {
+  vec_int16 out;
+  for (int i = 0; i < 4; i++) {
+    out[i] = hi[i];
+    out[i + 4] = lo[i];
+  }
+  return out;
+}
+
+static inline vec_float32 fp32_to_dlf16_words(vec_float32 a, vec_mask32 *fe) {
+  vec_float32 sign = (a >> 16) & DLF16_SIGN_MASK;
+  vec_float32 mag = a & 0x7FFFFFFF;
+  vec_mask32 nan = mag > 0x7F800000;
+  vec_mask32 nonzero = mag != 0;
+
+  mag += 1 << 13; // round off the 14 dropped fraction bits, ties away
+  // 0x0000 is zero, so the all-zero exponent and fraction isn't usable
+  vec_mask32 tiny = mag < FP32_BITS_DLF16_ZERO_EXP + (1 << 14);
+  vec_mask32 huge = mag >= FP32_BITS_DLF16_NINF;
+
+  vec_float32 out = (mag - FP32_BITS_DLF16_ZERO_EXP) >> 14;
+  out = vec_sel(out, vec_splats((uint32_t)0), tiny);
+  out = vec_sel(out, vec_splats((uint32_t)DLF16_NINF), huge);
+
+  *fe |= (nan & FE_INVALID) | (huge & ~nan & FE_OVERFLOW) |
+         (tiny & nonzero & FE_UNDERFLOW);
+  return out | sign;
+}
+
+static inline vec_float32 dlf16_to_fp32_words(vec_float32 a, vec_mask32 *fe) {
+  vec_float32 sign = (a & DLF16_SIGN_MASK) << 16;
+  vec_float32 mag = a & DLF16_NINF;
+  vec_mask32 ninf = mag == DLF16_NINF;
+
+  // DLFLOAT16 has no subnormals, exponent 0 is still a normal number
+  vec_float32 out = (mag + ((FP32_EXP_BIAS - DLF16_EXP_BIAS) << 9)) << 14;
+  out = vec_sel(out, vec_splats((uint32_t)0), mag == 0);
+  out = vec_sel(out, vec_splats((uint32_t)0x7FC00000), ninf);
+
+  *fe |= ninf & FE_INVALID;
+  return out | sign;
+}
+
+static inline vec_float32 fp16_to_fp32_words(vec_float32 a) {
+  vec_float32 sign = (a & 0x8000) << 16;
+  vec_float32 exp = (a >> 10) & 0x1F;
+  vec_float32 frac = (a & 0x3FF) << 13;
+
+  vec_float32 out = ((exp + (FP32_EXP_BIAS - FP16_EXP_BIAS)) << 23) | frac;
+  out = vec_sel(out, 0x7F800000 | frac, exp == 0x1F);
+  // zero and subnormals are fraction * 2^-24, exact in FP32
+  zdnn_vec_f32 subnormal = vec_float((vec_mask32)(frac >> 13)) * 0x1p-24f;
+  out = vec_sel(out, (vec_float32)subnormal, exp == 0);
+  return out | sign;
+}
+
+static inline vec_float32 fp32_to_fp16_words(vec_float32 a, vec_mask32 *fe) {
+  vec_float32 sign = (a >> 16) & 0x8000;
+  vec_float32 mag = a & 0x7FFFFFFF;
+  vec_mask32 nan = mag > 0x7F800000;
+  vec_mask32 tiny = mag < FP32_BITS_FP16_MIN_NORMAL;
+  vec_mask32 huge = mag >= FP32_BITS_FP16_INF;
+
+  // round to nearest even on the 13 dropped fraction bits
+  vec_float32 out =
+      (mag - ((uint32_t)(FP32_EXP_BIAS - FP16_EXP_BIAS) << 23) + 0xFFF +
+       ((mag >> 13) & 1)) >>
+      13;
+
+  // FP16 subnormals, shift the whole significand right, rounding to nearest
+  // even.  FP32 zeros and subnormals have no implied leading 1.
+  vec_float32 sig =
+      ((mag & 0x7FFFFF) | 0x800000) & (vec_float32)(mag >= 0x00800000);
+  vec_float32 shift = vec_min(126 - (mag >> 23), vec_splats((uint32_t)31));
+  vec_float32 sub = sig >> shift;
+  vec_float32 rem = sig & ((vec_splats((uint32_t)1) << shift) - 1);
+  vec_float32 half = vec_splats((uint32_t)1) << (shift - 1);
+  sub += (vec_float32)((rem > half) | ((rem == half) & ((sub & 1) != 0))) & 1;
+
+  out = vec_sel(out, sub, tiny);
+  out = vec_sel(out, vec_splats((uint32_t)0x7C00), huge);
+  out = vec_sel(out, vec_splats((uint32_t)0x7E00), nan);
+
+  *fe |= (huge & ~nan & FE_OVERFLOW) | (tiny & (rem != 0) & FE_UNDERFLOW);
+  return out | sign;
+}
+
+static inline vec_int16 soft_vec_round_from_fp32(vec_float32 a,
+                                                 vec_float32 b) {
+  vec_mask32 fe = {0};
+  vec_int16 out = words_to_halfwords(fp32_to_dlf16_words(a, &fe),
+                                     fp32_to_dlf16_words(b, &fe));
+  raise_fp_exceptions(fe);
+  return VEC_STICK_CELLS16(out);
+}
+
+static inline void soft_vec_lengthen_to_fp32(vec_int16 a, vec_float32 *out1,
+                                             vec_float32 *out2) {
+  vec_mask32 fe = {0};
+  vec_float32 hi, lo;
+  halfwords_to_words(VEC_STICK_CELLS16(a), &hi, &lo);
+  *out1 = dlf16_to_fp32_words(hi, &fe);
+  *out2 = dlf16_to_fp32_words(lo, &fe);
+  raise_fp_exceptions(fe);
+}
+
+static inline vec_int16 soft_vec_convert_from_fp16(vec_int16 a) {
+  vec_mask32 fe = {0};
+  vec_float32 hi, lo;
+  halfwords_to_words(a, &hi, &lo);
+  vec_int16 out =
+      words_to_halfwords(fp32_to_dlf16_words(fp16_to_fp32_words(hi), &fe),
+                         fp32_to_dlf16_words(fp16_to_fp32_words(lo), &fe));
+  raise_fp_exceptions(fe);
+  return VEC_STICK_CELLS16(out);
+}
+
+static inline vec_int16 soft_vec_convert_to_fp16(vec_int16 a) {
+  vec_mask32 fe = {0};
+  vec_float32 hi, lo;
+  halfwords_to_words(VEC_STICK_CELLS16(a), &hi, &lo);
+  vec_int16 out = words_to_halfwords(
+      fp32_to_fp16_words(dlf16_to_fp32_words(hi, &fe), &fe),
+      fp32_to_fp16_words(dlf16_to_fp32_words(lo, &fe), &fe));
+  raise_fp_exceptions(fe);
+  return out;
+}
+#endif // ZDNN_VEC_GENERIC
 /***********************************************************************
  * aiu_vec_round_from_fp32 routines
  *
@@ -61,7 +235,9 @@ static vec_int16 inline aiu_vec_round_from_fp32_inline(vec_float32 a,
                                                        vec_float32 b) {
   vec_int16 out;
 
-#if defined(__MVS__)
+#if defined(ZDNN_VEC_GENERIC)
+  out = soft_vec_round_from_fp32(a, b);
+#elif defined(__MVS__)
   /*
        Invoke the VCRNF
                   "*     VCRNF VReg0,VRegL,VRegR,mask2,0        \n\t"
@@ -115,7 +291,9 @@ vec_int16 aiu_vec_round_from_fp32(vec_float32 a, vec_float32 b) {
 static vec_int16 inline aiu_vec_convert_from_fp16_inline(vec_int16 a) {
   vec_int16 out;
 
-#if defined(__MVS__)
+#if defined(ZDNN_VEC_GENERIC)
+  out = soft_vec_convert_from_fp16(a);
+#elif defined(__MVS__)
   /*
       Invoke the VCNF
                  "*     VCNF VReg0,VReg1,,mask1,0        \n\t"
@@ -170,7 +348,11 @@ static void inline aiu_vec_lengthen_to_fp32_inline(vec_int16 a,
   vec_float32 work_float_1;
   vec_float32 work_float_2;
 
-#if defined(__MVS__)
+#if defined(ZDNN_VEC_GENERIC)
+  soft_vec_lengthen_to_fp32(a, &work_float_1, &work_float_2);
+  *out1 = work_float_1;
+  *out2 = work_float_2;
+#elif defined(__MVS__)
   /*
    *  Invoke the VCLFNx
    *  "*     VCLFN(H/L) VReg0,VReg2,mask0,mask2      \n\t"
@@ -230,7 +412,9 @@ void aiu_vec_lengthen_to_fp32(vec_int16 a, vec_float32 *out1,
 static vec_int16 inline aiu_vec_convert_to_fp16_inline(vec_int16 a) {
   vec_int16 work_short_1;
 
-#if defined(__MVS__)
+#if defined(ZDNN_VEC_GENERIC)
+  work_short_1 = soft_vec_convert_to_fp16(a);
+#elif defined(__MVS__)
   /*
    *  Invoke the VCFN
    *  "*     VCFN VReg0,VReg2,mask0,mask1      \n\t"
@@ -267,7 +451,8 @@ vec_int16 aiu_vec_convert_to_fp16(vec_int16 a) {
 
 /***********************************************************************
  *  cnvt_1 functions - These functions invoke the aiu_vec functions to
- *  convert one value.  Highly inefficient.
+ *  convert one value.  Highly inefficient.  DLFLOAT16 values are in
+ *  host byte order, use STICK_CELL16() to read/write them in a stick.
  **********************************************************************/
 /*  cnvt_1_fp32_to_dlf16 */
 uint16_t cnvt_1_fp32_to_dlf16(float a) {
@@ -285,7 +470,7 @@ uint16_t cnvt_1_fp32_to_dlf16(float a) {
       *((vec_float32 *)&tempfp32array[0]),
       *((vec_float32 *)&tempfp32array[4])); /* Convert from fp32 to
                                                dlfloat with rounding */
-  return (uint16_t)aiu_op_output_dfloat[0]; // return first value from vector
+  return STICK_CELL16(aiu_op_output_dfloat[0]); // return first value
 }
 
 /*  cnvt_1_dlf16_to_fp32 */
@@ -296,8 +481,8 @@ float cnvt_1_dlf16_to_fp32(uint16_t a) {
   /* Copy value to work area, use zAIU op routine to convert value from
      dlfloat to fp32 in pseudo vector (array), then copy the 1 converted
      entry into the expected data area */
-  float_bit16 tempshortarray[8] = {a}; // used as input to aiu_vec_lengthen...
-                                       // conversion
+  float_bit16 tempshortarray[8] = {
+      STICK_CELL16(a)}; // used as input to aiu_vec_lengthen... conversion
   aiu_vec_lengthen_to_fp32(*((vec_int16 *)&tempshortarray[0]),
                            aiu_op_output_fp32,
                            aiu_op_output_fp32 + 1); /* Convert from dlfloat to
@@ -318,7 +503,7 @@ uint16_t cnvt_1_fp16_to_dlf16(uint16_t a) {
                                       aiu_vec_convert... conversion */
   aiu_op_output = aiu_vec_convert_from_fp16(
       *(vec_int16 *)(tempFP16array)); // Convert from fp16 to dlfloat
-  return (uint16_t)aiu_op_output[0];  // return first value from vector
+  return STICK_CELL16(aiu_op_output[0]); // return first value from vector
 }
 
 /*  cnvt_1_dlf16_to_fp16 */
@@ -329,8 +514,9 @@ uint16_t cnvt_1_dlf16_to_fp16(uint16_t a) {
   /* Copy value to work area, use zAIU op routine to convert value from dlfloat
      to fp16 in pseudo vector (array), then copy the 1 converted entry
      into the expected data area */
-  float_bit16 tempFP16array[8] = {a}; /* input to aiu_vec_lengthen
-                              conversion, with input as first (only) entry */
+  float_bit16 tempFP16array[8] = {
+      STICK_CELL16(a)}; /* input to aiu_vec_lengthen conversion, with input
+                           as first (only) entry */
   aiu_op_output = aiu_vec_convert_to_fp16(
       *(vec_int16 *)(&tempFP16array));  // Convert from dlfloat to fp16
   return (float_bit16)aiu_op_output[0]; // return value from vector
@@ -379,11 +565,9 @@ float cnvt_1_fp16_to_fp32(uint16_t a) {
 
 // convert 1 FP32 element to BFLOAT
 uint16_t cnvt_1_fp32_to_bfloat(float a) {
-  union {
-    float in; // cppcheck-suppress unusedStructMember
-    uint16_t out;
-  } u = {.in = a};
-  return u.out;
+  // BFLOAT is the high-order half of the FP32 bits, whatever the byte order
+  uint32_float_u u = {.f = a};
+  return (uint16_t)(u.u >> 16);
 }
 
 // convert 1 FP32 element to FP16
@@ -546,8 +730,8 @@ void saturate_fp32_to_dlf16(const vec_float32 *in_vector_left,
                             vec_float32 *out_vector_right) {
 
   // Create temp vectors for output
-  vector float temp_left = (vector float)*in_vector_left;
-  vector float temp_right = (vector float)*in_vector_right;
+  zdnn_vec_f32 temp_left = (zdnn_vec_f32)*in_vector_left;
+  zdnn_vec_f32 temp_right = (zdnn_vec_f32)*in_vector_right;
 
   // For each left and right vectors:
   // 1. Perform a bitwise AND on the original input vector with dlflt_inf_vec to
@@ -818,8 +1002,8 @@ uint64_t bfloat_to_dlf16(uint16_t *input_data, uint16_t *output_data,
     // Conversion processing: Use vector merge to insert extra decimal
     // places into the vector, expanding the bfloat16 into an FP32,
     // then use our "convert and round" routine to transform to dlfloat
-    interim_data1 = vec_mergeh(*cur_input_data, zero_vector16);
-    interim_data2 = vec_mergel(*cur_input_data, zero_vector16);
+    interim_data1 = VEC_MERGEH_HALFWORDS(*cur_input_data, zero_vector16);
+    interim_data2 = VEC_MERGEL_HALFWORDS(*cur_input_data, zero_vector16);
     // Perform saturation using the passed saturation function.
     // No saturation performed if skip function is passed
     saturate_func((vec_float32 *)&interim_data1, (vec_float32 *)&interim_data2,
@@ -855,8 +1039,8 @@ uint64_t bfloat_to_dlf16(uint16_t *input_data, uint16_t *output_data,
   // Conversion processing: Use vector merge to insert extra decimal
   // places into the vector, expanding the bfloat16 into an FP32,
   // then use our "convert and round" routine to transform to dlfloat
-  interim_data1 = vec_mergeh(in_vector, zero_vector16);
-  interim_data2 = vec_mergel(in_vector, zero_vector16);
+  interim_data1 = VEC_MERGEH_HALFWORDS(in_vector, zero_vector16);
+  interim_data2 = VEC_MERGEL_HALFWORDS(in_vector, zero_vector16);
   // Perform saturation using the passed saturation function.
   // No saturation performed if skip function is passed
   saturate_func((vec_float32 *)&interim_data1, (vec_float32 *)&interim_data2,
@@ -1149,8 +1333,10 @@ uint64_t bfloat_to_dlf16_in_stride(uint16_t *bflt_data, uint16_t *dflt16_data,
     // Conversion processing: Use vector merge to insert extra decimal
     // places into the vector, expanding the bfloat16 into an FP32,
     // then use our "convert and round" routine to transform to dlfloat
-    interim_data1 = (vec_float32)vec_mergeh(*gathered_vector, zero_vector16);
-    interim_data2 = (vec_float32)vec_mergel(*gathered_vector, zero_vector16);
+    interim_data1 =
+        (vec_float32)VEC_MERGEH_HALFWORDS(*gathered_vector, zero_vector16);
+    interim_data2 =
+        (vec_float32)VEC_MERGEL_HALFWORDS(*gathered_vector, zero_vector16);
     *cur_dflt16_data = aiu_vec_round_from_fp32_inline(
         (vec_float32)interim_data1, (vec_float32)interim_data2); /* Convert
                             gathered values directly to user
@@ -1176,8 +1362,10 @@ uint64_t bfloat_to_dlf16_in_stride(uint16_t *bflt_data, uint16_t *dflt16_data,
     // Conversion processing: Use vector merge to insert extra decimal
     // places into the vector, expanding the bfloat16 into an FP32,
     // then use our "convert and round" routine to transform to dlfloat
-    interim_data1 = (vec_float32)vec_mergeh(*gathered_vector, zero_vector16);
-    interim_data2 = (vec_float32)vec_mergel(*gathered_vector, zero_vector16);
+    interim_data1 =
+        (vec_float32)VEC_MERGEH_HALFWORDS(*gathered_vector, zero_vector16);
+    interim_data2 =
+        (vec_float32)VEC_MERGEL_HALFWORDS(*gathered_vector, zero_vector16);
     aiu_op_output = aiu_vec_round_from_fp32_inline((vec_float32)interim_data1,
                                                    (vec_float32)interim_data2);
 
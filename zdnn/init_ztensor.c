@@ -24,10 +24,29 @@
 #pragma export(zdnn_init_quantized_ztensor)
 #pragma export(zdnn_init_ztensor_with_malloc)
 #pragma export(zdnn_init_quantized_ztensor_with_malloc)
+#pragma export(zdnn_init_per_channel_quantized_ztensor)
 #pragma export(zdnn_is_quantized_ztensor)
 #pragma export(zdnn_reset_ztensor)
 #endif
 
+// zdnn_ztensor before is_per_channel, channel_scales and channel_offsets were
+// carved out of its reserved2 bytes.  Applications built against older headers
+// allocate zdnn_ztensors of this size, so the new fields must fit in it.
+typedef struct {
+  zdnn_tensor_desc *pre_transformed_desc;
+  zdnn_tensor_desc *transformed_desc;
+  uint64_t buffer_size;
+  void *buffer;
+  bool is_transformed;
+  char reserved[3];
+  float rec_scale;
+  float offset;
+  char reserved2[20];
+} ztensor_1_2_layout;
+
+typedef char ztensor_size_unchanged
+    [sizeof(zdnn_ztensor) == sizeof(ztensor_1_2_layout) ? 1 : -1];
+
 /// Initialize a zTensor with the pre-transformed and transformed shape
 /// informations
 ///
@@ -46,7 +65,10 @@ void zdnn_init_ztensor(zdnn_tensor_desc *pre_tfrmd_desc,
   memset(&output->reserved, 0, sizeof(output->reserved));
   output->rec_scale = 0;
   output->offset = 0;
+  output->is_per_channel = false;
   memset(&output->reserved2, 0, sizeof(output->reserved2));
+  output->channel_scales = NULL;
+  output->channel_offsets = NULL;
 }
 
 /// Initialize a quantized zTensor with the pre-transformed and transformed
@@ -71,7 +93,36 @@ void zdnn_init_quantized_ztensor(zdnn_tensor_desc *pre_tfrmd_desc,
   memset(&output->reserved, 0, sizeof(output->reserved));
   output->rec_scale = (scale != 0) ? (1 / scale) : scale;
   output->offset = offset;
+  output->is_per_channel = false;
   memset(&output->reserved2, 0, sizeof(output->reserved2));
+  output->channel_scales = NULL;
+  output->channel_offsets = NULL;
+}
+
+/// Initialize a quantized zTensor whose scale and offset are given per output
+/// channel (dim1), on top of what zdnn_init_quantized_ztensor() does.  Only the
+/// pointers are kept, the vectors must outlive the zTensor.
+///
+/// \param[in] pre_tfrmd_desc pre-transformed shape information
+/// \param[in] tfrmd_desc transformed shape information
+/// \param[in] scale scale of the channels without a channel scale
+/// \param[in] offset offset of the channels without a channel offset
+/// \param[in] channel_scales dim1 scales (not reciprocals), or NULL
+/// \param[in] channel_offsets dim1 offsets, or NULL
+/// \param[out] output the zdnn_ztensor struct being initialized.
+///
+/// \return None
+///
+void zdnn_init_per_channel_quantized_ztensor(
+    zdnn_tensor_desc *pre_tfrmd_desc, zdnn_tensor_desc *tfrmd_desc, float scale,
+    float offset, const float *channel_scales, const float *channel_offsets,
+    zdnn_ztensor *output) {
+
+  zdnn_init_quantized_ztensor(pre_tfrmd_desc, tfrmd_desc, scale, offset,
+                              output);
+  output->is_per_channel = (channel_scales || channel_offsets);
+  output->channel_scales = channel_scales;
+  output->channel_offsets = channel_offsets;
 }
 
 /// @brief  Check if a given ztensor represents a quantized ztensor or not
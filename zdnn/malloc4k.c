@@ -1,6 +1,6 @@
 // SPDX-License-Identifier: Apache-2.0
 /*
- * Copyright IBM Corp. 2021
+ * Copyright IBM Corp. 2021, 2024
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -18,10 +18,294 @@
 #include "zdnn.h"
 #include "zdnn_private.h"
 #include <errno.h>
+#include <pthread.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#ifdef __MVS__
+#pragma export(zdnn_set_allocator)
+#endif
+
+/*
+  Every area handed out by malloc_aligned_4k() is preceded by an alloc_header
+  that records where the area came from, so free_aligned_4k() can give it back
+  the right way:
+
+  - Sizes up to POOL_MAX_PAGES pages are rounded up to a size class and, when
+    freed, kept on a free list of that class instead of being released.  The
+    smallest classes (save areas, work areas of small ops) are first kept in a
+    per-thread cache that needs no locking, the rest go to a shared pool
+    holding at most alloc_cache_bytes.
+  - With hugepages_enabled, areas of HUGEPAGE_MIN_BYTES or more are mmap()'d
+    and advised for transparent huge pages instead of malloc()'d.
+  - Once zdnn_set_allocator() installs a host allocator, all new areas come
+    from it and go back to it, nothing is pooled.  Pooled areas freed from
+    then on are released, and every thread drains its cache the next time it
+    allocates or frees.
+
+  Size classes are 1 to 4 pages, then 4 classes per power of two:
+  5, 6, 7, 8, 10, 12, 14, 16, 20, 24, 28, 32, ... pages.  Rounding up wastes
+  at most 25% of an area.
+*/
+
+#define POOL_MAX_PAGES 16384 // 64MB, larger areas are never pooled
+#define POOL_NUM_CLASSES 52  // classes up to and including POOL_MAX_PAGES
+#define POOL_NO_CLASS UINT16_MAX
+
+#define TCACHE_NUM_CLASSES 20 // per-thread cache for classes up to 64 pages
+#define TCACHE_MAX_BLOCKS 2   // areas kept per class per thread
+
+#define HUGEPAGE_MIN_BYTES (2 * 1024 * 1024)
+
+typedef enum alloc_sources {
+  ALLOC_SRC_MALLOC, // malloc()'d, aligned within the area
+  ALLOC_SRC_MMAP,   // mmap()'d, header in the first page
+  ALLOC_SRC_HOST    // from the zdnn_set_allocator() allocator
+} alloc_sources;
+
+typedef struct alloc_header {
+  void *base;                // address returned by the backing allocator
+  size_t base_size;          // bytes requested from the backing allocator
+  struct alloc_header *next; // free list link while pooled
+  zdnn_free_func host_free;  // ALLOC_SRC_HOST only
+  void *host_user_data;      // ALLOC_SRC_HOST only
+  uint16_t class_idx;        // size class, or POOL_NO_CLASS
+  uint8_t source;            // alloc_sources
+} alloc_header;
+
+#define HEADER_OF(aligned_ptr) ((alloc_header *)(aligned_ptr) - 1)
+#define AREA_OF(header) ((void *)((alloc_header *)(header) + 1))
+
+static zdnn_alloc_func host_alloc = NULL;
+static zdnn_free_func host_free = NULL;
+static void *host_user_data = NULL;
+
+static pthread_mutex_t alloc_lock = PTHREAD_MUTEX_INITIALIZER;
+static alloc_header *pool_free_list[POOL_NUM_CLASSES];
+static uint64_t pool_cached_bytes = 0;
+
+// bumped by zdnn_set_allocator(), thread caches filled before are drained
+static uint32_t alloc_generation = 0;
+
+static __thread alloc_header *tcache_free_list[TCACHE_NUM_CLASSES];
+static __thread uint8_t tcache_count[TCACHE_NUM_CLASSES];
+static __thread uint32_t tcache_generation = 0;
+static pthread_once_t tcache_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t tcache_key;
+
+/// Size class for an area of a number of pages
+///
+/// \param[in] pages Number of pages, at least 1
+///
+/// \return size class index, or POOL_NO_CLASS if too large to pool
+///
+static uint16_t size_class(uint64_t pages) {
+  if (pages > POOL_MAX_PAGES) {
+    return POOL_NO_CLASS;
+  }
+  if (pages <= 4) {
+    return (uint16_t)(pages - 1);
+  }
+
+  // pages is in (2^e, 2^(e+1)], split into 4 steps of 2^(e-2) pages
+  uint32_t e = 63 - __builtin_clzll(pages - 1);
+  uint32_t shift = e - 2;
+  uint64_t k = (pages - (1ULL << e) + (1ULL << shift) - 1) >> shift;
+  return (uint16_t)(4 * (e - 1) + (k - 1));
+}
+
+/// Number of pages of a size class
+///
+/// \param[in] class_idx Size class index
+///
+/// \return number of pages
+///
+static uint64_t class_pages(uint16_t class_idx) {
+  if (class_idx < 4) {
+    return class_idx + 1;
+  }
+  uint32_t e = class_idx / 4 + 1;
+  uint64_t k = class_idx % 4 + 1;
+  return (1ULL << e) + (k << (e - 2));
+}
+
+/// Get an area from the backing allocator and set up its header
+///
+/// \param[in] size Usable size of the area, in bytes
+/// \param[in] class_idx Size class recorded in the header
+///
+/// \return Pointer to the 4k-aligned area, or NULL
+///
+static void *alloc_area(size_t size, uint16_t class_idx) {
+  alloc_header *header;
+
+  if (host_alloc) {
+    // the host returns 4k-aligned memory, the header goes in the first page
+    size_t base_size = size + AIU_PAGESIZE_IN_BYTES;
+    void *base = host_alloc(base_size, host_user_data);
+    if (!base) {
+      return NULL;
+    }
+    if ((uintptr_t)base & (AIU_PAGESIZE_IN_BYTES - 1)) {
+      LOG_ERROR("Host allocator returned %016lx, not on a 4k boundary",
+                (uintptr_t)base);
+      host_free(base, base_size, host_user_data);
+      return NULL;
+    }
+    header = HEADER_OF((char *)base + AIU_PAGESIZE_IN_BYTES);
+    header->base = base;
+    header->base_size = base_size;
+    header->host_free = host_free;
+    header->host_user_data = host_user_data;
+    header->source = ALLOC_SRC_HOST;
+    header->class_idx = POOL_NO_CLASS;
+    return AREA_OF(header);
+  }
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  if (hugepages_enabled && size >= HUGEPAGE_MIN_BYTES) {
+    size_t base_size = size + AIU_PAGESIZE_IN_BYTES;
+    void *base = mmap(NULL, base_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+      perror("Error during mmap");
+      return NULL;
+    }
+    // only a hint, the kernel may not have transparent huge pages enabled
+    madvise(base, base_size, MADV_HUGEPAGE);
+
+    header = HEADER_OF((char *)base + AIU_PAGESIZE_IN_BYTES);
+    header->base = base;
+    header->base_size = base_size;
+    header->source = ALLOC_SRC_MMAP;
+    header->class_idx = class_idx;
+    return AREA_OF(header);
+  }
+#endif
+
+  // request one more page + size of the header from the OS
+  size_t base_size = size + (AIU_PAGESIZE_IN_BYTES - 1) + sizeof(alloc_header);
+  void *base = malloc(base_size);
+  if (!base) {
+    perror("Error during malloc");
+    fprintf(stderr, "errno = %d\n", errno);
+    return NULL;
+  }
+
+  // find the 4k boundary that leaves room for the header
+  void *aligned_ptr =
+      (void *)(((uintptr_t)base + sizeof(alloc_header) +
+                (AIU_PAGESIZE_IN_BYTES - 1)) &
+               ~(uintptr_t)(AIU_PAGESIZE_IN_BYTES - 1));
+  header = HEADER_OF(aligned_ptr);
+  header->base = base;
+  header->base_size = base_size;
+  header->source = ALLOC_SRC_MALLOC;
+  header->class_idx = class_idx;
+  return aligned_ptr;
+}
+
+/// Give an area back to its backing allocator
+///
+/// \param[in] header Header of the area
+///
+/// \return None
+///
+static void release_area(alloc_header *header) {
+  switch (header->source) {
+  case ALLOC_SRC_HOST:
+    header->host_free(header->base, header->base_size,
+                      header->host_user_data);
+    break;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  case ALLOC_SRC_MMAP:
+    munmap(header->base, header->base_size);
+    break;
+#endif
+  default:
+    free(header->base);
+    break;
+  }
+}
+
+/// Move every area in the calling thread's cache to the shared pool, or
+/// release it if the pool is full.  Runs as the destructor of tcache_key when
+/// a thread that cached areas ends.
+///
+/// \param[in] arg unused
+///
+/// \return None
+///
+static void tcache_flush(void *arg) {
+  (void)arg;
+
+  pthread_mutex_lock(&alloc_lock);
+  for (uint16_t i = 0; i < TCACHE_NUM_CLASSES; i++) {
+    uint64_t bytes = class_pages(i) * AIU_PAGESIZE_IN_BYTES;
+    while (tcache_free_list[i]) {
+      alloc_header *header = tcache_free_list[i];
+      tcache_free_list[i] = header->next;
+
+      if (!host_alloc && pool_cached_bytes + bytes <= alloc_cache_bytes) {
+        header->next = pool_free_list[i];
+        pool_free_list[i] = header;
+        pool_cached_bytes += bytes;
+      } else {
+        release_area(header);
+      }
+    }
+    tcache_count[i] = 0;
+  }
+  pthread_mutex_unlock(&alloc_lock);
+}
+
+/// Release every area in the calling thread's cache if zdnn_set_allocator()
+/// was called since the thread last allocated or freed
+///
+/// \return None
+///
+static void tcache_check_generation() {
+  uint32_t generation = __atomic_load_n(&alloc_generation, __ATOMIC_ACQUIRE);
+  if (tcache_generation == generation) {
+    return;
+  }
+
+  for (uint16_t i = 0; i < TCACHE_NUM_CLASSES; i++) {
+    while (tcache_free_list[i]) {
+      alloc_header *header = tcache_free_list[i];
+      tcache_free_list[i] = header->next;
+      release_area(header);
+    }
+    tcache_count[i] = 0;
+  }
+  tcache_generation = generation;
+}
+
+static void tcache_key_create() {
+  pthread_key_create(&tcache_key, tcache_flush);
+}
+
+/// Release every area in the shared pool.  Must be called with alloc_lock
+/// held.
+///
+/// \return None
+///
+static void pool_release_all() {
+  for (uint16_t i = 0; i < POOL_NUM_CLASSES; i++) {
+    while (pool_free_list[i]) {
+      alloc_header *header = pool_free_list[i];
+      pool_free_list[i] = header->next;
+      release_area(header);
+    }
+  }
+  pool_cached_bytes = 0;
+}
+
 /// malloc() that does 4k-alignment
 ///
 /// \param[in] size Size to be malloc'd
@@ -30,32 +314,56 @@
 ///
 void *malloc_aligned_4k(size_t size) {
 
-  // request one more page + size of a pointer from the OS
-  unsigned short extra_allocation =
-      (AIU_PAGESIZE_IN_BYTES - 1) + sizeof(void *);
-
   // make sure size is reasonable
-  if (!size || size > SIZE_MAX) {
+  if (!size || size > SIZE_MAX - 2 * AIU_PAGESIZE_IN_BYTES) {
     return NULL;
   }
 
-  void *ptr = malloc(size + extra_allocation);
-  if (!ptr) {
-    perror("Error during malloc");
-    fprintf(stderr, "errno = %d\n", errno);
-    return ptr;
+  void *aligned_ptr;
+  uint16_t class_idx = POOL_NO_CLASS;
+
+  tcache_check_generation();
+
+  if (!host_alloc && alloc_cache_bytes) {
+    class_idx = size_class(CEIL(size, AIU_PAGESIZE_IN_BYTES));
+  }
+
+  if (class_idx == POOL_NO_CLASS) {
+    aligned_ptr = alloc_area(size, POOL_NO_CLASS);
+    LOG_DEBUG("malloc_aligned_4k() unpooled at %016lx, of size %zu",
+              (uintptr_t)aligned_ptr, size);
+    return aligned_ptr;
   }
 
-  // find the 4k boundary after ptr
-  void *aligned_ptr = (void *)(((uintptr_t)ptr + extra_allocation) &
-                               ~(AIU_PAGESIZE_IN_BYTES - 1));
-  // put the original malloc'd address right before aligned_ptr
-  ((void **)aligned_ptr)[-1] = ptr;
+  if (class_idx < TCACHE_NUM_CLASSES && tcache_free_list[class_idx]) {
+    alloc_header *header = tcache_free_list[class_idx];
+    tcache_free_list[class_idx] = header->next;
+    tcache_count[class_idx]--;
+    LOG_DEBUG("malloc_aligned_4k() thread cache at %016lx, of size %zu",
+              (uintptr_t)AREA_OF(header), size);
+    return AREA_OF(header);
+  }
+
+  uint64_t bytes = class_pages(class_idx) * AIU_PAGESIZE_IN_BYTES;
+
+  pthread_mutex_lock(&alloc_lock);
+  alloc_header *header = pool_free_list[class_idx];
+  if (header) {
+    pool_free_list[class_idx] = header->next;
+    pool_cached_bytes -= bytes;
+  }
+  pthread_mutex_unlock(&alloc_lock);
 
-  LOG_DEBUG("malloc_aligned_4k() malloc() at %016lx, aligned at %016lx, of "
-            "size %zu",
-            (uintptr_t)ptr, (uintptr_t)aligned_ptr, size);
+  if (header) {
+    LOG_DEBUG("malloc_aligned_4k() pool at %016lx, of size %zu",
+              (uintptr_t)AREA_OF(header), size);
+    return AREA_OF(header);
+  }
 
+  aligned_ptr = alloc_area(bytes, class_idx);
+  LOG_DEBUG("malloc_aligned_4k() new at %016lx, of size %zu (class %" PRIu64
+            " bytes)",
+            (uintptr_t)aligned_ptr, size, bytes);
   return aligned_ptr;
 }
 
@@ -66,11 +374,99 @@ void *malloc_aligned_4k(size_t size) {
 /// \return None
 ///
 void free_aligned_4k(void *aligned_ptr) {
-  if (aligned_ptr) {
-    // get the original malloc'd address from where we put it and free it
-    void *original_ptr = ((void **)aligned_ptr)[-1];
-    LOG_DEBUG("free_aligned_4k() aligned_ptr = %016lx original_ptr = %016lx",
-              (uintptr_t)aligned_ptr, (uintptr_t)original_ptr);
-    free(original_ptr);
+  if (!aligned_ptr) {
+    return;
+  }
+
+  alloc_header *header = HEADER_OF(aligned_ptr);
+  uint16_t class_idx = header->class_idx;
+
+  LOG_DEBUG("free_aligned_4k() aligned_ptr = %016lx base = %016lx",
+            (uintptr_t)aligned_ptr, (uintptr_t)header->base);
+
+  tcache_check_generation();
+
+  // areas pooled before a host allocator was installed aren't pooled again
+  if (class_idx == POOL_NO_CLASS || host_alloc) {
+    release_area(header);
+    return;
+  }
+
+  if (class_idx < TCACHE_NUM_CLASSES &&
+      tcache_count[class_idx] < TCACHE_MAX_BLOCKS) {
+    // make sure the cache is flushed when this thread ends
+    pthread_once(&tcache_key_once, tcache_key_create);
+    pthread_setspecific(tcache_key, (void *)1);
+
+    header->next = tcache_free_list[class_idx];
+    tcache_free_list[class_idx] = header;
+    tcache_count[class_idx]++;
+    return;
+  }
+
+  uint64_t bytes = class_pages(class_idx) * AIU_PAGESIZE_IN_BYTES;
+
+  pthread_mutex_lock(&alloc_lock);
+  if (pool_cached_bytes + bytes <= alloc_cache_bytes) {
+    header->next = pool_free_list[class_idx];
+    pool_free_list[class_idx] = header;
+    pool_cached_bytes += bytes;
+    header = NULL;
+  }
+  pthread_mutex_unlock(&alloc_lock);
+
+  if (header) {
+    release_area(header);
+  }
+}
+
+/// Bytes held for reuse by the shared pool and the calling thread's cache
+///
+/// \return number of bytes
+///
+uint64_t get_alloc_cached_bytes(void) {
+  uint64_t bytes = 0;
+  for (uint16_t i = 0; i < TCACHE_NUM_CLASSES; i++) {
+    bytes += tcache_count[i] * class_pages(i) * AIU_PAGESIZE_IN_BYTES;
   }
+
+  pthread_mutex_lock(&alloc_lock);
+  bytes += pool_cached_bytes;
+  pthread_mutex_unlock(&alloc_lock);
+  return bytes;
+}
+
+/// Set the allocator zDNN uses for zTensor buffers, save areas and work areas.
+/// alloc_func must return memory on a 4k boundary.  Areas allocated before the
+/// call are still given back to whatever allocated them, and with a host
+/// allocator are no longer kept for reuse.  Must not be called while other
+/// threads are using zDNN.
+///
+/// \param[in] alloc_func Allocation function, or NULL for the built-in one
+/// \param[in] free_func Matching free function, or NULL for the built-in one
+/// \param[in] user_data Passed to alloc_func and free_func as is
+///
+/// \return None
+///
+void zdnn_set_allocator(zdnn_alloc_func alloc_func, zdnn_free_func free_func,
+                        void *user_data) {
+  pthread_mutex_lock(&alloc_lock);
+
+  if (alloc_func && free_func) {
+    host_alloc = alloc_func;
+    host_free = free_func;
+    host_user_data = user_data;
+    // nothing is pooled while the host allocator is in use
+    pool_release_all();
+  } else {
+    host_alloc = NULL;
+    host_free = NULL;
+    host_user_data = NULL;
+  }
+  __atomic_add_fetch(&alloc_generation, 1, __ATOMIC_RELEASE);
+
+  pthread_mutex_unlock(&alloc_lock);
+
+  // other threads drain their caches on their next allocation or free
+  tcache_check_generation();
 }
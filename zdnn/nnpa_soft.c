@@ -0,0 +1,1298 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Software NNPA backend.  Interprets an nnpa_parameter_block on the host CPU,
+ * reading and writing the tensors directly in their 4DFEATURE, 4DKERNEL,
+ * 4DWEIGHTS and 4DGENERIC layouts, so that everything above invoke_nnpa()
+ * runs unchanged.  Selected with ZDNN_BACKEND=soft (see zdnn_init()).
+ */
+
+#include <float.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "convert.h"
+#include "version.h"
+#include "zdnn.h"
+#include "zdnn_private.h"
+
+// rows of output handled per parallel chunk are sized to cover about this many
+// elements
+#define SOFT_ELEMENTS_PER_CHUNK 8192
+// rows of output computed together by one matmul task
+#define SOFT_MATMUL_ROW_BLOCK 32
+
+// -----------------------------------------------------------------------------
+// DLFLOAT16 scalar conversion
+// -----------------------------------------------------------------------------
+
+/// Convert one DLFLOAT16 value to FP32.  NINF becomes a NaN.
+///
+/// \param[in] d DLFLOAT16 bits
+///
+/// \return FP32 value
+///
+static inline float soft_dlf16_to_fp32(uint16_t d) {
+  uint32_float_u x;
+  uint32_t sign = (uint32_t)(d & DLF16_SIGN_MASK) << 16;
+  uint32_t mag = d & ~DLF16_SIGN_MASK;
+
+  if (mag == DLF16_NINF) {
+    x.u = sign | 0x7FC00000;
+  } else if (mag == 0) {
+    x.u = sign;
+  } else {
+    // DLFLOAT16 has no subnormals, exponent 0 is still a normal number
+    x.u = sign | ((mag >> 9) + FP32_EXP_BIAS - DLF16_EXP_BIAS) << 23 |
+          (mag & 0x1FF) << 14;
+  }
+  return x.f;
+}
+
+/// Convert one FP32 value to DLFLOAT16, rounding to nearest with ties away
+/// from zero.  Values too small for DLFLOAT16 become zero.
+///
+/// \param[in] f FP32 value
+/// \param[in] saturate if true, finite overflow clamps to the largest
+///                     finite DLFLOAT16 instead of producing NINF
+/// \param[out] range_violation set to true when NINF is produced
+///
+/// \return DLFLOAT16 bits
+///
+static inline uint16_t soft_fp32_to_dlf16(float f, bool saturate,
+                                          bool *range_violation) {
+  uint32_float_u x = {.f = f};
+  uint16_t sign = (x.u >> 16) & DLF16_SIGN_MASK;
+  uint32_t mag = x.u & 0x7FFFFFFF;
+
+  if (mag >= 0x7F800000) { // NaN or infinity, never saturated
+    *range_violation = true;
+    return sign | DLF16_NINF;
+  }
+
+  mag += 1 << 13; // round the 14 dropped mantissa bits
+  int32_t exp = (int32_t)(mag >> 23) - FP32_EXP_BIAS + DLF16_EXP_BIAS;
+  uint16_t frac = (mag >> 14) & 0x1FF;
+
+  if (exp < 0) {
+    return sign;
+  }
+  if (exp > 63 || (exp << 9 | frac) > DLF16_MAX_BITS) {
+    if (saturate) {
+      return sign | DLF16_MAX_BITS;
+    }
+    *range_violation = true;
+    return sign | DLF16_NINF;
+  }
+  return sign | (uint16_t)(exp << 9) | frac;
+}
+
+// -----------------------------------------------------------------------------
+// Tensor access
+// -----------------------------------------------------------------------------
+
+// A tensor descriptor from the parameter block, with the byte strides needed
+// to find any (dim4, dim3, dim2) row and the dim1 cells within it.
+typedef struct soft_tensor {
+  uint8_t *data;
+  uint8_t format;
+  uint8_t type;
+  uint32_t dim4;
+  uint32_t dim3;
+  uint32_t dim2;
+  uint32_t dim1;
+  uint32_t cells;      // dim1 elements per stick
+  uint32_t cell_step;  // bytes between neighbouring dim1 elements in a stick
+  uint64_t stride4;    // bytes between dim4 indices
+  uint64_t stride3;    // bytes between dim3 indices
+  uint64_t stride2;    // bytes between dim2 indices (pairs for 4DWEIGHTS)
+  uint64_t stride1;    // bytes between dim1 stick groups
+} soft_tensor;
+
+static void init_soft_tensor(soft_tensor *t,
+                             const nnpa_tensor_descriptor *desc) {
+  t->data = (uint8_t *)desc->tensor_data_addr;
+  t->format = desc->data_layout_format;
+  t->type = desc->data_type;
+  t->dim4 = desc->dim4_index_size;
+  t->dim3 = desc->dim3_index_size;
+  t->dim2 = desc->dim2_index_size;
+  t->dim1 = desc->dim1_index_size;
+
+  uint32_t elem_size;
+  switch (t->type) {
+  case NNPA_8_BIT_BINARY_INT:
+    elem_size = AIU_1BYTE_CELL_SIZE;
+    break;
+  case NNPA_32_BIT_BINARY_INT:
+  case NNPA_32_BIT_BINARY_FP_SHORT:
+    elem_size = AIU_4BYTE_CELL_SIZE;
+    break;
+  default:
+    elem_size = AIU_2BYTE_CELL_SIZE;
+    break;
+  }
+
+  if (t->format == NNPA_LAYOUTFMT_4DGENERIC) {
+    // plain NHWC, each row of dim1 elements is contiguous
+    t->cells = t->dim1 ? t->dim1 : 1;
+    t->cell_step = elem_size;
+    t->stride2 = (uint64_t)t->dim1 * elem_size;
+    t->stride3 = t->dim2 * t->stride2;
+    t->stride4 = t->dim3 * t->stride3;
+    t->stride1 = 0;
+    return;
+  }
+
+  uint64_t sticks_per_dim3 = t->dim2;
+  t->cells = AIU_BYTES_PER_STICK / elem_size;
+  t->cell_step = elem_size;
+  t->stride2 = AIU_BYTES_PER_STICK;
+
+  if (t->format == NNPA_LAYOUTFMT_4DWEIGHTS) {
+    // two dim2 rows are byte-interleaved within each stick
+    sticks_per_dim3 = CEIL(t->dim2, 2);
+    t->cells = AIU_2BYTE_CELLS_PER_STICK;
+    t->cell_step = AIU_2BYTE_CELL_SIZE;
+  }
+
+  t->stride3 =
+      CEIL(sticks_per_dim3, AIU_STICKS_PER_PAGE) * AIU_PAGESIZE_IN_BYTES;
+
+  if (t->format == NNPA_LAYOUTFMT_4DKERNEL) {
+    // dim1 stick groups are outermost
+    t->stride4 = t->dim3 * t->stride3;
+    t->stride1 = t->dim4 * t->stride4;
+  } else {
+    t->stride1 = t->dim3 * t->stride3;
+    t->stride4 = CEIL(t->dim1, t->cells) * t->stride1;
+  }
+}
+
+/// Address of element 0 of the dim1 row at (n, h, w).  Indices are clamped to
+/// 0 in any dimension of size 1 so that broadcast operands can be read with
+/// the output's indices.
+static inline uint8_t *row_addr(const soft_tensor *t, uint32_t n, uint32_t h,
+                                uint32_t w) {
+  n = (t->dim4 == 1) ? 0 : n;
+  h = (t->dim3 == 1) ? 0 : h;
+  w = (t->dim2 == 1) ? 0 : w;
+
+  uint8_t *addr = t->data + n * t->stride4 + h * t->stride3;
+  if (t->format == NNPA_LAYOUTFMT_4DWEIGHTS) {
+    return addr + (w / 2) * t->stride2 + (w & 1);
+  }
+  return addr + w * t->stride2;
+}
+
+/// Load the dim1 row at (n, h, w) as FP32 (integer types are converted
+/// exactly).
+static void load_row(const soft_tensor *t, uint32_t n, uint32_t h, uint32_t w,
+                     float *out) {
+  uint8_t *row = row_addr(t, n, h, w);
+
+  for (uint32_t c = 0; c < t->dim1; c += t->cells) {
+    uint8_t *stick = row + (c / t->cells) * t->stride1;
+    uint32_t cnt = MIN(t->cells, t->dim1 - c);
+    float *dst = out + c;
+
+    switch (t->type) {
+    case NNPA_DATATYPE_1: {
+      const uint16_t *src = (const uint16_t *)stick;
+      for (uint32_t i = 0; i < cnt; i++) {
+        dst[i] = soft_dlf16_to_fp32(STICK_CELL16(src[i]));
+      }
+      break;
+    }
+    case NNPA_32_BIT_BINARY_FP_SHORT:
+      memcpy(dst, stick, cnt * sizeof(float));
+      break;
+    case NNPA_8_BIT_BINARY_INT:
+      for (uint32_t i = 0; i < cnt; i++) {
+        dst[i] = (float)(int8_t)stick[i * t->cell_step];
+      }
+      break;
+    case NNPA_32_BIT_BINARY_INT: {
+      const int32_t *src = (const int32_t *)stick;
+      for (uint32_t i = 0; i < cnt; i++) {
+        dst[i] = (float)src[i];
+      }
+      break;
+    }
+    }
+  }
+}
+
+/// Load the dim1 row at (n, h, w) of an INT8 tensor without conversion.
+static void load_row_int8(const soft_tensor *t, uint32_t n, uint32_t h,
+                          uint32_t w, int8_t *out) {
+  uint8_t *row = row_addr(t, n, h, w);
+
+  for (uint32_t c = 0; c < t->dim1; c += t->cells) {
+    uint8_t *stick = row + (c / t->cells) * t->stride1;
+    uint32_t cnt = MIN(t->cells, t->dim1 - c);
+    for (uint32_t i = 0; i < cnt; i++) {
+      out[c + i] = (int8_t)stick[i * t->cell_step];
+    }
+  }
+}
+
+/// Store an FP32 row into the dim1 row at (n, h, w), converting to the
+/// tensor's data type.
+///
+/// \return true if any element had to be stored as NINF (NaN for FP32)
+///
+static bool store_row(const soft_tensor *t, uint32_t n, uint32_t h, uint32_t w,
+                      const float *in, bool saturate) {
+  uint8_t *row = row_addr(t, n, h, w);
+  bool range_violation = false;
+
+  for (uint32_t c = 0; c < t->dim1; c += t->cells) {
+    uint8_t *stick = row + (c / t->cells) * t->stride1;
+    uint32_t cnt = MIN(t->cells, t->dim1 - c);
+    const float *src = in + c;
+
+    switch (t->type) {
+    case NNPA_DATATYPE_1: {
+      uint16_t *dst = (uint16_t *)stick;
+      for (uint32_t i = 0; i < cnt; i++) {
+        dst[i] = STICK_CELL16(
+            soft_fp32_to_dlf16(src[i], saturate, &range_violation));
+      }
+      break;
+    }
+    case NNPA_32_BIT_BINARY_FP_SHORT:
+      memcpy(stick, src, cnt * sizeof(float));
+      // NaN is how an NINF input comes out in FP32
+      for (uint32_t i = 0; i < cnt; i++) {
+        range_violation |= isnan(src[i]);
+      }
+      break;
+    case NNPA_8_BIT_BINARY_INT:
+      for (uint32_t i = 0; i < cnt; i++) {
+        stick[i * t->cell_step] =
+            (uint8_t)(int8_t)MIN(MAX(src[i], INT8_MIN_AS_FP32),
+                                 INT8_MAX_AS_FP32);
+      }
+      break;
+    case NNPA_32_BIT_BINARY_INT: {
+      int32_t *dst = (int32_t *)stick;
+      for (uint32_t i = 0; i < cnt; i++) {
+        dst[i] = (int32_t)src[i];
+      }
+      break;
+    }
+    }
+  }
+  return range_violation;
+}
+
+// -----------------------------------------------------------------------------
+// Operation context
+// -----------------------------------------------------------------------------
+
+typedef struct soft_op {
+  uint8_t function_code;
+  const function_specific_parameters *fsp;
+  soft_tensor in1;
+  soft_tensor in2;
+  soft_tensor in3;
+  soft_tensor out1;
+  soft_tensor out2;
+  // set by workers, only ever changed from false to true
+  volatile bool range_violation;
+  volatile bool alloc_failure;
+  // operation specific data shared by all workers (read-only once built)
+  void *shared;
+} soft_op;
+
+static inline float dlf16_parm(uint32_t bits) {
+  return soft_dlf16_to_fp32((uint16_t)bits);
+}
+
+static inline float sigmoidf(float x) { return 1.0f / (1.0f + expf(-x)); }
+
+/// Number of output rows handled per chunk for rows of row_len elements.
+static inline uint64_t rows_per_chunk(uint32_t row_len) {
+  return MAX(1, SOFT_ELEMENTS_PER_CHUNK / MAX(row_len, 1));
+}
+
+// -----------------------------------------------------------------------------
+// Row-wise operations: elementwise, activations, normalizations, reduce and
+// transform.  Each output (dim4, dim3, dim2) row is computed from the inputs'
+// rows at the same indices.
+// -----------------------------------------------------------------------------
+
+static void compute_row(const soft_op *op, const float *a, const float *b,
+                        const float *c, float *y) {
+  const uint32_t len = op->in1.dim1;
+
+  switch (op->function_code) {
+  case NNPA_ADD:
+    for (uint32_t i = 0; i < len; i++)
+      y[i] = a[i] + b[i];
+    break;
+  case NNPA_SUB:
+    for (uint32_t i = 0; i < len; i++)
+      y[i] = a[i] - b[i];
+    break;
+  case NNPA_MUL:
+    for (uint32_t i = 0; i < len; i++)
+      y[i] = a[i] * b[i];
+    break;
+  case NNPA_DIV:
+    for (uint32_t i = 0; i < len; i++)
+      y[i] = a[i] / b[i];
+    break;
+  case NNPA_MIN:
+    for (uint32_t i = 0; i < len; i++)
+      y[i] = (a[i] < b[i]) ? a[i] : b[i];
+    break;
+  case NNPA_MAX:
+    for (uint32_t i = 0; i < len; i++)
+      y[i] = (a[i] > b[i]) ? a[i] : b[i];
+    break;
+  case NNPA_LOG:
+    for (uint32_t i = 0; i < len; i++)
+      y[i] = logf(a[i]);
+    break;
+  case NNPA_EXP:
+    for (uint32_t i = 0; i < len; i++)
+      y[i] = expf(a[i]);
+    break;
+  case NNPA_SQRT:
+    for (uint32_t i = 0; i < len; i++)
+      y[i] = sqrtf(a[i]);
+    break;
+  case NNPA_INVSQRT: {
+    const func_sp_parms_invsqrt *p = (const func_sp_parms_invsqrt *)op->fsp;
+    float eps = dlf16_parm(p->parm1.epsilon);
+    for (uint32_t i = 0; i < len; i++)
+      y[i] = 1.0f / sqrtf(a[i] + eps);
+    break;
+  }
+  case NNPA_RELU: {
+    const func_sp_parms_relu *p = (const func_sp_parms_relu *)op->fsp;
+    float clip = dlf16_parm(p->parm1.clipping_value);
+    float adj = dlf16_parm(p->parm2.adjustment_factor);
+    for (uint32_t i = 0; i < len; i++) {
+      float v = (a[i] > 0) ? a[i] : a[i] * adj;
+      y[i] = (clip > 0 && v > clip) ? clip : v;
+    }
+    break;
+  }
+  case NNPA_TANH:
+    for (uint32_t i = 0; i < len; i++)
+      y[i] = tanhf(a[i]);
+    break;
+  case NNPA_SIGMOID:
+    for (uint32_t i = 0; i < len; i++)
+      y[i] = sigmoidf(a[i]);
+    break;
+  case NNPA_GELU:
+    for (uint32_t i = 0; i < len; i++)
+      y[i] = 0.5f * a[i] *
+             (1.0f + tanhf(0.7978845608f * a[i] *
+                           (1.0f + 0.044715f * a[i] * a[i])));
+    break;
+  case NNPA_SOFTMAX: {
+    const func_sp_parms_softmax *p = (const func_sp_parms_softmax *)op->fsp;
+    uint32_t mask = p->parm2.mask ? MIN(p->parm2.mask, len) : len;
+    float max = -FLT_MAX, sum = 0;
+    for (uint32_t i = 0; i < mask; i++)
+      max = (a[i] > max) ? a[i] : max;
+    for (uint32_t i = 0; i < mask; i++) {
+      y[i] = expf(a[i] - max);
+      sum += y[i];
+    }
+    for (uint32_t i = 0; i < mask; i++)
+      y[i] = (p->parm1.act == NNPA_SOFTMAX_LOG) ? (a[i] - max) - logf(sum)
+                                                 : y[i] / sum;
+    for (uint32_t i = mask; i < len; i++)
+      y[i] = 0;
+    break;
+  }
+  case NNPA_BATCHNORMALIZATION:
+    for (uint32_t i = 0; i < len; i++)
+      y[i] = a[i] * b[i] + c[i];
+    break;
+  case NNPA_LAYERNORM: {
+    const func_sp_parms_layernorm *p =
+        (const func_sp_parms_layernorm *)op->fsp;
+    float beta = dlf16_parm(p->parm1.beta);
+    float gamma = dlf16_parm(p->parm2.gamma);
+    float eps = dlf16_parm(p->parm3.epsilon);
+    // input_b (mean) and input_c (variance) have dim1 of 1
+    float scale = gamma / sqrtf(c[0] + eps);
+    for (uint32_t i = 0; i < len; i++)
+      y[i] = (a[i] - b[0]) * scale + beta;
+    break;
+  }
+  case NNPA_NORM: {
+    float sum = 0;
+    for (uint32_t i = 0; i < len; i++)
+      sum += (a[i] - b[i]) * (a[i] - b[i]);
+    y[0] = sqrtf(sum);
+    break;
+  }
+  case NNPA_REDUCE: {
+    const func_sp_parms_reduce *p = (const func_sp_parms_reduce *)op->fsp;
+    bool find_min = p->parm1.operation == NNPA_REDUCE_OP_MINIMUM ||
+                    p->parm1.operation == NNPA_REDUCE_OP_MINIMUM_IDX;
+    uint32_t idx = 0;
+    for (uint32_t i = 1; i < len; i++) {
+      if (find_min ? (a[i] < a[idx]) : (a[i] > a[idx]))
+        idx = i;
+    }
+    y[0] = (p->parm1.operation == NNPA_REDUCE_OP_MINIMUM_IDX ||
+            p->parm1.operation == NNPA_REDUCE_OP_MAXIMUM_IDX)
+               ? (float)idx
+               : a[idx];
+    break;
+  }
+  case NNPA_TRANSFORM: {
+    const func_sp_parms_transform *p =
+        (const func_sp_parms_transform *)op->fsp;
+    if (p->parm1.toc == NNPA_TOC_STICK_INT8) {
+      float rec_scale = dlf16_parm(p->parm2.rec_scale);
+      float offset = dlf16_parm(p->parm3.offset);
+      float lo = (float)(int8_t)p->parm4.clip_min;
+      float hi = (float)(int8_t)p->parm5.clip_max;
+      for (uint32_t i = 0; i < len; i++) {
+        float q = rintf(a[i] * rec_scale + offset);
+        y[i] = (q < lo) ? lo : ((q > hi) ? hi : q);
+      }
+    } else {
+      memcpy(y, a, len * sizeof(float));
+    }
+    break;
+  }
+  }
+}
+
+static void rowwise_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  soft_op *op = (soft_op *)ctx;
+  const soft_tensor *out = &op->out1;
+  uint32_t len = MAX(op->in1.dim1, out->dim1);
+
+  float *scratch = malloc(4 * (size_t)len * sizeof(float));
+  if (!scratch) {
+    op->alloc_failure = true;
+    return;
+  }
+  float *a = scratch, *b = a + len, *c = b + len, *y = c + len;
+
+  bool saturate = false;
+  if (op->function_code == NNPA_TRANSFORM) {
+    saturate = ((const func_sp_parms_transform *)op->fsp)->parm1.sc;
+  }
+
+  for (uint64_t r = begin; r < end; r++) {
+    uint32_t w = r % out->dim2;
+    uint32_t h = (r / out->dim2) % out->dim3;
+    uint32_t n = r / ((uint64_t)out->dim2 * out->dim3);
+
+    load_row(&op->in1, n, h, w, a);
+    if (op->in2.data) {
+      load_row(&op->in2, n, h, w, b);
+    }
+    if (op->in3.data) {
+      load_row(&op->in3, n, h, w, c);
+    }
+    compute_row(op, a, b, c, y);
+    if (store_row(out, n, h, w, y, saturate)) {
+      op->range_violation = true;
+    }
+  }
+  free(scratch);
+}
+
+// -----------------------------------------------------------------------------
+// NNPA-MOMENTS: per dim4 mean and variance over all other dimensions
+// -----------------------------------------------------------------------------
+
+static void moments_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  soft_op *op = (soft_op *)ctx;
+  const soft_tensor *in = &op->in1;
+  uint32_t bessel =
+      ((const func_sp_parms_moments *)op->fsp)->parm1.bessel_correction;
+
+  float *a = malloc((size_t)in->dim1 * sizeof(float));
+  if (!a) {
+    op->alloc_failure = true;
+    return;
+  }
+
+  for (uint64_t n = begin; n < end; n++) {
+    double sum = 0, sum_sq = 0;
+    for (uint32_t h = 0; h < in->dim3; h++) {
+      for (uint32_t w = 0; w < in->dim2; w++) {
+        load_row(in, n, h, w, a);
+        for (uint32_t i = 0; i < in->dim1; i++) {
+          sum += a[i];
+          sum_sq += (double)a[i] * a[i];
+        }
+      }
+    }
+    double count = (double)in->dim3 * in->dim2 * in->dim1;
+    float mean = (float)(sum / count);
+    float var = (float)((sum_sq - sum * sum / count) / (count - bessel));
+
+    if (store_row(&op->out1, n, 0, 0, &mean, false) |
+        store_row(&op->out2, n, 0, 0, &var, false)) {
+      op->range_violation = true;
+    }
+  }
+  free(a);
+}
+
+// -----------------------------------------------------------------------------
+// NNPA-LSTMACT / NNPA-GRUACT: one timestep of gate activations
+// -----------------------------------------------------------------------------
+
+static void rnn_act_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  soft_op *op = (soft_op *)ctx;
+  uint32_t len = op->out1.dim1;
+  uint32_t gates = (op->function_code == NNPA_LSTMACT) ? 4 : 3;
+
+  float *scratch = malloc((2 * gates + 3) * (size_t)len * sizeof(float));
+  if (!scratch) {
+    op->alloc_failure = true;
+    return;
+  }
+  float *x = scratch, *hid = x + gates * len, *prev = hid + gates * len,
+        *y1 = prev + len, *y2 = y1 + len;
+
+  bool violation = false;
+  for (uint64_t w = begin; w < end; w++) {
+    for (uint32_t g = 0; g < gates; g++) {
+      load_row(&op->in1, g, 0, w, x + g * len);
+      load_row(&op->in2, g, 0, w, hid + g * len);
+    }
+    load_row(&op->in3, 0, 0, w, prev);
+
+    if (op->function_code == NNPA_LSTMACT) {
+      // gates in FICO order, input_b holds the bias-added hidden projection
+      for (uint32_t i = 0; i < len; i++) {
+        float f = sigmoidf(x[i] + hid[i]);
+        float in = sigmoidf(x[len + i] + hid[len + i]);
+        float cand = tanhf(x[2 * len + i] + hid[2 * len + i]);
+        float o = sigmoidf(x[3 * len + i] + hid[3 * len + i]);
+        y2[i] = f * prev[i] + in * cand;
+        y1[i] = o * tanhf(y2[i]);
+      }
+      violation |= store_row(&op->out2, 0, 0, w, y2, false);
+    } else {
+      // gates in ZRH order
+      for (uint32_t i = 0; i < len; i++) {
+        float z = sigmoidf(x[i] + hid[i]);
+        float r = sigmoidf(x[len + i] + hid[len + i]);
+        float cand = tanhf(x[2 * len + i] + r * hid[2 * len + i]);
+        y1[i] = (1.0f - z) * cand + z * prev[i];
+      }
+    }
+    violation |= store_row(&op->out1, 0, 0, w, y1, false);
+  }
+  if (violation) {
+    op->range_violation = true;
+  }
+  free(scratch);
+}
+
+// -----------------------------------------------------------------------------
+// NNPA-AVGPOOL2D / NNPA-MAXPOOL2D
+// -----------------------------------------------------------------------------
+
+/// Compute the leading padding for one spatial dimension.  SAME padding splits
+/// the total evenly with the extra element (if any) on the trailing side.
+static inline int64_t leading_pad(uint32_t pad_type, uint32_t in, uint32_t out,
+                                  uint32_t stride, uint32_t window) {
+  if (pad_type != SAME_PADDING) {
+    return 0;
+  }
+  int64_t total = (int64_t)(out - 1) * stride + window - in;
+  return (total > 0) ? total / 2 : 0;
+}
+
+static void pool_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  soft_op *op = (soft_op *)ctx;
+  const soft_tensor *in = &op->in1, *out = &op->out1;
+  const func_sp_parms_pool2d *p = (const func_sp_parms_pool2d *)op->fsp;
+  uint32_t len = in->dim1;
+
+  // zero strides mean the window covers the whole input
+  uint32_t sw = p->parm2.stride_width ? p->parm2.stride_width : 1;
+  uint32_t sh = p->parm3.stride_height ? p->parm3.stride_height : 1;
+  uint32_t kw = p->parm4.kernel_width, kh = p->parm5.kernel_height;
+  int64_t pad_w = leading_pad(p->parm1.pad, in->dim2, out->dim2, sw, kw);
+  int64_t pad_h = leading_pad(p->parm1.pad, in->dim3, out->dim3, sh, kh);
+  bool is_max = op->function_code == NNPA_MAXPOOL2D;
+
+  float *scratch = malloc(2 * (size_t)len * sizeof(float));
+  if (!scratch) {
+    op->alloc_failure = true;
+    return;
+  }
+  float *a = scratch, *y = a + len;
+
+  bool violation = false;
+  for (uint64_t r = begin; r < end; r++) {
+    uint32_t oh = r % out->dim3;
+    uint32_t n = r / out->dim3;
+
+    for (uint32_t ow = 0; ow < out->dim2; ow++) {
+      uint32_t count = 0;
+      for (uint32_t i = 0; i < len; i++)
+        y[i] = is_max ? -FLT_MAX : 0;
+
+      for (uint32_t ky = 0; ky < kh; ky++) {
+        int64_t ih = (int64_t)oh * sh + ky - pad_h;
+        if (ih < 0 || ih >= in->dim3)
+          continue;
+        for (uint32_t kx = 0; kx < kw; kx++) {
+          int64_t iw = (int64_t)ow * sw + kx - pad_w;
+          if (iw < 0 || iw >= in->dim2)
+            continue;
+          load_row(in, n, ih, iw, a);
+          count++;
+          if (is_max) {
+            for (uint32_t i = 0; i < len; i++)
+              y[i] = (a[i] > y[i]) ? a[i] : y[i];
+          } else {
+            for (uint32_t i = 0; i < len; i++)
+              y[i] += a[i];
+          }
+        }
+      }
+      if (!is_max && count) {
+        // padding elements are not counted in the average
+        for (uint32_t i = 0; i < len; i++)
+          y[i] /= count;
+      }
+      violation |= store_row(out, n, oh, ow, y, false);
+    }
+  }
+  if (violation) {
+    op->range_violation = true;
+  }
+  free(scratch);
+}
+
+// -----------------------------------------------------------------------------
+// NNPA-CONVOLUTION: NHWC input, HWCK kernel, (1, 1, 1, K) bias
+// -----------------------------------------------------------------------------
+
+static void unpack_kernel_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  soft_op *op = (soft_op *)ctx;
+  const soft_tensor *k = &op->in2;
+  float *kernel = (float *)op->shared;
+
+  // row r is (kh, kw, c) of the HWCK kernel, K elements each
+  for (uint64_t r = begin; r < end; r++) {
+    uint32_t c = r % k->dim2;
+    uint32_t kw = (r / k->dim2) % k->dim3;
+    uint32_t kh = r / ((uint64_t)k->dim2 * k->dim3);
+    load_row(k, kh, kw, c, kernel + r * k->dim1);
+  }
+}
+
+static void conv_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  soft_op *op = (soft_op *)ctx;
+  const soft_tensor *in = &op->in1, *out = &op->out1;
+  const func_sp_parms_conv2d *p = (const func_sp_parms_conv2d *)op->fsp;
+  const float *kernel = (const float *)op->shared;
+
+  uint32_t kh = op->in2.dim4, kw = op->in2.dim3;
+  uint32_t chans = in->dim1, k_out = out->dim1;
+  uint32_t sw = p->parm2.stride_width ? p->parm2.stride_width : 1;
+  uint32_t sh = p->parm3.stride_height ? p->parm3.stride_height : 1;
+  int64_t pad_w = leading_pad(p->parm1.pad, in->dim2, out->dim2, sw, kw);
+  int64_t pad_h = leading_pad(p->parm1.pad, in->dim3, out->dim3, sh, kh);
+  float clip = dlf16_parm(p->parm4.clipping_value);
+
+  float *scratch = malloc(((size_t)chans + 2 * k_out) * sizeof(float));
+  if (!scratch) {
+    op->alloc_failure = true;
+    return;
+  }
+  float *x = scratch, *bias = x + chans, *y = bias + k_out;
+  load_row(&op->in3, 0, 0, 0, bias);
+
+  bool violation = false;
+  for (uint64_t r = begin; r < end; r++) {
+    uint32_t oh = r % out->dim3;
+    uint32_t n = r / out->dim3;
+
+    for (uint32_t ow = 0; ow < out->dim2; ow++) {
+      memcpy(y, bias, k_out * sizeof(float));
+
+      for (uint32_t ky = 0; ky < kh; ky++) {
+        int64_t ih = (int64_t)oh * sh + ky - pad_h;
+        if (ih < 0 || ih >= in->dim3)
+          continue;
+        for (uint32_t kx = 0; kx < kw; kx++) {
+          int64_t iw = (int64_t)ow * sw + kx - pad_w;
+          if (iw < 0 || iw >= in->dim2)
+            continue;
+          load_row(in, n, ih, iw, x);
+          const float *wk = kernel + ((uint64_t)ky * kw + kx) * chans * k_out;
+          for (uint32_t c = 0; c < chans; c++) {
+            const float xv = x[c];
+            const float *wrow = wk + (uint64_t)c * k_out;
+            for (uint32_t i = 0; i < k_out; i++)
+              y[i] += xv * wrow[i];
+          }
+        }
+      }
+      if (p->parm1.act == CONV2D_ACT_RELU) {
+        for (uint32_t i = 0; i < k_out; i++) {
+          float v = (y[i] > 0) ? y[i] : 0;
+          y[i] = (clip > 0 && v > clip) ? clip : v;
+        }
+      }
+      violation |= store_row(out, n, oh, ow, y, false);
+    }
+  }
+  if (violation) {
+    op->range_violation = true;
+  }
+  free(scratch);
+}
+
+// -----------------------------------------------------------------------------
+// NNPA-MATMUL-OP / -BCAST23 / -BCAST1, including the quantized forms where
+// input_b is INT8 4DWEIGHTS.
+//
+//   A: (S, 1, M, N), or (S, 1, N, M) when transpose_a
+//   B: (S, 1, N, P), or (S, 1, P, N) when transpose_b
+//   C: (S, 1, 1, P)
+//   Y: (S, 1, M, P)
+//
+// A and B are first unpacked into row-major matrices (FP32, or INT8 for the
+// quantized forms), then Y is computed in blocks of SOFT_MATMUL_ROW_BLOCK rows.
+// -----------------------------------------------------------------------------
+
+typedef struct soft_matmul {
+  bool transpose_a;
+  bool transpose_b;
+  bool quantized;
+  uint32_t m, n, p;
+  // quantized only
+  float rec_scale_a;
+  float offset_a;
+  int8_t clip_min;
+  int8_t clip_max;
+  float scale_y; // M = rec_scale_y / (rec_scale_a * rec_scale_b)
+  // unpacked A and B, float or int8_t elements
+  void *a;
+  void *b;
+} soft_matmul;
+
+/// Scale from the INT32 accumulator to the output,
+/// M = rec_scale_y / (rec_scale_a * rec_scale_b)
+static inline float quantized_matmul_scale(const func_sp_parms_matmul *p) {
+  return dlf16_parm(p->parm7.rec_scale) /
+         (dlf16_parm(p->parm3.rec_scale) * dlf16_parm(p->parm5.rec_scale));
+}
+
+// unpack one stored row of input_a or input_b into the row-major matrix
+static void unpack_matmul_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  soft_op *op = (soft_op *)ctx;
+  const soft_matmul *mm = (const soft_matmul *)op->shared;
+
+  // rows [0, rows_a) belong to input_a, the rest to input_b
+  uint64_t rows_a = (uint64_t)op->in1.dim4 * op->in1.dim2;
+  uint32_t len = MAX(op->in1.dim1, op->in2.dim1);
+
+  float *tmp = malloc((size_t)len * sizeof(float));
+  if (!tmp) {
+    op->alloc_failure = true;
+    return;
+  }
+
+  for (uint64_t r = begin; r < end; r++) {
+    bool is_a = r < rows_a;
+    const soft_tensor *t = is_a ? &op->in1 : &op->in2;
+    uint64_t rr = is_a ? r : r - rows_a;
+    uint32_t s = rr / t->dim2, row = rr % t->dim2;
+    bool transposed = is_a ? mm->transpose_a : mm->transpose_b;
+    // logical matrix is rows x cols, stored as either that or its transpose
+    uint32_t cols = is_a ? mm->n : mm->p;
+    uint64_t base = (uint64_t)s * (is_a ? mm->m : mm->n) * cols;
+
+    if (mm->quantized) {
+      int8_t *dst = (int8_t *)(is_a ? mm->a : mm->b);
+      if (t->type == NNPA_8_BIT_BINARY_INT) {
+        load_row_int8(t, s, 0, row, (int8_t *)tmp);
+      } else {
+        // on-the-fly quantization of a DLFLOAT16 input_a
+        load_row(t, s, 0, row, tmp);
+        for (uint32_t i = 0; i < t->dim1; i++) {
+          float q = rintf(tmp[i] * mm->rec_scale_a + mm->offset_a);
+          q = (q < mm->clip_min) ? mm->clip_min : q;
+          q = (q > mm->clip_max) ? mm->clip_max : q;
+          ((int8_t *)tmp)[i] = (int8_t)q;
+        }
+      }
+      for (uint32_t i = 0; i < t->dim1; i++) {
+        uint64_t idx = transposed ? base + (uint64_t)i * cols + row
+                                  : base + (uint64_t)row * cols + i;
+        dst[idx] = ((int8_t *)tmp)[i];
+      }
+    } else {
+      float *dst = (float *)(is_a ? mm->a : mm->b);
+      if (transposed) {
+        load_row(t, s, 0, row, tmp);
+        for (uint32_t i = 0; i < t->dim1; i++)
+          dst[base + (uint64_t)i * cols + row] = tmp[i];
+      } else {
+        load_row(t, s, 0, row, dst + base + (uint64_t)row * cols);
+      }
+    }
+  }
+  free(tmp);
+}
+
+static inline float matmul_apply_op(uint32_t operation, float dot, float c) {
+  switch (operation) {
+  case NNPA_MATMUL_OP_COMP_HIGH:
+    return dot > c;
+  case NNPA_MATMUL_OP_COMP_NOT_LOW:
+    return dot >= c;
+  case NNPA_MATMUL_OP_COMP_EQUAL:
+    return dot == c;
+  case NNPA_MATMUL_OP_COMP_NOT_EQUAL:
+    return dot != c;
+  case NNPA_MATMUL_OP_COMP_NOT_HIGH:
+    return dot <= c;
+  case NNPA_MATMUL_OP_COMP_LOW:
+    return dot < c;
+  default:
+    return dot + c;
+  }
+}
+
+static void matmul_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  soft_op *op = (soft_op *)ctx;
+  const soft_matmul *mm = (const soft_matmul *)op->shared;
+  const uint32_t m = mm->m, n = mm->n, p = mm->p;
+  const uint64_t blocks_per_stack = CEIL(m, SOFT_MATMUL_ROW_BLOCK);
+  // operation is in the same bit position for all matmul function codes
+  uint32_t operation = ((const func_sp_parms_matmul *)op->fsp)->parm1.operation;
+
+  float *scratch = malloc(2 * (size_t)p * sizeof(float) +
+                          (size_t)p * sizeof(int32_t));
+  if (!scratch) {
+    op->alloc_failure = true;
+    return;
+  }
+  float *c = scratch, *y = c + p;
+  int32_t *acc = (int32_t *)(y + p);
+
+  bool violation = false;
+  for (uint64_t task = begin; task < end; task++) {
+    uint32_t s = task / blocks_per_stack;
+    uint32_t m_begin = (task % blocks_per_stack) * SOFT_MATMUL_ROW_BLOCK;
+    uint32_t m_end = MIN(m_begin + SOFT_MATMUL_ROW_BLOCK, m);
+    uint32_t sa = (op->in1.dim4 == 1) ? 0 : s;
+    uint32_t sb = (op->in2.dim4 == 1) ? 0 : s;
+
+    load_row(&op->in3, s, 0, 0, c);
+
+    for (uint32_t row = m_begin; row < m_end; row++) {
+      if (mm->quantized) {
+        const int8_t *a = (const int8_t *)mm->a + ((uint64_t)sa * m + row) * n;
+        const int8_t *b = (const int8_t *)mm->b + (uint64_t)sb * n * p;
+        memset(acc, 0, p * sizeof(int32_t));
+        for (uint32_t k = 0; k < n; k++) {
+          const int32_t av = a[k];
+          const int8_t *brow = b + (uint64_t)k * p;
+          for (uint32_t j = 0; j < p; j++)
+            acc[j] += av * brow[j];
+        }
+        for (uint32_t j = 0; j < p; j++)
+          y[j] = matmul_apply_op(operation, mm->scale_y * (float)acc[j], c[j]);
+      } else {
+        const float *a = (const float *)mm->a + ((uint64_t)sa * m + row) * n;
+        const float *b = (const float *)mm->b + (uint64_t)sb * n * p;
+        memset(y, 0, p * sizeof(float));
+        for (uint32_t k = 0; k < n; k++) {
+          const float av = a[k];
+          const float *brow = b + (uint64_t)k * p;
+          for (uint32_t j = 0; j < p; j++)
+            y[j] += av * brow[j];
+        }
+        for (uint32_t j = 0; j < p; j++)
+          y[j] = matmul_apply_op(operation, y[j], c[j]);
+      }
+      violation |= store_row(&op->out1, s, 0, row, y, false);
+    }
+  }
+  if (violation) {
+    op->range_violation = true;
+  }
+  free(scratch);
+}
+
+static zdnn_status soft_matmul_op(soft_op *op) {
+  soft_matmul mm;
+  memset(&mm, 0, sizeof(soft_matmul));
+  op->shared = &mm;
+
+  // all matmul function codes share the same parameter layout, with transpose
+  // control and quantization parameters zero under parameter block format 0
+  const func_sp_parms_matmul *p = (const func_sp_parms_matmul *)op->fsp;
+  mm.transpose_a = p->parm2.transpose_a;
+  mm.transpose_b = p->parm2.transpose_b;
+  mm.quantized = op->in2.type == NNPA_8_BIT_BINARY_INT;
+  if (mm.quantized) {
+    mm.rec_scale_a = dlf16_parm(p->parm3.rec_scale);
+    mm.offset_a = dlf16_parm(p->parm4.offset);
+    mm.clip_min = (int8_t)p->parm9.clip_min;
+    mm.clip_max = (int8_t)p->parm10.clip_max;
+    mm.scale_y = quantized_matmul_scale(p);
+  }
+
+  mm.m = op->out1.dim2;
+  mm.p = op->out1.dim1;
+  mm.n = mm.transpose_a ? op->in1.dim2 : op->in1.dim1;
+
+  size_t elem = mm.quantized ? sizeof(int8_t) : sizeof(float);
+  uint64_t a_elems = (uint64_t)op->in1.dim4 * mm.m * mm.n;
+  uint64_t b_elems = (uint64_t)op->in2.dim4 * mm.n * mm.p;
+  if (!(mm.a = malloc((a_elems + b_elems) * elem))) {
+    return ZDNN_STATUS(ZDNN_ALLOCATION_FAILURE,
+                       "Unable to allocate %" PRIu64 " bytes.",
+                       (a_elems + b_elems) * elem);
+  }
+  mm.b = (char *)mm.a + a_elems * elem;
+
+  uint64_t rows = (uint64_t)op->in1.dim4 * op->in1.dim2 +
+                  (uint64_t)op->in2.dim4 * op->in2.dim2;
+  run_parallel(rows, rows_per_chunk(MAX(op->in1.dim1, op->in2.dim1)),
+               unpack_matmul_chunk, op);
+
+  if (!op->alloc_failure) {
+    run_parallel((uint64_t)op->out1.dim4 * CEIL(mm.m, SOFT_MATMUL_ROW_BLOCK),
+                 1, matmul_chunk, op);
+  }
+
+  free(mm.a);
+  return ZDNN_STATUS_OK;
+}
+
+// -----------------------------------------------------------------------------
+// NNPA-QAF
+// -----------------------------------------------------------------------------
+
+/// Fill a QAF parameter block with the capabilities of the newest known zAIU,
+/// all of which the software backend implements.
+///
+/// \param[out] qpb Pointer to nnpa_qaf_parameter_block
+///
+/// \return None
+///
+static void soft_query(nnpa_qaf_parameter_block *qpb) {
+  const aiu_hwinfo *info = aiu_hwinfo_list[0];
+
+  memset(qpb, 0, sizeof(nnpa_qaf_parameter_block));
+  memcpy(&qpb->HWINFO_BLK1_QAF_MEMBER, info->blk1, HWINFO_BLK1_LEN);
+  memcpy(&qpb->HWINFO_BLK2_QAF_MEMBER, info->blk2, HWINFO_BLK2_LEN);
+  memcpy(&qpb->HWINFO_BLK3_QAF_MEMBER, info->blk3, HWINFO_BLK3_LEN);
+  qpb->HWINFO_VAL1_QAF_MEMBER = info->val1;
+  qpb->HWINFO_VAL2_QAF_MEMBER = info->val2;
+}
+
+// -----------------------------------------------------------------------------
+// Function-specific response codes
+// -----------------------------------------------------------------------------
+
+// zAIU limits behind the F00x response codes of the pooling and convolution
+// functions
+#define POOL_ZERO_STRIDES_MAX_KERNEL 1024
+#define POOL_NONZERO_STRIDES_MAX_KERNEL 64
+#define POOL_NONZERO_STRIDES_MAX_STRIDE 30
+#define POOL_NONZERO_STRIDES_MAX_HEIGHT_WIDTH 1024
+#define CONV_ZERO_STRIDES_MAX_KERNEL 448
+#define CONV_NONZERO_STRIDES_MAX_KERNEL 64
+#define CONV_MAX_STRIDE 13
+
+/// Reject the function-specific parameters the zAIU rejects, with the same
+/// response code, so callers see the same status from either backend.
+///
+/// \param[in] op the decoded operation
+///
+/// \return ZDNN_OK
+///         ZDNN_FUNC_RC_F000 - ZDNN_FUNC_RC_F004
+///
+static zdnn_status check_function_parms(const soft_op *op) {
+  switch (op->function_code) {
+  case NNPA_SOFTMAX: {
+    const func_sp_parms_softmax *p = (const func_sp_parms_softmax *)op->fsp;
+    if (p->parm1.act != NNPA_SOFTMAX_NONE && p->parm1.act != NNPA_SOFTMAX_LOG) {
+      return ZDNN_STATUS_NO_MSG(ZDNN_FUNC_RC_F001);
+    }
+    if (p->parm2.mask > op->in1.dim1) {
+      return ZDNN_STATUS_NO_MSG(ZDNN_FUNC_RC_F002);
+    }
+    break;
+  }
+  case NNPA_MAXPOOL2D:
+  case NNPA_AVGPOOL2D: {
+    const func_sp_parms_pool2d *p = (const func_sp_parms_pool2d *)op->fsp;
+    uint32_t kernel = MAX(p->parm4.kernel_width, p->parm5.kernel_height);
+    uint32_t stride = MAX(p->parm2.stride_width, p->parm3.stride_height);
+    if (p->parm1.pad != VALID_PADDING && p->parm1.pad != SAME_PADDING) {
+      return ZDNN_STATUS_NO_MSG(ZDNN_FUNC_RC_F000);
+    }
+    if (!stride) {
+      if (kernel > POOL_ZERO_STRIDES_MAX_KERNEL) {
+        return ZDNN_STATUS_NO_MSG(ZDNN_FUNC_RC_F001);
+      }
+    } else if (kernel > POOL_NONZERO_STRIDES_MAX_KERNEL) {
+      return ZDNN_STATUS_NO_MSG(ZDNN_FUNC_RC_F002);
+    } else if (stride > POOL_NONZERO_STRIDES_MAX_STRIDE) {
+      return ZDNN_STATUS_NO_MSG(ZDNN_FUNC_RC_F003);
+    } else if (MAX(op->in1.dim2, op->in1.dim3) >
+               POOL_NONZERO_STRIDES_MAX_HEIGHT_WIDTH) {
+      return ZDNN_STATUS_NO_MSG(ZDNN_FUNC_RC_F004);
+    }
+    break;
+  }
+  case NNPA_MATMUL_OP:
+  case NNPA_MATMUL_OP_BCAST23:
+  case NNPA_MATMUL_OP_BCAST1: {
+    const func_sp_parms_matmul *p = (const func_sp_parms_matmul *)op->fsp;
+    if (p->parm1.operation > NNPA_MATMUL_OP_COMP_LOW) {
+      return ZDNN_STATUS_NO_MSG(ZDNN_FUNC_RC_F000);
+    }
+    if (op->in2.type == NNPA_8_BIT_BINARY_INT) {
+      if (op->in1.format != NNPA_LAYOUTFMT_4DFEATURE ||
+          op->in2.format != NNPA_LAYOUTFMT_4DWEIGHTS) {
+        return ZDNN_STATUS_NO_MSG(ZDNN_FUNC_RC_F001);
+      }
+      float scale = quantized_matmul_scale(p);
+      if (!isfinite(scale) || scale == 0) {
+        return ZDNN_STATUS_NO_MSG(ZDNN_FUNC_RC_F002);
+      }
+    }
+    break;
+  }
+  case NNPA_CONVOLUTION: {
+    const func_sp_parms_conv2d *p = (const func_sp_parms_conv2d *)op->fsp;
+    uint32_t kernel = MAX(op->in2.dim4, op->in2.dim3);
+    uint32_t stride = MAX(p->parm2.stride_width, p->parm3.stride_height);
+    if (p->parm1.pad != VALID_PADDING && p->parm1.pad != SAME_PADDING) {
+      return ZDNN_STATUS_NO_MSG(ZDNN_FUNC_RC_F000);
+    }
+    if (p->parm1.act != CONV2D_ACT_NONE && p->parm1.act != CONV2D_ACT_RELU) {
+      return ZDNN_STATUS_NO_MSG(ZDNN_FUNC_RC_F001);
+    }
+    if (!stride) {
+      if (kernel > CONV_ZERO_STRIDES_MAX_KERNEL) {
+        return ZDNN_STATUS_NO_MSG(ZDNN_FUNC_RC_F002);
+      }
+    } else if (kernel > CONV_NONZERO_STRIDES_MAX_KERNEL) {
+      return ZDNN_STATUS_NO_MSG(ZDNN_FUNC_RC_F003);
+    } else if (stride > CONV_MAX_STRIDE) {
+      return ZDNN_STATUS_NO_MSG(ZDNN_FUNC_RC_F004);
+    }
+    break;
+  }
+  default:
+    break;
+  }
+  return ZDNN_STATUS_OK;
+}
+
+/// Check a tensor against the maximum dimension index sizes, as the zAIU does
+/// before running any function.  Unused tensors have all dims 0.
+///
+/// \param[in] t the tensor
+///
+/// \return true if the zAIU accepts the dims
+///
+static bool is_soft_tensor_within_mdis(const soft_tensor *t) {
+  return t->dim4 <= zdnn_get_max_for_dim(4) &&
+         t->dim3 <= zdnn_get_max_for_dim(3) &&
+         t->dim2 <= zdnn_get_max_for_dim(2) &&
+         t->dim1 <= zdnn_get_max_for_dim(1);
+}
+
+/// Check the stick area of a tensor against the maximum tensor size, as the
+/// zAIU does before running any function.  Unused tensors have all dims 0.
+///
+/// \param[in] t the tensor
+///
+/// \return true if the zAIU accepts the size
+///
+static bool is_soft_tensor_within_mts(const soft_tensor *t) {
+  uint64_t size;
+
+  if (t->format == NNPA_LAYOUTFMT_4DGENERIC) {
+    // not a stick area
+    return true;
+  } else if (t->format == NNPA_LAYOUTFMT_4DKERNEL) {
+    size = CEIL(t->dim1, t->cells) * t->stride1;
+  } else {
+    size = t->dim4 * t->stride4;
+  }
+  return size <= zdnn_get_nnpa_max_tensor_size();
+}
+
+// -----------------------------------------------------------------------------
+// Entry point
+// -----------------------------------------------------------------------------
+
+/// Software equivalent of the NNPA instruction.  Same interface and return
+/// values as invoke_nnpa().
+///
+/// \param[in] function_code NNPA function code
+/// \param[in] parm_block pointer to a nnpa_parameter_block, or a
+///                       nnpa_qaf_parameter_block for NNPA_QAF
+/// \param[out] exception_flags exception flags, may be NULL
+///
+/// \return ZDNN_OK
+///         ZDNN_UNSUPPORTED_PARMBLOCK
+///         ZDNN_UNAVAILABLE_FUNCTION
+///         ZDNN_EXCEEDS_MDIS
+///         ZDNN_EXCEEDS_MTS
+///         ZDNN_ALLOCATION_FAILURE
+///         ZDNN_FUNC_RC_F000 - ZDNN_FUNC_RC_F004
+///
+zdnn_status soft_invoke_nnpa(uint8_t function_code, char *parm_block,
+                             uint8_t *exception_flags) {
+  if (exception_flags) {
+    *exception_flags = 0;
+  }
+
+  if (function_code == NNPA_QAF) {
+    soft_query((nnpa_qaf_parameter_block *)parm_block);
+    return ZDNN_STATUS_OK;
+  }
+
+  nnpa_parameter_block *pb = (nnpa_parameter_block *)parm_block;
+  if (pb->parm_block_version_number > NNPA_PARMBLKFORMAT_1) {
+    return ZDNN_STATUS_NO_MSG(ZDNN_UNSUPPORTED_PARMBLOCK);
+  }
+
+  soft_op op;
+  memset(&op, 0, sizeof(soft_op));
+  op.function_code = function_code;
+  op.fsp = &pb->function_specific_parms;
+  init_soft_tensor(&op.in1, &pb->input_tensor1);
+  init_soft_tensor(&op.in2, &pb->input_tensor2);
+  init_soft_tensor(&op.in3, &pb->input_tensor3);
+  init_soft_tensor(&op.out1, &pb->output_tensor1);
+  init_soft_tensor(&op.out2, &pb->output_tensor2);
+
+  if (!is_soft_tensor_within_mdis(&op.in1) ||
+      !is_soft_tensor_within_mdis(&op.in2) ||
+      !is_soft_tensor_within_mdis(&op.in3) ||
+      !is_soft_tensor_within_mdis(&op.out1) ||
+      !is_soft_tensor_within_mdis(&op.out2)) {
+    return ZDNN_STATUS_NO_MSG(ZDNN_EXCEEDS_MDIS);
+  }
+  if (!is_soft_tensor_within_mts(&op.in1) ||
+      !is_soft_tensor_within_mts(&op.in2) ||
+      !is_soft_tensor_within_mts(&op.in3) ||
+      !is_soft_tensor_within_mts(&op.out1) ||
+      !is_soft_tensor_within_mts(&op.out2)) {
+    return ZDNN_STATUS_NO_MSG(ZDNN_EXCEEDS_MTS);
+  }
+
+  zdnn_status status = check_function_parms(&op);
+  if (status != ZDNN_OK) {
+    return status;
+  }
+
+  const soft_tensor *out = &op.out1;
+  uint64_t out_rows = (uint64_t)out->dim4 * out->dim3 * out->dim2;
+
+  switch (function_code) {
+  case NNPA_ADD:
+  case NNPA_SUB:
+  case NNPA_MUL:
+  case NNPA_DIV:
+  case NNPA_MIN:
+  case NNPA_MAX:
+  case NNPA_LOG:
+  case NNPA_EXP:
+  case NNPA_SQRT:
+  case NNPA_INVSQRT:
+  case NNPA_RELU:
+  case NNPA_TANH:
+  case NNPA_SIGMOID:
+  case NNPA_SOFTMAX:
+  case NNPA_GELU:
+  case NNPA_BATCHNORMALIZATION:
+  case NNPA_LAYERNORM:
+  case NNPA_NORM:
+  case NNPA_REDUCE:
+  case NNPA_TRANSFORM:
+    run_parallel(out_rows, rows_per_chunk(op.in1.dim1), rowwise_chunk, &op);
+    break;
+  case NNPA_MOMENTS:
+    run_parallel(op.in1.dim4, 1, moments_chunk, &op);
+    break;
+  case NNPA_MAXPOOL2D:
+  case NNPA_AVGPOOL2D:
+    run_parallel((uint64_t)out->dim4 * out->dim3, 1, pool_chunk, &op);
+    break;
+  case NNPA_LSTMACT:
+  case NNPA_GRUACT:
+    run_parallel(out->dim2, rows_per_chunk(out->dim1), rnn_act_chunk, &op);
+    break;
+  case NNPA_CONVOLUTION: {
+    uint64_t kernel_rows =
+        (uint64_t)op.in2.dim4 * op.in2.dim3 * op.in2.dim2;
+    if (!(op.shared = malloc(kernel_rows * op.in2.dim1 * sizeof(float)))) {
+      return ZDNN_STATUS(ZDNN_ALLOCATION_FAILURE,
+                         "Unable to allocate %" PRIu64 " bytes.",
+                         kernel_rows * op.in2.dim1 * sizeof(float));
+    }
+    run_parallel(kernel_rows, rows_per_chunk(op.in2.dim1), unpack_kernel_chunk,
+                 &op);
+    run_parallel((uint64_t)out->dim4 * out->dim3, 1, conv_chunk, &op);
+    free(op.shared);
+    break;
+  }
+  case NNPA_MATMUL_OP:
+  case NNPA_MATMUL_OP_BCAST23:
+  case NNPA_MATMUL_OP_BCAST1:
+    status = soft_matmul_op(&op);
+    break;
+  default:
+    return ZDNN_STATUS_NO_MSG(ZDNN_UNAVAILABLE_FUNCTION);
+  }
+
+  if (status != ZDNN_OK) {
+    return status;
+  }
+  if (op.alloc_failure) {
+    return ZDNN_STATUS(ZDNN_ALLOCATION_FAILURE,
+                       "Unable to allocate scratch for function code %d",
+                       function_code);
+  }
+  if (op.range_violation && exception_flags) {
+    *exception_flags |= EF_RANGE_VIOLATION_MASK;
+  }
+  return ZDNN_STATUS_OK;
+}
@@ -40,6 +40,10 @@
 #pragma export(zdnn_gelu)
 #pragma export(zdnn_lstm)
 #pragma export(zdnn_gru)
+#pragma export(zdnn_lstm_packed)
+#pragma export(zdnn_gru_packed)
+#pragma export(zdnn_lstm_stack)
+#pragma export(zdnn_gru_stack)
 #pragma export(zdnn_matmul_op)
 #pragma export(zdnn_matmul_bcast_op)
 #pragma export(zdnn_matmul_transpose_op)
@@ -53,6 +57,9 @@
 #pragma export(zdnn_avgpool2d)
 #pragma export(zdnn_maxpool2d)
 #pragma export(zdnn_conv2d)
+#pragma export(zdnn_conv2d_grouped)
+#pragma export(zdnn_conv2d_dilated)
+#pragma export(zdnn_conv2d_transpose)
 #endif
 
 #define BEGIN_PRINT_PARMS                                                      \
@@ -439,6 +446,215 @@ zdnn_status zdnn_gru(const zdnn_ztensor *input, const zdnn_ztensor *h0,
                       work_area, hn_output, NULL);
 }
 
+/// External interface for LSTM operation over sequences of different lengths
+///
+/// \param[in] input The input tensor, padded to the longest sequence
+/// \param[in] seq_lens Number of valid timesteps of each batch row
+/// \param[in] h0 The initial hidden state tensor
+/// \param[in] c0 The initial cell state tensor
+/// \param[in] weights The concatenated weights tensor
+/// \param[in] biases The concatenated biases tensor
+/// \param[in] hidden_weights The concatenated hidden weights tensor
+/// \param[in] hidden_biases The concatenated hidden biases tensor
+/// \param[in] direction Direction (FWD, BWD, BIDIR)
+/// \param[in] work_area Pointer to pre-allocated work area, or NULL
+/// \param[out] hn_output The output hidden_state tensor
+/// \param[out] cf_output The output cell_state tensor
+///
+/// \return ZDNN_OK if all checks pass or a failure based on why it failed.
+///
+zdnn_status zdnn_lstm_packed(const zdnn_ztensor *input,
+                             const uint32_t *seq_lens, const zdnn_ztensor *h0,
+                             const zdnn_ztensor *c0,
+                             const zdnn_ztensor *weights,
+                             const zdnn_ztensor *biases,
+                             const zdnn_ztensor *hidden_weights,
+                             const zdnn_ztensor *hidden_biases,
+                             lstm_gru_direction direction, void *work_area,
+                             zdnn_ztensor *hn_output, zdnn_ztensor *cf_output) {
+  if (precheck_enabled) {
+    BEGIN_PRINT_PARMS;
+    PRINT_PARM_ZTENSOR_PTR(input);
+    PRINT_PARM_PTR(seq_lens);
+    PRINT_PARM_ZTENSOR_PTR(h0);
+    PRINT_PARM_ZTENSOR_PTR(c0);
+    PRINT_PARM_ZTENSOR_PTR(weights);
+    PRINT_PARM_ZTENSOR_PTR(biases);
+    PRINT_PARM_ZTENSOR_PTR(hidden_weights);
+    PRINT_PARM_ZTENSOR_PTR(hidden_biases);
+    PRINT_PARM_RNN_DIR(direction);
+    PRINT_PARM_PTR(work_area);
+    PRINT_PARM_ZTENSOR_PTR(hn_output);
+    PRINT_PARM_ZTENSOR_PTR(cf_output);
+    PRINT_API_AVAILABILITY("zdnn_lstm_packed", ZDNN_LSTM);
+    END_PRINT_PARMS;
+
+    zdnn_status precheck_status;
+    if ((precheck_status = verify_zdnn_lstm_or_gru_tensors(
+             NNPA_LSTMACT, input, h0, c0, weights, biases, hidden_weights,
+             hidden_biases, direction, hn_output, cf_output)) != ZDNN_OK) {
+      return precheck_status;
+    }
+  }
+
+  return aiu_lstm_gru_packed(NNPA_PARMBLKFORMAT_0, NNPA_LSTMACT, input,
+                             seq_lens, h0, c0, weights, biases, hidden_weights,
+                             hidden_biases, direction, work_area, hn_output,
+                             cf_output);
+}
+
+/// External interface for GRU operation over sequences of different lengths
+///
+/// \param[in] input The input tensor, padded to the longest sequence
+/// \param[in] seq_lens Number of valid timesteps of each batch row
+/// \param[in] h0 The initial hidden state tensor
+/// \param[in] weights The concatenated weights tensor
+/// \param[in] biases The concatenated biases tensor
+/// \param[in] hidden_weights The concatenated hidden weights tensor
+/// \param[in] hidden_biases The concatenated hidden biases tensor
+/// \param[in] direction Direction (FWD, BWD, BIDIR)
+/// \param[in] work_area Pointer to pre-allocated work area, or NULL
+/// \param[out] hn_output The output hidden_state tensor
+///
+/// \return ZDNN_OK if all checks pass or a failure based on why it failed.
+///
+zdnn_status zdnn_gru_packed(const zdnn_ztensor *input,
+                            const uint32_t *seq_lens, const zdnn_ztensor *h0,
+                            const zdnn_ztensor *weights,
+                            const zdnn_ztensor *biases,
+                            const zdnn_ztensor *hidden_weights,
+                            const zdnn_ztensor *hidden_biases,
+                            lstm_gru_direction direction, void *work_area,
+                            zdnn_ztensor *hn_output) {
+  if (precheck_enabled) {
+    BEGIN_PRINT_PARMS;
+    PRINT_PARM_ZTENSOR_PTR(input);
+    PRINT_PARM_PTR(seq_lens);
+    PRINT_PARM_ZTENSOR_PTR(h0);
+    PRINT_PARM_ZTENSOR_PTR(weights);
+    PRINT_PARM_ZTENSOR_PTR(biases);
+    PRINT_PARM_ZTENSOR_PTR(hidden_weights);
+    PRINT_PARM_ZTENSOR_PTR(hidden_biases);
+    PRINT_PARM_RNN_DIR(direction);
+    PRINT_PARM_PTR(work_area);
+    PRINT_PARM_ZTENSOR_PTR(hn_output);
+    PRINT_API_AVAILABILITY("zdnn_gru_packed", ZDNN_GRU);
+    END_PRINT_PARMS;
+
+    zdnn_status precheck_status;
+    if ((precheck_status = verify_zdnn_lstm_or_gru_tensors(
+             NNPA_GRUACT, input, h0, NULL, weights, biases, hidden_weights,
+             hidden_biases, direction, hn_output, NULL)) != ZDNN_OK) {
+      return precheck_status;
+    }
+  }
+
+  return aiu_lstm_gru_packed(NNPA_PARMBLKFORMAT_0, NNPA_GRUACT, input,
+                             seq_lens, h0, NULL, weights, biases,
+                             hidden_weights, hidden_biases, direction,
+                             work_area, hn_output, NULL);
+}
+
+/// External interface for a stack of LSTM layers
+///
+/// \param[in] input The first layer's input tensor
+/// \param[in] num_layers Number of layers
+/// \param[in] h0 The initial hidden state tensor of each layer
+/// \param[in] c0 The initial cell state tensor of each layer
+/// \param[in] weights The concatenated weights tensor of each layer
+/// \param[in] biases The concatenated biases tensor of each layer
+/// \param[in] hidden_weights The concatenated hidden weights tensor of each
+///                           layer
+/// \param[in] hidden_biases The concatenated hidden biases tensor of each
+///                          layer
+/// \param[in] direction Direction of every layer (FWD, BWD, BIDIR)
+/// \param[in] work_area Pointer to pre-allocated work area, or NULL
+/// \param[out] hn_output The last layer's output hidden_state tensor
+/// \param[out] cf_output The last layer's output cell_state tensor
+///
+/// \return ZDNN_OK if all checks pass or a failure based on why it failed.
+///
+zdnn_status zdnn_lstm_stack(const zdnn_ztensor *input, uint32_t num_layers,
+                            const zdnn_ztensor **h0, const zdnn_ztensor **c0,
+                            const zdnn_ztensor **weights,
+                            const zdnn_ztensor **biases,
+                            const zdnn_ztensor **hidden_weights,
+                            const zdnn_ztensor **hidden_biases,
+                            lstm_gru_direction direction, void *work_area,
+                            zdnn_ztensor *hn_output, zdnn_ztensor *cf_output) {
+  if (precheck_enabled) {
+    BEGIN_PRINT_PARMS;
+    PRINT_PARM_ZTENSOR_PTR(input);
+    PRINT_PARM_UINT32T(num_layers);
+    PRINT_PARM_PTR(h0);
+    PRINT_PARM_PTR(c0);
+    PRINT_PARM_PTR(weights);
+    PRINT_PARM_PTR(biases);
+    PRINT_PARM_PTR(hidden_weights);
+    PRINT_PARM_PTR(hidden_biases);
+    PRINT_PARM_RNN_DIR(direction);
+    PRINT_PARM_PTR(work_area);
+    PRINT_PARM_ZTENSOR_PTR(hn_output);
+    PRINT_PARM_ZTENSOR_PTR(cf_output);
+    PRINT_API_AVAILABILITY("zdnn_lstm_stack", ZDNN_LSTM);
+    END_PRINT_PARMS;
+    // every layer's tensors are checked by aiu_lstm_gru_stack(), which sets up
+    // the intermediate outputs
+  }
+
+  return aiu_lstm_gru_stack(NNPA_PARMBLKFORMAT_0, NNPA_LSTMACT, input,
+                            num_layers, h0, c0, weights, biases,
+                            hidden_weights, hidden_biases, direction,
+                            work_area, hn_output, cf_output);
+}
+
+/// External interface for a stack of GRU layers
+///
+/// \param[in] input The first layer's input tensor
+/// \param[in] num_layers Number of layers
+/// \param[in] h0 The initial hidden state tensor of each layer
+/// \param[in] weights The concatenated weights tensor of each layer
+/// \param[in] biases The concatenated biases tensor of each layer
+/// \param[in] hidden_weights The concatenated hidden weights tensor of each
+///                           layer
+/// \param[in] hidden_biases The concatenated hidden biases tensor of each
+///                          layer
+/// \param[in] direction Direction of every layer (FWD, BWD, BIDIR)
+/// \param[in] work_area Pointer to pre-allocated work area, or NULL
+/// \param[out] hn_output The last layer's output hidden_state tensor
+///
+/// \return ZDNN_OK if all checks pass or a failure based on why it failed.
+///
+zdnn_status zdnn_gru_stack(const zdnn_ztensor *input, uint32_t num_layers,
+                           const zdnn_ztensor **h0,
+                           const zdnn_ztensor **weights,
+                           const zdnn_ztensor **biases,
+                           const zdnn_ztensor **hidden_weights,
+                           const zdnn_ztensor **hidden_biases,
+                           lstm_gru_direction direction, void *work_area,
+                           zdnn_ztensor *hn_output) {
+  if (precheck_enabled) {
+    BEGIN_PRINT_PARMS;
+    PRINT_PARM_ZTENSOR_PTR(input);
+    PRINT_PARM_UINT32T(num_layers);
+    PRINT_PARM_PTR(h0);
+    PRINT_PARM_PTR(weights);
+    PRINT_PARM_PTR(biases);
+    PRINT_PARM_PTR(hidden_weights);
+    PRINT_PARM_PTR(hidden_biases);
+    PRINT_PARM_RNN_DIR(direction);
+    PRINT_PARM_PTR(work_area);
+    PRINT_PARM_ZTENSOR_PTR(hn_output);
+    PRINT_API_AVAILABILITY("zdnn_gru_stack", ZDNN_GRU);
+    END_PRINT_PARMS;
+  }
+
+  return aiu_lstm_gru_stack(NNPA_PARMBLKFORMAT_0, NNPA_GRUACT, input,
+                            num_layers, h0, NULL, weights, biases,
+                            hidden_weights, hidden_biases, direction,
+                            work_area, hn_output, NULL);
+}
+
 // -----------------------------------------------------------------------------
 // External Elementwise Operations
 // -----------------------------------------------------------------------------
@@ -709,8 +925,8 @@ zdnn_status zdnn_matmul_op(const zdnn_ztensor *input_a,
 
   // NNPA parameter block expects:
   // - function-specific-parameter-1: OPERATION field
-  return aiu_ops_func_specific(NNPA_PARMBLKFORMAT_0, NNPA_MATMUL_OP, input_a,
-                               input_b, input_c, output, NULL, 0, &fsp);
+  return aiu_matmul_op(NNPA_PARMBLKFORMAT_0, NNPA_MATMUL_OP, input_a, input_b,
+                       input_c, output, &fsp);
 }
 
 /// External interface for Matmul Broadcast operation
@@ -825,8 +1041,8 @@ zdnn_status zdnn_matmul_transpose_op(const zdnn_ztensor *input_a,
   // NNPA parameter block expects:
   // - function-specific-parameter-1: OPERATION field
   // - function-specific-parameter-1: transpose control
-  return aiu_ops_func_specific(NNPA_PARMBLKFORMAT_1, function_code, input_a,
-                               input_b, input_c, output, NULL, 0, &fsp);
+  return aiu_matmul_op(NNPA_PARMBLKFORMAT_1, function_code, input_a, input_b,
+                       input_c, output, &fsp);
 }
 
 /// External interface for Quantized Matmul operation
@@ -861,6 +1077,18 @@ zdnn_status zdnn_quantized_matmul_op(
                        input_b->offset, 0.f);
   }
 
+  // Per-channel input_b scales and offsets are folded into the bias and the
+  // host-side correction of a MATMUL_OP_ADDITION, neither of which happens
+  // when the bias is pre-computed
+  if (input_b->is_per_channel &&
+      (pre_computed || op_type != MATMUL_OP_ADDITION)) {
+    return ZDNN_STATUS(ZDNN_INVALID_SCALE,
+                       "input_b per-channel scales and offsets are only "
+                       "supported with MATMUL_OP_ADDITION and "
+                       "pre_computed=false",
+                       NO_ARG);
+  }
+
   // Determine function_code using dim4 of input_a and input_b
   nnpa_function_code function_code = get_matmul_function(
       input_a->transformed_desc->dim4, input_b->transformed_desc->dim4);
@@ -1234,6 +1462,192 @@ zdnn_status zdnn_conv2d(const zdnn_ztensor *input, const zdnn_ztensor *kernel,
   // - function-specific-parameter-2: dimension-2 (W) stride of NHWC
   // - function-specific-parameter-3: dimension-3 (H) stride of NHWC
   // thus in (stride_width, stride_height) order
-  return aiu_ops_func_specific(NNPA_PARMBLKFORMAT_0, NNPA_CONVOLUTION, input,
-                               kernel, bias, output, NULL, 0, &fsp);
+  return aiu_conv2d_op(NNPA_PARMBLKFORMAT_0, input, kernel, bias, output, &fsp);
+}
+
+/// Performs a grouped 2D convolution, where the input and output channels are
+/// split into groups and every group of input channels is convolved with its
+/// own slice of the kernel.  groups of 1 is zdnn_conv2d(), and groups equal to
+/// the input channels is a depthwise convolution.
+///
+/// \param[in] input The input tensor, (N, H, W, C)
+/// \param[in] kernel The input kernel tensor, (KH, KW, C / groups, K)
+/// \param[in] bias  The input bias tensor, (K)
+/// \param[in] groups number of groups, must divide C and K
+/// \param[in] padding_type VALID_PADDING or SAME_PADDING
+/// \param[in] stride_height height movement per kernel slide
+/// \param[in] stride_width width movement per kernel slide
+/// \param[in] act_func
+///                 activation function as specified in the zdnn_conv2d_act enum
+/// \param[in] clipping_value A pointer to an FP32 clipping value
+/// \param[out] output The output tensor, (N, OH, OW, K)
+///
+/// \return ZDNN_OK if all checks pass. or a failure based on why it failed
+///
+zdnn_status zdnn_conv2d_grouped(const zdnn_ztensor *input,
+                                const zdnn_ztensor *kernel,
+                                const zdnn_ztensor *bias, uint32_t groups,
+                                zdnn_pool_padding padding_type,
+                                uint32_t stride_height, uint32_t stride_width,
+                                zdnn_conv2d_act act_func,
+                                const void *clipping_value,
+                                zdnn_ztensor *output) {
+  function_specific_parameters fsp;
+  memset(&fsp, 0, sizeof(function_specific_parameters));
+  func_sp_parms_conv2d *fsp_conv2d = (func_sp_parms_conv2d *)&fsp;
+  fsp_conv2d->parm1.act = act_func;
+  fsp_conv2d->parm1.pad = padding_type;
+  fsp_conv2d->parm2.stride_width = stride_width;
+  fsp_conv2d->parm3.stride_height = stride_height;
+
+  float clip_val = 0;
+  if (clipping_value) {
+    clip_val = *(float *)clipping_value;
+    if (clip_val != 0) {
+      fsp_conv2d->parm4.clipping_value = cnvt_1_fp32_to_dlf16(clip_val);
+    }
+  }
+  if (precheck_enabled) {
+    BEGIN_PRINT_PARMS;
+    PRINT_PARM_ZTENSOR_PTR(input);
+    PRINT_PARM_ZTENSOR_PTR(kernel);
+    PRINT_PARM_ZTENSOR_PTR(bias);
+    PRINT_PARM_UINT32T(groups);
+    PRINT_PARM_POOL_PADDING(padding_type);
+    PRINT_PARM_UINT32T(stride_height);
+    PRINT_PARM_UINT32T(stride_width);
+    PRINT_PARM_CONV2D_ACT(act_func);
+    PRINT_PARM_FLOAT_PTR(clip_val);
+    PRINT_PARM_ZTENSOR_PTR(output);
+    PRINT_API_AVAILABILITY("zdnn_conv2d_grouped", ZDNN_CONV2D);
+    END_PRINT_PARMS;
+  }
+
+  return aiu_conv2d_grouped_op(NNPA_PARMBLKFORMAT_0, input, kernel, bias,
+                               groups, output, &fsp);
+}
+
+/// Performs a dilated 2D convolution, where the kernel rows and columns are
+/// applied to input rows and columns dilation_height and dilation_width apart.
+/// Dilations of 1 are zdnn_conv2d().
+///
+/// \param[in] input The input tensor
+/// \param[in] kernel The input kernel tensor
+/// \param[in] bias  The input bias tensor
+/// \param[in] padding_type VALID_PADDING or SAME_PADDING
+/// \param[in] stride_height height movement per kernel slide
+/// \param[in] stride_width width movement per kernel slide
+/// \param[in] dilation_height input rows between kernel rows
+/// \param[in] dilation_width input columns between kernel columns
+/// \param[in] act_func
+///                 activation function as specified in the zdnn_conv2d_act enum
+/// \param[in] clipping_value A pointer to an FP32 clipping value
+/// \param[out] output The output tensor
+///
+/// \return ZDNN_OK if all checks pass. or a failure based on why it failed
+///
+zdnn_status zdnn_conv2d_dilated(const zdnn_ztensor *input,
+                                const zdnn_ztensor *kernel,
+                                const zdnn_ztensor *bias,
+                                zdnn_pool_padding padding_type,
+                                uint32_t stride_height, uint32_t stride_width,
+                                uint32_t dilation_height,
+                                uint32_t dilation_width,
+                                zdnn_conv2d_act act_func,
+                                const void *clipping_value,
+                                zdnn_ztensor *output) {
+  function_specific_parameters fsp;
+  memset(&fsp, 0, sizeof(function_specific_parameters));
+  func_sp_parms_conv2d *fsp_conv2d = (func_sp_parms_conv2d *)&fsp;
+  fsp_conv2d->parm1.act = act_func;
+  fsp_conv2d->parm1.pad = padding_type;
+  fsp_conv2d->parm2.stride_width = stride_width;
+  fsp_conv2d->parm3.stride_height = stride_height;
+
+  float clip_val = 0;
+  if (clipping_value) {
+    clip_val = *(float *)clipping_value;
+    if (clip_val != 0) {
+      fsp_conv2d->parm4.clipping_value = cnvt_1_fp32_to_dlf16(clip_val);
+    }
+  }
+  if (precheck_enabled) {
+    BEGIN_PRINT_PARMS;
+    PRINT_PARM_ZTENSOR_PTR(input);
+    PRINT_PARM_ZTENSOR_PTR(kernel);
+    PRINT_PARM_ZTENSOR_PTR(bias);
+    PRINT_PARM_POOL_PADDING(padding_type);
+    PRINT_PARM_UINT32T(stride_height);
+    PRINT_PARM_UINT32T(stride_width);
+    PRINT_PARM_UINT32T(dilation_height);
+    PRINT_PARM_UINT32T(dilation_width);
+    PRINT_PARM_CONV2D_ACT(act_func);
+    PRINT_PARM_FLOAT_PTR(clip_val);
+    PRINT_PARM_ZTENSOR_PTR(output);
+    PRINT_API_AVAILABILITY("zdnn_conv2d_dilated", ZDNN_CONV2D);
+    END_PRINT_PARMS;
+  }
+
+  return aiu_conv2d_dilated_op(NNPA_PARMBLKFORMAT_0, input, kernel, bias,
+                               dilation_height, dilation_width, output, &fsp);
+}
+
+/// Performs a transposed 2D convolution (deconvolution), where every input
+/// value is multiplied by the kernel and added into the output at stride
+/// steps, the gradient of zdnn_conv2d() with respect to its input.
+///
+/// \param[in] input The input tensor
+/// \param[in] kernel The input kernel tensor
+/// \param[in] bias  The input bias tensor
+/// \param[in] padding_type VALID_PADDING or SAME_PADDING
+/// \param[in] stride_height output rows between input rows
+/// \param[in] stride_width output columns between input columns
+/// \param[in] act_func
+///                 activation function as specified in the zdnn_conv2d_act enum
+/// \param[in] clipping_value A pointer to an FP32 clipping value
+/// \param[out] output The output tensor
+///
+/// \return ZDNN_OK if all checks pass. or a failure based on why it failed
+///
+zdnn_status zdnn_conv2d_transpose(const zdnn_ztensor *input,
+                                  const zdnn_ztensor *kernel,
+                                  const zdnn_ztensor *bias,
+                                  zdnn_pool_padding padding_type,
+                                  uint32_t stride_height,
+                                  uint32_t stride_width,
+                                  zdnn_conv2d_act act_func,
+                                  const void *clipping_value,
+                                  zdnn_ztensor *output) {
+  function_specific_parameters fsp;
+  memset(&fsp, 0, sizeof(function_specific_parameters));
+  func_sp_parms_conv2d *fsp_conv2d = (func_sp_parms_conv2d *)&fsp;
+  fsp_conv2d->parm1.act = act_func;
+  fsp_conv2d->parm1.pad = padding_type;
+  fsp_conv2d->parm2.stride_width = stride_width;
+  fsp_conv2d->parm3.stride_height = stride_height;
+
+  float clip_val = 0;
+  if (clipping_value) {
+    clip_val = *(float *)clipping_value;
+    if (clip_val != 0) {
+      fsp_conv2d->parm4.clipping_value = cnvt_1_fp32_to_dlf16(clip_val);
+    }
+  }
+  if (precheck_enabled) {
+    BEGIN_PRINT_PARMS;
+    PRINT_PARM_ZTENSOR_PTR(input);
+    PRINT_PARM_ZTENSOR_PTR(kernel);
+    PRINT_PARM_ZTENSOR_PTR(bias);
+    PRINT_PARM_POOL_PADDING(padding_type);
+    PRINT_PARM_UINT32T(stride_height);
+    PRINT_PARM_UINT32T(stride_width);
+    PRINT_PARM_CONV2D_ACT(act_func);
+    PRINT_PARM_FLOAT_PTR(clip_val);
+    PRINT_PARM_ZTENSOR_PTR(output);
+    PRINT_API_AVAILABILITY("zdnn_conv2d_transpose", ZDNN_CONV2D);
+    END_PRINT_PARMS;
+  }
+
+  return aiu_conv2d_transpose_op(NNPA_PARMBLKFORMAT_0, input, kernel, bias,
+                                 output, &fsp);
 }
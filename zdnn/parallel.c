@@ -0,0 +1,294 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "zdnn.h"
+#include "zdnn_private.h"
+
+#ifdef __MVS__
+#pragma export(zdnn_set_max_threads)
+#pragma export(zdnn_get_max_threads)
+#endif
+
+// Upper bound on the number of worker threads in the pool
+#define PARALLEL_MAX_WORKERS 63
+
+// A job handed to the pool by run_parallel().  Workers and the caller claim
+// [next, next + grain) chunks under pool_lock until total is reached.  Only
+// workers with an index below helpers take part, the rest just acknowledge.
+typedef struct parallel_job {
+  parallel_func func;
+  void *ctx;
+  uint64_t total;
+  uint64_t grain;
+  uint64_t next;
+  uint32_t helpers;
+} parallel_job;
+
+// Per-worker state, set up by the thread that starts the worker so a job
+// posted before the worker first runs is not missed
+typedef struct pool_worker_info {
+  uint32_t index;
+  uint64_t seen_generation;
+} pool_worker_info;
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_done_cond = PTHREAD_COND_INITIALIZER;
+
+static parallel_job pool_job;
+static pool_worker_info pool_worker_infos[PARALLEL_MAX_WORKERS];
+static uint64_t pool_generation = 0; // bumped for every job posted
+static uint32_t pool_workers = 0;    // number of worker threads started
+static uint32_t pool_pending = 0;    // workers yet to finish current job
+static bool pool_busy = false;       // a job is in flight
+static bool pool_start_failed = false; // stop trying to add workers
+static uint32_t max_threads = 0; // threads per job incl. caller, 0 = # of CPUs
+
+static pthread_once_t pool_atfork_once = PTHREAD_ONCE_INIT;
+
+/// Claim and run chunks of the current job until there are none left.  Must
+/// be called with pool_lock held, returns with pool_lock held.
+///
+/// \param[in] job Pointer to the job being worked on
+///
+/// \return None
+///
+static void drain_job(parallel_job *job) {
+  while (job->next < job->total) {
+    uint64_t begin = job->next;
+    uint64_t end = MIN(begin + job->grain, job->total);
+    job->next = end;
+
+    pthread_mutex_unlock(&pool_lock);
+    job->func(job->ctx, begin, end);
+    pthread_mutex_lock(&pool_lock);
+  }
+}
+
+/// Worker thread main loop: wait for a new job generation, help drain it,
+/// then report back to the poster.
+///
+/// \param[in] arg Pointer to the worker's pool_worker_info
+///
+/// \return never returns
+///
+static void *pool_worker(void *arg) {
+  pool_worker_info *info = (pool_worker_info *)arg;
+
+  pthread_mutex_lock(&pool_lock);
+  for (;;) {
+    while (pool_generation == info->seen_generation) {
+      pthread_cond_wait(&pool_work_cond, &pool_lock);
+    }
+    info->seen_generation = pool_generation;
+
+    if (info->index < pool_job.helpers) {
+      drain_job(&pool_job);
+    }
+
+    if (--pool_pending == 0) {
+      pthread_cond_signal(&pool_done_cond);
+    }
+  }
+  return NULL;
+}
+
+/// Number of worker threads a job may use given the configured limit, one
+/// fewer than the thread count since the calling thread always participates.
+///
+/// \return number of helpers wanted, not yet capped by the workers started
+///
+static uint32_t wanted_helpers() {
+  static long ncpus = 0;
+  if (!ncpus) {
+    ncpus = MAX(sysconf(_SC_NPROCESSORS_ONLN), 1);
+  }
+
+  uint64_t threads = max_threads ? max_threads : (uint64_t)ncpus;
+  return (uint32_t)MIN(threads - 1, PARALLEL_MAX_WORKERS);
+}
+
+/// Hold pool_lock across fork() so the child gets the pool in a consistent
+/// state
+///
+/// \return None
+///
+static void pool_prepare_fork() { pthread_mutex_lock(&pool_lock); }
+
+/// Release pool_lock in the parent after fork()
+///
+/// \return None
+///
+static void pool_parent_fork() { pthread_mutex_unlock(&pool_lock); }
+
+/// The child of fork() has none of the worker threads, so forget about them
+/// and start over with fresh synchronization objects.  Workers are started
+/// again by the child's first run_parallel() that wants them.
+///
+/// \return None
+///
+static void pool_child_fork() {
+  pool_workers = 0;
+  pool_pending = 0;
+  pool_busy = false;
+  pool_start_failed = false;
+
+  pthread_mutex_init(&pool_lock, NULL);
+  pthread_cond_init(&pool_work_cond, NULL);
+  pthread_cond_init(&pool_done_cond, NULL);
+}
+
+/// Register the fork handlers of the pool, once
+///
+/// \return None
+///
+static void pool_register_atfork() {
+  if (pthread_atfork(pool_prepare_fork, pool_parent_fork, pool_child_fork)) {
+    LOG_WARN("unable to register fork handlers of the thread pool", NO_ARG);
+  }
+}
+
+/// Start worker threads until there are at least wanted of them.  Must be
+/// called with pool_lock held and no job in flight.
+///
+/// \param[in] wanted number of worker threads wanted
+///
+/// \return None
+///
+static void pool_grow(uint32_t wanted) {
+  if (pool_workers >= wanted || pool_start_failed) {
+    return;
+  }
+
+  // a child of fork() inherits pool_workers but none of the threads
+  pthread_once(&pool_atfork_once, pool_register_atfork);
+
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+  while (pool_workers < wanted) {
+    pool_worker_info *info = &pool_worker_infos[pool_workers];
+    info->index = pool_workers;
+    info->seen_generation = pool_generation;
+
+    pthread_t tid;
+    if (pthread_create(&tid, &attr, pool_worker, info)) {
+      LOG_WARN("unable to start worker thread %u, continuing with %u",
+               pool_workers, pool_workers);
+      pool_start_failed = true;
+      break;
+    }
+    pool_workers++;
+  }
+
+  pthread_attr_destroy(&attr);
+  LOG_INFO("thread pool has %u worker(s)", pool_workers);
+}
+
+/// Run func over [0, total) split into chunks of at most grain items, using
+/// the internal thread pool.  Returns once every chunk has completed.
+///
+/// Runs inline on the calling thread when the work fits in one chunk, when
+/// only one thread is allowed, or when the pool is already busy (nested or
+/// concurrent callers), so it is always safe to call.
+///
+/// \param[in] total number of work items
+/// \param[in] grain maximum number of work items per chunk
+/// \param[in] func function invoked as func(ctx, begin, end) per chunk
+/// \param[in] ctx opaque pointer passed through to func
+///
+/// \return None
+///
+void run_parallel(uint64_t total, uint64_t grain, parallel_func func,
+                  void *ctx) {
+  if (!total) {
+    return;
+  }
+  if (!grain) {
+    grain = 1;
+  }
+
+  uint32_t helpers = 0;
+
+  pthread_mutex_lock(&pool_lock);
+  if (total > grain && !pool_busy) {
+    // no point waking more workers than there are chunks besides the caller's
+    helpers = (uint32_t)MIN(wanted_helpers(), CEIL(total, grain) - 1);
+    pool_grow(helpers);
+    helpers = MIN(helpers, pool_workers);
+  }
+
+  if (!helpers) {
+    pthread_mutex_unlock(&pool_lock);
+    func(ctx, 0, total);
+    return;
+  }
+
+  pool_busy = true;
+  pool_job.func = func;
+  pool_job.ctx = ctx;
+  pool_job.total = total;
+  pool_job.grain = grain;
+  pool_job.next = 0;
+  pool_job.helpers = helpers;
+  pool_pending = pool_workers;
+  pool_generation++;
+  pthread_cond_broadcast(&pool_work_cond);
+
+  drain_job(&pool_job);
+
+  // every worker must acknowledge this generation before the job descriptor
+  // can be reused
+  while (pool_pending) {
+    pthread_cond_wait(&pool_done_cond, &pool_lock);
+  }
+  pool_busy = false;
+  pthread_mutex_unlock(&pool_lock);
+}
+
+/// Set the maximum number of threads, including the calling thread, that
+/// zDNN uses to process a single request on the host CPU (stickification and
+/// the software backend).  0 selects the number of online processors, 1
+/// disables multi-threading.
+///
+/// \param[in] threads maximum number of threads, or 0 for the default
+///
+/// \return None
+///
+void zdnn_set_max_threads(uint32_t threads) {
+  pthread_mutex_lock(&pool_lock);
+  max_threads = threads;
+  pthread_mutex_unlock(&pool_lock);
+}
+
+/// Retrieve the maximum number of threads, including the calling thread, that
+/// zDNN uses to process a single request on the host CPU.
+///
+/// \return number of threads
+///
+uint32_t zdnn_get_max_threads() {
+  pthread_mutex_lock(&pool_lock);
+  uint32_t threads = wanted_helpers() + 1;
+  pthread_mutex_unlock(&pool_lock);
+  return threads;
+}
@@ -113,7 +113,8 @@ bool zdnn_is_nnpa_parmblk_fmt_installed(int count, ...) {
 /// \return true if all queried data types are installed, false if any is not
 ///
 bool zdnn_is_nnpa_datatype_installed(uint16_t types_bitmask) {
-  return (~nnpa_query_result.installed_data_types & types_bitmask) == 0;
+  return (~QAF_BITMASK16(nnpa_query_result.installed_data_types) &
+          types_bitmask) == 0;
 }
 
 /// Query if NNPA data layout formats are installed
@@ -125,8 +126,8 @@ bool zdnn_is_nnpa_datatype_installed(uint16_t types_bitmask) {
 ///          is not
 ///
 bool zdnn_is_nnpa_layout_fmt_installed(uint32_t layout_bitmask) {
-  return (~nnpa_query_result.installed_data_layout_formats & layout_bitmask) ==
-         0;
+  return (~QAF_BITMASK32(nnpa_query_result.installed_data_layout_formats) &
+          layout_bitmask) == 0;
 }
 
 /// Query if NNPA data type to/from BFP format conversions are installed
@@ -143,7 +144,8 @@ bool zdnn_is_nnpa_conversion_installed(nnpa_data_type type,
 
   switch (type) {
   case NNPA_DATATYPE_1:
-    return (~nnpa_query_result.installed_dt1_conversions_vector &
+    return (~QAF_BITMASK16(
+                nnpa_query_result.installed_dt1_conversions_vector) &
             format_bitmask) == 0;
   default:
     // unknown nnp data-type means "not installed" regardless of mask
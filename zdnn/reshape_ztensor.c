@@ -25,6 +25,267 @@
 #pragma export(zdnn_reshape_ztensor)
 #endif
 
+// dest rows handled per parallel chunk of a stick-level reshape are sized to
+// cover about this many cells, an element-level reshape takes this many
+// elements per chunk
+#define RESHAPE_CELLS_PER_CHUNK 65536
+
+// State shared by the workers of a stick-level reshape.  Every chunk is a
+// range of dest (e4x, e3x) rows, which cover their own sticks of the dest
+// stick area.
+typedef struct reshape_job {
+  const char *src_buf;
+  char *dest_buf;
+  stick_geometry src;
+  stick_geometry dest;
+} reshape_job;
+
+/// Check if a zTensor's values can be moved between sticks as DLFLOAT16
+/// cells, i.e. it's a DLFLOAT16 feature tensor whose pre-transformed layout
+/// keeps the NHWC order of its transformed shape
+///
+/// \param[in] ztensor the zTensor
+///
+/// \return true if so
+///
+static bool is_reshapeable_by_cells(const zdnn_ztensor *ztensor) {
+  if (ztensor->transformed_desc->format != ZDNN_FORMAT_4DFEATURE ||
+      ztensor->transformed_desc->type != ZDNN_DLFLOAT16) {
+    return false;
+  }
+  switch (ztensor->pre_transformed_desc->layout) {
+  case ZDNN_1D:
+  case ZDNN_2D:
+  case ZDNN_2DS:
+  case ZDNN_3D:
+  case ZDNN_3DS:
+  case ZDNN_4D:
+  case ZDNN_NHWC:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// Fill dest rows [begin, end) of a stick-level reshape.  The cells of a dest
+/// stick are consecutive in NHWC order, so each one is filled with runs of
+/// cells copied from at most a few src sticks, and the cells past dim1 in the
+/// last stick are zeroed like stickification does.
+///
+/// \param[in] ctx Pointer to the reshape_job
+/// \param[in] begin first dest (e4x, e3x) row
+/// \param[in] end one past the last dest row
+///
+/// \return None
+///
+static void reshape_cells_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  const reshape_job *job = ctx;
+  const stick_geometry *src = &job->src, *dest = &job->dest;
+
+  // src position of the first cell of the chunk
+  uint64_t pos = begin * dest->dim2 * dest->dim1;
+  uint32_t sc = pos % src->dim1;
+  pos /= src->dim1;
+  uint32_t sw = pos % src->dim2;
+  pos /= src->dim2;
+  uint32_t sh = pos % src->dim3;
+  uint64_t sn = pos / src->dim3;
+
+  for (uint64_t row = begin; row < end; row++) {
+    char *dest_row = job->dest_buf + (row / dest->dim3) * dest->bytes_per_e4x +
+                     (row % dest->dim3) * dest->bytes_per_row;
+
+    for (uint32_t dw = 0; dw < dest->dim2; dw++) {
+      for (uint32_t dc = 0; dc < dest->dim1; dc += AIU_2BYTE_CELLS_PER_STICK) {
+        char *dest_stick = dest_row +
+                           dc / AIU_2BYTE_CELLS_PER_STICK *
+                               dest->bytes_per_stick1 +
+                           (uint64_t)dw * AIU_BYTES_PER_STICK;
+        uint32_t cells = dest->dim1 - dc;
+        if (cells > AIU_2BYTE_CELLS_PER_STICK) {
+          cells = AIU_2BYTE_CELLS_PER_STICK;
+        }
+
+        uint32_t filled = 0;
+        while (filled < cells) {
+          // cells left in the current src stick
+          uint32_t src_stick_end =
+              (sc / AIU_2BYTE_CELLS_PER_STICK + 1) * AIU_2BYTE_CELLS_PER_STICK;
+          uint32_t run = MIN(src_stick_end, src->dim1) - sc;
+          if (run > cells - filled) {
+            run = cells - filled;
+          }
+
+          const char *src_stick =
+              job->src_buf + sn * src->bytes_per_e4x +
+              sc / AIU_2BYTE_CELLS_PER_STICK * src->bytes_per_stick1 +
+              (uint64_t)sh * src->bytes_per_row +
+              (uint64_t)sw * AIU_BYTES_PER_STICK;
+          memcpy(dest_stick + filled * sizeof(uint16_t),
+                 src_stick + sc % AIU_2BYTE_CELLS_PER_STICK * sizeof(uint16_t),
+                 run * sizeof(uint16_t));
+
+          filled += run;
+          sc += run;
+          if (sc == src->dim1) {
+            sc = 0;
+            if (++sw == src->dim2) {
+              sw = 0;
+              if (++sh == src->dim3) {
+                sh = 0;
+                sn++;
+              }
+            }
+          }
+        }
+
+        if (cells < AIU_2BYTE_CELLS_PER_STICK) {
+          memset(dest_stick + cells * sizeof(uint16_t), 0,
+                 (AIU_2BYTE_CELLS_PER_STICK - cells) * sizeof(uint16_t));
+        }
+      }
+    }
+  }
+}
+
+/// Reshape by moving the DLFLOAT16 cells of src's sticks straight into dest's
+/// sticks, in NHWC order.  Both must pass is_reshapeable_by_cells() and hold
+/// the same number of elements.
+///
+/// \param[in] src source zTensor
+/// \param[out] dest destination zTensor
+///
+/// \return None
+///
+static void reshape_by_cells(const zdnn_ztensor *src, zdnn_ztensor *dest) {
+  const zdnn_tensor_desc *dest_desc = dest->transformed_desc;
+  reshape_job job;
+
+  job.src_buf = src->buffer;
+  job.dest_buf = dest->buffer;
+  init_stick_geometry(src->transformed_desc, &job.src);
+  init_stick_geometry(dest_desc, &job.dest);
+
+  uint64_t row_cells = (uint64_t)dest_desc->dim2 * dest_desc->dim1;
+  run_parallel((uint64_t)dest_desc->dim4 * dest_desc->dim3,
+               MAX(1, RESHAPE_CELLS_PER_CHUNK / MAX(row_cells, 1)),
+               reshape_cells_chunk, &job);
+}
+
+// Walks the elements of a zTensor in pre-transformed order.  idx[] is the
+// element's index along dims[], outermost first, where dims[] are the
+// pre-transformed dims of an NCHW or 4DS tensor and the transformed dims of
+// any other, since those keep the pre-transformed order.
+typedef struct elem_cursor {
+  const zdnn_ztensor *ztensor;
+  uint32_t dims[ZDNN_MAX_DIMS];
+  uint32_t idx[ZDNN_MAX_DIMS];
+} elem_cursor;
+
+// State shared by the workers of an element-level reshape.  Every chunk is a
+// range of elements in pre-transformed order.
+typedef struct reshape_elems_job {
+  const zdnn_ztensor *src;
+  zdnn_ztensor *dest;
+} reshape_elems_job;
+
+/// Point a cursor at element #elem of a zTensor
+///
+/// \param[in] ztensor the zTensor
+/// \param[in] elem element number in pre-transformed order
+/// \param[out] cur the cursor
+///
+/// \return None
+///
+static void init_elem_cursor(const zdnn_ztensor *ztensor, uint64_t elem,
+                             elem_cursor *cur) {
+  const zdnn_tensor_desc *desc =
+      (ztensor->pre_transformed_desc->layout == ZDNN_NCHW ||
+       ztensor->pre_transformed_desc->layout == ZDNN_4DS)
+          ? ztensor->pre_transformed_desc
+          : ztensor->transformed_desc;
+
+  cur->ztensor = ztensor;
+  cur->dims[0] = desc->dim4;
+  cur->dims[1] = desc->dim3;
+  cur->dims[2] = desc->dim2;
+  cur->dims[3] = desc->dim1;
+
+  for (int i = ZDNN_MAX_DIMS - 1; i >= 0; i--) {
+    cur->idx[i] = elem % cur->dims[i];
+    elem /= cur->dims[i];
+  }
+}
+
+/// Return the byte offset of a cursor's element in its zTensor's buffer
+///
+/// \param[in] cur the cursor
+///
+/// \return byte offset
+///
+static size_t get_elem_cursor_offset(const elem_cursor *cur) {
+  const zdnn_ztensor *ztensor = cur->ztensor;
+  const uint32_t *idx = cur->idx;
+
+  switch (ztensor->pre_transformed_desc->layout) {
+  case ZDNN_NCHW:
+    // N, C, H, W -> N, H, W, C
+    return get_stick_offset(idx[0], idx[2], idx[3], idx[1],
+                            ztensor->transformed_desc);
+  case ZDNN_4DS:
+    // the directions are side by side in dim1, each padded to whole sticks
+    return get_stick_offset(idx[0], 0, idx[2],
+                            (cur->dims[1] == 1)
+                                ? idx[3]
+                                : idx[1] * PADDED(cur->dims[3]) + idx[3],
+                            ztensor->transformed_desc);
+  default:
+    return get_stick_offset(idx[0], idx[1], idx[2], idx[3],
+                            ztensor->transformed_desc);
+  }
+}
+
+/// Move a cursor to the next element
+///
+/// \param[in,out] cur the cursor
+///
+/// \return None
+///
+static void next_elem_cursor(elem_cursor *cur) {
+  for (int i = ZDNN_MAX_DIMS - 1; i >= 0; i--) {
+    if (++cur->idx[i] < cur->dims[i]) {
+      return;
+    }
+    cur->idx[i] = 0;
+  }
+}
+
+/// Copy elements [begin, end) of an element-level reshape, element #i of src
+/// in pre-transformed order becomes element #i of dest.
+///
+/// \param[in] ctx Pointer to the reshape_elems_job
+/// \param[in] begin first element
+/// \param[in] end one past the last element
+///
+/// \return None
+///
+static void reshape_elems_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  const reshape_elems_job *job = ctx;
+  elem_cursor src_cur, dest_cur;
+
+  init_elem_cursor(job->src, begin, &src_cur);
+  init_elem_cursor(job->dest, begin, &dest_cur);
+
+  for (uint64_t e = begin; e < end; e++) {
+    *(uint16_t *)((uintptr_t)job->dest->buffer +
+                  get_elem_cursor_offset(&dest_cur)) =
+        *(uint16_t *)((uintptr_t)job->src->buffer +
+                      get_elem_cursor_offset(&src_cur));
+    next_elem_cursor(&src_cur);
+    next_elem_cursor(&dest_cur);
+  }
+}
+
 /// Reshape and copy buffer content from source zTensor's buffer to destination
 /// zTensor's in accordance to destination zTensor's shape.  The following
 /// conditions must be satisfied:
@@ -46,7 +307,6 @@
 ///         ZDNN_INVALID_FORMAT
 ///         ZDNN_INVALID_TYPE
 ///         ZDNN_INVALID_BUFFER
-///         ZDNN_CONVERT_FAILURE
 ///
 zdnn_status zdnn_reshape_ztensor(const zdnn_ztensor *src, zdnn_ztensor *dest) {
 
@@ -162,56 +422,48 @@ zdnn_status zdnn_reshape_ztensor(const zdnn_ztensor *src, zdnn_ztensor *dest) {
     return ZDNN_STATUS_OK;
   }
 
-  LOG_TRACE("Strategy: last resort", NO_ARG);
-
-#define STACK_TMPBUF_SIZE (1024 * 1024) // 1MB
-
-  // last resort: fully unstick and restick
-
-  // NOTE: this will change when we have "no conversion stick/unstick"
-  // for now, unstick to FP32 and restick to preserve precision.
-
-  char stack_tmpbuf[STACK_TMPBUF_SIZE] = {0};
-  void *malloc_tmpbuf = NULL;
-
-  zdnn_ztensor tmp_tensor_src, tmp_tensor_dest;
-  zdnn_tensor_desc tmp_pre_tfrmd_desc_src, tmp_pre_tfrmd_desc_dest;
-
-  memcpy(&tmp_tensor_src, src, sizeof(zdnn_ztensor));
-  memcpy(&tmp_tensor_dest, dest, sizeof(zdnn_ztensor));
-  memcpy(&tmp_pre_tfrmd_desc_src, src->pre_transformed_desc,
-         sizeof(zdnn_tensor_desc));
-  memcpy(&tmp_pre_tfrmd_desc_dest, dest->pre_transformed_desc,
-         sizeof(zdnn_tensor_desc));
+  // Scenario: DLFLOAT16 values in NHWC order on both sides, move the cells
+  // between sticks without converting them
+  if (is_reshapeable_by_cells(src) && is_reshapeable_by_cells(dest)) {
+    LOG_TRACE("Strategy: move cells between sticks", NO_ARG);
+    reshape_by_cells(src, dest);
+    dest->is_transformed = true;
+    return ZDNN_STATUS_OK;
+  }
 
-  tmp_pre_tfrmd_desc_src.type = FP32;
-  tmp_pre_tfrmd_desc_dest.type = FP32;
-  tmp_tensor_src.pre_transformed_desc = &tmp_pre_tfrmd_desc_src;
-  tmp_tensor_dest.pre_transformed_desc = &tmp_pre_tfrmd_desc_dest;
+  LOG_TRACE("Strategy: move elements in pre-transformed order", NO_ARG);
 
+  // the same checks zdnn_transform_origtensor() and zdnn_transform_ztensor()
+  // would do if the values took a trip through FP32
   zdnn_status status;
-
-  // if unstickified content is small enough (=< STACK_TMPBUF_SIZE) then use
-  // stack_tmpbuf instead of malloc()-ing one on heap
-  uint64_t s = get_num_elements(src, ELEMENTS_PRE) * get_data_type_size(FP32);
-  if (s > STACK_TMPBUF_SIZE) {
-    malloc_tmpbuf = malloc(s);
+  if ((status = verify_descriptors_transform_origtensor(src)) != ZDNN_OK ||
+      (status = verify_descriptors_transform_ztensor(dest)) != ZDNN_OK) {
+    return status;
   }
 
-  // no need to log status, zdnn_transform_origtensor() and
-  // zdnn_transform_ztensor() already do
-  if ((status = zdnn_transform_origtensor(
-           &tmp_tensor_src, malloc_tmpbuf ? malloc_tmpbuf : stack_tmpbuf)) ==
-      ZDNN_OK) {
-    status = zdnn_transform_ztensor(
-        &tmp_tensor_dest, malloc_tmpbuf ? malloc_tmpbuf : stack_tmpbuf);
+  if (!src->buffer || (uintptr_t)src->buffer & 0xFFF || !dest->buffer ||
+      (uintptr_t)dest->buffer & 0xFFF ||
+      dest->buffer_size < zdnn_getsize_ztensor(dest_tfrmd_desc)) {
+    return ZDNN_STATUS_NO_MSG(ZDNN_INVALID_BUFFER);
   }
 
-  if (malloc_tmpbuf) {
-    free(malloc_tmpbuf);
-  }
-  if (status == ZDNN_OK) {
-    dest->is_transformed = true;
+  if (src_tfrmd_desc->type != ZDNN_DLFLOAT16 ||
+      dest_tfrmd_desc->type != ZDNN_DLFLOAT16) {
+    return ZDNN_STATUS(ZDNN_INVALID_TYPE,
+                       "Types must be ZDNN_DLFLOAT16.  src type: %d, dest "
+                       "type: %d.",
+                       src_tfrmd_desc->type, dest_tfrmd_desc->type);
   }
-  return status;
+
+  // clear the padding, only the cells of the elements are written below
+  memset(dest->buffer, 0, zdnn_getsize_ztensor(dest_tfrmd_desc));
+
+  // a DLFLOAT16 value survives the DLFLOAT16 -> FP32 -> DLFLOAT16 trip as is,
+  // so move the cells without converting them
+  reshape_elems_job job = {src, dest};
+  run_parallel(get_num_elements(src, ELEMENTS_PRE), RESHAPE_CELLS_PER_CHUNK,
+               reshape_elems_chunk, &job);
+
+  dest->is_transformed = true;
+  return ZDNN_STATUS_OK;
 }
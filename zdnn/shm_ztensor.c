@@ -0,0 +1,479 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "zdnn.h"
+#include "zdnn_private.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __MVS__
+#pragma export(zdnn_init_ztensor_with_shm)
+#pragma export(zdnn_publish_shm_ztensor)
+#pragma export(zdnn_attach_shm_ztensor)
+#pragma export(zdnn_detach_shm_ztensor)
+#pragma export(zdnn_unlink_shm_ztensor)
+#endif
+
+/*
+  A shared memory zTensor lives in a named POSIX shared memory object, so that
+  one process transforms into it and other processes map the same pages
+  instead of holding and transforming their own copies:
+
+    shm_ztensor_header
+    channel scales and channel offsets, dim1 floats each
+    padding to AIU_PAGESIZE_IN_BYTES
+    stick area of buffer_size bytes
+
+  The creating process maps the object read/write, transforms into the stick
+  area and publishes it, which makes its own mapping read-only.  Other
+  processes attach to a published object read-only.
+
+  Every mapping is recorded in a process-local list, so that a zTensor is only
+  taken for a shared memory one, and the memory in front of its buffer only
+  read, when its buffer is the stick area of a mapping made here.
+*/
+
+#define SHM_ZTENSOR_MAGIC "zDNNshm"
+
+// channel vectors held by a shm_ztensor_header
+#define SHM_CHANNEL_SCALES 0x1
+#define SHM_CHANNEL_OFFSETS 0x2
+
+typedef struct shm_ztensor_header {
+  char magic[8];            // SHM_ZTENSOR_MAGIC
+  uint32_t ready;           // set once the stick area has been transformed
+  uint32_t channel_vectors; // SHM_CHANNEL_SCALES | SHM_CHANNEL_OFFSETS
+  uint64_t buffer_size;
+  zdnn_tensor_desc transformed_desc;
+  float rec_scale;
+  float offset;
+} shm_ztensor_header;
+
+// a mapping made by zdnn_init_ztensor_with_shm() or zdnn_attach_shm_ztensor()
+typedef struct shm_mapping {
+  struct shm_mapping *next;
+  shm_ztensor_header *header; // start of the mapping
+  uint64_t map_size;
+  const void *buffer; // stick area
+  uint64_t buffer_size;
+} shm_mapping;
+
+static pthread_mutex_t shm_mappings_lock = PTHREAD_MUTEX_INITIALIZER;
+static shm_mapping *shm_mappings = NULL;
+
+/// Size of the header and channel vectors in front of the stick area
+///
+/// \param[in] tfrmd_desc transformed shape information
+///
+/// \return size in bytes, whole pages
+///
+static uint64_t get_shm_header_size(const zdnn_tensor_desc *tfrmd_desc) {
+  return CEIL(sizeof(shm_ztensor_header) +
+                  2 * (uint64_t)tfrmd_desc->dim1 * sizeof(float),
+              AIU_PAGESIZE_IN_BYTES) *
+         AIU_PAGESIZE_IN_BYTES;
+}
+
+/// Channel scales of a header, followed by its channel offsets
+///
+/// \param[in] header the header
+///
+/// \return the channel scales
+///
+static float *get_shm_channel_scales(const shm_ztensor_header *header) {
+  return (float *)(header + 1);
+}
+
+/// Record a mapping made by this module
+///
+/// \param[in] header start of the mapping
+/// \param[in] map_size size of the mapping
+/// \param[in] buffer_size size of the stick area
+///
+/// \return ZDNN_OK
+///         ZDNN_ALLOCATION_FAILURE
+///
+static zdnn_status add_shm_mapping(shm_ztensor_header *header,
+                                   uint64_t map_size, uint64_t buffer_size) {
+  shm_mapping *mapping = malloc(sizeof(shm_mapping));
+  if (!mapping) {
+    return ZDNN_STATUS(ZDNN_ALLOCATION_FAILURE,
+                       "Unable to allocate %" PRIu64 " bytes",
+                       (uint64_t)sizeof(shm_mapping));
+  }
+  mapping->header = header;
+  mapping->map_size = map_size;
+  mapping->buffer = (char *)header + (map_size - buffer_size);
+  mapping->buffer_size = buffer_size;
+
+  pthread_mutex_lock(&shm_mappings_lock);
+  mapping->next = shm_mappings;
+  shm_mappings = mapping;
+  pthread_mutex_unlock(&shm_mappings_lock);
+  return ZDNN_STATUS_OK;
+}
+
+/// Look up the mapping whose stick area is a zTensor's buffer
+///
+/// \param[in] ztensor the zTensor
+/// \param[in] remove whether to drop the mapping from the list
+/// \param[out] found copy of the mapping
+///
+/// \return true if the buffer and buffer_size are those of a mapping made by
+///         this module
+///
+static bool find_shm_mapping(const zdnn_ztensor *ztensor, bool remove,
+                             shm_mapping *found) {
+  bool is_found = false;
+
+  pthread_mutex_lock(&shm_mappings_lock);
+  for (shm_mapping **link = &shm_mappings; *link; link = &(*link)->next) {
+    shm_mapping *mapping = *link;
+    if (mapping->buffer == ztensor->buffer &&
+        mapping->buffer_size == ztensor->buffer_size) {
+      *found = *mapping;
+      if (remove) {
+        *link = mapping->next;
+        free(mapping);
+      }
+      is_found = true;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&shm_mappings_lock);
+  return is_found;
+}
+
+/// Check that two transformed descriptors describe the same stick area
+///
+/// \param[in] a a transformed descriptor
+/// \param[in] b another transformed descriptor
+///
+/// \return true if they match
+///
+static bool same_transformed_desc(const zdnn_tensor_desc *a,
+                                  const zdnn_tensor_desc *b) {
+  return a->layout == b->layout && a->format == b->format &&
+         a->type == b->type && a->dim4 == b->dim4 && a->dim3 == b->dim3 &&
+         a->dim2 == b->dim2 && a->dim1 == b->dim1;
+}
+
+/// Initialize a zTensor whose buffer is allocated in a new named POSIX shared
+/// memory object, to be transformed into and published with
+/// zdnn_publish_shm_ztensor() for other processes to attach to
+///
+/// \param[in] pre_tfrmd_desc pre-transformed shape information
+/// \param[in] tfrmd_desc transformed shape information
+/// \param[in] name name of the shared memory object, "/somename"
+/// \param[out] output the zTensor
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_BUFFER
+///         ZDNN_INVALID_FORMAT
+///         ZDNN_INVALID_TYPE
+///         ZDNN_INVALID_LAYOUT
+///         ZDNN_INVALID_SHAPE
+///         ZDNN_FILE_ERROR
+///         ZDNN_ALLOCATION_FAILURE
+///
+zdnn_status zdnn_init_ztensor_with_shm(zdnn_tensor_desc *pre_tfrmd_desc,
+                                       zdnn_tensor_desc *tfrmd_desc,
+                                       const char *name, zdnn_ztensor *output) {
+  zdnn_status status;
+
+  if (!name) {
+    return ZDNN_STATUS(ZDNN_INVALID_BUFFER, "name is NULL", NO_ARG);
+  }
+
+  // no buffer unless one is mapped
+  zdnn_init_ztensor(pre_tfrmd_desc, tfrmd_desc, output);
+  output->buffer = NULL;
+  output->buffer_size = 0;
+  if ((status = verify_transformed_descriptor(tfrmd_desc)) != ZDNN_OK) {
+    return status;
+  }
+
+  const uint64_t header_size = get_shm_header_size(tfrmd_desc);
+  const uint64_t buffer_size = zdnn_getsize_ztensor(tfrmd_desc);
+  const uint64_t map_size = header_size + buffer_size;
+
+  int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+  if (fd < 0) {
+    return ZDNN_STATUS(ZDNN_FILE_ERROR, "Unable to create %s: %s", name,
+                       strerror(errno));
+  }
+
+  void *map = MAP_FAILED;
+  if (ftruncate(fd, (off_t)map_size) == 0) {
+    map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  int err = errno;
+  close(fd);
+  if (map == MAP_FAILED) {
+    shm_unlink(name);
+    return ZDNN_STATUS(ZDNN_FILE_ERROR, "Unable to map %s: %s", name,
+                       strerror(err));
+  }
+
+  // a new object reads as zeros, so ready is false until published
+  shm_ztensor_header *header = map;
+  memcpy(header->magic, SHM_ZTENSOR_MAGIC, sizeof(header->magic));
+  header->buffer_size = buffer_size;
+  header->transformed_desc = *tfrmd_desc;
+
+  if ((status = add_shm_mapping(header, map_size, buffer_size)) != ZDNN_OK) {
+    munmap(map, map_size);
+    shm_unlink(name);
+    return status;
+  }
+
+  output->buffer = (char *)map + header_size;
+  output->buffer_size = buffer_size;
+  return ZDNN_STATUS_OK;
+}
+
+/// Let other processes attach to a shared memory zTensor created by
+/// zdnn_init_ztensor_with_shm(), once it is transformed.  Its scale, offset
+/// and channel vectors are published with it, and its buffer becomes
+/// read-only.
+///
+/// \param[in] ztensor the zTensor
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_BUFFER
+///         ZDNN_INVALID_STATE
+///         ZDNN_FILE_ERROR
+///
+zdnn_status zdnn_publish_shm_ztensor(zdnn_ztensor *ztensor) {
+  if (!ztensor->buffer) {
+    return ZDNN_STATUS_NO_MSG(ZDNN_INVALID_BUFFER);
+  }
+  if (!ztensor->is_transformed) {
+    return ZDNN_STATUS(ZDNN_INVALID_STATE, "zTensor is not transformed",
+                       NO_ARG);
+  }
+
+  shm_mapping mapping;
+  if (!find_shm_mapping(ztensor, false, &mapping)) {
+    return ZDNN_STATUS(ZDNN_INVALID_BUFFER,
+                       "buffer is not a shared memory zTensor", NO_ARG);
+  }
+  shm_ztensor_header *header = mapping.header;
+  // published (or attached) headers are mapped read-only
+  if (__atomic_load_n(&header->ready, __ATOMIC_ACQUIRE)) {
+    return ZDNN_STATUS(ZDNN_INVALID_STATE, "zTensor is already published",
+                       NO_ARG);
+  }
+
+  header->rec_scale = ztensor->rec_scale;
+  header->offset = ztensor->offset;
+  const uint32_t channels = header->transformed_desc.dim1;
+  float *channel_scales = get_shm_channel_scales(header);
+  if (ztensor->is_per_channel && ztensor->channel_scales) {
+    memcpy(channel_scales, ztensor->channel_scales, channels * sizeof(float));
+    header->channel_vectors |= SHM_CHANNEL_SCALES;
+  }
+  if (ztensor->is_per_channel && ztensor->channel_offsets) {
+    memcpy(channel_scales + channels, ztensor->channel_offsets,
+           channels * sizeof(float));
+    header->channel_vectors |= SHM_CHANNEL_OFFSETS;
+  }
+  // attaching processes see the stick area and the above before ready
+  __atomic_store_n(&header->ready, 1, __ATOMIC_RELEASE);
+
+  if (mprotect(header, mapping.map_size, PROT_READ) != 0) {
+    return ZDNN_STATUS(ZDNN_FILE_ERROR, "Unable to protect zTensor: %s",
+                       strerror(errno));
+  }
+  return ZDNN_STATUS_OK;
+}
+
+/// Initialize a zTensor whose buffer is the stick area of a shared memory
+/// zTensor published by another process, mapped read-only
+///
+/// \param[in] pre_tfrmd_desc pre-transformed shape information
+/// \param[in] tfrmd_desc transformed shape information, the same as the
+///                       object was created with
+/// \param[in] name name of the shared memory object
+/// \param[out] output the zTensor, transformed
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_BUFFER
+///         ZDNN_INVALID_FORMAT
+///         ZDNN_INVALID_TYPE
+///         ZDNN_INVALID_LAYOUT
+///         ZDNN_INVALID_SHAPE
+///         ZDNN_INVALID_STATE
+///         ZDNN_FILE_ERROR
+///         ZDNN_ALLOCATION_FAILURE
+///
+zdnn_status zdnn_attach_shm_ztensor(zdnn_tensor_desc *pre_tfrmd_desc,
+                                    zdnn_tensor_desc *tfrmd_desc,
+                                    const char *name, zdnn_ztensor *output) {
+  zdnn_status status;
+
+  if (!name) {
+    return ZDNN_STATUS(ZDNN_INVALID_BUFFER, "name is NULL", NO_ARG);
+  }
+
+  // no buffer unless one is mapped
+  zdnn_init_ztensor(pre_tfrmd_desc, tfrmd_desc, output);
+  output->buffer = NULL;
+  output->buffer_size = 0;
+  if ((status = verify_transformed_descriptor(tfrmd_desc)) != ZDNN_OK) {
+    return status;
+  }
+
+  const uint64_t header_size = get_shm_header_size(tfrmd_desc);
+  const uint64_t buffer_size = zdnn_getsize_ztensor(tfrmd_desc);
+  const uint64_t map_size = header_size + buffer_size;
+
+  int fd = shm_open(name, O_RDONLY, 0);
+  if (fd < 0) {
+    return ZDNN_STATUS(ZDNN_FILE_ERROR, "Unable to open %s: %s", name,
+                       strerror(errno));
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    int err = errno;
+    close(fd);
+    return ZDNN_STATUS(ZDNN_FILE_ERROR, "Unable to stat %s: %s", name,
+                       strerror(err));
+  }
+  if (st.st_size == 0) {
+    // the creating process hasn't sized it yet
+    close(fd);
+    return ZDNN_STATUS(ZDNN_INVALID_STATE, "%s is not published", name);
+  }
+  if ((uint64_t)st.st_size != map_size) {
+    close(fd);
+    return ZDNN_STATUS(ZDNN_FILE_ERROR,
+                       "%s is %" PRIu64 " bytes, expected %" PRIu64, name,
+                       (uint64_t)st.st_size, map_size);
+  }
+
+  void *map = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, 0);
+  int err = errno;
+  close(fd);
+  if (map == MAP_FAILED) {
+    return ZDNN_STATUS(ZDNN_FILE_ERROR, "Unable to map %s: %s", name,
+                       strerror(err));
+  }
+
+  const shm_ztensor_header *header = map;
+  if (memcmp(header->magic, SHM_ZTENSOR_MAGIC, sizeof(header->magic)) ||
+      header->buffer_size != buffer_size ||
+      !same_transformed_desc(&header->transformed_desc, tfrmd_desc)) {
+    munmap(map, map_size);
+    return ZDNN_STATUS(ZDNN_FILE_ERROR,
+                       "%s does not hold a zTensor of this shape", name);
+  }
+  if (!__atomic_load_n(&header->ready, __ATOMIC_ACQUIRE)) {
+    munmap(map, map_size);
+    return ZDNN_STATUS(ZDNN_INVALID_STATE, "%s is not published", name);
+  }
+
+  if ((status = add_shm_mapping(map, map_size, buffer_size)) != ZDNN_OK) {
+    munmap(map, map_size);
+    return status;
+  }
+
+  output->buffer = (char *)map + header_size;
+  output->buffer_size = buffer_size;
+  output->rec_scale = header->rec_scale;
+  output->offset = header->offset;
+  // the channel vectors are read where they are mapped
+  const float *channel_scales = get_shm_channel_scales(header);
+  if (header->channel_vectors & SHM_CHANNEL_SCALES) {
+    output->channel_scales = channel_scales;
+  }
+  if (header->channel_vectors & SHM_CHANNEL_OFFSETS) {
+    output->channel_offsets = channel_scales + tfrmd_desc->dim1;
+  }
+  output->is_per_channel = (header->channel_vectors != 0);
+  output->is_transformed = true;
+  return ZDNN_STATUS_OK;
+}
+
+/// Unmap the buffer of a zTensor created by zdnn_init_ztensor_with_shm() or
+/// attached to by zdnn_attach_shm_ztensor().  The shared memory object stays
+/// until zdnn_unlink_shm_ztensor() is called and all processes detached.
+///
+/// \param[in] ztensor the zTensor, with no buffer afterwards
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_BUFFER
+///
+zdnn_status zdnn_detach_shm_ztensor(zdnn_ztensor *ztensor) {
+  if (!ztensor->buffer) {
+    return ZDNN_STATUS_NO_MSG(ZDNN_INVALID_BUFFER);
+  }
+
+  shm_mapping mapping;
+  if (!find_shm_mapping(ztensor, true, &mapping)) {
+    return ZDNN_STATUS(ZDNN_INVALID_BUFFER,
+                       "buffer is not a shared memory zTensor", NO_ARG);
+  }
+
+  // the address may come back for different data
+  invalidate_qmatmul_bias_cache(ztensor->buffer);
+  munmap(mapping.header, mapping.map_size);
+
+  ztensor->buffer = NULL;
+  ztensor->buffer_size = 0;
+  ztensor->is_transformed = false;
+  // attached channel vectors were in the mapping
+  if ((const void *)ztensor->channel_scales >= (void *)mapping.header &&
+      (const void *)ztensor->channel_scales < mapping.buffer) {
+    ztensor->channel_scales = NULL;
+  }
+  if ((const void *)ztensor->channel_offsets >= (void *)mapping.header &&
+      (const void *)ztensor->channel_offsets < mapping.buffer) {
+    ztensor->channel_offsets = NULL;
+  }
+  ztensor->is_per_channel =
+      ztensor->is_per_channel &&
+      (ztensor->channel_scales || ztensor->channel_offsets);
+  return ZDNN_STATUS_OK;
+}
+
+/// Remove the name of a shared memory zTensor.  Processes already attached
+/// keep their mappings.
+///
+/// \param[in] name name of the shared memory object
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_BUFFER
+///         ZDNN_FILE_ERROR
+///
+zdnn_status zdnn_unlink_shm_ztensor(const char *name) {
+  if (!name) {
+    return ZDNN_STATUS(ZDNN_INVALID_BUFFER, "name is NULL", NO_ARG);
+  }
+  if (shm_unlink(name) != 0) {
+    return ZDNN_STATUS(ZDNN_FILE_ERROR, "Unable to unlink %s: %s", name,
+                       strerror(errno));
+  }
+  return ZDNN_STATUS_OK;
+}
@@ -97,6 +97,9 @@ DECLARE_STATUS_STR_N_MSG(ZDNN_CONVERT_FAILURE,
 DECLARE_STATUS_STR_N_MSG(ZDNN_INVALID_STATE, "Invalid zTensor state.")
 DECLARE_STATUS_STR_N_MSG(ZDNN_UNSUPPORTED_AIU_EXCEPTION,
                          "zAIU operation returned an unexpected exception.")
+DECLARE_STATUS_STR_N_MSG(
+    ZDNN_FILE_ERROR,
+    "zTensor file or shared memory can not be accessed, or is not valid.")
 DECLARE_STATUS_STR_N_MSG(
     ZDNN_UNSUPPORTED_PARMBLOCK,
     "NNPA parameter block format is not supported by the model.")
@@ -182,6 +185,7 @@ const char *zdnn_get_status_message(zdnn_status status) {
     CASE_RTN_MSG(ZDNN_CONVERT_FAILURE);
     CASE_RTN_MSG(ZDNN_INVALID_STATE);
     CASE_RTN_MSG(ZDNN_UNSUPPORTED_AIU_EXCEPTION);
+    CASE_RTN_MSG(ZDNN_FILE_ERROR);
     CASE_RTN_MSG(ZDNN_UNSUPPORTED_PARMBLOCK);
     CASE_RTN_MSG(ZDNN_UNAVAILABLE_FUNCTION);
     CASE_RTN_MSG(ZDNN_UNSUPPORTED_FORMAT);
@@ -247,6 +251,7 @@ static const char *get_status_str(zdnn_status status) {
     CASE_RTN_STR(ZDNN_CONVERT_FAILURE);
     CASE_RTN_STR(ZDNN_INVALID_STATE);
     CASE_RTN_STR(ZDNN_UNSUPPORTED_AIU_EXCEPTION);
+    CASE_RTN_STR(ZDNN_FILE_ERROR);
     CASE_RTN_STR(ZDNN_UNSUPPORTED_PARMBLOCK);
     CASE_RTN_STR(ZDNN_UNAVAILABLE_FUNCTION);
     CASE_RTN_STR(ZDNN_UNSUPPORTED_FORMAT);
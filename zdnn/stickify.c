@@ -23,6 +23,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "convert.h"
 #include "zdnn.h"
 #include "zdnn_private.h"
@@ -31,6 +35,7 @@
 #pragma export(zdnn_transform_ztensor)
 #pragma export(zdnn_transform_origtensor)
 #pragma export(zdnn_transform_quantized_ztensor)
+#pragma export(zdnn_transform_dynamic_quantized_ztensor)
 #pragma export(zdnn_transform_ztensor_with_saturation)
 #endif
 
@@ -72,6 +77,46 @@ static inline void cache_flush(const void *ptr, uintptr_t offset) {
   // No equivalent for non-MVS, leave empty or add necessary code
 #endif
 }
+/// Copy a block of data to its final destination with non-temporal stores
+/// where the platform has them, so that data the caller won't touch soon
+/// doesn't evict its working set from the cache.  Elsewhere the destination
+/// lines are flushed after a regular copy.
+///
+/// \param[in] dst destination address
+/// \param[in] src source address
+/// \param[in] len number of bytes to copy
+///
+static inline void stream_store(void *dst, const void *src, size_t len) {
+#if defined(__SSE2__)
+  uint8_t *d = (uint8_t *)dst;
+  const uint8_t *s = (const uint8_t *)src;
+
+  // non-temporal stores need 16-byte alignment, copy the head and the tail
+  size_t misalign = (-(uintptr_t)d) & 15;
+  size_t head = MIN(misalign, len);
+  memcpy(d, s, head);
+  d += head;
+  s += head;
+  len -= head;
+
+  for (; len >= 16; len -= 16, d += 16, s += 16) {
+    _mm_stream_si128((__m128i *)d, _mm_loadu_si128((const __m128i *)s));
+  }
+  memcpy(d, s, len);
+#else
+  memcpy(dst, src, len);
+  for (size_t i = 0; i < len; i += 256) {
+    cache_flush(dst, i);
+  }
+#endif
+}
+/// Make the stream_store()s of the calling thread visible to other threads
+///
+static inline void stream_fence() {
+#if defined(__SSE2__)
+  _mm_sfence();
+#endif
+}
 
 /// Calculate stride n size for the tensor. When stride n size >
 /// STICK_SW_THRESHOLD use hardware stickification otherwise stay in software
@@ -104,6 +149,28 @@ n_stride_meets_hardware_limit(const zdnn_tensor_desc *tensor) {
          "<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<\n",               \
          __func__)
 
+/// Work out where the sticks of a 4DFEATURE stick area are.  The transformed
+/// type must be a known one.
+///
+/// \param[in] tfrmd_desc transformed descriptor
+/// \param[out] geom the stick geometry
+///
+/// \return None
+///
+void init_stick_geometry(const zdnn_tensor_desc *tfrmd_desc,
+                         stick_geometry *geom) {
+  geom->dim3 = tfrmd_desc->dim3;
+  geom->dim2 = tfrmd_desc->dim2;
+  geom->dim1 = tfrmd_desc->dim1;
+  geom->cells_per_stick =
+      AIU_BYTES_PER_STICK / get_data_type_size(tfrmd_desc->type);
+  geom->bytes_per_row =
+      CEIL(tfrmd_desc->dim2, AIU_STICKS_PER_PAGE) * AIU_PAGESIZE_IN_BYTES;
+  geom->bytes_per_stick1 = (uint64_t)tfrmd_desc->dim3 * geom->bytes_per_row;
+  geom->bytes_per_e4x =
+      geom->bytes_per_stick1 * CEIL(tfrmd_desc->dim1, geom->cells_per_stick);
+}
+
 /// Return the byte offset of the field in the stick array, based on the input
 /// fields indexes, and the overall dimensions of the input tensor. The use of
 /// e4x,e3x, etc is to reflect the four dimensions in the NNPA control block
@@ -480,296 +547,320 @@ zdnn_status hw_transform_ztensor(const void *in_buf, bool saturation_control,
                                &temp_input, NULL, NULL, output, NULL, 0, &fsp);
 }
 
-/// The actual routine for stickification, only does the following:
-///    NHWC -> NHWC, NCHW -> NHWC, HWCK -> HWCK
-/// Does NOT handle concatenated types.
+// rows handled per parallel (un)stickification chunk are sized to cover about
+// this many elements
+#define STICK_ELEMENTS_PER_CHUNK 65536
+
+// State shared by the workers of a parallel transform_ztensor() or
+// transform_origtensor().  Every chunk is a range of rows (e.g., (e4x, e3x)),
+// each of which covers its own set of 4k pages of the stick area and its own
+// part of the original tensor, so workers never write to the same memory.
+typedef struct stick_job {
+  const zdnn_ztensor *ztensor;
+  const void *in_buf; // stickify: data to be stickified, else stick area
+  void *out_buf;      // stickify: stick area, else unstickified data
+  void (*saturate_func)(const vec_float32 *, const vec_float32 *,
+                        vec_float32 *, vec_float32 *);
+  short cell_shift;          // log2 of pre-transformed element size
+  uint64_t bytes_per_row;    // stick area bytes of one e3x
+  uint64_t bytes_per_e4x;    // stick area bytes between consecutive e4x
+  uint64_t bytes_per_stick1; // stick area bytes between consecutive dim1 sticks
+  // set by any worker, FP exception flags are per-thread
+  volatile bool convert_failure;
+  volatile bool fe_underflow;
+  volatile bool fe_invalid;
+  volatile bool fe_overflow;
+  volatile bool fe_inexact;
+} stick_job;
+
+/// Record the FP exceptions raised by the calling thread in the job
 ///
-/// \param[in] in_buf data buffer to be stickified
-/// \param[out] ztensor Pointer to zdnn_ztensor to contain stickified data
-/// \param[in] saturation_control saturation control
+/// \param[in] job Pointer to the stickify job
 ///
-/// \return ZDNN_OK
-///         ZDNN_CONVERT_FAILURE
+/// \return None
 ///
-zdnn_status transform_ztensor(const void *in_buf, zdnn_ztensor *ztensor,
-                              bool saturation_control) {
-  uint64_t input_offset =
-      0; // moving position as the input is processed, in BYTES
-  uint64_t output_offset =
-      0; // moving position as the output is processed, in BYTES
+static void stick_job_merge_fp_errors(stick_job *job) {
+  int fe = fetestexcept(FE_UNDERFLOW | FE_INVALID | FE_INEXACT | FE_OVERFLOW);
+  if (fe & FE_UNDERFLOW) {
+    job->fe_underflow = true;
+  }
+  if (fe & FE_INVALID) {
+    job->fe_invalid = true;
+  }
+  if (fe & FE_OVERFLOW) {
+    job->fe_overflow = true;
+  }
+  if (fe & FE_INEXACT) {
+    job->fe_inexact = true;
+  }
+}
 
-  short input_cell_size =
-      get_data_type_size(ztensor->pre_transformed_desc->type);
-  short input_cell_shift = input_cell_size / 2;
+/// Return the FP exceptions raised by all the workers of the job
+///
+/// \param[in] job Pointer to the stick job
+///
+/// \return FE_* flags
+///
+static int stick_job_fp_errors(const stick_job *job) {
+  return (job->fe_underflow ? FE_UNDERFLOW : 0) |
+         (job->fe_invalid ? FE_INVALID : 0) |
+         (job->fe_overflow ? FE_OVERFLOW : 0) |
+         (job->fe_inexact ? FE_INEXACT : 0);
+}
 
-  /*
-   * Stores the vector operation output directly into the stick_area.  This
-   * reduces the number of inefficient loops.
-   */
-  uint32_t fields_to_convert;    // number of fields to actually convert
-  uint32_t nbr_fields_converted; // number of fields converted
+/// Number of rows per parallel chunk
+///
+/// \param[in] row_elements number of elements in a row
+///
+/// \return rows per chunk, at least 1
+///
+static inline uint64_t stick_rows_per_chunk(uint64_t row_elements) {
+  return MAX(1, STICK_ELEMENTS_PER_CHUNK / MAX(row_elements, 1));
+}
 
-  feclearexcept(
-      FE_ALL_EXCEPT); /* clear exception flags set during conversion */
+/// Stickify rows [begin, end) of a tensor whose input is laid out in the same
+/// dimension order as the transformed tensor, i.e. NHWC -> NHWC and
+/// HWCK -> HWCK.  Row r is (e4x, e3x) = (r / dim3, r % dim3).
+///
+/// \param[in] ctx Pointer to the stick_job
+/// \param[in] begin first row
+/// \param[in] end one past the last row
+///
+/// \return None
+///
+static void stickify_rows_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  stick_job *job = (stick_job *)ctx;
+  const zdnn_tensor_desc *desc = job->ztensor->transformed_desc;
+  void *out_buf = job->out_buf;
 
-  // select saturation control function if requested, otherwise pass skip func
-  void (*saturate_func)(const vec_float32 *, const vec_float32 *, vec_float32 *,
-                        vec_float32 *) = saturation_control
-                                             ? &saturate_fp32_to_dlf16
-                                             : &skip_saturate_fp32_to_dlf16;
-  if (ztensor->transformed_desc->layout == ZDNN_NHWC) {
+  // moving position as the input is processed, in BYTES
+  uint64_t input_offset = (begin * desc->dim2 * desc->dim1)
+                          << job->cell_shift;
 
-    // Expected layout is NHWC, stickify normally. Requires a single data
-    // buffer.
+  feclearexcept(FE_ALL_EXCEPT);
 
-    // If FP32 and NNPA_TRANSFORM is available, send to hardware
-    if (ztensor->pre_transformed_desc->layout != ZDNN_NCHW &&
-        ztensor->pre_transformed_desc->type == FP32 &&
-        zdnn_is_nnpa_function_installed(1, NNPA_TRANSFORM) &&
-        n_stride_meets_hardware_limit(ztensor->transformed_desc)) {
-      return hw_transform_ztensor(in_buf, saturation_control, ztensor);
-    }
+  for (uint64_t r = begin; r < end && !job->convert_failure; r++) {
+    // moving position as the output is processed, in BYTES
+    uint64_t output_offset = (r / desc->dim3) * job->bytes_per_e4x +
+                             (r % desc->dim3) * job->bytes_per_row;
 
-    // loop invariant values
-    uint64_t bytes_all_h =
-        (uint64_t)ztensor->transformed_desc->dim3 *
-        CEIL(ztensor->transformed_desc->dim2, AIU_STICKS_PER_PAGE) *
-        AIU_PAGESIZE_IN_BYTES;
-    uint64_t bytes_per_n = bytes_all_h * CEIL(ztensor->transformed_desc->dim1,
-                                              AIU_2BYTE_CELLS_PER_STICK);
-
-    if (ztensor->pre_transformed_desc->layout != ZDNN_NCHW) {
-
-      // N
-      for (uint32_t e4x = 0; e4x < ztensor->transformed_desc->dim4; e4x++) {
-
-        // used for pushing out_offset from n to n+1 (i.e., + bytes_per_n)
-        uint64_t out_offset_n = output_offset;
-
-        // H
-        for (uint32_t e3x = 0; e3x < ztensor->transformed_desc->dim3; e3x++) {
-
-          // W
-          for (uint32_t e2x = 0; e2x < ztensor->transformed_desc->dim2; e2x++) {
-            // Prefetch (read) the next input buffer to be used. The HW should
-            // "notice" our sequential accesses and continue them, so we won't
-            // need to aggressively prefetch here.
-            prefetch_read(in_buf, input_offset);
-
-            // used for pushing out_offset from w to w+1 (i.e., +
-            // AIU_BYTES_PER_STICK)
-            uint64_t out_offset_w = output_offset;
-
-            // process each C-stick (i.e., every 64 elements or whatever
-            // left in dim1)
-            for (uint32_t e1x = 0; e1x < ztensor->transformed_desc->dim1;
-                 e1x += AIU_2BYTE_CELLS_PER_STICK) {
-              // Prefetch to L1 newest offset to write that HW wouldn't
-              // know about
-              prefetch_write(ztensor->buffer, output_offset);
-              fields_to_convert = MIN((ztensor->transformed_desc->dim1 - e1x),
-                                      AIU_2BYTE_CELLS_PER_STICK);
-
-              nbr_fields_converted = convert_data_format(
-                  (void *)((uintptr_t)in_buf + input_offset),
-                  ztensor->pre_transformed_desc->type,
-                  (void *)((uintptr_t)ztensor->buffer + output_offset),
-                  ztensor->transformed_desc->type, fields_to_convert,
-                  saturate_func);
-
-              if (nbr_fields_converted == 0)
-                return ZDNN_STATUS_NO_MSG(ZDNN_CONVERT_FAILURE);
-
-              // Release L1 cacheline for stick. The next "touch" will be
-              // from NNPA, and it doesn't need L1 caching.
-              cache_flush(ztensor->buffer, output_offset);
-              input_offset += (nbr_fields_converted << input_cell_shift);
-
-              // push output_offset to the next c-stick of the same super
-              // c-stick, which is bytes_all_h number of bytes away.
-              output_offset += bytes_all_h;
-            }
+    // W (or C for HWCK)
+    for (uint32_t e2x = 0; e2x < desc->dim2; e2x++) {
+      // Prefetch (read) the next input buffer to be used. The HW should
+      // "notice" our sequential accesses and continue them, so we won't
+      // need to aggressively prefetch here.
+      prefetch_read(job->in_buf, input_offset);
 
-            // output_offset was pushed around in dim1 loops, so reset it to
-            // the next w
-            output_offset = out_offset_w + AIU_BYTES_PER_STICK;
-          }
+      // used for pushing out_offset from e2x to e2x+1 (i.e., +
+      // AIU_BYTES_PER_STICK)
+      uint64_t out_offset_e2x = output_offset;
 
-          // after processing all the w-entries, go to the next 4k-boundary
-          // location (aka stick padding)
-          output_offset = (output_offset + (AIU_PAGESIZE_IN_BYTES - 1)) &
-                          (-AIU_PAGESIZE_IN_BYTES);
+      // process each stick (i.e., every 64 elements or whatever left in dim1)
+      for (uint32_t e1x = 0; e1x < desc->dim1;
+           e1x += AIU_2BYTE_CELLS_PER_STICK) {
+        // Prefetch to L1 newest offset to write that HW wouldn't
+        // know about
+        prefetch_write(out_buf, output_offset);
+        uint32_t fields_to_convert =
+            MIN((desc->dim1 - e1x), AIU_2BYTE_CELLS_PER_STICK);
+
+        uint32_t nbr_fields_converted = convert_data_format(
+            (void *)((uintptr_t)job->in_buf + input_offset),
+            job->ztensor->pre_transformed_desc->type,
+            (void *)((uintptr_t)out_buf + output_offset), desc->type,
+            fields_to_convert, job->saturate_func);
+
+        if (nbr_fields_converted == 0) {
+          job->convert_failure = true;
+          break;
         }
 
-        // output_offset was pushed around in the dims[2-0] loops, so reset it
-        // to the next n
-        output_offset = out_offset_n + bytes_per_n;
+        // Release L1 cacheline for stick. The next "touch" will be
+        // from NNPA, and it doesn't need L1 caching.
+        cache_flush(out_buf, output_offset);
+        input_offset += (nbr_fields_converted << job->cell_shift);
+
+        // push output_offset to the next stick of the same super stick
+        output_offset += job->bytes_per_stick1;
       }
-    } else { // NCHW
-
-      uint8_t sizeof_dlf16 = get_data_type_size(ZDNN_DLFLOAT16);
-
-      // process the entire W number of entries at every pass
-      fields_to_convert = ztensor->transformed_desc->dim2;
-
-      // convert_data_format() will dump the converted entries here
-      uint16_t temp_buff[fields_to_convert];
-
-      // number of bytes to jump from the beginning of the last C-stick to the
-      // next page-boundary
-      uint64_t padding =
-          (ztensor->transformed_desc->dim2 % AIU_STICKS_PER_PAGE)
-              ? (AIU_STICKS_PER_PAGE -
-                 (ztensor->transformed_desc->dim2 % AIU_STICKS_PER_PAGE)) *
-                    AIU_BYTES_PER_STICK
-              : 0;
-
-      for (uint32_t e4x = 0; e4x < ztensor->transformed_desc->dim4; e4x++) {
-
-        uint64_t out_offset_n = output_offset;
-
-        for (uint32_t e1x = 0; e1x < ztensor->transformed_desc->dim1; e1x++) {
-
-          uint64_t output_offset_c = output_offset;
-
-          for (uint32_t e3x = 0; e3x < ztensor->transformed_desc->dim3; e3x++) {
-            // Prefetch (read) the next input buffer to be used. The HW should
-            // "notice" our sequential accesses and continue them, so we won't
-            // need to aggressively prefetch here.
-            prefetch_read(in_buf, input_offset);
-            nbr_fields_converted =
-                convert_data_format((void *)((uintptr_t)in_buf + input_offset),
-                                    ztensor->pre_transformed_desc->type,
-                                    temp_buff, ztensor->transformed_desc->type,
-                                    fields_to_convert, saturate_func);
-
-            if (nbr_fields_converted == 0)
-              return ZDNN_STATUS_NO_MSG(ZDNN_CONVERT_FAILURE);
-
-            // read each entry in temp_buff contiguously and scatter write them
-            // to stick area locations AIU_BYTES_PER_STICK bytes apart, i.e.,
-            // the same C location of the consecutive C-sticks
-            for (uint32_t w = 0; w < fields_to_convert; w++) {
-              // Prefetch to L1 newest offset to write that HW wouldn't
-              // know about
-              prefetch_write(ztensor->buffer, output_offset);
-              *(uint16_t *)((uintptr_t)ztensor->buffer + output_offset) =
-                  temp_buff[w];
-              // go to same C location of the next stick
-              output_offset += AIU_BYTES_PER_STICK;
-            }
 
-            // go to the next 4k-boundary location (aka stick padding)
-            output_offset += padding;
+      // output_offset was pushed around in dim1 loops, so reset it to
+      // the next e2x
+      output_offset = out_offset_e2x + AIU_BYTES_PER_STICK;
+    }
+  }
 
-            // push input_offset the entire W number of entries
-            input_offset += (nbr_fields_converted << input_cell_shift);
-          }
+  stick_job_merge_fp_errors(job);
+}
 
-          // go to the next C location of H = 0, W = 0
-          output_offset = output_offset_c + sizeof_dlf16;
-          if (!((e1x + 1) % AIU_2BYTE_CELLS_PER_STICK)) {
-            // but if we're at the end of C-stick, roll back 1 stick worth of
-            // bytes and jump to the the next c-stick of that super c-stick,
-            // which is bytes_all_h number of bytes away.
-            output_offset = output_offset - AIU_BYTES_PER_STICK + bytes_all_h;
-          }
+/// Stickify rows [begin, end) of an NCHW input into an NHWC ztensor.  Row r is
+/// (n, h) = (r / dim3, r % dim3), every C of it is gathered from the input.
+///
+/// \param[in] ctx Pointer to the stick_job
+/// \param[in] begin first row
+/// \param[in] end one past the last row
+///
+/// \return None
+///
+static void stickify_nchw_rows_chunk(void *ctx, uint64_t begin,
+                                     uint64_t end) {
+  stick_job *job = (stick_job *)ctx;
+  const zdnn_tensor_desc *desc = job->ztensor->transformed_desc;
+  void *out_buf = job->out_buf;
+
+  uint8_t sizeof_dlf16 = get_data_type_size(ZDNN_DLFLOAT16);
+
+  // convert_data_format() will dump the converted entries here, W is walked
+  // AIU_2BYTE_CELLS_PER_STICK entries at a time so the scratch on the pool
+  // thread's stack stays a fixed size however wide the input is
+  uint16_t temp_buff[AIU_2BYTE_CELLS_PER_STICK];
+
+  feclearexcept(FE_ALL_EXCEPT);
+
+  for (uint64_t r = begin; r < end && !job->convert_failure; r++) {
+    uint32_t e4x = r / desc->dim3;
+    uint32_t e3x = r % desc->dim3;
+
+    for (uint32_t e1x = 0; e1x < desc->dim1 && !job->convert_failure;
+         e1x++) {
+      // input is N, C, H, W
+      uint64_t input_offset =
+          ((((uint64_t)e4x * desc->dim1 + e1x) * desc->dim3 + e3x) *
+           desc->dim2)
+          << job->cell_shift;
+      // C location of W = 0 in the c-stick page set of this row
+      uint64_t output_offset =
+          e4x * job->bytes_per_e4x +
+          (e1x / AIU_2BYTE_CELLS_PER_STICK) * job->bytes_per_stick1 +
+          e3x * job->bytes_per_row +
+          (e1x % AIU_2BYTE_CELLS_PER_STICK) * sizeof_dlf16;
+
+      for (uint32_t e2x = 0; e2x < desc->dim2;
+           e2x += AIU_2BYTE_CELLS_PER_STICK) {
+        uint32_t fields_to_convert =
+            MIN((desc->dim2 - e2x), AIU_2BYTE_CELLS_PER_STICK);
+
+        // Prefetch (read) the next input buffer to be used.
+        prefetch_read(job->in_buf, input_offset);
+        uint32_t nbr_fields_converted = convert_data_format(
+            (void *)((uintptr_t)job->in_buf + input_offset),
+            job->ztensor->pre_transformed_desc->type, temp_buff, desc->type,
+            fields_to_convert, job->saturate_func);
+
+        if (nbr_fields_converted == 0) {
+          job->convert_failure = true;
+          break;
+        }
+
+        // read each entry in temp_buff contiguously and scatter write them
+        // to stick area locations AIU_BYTES_PER_STICK bytes apart, i.e.,
+        // the same C location of the consecutive C-sticks
+        for (uint32_t w = 0; w < fields_to_convert; w++) {
+          // Prefetch to L1 newest offset to write that HW wouldn't
+          // know about
+          prefetch_write(out_buf, output_offset);
+          *(uint16_t *)((uintptr_t)out_buf + output_offset) = temp_buff[w];
+          // go to same C location of the next stick
+          output_offset += AIU_BYTES_PER_STICK;
         }
 
-        // done with all the C/H/W, go to the next n
-        output_offset = out_offset_n + bytes_per_n;
+        input_offset += (uint64_t)fields_to_convert << job->cell_shift;
       }
     }
-  } else if (ztensor->transformed_desc->layout == ZDNN_HWCK) {
+  }
 
-    uint64_t bytes_per_h =
-        CEIL(ztensor->transformed_desc->dim2, AIU_STICKS_PER_PAGE) *
-        ztensor->transformed_desc->dim3 * AIU_PAGESIZE_IN_BYTES;
+  stick_job_merge_fp_errors(job);
+}
 
-    uint64_t bytes_all_h = bytes_per_h * ztensor->transformed_desc->dim4;
+/// The actual routine for stickification, only does the following:
+///    NHWC -> NHWC, NCHW -> NHWC, HWCK -> HWCK
+/// Does NOT handle concatenated types.
+///
+/// The (e4x, e3x) rows are spread over the internal thread pool, see
+/// zdnn_set_max_threads().
+///
+/// \param[in] in_buf data buffer to be stickified
+/// \param[out] ztensor Pointer to zdnn_ztensor to contain stickified data
+/// \param[in] saturation_control saturation control
+///
+/// \return ZDNN_OK
+///         ZDNN_CONVERT_FAILURE
+///
+zdnn_status transform_ztensor(const void *in_buf, zdnn_ztensor *ztensor,
+                              bool saturation_control) {
+  const zdnn_tensor_desc *desc = ztensor->transformed_desc;
+
+  stick_job job;
+  memset(&job, 0, sizeof(job));
+  job.ztensor = ztensor;
+  job.in_buf = in_buf;
+  job.out_buf = ztensor->buffer;
+  job.cell_shift =
+      get_data_type_size(ztensor->pre_transformed_desc->type) / 2;
+  // select saturation control function if requested, otherwise pass skip func
+  job.saturate_func = saturation_control ? &saturate_fp32_to_dlf16
+                                         : &skip_saturate_fp32_to_dlf16;
+  // every e3x starts on a 4k-boundary (aka stick padding)
+  job.bytes_per_row =
+      CEIL(desc->dim2, AIU_STICKS_PER_PAGE) * AIU_PAGESIZE_IN_BYTES;
 
-    // H
-    for (uint32_t e4x = 0; e4x < ztensor->transformed_desc->dim4; e4x++) {
+  parallel_func chunk_func = stickify_rows_chunk;
 
-      uint64_t out_offset_h = output_offset;
+  if (desc->layout == ZDNN_NHWC) {
 
-      // W
-      for (uint32_t e3x = 0; e3x < ztensor->transformed_desc->dim3; e3x++) {
-
-        // C
-        for (uint32_t e2x = 0; e2x < ztensor->transformed_desc->dim2; e2x++) {
-
-          uint64_t out_offset_c = output_offset;
-
-          // process each K-stick (i.e., every 64 elements or whatever
-          // left in dim1)
-          for (uint32_t e1x = 0; e1x < ztensor->transformed_desc->dim1;
-               e1x += AIU_2BYTE_CELLS_PER_STICK) {
-            // Prefetch (read) the next input buffer to be used. The HW should
-            // "notice" our sequential accesses and continue them, so we won't
-            // need to aggressively prefetch here.
-            // Also, Prefetch the new output offset to write that HW wouldn't
-            // know about.
-            prefetch_read(in_buf, input_offset);
-            prefetch_write(ztensor->buffer, output_offset);
-            fields_to_convert = MIN((ztensor->transformed_desc->dim1 - e1x),
-                                    AIU_2BYTE_CELLS_PER_STICK);
-
-            nbr_fields_converted = convert_data_format(
-                (void *)((uintptr_t)in_buf + input_offset),
-                ztensor->pre_transformed_desc->type,
-                (void *)((uintptr_t)ztensor->buffer + output_offset),
-                ztensor->transformed_desc->type, fields_to_convert,
-                saturate_func);
-
-            if (nbr_fields_converted == 0)
-              return ZDNN_STATUS_NO_MSG(ZDNN_CONVERT_FAILURE);
-
-            // push input_offset the next c-stick, fake the multiply by
-            // bit-shifting
-            input_offset += (nbr_fields_converted << input_cell_shift);
-
-            // push output_offset to the next c-stick of the same super
-            // c-stick, which is bytes_all_h number of bytes away.
-            output_offset += bytes_all_h;
-          }
+    // Expected layout is NHWC, stickify normally. Requires a single data
+    // buffer.
 
-          // output_offset was pushed around in dim1 loops, so reset it to
-          // the next c
-          output_offset = out_offset_c + AIU_BYTES_PER_STICK;
-        }
+    // If FP32 and NNPA_TRANSFORM is available, send to hardware
+    if (ztensor->pre_transformed_desc->layout != ZDNN_NCHW &&
+        ztensor->pre_transformed_desc->type == FP32 &&
+        zdnn_is_nnpa_function_installed(1, NNPA_TRANSFORM) &&
+        n_stride_meets_hardware_limit(desc) && is_within_nnpa_limits(desc)) {
+      return hw_transform_ztensor(in_buf, saturation_control, ztensor);
+    }
 
-        // after processing all the c-entries, go to the next 4k-boundary
-        // location (aka stick padding)
-        output_offset = (output_offset + (AIU_PAGESIZE_IN_BYTES - 1)) &
-                        (-AIU_PAGESIZE_IN_BYTES);
-      }
+    // c-sticks of the same super c-stick are all the h of an n apart
+    job.bytes_per_stick1 = (uint64_t)desc->dim3 * job.bytes_per_row;
+    job.bytes_per_e4x =
+        job.bytes_per_stick1 * CEIL(desc->dim1, AIU_2BYTE_CELLS_PER_STICK);
 
-      // output_offset was pushed around in the dims[2-0] loops, so reset it
-      // to the next h
-      output_offset = out_offset_h + bytes_per_h;
+    if (ztensor->pre_transformed_desc->layout == ZDNN_NCHW) {
+      chunk_func = stickify_nchw_rows_chunk;
     }
+  } else if (desc->layout == ZDNN_HWCK) {
+
+    // k-sticks of the same super k-stick are all the h of the tensor apart
+    job.bytes_per_e4x = (uint64_t)desc->dim3 * job.bytes_per_row;
+    job.bytes_per_stick1 = job.bytes_per_e4x * desc->dim4;
   } else {
     // caller messed up if we ever arrive here
     return ZDNN_STATUS(ZDNN_INVALID_LAYOUT,
                        "Invalid layout for transformation: %s",
-                       get_data_layout_str(ztensor->transformed_desc->layout));
+                       get_data_layout_str(desc->layout));
+  }
+
+  run_parallel((uint64_t)desc->dim4 * desc->dim3,
+               stick_rows_per_chunk((uint64_t)desc->dim2 * desc->dim1),
+               chunk_func, &job);
+
+  if (job.convert_failure) {
+    return ZDNN_STATUS_NO_MSG(ZDNN_CONVERT_FAILURE);
   }
 
   /* handle any FP errors or return success */
+  int fe = stick_job_fp_errors(&job);
+
   // Handle saturation vs no saturation differently to match the HW
   zdnn_status fp_error;
   if (saturation_control == true) {
-    fp_error = handle_fp_errors_saturation(
-        fetestexcept(FE_UNDERFLOW | FE_INVALID | FE_INEXACT | FE_OVERFLOW),
-        ztensor->pre_transformed_desc->type);
+    fp_error =
+        handle_fp_errors_saturation(fe, ztensor->pre_transformed_desc->type);
     if (fp_error != ZDNN_OK) {
       return fp_error;
     }
 
   } else {
-    fp_error = handle_fp_errors(
-        fetestexcept(FE_UNDERFLOW | FE_INVALID | FE_INEXACT | FE_OVERFLOW));
+    fp_error = handle_fp_errors(fe);
     if (fp_error != ZDNN_OK) {
       return fp_error;
     }
@@ -944,10 +1035,10 @@ zdnn_status transform_ztensor_smalldim1(const void *in_buf,
           cur_input_data = (vec_float32 *)(cur_input_data) + 2;
           break;
         case BFLOAT:
-          tmp_vector_16[0] =
-              vec_mergeh(*(vec_int16 *)(cur_input_data), zero_vector16);
-          tmp_vector_16[1] =
-              vec_mergel(*(vec_int16 *)(cur_input_data), zero_vector16);
+          tmp_vector_16[0] = VEC_MERGEH_HALFWORDS(
+              *(vec_int16 *)(cur_input_data), zero_vector16);
+          tmp_vector_16[1] = VEC_MERGEL_HALFWORDS(
+              *(vec_int16 *)(cur_input_data), zero_vector16);
           tmp_out = aiu_vec_round_from_fp32((vec_float32)tmp_vector_16[0],
                                             (vec_float32)tmp_vector_16[1]);
           // advance 1 vector worth of entries
@@ -1001,8 +1092,8 @@ zdnn_status transform_ztensor_smalldim1(const void *in_buf,
         case BFLOAT:
           in_vector_16 = vec_load_len((uint16_t *)cur_input_data,
                                       remaining_bytes_to_get - 1);
-          tmp_vector_16[0] = vec_mergeh(in_vector_16, zero_vector16);
-          tmp_vector_16[1] = vec_mergel(in_vector_16, zero_vector16);
+          tmp_vector_16[0] = VEC_MERGEH_HALFWORDS(in_vector_16, zero_vector16);
+          tmp_vector_16[1] = VEC_MERGEL_HALFWORDS(in_vector_16, zero_vector16);
           tmp_out = aiu_vec_round_from_fp32((vec_float32)tmp_vector_16[0],
                                             (vec_float32)tmp_vector_16[1]);
           break;
@@ -1081,6 +1172,11 @@ zdnn_status zdnn_transform_ztensor(zdnn_ztensor *ztensor, ...) {
             get_data_type_str(ztensor->pre_transformed_desc->type),
             get_data_type_str(ztensor->transformed_desc->type));
 
+  if ((status = check_op_plan_recordable("zdnn_transform_ztensor")) !=
+      ZDNN_OK) {
+    return status;
+  }
+
   if ((status = verify_descriptors_transform_ztensor(ztensor)) != ZDNN_OK) {
     return status;
   }
@@ -1355,47 +1451,13 @@ zdnn_status zdnn_transform_ztensor_with_saturation(zdnn_ztensor *ztensor, ...) {
             get_data_type_str(ztensor->pre_transformed_desc->type),
             get_data_type_str(ztensor->transformed_desc->type));
 
-  if ((status = verify_descriptors_transform_ztensor(ztensor)) != ZDNN_OK) {
+  if ((status = check_op_plan_recordable(
+           "zdnn_transform_ztensor_with_saturation")) != ZDNN_OK) {
     return status;
   }
 
-  const uint32_t *dims_ptr = &(ztensor->transformed_desc->dim4);
-
-  // is the dimension above the limit or zero?
-  // transformed layout uses all dim* entries, so we'll check them all
-  for (int i = 0; i < ZDNN_MAX_DIMS; i++) {
-    LOG_DEBUG("dim%d: %d", ZDNN_MAX_DIMS - i, dims_ptr[i]);
-    if (!dims_ptr[i]) {
-      return ZDNN_STATUS(ZDNN_INVALID_SHAPE,
-                         "Invalid shape for dim%d. (reason: dimension is 0)",
-                         ZDNN_MAX_DIMS - i);
-    }
-
-    if (dims_ptr[i] > zdnn_get_max_for_dim(ZDNN_MAX_DIMS - i)) {
-
-      if (!zdnn_get_max_for_dim(ZDNN_MAX_DIMS - i)) {
-        return ZDNN_STATUS(ZDNN_UNSUPPORTED_AIU_EXCEPTION,
-                           "Unable to verify shape. (reason: HW environment "
-                           "may not be setup properly)",
-                           NO_ARG);
-      } else {
-        return ZDNN_STATUS(
-            ZDNN_INVALID_SHAPE,
-            "Invalid shape for dim%d. (reason: dimension value %d exceeds %d)",
-            ZDNN_MAX_DIMS - i, dims_ptr[i],
-            zdnn_get_max_for_dim(ZDNN_MAX_DIMS - i));
-      }
-    }
-  }
-
-  // is stick area size above the limit?
-  if (zdnn_getsize_ztensor(ztensor->transformed_desc) >
-      zdnn_get_nnpa_max_tensor_size()) {
-    return ZDNN_STATUS(ZDNN_INVALID_SHAPE,
-                       "Invalid shape (reasons: tensor size: %" PRIu64
-                       ", maximum: %" PRIu64 " bytes",
-                       zdnn_getsize_ztensor(ztensor->transformed_desc),
-                       zdnn_get_nnpa_max_tensor_size());
+  if ((status = verify_descriptors_transform_ztensor(ztensor)) != ZDNN_OK) {
+    return status;
   }
 
   /*
@@ -1430,7 +1492,8 @@ zdnn_status zdnn_transform_ztensor_with_saturation(zdnn_ztensor *ztensor, ...) {
   return status;
 }
 
-zdnn_status transform_quantized_ztensor(const void *in_buf, int8_t clip_min,
+zdnn_status transform_quantized_ztensor(const void *in_buf, float rec_scale,
+                                        float offset, int8_t clip_min,
                                         int8_t clip_max, zdnn_ztensor *output) {
   // Create a temporary ztensor to point to user's data buffer
   zdnn_tensor_desc temp_desc;
@@ -1453,8 +1516,8 @@ zdnn_status transform_quantized_ztensor(const void *in_buf, int8_t clip_min,
   func_sp_parms_transform *fsp_transform = (func_sp_parms_transform *)&fsp;
   // Setup Function Specific Parameters:
   fsp_transform->parm1.toc = NNPA_TOC_STICK_INT8;
-  fsp_transform->parm2.rec_scale = cnvt_1_fp32_to_dlf16(output->rec_scale);
-  fsp_transform->parm3.offset = cnvt_1_fp32_to_dlf16(output->offset);
+  fsp_transform->parm2.rec_scale = cnvt_1_fp32_to_dlf16(rec_scale);
+  fsp_transform->parm3.offset = cnvt_1_fp32_to_dlf16(offset);
   fsp_transform->parm4.clip_min = clip_min;
   fsp_transform->parm5.clip_max = clip_max;
 
@@ -1645,6 +1708,39 @@ zdnn_status transform_quantized_weights_ztensor(const void *in_buf,
   return ZDNN_STATUS_OK;
 }
 
+/// Converts num_elements fp16 values to fp32
+///
+/// \param[in] data16 fp16 values
+/// \param[out] data32 fp32 values, with room for num_elements rounded up to a
+///                    multiple of STICKCVT_MAX_ENTRIES_TO_CONVERT
+/// \param[in] num_elements number of values to convert
+///
+/// \return None
+///
+static void fp16_to_fp32(const uint16_t *data16, float *data32,
+                         uint64_t num_elements) {
+  uint16_t tmp_dlf16[STICKCVT_MAX_ENTRIES_TO_CONVERT] = {0};
+
+  // do the full STICKCVT_MAX_ENTRIES_TO_CONVERT groups 1st
+  for (uint64_t i = 0; i < num_elements / STICKCVT_MAX_ENTRIES_TO_CONVERT;
+       i++) {
+
+    fp16_to_dlf16((uint16_t *)data16, tmp_dlf16,
+                  STICKCVT_MAX_ENTRIES_TO_CONVERT);
+    dlf16_to_fp32(tmp_dlf16, data32, STICKCVT_MAX_ENTRIES_TO_CONVERT);
+
+    data16 += STICKCVT_MAX_ENTRIES_TO_CONVERT;
+    data32 += STICKCVT_MAX_ENTRIES_TO_CONVERT;
+  }
+
+  // do the leftovers
+  if (num_elements % STICKCVT_MAX_ENTRIES_TO_CONVERT) {
+    fp16_to_dlf16((uint16_t *)data16, tmp_dlf16,
+                  num_elements % STICKCVT_MAX_ENTRIES_TO_CONVERT);
+    dlf16_to_fp32(tmp_dlf16, data32, STICKCVT_MAX_ENTRIES_TO_CONVERT);
+  }
+}
+
 /// Converts a data buffer of fp16 to fp32 and stores it into a malloc'd space.
 float *convert_fp16_fp32_and_store(zdnn_tensor_desc *tfd_desc,
                                    const void *data) {
@@ -1662,35 +1758,21 @@ float *convert_fp16_fp32_and_store(zdnn_tensor_desc *tfd_desc,
     return NULL;
   }
 
-  uint16_t tmp_dlf16[STICKCVT_MAX_ENTRIES_TO_CONVERT] = {0};
-
-  uint16_t *data16 = (uint16_t *)(data);
-  float *data32 = fp32_data;
-
-  // do the full STICKCVT_MAX_ENTRIES_TO_CONVERT groups 1st
-  for (uint64_t i = 0; i < total_elements / STICKCVT_MAX_ENTRIES_TO_CONVERT;
-       i++) {
-
-    fp16_to_dlf16(data16, tmp_dlf16, STICKCVT_MAX_ENTRIES_TO_CONVERT);
-    dlf16_to_fp32(tmp_dlf16, data32, STICKCVT_MAX_ENTRIES_TO_CONVERT);
-
-    data16 += STICKCVT_MAX_ENTRIES_TO_CONVERT;
-    data32 += STICKCVT_MAX_ENTRIES_TO_CONVERT;
-  }
-
-  // do the leftovers
-  if (total_elements % STICKCVT_MAX_ENTRIES_TO_CONVERT) {
-    fp16_to_dlf16(data16, tmp_dlf16,
-                  total_elements % STICKCVT_MAX_ENTRIES_TO_CONVERT);
-    dlf16_to_fp32(tmp_dlf16, data32, STICKCVT_MAX_ENTRIES_TO_CONVERT);
-  }
+  fp16_to_fp32((uint16_t *)data, fp32_data, total_elements);
 
   return fp32_data;
 }
 
-/// Converts a data buffer of bfloat to fp32 and stores it into a malloc'd
-/// space.
-float *convert_bf_fp32_and_store(zdnn_tensor_desc *tfd_desc, const void *data) {
+/// Converts num_elements bfloat values to fp32
+///
+/// \param[in] data16 bfloat values
+/// \param[out] data32 fp32 values
+/// \param[in] num_elements number of values to convert
+///
+/// \return None
+///
+static void bf_to_fp32(const uint16_t *data16, float *data32,
+                       uint64_t num_elements) {
 
   // vec_perm(): vector1 bytes are indexed 0 - 15, vector2 16 - 31
   //
@@ -1699,31 +1781,30 @@ float *convert_bf_fp32_and_store(zdnn_tensor_desc *tfd_desc, const void *data) {
   // 1st 2 bytes from vector2, then
   // 2nd 2 bytes from vector1, then
   // 2nd 2 bytes from vector2, and so forth
+  //
+  // (on little-endian hosts the vector2 bytes go first so the bfloat still
+  // lands in the high-order half of the fp32)
+#if defined(ZDNN_VEC_BIG_ENDIAN)
   vec_char8 sel_vec_full = {0, 1, 16, 17, 2, 3, 18, 19,
                             4, 5, 20, 21, 6, 7, 22, 23};
-
-  vec_char8 sel_vec_partial = {0};
+#else
+  vec_char8 sel_vec_full = {16, 17, 0, 1, 18, 19, 2, 3,
+                            20, 21, 4, 5, 22, 23, 6, 7};
+#endif
 
   vec_int16 zeros = {0};
 
-  // selection vector for the leftovers when e1 isn't multiples of
-  // VECPERM_MAX_BFLOAT_ENTRIES
-  memcpy((void *)&sel_vec_partial, (void *)&sel_vec_full,
-         (tfd_desc->dim1 % VECPERM_MAX_BFLOAT_ENTRIES) * 2);
-
-  uint64_t total_elements = (uint64_t)tfd_desc->dim4 * tfd_desc->dim3 *
-                            tfd_desc->dim2 * tfd_desc->dim1;
-
-  float *fp32_data = malloc(sizeof(float) * total_elements);
-  if (fp32_data == NULL) {
-    return NULL;
-  }
-
-  uint16_t *data16 = (uint16_t *)(data);
-  float *data32 = fp32_data;
+  // a group loads a whole vector of bfloats but converts only the first
+  // VECPERM_MAX_BFLOAT_ENTRIES of them, so the last group or so is left to the
+  // leftovers to not read past the end of the input
+  uint64_t full_groups =
+      num_elements < 2 * VECPERM_MAX_BFLOAT_ENTRIES
+          ? 0
+          : num_elements / VECPERM_MAX_BFLOAT_ENTRIES - 1;
+  uint64_t leftovers = num_elements - full_groups * VECPERM_MAX_BFLOAT_ENTRIES;
 
   // do the full VECPERM_MAX_BFLOAT_ENTRIES groups 1st
-  for (uint64_t i = 0; i < total_elements / VECPERM_MAX_BFLOAT_ENTRIES; i++) {
+  for (uint64_t i = 0; i < full_groups; i++) {
 
     // cppcheck-suppress invalidPointerCast
     *(vec_int16 *)data32 = vec_perm(*(vec_int16 *)data16, zeros, sel_vec_full);
@@ -1732,43 +1813,49 @@ float *convert_bf_fp32_and_store(zdnn_tensor_desc *tfd_desc, const void *data) {
     data32 += VECPERM_MAX_BFLOAT_ENTRIES;
   }
 
-  // do the leftovers
-  if (total_elements % VECPERM_MAX_BFLOAT_ENTRIES) {
-    // cppcheck-suppress invalidPointerCast
-    *(vec_int16 *)data32 =
-        vec_perm(*(vec_int16 *)data16, zeros, sel_vec_partial);
+  // do the leftovers, up to VECPERM_MAX_BFLOAT_ENTRIES at a time
+  while (leftovers) {
+    uint32_t entries = MIN(leftovers, VECPERM_MAX_BFLOAT_ENTRIES);
+    vec_int16 in_vector = vec_load_len(data16, entries * sizeof(uint16_t) - 1);
+    vec_store_len(vec_perm(in_vector, zeros, sel_vec_full), (uint16_t *)data32,
+                  entries * sizeof(float) - 1);
+
+    data16 += entries;
+    data32 += entries;
+    leftovers -= entries;
+  }
+}
+
+/// Converts a data buffer of bfloat to fp32 and stores it into a malloc'd
+/// space.
+float *convert_bf_fp32_and_store(zdnn_tensor_desc *tfd_desc, const void *data) {
+  uint64_t total_elements = (uint64_t)tfd_desc->dim4 * tfd_desc->dim3 *
+                            tfd_desc->dim2 * tfd_desc->dim1;
+
+  float *fp32_data = malloc(sizeof(float) * total_elements);
+  if (fp32_data == NULL) {
+    return NULL;
   }
 
+  bf_to_fp32((uint16_t *)data, fp32_data, total_elements);
+
   return fp32_data;
 }
 
-/// Converts the input tensor to a quantized stick format for
-/// execution by zDNN operations.
+/// Verify the buffer, state, layouts and dimensions of a zTensor about to
+/// receive quantized data
 ///
+/// \param[in] ztensor Pointer to zdnn_ztensor to be transformed into
 ///
 /// \return ZDNN_OK
-///         ZDNN_INVALID_FORMAT
 ///         ZDNN_INVALID_LAYOUT
-///         ZDNN_INVALID_TYPE
 ///         ZDNN_INVALID_SHAPE
 ///         ZDNN_INVALID_BUFFER
 ///         ZDNN_INVALID_STATE
-///         ZDNN_CONVERT_FAILURE
-///         ZDNN_ALLOCATION_FAILURE
 ///
-zdnn_status zdnn_transform_quantized_ztensor(zdnn_ztensor *ztensor,
-                                             bool saturation_control,
-                                             int8_t clip_min, int8_t clip_max,
-                                             const void *data) {
+static zdnn_status verify_quantized_transform(zdnn_ztensor *ztensor) {
   zdnn_status status;
 
-  LOG_DEBUG("zdnn_transform_quantized_ztensor layout %s -> %s",
-            get_data_layout_str(ztensor->pre_transformed_desc->layout),
-            get_data_layout_str(ztensor->transformed_desc->layout));
-  LOG_DEBUG("zdnn_transform_quantized_ztensor type %s -> %s",
-            get_data_type_str(ztensor->pre_transformed_desc->type),
-            get_data_type_str(ztensor->transformed_desc->type));
-
   /*
    * Check for buffer issues. Return an error if:
    *
@@ -1789,6 +1876,9 @@ zdnn_status zdnn_transform_quantized_ztensor(zdnn_ztensor *ztensor,
                        NO_ARG);
   }
 
+  // biases zdnn_quantized_matmul_op() computed from the old data are stale
+  invalidate_qmatmul_bias_cache(ztensor->buffer);
+
   // Make sure layout is ZDNN_NHWC
   if (ztensor->transformed_desc->layout != ZDNN_NHWC) {
     return ZDNN_STATUS(ZDNN_INVALID_LAYOUT,
@@ -1819,25 +1909,64 @@ zdnn_status zdnn_transform_quantized_ztensor(zdnn_ztensor *ztensor,
     return status;
   }
 
-  if (ztensor->transformed_desc->format == ZDNN_FORMAT_4DFEATURE) {
-    if (ztensor->transformed_desc->type == ZDNN_DLFLOAT16) {
-      switch (ztensor->pre_transformed_desc->type) {
-      case FP32:
-        status = hw_transform_ztensor(data, saturation_control, ztensor);
-        break;
-      case FP16:
-      case BFLOAT:
-        status = transform_ztensor(data, ztensor, false);
-        break;
-      default:
-        status =
-            ZDNN_STATUS(ZDNN_INVALID_TYPE,
-                        "Invalid pre-transform type to be transformed to "
-                        "quantized type of DLFLOAT16: %d (%s)",
-                        ztensor->transformed_desc->type,
-                        get_data_type_str(ztensor->transformed_desc->type));
-      }
-    } else if (ztensor->transformed_desc->type == ZDNN_BINARY_INT8) {
+  return ZDNN_STATUS_OK;
+}
+
+/// Converts the input tensor to a quantized stick format for
+/// execution by zDNN operations.
+///
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_FORMAT
+///         ZDNN_INVALID_LAYOUT
+///         ZDNN_INVALID_TYPE
+///         ZDNN_INVALID_SHAPE
+///         ZDNN_INVALID_BUFFER
+///         ZDNN_INVALID_STATE
+///         ZDNN_CONVERT_FAILURE
+///         ZDNN_ALLOCATION_FAILURE
+///
+zdnn_status zdnn_transform_quantized_ztensor(zdnn_ztensor *ztensor,
+                                             bool saturation_control,
+                                             int8_t clip_min, int8_t clip_max,
+                                             const void *data) {
+  zdnn_status status;
+
+  LOG_DEBUG("zdnn_transform_quantized_ztensor layout %s -> %s",
+            get_data_layout_str(ztensor->pre_transformed_desc->layout),
+            get_data_layout_str(ztensor->transformed_desc->layout));
+  LOG_DEBUG("zdnn_transform_quantized_ztensor type %s -> %s",
+            get_data_type_str(ztensor->pre_transformed_desc->type),
+            get_data_type_str(ztensor->transformed_desc->type));
+
+  if ((status = check_op_plan_recordable("zdnn_transform_quantized_ztensor")) !=
+      ZDNN_OK) {
+    return status;
+  }
+
+  if ((status = verify_quantized_transform(ztensor)) != ZDNN_OK) {
+    return status;
+  }
+
+  if (ztensor->transformed_desc->format == ZDNN_FORMAT_4DFEATURE) {
+    if (ztensor->transformed_desc->type == ZDNN_DLFLOAT16) {
+      switch (ztensor->pre_transformed_desc->type) {
+      case FP32:
+        status = hw_transform_ztensor(data, saturation_control, ztensor);
+        break;
+      case FP16:
+      case BFLOAT:
+        status = transform_ztensor(data, ztensor, false);
+        break;
+      default:
+        status =
+            ZDNN_STATUS(ZDNN_INVALID_TYPE,
+                        "Invalid pre-transform type to be transformed to "
+                        "quantized type of DLFLOAT16: %d (%s)",
+                        ztensor->transformed_desc->type,
+                        get_data_type_str(ztensor->transformed_desc->type));
+      }
+    } else if (ztensor->transformed_desc->type == ZDNN_BINARY_INT8) {
       zdnn_tensor_desc *pt_desc = ztensor->pre_transformed_desc;
       zdnn_tensor_desc *tfd_desc = ztensor->transformed_desc;
       switch (pt_desc->type) {
@@ -1851,8 +1980,9 @@ zdnn_status zdnn_transform_quantized_ztensor(zdnn_ztensor *ztensor,
               NO_ARG);
         }
 
-        status =
-            transform_quantized_ztensor(fp32_data, clip_min, clip_max, ztensor);
+        status = transform_quantized_ztensor(fp32_data, ztensor->rec_scale,
+                                             ztensor->offset, clip_min,
+                                             clip_max, ztensor);
         free(fp32_data);
         break;
       }
@@ -1865,13 +1995,16 @@ zdnn_status zdnn_transform_quantized_ztensor(zdnn_ztensor *ztensor,
               "Unable to allocate required bytes for bf to fp32 conversion.",
               NO_ARG);
         }
-        status =
-            transform_quantized_ztensor(fp32_data, clip_min, clip_max, ztensor);
+        status = transform_quantized_ztensor(fp32_data, ztensor->rec_scale,
+                                             ztensor->offset, clip_min,
+                                             clip_max, ztensor);
         free(fp32_data);
         break;
       }
       case FP32:
-        status = transform_quantized_ztensor(data, clip_min, clip_max, ztensor);
+        status = transform_quantized_ztensor(data, ztensor->rec_scale,
+                                             ztensor->offset, clip_min,
+                                             clip_max, ztensor);
         break;
       case INT8:
         status = transform_quantized_int8_ztensor(data, ztensor);
@@ -1915,6 +2048,268 @@ zdnn_status zdnn_transform_quantized_ztensor(zdnn_ztensor *ztensor,
   return status;
 }
 
+// elements reduced per parallel chunk while looking for the range of the data
+// of a dynamically quantized transform
+#define RANGE_ELEMENTS_PER_CHUNK 65536
+
+typedef VEC_UNALIGNED float vec_fp32;
+
+// State shared by the workers finding the range of the data of
+// zdnn_transform_dynamic_quantized_ztensor().  FP16 and BFLOAT data is staged
+// as FP32 chunk by chunk and reduced while the chunk is still in cache, so the
+// caller's data is read only once before the transform.
+typedef struct range_job {
+  const void *in_buf;    // data to be quantized
+  zdnn_data_types type;  // pre-transformed type of in_buf
+  float *fp32_buf;       // FP32 values of in_buf, in_buf itself if FP32
+  float *mins, *maxs;    // range of each chunk
+} range_job;
+
+/// Find the range of num_elements FP32 values.  The range always includes 0,
+/// the same as zdnn_getrange_ztensor().
+///
+/// \param[in] data FP32 values
+/// \param[in] num_elements number of values
+/// \param[out] min minimum value, no greater than 0
+/// \param[out] max maximum value, no less than 0
+///
+/// \return None
+///
+static void fp32_range(const float *data, uint64_t num_elements, float *min,
+                       float *max) {
+  // two sets of accumulators so consecutive vectors don't wait on each other
+  vec_fp32 min_vec[2] = {vec_splats(0.f), vec_splats(0.f)};
+  vec_fp32 max_vec[2] = {vec_splats(0.f), vec_splats(0.f)};
+
+  uint64_t i = 0;
+  for (; i + 8 <= num_elements; i += 8) {
+    vec_fp32 in0 = *(vec_fp32 *)&data[i];
+    vec_fp32 in1 = *(vec_fp32 *)&data[i + 4];
+    min_vec[0] = vec_min(min_vec[0], in0);
+    max_vec[0] = vec_max(max_vec[0], in0);
+    min_vec[1] = vec_min(min_vec[1], in1);
+    max_vec[1] = vec_max(max_vec[1], in1);
+  }
+  min_vec[0] = vec_min(min_vec[0], min_vec[1]);
+  max_vec[0] = vec_max(max_vec[0], max_vec[1]);
+
+  float min_val = 0.f, max_val = 0.f;
+  for (int j = 0; j < 4; j++) {
+    min_val = MIN(min_val, min_vec[0][j]);
+    max_val = MAX(max_val, max_vec[0][j]);
+  }
+
+  // leftovers
+  for (; i < num_elements; i++) {
+    min_val = MIN(min_val, data[i]);
+    max_val = MAX(max_val, data[i]);
+  }
+
+  *min = min_val;
+  *max = max_val;
+}
+
+/// Stage elements [begin, end) as FP32 if needed and find the range of every
+/// RANGE_ELEMENTS_PER_CHUNK chunk of them.  run_parallel() hands out a single
+/// chunk at a time, or the whole range when it runs inline.
+///
+/// \param[in] ctx Pointer to the range_job
+/// \param[in] begin first element, at the start of a chunk
+/// \param[in] end one past the last element
+///
+/// \return None
+///
+static void range_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  range_job *job = (range_job *)ctx;
+
+  for (uint64_t first = begin; first < end;
+       first += RANGE_ELEMENTS_PER_CHUNK) {
+    uint64_t count = MIN(end - first, RANGE_ELEMENTS_PER_CHUNK);
+    uint64_t chunk = first / RANGE_ELEMENTS_PER_CHUNK;
+    float *fp32_data = job->fp32_buf + first;
+
+    switch (job->type) {
+    case FP16:
+      fp16_to_fp32((const uint16_t *)job->in_buf + first, fp32_data, count);
+      break;
+    case BFLOAT:
+      bf_to_fp32((const uint16_t *)job->in_buf + first, fp32_data, count);
+      break;
+    default:
+      break;
+    }
+
+    fp32_range(fp32_data, count, &job->mins[chunk], &job->maxs[chunk]);
+  }
+}
+
+/// Derive the scale and offset that map [min, max] onto [INT8_MIN, INT8_MAX]
+///
+/// \param[in] min minimum value, no greater than 0
+/// \param[in] max maximum value, no less than 0
+/// \param[out] scale scale
+/// \param[out] offset offset, an integer so that 0 is exactly representable
+///
+/// \return None
+///
+static void range_to_scale_offset(float min, float max, float *scale,
+                                  float *offset) {
+  // all zeros, any scale will do
+  if (max - min == 0.f) {
+    *scale = 1.f;
+    *offset = 0.f;
+    return;
+  }
+
+  *scale = (max - min) / 255.f;
+
+  // min quantizes to INT8_MIN, always within [INT8_MIN, INT8_MAX] as min <= 0
+  float zero_point = INT8_MIN - min / *scale;
+  *offset =
+      (float)(int)(zero_point < 0 ? zero_point - 0.5f : zero_point + 0.5f);
+}
+
+/// Converts the input tensor to a quantized stick format, with a scale and
+/// offset derived from the range of the input data.
+///
+/// \param[in] ztensor Pointer to zdnn_ztensor to contain the quantized data,
+///                    its rec_scale and offset are set once the
+///                    transform succeeds
+/// \param[in] saturation_control saturation control, QUANTIZED_DLFLOAT16 only
+/// \param[in] clip_min minimum clipping value, QUANTIZED_INT8 only
+/// \param[in] clip_max maximum clipping value, QUANTIZED_INT8 only
+/// \param[in] data FP32, FP16 or BFLOAT data to be quantized
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_FORMAT
+///         ZDNN_INVALID_LAYOUT
+///         ZDNN_INVALID_TYPE
+///         ZDNN_INVALID_SHAPE
+///         ZDNN_INVALID_BUFFER
+///         ZDNN_INVALID_STATE
+///         ZDNN_CONVERT_FAILURE
+///         ZDNN_ALLOCATION_FAILURE
+///
+zdnn_status zdnn_transform_dynamic_quantized_ztensor(zdnn_ztensor *ztensor,
+                                                     bool saturation_control,
+                                                     int8_t clip_min,
+                                                     int8_t clip_max,
+                                                     const void *data) {
+  zdnn_status status;
+
+  LOG_DEBUG("zdnn_transform_dynamic_quantized_ztensor type %s -> %s",
+            get_data_type_str(ztensor->pre_transformed_desc->type),
+            get_data_type_str(ztensor->transformed_desc->type));
+
+  if ((status = check_op_plan_recordable(
+           "zdnn_transform_dynamic_quantized_ztensor")) != ZDNN_OK) {
+    return status;
+  }
+
+  if ((status = verify_quantized_transform(ztensor)) != ZDNN_OK) {
+    return status;
+  }
+
+  zdnn_tensor_desc *tfd_desc = ztensor->transformed_desc;
+  zdnn_data_types type = ztensor->pre_transformed_desc->type;
+
+  if (tfd_desc->format != ZDNN_FORMAT_4DFEATURE) {
+    return ZDNN_STATUS(ZDNN_INVALID_FORMAT,
+                       "Invalid transform format for dynamic quantization: "
+                       "%d (%s)",
+                       tfd_desc->format,
+                       get_data_format_str(tfd_desc->format));
+  }
+
+  if (type != FP32 && type != FP16 && type != BFLOAT) {
+    return ZDNN_STATUS(ZDNN_INVALID_TYPE,
+                       "Invalid pre-transform type for dynamic quantization: "
+                       "%d (%s)",
+                       type, get_data_type_str(type));
+  }
+
+  float min, max, scale, offset;
+
+  if (tfd_desc->type == ZDNN_DLFLOAT16) {
+    // the values are stored unscaled, so take their range from the stick area
+    // rather than reading the larger input a second time
+    status = zdnn_transform_quantized_ztensor(ztensor, saturation_control,
+                                              clip_min, clip_max, data);
+    if (!ztensor->is_transformed) {
+      return status;
+    }
+    zdnn_status range_status = zdnn_getrange_ztensor(ztensor, &min, &max);
+    if (range_status != ZDNN_OK) {
+      // without a range there is no scale to go with the stickified values
+      ztensor->is_transformed = false;
+      return range_status;
+    }
+    range_to_scale_offset(min, max, &scale, &offset);
+    ztensor->rec_scale = 1.f / scale;
+    ztensor->offset = offset;
+    return status;
+  }
+
+  if (tfd_desc->type != ZDNN_BINARY_INT8) {
+    return ZDNN_STATUS(ZDNN_INVALID_TYPE,
+                       "Invalid transform type for transformation: %d (%s)",
+                       tfd_desc->type, get_data_type_str(tfd_desc->type));
+  }
+
+  uint64_t total_elements = (uint64_t)tfd_desc->dim4 * tfd_desc->dim3 *
+                            tfd_desc->dim2 * tfd_desc->dim1;
+  uint64_t num_chunks = CEIL(total_elements, RANGE_ELEMENTS_PER_CHUNK);
+
+  range_job job;
+  job.in_buf = data;
+  job.type = type;
+  job.mins = malloc(2 * num_chunks * sizeof(float));
+  job.maxs = job.mins + num_chunks;
+  if (type == FP32) {
+    job.fp32_buf = (float *)data;
+  } else {
+    // fp16_to_fp32() converts whole STICKCVT_MAX_ENTRIES_TO_CONVERT groups
+    job.fp32_buf =
+        malloc(sizeof(float) *
+               CEIL(total_elements, STICKCVT_MAX_ENTRIES_TO_CONVERT) *
+               STICKCVT_MAX_ENTRIES_TO_CONVERT);
+  }
+
+  if (job.mins == NULL || job.fp32_buf == NULL) {
+    free(job.mins);
+    if (type != FP32) {
+      free(job.fp32_buf);
+    }
+    return ZDNN_STATUS(
+        ZDNN_ALLOCATION_FAILURE,
+        "Unable to allocate required bytes for dynamic quantization.", NO_ARG);
+  }
+
+  run_parallel(total_elements, RANGE_ELEMENTS_PER_CHUNK, range_chunk, &job);
+
+  min = 0.f;
+  max = 0.f;
+  for (uint64_t i = 0; i < num_chunks; i++) {
+    min = MIN(min, job.mins[i]);
+    max = MAX(max, job.maxs[i]);
+  }
+  range_to_scale_offset(min, max, &scale, &offset);
+
+  // leave the ztensor's scale and offset alone unless the transform succeeds
+  status = transform_quantized_ztensor(job.fp32_buf, 1.f / scale, offset,
+                                       clip_min, clip_max, ztensor);
+  if (status == ZDNN_OK) {
+    ztensor->rec_scale = 1.f / scale;
+    ztensor->offset = offset;
+  }
+
+  free(job.mins);
+  if (type != FP32) {
+    free(job.fp32_buf);
+  }
+  return status;
+}
+
 /// Call HW to transform from DLFLOAT16 -> FP32 only.
 ///
 /// \param[in] input Pointer to zdnn_ztensor, containing data to be
@@ -1965,210 +2360,282 @@ zdnn_status hw_transform_origtensor(const zdnn_ztensor *input, void *out_buf) {
 
 // ------------------------------------------------------------------------------------------------
 
-/// The actual routine for unstickification, only does the following:
-///    NHWC -> NHWC, NHWC -> NCHW
-/// Does NOT handle concatenated types nor HWCK
+/// Unstickify rows [begin, end) of an NHWC ztensor into an NHWC (or any
+/// non-NCHW) output.  Row r is (e4x, e3x) = (r / dim3, r % dim3), which is
+/// contiguous in the output.
 ///
-/// \param[in] ztensor Pointer to zdnn_ztensor, containing data to be
-///                    unstickified
-/// \param[out] out_buf data buffer to unstickify to
+/// \param[in] ctx Pointer to the stick_job
+/// \param[in] begin first row
+/// \param[in] end one past the last row
 ///
-/// \return ZDNN_OK
-///         ZDNN_CONVERT_FAILURE
+/// \return None
 ///
-zdnn_status transform_origtensor(const zdnn_ztensor *ztensor, void *out_buf) {
-  uint64_t output_offset =
-      0; // moving position as the output is processed, in BYTES
-  uint64_t input_offset =
-      0; // moving position as the input is processed, in BYTES
+static void unstickify_rows_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  stick_job *job = (stick_job *)ctx;
+  const zdnn_tensor_desc *desc = job->ztensor->transformed_desc;
+  zdnn_data_types out_type = job->ztensor->pre_transformed_desc->type;
+  bool streaming = streaming_stores_enabled;
 
-  short output_cell_size =
-      get_data_type_size(ztensor->pre_transformed_desc->type);
-  short output_cell_shift = output_cell_size / 2;
+  // one stick worth of converted entries when using streaming stores
+  vec_float32 staging[AIU_2BYTE_CELLS_PER_STICK * sizeof(float) /
+                      sizeof(vec_float32)];
 
-  uint32_t fields_to_convert;    // number of fields to actually convert
-  uint32_t nbr_fields_converted; // number of fields converted
+  // moving position as the output is processed, in BYTES
+  uint64_t output_offset = (begin * desc->dim2 * desc->dim1)
+                           << job->cell_shift;
 
-  // loop invariant values
-  uint64_t bytes_per_h =
-      CEIL(ztensor->transformed_desc->dim2, AIU_STICKS_PER_PAGE) *
-      AIU_PAGESIZE_IN_BYTES;
+  feclearexcept(FE_ALL_EXCEPT);
 
-  uint64_t bytes_all_h =
-      (uint64_t)ztensor->transformed_desc->dim3 * bytes_per_h;
+  for (uint64_t r = begin; r < end && !job->convert_failure; r++) {
+    // moving position as the input is processed, in BYTES
+    uint64_t input_offset = (r / desc->dim3) * job->bytes_per_e4x +
+                            (r % desc->dim3) * job->bytes_per_row;
 
-  uint64_t bytes_per_n = bytes_all_h * CEIL(ztensor->transformed_desc->dim1,
-                                            AIU_2BYTE_CELLS_PER_STICK);
+    for (uint32_t e2x = 0; e2x < desc->dim2; e2x++) {
 
-  feclearexcept(
-      FE_ALL_EXCEPT); /* clear exception flags set during conversion */
+      // used for pushing input from w to w+1 (i.e., + AIU_BYTES_PER_STICK)
+      uint64_t in_offset_w = input_offset;
 
-  // use no-op function to request no saturation be used during data conversion
-  void (*skip_func)(const vec_float32 *, const vec_float32 *, vec_float32 *,
-                    vec_float32 *) = &skip_saturate_fp32_to_dlf16;
+      // process each c-stick (i.e., every 64 elements or whatever left in
+      // dim1)
+      for (uint32_t e1x = 0; e1x < desc->dim1;
+           e1x += AIU_2BYTE_CELLS_PER_STICK) {
+        // Prefetch (read) the next input buffer to be used. The HW should
+        // "notice" our sequential accesses and continue them, so we won't
+        // need to aggressively prefetch here.
+        prefetch_read(job->in_buf, input_offset);
+        uint32_t fields_to_convert =
+            MIN((desc->dim1 - e1x), AIU_2BYTE_CELLS_PER_STICK);
+
+        void *dst = (void *)((uintptr_t)job->out_buf + output_offset);
+        if (!streaming) {
+          // Prefetch the new output offset to write that HW wouldn't know
+          // about.
+          prefetch_write(job->out_buf, output_offset);
+        }
 
-  if (ztensor->pre_transformed_desc->layout != ZDNN_NCHW) {
+        uint32_t nbr_fields_converted = convert_data_format(
+            (void *)((uintptr_t)job->in_buf + input_offset), desc->type,
+            streaming ? (void *)staging : dst, out_type, fields_to_convert,
+            job->saturate_func);
 
-    // If FP32 and NNPA_TRANSFORM is available, send to hardware
-    if (ztensor->pre_transformed_desc->type == FP32 &&
-        zdnn_is_nnpa_function_installed(1, NNPA_TRANSFORM) &&
-        n_stride_meets_hardware_limit(ztensor->transformed_desc)) {
-      return hw_transform_origtensor(ztensor, out_buf);
-    }
+        if (nbr_fields_converted == 0) {
+          job->convert_failure = true;
+          break;
+        }
 
-    for (uint32_t e4x = 0; e4x < ztensor->transformed_desc->dim4; e4x++) {
+        if (streaming) {
+          stream_store(dst, staging, nbr_fields_converted << job->cell_shift);
+        }
 
-      // used for pushing input_offset from n to n+1 (i.e., +
-      // bytes_per_n)
-      uint64_t in_offset_n = input_offset;
+        // push output_offset the next c-stick, fake the multiply by
+        // bit-shifting
+        output_offset += (nbr_fields_converted << job->cell_shift);
 
-      for (uint32_t e3x = 0; e3x < ztensor->transformed_desc->dim3; e3x++) {
+        // push input_offset to the next c-stick of the same super c-stick
+        input_offset += job->bytes_per_stick1;
+      }
 
-        for (uint32_t e2x = 0; e2x < ztensor->transformed_desc->dim2; e2x++) {
+      // input_offset was pushed around in dim1 loops, so reset it to the next
+      // w
+      input_offset = in_offset_w + AIU_BYTES_PER_STICK;
+    }
+  }
 
-          // used for pushing input from w to w+1 (i.e., +
-          // AIU_BYTES_PER_STICK)
-          uint64_t in_offset_w = input_offset;
+  if (streaming) {
+    stream_fence();
+  }
+  stick_job_merge_fp_errors(job);
+}
 
-          // process each c-stick (i.e., every 64 elements or whatever
-          // left in dim1)
-          for (uint32_t e1x = 0; e1x < ztensor->transformed_desc->dim1;
-               e1x += AIU_2BYTE_CELLS_PER_STICK) {
-            // Prefetch (read) the next input buffer to be used. The HW
-            // should "notice" our sequential accesses and continue
-            // them, so we won't need to aggressively prefetch here.
-            // Also, Prefetch the new output offset to write that HW
-            // wouldn't know about.
+/// Unstickify rows [begin, end) of an NHWC ztensor into an NCHW output.  Row r
+/// is (n, c) = (r / dim1, r % dim1), every H x W of which is contiguous in the
+/// output.
+///
+/// \param[in] ctx Pointer to the stick_job
+/// \param[in] begin first row
+/// \param[in] end one past the last row
+///
+/// \return None
+///
+static void unstickify_nchw_rows_chunk(void *ctx, uint64_t begin,
+                                       uint64_t end) {
+  stick_job *job = (stick_job *)ctx;
+  const zdnn_tensor_desc *desc = job->ztensor->transformed_desc;
+  zdnn_data_types out_type = job->ztensor->pre_transformed_desc->type;
+  bool streaming = streaming_stores_enabled;
 
-            prefetch_read(ztensor->buffer, input_offset);
-            prefetch_write(out_buf, output_offset);
-            fields_to_convert = MIN((ztensor->transformed_desc->dim1 - e1x),
-                                    AIU_2BYTE_CELLS_PER_STICK);
+  uint8_t sizeof_dlf16 = get_data_type_size(ZDNN_DLFLOAT16);
 
-            nbr_fields_converted = convert_data_format(
-                (void *)((uintptr_t)ztensor->buffer + input_offset),
-                ztensor->transformed_desc->type,
-                (void *)((uintptr_t)out_buf + output_offset),
-                ztensor->pre_transformed_desc->type, fields_to_convert,
-                skip_func);
+  // one stick worth of converted entries when using streaming stores
+  vec_float32 staging[AIU_2BYTE_CELLS_PER_STICK * sizeof(float) /
+                      sizeof(vec_float32)];
 
-            if (nbr_fields_converted == 0)
-              return ZDNN_STATUS_NO_MSG(ZDNN_CONVERT_FAILURE);
+  // moving position as the output is processed, in BYTES
+  uint64_t output_offset = (begin * desc->dim3 * desc->dim2)
+                           << job->cell_shift;
 
-            // push output_offset the next c-stick, fake the multiply by
-            // bit-shifting
-            output_offset += (nbr_fields_converted << output_cell_shift);
+  feclearexcept(FE_ALL_EXCEPT);
 
-            // push input_offset to the next c-stick of the same super
-            // c-stick, which is bytes_all_h number of bytes away.
-            input_offset += bytes_all_h;
+  for (uint64_t r = begin; r < end && !job->convert_failure; r++) {
+    uint32_t e1x = r % desc->dim1;
+
+    // C location of H = 0, W = 0
+    uint64_t input_offset =
+        (r / desc->dim1) * job->bytes_per_e4x +
+        (e1x / AIU_2BYTE_CELLS_PER_STICK) * job->bytes_per_stick1 +
+        (e1x % AIU_2BYTE_CELLS_PER_STICK) * sizeof_dlf16;
+
+    for (uint32_t e3x = 0; e3x < desc->dim3; e3x++) {
+      // Prefetch (read) the next input buffer to be used. The HW should
+      // "notice" our sequential accesses and continue them, so we won't need
+      // to aggressively prefetch here.
+      prefetch_read(job->in_buf, input_offset);
+
+      // send the W entries of a given set of N/H/C to
+      // convert_data_format_in_stride(), the entries are AIU_BYTES_PER_STICK
+      // bytes apart
+      uint32_t nbr_fields_converted = 0;
+      if (!streaming) {
+        prefetch_write(job->out_buf, output_offset);
+        nbr_fields_converted = convert_data_format_in_stride(
+            (void *)((uintptr_t)job->in_buf + input_offset), desc->type,
+            (void *)((uintptr_t)job->out_buf + output_offset), out_type,
+            desc->dim2, AIU_2BYTE_CELLS_PER_STICK);
+      } else {
+        // at most a stick worth of W entries at a time via the staging area
+        for (uint32_t e2x = 0; e2x < desc->dim2;
+             e2x += AIU_2BYTE_CELLS_PER_STICK) {
+          uint32_t converted = convert_data_format_in_stride(
+              (void *)((uintptr_t)job->in_buf + input_offset +
+                       (uint64_t)e2x * AIU_BYTES_PER_STICK),
+              desc->type, staging, out_type,
+              MIN(desc->dim2 - e2x, AIU_2BYTE_CELLS_PER_STICK),
+              AIU_2BYTE_CELLS_PER_STICK);
+          if (converted == 0) {
+            nbr_fields_converted = 0;
+            break;
           }
-
-          // input_offset was pushed around in dim1 loops, so reset it
-          // to the next w
-          input_offset = in_offset_w + AIU_BYTES_PER_STICK;
+          stream_store(
+              (void *)((uintptr_t)job->out_buf + output_offset +
+                       ((uint64_t)nbr_fields_converted << job->cell_shift)),
+              staging, converted << job->cell_shift);
+          nbr_fields_converted += converted;
         }
-
-        // after processing all the w-entries, go to the next
-        // 4k-boundary location (aka stick padding)
-        input_offset = (input_offset + (AIU_PAGESIZE_IN_BYTES - 1)) &
-                       (-AIU_PAGESIZE_IN_BYTES);
       }
 
-      // input_offset was pushed around in the dims[2-0] loops, so reset
-      // it to the next n
-      input_offset = in_offset_n + bytes_per_n;
-    }
-  } else {
-
-    // the loops are in N -> C -> H -> W order in order to write the W
-    // entries contiguously
-
-    // N
-    for (uint32_t e4x = 0; e4x < ztensor->transformed_desc->dim4; e4x++) {
-
-      // used for pushing input_offset from n to n+1 (i.e., +
-      // bytes_per_n)
-      uint64_t in_offset_n = input_offset;
-
-      // C
-      for (uint32_t e1x = 0; e1x < ztensor->transformed_desc->dim1; e1x++) {
-
-        // used for pushing input from c to c+1
-        uint64_t in_offset_c = input_offset;
-
-        // H
-        for (uint32_t e3x = 0; e3x < ztensor->transformed_desc->dim3; e3x++) {
-          // Prefetch (read) the next input buffer to be used. The HW
-          // should "notice" our sequential accesses and continue them,
-          // so we won't need to aggressively prefetch here. Also,
-          // Prefetch the new output offset to write that HW wouldn't
-          // know about.
-
-          prefetch_read(ztensor->buffer, input_offset);
-          prefetch_write(out_buf, output_offset);
-          // send all the W entries of a given set of N/H/C to
-          // convert_data_format_in_stride(), the entries are
-          // AIU_BYTES_PER_STICK entries apart
+      if (nbr_fields_converted == 0) {
+        job->convert_failure = true;
+        break;
+      }
 
-          fields_to_convert = ztensor->transformed_desc->dim2;
+      // push input_offset to the next H
+      input_offset += job->bytes_per_row;
 
-          nbr_fields_converted = convert_data_format_in_stride(
-              (void *)((uintptr_t)ztensor->buffer + input_offset),
-              ztensor->transformed_desc->type,
-              (void *)((uintptr_t)out_buf + output_offset),
-              ztensor->pre_transformed_desc->type, fields_to_convert,
-              AIU_2BYTE_CELLS_PER_STICK);
+      // push output_offset to the next H, fake the multiply by bit-shifting
+      output_offset += (nbr_fields_converted << job->cell_shift);
+    }
+  }
 
-          if (nbr_fields_converted == 0)
-            return ZDNN_STATUS_NO_MSG(ZDNN_CONVERT_FAILURE);
+  if (streaming) {
+    stream_fence();
+  }
+  stick_job_merge_fp_errors(job);
+}
 
-          // push input_offset to the next H
-          input_offset += bytes_per_h;
+/// The actual routine for unstickification, only does the following:
+///    NHWC -> NHWC, NHWC -> NCHW
+/// Does NOT handle concatenated types nor HWCK
+///
+/// The rows are spread over the internal thread pool, see
+/// zdnn_set_max_threads().  The unstickified data is written with streaming
+/// stores when ZDNN_STREAMING_STORES is enabled.
+///
+/// \param[in] ztensor Pointer to zdnn_ztensor, containing data to be
+///                    unstickified
+/// \param[out] out_buf data buffer to unstickify to
+///
+/// \return ZDNN_OK
+///         ZDNN_CONVERT_FAILURE
+///
+zdnn_status transform_origtensor(const zdnn_ztensor *ztensor, void *out_buf) {
+  const zdnn_tensor_desc *desc = ztensor->transformed_desc;
+
+  stick_job job;
+  memset(&job, 0, sizeof(job));
+  job.ztensor = ztensor;
+  job.in_buf = ztensor->buffer;
+  job.out_buf = out_buf;
+  job.cell_shift = get_data_type_size(ztensor->pre_transformed_desc->type) / 2;
+  // use no-op function to request no saturation be used during data conversion
+  job.saturate_func = &skip_saturate_fp32_to_dlf16;
 
-          // push output_offset to the next H, fake the multiply by
-          // bit-shifting
-          output_offset += (nbr_fields_converted << output_cell_shift);
-        }
+  // loop invariant values
+  job.bytes_per_row =
+      CEIL(desc->dim2, AIU_STICKS_PER_PAGE) * AIU_PAGESIZE_IN_BYTES;
+  job.bytes_per_stick1 = (uint64_t)desc->dim3 * job.bytes_per_row;
+  job.bytes_per_e4x =
+      job.bytes_per_stick1 * CEIL(desc->dim1, AIU_2BYTE_CELLS_PER_STICK);
 
-        // push in_offset_c to the next C
-        in_offset_c += get_data_type_size(ztensor->transformed_desc->type);
+  if (ztensor->pre_transformed_desc->layout != ZDNN_NCHW) {
 
-        // go to the next C-stick if we're at the end of the current
-        // C-stick
-        if (!((e1x + 1) % AIU_2BYTE_CELLS_PER_STICK)) {
-          in_offset_c = in_offset_c - AIU_BYTES_PER_STICK + bytes_all_h;
-        }
+    // If FP32 and NNPA_TRANSFORM is available, send to hardware
+    if (ztensor->pre_transformed_desc->type == FP32 &&
+        zdnn_is_nnpa_function_installed(1, NNPA_TRANSFORM) &&
+        n_stride_meets_hardware_limit(desc) && is_within_nnpa_limits(desc)) {
+      return hw_transform_origtensor(ztensor, out_buf);
+    }
 
-        input_offset = in_offset_c;
-      }
+    run_parallel((uint64_t)desc->dim4 * desc->dim3,
+                 stick_rows_per_chunk((uint64_t)desc->dim2 * desc->dim1),
+                 unstickify_rows_chunk, &job);
+  } else {
+    // rows are (n, c) in order to write the H x W entries contiguously
+    run_parallel((uint64_t)desc->dim4 * desc->dim1,
+                 stick_rows_per_chunk((uint64_t)desc->dim3 * desc->dim2),
+                 unstickify_nchw_rows_chunk, &job);
+  }
 
-      // reset input_offset to the next n
-      input_offset = in_offset_n + bytes_per_n;
-    }
+  if (job.convert_failure) {
+    return ZDNN_STATUS_NO_MSG(ZDNN_CONVERT_FAILURE);
   }
 
   // handle any FP errors or return success
-  return handle_fp_errors(
-      fetestexcept(FE_UNDERFLOW | FE_INVALID | FE_INEXACT | FE_OVERFLOW));
+  return handle_fp_errors(stick_job_fp_errors(&job));
 
 } // End transform_origtensor
 
-/// Unstickification when dim1 is <= 2.  Only handles NHWC -> NHWC.
+/// Store a converted vector to the unstickified output
 ///
-/// \param[in] ztensor Pointer to zdnn_ztensor, containing data to be
-///                    unstickified
-/// \param[out] out_buf data buffer to unstickify to
+/// \param[in] dst destination address
+/// \param[in] src converted data
+/// \param[in] len number of bytes
+/// \param[in] streaming use stream_store()
 ///
-/// \return ZDNN_OK
-///         ZDNN_CONVERT_FAILURE
-///         ZDNN_INVALID_TYPE
-///
-zdnn_status transform_origtensor_smalldim1(const zdnn_ztensor *ztensor,
-                                           void *out_buf) {
+static inline void store_unstickified(void *dst, const void *src, size_t len,
+                                      bool streaming) {
+  if (streaming) {
+    stream_store(dst, src, len);
+  } else {
+    memcpy(dst, src, len);
+  }
+}
 
-  uint64_t input_offset =
-      0; // moving position as the input is processed, in BYTES
+/// Unstickify rows [begin, end) of an NHWC ztensor with dim1 <= 2.  Row r is
+/// (e4x, e3x) = (r / dim3, r % dim3).
+///
+/// \param[in] ctx Pointer to the stick_job
+/// \param[in] begin first row
+/// \param[in] end one past the last row
+///
+/// \return None
+///
+static void unstickify_smalldim1_rows_chunk(void *ctx, uint64_t begin,
+                                            uint64_t end) {
+  stick_job *job = (stick_job *)ctx;
+  const zdnn_tensor_desc *desc = job->ztensor->transformed_desc;
+  zdnn_data_types out_type = job->ztensor->pre_transformed_desc->type;
+  bool streaming = streaming_stores_enabled;
 
   // Define a input vector.  a Vector Register can fit 8 int16 fields
   vec_int16 input_data = {0};
@@ -2176,21 +2643,12 @@ zdnn_status transform_origtensor_smalldim1(const zdnn_ztensor *ztensor,
   // output pointer that always moves forward, will be casted as either
   // vec_int16 or vec_float32 depends on output type
   // ** Note: adding 1 to a vector pointer will move it ahead 16 bytes
-  void *output_data = out_buf;
-
-  // loop invariant values
-  uint64_t bytes_per_h =
-      CEIL(ztensor->transformed_desc->dim2, AIU_STICKS_PER_PAGE) *
-      AIU_PAGESIZE_IN_BYTES;
-
-  uint64_t bytes_all_h =
-      (uint64_t)ztensor->transformed_desc->dim3 * bytes_per_h;
-
-  uint64_t bytes_per_n = bytes_all_h * CEIL(ztensor->transformed_desc->dim1,
-                                            AIU_2BYTE_CELLS_PER_STICK);
+  void *output_data =
+      (void *)((uintptr_t)job->out_buf +
+               ((begin * desc->dim2 * desc->dim1) << job->cell_shift));
 
   // Set indicies from which values need to be collected for conversion
-  vector unsigned int idx, idx_left, idx_right;
+  zdnn_vec_u32 idx, idx_left, idx_right;
 
   /*
 
@@ -2221,19 +2679,17 @@ zdnn_status transform_origtensor_smalldim1(const zdnn_ztensor *ztensor,
 
   // ** xlc requires vector shift right operand to be unsigned long
 
-  vector unsigned int idx_left_incr = (ztensor->transformed_desc->dim1 == 2)
-                                          ? (vector unsigned int){0, 1, 64, 65}
-                                          : (vector unsigned int){0, 1, 2, 3}
-                                                << 6ul;
-  vector unsigned int idx_right_incr =
-      (ztensor->transformed_desc->dim1 == 2)
-          ? (vector unsigned int){128, 129, 192, 193}
-          : (vector unsigned int){4, 5, 6, 7} << 6ul;
+  zdnn_vec_u32 idx_left_incr = (desc->dim1 == 2)
+                                   ? (zdnn_vec_u32){0, 1, 64, 65}
+                                   : (zdnn_vec_u32){0, 1, 2, 3} << 6ul;
+  zdnn_vec_u32 idx_right_incr =
+      (desc->dim1 == 2) ? (zdnn_vec_u32){128, 129, 192, 193}
+                        : (zdnn_vec_u32){4, 5, 6, 7} << 6ul;
 
   uint32_t rows_in_vec;
   unsigned long vec_shift;
 
-  if (ztensor->transformed_desc->dim1 == 2) {
+  if (desc->dim1 == 2) {
     rows_in_vec = 4;
     // when rows_in_vec == 4, groups are 2^8 entries apart
     vec_shift = 8;
@@ -2244,190 +2700,222 @@ zdnn_status transform_origtensor_smalldim1(const zdnn_ztensor *ztensor,
   }
 
   // # of remaining fields to convert in the last group (if any)
-  uint32_t remaining_el = (ztensor->transformed_desc->dim2 % rows_in_vec) *
-                          ztensor->transformed_desc->dim1;
+  uint32_t remaining_el = (desc->dim2 % rows_in_vec) * desc->dim1;
 
   uint32_t remaining_bytes_to_set =
-      remaining_el * get_data_type_size(ztensor->pre_transformed_desc->type);
+      remaining_el * get_data_type_size(out_type);
 
   vec_int16 tmp_out_16;
   vec_float32 tmp_out_left, tmp_out_right;
 
-  vec_char8 selection_vector = {0,  1,  4,  5,  8,  9,  12, 13,
-                                16, 17, 20, 21, 24, 25, 28, 29};
-
-  feclearexcept(
-      FE_ALL_EXCEPT); /* clear exception flags set during conversion */
-
-  for (uint32_t e4x = 0; e4x < ztensor->transformed_desc->dim4; e4x++) {
+  vec_char8 selection_vector = VEC_SEL_HI_HALFWORDS;
 
-    // used for pushing input_offset from n to n+1 (i.e., + bytes_per_n)
-    uint64_t in_offset_n = input_offset;
+  feclearexcept(FE_ALL_EXCEPT);
 
-    for (uint32_t e3x = 0; e3x < ztensor->transformed_desc->dim3; e3x++) {
+  for (uint64_t r = begin; r < end; r++) {
 
-      uint16_t *in_data =
-          (uint16_t *)((uintptr_t)ztensor->buffer + input_offset);
+    uint16_t *in_data =
+        (uint16_t *)((uintptr_t)job->in_buf +
+                     (r / desc->dim3) * job->bytes_per_e4x +
+                     (r % desc->dim3) * job->bytes_per_row);
 
-      uint32_t e2x;
+    uint32_t e2x;
 
-      // If there's more than 8 to convert, convert groups of 8
-      // DLFLOAT16s
-      for (e2x = 0; e2x < ztensor->transformed_desc->dim2 / rows_in_vec;
-           e2x++) {
-        idx = (vector unsigned int){e2x, e2x, e2x, e2x} << vec_shift;
-        idx_left = idx + idx_left_incr;
-        idx_right = idx + idx_right_incr;
+    // If there's more than 8 to convert, convert groups of 8
+    // DLFLOAT16s
+    for (e2x = 0; e2x < desc->dim2 / rows_in_vec; e2x++) {
+      idx = (zdnn_vec_u32){e2x, e2x, e2x, e2x} << vec_shift;
+      idx_left = idx + idx_left_incr;
+      idx_right = idx + idx_right_incr;
 
+      if (!streaming) {
         prefetch_write((void *)output_data, 0);
+      }
 
-        input_data = (vec_int16){in_data[idx_left[0]],  in_data[idx_left[1]],
-                                 in_data[idx_left[2]],  in_data[idx_left[3]],
-                                 in_data[idx_right[0]], in_data[idx_right[1]],
-                                 in_data[idx_right[2]], in_data[idx_right[3]]};
-
-        switch (ztensor->pre_transformed_desc->type) {
-        case FP16:
-          *((vec_int16 *)(output_data)) = aiu_vec_convert_to_fp16(input_data);
+      input_data = (vec_int16){in_data[idx_left[0]],  in_data[idx_left[1]],
+                               in_data[idx_left[2]],  in_data[idx_left[3]],
+                               in_data[idx_right[0]], in_data[idx_right[1]],
+                               in_data[idx_right[2]], in_data[idx_right[3]]};
 
-          // bump ptr to start of next vector (8 float16s = 16 bytes =
-          // +1)
-          output_data = (vec_int16 *)output_data + 1;
-          break;
-        case FP32:
-          aiu_vec_lengthen_to_fp32((vec_int16)input_data,
-                                   (vec_float32 *)output_data,
-                                   (vec_float32 *)output_data + 1);
-
-          // bump ptr to start of next pair of vector (8 float32s = 32
-          // bytes = +2)
-          output_data = (vec_float32 *)output_data + 2;
-          break;
-        case BFLOAT:
-          aiu_vec_lengthen_to_fp32((vec_int16)input_data, &tmp_out_left,
-                                   &tmp_out_right);
+      switch (out_type) {
+      case FP16:
+        tmp_out_16 = aiu_vec_convert_to_fp16(input_data);
+        store_unstickified(output_data, &tmp_out_16, sizeof(vec_int16),
+                           streaming);
 
-          *((vec_int16 *)(output_data)) =
-              (vec_int16)vec_perm((vec_char8)(tmp_out_left),
-                                  (vec_char8)(tmp_out_right), selection_vector);
+        // bump ptr to start of next vector (8 float16s = 16 bytes = +1)
+        output_data = (vec_int16 *)output_data + 1;
+        break;
+      case FP32:
+        aiu_vec_lengthen_to_fp32((vec_int16)input_data, &tmp_out_left,
+                                 &tmp_out_right);
+        store_unstickified(output_data, &tmp_out_left, sizeof(vec_float32),
+                           streaming);
+        store_unstickified((vec_float32 *)output_data + 1, &tmp_out_right,
+                           sizeof(vec_float32), streaming);
+
+        // bump ptr to start of next pair of vector (8 float32s = 32 bytes =
+        // +2)
+        output_data = (vec_float32 *)output_data + 2;
+        break;
+      case BFLOAT:
+        aiu_vec_lengthen_to_fp32((vec_int16)input_data, &tmp_out_left,
+                                 &tmp_out_right);
 
-          // bump ptr to start of next vector (8 bfloats = 16 bytes =
-          // +1)
-          output_data = (vec_int16 *)output_data + 1;
-          break;
-        default:
-          // this is for completeness but we should never get here, called
-          // should have already checked it before calling this function
-          return ZDNN_STATUS(ZDNN_INVALID_TYPE,
-                             "unknown/invalid pre-transformed data type: %d",
-                             ztensor->pre_transformed_desc->type);
-          break;
-        }
+        tmp_out_16 =
+            (vec_int16)vec_perm((vec_char8)(tmp_out_left),
+                                (vec_char8)(tmp_out_right), selection_vector);
+        store_unstickified(output_data, &tmp_out_16, sizeof(vec_int16),
+                           streaming);
 
-      } // End of for loop
+        // bump ptr to start of next vector (8 bfloats = 16 bytes = +1)
+        output_data = (vec_int16 *)output_data + 1;
+        break;
+      default:
+        // caller has already checked the type before calling
+        break;
+      }
 
-      // e2x at this point points to the group with remaining fields (if
-      // any)
-      if (remaining_el > 0) { // If none, skip the rest
+    } // End of for loop
+
+    // e2x at this point points to the group with remaining fields (if any)
+    if (remaining_el > 0) { // If none, skip the rest
+
+      idx = (zdnn_vec_u32){e2x, e2x, e2x, e2x} << vec_shift;
+      idx_left = idx + idx_left_incr;
+      idx_right = idx + idx_right_incr;
+
+      // input_data[] should contain either 0s or residual values from the
+      // previous loop, so no need to fill the entries that we don't need
+      switch (remaining_el) {
+      // remaining_el will never be 8
+      case 7:
+        // fill input_data[6-0]
+        input_data[6] = in_data[idx_right[2]];
+      case 6:
+        // fill input_data[5-0]
+        input_data[5] = in_data[idx_right[1]];
+      case 5:
+        input_data[4] = in_data[idx_right[0]];
+      case 4:
+        input_data[3] = in_data[idx_left[3]];
+      case 3:
+        input_data[2] = in_data[idx_left[2]];
+      case 2:
+        input_data[1] = in_data[idx_left[1]];
+      default:
+        // all scenarios fill at least input_data[0]
+        input_data[0] = in_data[idx_left[0]];
+      };
+
+      // 1) convert the remaining entries and store to tmp_out_x
+      // 2) vec_store_len() from tmp_out_x to output_data
+      // 3) advances output_data ptr
+      switch (out_type) {
+      case FP16:
+        tmp_out_16 = aiu_vec_convert_to_fp16(input_data);
 
-        idx = (vector unsigned int){e2x, e2x, e2x, e2x} << vec_shift;
-        idx_left = idx + idx_left_incr;
-        idx_right = idx + idx_right_incr;
-
-        // input_data[] should contain either 0s or residual values from the
-        // previous loop, so no need to fill the entries that we don't need
-        switch (remaining_el) {
-        // remaining_el will never be 8
-        case 7:
-          // fill input_data[6-0]
-          input_data[6] = in_data[idx_right[2]];
-        case 6:
-          // fill input_data[5-0]
-          input_data[5] = in_data[idx_right[1]];
-        case 5:
-          input_data[4] = in_data[idx_right[0]];
-        case 4:
-          input_data[3] = in_data[idx_left[3]];
-        case 3:
-          input_data[2] = in_data[idx_left[2]];
-        case 2:
-          input_data[1] = in_data[idx_left[1]];
-        default:
-          // all scenarios fill at least input_data[0]
-          input_data[0] = in_data[idx_left[0]];
-        };
+        vec_store_len(tmp_out_16, (uint16_t *)output_data,
+                      remaining_bytes_to_set - 1);
 
-        // 1) convert the remaining entries and store to tmp_out_x
-        // 2) vec_store_len() from tmp_out_x to output_data
-        // 3) advances output_data ptr
-        switch (ztensor->pre_transformed_desc->type) {
-        case FP16:
-          tmp_out_16 = aiu_vec_convert_to_fp16(input_data);
+        output_data = (void *)((uintptr_t)output_data + remaining_bytes_to_set);
+        break;
+      case FP32:
+        aiu_vec_lengthen_to_fp32((vec_int16)input_data, &tmp_out_left,
+                                 &tmp_out_right);
+
+        // Store left FP32 to output (1 to 4 values), Length is offset
+        // by 1. vec_store_len() stores 16 bytes at the most so it
+        // won't matter if remaining_bytes_to_set > 16
+        vec_store_len(tmp_out_left, (uint32_t *)output_data,
+                      remaining_bytes_to_set - 1);
+
+        // If there's more than 4 to convert (remaining_bytes_to_set >
+        // 16), store values 5-8
+        if (remaining_el > 4) {
+          vec_store_len(tmp_out_right,
+                        (uint32_t *)((vec_float32 *)output_data + 1),
+                        (remaining_bytes_to_set - 16) - 1);
+        }
 
-          vec_store_len(tmp_out_16, (uint16_t *)output_data,
-                        remaining_bytes_to_set - 1);
+        output_data = (void *)((uintptr_t)output_data + remaining_bytes_to_set);
+        break;
+      case BFLOAT:
+        aiu_vec_lengthen_to_fp32((vec_int16)input_data, &tmp_out_left,
+                                 &tmp_out_right);
 
-          output_data =
-              (void *)((uintptr_t)output_data + remaining_bytes_to_set);
-          break;
-        case FP32:
-          aiu_vec_lengthen_to_fp32((vec_int16)input_data, &tmp_out_left,
-                                   &tmp_out_right);
+        tmp_out_16 =
+            (vec_int16)vec_perm((vec_char8)tmp_out_left,
+                                (vec_char8)tmp_out_right, selection_vector);
 
-          // Store left FP32 to output (1 to 4 values), Length is offset
-          // by 1. vec_store_len() stores 16 bytes at the most so it
-          // won't matter if remaining_bytes_to_set > 16
-          vec_store_len(tmp_out_left, (uint32_t *)output_data,
-                        remaining_bytes_to_set - 1);
+        vec_store_len(tmp_out_16, (uint16_t *)output_data,
+                      remaining_bytes_to_set - 1);
 
-          // If there's more than 4 to convert (remaining_bytes_to_set >
-          // 16), store values 5-8
-          if (remaining_el > 4) {
-            vec_store_len(tmp_out_right,
-                          (uint32_t *)((vec_float32 *)output_data + 1),
-                          (remaining_bytes_to_set - 16) - 1);
-          }
+        output_data = (void *)((uintptr_t)output_data + remaining_bytes_to_set);
+        break;
+      default:
+        // caller has already checked the type before calling
+        break;
+      }
+    }
+  }
 
-          output_data =
-              (void *)((uintptr_t)output_data + remaining_bytes_to_set);
-          break;
-        case BFLOAT:
-          aiu_vec_lengthen_to_fp32((vec_int16)input_data, &tmp_out_left,
-                                   &tmp_out_right);
+  if (streaming) {
+    stream_fence();
+  }
+  stick_job_merge_fp_errors(job);
+}
 
-          tmp_out_16 =
-              (vec_int16)vec_perm((vec_char8)tmp_out_left,
-                                  (vec_char8)tmp_out_right, selection_vector);
+/// Unstickification when dim1 is <= 2.  Only handles NHWC -> NHWC.
+///
+/// The (e4x, e3x) rows are spread over the internal thread pool, see
+/// zdnn_set_max_threads().
+///
+/// \param[in] ztensor Pointer to zdnn_ztensor, containing data to be
+///                    unstickified
+/// \param[out] out_buf data buffer to unstickify to
+///
+/// \return ZDNN_OK
+///         ZDNN_CONVERT_FAILURE
+///         ZDNN_INVALID_TYPE
+///
+zdnn_status transform_origtensor_smalldim1(const zdnn_ztensor *ztensor,
+                                           void *out_buf) {
+  const zdnn_tensor_desc *desc = ztensor->transformed_desc;
 
-          vec_store_len(tmp_out_16, (uint16_t *)output_data,
-                        remaining_bytes_to_set - 1);
+  switch (ztensor->pre_transformed_desc->type) {
+  case FP16:
+  case FP32:
+  case BFLOAT:
+    break;
+  default:
+    // this is for completeness but we should never get here, called
+    // should have already checked it before calling this function
+    return ZDNN_STATUS(ZDNN_INVALID_TYPE,
+                       "unknown/invalid pre-transformed data type: %d",
+                       ztensor->pre_transformed_desc->type);
+  }
 
-          output_data =
-              (void *)((uintptr_t)output_data + remaining_bytes_to_set);
-          break;
-        default:
-          // this is for completeness but we should never get here, called
-          // should have already checked it before calling this function
-          return ZDNN_STATUS(ZDNN_INVALID_TYPE,
-                             "unknown/invalid pre-transformed data type: %d",
-                             ztensor->pre_transformed_desc->type);
-          break;
-        }
-      }
+  stick_job job;
+  memset(&job, 0, sizeof(job));
+  job.ztensor = ztensor;
+  job.in_buf = ztensor->buffer;
+  job.out_buf = out_buf;
+  job.cell_shift = get_data_type_size(ztensor->pre_transformed_desc->type) / 2;
 
-      // add to input offset all the bytes in h (already aligned to page
-      // size)
-      input_offset += bytes_per_h;
-    }
+  // loop invariant values
+  job.bytes_per_row =
+      CEIL(desc->dim2, AIU_STICKS_PER_PAGE) * AIU_PAGESIZE_IN_BYTES;
+  job.bytes_per_stick1 = (uint64_t)desc->dim3 * job.bytes_per_row;
+  job.bytes_per_e4x =
+      job.bytes_per_stick1 * CEIL(desc->dim1, AIU_2BYTE_CELLS_PER_STICK);
 
-    // input_offset was pushed around in the dims[2-0] loops, so reset
-    // it to the next n
-    input_offset = in_offset_n + bytes_per_n;
-  }
+  run_parallel((uint64_t)desc->dim4 * desc->dim3,
+               stick_rows_per_chunk((uint64_t)desc->dim2 * desc->dim1),
+               unstickify_smalldim1_rows_chunk, &job);
 
   // handle any FP errors or return success
-  return handle_fp_errors(
-      fetestexcept(FE_UNDERFLOW | FE_INVALID | FE_INEXACT | FE_OVERFLOW));
+  return handle_fp_errors(stick_job_fp_errors(&job));
 
 } // End transform_origtensor_smalldim1
 
@@ -2491,6 +2979,11 @@ zdnn_status zdnn_transform_origtensor(const zdnn_ztensor *ztensor,
                                       void *out_buf) {
   zdnn_status status = ZDNN_OK; // Assume success
 
+  if ((status = check_op_plan_recordable("zdnn_transform_origtensor")) !=
+      ZDNN_OK) {
+    return status;
+  }
+
   if ((status = verify_descriptors_transform_origtensor(ztensor)) != ZDNN_OK) {
     return status;
   }
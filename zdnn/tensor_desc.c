@@ -303,6 +303,54 @@ zdnn_status verify_transformed_descriptor(const zdnn_tensor_desc *tfrmd_desc) {
   return verify_transformed_dimensions(tfrmd_desc);
 }
 
+/// Check if a dimension of a transformed descriptor may go past the maximum
+/// dimension index size of the zAIU.  Any dimension of a DLFLOAT16 feature
+/// tensor and the output channels (dim1) of a kernel may, as operations given
+/// them are split into tiles or chunks within the limits where possible, or
+/// else fail with ZDNN_EXCEEDS_MDIS.
+///
+/// \param[in] tfrmd_desc transformed descriptor
+/// \param[in] dim dimension, 1 to 4
+///
+/// \return true if the dimension may go past the limit
+///
+static bool may_exceed_max_dim(const zdnn_tensor_desc *tfrmd_desc,
+                               uint8_t dim) {
+  if (tfrmd_desc->format == ZDNN_FORMAT_4DKERNEL) {
+    return dim == 1;
+  }
+  return tfrmd_desc->format == ZDNN_FORMAT_4DFEATURE &&
+         tfrmd_desc->layout == ZDNN_NHWC &&
+         tfrmd_desc->type == ZDNN_DLFLOAT16;
+}
+
+/// Check if a transformed descriptor may go past the maximum tensor size of
+/// the zAIU, see may_exceed_max_dim()
+///
+/// \param[in] tfrmd_desc transformed descriptor
+///
+/// \return true if the tensor may go past the limit
+///
+static bool may_exceed_max_tensor_size(const zdnn_tensor_desc *tfrmd_desc) {
+  return tfrmd_desc->format == ZDNN_FORMAT_4DKERNEL ||
+         may_exceed_max_dim(tfrmd_desc, 1);
+}
+
+/// Check if a transformed descriptor is within the maximum dimension index
+/// sizes and the maximum tensor size of the zAIU
+///
+/// \param[in] tfrmd_desc transformed descriptor
+///
+/// \return true if the zAIU accepts the tensor
+///
+bool is_within_nnpa_limits(const zdnn_tensor_desc *tfrmd_desc) {
+  return tfrmd_desc->dim4 <= zdnn_get_max_for_dim(4) &&
+         tfrmd_desc->dim3 <= zdnn_get_max_for_dim(3) &&
+         tfrmd_desc->dim2 <= zdnn_get_max_for_dim(2) &&
+         tfrmd_desc->dim1 <= zdnn_get_max_for_dim(1) &&
+         zdnn_getsize_ztensor(tfrmd_desc) <= zdnn_get_nnpa_max_tensor_size();
+}
+
 zdnn_status verify_transformed_dimensions(const zdnn_tensor_desc *tfrmd_desc) {
 
   const uint32_t *dims_ptr = &(tfrmd_desc->dim4);
@@ -324,7 +372,7 @@ zdnn_status verify_transformed_dimensions(const zdnn_tensor_desc *tfrmd_desc) {
                            "Unable to verify shape. (reason: HW environment "
                            "may not be setup properly)",
                            NO_ARG);
-      } else {
+      } else if (!may_exceed_max_dim(tfrmd_desc, ZDNN_MAX_DIMS - i)) {
         return ZDNN_STATUS(ZDNN_INVALID_SHAPE,
                            "Invalid shape for dim%d. (reason: dimension "
                            "value %d exceeds %d)",
@@ -335,7 +383,8 @@ zdnn_status verify_transformed_dimensions(const zdnn_tensor_desc *tfrmd_desc) {
   }
 
   // is stick area size above the limit?
-  if (zdnn_getsize_ztensor(tfrmd_desc) > zdnn_get_nnpa_max_tensor_size()) {
+  if (zdnn_getsize_ztensor(tfrmd_desc) > zdnn_get_nnpa_max_tensor_size() &&
+      !may_exceed_max_tensor_size(tfrmd_desc)) {
     return ZDNN_STATUS(ZDNN_INVALID_SHAPE,
                        "Invalid shape (reasons: tensor size: %" PRIu64
                        ", maximum: %" PRIu64 " bytes",
@@ -346,12 +346,13 @@ void dumpdata_ztensor(const zdnn_ztensor *ztensor, dump_mode mode,
             switch (tfrmd_type) {
             case ZDNN_DLFLOAT16:
               if (mode == AS_HEX) {
-                printf("%04x%*s", ((uint16_t *)ztensor->buffer)[i + j],
+                printf("%04x%*s",
+                       STICK_CELL16(((uint16_t *)ztensor->buffer)[i + j]),
                        cell_size - 4, "");
               } else {
-                printf(
-                    "%-*." FLOAT_DECIMAL_PLACES "f", cell_size,
-                    cnvt_1_dlf16_to_fp32(((uint16_t *)ztensor->buffer)[i + j]));
+                printf("%-*." FLOAT_DECIMAL_PLACES "f", cell_size,
+                       cnvt_1_dlf16_to_fp32(STICK_CELL16(
+                           ((uint16_t *)ztensor->buffer)[i + j])));
               }
               break;
             case ZDNN_BINARY_INT32:
@@ -462,12 +463,13 @@ void dumpdata_ztensor(const zdnn_ztensor *ztensor, dump_mode mode,
             switch (tfrmd_desc->type) {
             case ZDNN_DLFLOAT16:
               if (mode == AS_HEX) {
-                printf("%04x%*s", ((uint16_t *)ztensor->buffer)[i + j],
+                printf("%04x%*s",
+                       STICK_CELL16(((uint16_t *)ztensor->buffer)[i + j]),
                        cell_size - 4, "");
               } else {
-                printf(
-                    "%-*." FLOAT_DECIMAL_PLACES "f", cell_size,
-                    cnvt_1_dlf16_to_fp32(((uint16_t *)ztensor->buffer)[i + j]));
+                printf("%-*." FLOAT_DECIMAL_PLACES "f", cell_size,
+                       cnvt_1_dlf16_to_fp32(STICK_CELL16(
+                           ((uint16_t *)ztensor->buffer)[i + j])));
               }
               break;
             case ZDNN_BINARY_INT32:
@@ -130,16 +130,16 @@ static zdnn_status verify_dim(uint8_t dim_idx, uint32_t val, ...) {
 // Convenience macros with auto NULL-terminated variadic list
 
 #define VERIFY_FIELDS(type, format, ...)                                       \
-  verify_fields(type, format, TENSOR_PARMS(__VA_ARGS__)(__VA_ARGS__), NO_ARG)
+  verify_fields(type, format, TENSOR_PARMS(__VA_ARGS__)(__VA_ARGS__), NULL)
 
 #define VERIFY_DIM4(val, ...)                                                  \
-  verify_dim(4, val, TENSOR_PARMS(__VA_ARGS__)(__VA_ARGS__), NO_ARG)
+  verify_dim(4, val, TENSOR_PARMS(__VA_ARGS__)(__VA_ARGS__), NULL)
 #define VERIFY_DIM3(val, ...)                                                  \
-  verify_dim(3, val, TENSOR_PARMS(__VA_ARGS__)(__VA_ARGS__), NO_ARG)
+  verify_dim(3, val, TENSOR_PARMS(__VA_ARGS__)(__VA_ARGS__), NULL)
 #define VERIFY_DIM2(val, ...)                                                  \
-  verify_dim(2, val, TENSOR_PARMS(__VA_ARGS__)(__VA_ARGS__), NO_ARG)
+  verify_dim(2, val, TENSOR_PARMS(__VA_ARGS__)(__VA_ARGS__), NULL)
 #define VERIFY_DIM1(val, ...)                                                  \
-  verify_dim(1, val, TENSOR_PARMS(__VA_ARGS__)(__VA_ARGS__), NO_ARG)
+  verify_dim(1, val, TENSOR_PARMS(__VA_ARGS__)(__VA_ARGS__), NULL)
 
 #define VERIFY_HEIGHT VERIFY_DIM3
 #define VERIFY_WIDTH VERIFY_DIM2
@@ -0,0 +1,307 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "zdnn.h"
+#include "zdnn_private.h"
+
+#ifdef __MVS__
+#pragma export(zdnn_transpose_ztensor)
+#endif
+
+/*
+  A transpose moves the DLFLOAT16 cells of the input's sticks straight into
+  the output's sticks.  Axes are numbered in transformed NHWC order, 0 being
+  dim4 and 3 being dim1, and output axis k is input axis perm[k].
+
+  When dim1 stays dim1, every output stick is a whole input stick.  Otherwise
+  the input's dim1 becomes some other output axis q, and the output is filled
+  a tile at a time: up to AIU_2BYTE_CELLS_PER_STICK input sticks along the
+  input axis that becomes the output's dim1 are read into a square of cells,
+  which is written out transposed as up to AIU_2BYTE_CELLS_PER_STICK output
+  sticks along q.
+*/
+
+// output sticks (or tile cells) handled per parallel chunk are sized to cover
+// about this many cells
+#define TRANSPOSE_CELLS_PER_CHUNK 65536
+
+#define TILE_CELLS AIU_2BYTE_CELLS_PER_STICK
+
+// State shared by the workers of a transpose.  Every chunk covers its own
+// sticks of the output.
+typedef struct transpose_job {
+  const char *in_buf;
+  char *out_buf;
+  stick_geometry in;
+  stick_geometry out;
+  uint32_t out_dims[ZDNN_MAX_DIMS]; // in axis order, dim4 first
+  uint8_t perm[ZDNN_MAX_DIMS];
+  uint8_t cell_axis;                // output axis holding the input's dim1
+  uint8_t other_axes[2];            // output axes other than 3 and cell_axis
+  uint64_t cell_tiles;              // tiles along cell_axis
+  uint64_t stick1_tiles;            // tiles along the output's dim1
+} transpose_job;
+
+/// Byte offset of the stick holding a cell
+///
+/// \param[in] geom the stick geometry
+/// \param[in] x coordinates of the cell, in axis order
+///
+/// \return offset from the start of the stick area
+///
+static inline uint64_t stick_offset(const stick_geometry *geom,
+                                    const uint32_t *x) {
+  return x[0] * geom->bytes_per_e4x +
+         x[3] / AIU_2BYTE_CELLS_PER_STICK * geom->bytes_per_stick1 +
+         (uint64_t)x[1] * geom->bytes_per_row +
+         (uint64_t)x[2] * AIU_BYTES_PER_STICK;
+}
+
+/// Copy whole sticks for output rows [begin, end), when the input's dim1 stays
+/// the output's dim1.  Padding cells after the last dim1 are zeroed rather
+/// than copied.
+///
+/// \param[in] ctx Pointer to the transpose_job
+/// \param[in] begin first output (e4x, e3x) row
+/// \param[in] end one past the last output row
+///
+/// \return None
+///
+static void transpose_sticks_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  const transpose_job *job = ctx;
+  uint32_t o[ZDNN_MAX_DIMS], x[ZDNN_MAX_DIMS];
+
+  for (uint64_t row = begin; row < end; row++) {
+    o[0] = row / job->out_dims[1];
+    o[1] = row % job->out_dims[1];
+    for (o[2] = 0; o[2] < job->out_dims[2]; o[2]++) {
+      for (o[3] = 0; o[3] < job->out_dims[3];
+           o[3] += AIU_2BYTE_CELLS_PER_STICK) {
+        for (int k = 0; k < ZDNN_MAX_DIMS; k++) {
+          x[job->perm[k]] = o[k];
+        }
+        char *out_stick = job->out_buf + stick_offset(&job->out, o);
+        uint32_t num_c = MIN(TILE_CELLS, job->out_dims[3] - o[3]);
+        memcpy(out_stick, job->in_buf + stick_offset(&job->in, x),
+               num_c * sizeof(uint16_t));
+        if (num_c < TILE_CELLS) {
+          memset(out_stick + num_c * sizeof(uint16_t), 0,
+                 (TILE_CELLS - num_c) * sizeof(uint16_t));
+        }
+      }
+    }
+  }
+}
+
+/// Transpose tiles [begin, end) of cells, when the input's dim1 becomes
+/// another output axis
+///
+/// \param[in] ctx Pointer to the transpose_job
+/// \param[in] begin first tile
+/// \param[in] end one past the last tile
+///
+/// \return None
+///
+static void transpose_tiles_chunk(void *ctx, uint64_t begin, uint64_t end) {
+  const transpose_job *job = ctx;
+  const uint8_t q = job->cell_axis;
+  uint32_t o[ZDNN_MAX_DIMS], x[ZDNN_MAX_DIMS];
+  uint16_t tile[TILE_CELLS][TILE_CELLS];
+
+  for (uint64_t t = begin; t < end; t++) {
+    // tiles are numbered by (other_axes[0], other_axes[1], q, dim1)
+    uint64_t rest = t;
+    uint32_t c0 = rest % job->stick1_tiles * TILE_CELLS;
+    rest /= job->stick1_tiles;
+    uint32_t q0 = rest % job->cell_tiles * TILE_CELLS;
+    rest /= job->cell_tiles;
+    o[job->other_axes[1]] = rest % job->out_dims[job->other_axes[1]];
+    o[job->other_axes[0]] = rest / job->out_dims[job->other_axes[1]];
+
+    uint32_t num_c = MIN(TILE_CELLS, job->out_dims[3] - c0);
+    uint32_t num_q = MIN(TILE_CELLS, job->out_dims[q] - q0);
+
+    // each input stick gives a row of the tile: num_q cells along the
+    // input's dim1, starting on a stick boundary as q0 is a multiple of
+    // TILE_CELLS
+    o[q] = q0;
+    for (uint32_t ci = 0; ci < num_c; ci++) {
+      o[3] = c0 + ci;
+      for (int k = 0; k < ZDNN_MAX_DIMS; k++) {
+        x[job->perm[k]] = o[k];
+      }
+      memcpy(tile[ci], job->in_buf + stick_offset(&job->in, x),
+             num_q * sizeof(uint16_t));
+    }
+
+    // each output stick takes a column of the tile
+    o[3] = c0;
+    for (uint32_t qi = 0; qi < num_q; qi++) {
+      o[q] = q0 + qi;
+      uint16_t *out_stick =
+          (uint16_t *)(job->out_buf + stick_offset(&job->out, o));
+      for (uint32_t ci = 0; ci < num_c; ci++) {
+        out_stick[ci] = tile[ci][qi];
+      }
+      if (num_c < TILE_CELLS) {
+        memset(&out_stick[num_c], 0, (TILE_CELLS - num_c) * sizeof(uint16_t));
+      }
+    }
+  }
+}
+
+/// Check the zTensors and permutation of a transpose
+///
+/// \param[in] input the input zTensor
+/// \param[in] perm the permutation
+/// \param[in] output the output zTensor
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_STATE
+///         ZDNN_INVALID_FORMAT
+///         ZDNN_INVALID_TYPE
+///         ZDNN_INVALID_SHAPE
+///         ZDNN_INVALID_BUFFER
+///
+static zdnn_status verify_transpose_tensors(const zdnn_ztensor *input,
+                                            const uint8_t *perm,
+                                            const zdnn_ztensor *output) {
+  const zdnn_tensor_desc *in_desc = input->transformed_desc,
+                         *out_desc = output->transformed_desc;
+
+  if (!input->is_transformed) {
+    return ZDNN_STATUS(ZDNN_INVALID_STATE, "input tensor is not transformed.",
+                       NO_ARG);
+  }
+  if (in_desc->format != ZDNN_FORMAT_4DFEATURE ||
+      out_desc->format != ZDNN_FORMAT_4DFEATURE) {
+    return ZDNN_STATUS(ZDNN_INVALID_FORMAT,
+                       "Formats must be %s, input: %s, output: %s",
+                       get_data_format_str(ZDNN_FORMAT_4DFEATURE),
+                       get_data_format_str(in_desc->format),
+                       get_data_format_str(out_desc->format));
+  }
+  if (in_desc->type != ZDNN_DLFLOAT16 || out_desc->type != ZDNN_DLFLOAT16) {
+    return ZDNN_STATUS(ZDNN_INVALID_TYPE,
+                       "Types must be %s, input: %s, output: %s",
+                       get_data_type_str(ZDNN_DLFLOAT16),
+                       get_data_type_str(in_desc->type),
+                       get_data_type_str(out_desc->type));
+  }
+
+  uint8_t seen = 0;
+  for (int k = 0; k < ZDNN_MAX_DIMS; k++) {
+    if (perm[k] >= ZDNN_MAX_DIMS || (seen & (1 << perm[k]))) {
+      return ZDNN_STATUS(ZDNN_INVALID_SHAPE,
+                         "(%u, %u, %u, %u) is not a permutation of the "
+                         "axes (0, 1, 2, 3)",
+                         perm[0], perm[1], perm[2], perm[3]);
+    }
+    seen |= 1 << perm[k];
+  }
+
+  const uint32_t in_dims[] = {in_desc->dim4, in_desc->dim3, in_desc->dim2,
+                              in_desc->dim1};
+  if (out_desc->dim4 != in_dims[perm[0]] ||
+      out_desc->dim3 != in_dims[perm[1]] ||
+      out_desc->dim2 != in_dims[perm[2]] ||
+      out_desc->dim1 != in_dims[perm[3]]) {
+    return ZDNN_STATUS(ZDNN_INVALID_SHAPE,
+                       "Output dims (%u, %u, %u, %u) are not input dims "
+                       "(%u, %u, %u, %u) permuted by (%u, %u, %u, %u)",
+                       out_desc->dim4, out_desc->dim3, out_desc->dim2,
+                       out_desc->dim1, in_dims[0], in_dims[1], in_dims[2],
+                       in_dims[3], perm[0], perm[1], perm[2], perm[3]);
+  }
+
+  if (!input->buffer || !output->buffer ||
+      output->buffer_size < zdnn_getsize_ztensor(out_desc)) {
+    return ZDNN_STATUS_NO_MSG(ZDNN_INVALID_BUFFER);
+  }
+  return ZDNN_STATUS_OK;
+}
+
+/// Permute the dims of a transformed zTensor into another, moving its values
+/// between sticks without untransforming them.  Axes are numbered in
+/// transformed NHWC order, 0 for dim4 through 3 for dim1, and output axis k
+/// is input axis perm[k].  For example (0, 3, 1, 2) takes NHWC to NCHW order
+/// and (0, 1, 3, 2) swaps the inner two dims.
+///
+/// \param[in] input transformed DLFLOAT16 feature zTensor
+/// \param[in] perm ZDNN_MAX_DIMS input axes, one per output axis
+/// \param[out] output DLFLOAT16 feature zTensor of the permuted shape
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_STATE
+///         ZDNN_INVALID_FORMAT
+///         ZDNN_INVALID_TYPE
+///         ZDNN_INVALID_SHAPE
+///         ZDNN_INVALID_BUFFER
+///
+zdnn_status zdnn_transpose_ztensor(const zdnn_ztensor *input,
+                                   const uint8_t *perm, zdnn_ztensor *output) {
+  zdnn_status status;
+
+  if ((status = verify_transpose_tensors(input, perm, output)) != ZDNN_OK) {
+    return status;
+  }
+
+  transpose_job job;
+  const zdnn_tensor_desc *out_desc = output->transformed_desc;
+
+  job.in_buf = input->buffer;
+  job.out_buf = output->buffer;
+  init_stick_geometry(input->transformed_desc, &job.in);
+  init_stick_geometry(out_desc, &job.out);
+  job.out_dims[0] = out_desc->dim4;
+  job.out_dims[1] = out_desc->dim3;
+  job.out_dims[2] = out_desc->dim2;
+  job.out_dims[3] = out_desc->dim1;
+  memcpy(job.perm, perm, sizeof(job.perm));
+
+  if (perm[3] == 3) {
+    LOG_TRACE("Strategy: copy whole sticks", NO_ARG);
+    run_parallel((uint64_t)out_desc->dim4 * out_desc->dim3,
+                 MAX(1, TRANSPOSE_CELLS_PER_CHUNK /
+                            MAX((uint64_t)out_desc->dim2 * out_desc->dim1,
+                                1)),
+                 transpose_sticks_chunk, &job);
+  } else {
+    LOG_TRACE("Strategy: transpose tiles of cells", NO_ARG);
+    uint8_t n = 0;
+    for (uint8_t k = 0; k < 3; k++) {
+      if (perm[k] == 3) {
+        job.cell_axis = k;
+      } else {
+        job.other_axes[n++] = k;
+      }
+    }
+    job.cell_tiles = CEIL(job.out_dims[job.cell_axis], TILE_CELLS);
+    job.stick1_tiles = CEIL(out_desc->dim1, TILE_CELLS);
+
+    run_parallel((uint64_t)job.out_dims[job.other_axes[0]] *
+                     job.out_dims[job.other_axes[1]] * job.cell_tiles *
+                     job.stick1_tiles,
+                 MAX(1, TRANSPOSE_CELLS_PER_CHUNK / (TILE_CELLS * TILE_CELLS)),
+                 transpose_tiles_chunk, &job);
+  }
+
+  output->is_transformed = true;
+  return ZDNN_STATUS_OK;
+}
@@ -72,7 +72,8 @@ void print_hex(size_t const size, void const *const ptr) {
 }
 
 /// Test if bit at bit_pos is 1 in a bit128_t struct
-///  Bit position is assumed to be left to right of uint64_t field
+///  Bit position is assumed to be left to right in storage order, as the
+///  NNPA-QAF fields are big-endian regardless of host
 ///
 /// \param[in] field Pointer to bit128_t struct
 /// \param[in] bit_pos 0-based bit position
@@ -80,19 +81,16 @@ void print_hex(size_t const size, void const *const ptr) {
 /// \return true or false
 ///
 bool is_bitset_128(bit128_t field, uint8_t bit_pos) {
-  if (bit_pos < 64) {
-    return field.bits_0to63 &
-           ((uint64_t)1 << ((BIT_SIZEOF(uint64_t) - 1) - bit_pos));
-  } else if (bit_pos < 128) {
-    return field.bits_64to127 &
-           ((uint64_t)1 << ((BIT_SIZEOF(uint64_t) - 1) - (bit_pos - 64)));
+  if (bit_pos < 128) {
+    return ((uint8_t *)&field)[bit_pos / 8] & (0x80 >> (bit_pos % 8));
   } else {
     return false;
   }
 }
 
 /// Test if bit at bit_pos is 1 in a bit256_t struct
-///  Bit position is assumed to be left to right of uint64_t field
+///  Bit position is assumed to be left to right in storage order, as the
+///  NNPA-QAF fields are big-endian regardless of host
 ///
 /// \param[in] field Pointer to bit256_t struct
 /// \param[in] bit_pos 0-based bit position
@@ -100,18 +98,8 @@ bool is_bitset_128(bit128_t field, uint8_t bit_pos) {
 /// \return true or false
 ///
 bool is_bitset_256(bit256_t field, uint16_t bit_pos) {
-  if (bit_pos < 64) {
-    return field.bits_0to63 &
-           ((uint64_t)1 << ((BIT_SIZEOF(uint64_t) - 1) - bit_pos));
-  } else if (bit_pos < 128) {
-    return field.bits_64to127 &
-           ((uint64_t)1 << ((BIT_SIZEOF(uint64_t) - 1) - (bit_pos - 64)));
-  } else if (bit_pos < 192) {
-    return field.bits_128to191 &
-           ((uint64_t)1 << ((BIT_SIZEOF(uint64_t) - 1) - (bit_pos - 128)));
-  } else if (bit_pos < 256) {
-    return field.bits_192to255 &
-           ((uint64_t)1 << ((BIT_SIZEOF(uint64_t) - 1) - (bit_pos - 192)));
+  if (bit_pos < 256) {
+    return ((uint8_t *)&field)[bit_pos / 8] & (0x80 >> (bit_pos % 8));
   } else {
     return false;
   }
@@ -275,6 +275,10 @@ zdnn_status invoke_nnpa(uint8_t function_code, char *parm_block,
     }
   }
 
+  if (nnpa_backend == NNPA_BACKEND_SOFT) {
+    return soft_invoke_nnpa(function_code, parm_block, exception_flags);
+  }
+
   // clang-format off
 #if defined(__MVS__)
   struct psa *psaptr =
@@ -306,7 +310,7 @@ zdnn_status invoke_nnpa(uint8_t function_code, char *parm_block,
                        "NNPA facility unavailable", NO_ARG);
   }
 
-#else
+#elif defined(__s390x__)
     register uint64_t r0 __asm__("%r0") = function_code;
     register uint64_t r1 __asm__("%r1") = (uint64_t)parm_block;
 
@@ -320,6 +324,10 @@ zdnn_status invoke_nnpa(uint8_t function_code, char *parm_block,
     : "memory", "cc");                   // ASM clobbers
     rtn.r0 = r0;
 
+#else
+    // no NNPA instruction outside of IBM Z, only the software backend
+    return ZDNN_STATUS(ZDNN_UNAVAILABLE_FUNCTION,
+                       "NNPA facility unavailable", NO_ARG);
 #endif   // defined(__MVS__)
   // clang-format on
 
@@ -353,6 +361,10 @@ zdnn_status invoke_nnpa(uint8_t function_code, char *parm_block,
 /// possible on NNPA_QAF.
 ///
 zdnn_status invoke_nnpa_query(nnpa_qaf_parameter_block *qpb) {
+  if (nnpa_backend == NNPA_BACKEND_SOFT) {
+    return invoke_nnpa(NNPA_QAF, (char *)qpb, NULL);
+  }
+
 #if defined(__MVS__)
   /***********************************************************************
    * On z/OS, use system copy of STFLE output ("faclnnpaf").  (LoZ has to
@@ -85,6 +85,7 @@ typedef enum zdnn_status {
   ZDNN_CONVERT_FAILURE,                               // Floating point data conversion failure.
   ZDNN_INVALID_STATE,                                 // Invalid zTensor state.
   ZDNN_UNSUPPORTED_AIU_EXCEPTION,                     // zAIU operation returned an unexpected exception.
+  ZDNN_FILE_ERROR,                                    // zTensor file or shared memory can not be accessed, or is not valid.
   // ----------------------------------------------------------------
   ZDNN_UNSUPPORTED_PARMBLOCK = ZDNN_HW_ERROR + 0x0001, // NNPA parameter block format is not supported by the model.
   ZDNN_UNAVAILABLE_FUNCTION,                           // Specified NNPA function is not defined or installed on the machine.
@@ -371,7 +372,12 @@ typedef struct zdnn_ztensor {
   char reserved[3];    // not currently used, should contain zeros.
   float rec_scale;    // the scale factor for quantization, stored as reciprocal
   float offset;       // the offset for quantization
-  char reserved2[20]; // not currently used, should contain zeros.
+  bool is_per_channel; // channel_scales and channel_offsets are in use
+  char reserved2[3];   // not currently used, should contain zeros.
+  const float *channel_scales;  // per-output-channel scales of quantized
+                                // weights (not reciprocals), or NULL
+  const float *channel_offsets; // per-output-channel offsets of quantized
+                                // weights, or NULL
 } zdnn_ztensor;
 
 #define ZDNN_VERSION "1.2.0"
@@ -436,6 +442,11 @@ void zdnn_init_quantized_ztensor(zdnn_tensor_desc *pre_tfrmd_desc,
                                  zdnn_tensor_desc *tfrmd_desc, float scale,
                                  float offset, zdnn_ztensor *output);
 
+void zdnn_init_per_channel_quantized_ztensor(
+    zdnn_tensor_desc *pre_tfrmd_desc, zdnn_tensor_desc *tfrmd_desc, float scale,
+    float offset, const float *channel_scales, const float *channel_offsets,
+    zdnn_ztensor *output);
+
 zdnn_status zdnn_init_ztensor_with_malloc(zdnn_tensor_desc *pre_tfrmd_desc,
                                           zdnn_tensor_desc *tfrmd_desc,
                                           zdnn_ztensor *output);
@@ -453,6 +464,37 @@ uint64_t zdnn_getsize_ztensor(const zdnn_tensor_desc *tfrmd_desc);
 zdnn_status zdnn_getrange_ztensor(const zdnn_ztensor *ztensor, float *min,
                                   float *max);
 
+// Transformed zTensors saved to a file and mapped back into memory
+typedef struct zdnn_ztensor_file zdnn_ztensor_file;
+
+zdnn_status zdnn_save_ztensors(const char *path,
+                               const zdnn_ztensor *const *ztensors,
+                               uint32_t count);
+zdnn_status zdnn_map_ztensor_file(const char *path, zdnn_ztensor_file **file);
+uint32_t zdnn_get_ztensor_file_count(const zdnn_ztensor_file *file);
+const zdnn_ztensor *zdnn_get_ztensor_file_entry(const zdnn_ztensor_file *file,
+                                                uint32_t index);
+void zdnn_unmap_ztensor_file(zdnn_ztensor_file *file);
+
+// zTensor buffers in named POSIX shared memory, shared across processes
+zdnn_status zdnn_init_ztensor_with_shm(zdnn_tensor_desc *pre_tfrmd_desc,
+                                       zdnn_tensor_desc *tfrmd_desc,
+                                       const char *name, zdnn_ztensor *output);
+zdnn_status zdnn_publish_shm_ztensor(zdnn_ztensor *ztensor);
+zdnn_status zdnn_attach_shm_ztensor(zdnn_tensor_desc *pre_tfrmd_desc,
+                                    zdnn_tensor_desc *tfrmd_desc,
+                                    const char *name, zdnn_ztensor *output);
+zdnn_status zdnn_detach_shm_ztensor(zdnn_ztensor *ztensor);
+zdnn_status zdnn_unlink_shm_ztensor(const char *name);
+
+zdnn_status zdnn_init_ztensor_view(const zdnn_ztensor *parent,
+                                   uint32_t dim4_start, uint32_t dim4_count,
+                                   uint32_t dim3_start, uint32_t dim3_count,
+                                   uint32_t dim2_start, uint32_t dim2_count,
+                                   zdnn_tensor_desc *pre_tfrmd_desc,
+                                   zdnn_tensor_desc *tfrmd_desc,
+                                   zdnn_ztensor *view);
+
 // -----------------------------------------------------------------------------
 // External Query Functions
 // -----------------------------------------------------------------------------
@@ -478,6 +520,37 @@ zdnn_status zdnn_refresh_nnpa_query_result();
 bool zdnn_is_version_runnable(uint32_t ver_num);
 uint32_t zdnn_get_max_runnable_version();
 
+// -----------------------------------------------------------------------------
+// Operation Plan Functions
+// -----------------------------------------------------------------------------
+
+// A zAIU operation validated and prepared once, for repeated execution
+typedef struct zdnn_op_plan zdnn_op_plan;
+
+zdnn_status zdnn_begin_op_plan(zdnn_op_plan **plan);
+zdnn_status zdnn_end_op_plan(zdnn_op_plan *plan);
+zdnn_status zdnn_execute_op_plan(zdnn_op_plan *plan);
+void zdnn_free_op_plan(zdnn_op_plan *plan);
+
+// -----------------------------------------------------------------------------
+// Host Threading Functions
+// -----------------------------------------------------------------------------
+
+void zdnn_set_max_threads(uint32_t threads);
+uint32_t zdnn_get_max_threads();
+
+// -----------------------------------------------------------------------------
+// Memory Allocation Functions
+// -----------------------------------------------------------------------------
+
+// Host allocator for zTensor buffers, save areas and work areas.  Must return
+// memory on a 4k boundary.
+typedef void *(*zdnn_alloc_func)(size_t size, void *user_data);
+typedef void (*zdnn_free_func)(void *ptr, size_t size, void *user_data);
+
+void zdnn_set_allocator(zdnn_alloc_func alloc_func, zdnn_free_func free_func,
+                        void *user_data);
+
 // -----------------------------------------------------------------------------
 // External Elementwise Operations
 // -----------------------------------------------------------------------------
@@ -539,6 +612,71 @@ zdnn_status zdnn_gru(const zdnn_ztensor *input, const zdnn_ztensor *h0,
                      lstm_gru_direction direction, void *work_area,
                      zdnn_ztensor *hn_output);
 
+// LSTM/GRU over a batch of sequences of different lengths, seq_lens[b]
+// timesteps of batch row b are valid
+zdnn_status zdnn_lstm_packed(const zdnn_ztensor *input,
+                             const uint32_t *seq_lens, const zdnn_ztensor *h0,
+                             const zdnn_ztensor *c0,
+                             const zdnn_ztensor *weights,
+                             const zdnn_ztensor *biases,
+                             const zdnn_ztensor *hidden_weights,
+                             const zdnn_ztensor *hidden_biases,
+                             lstm_gru_direction direction, void *work_area,
+                             zdnn_ztensor *hn_output, zdnn_ztensor *cf_output);
+zdnn_status zdnn_gru_packed(const zdnn_ztensor *input,
+                            const uint32_t *seq_lens, const zdnn_ztensor *h0,
+                            const zdnn_ztensor *weights,
+                            const zdnn_ztensor *biases,
+                            const zdnn_ztensor *hidden_weights,
+                            const zdnn_ztensor *hidden_biases,
+                            lstm_gru_direction direction, void *work_area,
+                            zdnn_ztensor *hn_output);
+
+// Stacked LSTM/GRU layers, each array holds one ztensor per layer
+zdnn_status zdnn_lstm_stack(const zdnn_ztensor *input, uint32_t num_layers,
+                            const zdnn_ztensor **h0, const zdnn_ztensor **c0,
+                            const zdnn_ztensor **weights,
+                            const zdnn_ztensor **biases,
+                            const zdnn_ztensor **hidden_weights,
+                            const zdnn_ztensor **hidden_biases,
+                            lstm_gru_direction direction, void *work_area,
+                            zdnn_ztensor *hn_output, zdnn_ztensor *cf_output);
+zdnn_status zdnn_gru_stack(const zdnn_ztensor *input, uint32_t num_layers,
+                           const zdnn_ztensor **h0,
+                           const zdnn_ztensor **weights,
+                           const zdnn_ztensor **biases,
+                           const zdnn_ztensor **hidden_weights,
+                           const zdnn_ztensor **hidden_biases,
+                           lstm_gru_direction direction, void *work_area,
+                           zdnn_ztensor *hn_output);
+
+// Forward LSTM/GRU fed a few timesteps at a time, state kept in between
+typedef struct zdnn_rnn_session zdnn_rnn_session;
+
+zdnn_status zdnn_create_lstm_session(const zdnn_ztensor *h0,
+                                     const zdnn_ztensor *c0,
+                                     const zdnn_ztensor *weights,
+                                     const zdnn_ztensor *biases,
+                                     const zdnn_ztensor *hidden_weights,
+                                     const zdnn_ztensor *hidden_biases,
+                                     uint32_t max_timesteps,
+                                     zdnn_rnn_session **session);
+zdnn_status zdnn_create_gru_session(const zdnn_ztensor *h0,
+                                    const zdnn_ztensor *weights,
+                                    const zdnn_ztensor *biases,
+                                    const zdnn_ztensor *hidden_weights,
+                                    const zdnn_ztensor *hidden_biases,
+                                    uint32_t max_timesteps,
+                                    zdnn_rnn_session **session);
+zdnn_status zdnn_rnn_session_step(zdnn_rnn_session *session,
+                                  const zdnn_ztensor *input,
+                                  zdnn_ztensor *hn_output,
+                                  zdnn_ztensor *cf_output);
+zdnn_status zdnn_reset_rnn_session(zdnn_rnn_session *session,
+                                   const zdnn_ztensor *h0,
+                                   const zdnn_ztensor *c0);
+void zdnn_free_rnn_session(zdnn_rnn_session *session);
+
 // -----------------------------------------------------------------------------
 // Matrix Multiplication Operations
 // -----------------------------------------------------------------------------
@@ -563,6 +701,7 @@ zdnn_status zdnn_quantized_matmul_op(
     const zdnn_ztensor *input_c, zdnn_matmul_ops op_type, const int8_t clip_min,
     const int8_t clip_max, const bool disable_clipping, const bool dequantize,
     const bool pre_computed, void *work_area, zdnn_ztensor *output);
+void zdnn_reset_quantized_bias_cache();
 
 // -----------------------------------------------------------------------------
 // External Norm Operations
@@ -611,6 +750,33 @@ zdnn_status zdnn_conv2d(const zdnn_ztensor *input, const zdnn_ztensor *kernel,
                         zdnn_pool_padding padding_type, uint32_t stride_height,
                         uint32_t stride_width, zdnn_conv2d_act act_func,
                         const void *clipping_value, zdnn_ztensor *output);
+zdnn_status zdnn_conv2d_grouped(const zdnn_ztensor *input,
+                                const zdnn_ztensor *kernel,
+                                const zdnn_ztensor *bias, uint32_t groups,
+                                zdnn_pool_padding padding_type,
+                                uint32_t stride_height, uint32_t stride_width,
+                                zdnn_conv2d_act act_func,
+                                const void *clipping_value,
+                                zdnn_ztensor *output);
+zdnn_status zdnn_conv2d_dilated(const zdnn_ztensor *input,
+                                const zdnn_ztensor *kernel,
+                                const zdnn_ztensor *bias,
+                                zdnn_pool_padding padding_type,
+                                uint32_t stride_height, uint32_t stride_width,
+                                uint32_t dilation_height,
+                                uint32_t dilation_width,
+                                zdnn_conv2d_act act_func,
+                                const void *clipping_value,
+                                zdnn_ztensor *output);
+zdnn_status zdnn_conv2d_transpose(const zdnn_ztensor *input,
+                                  const zdnn_ztensor *kernel,
+                                  const zdnn_ztensor *bias,
+                                  zdnn_pool_padding padding_type,
+                                  uint32_t stride_height,
+                                  uint32_t stride_width,
+                                  zdnn_conv2d_act act_func,
+                                  const void *clipping_value,
+                                  zdnn_ztensor *output);
 
 // -----------------------------------------------------------------------------
 // External Tensor Transform Operations
@@ -625,11 +791,26 @@ zdnn_status zdnn_transform_quantized_ztensor(zdnn_ztensor *ztensor,
                                              int8_t clip_min, int8_t clip_max,
                                              const void *data);
 
+zdnn_status zdnn_transform_dynamic_quantized_ztensor(zdnn_ztensor *ztensor,
+                                                     bool saturation_control,
+                                                     int8_t clip_min,
+                                                     int8_t clip_max,
+                                                     const void *data);
+
 zdnn_status zdnn_transform_origtensor(const zdnn_ztensor *ztensor,
                                       void *out_buf);
 
 zdnn_status zdnn_reshape_ztensor(const zdnn_ztensor *src, zdnn_ztensor *dest);
 
+zdnn_status zdnn_transpose_ztensor(const zdnn_ztensor *input,
+                                   const uint8_t *perm, zdnn_ztensor *output);
+
+zdnn_status zdnn_concat_ztensors(const zdnn_ztensor *const *inputs,
+                                 uint32_t count, uint8_t axis,
+                                 zdnn_ztensor *output);
+zdnn_status zdnn_split_ztensor(const zdnn_ztensor *input, uint8_t axis,
+                               zdnn_ztensor *const *outputs, uint32_t count);
+
 // -----------------------------------------------------------------------------
 // External Version Related Functions
 // -----------------------------------------------------------------------------
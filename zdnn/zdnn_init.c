@@ -39,8 +39,19 @@
 // global variables, set by zdnn_init() via environment vars
 log_levels log_level = LOGLEVEL_ERROR; // log level (see enum log_levels)
 bool precheck_enabled = false; // enables tensor pre-check before invoking NNPA
+bool streaming_stores_enabled = false; // unstickify bypassing the cache
+uint64_t alloc_cache_bytes = 64 * 1024 * 1024; // pooled 4k-aligned areas
+bool hugepages_enabled = false; // back large areas with huge pages
+bool rnn_bidir_concurrent = false; // run BIDIR RNN directions on 2 threads
+uint32_t qmatmul_bias_cache_entries = 0; // cached quantized matmul biases
 uint32_t status_diag = STATUS_DIAG_NOT_SET; // diagnostic info when status = X
 char log_module[LOGMODULE_SIZE] = "\0";
+#if defined(ZDNN_VEC_GENERIC)
+// not on IBM Z, the software backend is the only one that can work
+nnpa_backends nnpa_backend = NNPA_BACKEND_SOFT;
+#else
+nnpa_backends nnpa_backend = NNPA_BACKEND_HW; // where NNPA functions execute
+#endif
 
 // Index of the facility bit for the NNPA facility
 #define STFLE_NNPA 165
@@ -89,6 +100,34 @@ void zdnn_init() {
     precheck_enabled = !strcasecmp("true", ptr);
   }
 
+  if ((ptr = getenv(ENVVAR_STREAMING_STORES))) {
+    streaming_stores_enabled = !strcasecmp("true", ptr);
+  }
+
+  if ((ptr = getenv(ENVVAR_ALLOC_CACHE_MB))) {
+    long val = strtol(ptr, &endptr, 10);
+
+    if (endptr != ptr && endptr == ptr + strlen(ptr) && val >= 0) {
+      alloc_cache_bytes = (uint64_t)val * 1024 * 1024;
+    }
+  }
+
+  if ((ptr = getenv(ENVVAR_HUGEPAGES))) {
+    hugepages_enabled = !strcasecmp("true", ptr);
+  }
+
+  if ((ptr = getenv(ENVVAR_RNN_BIDIR_CONCURRENT))) {
+    rnn_bidir_concurrent = !strcasecmp("true", ptr);
+  }
+
+  if ((ptr = getenv(ENVVAR_QMATMUL_BIAS_CACHE))) {
+    long val = strtol(ptr, &endptr, 10);
+
+    if (endptr != ptr && endptr == ptr + strlen(ptr) && val >= 0) {
+      qmatmul_bias_cache_entries = (uint32_t)MIN(val, UINT32_MAX);
+    }
+  }
+
   if ((ptr = getenv(ENVVAR_STATUS_DIAG))) {
 
     uint32_t val;
@@ -109,13 +148,38 @@ void zdnn_init() {
     strncpy(log_module, ptr, LOGMODULE_SIZE - 1);
   }
 
-  // If there is an NNPA facility installed refresh query results.
-  if (zdnn_is_nnpa_installed() == true) {
+  if ((ptr = getenv(ENVVAR_BACKEND))) {
+    if (!strcasecmp("hw", ptr)) {
+      nnpa_backend = NNPA_BACKEND_HW;
+    }
+
+    if (!strcasecmp("soft", ptr)) {
+      nnpa_backend = NNPA_BACKEND_SOFT;
+    }
+
+    // use the software backend only when there's no NNPA facility
+    if (!strcasecmp("auto", ptr)) {
+      nnpa_backend = zdnn_is_nnpa_installed() ? NNPA_BACKEND_HW
+                                              : NNPA_BACKEND_SOFT;
+    }
+  }
+
+  if ((ptr = getenv(ENVVAR_MAX_THREADS))) {
+    long val = strtol(ptr, &endptr, 10);
+
+    if (endptr != ptr && endptr == ptr + strlen(ptr) && val >= 0) {
+      zdnn_set_max_threads((uint32_t)MIN(val, UINT32_MAX));
+    }
+  }
+
+  // If there is an NNPA facility installed (or emulated by the software
+  // backend) refresh query results.
+  if (nnpa_backend == NNPA_BACKEND_SOFT || zdnn_is_nnpa_installed() == true) {
     zdnn_refresh_nnpa_query_result();
   }
 }
 
-#ifndef __MVS__
+#if defined(__s390x__) && !defined(__MVS__)
 #define STFLE_LENGTH 32
 
 static int invoke_stfle(unsigned char *facility_list) {
@@ -153,7 +217,7 @@ static inline int check_bitfield(const uint8_t *bitfield, int bitno) {
 /// Determine if NNPA hardware support is available
 ///
 /// The function unconditionally uses the STFLE instruction available
-/// since IBM z9-109.
+/// since IBM z9-109.  Always true when the software backend is selected.
 ///
 /// \param[in] None
 ///
@@ -161,7 +225,14 @@ static inline int check_bitfield(const uint8_t *bitfield, int bitno) {
 ///         false
 ///
 bool zdnn_is_nnpa_installed() {
-#ifndef __MVS__
+  if (nnpa_backend == NNPA_BACKEND_SOFT) {
+    return true;
+  }
+
+#if !defined(__s390x__) && !defined(__MVS__)
+  // NNPA only exists on IBM Z
+  return false;
+#elif !defined(__MVS__)
   int nnpa_supported;
   unsigned char facilities[STFLE_LENGTH] = {0};
   int cc;
@@ -24,11 +24,7 @@
 // -----------------------------------------------------------------------------
 // convert_hw.c includes
 // -----------------------------------------------------------------------------
-#if defined(__MVS__)    // If z/OS, use XL C include and typedef
-#include <builtins.h>   // needed for XL C vector ops
-#else                   // If LoZ, use gcc include and typedef
-#include <s390intrin.h> // needed for LoZ vector ops
-#endif
+#include "zdnn_vec.h" // vector types and ops, native on Z, emulated elsewhere
 
 #include "../config.h"
 
@@ -149,13 +145,32 @@ typedef enum elements_mode {
 
 extern log_levels log_level;
 extern bool precheck_enabled;
+extern bool streaming_stores_enabled;
+extern uint64_t alloc_cache_bytes;
+extern bool hugepages_enabled;
+extern bool rnn_bidir_concurrent;
+extern uint32_t qmatmul_bias_cache_entries;
 extern uint32_t status_diag;
 extern char log_module[LOGMODULE_SIZE];
 
+typedef enum nnpa_backends {
+  NNPA_BACKEND_HW,  // issue the NNPA instruction
+  NNPA_BACKEND_SOFT // interpret the parameter block on the host CPU
+} nnpa_backends;
+
+extern nnpa_backends nnpa_backend;
+
 #define ENVVAR_LOGLEVEL "ZDNN_LOGLEVEL"
 #define ENVVAR_ENABLE_PRECHECK "ZDNN_ENABLE_PRECHECK"
 #define ENVVAR_STATUS_DIAG "ZDNN_STATUS_DIAG"
 #define ENVVAR_LOGMODULE "ZDNN_LOGMODULE"
+#define ENVVAR_BACKEND "ZDNN_BACKEND"
+#define ENVVAR_MAX_THREADS "ZDNN_MAX_THREADS"
+#define ENVVAR_STREAMING_STORES "ZDNN_STREAMING_STORES"
+#define ENVVAR_ALLOC_CACHE_MB "ZDNN_ALLOC_CACHE_MB"
+#define ENVVAR_HUGEPAGES "ZDNN_HUGEPAGES"
+#define ENVVAR_RNN_BIDIR_CONCURRENT "ZDNN_RNN_BIDIR_CONCURRENT"
+#define ENVVAR_QMATMUL_BIAS_CACHE "ZDNN_QMATMUL_BIAS_CACHE"
 
 #define STATUS_DIAG_NOT_SET -1
 
@@ -176,6 +191,7 @@ DCL_EXTERN_STATUS_STR(ZDNN_INVALID_BUFFER)
 DCL_EXTERN_STATUS_STR(ZDNN_CONVERT_FAILURE)
 DCL_EXTERN_STATUS_STR(ZDNN_INVALID_STATE)
 DCL_EXTERN_STATUS_STR(ZDNN_UNSUPPORTED_AIU_EXCEPTION)
+DCL_EXTERN_STATUS_STR(ZDNN_FILE_ERROR)
 
 DCL_EXTERN_STATUS_STR(ZDNN_UNSUPPORTED_PARMBLOCK)
 DCL_EXTERN_STATUS_STR(ZDNN_UNAVAILABLE_FUNCTION)
@@ -383,6 +399,15 @@ CASSERT(sizeof(nnpa_qaf_parameter_block) == QAF_PARMBLOCK_SIZE);
 
 extern nnpa_qaf_parameter_block nnpa_query_result;
 
+// The QAF bit-mask fields are big-endian, read them as host integers
+#if defined(ZDNN_VEC_BIG_ENDIAN)
+#define QAF_BITMASK16(x) (x)
+#define QAF_BITMASK32(x) (x)
+#else
+#define QAF_BITMASK16(x) __builtin_bswap16(x)
+#define QAF_BITMASK32(x) __builtin_bswap32(x)
+#endif
+
 // -----------------------------------------------------------------------------
 // Versioning
 // -----------------------------------------------------------------------------
@@ -394,8 +419,6 @@ void refresh_aiu_lib_vernum();
 // Floating Point Format Conversion Functions
 // -----------------------------------------------------------------------------
 
-typedef vector unsigned int vec_float32;
-
 uint32_t convert_data_format(void *input_data, zdnn_data_types in_data_fmt,
                              void *output_data, zdnn_data_types out_data_fmt,
                              uint32_t num_fields,
@@ -440,6 +463,7 @@ void populate_nnpa_parm_block(
 
 void *malloc_aligned_4k(size_t size);
 void free_aligned_4k(void *aligned_ptr);
+uint64_t get_alloc_cached_bytes(void);
 
 // -----------------------------------------------------------------------------
 // NNPA Invoke Functions
@@ -448,6 +472,18 @@ void free_aligned_4k(void *aligned_ptr);
 zdnn_status invoke_nnpa(uint8_t function_code, char *parm_block,
                         uint8_t *exception_flags);
 zdnn_status invoke_nnpa_query(nnpa_qaf_parameter_block *qpb);
+zdnn_status soft_invoke_nnpa(uint8_t function_code, char *parm_block,
+                             uint8_t *exception_flags);
+
+#define EF_RANGE_VIOLATION_MASK 0x80
+
+// -----------------------------------------------------------------------------
+// Thread Pool
+// -----------------------------------------------------------------------------
+
+typedef void (*parallel_func)(void *ctx, uint64_t begin, uint64_t end);
+void run_parallel(uint64_t total, uint64_t grain, parallel_func func,
+                  void *ctx);
 
 // -----------------------------------------------------------------------------
 // Internal Function for zAIU Operations
@@ -473,6 +509,21 @@ zdnn_status aiu_lstm_gru(uint16_t op_parm_block_version, uint8_t function_code,
                          const zdnn_ztensor *hidden_biases,
                          lstm_gru_direction direction, void *work_area,
                          zdnn_ztensor *hn_output, zdnn_ztensor *cf_output);
+zdnn_status aiu_lstm_gru_packed(
+    uint16_t op_parm_block_version, uint8_t function_code,
+    const zdnn_ztensor *input, const uint32_t *seq_lens,
+    const zdnn_ztensor *h0, const zdnn_ztensor *c0,
+    const zdnn_ztensor *weights, const zdnn_ztensor *biases,
+    const zdnn_ztensor *hidden_weights, const zdnn_ztensor *hidden_biases,
+    lstm_gru_direction direction, void *work_area, zdnn_ztensor *hn_output,
+    zdnn_ztensor *cf_output);
+zdnn_status aiu_lstm_gru_stack(
+    uint16_t op_parm_block_version, uint8_t function_code,
+    const zdnn_ztensor *input, uint32_t num_layers, const zdnn_ztensor **h0,
+    const zdnn_ztensor **c0, const zdnn_ztensor **weights,
+    const zdnn_ztensor **biases, const zdnn_ztensor **hidden_weights,
+    const zdnn_ztensor **hidden_biases, lstm_gru_direction direction,
+    void *work_area, zdnn_ztensor *hn_output, zdnn_ztensor *cf_output);
 
 zdnn_status
 aiu_quantized_matmul(uint16_t op_parm_block_version,
@@ -482,6 +533,48 @@ aiu_quantized_matmul(uint16_t op_parm_block_version,
                      const int8_t clip_max, void *work_area,
                      zdnn_ztensor *output, const bool dequantize,
                      const bool disable_clipping, const bool pre_computed);
+void invalidate_qmatmul_bias_cache(const void *buffer);
+zdnn_status aiu_matmul_op(uint16_t op_parm_block_version,
+                          uint8_t function_code, const zdnn_ztensor *input_a,
+                          const zdnn_ztensor *input_b,
+                          const zdnn_ztensor *input_c, zdnn_ztensor *output,
+                          function_specific_parameters *fsp);
+zdnn_status aiu_conv2d_op(uint16_t op_parm_block_version,
+                          const zdnn_ztensor *input,
+                          const zdnn_ztensor *kernel, const zdnn_ztensor *bias,
+                          zdnn_ztensor *output,
+                          function_specific_parameters *fsp);
+zdnn_status aiu_conv2d_grouped_op(uint16_t op_parm_block_version,
+                                  const zdnn_ztensor *input,
+                                  const zdnn_ztensor *kernel,
+                                  const zdnn_ztensor *bias, uint32_t groups,
+                                  zdnn_ztensor *output,
+                                  function_specific_parameters *fsp);
+zdnn_status aiu_conv2d_dilated_op(uint16_t op_parm_block_version,
+                                  const zdnn_ztensor *input,
+                                  const zdnn_ztensor *kernel,
+                                  const zdnn_ztensor *bias, uint32_t dilation_h,
+                                  uint32_t dilation_w, zdnn_ztensor *output,
+                                  function_specific_parameters *fsp);
+zdnn_status aiu_conv2d_transpose_op(uint16_t op_parm_block_version,
+                                    const zdnn_ztensor *input,
+                                    const zdnn_ztensor *kernel,
+                                    const zdnn_ztensor *bias,
+                                    zdnn_ztensor *output,
+                                    function_specific_parameters *fsp);
+void copy_kernel_range(const zdnn_ztensor *from, const uint32_t *from_start,
+                       const zdnn_ztensor *to, const uint32_t *to_start,
+                       const uint32_t *count);
+
+zdnn_status check_op_plan_recordable(const char *op_name);
+
+bool is_chunkable_op(uint8_t function_code);
+zdnn_status aiu_ops_chunked(uint16_t op_parm_block_version,
+                            uint8_t function_code, const zdnn_ztensor *input1,
+                            const zdnn_ztensor *input2,
+                            const zdnn_ztensor *input3, zdnn_ztensor *output1,
+                            uint64_t func_sp_savearea_addr,
+                            function_specific_parameters *fsp);
 
 bool is_query_parmblock_installed(uint8_t parmblock_version);
 bool is_nnpa_fc_and_parmblock_installed(uint8_t function_code,
@@ -567,6 +660,7 @@ zdnn_status verify_descriptors_transform_origtensor(const zdnn_ztensor *input);
 zdnn_status verify_transformed_descriptor(const zdnn_tensor_desc *tfrmd_desc);
 
 zdnn_status verify_transformed_dimensions(const zdnn_tensor_desc *tfrmd_desc);
+bool is_within_nnpa_limits(const zdnn_tensor_desc *tfrmd_desc);
 
 // -----------------------------------------------------------------------------
 // Stickify Related Functions
@@ -574,6 +668,69 @@ zdnn_status verify_transformed_dimensions(const zdnn_tensor_desc *tfrmd_desc);
 
 size_t get_stick_offset(uint32_t e4x, uint32_t e3x, uint32_t e2x, uint32_t e1x,
                         const zdnn_tensor_desc *pre_tfrmd_desc);
+
+// Where the sticks of a 4DFEATURE stick area of 2-byte cells are
+typedef struct stick_geometry {
+  uint32_t dim3;
+  uint32_t dim2;
+  uint32_t dim1;
+  uint32_t cells_per_stick;
+  uint64_t bytes_per_row;    // stick area bytes of one e3x
+  uint64_t bytes_per_stick1; // stick area bytes between consecutive dim1 sticks
+  uint64_t bytes_per_e4x;    // stick area bytes between consecutive e4x
+} stick_geometry;
+
+void init_stick_geometry(const zdnn_tensor_desc *tfrmd_desc,
+                         stick_geometry *geom);
+bool get_ztensor_range_offset(const zdnn_tensor_desc *parent_desc,
+                              const uint32_t *start, const uint32_t *count,
+                              uint64_t *offset);
+void copy_ztensor_range(const zdnn_ztensor *whole, const zdnn_ztensor *piece,
+                        const uint32_t *start, bool to_whole);
+
+// A range of a zTensor that an operation is run on, see init_ztensor_tile()
+typedef struct ztensor_tile {
+  zdnn_tensor_desc pre_tfrmd_desc;
+  zdnn_tensor_desc tfrmd_desc;
+  zdnn_ztensor ztensor;
+  bool is_view; // ztensor points into the whole zTensor's buffer
+} ztensor_tile;
+
+uint32_t get_tile_size(uint32_t limit, uint32_t align);
+bool shrink_tile_size(uint32_t *size, uint32_t align);
+uint64_t get_tile_bytes(const zdnn_tensor_desc *like, uint32_t dim4,
+                        uint32_t dim3, uint32_t dim2, uint32_t dim1);
+zdnn_status init_ztensor_tile(const zdnn_ztensor *whole, const uint32_t *start,
+                              const uint32_t *count, bool copy_in,
+                              ztensor_tile *tile);
+zdnn_status init_temp_ztensor_tile(const ztensor_tile *like,
+                                   ztensor_tile *tile);
+void store_ztensor_tile(const zdnn_ztensor *whole, const uint32_t *start,
+                        const ztensor_tile *tile);
+void free_ztensor_tile(ztensor_tile *tile);
+
+// The partial results of an operation over tiles of its reduced dims, added
+// up for one output tile, see init_tile_sum()
+typedef struct tile_sum {
+  ztensor_tile *out_tile;
+  const ztensor_tile *bias_tile;
+  ztensor_tile zero_bias; // bias of every part after the first
+  ztensor_tile part;      // where the next part is computed
+  ztensor_tile other_tile;
+  bool have_zero_bias;
+  bool have_part;
+  bool have_other;
+  zdnn_ztensor *acc;   // the sum so far
+  zdnn_ztensor *other; // where the next sum goes, the output tile or a temp
+} tile_sum;
+
+void init_tile_sum(ztensor_tile *out_tile, const ztensor_tile *bias_tile,
+                   tile_sum *sum);
+zdnn_status next_tile_sum_part(tile_sum *sum);
+zdnn_status add_tile_sum_part(tile_sum *sum);
+void store_tile_sum(const zdnn_ztensor *whole, const uint32_t *start,
+                    const tile_sum *sum);
+void free_tile_sum(tile_sum *sum);
 bool is_bitset_128(bit128_t field, uint8_t bit_pos);
 bool is_bitset_256(bit256_t field, uint16_t bit_pos);
 
@@ -585,17 +742,14 @@ zdnn_status transform_zrh_ztensor(zdnn_ztensor *zrh_ztensor, void *zx_data,
 // -----------------------------------------------------------------------------
 // convert_hw.c wrapper Functions and types
 // -----------------------------------------------------------------------------
-typedef vector unsigned int vec_float32;
-typedef vector unsigned short vec_int16;
-typedef vector unsigned char vec_char8;
-
 vec_int16 aiu_vec_round_from_fp32(vec_float32 a, vec_float32 b);
 void aiu_vec_lengthen_to_fp32(vec_int16 a, vec_float32 *out1,
                               vec_float32 *out2);
 vec_int16 aiu_vec_convert_from_fp16(vec_int16 a);
 vec_int16 aiu_vec_convert_to_fp16(vec_int16 a);
 
-#if defined(__MVS__) || (defined(__ARCH__) && __ARCH__ < 14)
+#if defined(ZDNN_VEC_GENERIC) || defined(__MVS__) ||                          \
+    (defined(__ARCH__) && __ARCH__ < 14)
 #define VEC_ROUND_FROM_FP32(FP_HI, FP_LO)                                      \
   aiu_vec_round_from_fp32((vec_float32)(FP_HI), (vec_float32)(FP_LO));
 #define VEC_LENGTHEN_TO_FP32(IN, OUT_HI, OUT_LO)                               \
@@ -608,8 +762,8 @@ vec_int16 aiu_vec_convert_to_fp16(vec_int16 a);
    vector short to vector unsigned short.  */
 #if __GNUC__ <= 13
 #define VEC_LENGTHEN_TO_FP32(IN, OUT_HI, OUT_LO)                               \
-  (OUT_HI) = vec_extend_to_fp32_hi((vector short)(IN), 0);                     \
-  (OUT_LO) = vec_extend_to_fp32_lo((vector short)(IN), 0);
+  (OUT_HI) = vec_extend_to_fp32_hi((zdnn_vec_s16)(IN), 0);                     \
+  (OUT_LO) = vec_extend_to_fp32_lo((zdnn_vec_s16)(IN), 0);
 #else
 #define VEC_LENGTHEN_TO_FP32(IN, OUT_HI, OUT_LO)                               \
   (OUT_HI) = vec_extend_to_fp32_hi((IN), 0);                                   \
@@ -1547,6 +1701,7 @@ void dumpdata_ztensor(const zdnn_ztensor *ztensor, dump_mode mode,
 #define PADDED(x)                                                              \
   ((uint32_t)CEIL(x, AIU_2BYTE_CELLS_PER_STICK) * AIU_2BYTE_CELLS_PER_STICK)
 
+#if defined(ZDNN_VEC_S390)
 #if !defined(vec_float) || __ARCH__ < 13
 #undef vec_float
 #define vec_float(X)                                                           \
@@ -1572,6 +1727,7 @@ void dumpdata_ztensor(const zdnn_ztensor *ztensor, dump_mode mode,
     out;                                                                       \
   })
 #endif
+#endif // ZDNN_VEC_S390
 
 // -----------------------------------------------------------------------------
 // Private global variables
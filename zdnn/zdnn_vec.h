@@ -0,0 +1,325 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ZDNN_ZDNN_VEC_H_
+#define ZDNN_ZDNN_VEC_H_
+
+// -----------------------------------------------------------------------------
+// Vector abstraction used by the conversion and stickification code
+//
+// On IBM Z the compiler's vector facility built-ins are used directly.  On
+// any other host the same vector types (as zdnn_vec_* typedefs) and the subset
+// of vec_* built-ins the library uses are provided on top of GCC/Clang generic
+// vectors, which the compiler lowers to SSE (x86-64), ASIMD (aarch64) or scalar
+// code.
+//
+// Vectors are always 16 bytes, matching the z/Architecture vector registers
+// the stick conversion loops are written around.
+//
+// Byte oriented operations (vec_perm(), vec_load_len(), vec_store_len()) index
+// bytes in memory order, so they behave as on Z whenever the elements are
+// bytes.  Code that reinterprets wider elements as bytes, or halfword pairs as
+// words, must use the VEC_* helpers below so it's correct on either byte
+// order.
+// -----------------------------------------------------------------------------
+
+#if defined(__MVS__)    // If z/OS, use XL C include and typedef
+#include <builtins.h>   // needed for XL C vector ops
+#define ZDNN_VEC_S390
+#elif defined(__s390x__) // If LoZ, use gcc include and typedef
+#include <s390intrin.h>  // needed for LoZ vector ops
+#define ZDNN_VEC_S390
+#else
+#define ZDNN_VEC_GENERIC
+#endif
+
+#if defined(ZDNN_VEC_S390) ||                                                  \
+    (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define ZDNN_VEC_BIG_ENDIAN
+#endif
+
+// 16-byte vectors of each element type.  On Z these are the compiler's
+// `vector` types, elsewhere GCC/Clang generic vectors of the same layout, so
+// no `vector` keyword is defined for code that includes this header.
+//
+// Vector loads and stores on Z have no alignment requirement and the library
+// points vectors at arbitrary positions within tensor buffers, so the vector
+// typedefs used for that (VEC_UNALIGNED) must not assume any alignment on
+// other hosts either
+#if defined(ZDNN_VEC_GENERIC)
+typedef float zdnn_vec_f32 __attribute__((vector_size(16)));
+typedef signed int zdnn_vec_s32 __attribute__((vector_size(16)));
+typedef unsigned int zdnn_vec_u32 __attribute__((vector_size(16)));
+typedef signed short zdnn_vec_s16 __attribute__((vector_size(16)));
+typedef unsigned short zdnn_vec_u16 __attribute__((vector_size(16)));
+typedef signed char zdnn_vec_s8 __attribute__((vector_size(16)));
+typedef unsigned char zdnn_vec_u8 __attribute__((vector_size(16)));
+#define VEC_UNALIGNED __attribute__((vector_size(16), aligned(1)))
+#else
+typedef vector float zdnn_vec_f32;
+typedef vector signed int zdnn_vec_s32;
+typedef vector unsigned int zdnn_vec_u32;
+typedef vector signed short zdnn_vec_s16;
+typedef vector unsigned short zdnn_vec_u16;
+typedef vector signed char zdnn_vec_s8;
+typedef vector unsigned char zdnn_vec_u8;
+#define VEC_UNALIGNED vector
+#endif
+
+typedef VEC_UNALIGNED unsigned int vec_float32;
+typedef VEC_UNALIGNED unsigned short vec_int16;
+typedef VEC_UNALIGNED unsigned char vec_char8;
+
+#if defined(ZDNN_VEC_GENERIC)
+
+#include <stdint.h>
+#include <string.h>
+
+// number of elements in vector V
+#define VEC_ELEMENTS(V) (sizeof(V) / sizeof((V)[0]))
+
+/// Select bits from b where m is 1 and from a elsewhere, result has the type
+/// of a
+#define vec_sel(a, b, m)                                                       \
+  ((__typeof__(a))(((zdnn_vec_u8)(a) & ~(zdnn_vec_u8)(m)) |                    \
+                   ((zdnn_vec_u8)(b) & (zdnn_vec_u8)(m))))
+
+/// Element-wise compare, all 1s where equal
+#define vec_cmpeq(a, b) ((a) == (b))
+
+#define vec_max(a, b)                                                          \
+  ({                                                                           \
+    __typeof__(a) va_ = (a);                                                   \
+    __typeof__(a) vb_ = (b);                                                   \
+    vec_sel(vb_, va_, va_ > vb_);                                              \
+  })
+
+#define vec_min(a, b)                                                          \
+  ({                                                                           \
+    __typeof__(a) va_ = (a);                                                   \
+    __typeof__(a) vb_ = (b);                                                   \
+    vec_sel(vb_, va_, va_ < vb_);                                              \
+  })
+
+#define vec_madd(a, b, c) ((a) * (b) + (c))
+#define vec_msub(a, b, c) ((a) * (b) - (c))
+
+#define vec_float(a) __builtin_convertvector((a), zdnn_vec_f32)
+
+static inline zdnn_vec_f32 vec_round(zdnn_vec_f32 a) {
+  zdnn_vec_f32 out;
+  // round to nearest, ties to even, without signalling inexact
+  for (int i = 0; i < 4; i++) {
+    out[i] = __builtin_roundevenf(a[i]);
+  }
+  return out;
+}
+
+static inline zdnn_vec_f32 vec_splats_f32(float a) {
+  return (zdnn_vec_f32){a, a, a, a};
+}
+static inline zdnn_vec_s32 vec_splats_s32(int32_t a) {
+  return (zdnn_vec_s32){a, a, a, a};
+}
+static inline zdnn_vec_u32 vec_splats_u32(uint32_t a) {
+  return (zdnn_vec_u32){a, a, a, a};
+}
+static inline zdnn_vec_s16 vec_splats_s16(int16_t a) {
+  return (zdnn_vec_s16){a, a, a, a, a, a, a, a};
+}
+static inline zdnn_vec_u16 vec_splats_u16(uint16_t a) {
+  return (zdnn_vec_u16){a, a, a, a, a, a, a, a};
+}
+static inline zdnn_vec_s8 vec_splats_s8(int8_t a) {
+  return (zdnn_vec_s8){a, a, a, a, a, a, a, a,
+                              a, a, a, a, a, a, a, a};
+}
+static inline zdnn_vec_u8 vec_splats_u8(uint8_t a) {
+  return (zdnn_vec_u8){a, a, a, a, a, a, a, a,
+                                a, a, a, a, a, a, a, a};
+}
+
+#define vec_splats(a)                                                          \
+  _Generic((a),                                                                \
+      float: vec_splats_f32,                                                   \
+      int32_t: vec_splats_s32,                                                 \
+      uint32_t: vec_splats_u32,                                                \
+      int16_t: vec_splats_s16,                                                 \
+      uint16_t: vec_splats_u16,                                                \
+      int8_t: vec_splats_s8,                                                   \
+      uint8_t: vec_splats_u8)(a)
+
+/// Sign-extend the leftmost (h) or rightmost (l) half of the elements
+static inline zdnn_vec_s16 vec_unpackh_s8(zdnn_vec_s8 a) {
+  zdnn_vec_s16 out;
+  for (int i = 0; i < 8; i++) {
+    out[i] = a[i];
+  }
+  return out;
+}
+static inline zdnn_vec_s16 vec_unpackl_s8(zdnn_vec_s8 a) {
+  zdnn_vec_s16 out;
+  for (int i = 0; i < 8; i++) {
+    out[i] = a[i + 8];
+  }
+  return out;
+}
+static inline zdnn_vec_s32 vec_unpackh_s16(zdnn_vec_s16 a) {
+  zdnn_vec_s32 out;
+  for (int i = 0; i < 4; i++) {
+    out[i] = a[i];
+  }
+  return out;
+}
+static inline zdnn_vec_s32 vec_unpackl_s16(zdnn_vec_s16 a) {
+  zdnn_vec_s32 out;
+  for (int i = 0; i < 4; i++) {
+    out[i] = a[i + 4];
+  }
+  return out;
+}
+
+#define vec_unpackh(a)                                                         \
+  _Generic((a),                                                                \
+      zdnn_vec_s8: vec_unpackh_s8,                                             \
+      zdnn_vec_s16: vec_unpackh_s16)(a)
+#define vec_unpackl(a)                                                         \
+  _Generic((a),                                                                \
+      zdnn_vec_s8: vec_unpackl_s8,                                             \
+      zdnn_vec_s16: vec_unpackl_s16)(a)
+
+/// Interleave the leftmost (h) or rightmost (l) half of the elements of a and
+/// b, starting with a
+#define vec_mergeh(a, b)                                                       \
+  ({                                                                           \
+    __typeof__(a) va_ = (a), vb_ = (b), out_;                                  \
+    for (unsigned i_ = 0; i_ < VEC_ELEMENTS(va_) / 2; i_++) {                  \
+      out_[2 * i_] = va_[i_];                                                  \
+      out_[2 * i_ + 1] = vb_[i_];                                              \
+    }                                                                          \
+    out_;                                                                      \
+  })
+#define vec_mergel(a, b)                                                       \
+  ({                                                                           \
+    __typeof__(a) va_ = (a), vb_ = (b), out_;                                  \
+    const unsigned half_ = VEC_ELEMENTS(va_) / 2;                              \
+    for (unsigned i_ = 0; i_ < half_; i_++) {                                  \
+      out_[2 * i_] = va_[half_ + i_];                                          \
+      out_[2 * i_ + 1] = vb_[half_ + i_];                                      \
+    }                                                                          \
+    out_;                                                                      \
+  })
+
+static inline zdnn_vec_u8 vec_perm_u8(zdnn_vec_u8 a, zdnn_vec_u8 b,
+                                      zdnn_vec_u8 c) {
+#if defined(__clang__)
+  zdnn_vec_u8 out;
+  for (int i = 0; i < 16; i++) {
+    out[i] = (c[i] & 0x10) ? b[c[i] & 0x0F] : a[c[i] & 0x0F];
+  }
+  return out;
+#else
+  return __builtin_shuffle(a, b, c & 0x1F);
+#endif
+}
+
+/// Pick bytes from the 32-byte concatenation of a and b, byte c[i] is the
+/// index of result byte i
+#define vec_perm(a, b, c)                                                      \
+  ((__typeof__(a))vec_perm_u8((zdnn_vec_u8)(a), (zdnn_vec_u8)(b),             \
+                              (zdnn_vec_u8)(c)))
+
+static inline zdnn_vec_u8 vec_load_len_u8(const void *p, uint32_t n) {
+  zdnn_vec_u8 out = {0};
+  memcpy(&out, p, (n < 15 ? n : 15) + 1);
+  return out;
+}
+
+static inline void vec_store_len_u8(zdnn_vec_u8 a, void *p, uint32_t n) {
+  memcpy(p, &a, (n < 15 ? n : 15) + 1);
+}
+
+// a vector value whose type matches the element type pointed to by p
+#define VEC_OF_PTR(p)                                                          \
+  _Generic((p),                                                                \
+      float *: (zdnn_vec_f32){0},                                              \
+      const float *: (zdnn_vec_f32){0},                                        \
+      uint32_t *: (zdnn_vec_u32){0},                                           \
+      const uint32_t *: (zdnn_vec_u32){0},                                     \
+      int32_t *: (zdnn_vec_s32){0},                                            \
+      const int32_t *: (zdnn_vec_s32){0},                                      \
+      uint16_t *: (zdnn_vec_u16){0},                                           \
+      const uint16_t *: (zdnn_vec_u16){0},                                     \
+      int16_t *: (zdnn_vec_s16){0},                                            \
+      const int16_t *: (zdnn_vec_s16){0},                                      \
+      uint8_t *: (zdnn_vec_u8){0},                                             \
+      const uint8_t *: (zdnn_vec_u8){0},                                       \
+      int8_t *: (zdnn_vec_s8){0},                                              \
+      const int8_t *: (zdnn_vec_s8){0})
+
+/// Load n + 1 bytes (at most 16) from p, the rest of the vector is zeroed
+#define vec_load_len(p, n)                                                     \
+  ((__typeof__(VEC_OF_PTR(p)))vec_load_len_u8((p), (n)))
+
+/// Store the leftmost n + 1 bytes (at most 16) of a to p
+#define vec_store_len(a, p, n)                                                 \
+  vec_store_len_u8((zdnn_vec_u8)(a), (p), (n))
+
+#endif // ZDNN_VEC_GENERIC
+
+// -----------------------------------------------------------------------------
+// Byte order helpers
+// -----------------------------------------------------------------------------
+
+// vec_perm() selection vector picking the high-order halfword of each word in
+// the 2 input vectors, e.g. FP32 to BFLOAT truncation
+#if defined(ZDNN_VEC_BIG_ENDIAN)
+#define VEC_SEL_HI_HALFWORDS                                                   \
+  {0, 1, 4, 5, 8, 9, 12, 13, 16, 17, 20, 21, 24, 25, 28, 29}
+#else
+#define VEC_SEL_HI_HALFWORDS                                                   \
+  {2, 3, 6, 7, 10, 11, 14, 15, 18, 19, 22, 23, 26, 27, 30, 31}
+#endif
+
+// Interleave halfwords so that each halfword of HI becomes the high-order
+// halfword of a word and the matching halfword of LO the low-order one, e.g.
+// BFLOAT to FP32 widening when LO is all zeros
+#if defined(ZDNN_VEC_BIG_ENDIAN)
+#define VEC_MERGEH_HALFWORDS(HI, LO) vec_mergeh((HI), (LO))
+#define VEC_MERGEL_HALFWORDS(HI, LO) vec_mergel((HI), (LO))
+#else
+#define VEC_MERGEH_HALFWORDS(HI, LO) vec_mergeh((LO), (HI))
+#define VEC_MERGEL_HALFWORDS(HI, LO) vec_mergel((LO), (HI))
+#endif
+
+// Stick areas hold their DLFLOAT16 cells big-endian, as the zAIU reads and
+// writes them, so that a stickified buffer is the same on any host.  These
+// swap between stick and host byte order (either way), for one cell or for a
+// vector of cells
+#if defined(ZDNN_VEC_BIG_ENDIAN)
+#define STICK_CELL16(x) ((uint16_t)(x))
+#define VEC_STICK_CELLS16(V) (V)
+#else
+#define STICK_CELL16(x) __builtin_bswap16(x)
+#define VEC_STICK_CELLS16(V)                                                   \
+  ({                                                                           \
+    vec_int16 vs_ = (vec_int16)(V);                                            \
+    (__typeof__(V))((vs_ << 8) | (vs_ >> 8));                                  \
+  })
+#endif
+
+#endif /* ZDNN_ZDNN_VEC_H_ */
@@ -0,0 +1,485 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "zdnn.h"
+#include "zdnn_private.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __MVS__
+#pragma export(zdnn_save_ztensors)
+#pragma export(zdnn_map_ztensor_file)
+#pragma export(zdnn_get_ztensor_file_count)
+#pragma export(zdnn_get_ztensor_file_entry)
+#pragma export(zdnn_unmap_ztensor_file)
+#endif
+
+/*
+  A zTensor file holds already transformed zTensors so they can be mapped
+  into memory and used as is, instead of transforming them again in every
+  process:
+
+    ztensor_file_header
+    ztensor_file_entry[count]
+    per-channel scales and offsets, if any
+    padding to AIU_PAGESIZE_IN_BYTES
+    stick areas, each starting on an AIU_PAGESIZE_IN_BYTES boundary
+
+  The file is written in the saving host's byte order and layout, and is only
+  mapped by a host with the same ones.
+*/
+
+#define ZTENSOR_FILE_MAGIC "zDNNztf"
+#define ZTENSOR_FILE_VERSION 1
+#define ZTENSOR_FILE_BYTE_ORDER 0x01020304
+
+typedef struct ztensor_file_header {
+  char magic[8];       // ZTENSOR_FILE_MAGIC
+  uint32_t version;    // ZTENSOR_FILE_VERSION
+  uint32_t byte_order; // ZTENSOR_FILE_BYTE_ORDER as seen by the saving host
+  uint32_t count;      // number of ztensor_file_entry
+  uint32_t reserved;
+  uint64_t file_size;
+} ztensor_file_header;
+
+typedef struct ztensor_file_entry {
+  zdnn_tensor_desc pre_transformed_desc;
+  zdnn_tensor_desc transformed_desc;
+  float rec_scale;
+  float offset;
+  uint64_t buffer_offset; // from the start of the file
+  uint64_t buffer_size;
+  // transformed_desc->dim1 floats each, from the start of the file, 0 if none
+  uint64_t channel_scales_offset;
+  uint64_t channel_offsets_offset;
+} ztensor_file_entry;
+
+struct zdnn_ztensor_file {
+  void *map;
+  uint64_t map_size;
+  uint32_t count;
+  zdnn_tensor_desc *descs; // pre-transformed and transformed of each ztensor
+  zdnn_ztensor *ztensors;
+};
+
+/// Write size bytes to a zTensor file being saved
+///
+/// \param[in] fp the file
+/// \param[in] data the bytes, or NULL for zeros
+/// \param[in] size number of bytes
+///
+/// \return true on success
+///
+static bool write_ztensor_file_bytes(FILE *fp, const void *data,
+                                     uint64_t size) {
+  static const char zeros[AIU_PAGESIZE_IN_BYTES] = {0};
+
+  if (data) {
+    return fwrite(data, 1, size, fp) == size;
+  }
+  while (size) {
+    uint64_t n = MIN(size, sizeof(zeros));
+    if (fwrite(zeros, 1, n, fp) != n) {
+      return false;
+    }
+    size -= n;
+  }
+  return true;
+}
+
+/// Save transformed zTensors to a file that zdnn_map_ztensor_file() maps back
+/// into memory
+///
+/// \param[in] path the file to create or overwrite
+/// \param[in] ztensors the zTensors to save, all transformed
+/// \param[in] count number of zTensors
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_STATE
+///         ZDNN_INVALID_BUFFER
+///         ZDNN_ALLOCATION_FAILURE
+///         ZDNN_FILE_ERROR
+///
+zdnn_status zdnn_save_ztensors(const char *path,
+                               const zdnn_ztensor *const *ztensors,
+                               uint32_t count) {
+  if (!path || (count && !ztensors)) {
+    return ZDNN_STATUS(ZDNN_INVALID_BUFFER, "path or ztensors is NULL",
+                       NO_ARG);
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    const zdnn_ztensor *ztensor = ztensors[i];
+    if (!ztensor || !ztensor->is_transformed) {
+      return ZDNN_STATUS(ZDNN_INVALID_STATE,
+                         "ztensors[%u] is NULL or not transformed", i);
+    }
+    if (!ztensor->buffer ||
+        ztensor->buffer_size <
+            zdnn_getsize_ztensor(ztensor->transformed_desc)) {
+      return ZDNN_STATUS(ZDNN_INVALID_BUFFER,
+                         "ztensors[%u] buffer is NULL or too small", i);
+    }
+  }
+
+  uint64_t entries_size = (uint64_t)count * sizeof(ztensor_file_entry);
+  ztensor_file_entry *entries = malloc(MAX(entries_size, 1));
+  if (!entries) {
+    return ZDNN_STATUS(ZDNN_ALLOCATION_FAILURE,
+                       "Unable to allocate %" PRIu64 " bytes for entries.",
+                       entries_size);
+  }
+  memset(entries, 0, entries_size);
+
+  // lay out the channel vectors right after the entries, then the stick areas
+  uint64_t pos = sizeof(ztensor_file_header) + entries_size;
+  for (uint32_t i = 0; i < count; i++) {
+    const zdnn_ztensor *ztensor = ztensors[i];
+    const uint64_t channels_size =
+        (uint64_t)ztensor->transformed_desc->dim1 * sizeof(float);
+
+    entries[i].pre_transformed_desc = *ztensor->pre_transformed_desc;
+    entries[i].transformed_desc = *ztensor->transformed_desc;
+    entries[i].rec_scale = ztensor->rec_scale;
+    entries[i].offset = ztensor->offset;
+    entries[i].buffer_size = zdnn_getsize_ztensor(ztensor->transformed_desc);
+    if (ztensor->is_per_channel && ztensor->channel_scales) {
+      entries[i].channel_scales_offset = pos;
+      pos += channels_size;
+    }
+    if (ztensor->is_per_channel && ztensor->channel_offsets) {
+      entries[i].channel_offsets_offset = pos;
+      pos += channels_size;
+    }
+  }
+
+  // stick areas are whole pages, so each one starts on a page boundary
+  const uint64_t channels_end = pos;
+  const uint64_t buffers_begin =
+      CEIL(pos, AIU_PAGESIZE_IN_BYTES) * AIU_PAGESIZE_IN_BYTES;
+  pos = buffers_begin;
+  for (uint32_t i = 0; i < count; i++) {
+    entries[i].buffer_offset = pos;
+    pos += entries[i].buffer_size;
+  }
+
+  ztensor_file_header header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, ZTENSOR_FILE_MAGIC, sizeof(header.magic));
+  header.version = ZTENSOR_FILE_VERSION;
+  header.byte_order = ZTENSOR_FILE_BYTE_ORDER;
+  header.count = count;
+  header.file_size = pos;
+
+  FILE *fp = fopen(path, "wb");
+  if (!fp) {
+    int err = errno;
+    free(entries);
+    return ZDNN_STATUS(ZDNN_FILE_ERROR, "Unable to create %s: %s", path,
+                       strerror(err));
+  }
+
+  bool ok = write_ztensor_file_bytes(fp, &header, sizeof(header)) &&
+            write_ztensor_file_bytes(fp, entries, entries_size);
+
+  for (uint32_t i = 0; ok && i < count; i++) {
+    const uint64_t channels_size =
+        (uint64_t)ztensors[i]->transformed_desc->dim1 * sizeof(float);
+    if (entries[i].channel_scales_offset) {
+      ok = write_ztensor_file_bytes(fp, ztensors[i]->channel_scales,
+                                    channels_size);
+    }
+    if (ok && entries[i].channel_offsets_offset) {
+      ok = write_ztensor_file_bytes(fp, ztensors[i]->channel_offsets,
+                                    channels_size);
+    }
+  }
+
+  ok = ok && write_ztensor_file_bytes(fp, NULL, buffers_begin - channels_end);
+
+  for (uint32_t i = 0; ok && i < count; i++) {
+    ok = write_ztensor_file_bytes(fp, ztensors[i]->buffer,
+                                  entries[i].buffer_size);
+  }
+
+  int err = ok ? 0 : errno;
+  if (fclose(fp) != 0 && ok) {
+    ok = false;
+    err = errno;
+  }
+  free(entries);
+
+  if (!ok) {
+    remove(path);
+    return ZDNN_STATUS(ZDNN_FILE_ERROR, "Unable to write %s: %s", path,
+                       strerror(err));
+  }
+
+  return ZDNN_STATUS_OK;
+}
+
+/// Check that a channel vector of a mapped zTensor file entry is within the
+/// metadata of the file, after the entries
+///
+/// \param[in] offset offset of the vector, 0 if none
+/// \param[in] entry the entry
+/// \param[in] entries_end offset of the end of the entries
+/// \param[in] file_size size of the file
+/// \param[in,out] metadata_end end of the metadata so far, moved past the
+///                             vector
+///
+/// \return true if there's no vector or it is within the file
+///
+static bool channel_vector_in_file(uint64_t offset,
+                                   const ztensor_file_entry *entry,
+                                   uint64_t entries_end, uint64_t file_size,
+                                   uint64_t *metadata_end) {
+  if (!offset) {
+    return true;
+  }
+
+  uint64_t size = (uint64_t)entry->transformed_desc.dim1 * sizeof(float);
+  if (offset % sizeof(float) || offset < entries_end || offset > file_size ||
+      size > file_size - offset) {
+    return false;
+  }
+  *metadata_end = MAX(*metadata_end, offset + size);
+  return true;
+}
+
+/// Check the header and entries of a mapped zTensor file
+///
+/// \param[in] path the file, for messages
+/// \param[in] map the mapped file
+/// \param[in] map_size size of the file, at least a ztensor_file_header
+///
+/// \return ZDNN_OK or ZDNN_FILE_ERROR
+///
+static zdnn_status verify_ztensor_file(const char *path, const void *map,
+                                       uint64_t map_size) {
+  const ztensor_file_header *header = map;
+
+  if (memcmp(header->magic, ZTENSOR_FILE_MAGIC, sizeof(header->magic))) {
+    return ZDNN_STATUS(ZDNN_FILE_ERROR, "%s is not a zTensor file", path);
+  }
+  if (header->byte_order != ZTENSOR_FILE_BYTE_ORDER) {
+    return ZDNN_STATUS(ZDNN_FILE_ERROR,
+                       "%s was saved with a different byte order", path);
+  }
+  if (header->version != ZTENSOR_FILE_VERSION) {
+    return ZDNN_STATUS(ZDNN_FILE_ERROR,
+                       "%s has version %u (expects %u)", path,
+                       header->version, ZTENSOR_FILE_VERSION);
+  }
+  if (header->file_size != map_size ||
+      header->count > (map_size - sizeof(ztensor_file_header)) /
+                          sizeof(ztensor_file_entry)) {
+    return ZDNN_STATUS(ZDNN_FILE_ERROR,
+                       "%s is truncated (size %" PRIu64 ", expects %" PRIu64
+                       ")",
+                       path, map_size, header->file_size);
+  }
+
+  const ztensor_file_entry *entries =
+      (const ztensor_file_entry *)(header + 1);
+  const uint64_t entries_end =
+      sizeof(ztensor_file_header) +
+      (uint64_t)header->count * sizeof(ztensor_file_entry);
+
+  // the header, entries and channel vectors come before any stick area
+  uint64_t metadata_end = entries_end;
+  for (uint32_t i = 0; i < header->count; i++) {
+    const ztensor_file_entry *entry = &entries[i];
+    if (verify_transformed_descriptor(&entry->transformed_desc) != ZDNN_OK) {
+      return ZDNN_STATUS(ZDNN_FILE_ERROR,
+                         "%s entry %u has an invalid transformed descriptor",
+                         path, i);
+    }
+    if (!channel_vector_in_file(entry->channel_scales_offset, entry,
+                                entries_end, map_size, &metadata_end) ||
+        !channel_vector_in_file(entry->channel_offsets_offset, entry,
+                                entries_end, map_size, &metadata_end)) {
+      return ZDNN_STATUS(ZDNN_FILE_ERROR, "%s entry %u is not valid", path, i);
+    }
+  }
+
+  const uint64_t buffers_begin =
+      CEIL(metadata_end, AIU_PAGESIZE_IN_BYTES) * AIU_PAGESIZE_IN_BYTES;
+  for (uint32_t i = 0; i < header->count; i++) {
+    const ztensor_file_entry *entry = &entries[i];
+    if (entry->buffer_offset % AIU_PAGESIZE_IN_BYTES ||
+        entry->buffer_offset < buffers_begin ||
+        entry->buffer_offset > map_size ||
+        entry->buffer_size > map_size - entry->buffer_offset ||
+        entry->buffer_size != zdnn_getsize_ztensor(&entry->transformed_desc)) {
+      return ZDNN_STATUS(ZDNN_FILE_ERROR, "%s entry %u is not valid", path, i);
+    }
+  }
+
+  return ZDNN_STATUS_OK;
+}
+
+/// Map a file saved by zdnn_save_ztensors() into memory, read-only and shared
+/// with any other process that maps it.  The zTensors, got with
+/// zdnn_get_ztensor_file_entry(), are transformed and their buffers point into
+/// the mapping.
+///
+/// \param[in] path the file
+/// \param[out] file the mapped file, released with zdnn_unmap_ztensor_file()
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_BUFFER
+///         ZDNN_ALLOCATION_FAILURE
+///         ZDNN_FILE_ERROR
+///
+zdnn_status zdnn_map_ztensor_file(const char *path, zdnn_ztensor_file **file) {
+  if (!path || !file) {
+    return ZDNN_STATUS(ZDNN_INVALID_BUFFER, "path or file is NULL", NO_ARG);
+  }
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return ZDNN_STATUS(ZDNN_FILE_ERROR, "Unable to open %s: %s", path,
+                       strerror(errno));
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    int err = errno;
+    close(fd);
+    return ZDNN_STATUS(ZDNN_FILE_ERROR, "Unable to stat %s: %s", path,
+                       strerror(err));
+  }
+  if ((uint64_t)st.st_size < sizeof(ztensor_file_header)) {
+    close(fd);
+    return ZDNN_STATUS(ZDNN_FILE_ERROR, "%s is not a zTensor file", path);
+  }
+
+  const uint64_t map_size = (uint64_t)st.st_size;
+  void *map = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, 0);
+  int err = errno;
+  // the mapping stays valid without the descriptor
+  close(fd);
+  if (map == MAP_FAILED) {
+    return ZDNN_STATUS(ZDNN_FILE_ERROR, "Unable to map %s: %s", path,
+                       strerror(err));
+  }
+
+  zdnn_status status = verify_ztensor_file(path, map, map_size);
+  if (status != ZDNN_OK) {
+    munmap(map, map_size);
+    return status;
+  }
+
+  const ztensor_file_header *header = map;
+  const ztensor_file_entry *entries =
+      (const ztensor_file_entry *)(header + 1);
+
+  uint64_t size = sizeof(zdnn_ztensor_file) +
+                  header->count * (sizeof(zdnn_ztensor) +
+                                   2 * sizeof(zdnn_tensor_desc));
+  zdnn_ztensor_file *f = malloc(size);
+  if (!f) {
+    munmap(map, map_size);
+    return ZDNN_STATUS(ZDNN_ALLOCATION_FAILURE,
+                       "Unable to allocate %" PRIu64 " bytes for %s.", size,
+                       path);
+  }
+
+  f->map = map;
+  f->map_size = map_size;
+  f->count = header->count;
+  f->ztensors = (zdnn_ztensor *)(f + 1);
+  f->descs = (zdnn_tensor_desc *)(f->ztensors + f->count);
+
+  for (uint32_t i = 0; i < f->count; i++) {
+    const ztensor_file_entry *entry = &entries[i];
+    zdnn_ztensor *ztensor = &f->ztensors[i];
+
+    f->descs[2 * i] = entry->pre_transformed_desc;
+    f->descs[2 * i + 1] = entry->transformed_desc;
+
+    zdnn_init_ztensor(&f->descs[2 * i], &f->descs[2 * i + 1], ztensor);
+    ztensor->buffer = (char *)map + entry->buffer_offset;
+    ztensor->buffer_size = entry->buffer_size;
+    ztensor->rec_scale = entry->rec_scale;
+    ztensor->offset = entry->offset;
+    if (entry->channel_scales_offset) {
+      ztensor->channel_scales =
+          (const float *)((char *)map + entry->channel_scales_offset);
+    }
+    if (entry->channel_offsets_offset) {
+      ztensor->channel_offsets =
+          (const float *)((char *)map + entry->channel_offsets_offset);
+    }
+    ztensor->is_per_channel =
+        (entry->channel_scales_offset || entry->channel_offsets_offset);
+    ztensor->is_transformed = true;
+  }
+
+  *file = f;
+  return ZDNN_STATUS_OK;
+}
+
+/// Number of zTensors in a mapped zTensor file
+///
+/// \param[in] file the mapped file
+///
+/// \return number of zTensors
+///
+uint32_t zdnn_get_ztensor_file_count(const zdnn_ztensor_file *file) {
+  return file->count;
+}
+
+/// A zTensor of a mapped zTensor file, in the order they were saved in.  Its
+/// buffer is read-only, so it can't be the output of an operation.
+///
+/// \param[in] file the mapped file
+/// \param[in] index index of the zTensor
+///
+/// \return the zTensor, or NULL if index is out of range
+///
+const zdnn_ztensor *zdnn_get_ztensor_file_entry(const zdnn_ztensor_file *file,
+                                                uint32_t index) {
+  return index < file->count ? &file->ztensors[index] : NULL;
+}
+
+/// Unmap a zTensor file.  Its zTensors must no longer be used.
+///
+/// \param[in] file the mapped file, or NULL
+///
+/// \return None
+///
+void zdnn_unmap_ztensor_file(zdnn_ztensor_file *file) {
+  if (!file) {
+    return;
+  }
+
+  // another mapping may reuse the addresses, with different data
+  for (uint32_t i = 0; i < file->count; i++) {
+    invalidate_qmatmul_bias_cache(file->ztensors[i].buffer);
+  }
+
+  munmap(file->map, file->map_size);
+  free(file);
+}
@@ -0,0 +1,513 @@
+// SPDX-License-Identifier: Apache-2.0
+/*
+ * Copyright IBM Corp. 2021, 2024
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "zdnn.h"
+#include "zdnn_private.h"
+
+#ifdef __MVS__
+#pragma export(zdnn_init_ztensor_view)
+#endif
+
+/*
+  A 4DFEATURE stick area is laid out as
+
+    for each dim4 (N)
+      for each group of dim1 (C) cells that fit in a stick
+        for each dim3 (H)
+          dim2 (W) sticks, padded to a multiple of AIU_STICKS_PER_PAGE
+
+  The zAIU works out the address of every stick from the dims alone, so a view
+  can only alias the part of its parent's stick area that is laid out exactly
+  like a zTensor of the view's dims would be.  That means the view's W rows
+  start on a page of the parent and, for every dim the view spans more than
+  one of, the distance between consecutive entries is the same as in the
+  parent.
+*/
+
+/// Set the dims of a view's pre-transformed descriptor from those of its
+/// transformed descriptor, undoing zdnn_generate_transformed_desc() for the
+/// sliced dims
+///
+/// \param[in] tfrmd_desc transformed descriptor of the view
+/// \param[in,out] pre_tfrmd_desc pre-transformed descriptor of the view, a
+///                               copy of the parent's
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_LAYOUT
+///
+static zdnn_status set_view_pre_tfrmd_dims(const zdnn_tensor_desc *tfrmd_desc,
+                                           zdnn_tensor_desc *pre_tfrmd_desc) {
+  switch (pre_tfrmd_desc->layout) {
+  case ZDNN_1D:
+    break;
+  case ZDNN_2D:
+    pre_tfrmd_desc->dim2 = tfrmd_desc->dim2;
+    break;
+  case ZDNN_2DS:
+    pre_tfrmd_desc->dim2 = tfrmd_desc->dim4;
+    break;
+  case ZDNN_3D:
+    pre_tfrmd_desc->dim3 = tfrmd_desc->dim3;
+    pre_tfrmd_desc->dim2 = tfrmd_desc->dim2;
+    break;
+  case ZDNN_3DS:
+    pre_tfrmd_desc->dim3 = tfrmd_desc->dim4;
+    pre_tfrmd_desc->dim2 = tfrmd_desc->dim2;
+    break;
+  case ZDNN_4D:
+  case ZDNN_NHWC:
+    pre_tfrmd_desc->dim4 = tfrmd_desc->dim4;
+    pre_tfrmd_desc->dim3 = tfrmd_desc->dim3;
+    pre_tfrmd_desc->dim2 = tfrmd_desc->dim2;
+    break;
+  case ZDNN_4DS:
+    pre_tfrmd_desc->dim4 = tfrmd_desc->dim4;
+    pre_tfrmd_desc->dim2 = tfrmd_desc->dim2;
+    break;
+  case ZDNN_NCHW:
+    pre_tfrmd_desc->dim4 = tfrmd_desc->dim4;
+    pre_tfrmd_desc->dim2 = tfrmd_desc->dim3;
+    pre_tfrmd_desc->dim1 = tfrmd_desc->dim2;
+    break;
+  default:
+    return ZDNN_STATUS(ZDNN_INVALID_LAYOUT,
+                       "Invalid layout for a view: %d (%s)",
+                       pre_tfrmd_desc->layout,
+                       get_data_layout_str(pre_tfrmd_desc->layout));
+  }
+  return ZDNN_STATUS_OK;
+}
+
+/// Work out where a range of a 4DFEATURE zTensor is in its stick area, if it
+/// is laid out there as a zTensor of its own dims would be.  The range must be
+/// within the zTensor.
+///
+/// \param[in] parent_desc transformed descriptor of the zTensor
+/// \param[in] start first index of the range in each dim, dim4 first
+/// \param[in] count number of indices of the range in each dim, dim4 first
+/// \param[out] offset byte offset of the range in the stick area
+///
+/// \return true if the range can be viewed
+///
+bool get_ztensor_range_offset(const zdnn_tensor_desc *parent_desc,
+                              const uint32_t *start, const uint32_t *count,
+                              uint64_t *offset) {
+  stick_geometry geom;
+  init_stick_geometry(parent_desc, &geom);
+
+  // the range's sticks never share a page, or a stick, with cells outside of
+  // it
+  if (start[2] % AIU_STICKS_PER_PAGE ||
+      (count[2] % AIU_STICKS_PER_PAGE && start[2] + count[2] != geom.dim2) ||
+      start[3] % geom.cells_per_stick ||
+      (count[3] % geom.cells_per_stick && start[3] + count[3] != geom.dim1)) {
+    return false;
+  }
+
+  const bool same_rows = CEIL(count[2], AIU_STICKS_PER_PAGE) ==
+                         CEIL(geom.dim2, AIU_STICKS_PER_PAGE);
+  const uint64_t sticks1 = CEIL(count[3], geom.cells_per_stick);
+
+  if ((count[1] > 1 && !same_rows) ||
+      (sticks1 > 1 && (count[1] != geom.dim3 || !same_rows)) ||
+      (count[0] > 1 &&
+       (count[1] != geom.dim3 || !same_rows ||
+        sticks1 != CEIL(geom.dim1, geom.cells_per_stick)))) {
+    return false;
+  }
+
+  *offset = start[0] * geom.bytes_per_e4x +
+            start[3] / geom.cells_per_stick * geom.bytes_per_stick1 +
+            start[1] * geom.bytes_per_row +
+            start[2] / AIU_STICKS_PER_PAGE * AIU_PAGESIZE_IN_BYTES;
+  return true;
+}
+
+/// Round a tile size down to whole sticks when there is at least one
+///
+/// \param[in] limit the largest tile size allowed
+/// \param[in] align the number of indices per stick (or page)
+///
+/// \return the tile size
+///
+uint32_t get_tile_size(uint32_t limit, uint32_t align) {
+  return limit >= align ? limit / align * align : limit;
+}
+
+/// Halve a tile size, keeping it a multiple of align.  Tiles of less than a
+/// stick (or page) take as many bytes as a whole one, so they aren't shrunk
+/// below align.
+///
+/// \param[in,out] size the tile size
+/// \param[in] align the number of indices per stick (or page)
+///
+/// \return true if the tile size got smaller
+///
+bool shrink_tile_size(uint32_t *size, uint32_t align) {
+  if (*size > align) {
+    *size = CEIL(CEIL(*size, 2), align) * align;
+    return true;
+  }
+  return false;
+}
+
+/// Stick area size of a tensor of the given dims
+///
+/// \param[in] like transformed descriptor of the whole tensor
+/// \param[in] dim4
+/// \param[in] dim3
+/// \param[in] dim2
+/// \param[in] dim1
+///
+/// \return size in bytes
+///
+uint64_t get_tile_bytes(const zdnn_tensor_desc *like, uint32_t dim4,
+                        uint32_t dim3, uint32_t dim2, uint32_t dim1) {
+  zdnn_tensor_desc desc = *like;
+  desc.dim4 = dim4;
+  desc.dim3 = dim3;
+  desc.dim2 = dim2;
+  desc.dim1 = dim1;
+  return zdnn_getsize_ztensor(&desc);
+}
+
+/// Set up a range of a 4DFEATURE zTensor of 2-byte cells for an operation to
+/// be run on, as a view of the zTensor when the range can be viewed and as a
+/// temporary zTensor otherwise
+///
+/// \param[in] whole the zTensor
+/// \param[in] start first index of the range in each dim, dim4 first
+/// \param[in] count number of indices of the range in each dim, dim4 first
+/// \param[in] copy_in true to copy the range's cells into a temporary zTensor
+/// \param[out] tile the tile
+///
+/// \return ZDNN_OK
+///         ZDNN_ALLOCATION_FAILURE
+///
+zdnn_status init_ztensor_tile(const zdnn_ztensor *whole, const uint32_t *start,
+                              const uint32_t *count, bool copy_in,
+                              ztensor_tile *tile) {
+  uint64_t offset;
+  zdnn_status status;
+
+  tile->tfrmd_desc = *whole->transformed_desc;
+  tile->tfrmd_desc.dim4 = count[0];
+  tile->tfrmd_desc.dim3 = count[1];
+  tile->tfrmd_desc.dim2 = count[2];
+  tile->tfrmd_desc.dim1 = count[3];
+  zdnn_init_pre_transformed_desc(ZDNN_NHWC, whole->pre_transformed_desc->type,
+                                 &tile->pre_tfrmd_desc, count[0], count[1],
+                                 count[2], count[3]);
+
+  tile->is_view = get_ztensor_range_offset(whole->transformed_desc, start,
+                                           count, &offset);
+  if (tile->is_view) {
+    tile->ztensor = *whole;
+    tile->ztensor.pre_transformed_desc = &tile->pre_tfrmd_desc;
+    tile->ztensor.transformed_desc = &tile->tfrmd_desc;
+    tile->ztensor.buffer_size = zdnn_getsize_ztensor(&tile->tfrmd_desc);
+    tile->ztensor.buffer = (char *)whole->buffer + offset;
+    return ZDNN_STATUS_OK;
+  }
+
+  if ((status = zdnn_init_ztensor_with_malloc(
+           &tile->pre_tfrmd_desc, &tile->tfrmd_desc, &tile->ztensor)) !=
+      ZDNN_OK) {
+    return status;
+  }
+  if (copy_in) {
+    copy_ztensor_range(whole, &tile->ztensor, start, false);
+    tile->ztensor.is_transformed = true;
+  }
+  return ZDNN_STATUS_OK;
+}
+
+/// Set up a temporary zTensor with the same descriptors as a tile
+///
+/// \param[in] like the tile
+/// \param[out] tile the temporary zTensor
+///
+/// \return ZDNN_OK
+///         ZDNN_ALLOCATION_FAILURE
+///
+zdnn_status init_temp_ztensor_tile(const ztensor_tile *like,
+                                   ztensor_tile *tile) {
+  tile->pre_tfrmd_desc = like->pre_tfrmd_desc;
+  tile->tfrmd_desc = like->tfrmd_desc;
+  tile->is_view = false;
+  return zdnn_init_ztensor_with_malloc(&tile->pre_tfrmd_desc,
+                                       &tile->tfrmd_desc, &tile->ztensor);
+}
+
+/// Copy a tile that an operation wrote back to its range of the zTensor,
+/// unless it is a view
+///
+/// \param[in] whole the zTensor
+/// \param[in] start first index of the range in each dim, dim4 first
+/// \param[in] tile the tile
+///
+/// \return None
+///
+void store_ztensor_tile(const zdnn_ztensor *whole, const uint32_t *start,
+                        const ztensor_tile *tile) {
+  if (!tile->is_view) {
+    copy_ztensor_range(whole, &tile->ztensor, start, true);
+  }
+}
+
+/// Release a tile set up by init_ztensor_tile() or init_temp_ztensor_tile()
+///
+/// \param[in] tile the tile
+///
+/// \return None
+///
+void free_ztensor_tile(ztensor_tile *tile) {
+  if (!tile->is_view) {
+    zdnn_free_ztensor_buffer(&tile->ztensor);
+  }
+}
+
+/// Start the sum of the partial results of an output tile.  The first part is
+/// computed straight into sum->acc with the bias, every other one by the
+/// caller between next_tile_sum_part() and add_tile_sum_part().
+///
+/// \param[in] out_tile the output tile the parts are added up for
+/// \param[in] bias_tile the bias of the output tile
+/// \param[out] sum the sum
+///
+/// \return None
+///
+void init_tile_sum(ztensor_tile *out_tile, const ztensor_tile *bias_tile,
+                   tile_sum *sum) {
+  sum->out_tile = out_tile;
+  sum->bias_tile = bias_tile;
+  sum->have_zero_bias = false;
+  sum->have_part = false;
+  sum->have_other = false;
+  sum->acc = &out_tile->ztensor;
+  sum->other = NULL;
+}
+
+/// Set up the temporaries the next part of a sum is computed into.  The bias
+/// is only added once, by the first part, so the next one is computed with
+/// sum->zero_bias into sum->part.
+///
+/// \param[in,out] sum the sum
+///
+/// \return ZDNN_OK
+///         ZDNN_ALLOCATION_FAILURE
+///
+zdnn_status next_tile_sum_part(tile_sum *sum) {
+  zdnn_status status;
+
+  if (!sum->have_zero_bias) {
+    if ((status = init_temp_ztensor_tile(sum->bias_tile, &sum->zero_bias)) !=
+        ZDNN_OK) {
+      return status;
+    }
+    sum->have_zero_bias = true;
+    memset(sum->zero_bias.ztensor.buffer, 0,
+           sum->zero_bias.ztensor.buffer_size);
+    sum->zero_bias.ztensor.is_transformed = true;
+  }
+  if (!sum->have_part) {
+    if ((status = init_temp_ztensor_tile(sum->out_tile, &sum->part)) !=
+        ZDNN_OK) {
+      return status;
+    }
+    sum->have_part = true;
+  }
+  if (!sum->have_other) {
+    if ((status = init_temp_ztensor_tile(sum->out_tile, &sum->other_tile)) !=
+        ZDNN_OK) {
+      return status;
+    }
+    sum->have_other = true;
+    sum->other = &sum->other_tile.ztensor;
+  }
+  return ZDNN_STATUS_OK;
+}
+
+/// Add the part computed into sum->part to the sum
+///
+/// \param[in,out] sum the sum
+///
+/// \return ZDNN_OK or a failure of the NNPA addition
+///
+zdnn_status add_tile_sum_part(tile_sum *sum) {
+  zdnn_status status;
+
+  if ((status = zdnn_add(sum->acc, &sum->part.ztensor, sum->other)) !=
+      ZDNN_OK) {
+    return status;
+  }
+  zdnn_ztensor *tmp = sum->acc;
+  sum->acc = sum->other;
+  sum->other = tmp;
+  return ZDNN_STATUS_OK;
+}
+
+/// Move the sum into its output tile and copy that to its range of the output
+///
+/// \param[in] whole the output zTensor
+/// \param[in] start first index of the output tile in each dim, dim4 first
+/// \param[in] sum the sum
+///
+/// \return None
+///
+void store_tile_sum(const zdnn_ztensor *whole, const uint32_t *start,
+                    const tile_sum *sum) {
+  // a view is laid out as a standalone zTensor of its dims, so the last sum
+  // can be moved into the output tile byte for byte
+  if (sum->acc != &sum->out_tile->ztensor) {
+    memcpy(sum->out_tile->ztensor.buffer, sum->acc->buffer,
+           sum->out_tile->ztensor.buffer_size);
+  }
+  store_ztensor_tile(whole, start, sum->out_tile);
+}
+
+/// Release the temporaries of a sum, but not its output and bias tiles
+///
+/// \param[in] sum the sum
+///
+/// \return None
+///
+void free_tile_sum(tile_sum *sum) {
+  if (sum->have_zero_bias) {
+    free_ztensor_tile(&sum->zero_bias);
+  }
+  if (sum->have_part) {
+    free_ztensor_tile(&sum->part);
+  }
+  if (sum->have_other) {
+    free_ztensor_tile(&sum->other_tile);
+  }
+}
+
+/// Initialize a zTensor as a view of a sub-range of another zTensor's dim4,
+/// dim3 and dim2 (N, H and W of the transformed shape), aliasing the parent's
+/// buffer instead of copying it.  dim1 is never sliced.
+///
+/// The view must be laid out in the parent's buffer as a zTensor of its own
+/// shape would be:
+///
+/// - dim2_start is a multiple of AIU_STICKS_PER_PAGE, and so is dim2_count
+///   unless the range ends at the parent's last dim2
+/// - if dim3_count > 1, the view's dim2 takes as many pages as the parent's
+/// - if dim4_count > 1 or dim1 spans more than one stick, the whole dim3 and
+///   the same number of dim2 pages as the parent are taken
+///
+/// \param[in] parent the zTensor to view
+/// \param[in] dim4_start first dim4 index
+/// \param[in] dim4_count number of dim4 indices
+/// \param[in] dim3_start first dim3 index
+/// \param[in] dim3_count number of dim3 indices
+/// \param[in] dim2_start first dim2 index
+/// \param[in] dim2_count number of dim2 indices
+/// \param[out] pre_tfrmd_desc pre-transformed descriptor of the view
+/// \param[out] tfrmd_desc transformed descriptor of the view
+/// \param[out] view the view
+///
+/// \return ZDNN_OK
+///         ZDNN_INVALID_BUFFER
+///         ZDNN_INVALID_FORMAT
+///         ZDNN_INVALID_TYPE
+///         ZDNN_INVALID_LAYOUT
+///         ZDNN_INVALID_SHAPE
+///
+zdnn_status zdnn_init_ztensor_view(const zdnn_ztensor *parent,
+                                   uint32_t dim4_start, uint32_t dim4_count,
+                                   uint32_t dim3_start, uint32_t dim3_count,
+                                   uint32_t dim2_start, uint32_t dim2_count,
+                                   zdnn_tensor_desc *pre_tfrmd_desc,
+                                   zdnn_tensor_desc *tfrmd_desc,
+                                   zdnn_ztensor *view) {
+  const zdnn_tensor_desc *parent_desc = parent->transformed_desc;
+  zdnn_status status;
+
+  if (!parent->buffer) {
+    return ZDNN_STATUS_NO_MSG(ZDNN_INVALID_BUFFER);
+  }
+  if (parent_desc->format != ZDNN_FORMAT_4DFEATURE) {
+    return ZDNN_STATUS(ZDNN_INVALID_FORMAT,
+                       "Views are only supported for format %s, found %s",
+                       get_data_format_str(ZDNN_FORMAT_4DFEATURE),
+                       get_data_format_str(parent_desc->format));
+  }
+  if (!get_data_type_size(parent_desc->type)) {
+    return ZDNN_STATUS(ZDNN_INVALID_TYPE, "Invalid transformed type: %d",
+                       parent_desc->type);
+  }
+
+  if (!dim4_count || !dim3_count || !dim2_count ||
+      (uint64_t)dim4_start + dim4_count > parent_desc->dim4 ||
+      (uint64_t)dim3_start + dim3_count > parent_desc->dim3 ||
+      (uint64_t)dim2_start + dim2_count > parent_desc->dim2) {
+    return ZDNN_STATUS(
+        ZDNN_INVALID_SHAPE,
+        "View dim4 %u+%u, dim3 %u+%u, dim2 %u+%u is outside of dims "
+        "(%u, %u, %u)",
+        dim4_start, dim4_count, dim3_start, dim3_count, dim2_start, dim2_count,
+        parent_desc->dim4, parent_desc->dim3, parent_desc->dim2);
+  }
+
+  // the view's sticks never share a page with sticks outside of it
+  if (dim2_start % AIU_STICKS_PER_PAGE ||
+      (dim2_count % AIU_STICKS_PER_PAGE &&
+       dim2_start + dim2_count != parent_desc->dim2)) {
+    return ZDNN_STATUS(ZDNN_INVALID_SHAPE,
+                       "View dim2 %u+%u is not on %u-stick boundaries",
+                       dim2_start, dim2_count, AIU_STICKS_PER_PAGE);
+  }
+
+  const uint32_t start[] = {dim4_start, dim3_start, dim2_start, 0};
+  const uint32_t count[] = {dim4_count, dim3_count, dim2_count,
+                            parent_desc->dim1};
+  uint64_t offset;
+
+  if (!get_ztensor_range_offset(parent_desc, start, count, &offset)) {
+    return ZDNN_STATUS(ZDNN_INVALID_SHAPE,
+                       "View dim4 %u+%u, dim3 %u+%u, dim2 %u+%u is not "
+                       "contiguous in dims (%u, %u, %u, %u)",
+                       dim4_start, dim4_count, dim3_start, dim3_count,
+                       dim2_start, dim2_count, parent_desc->dim4,
+                       parent_desc->dim3, parent_desc->dim2,
+                       parent_desc->dim1);
+  }
+
+  *tfrmd_desc = *parent_desc;
+  tfrmd_desc->dim4 = dim4_count;
+  tfrmd_desc->dim3 = dim3_count;
+  tfrmd_desc->dim2 = dim2_count;
+
+  *pre_tfrmd_desc = *parent->pre_transformed_desc;
+  if ((status = set_view_pre_tfrmd_dims(tfrmd_desc, pre_tfrmd_desc)) !=
+      ZDNN_OK) {
+    return status;
+  }
+
+  // scale, offset, per-channel vectors and transformed state all carry over
+  *view = *parent;
+  view->pre_transformed_desc = pre_tfrmd_desc;
+  view->transformed_desc = tfrmd_desc;
+  view->buffer_size = zdnn_getsize_ztensor(tfrmd_desc);
+  view->buffer = (char *)parent->buffer + offset;
+
+  return ZDNN_STATUS_OK;
+}